@@ -820,12 +820,31 @@ export interface StateUpdatedData {
     variables: Variable[];
 }
 
+/** Addresses written since the previous update (in ascending order), along with their current values (values[i] is the value at addresses[i]). */
+export interface MemoryUpdate {
+    addresses: number[];
+    values: number[];
+}
+
+/** Complete execution state of a program (e.g. from running the same program natively), for Emulator.restoreState. */
+export interface EmulatorState {
+    ip: number;
+    cyclesExecuted: number;
+    memoryBytesAccessed: number;
+
+    /** True for each address that has been accessed (memoryBytesAccessed is the number of these). */
+    memoryAccessed: boolean[];
+    memory: number[];
+}
+
 export interface EmulatorOptions {
     readInput?: () => number;
     writeOutput?: (value: number) => void;
 
-    onHalt?: (data: HaltData) => void;
+    /** @deprecated Called after every memory write, which is expensive when running quickly; use Emulator.takeMemoryUpdate to apply writes in batches instead. */
     onWriteMemory?: (address: number, byte: number) => void;
+
+    onHalt?: (data: HaltData) => void;
     onStateUpdated?: (data: StateUpdatedData) => void;
 }
 
@@ -838,6 +857,10 @@ export class Emulator {
     private memory: number[] = [];
     private initialMemorySnapshot: number[];
 
+    // Addresses written since the last memory update (one bit per address), so that writes can be applied in batches
+    // (e.g. once per frame) instead of after every write; see takeMemoryUpdate
+    private memoryDirty = new Uint32Array((Constants.addressMax + 1) / 32);
+
     // Metrics
 
     // Memory access
@@ -850,11 +873,14 @@ export class Emulator {
     constructor(private program: AssembledProgram, private callbacks: EmulatorOptions = {}) {
         const bytes = this.program.bytes;
         for (let i = 0; i <= Constants.addressMax; i++) {
-            const value = (i < bytes.length) ? bytes[i] : 0;
-            this.memory[i] = value;
+            this.memory[i] = (i < bytes.length) ? bytes[i] : 0;
+        }
 
-            if (this.callbacks.onWriteMemory) {
-                this.callbacks.onWriteMemory(i, value);
+        // Loading counts as writing all of memory
+        this.memoryDirty.fill(0xffffffff);
+        if (this.callbacks.onWriteMemory) {
+            for (let i = 0; i <= Constants.addressMax; i++) {
+                this.callbacks.onWriteMemory(i, this.memory[i]);
             }
         }
 
@@ -924,11 +950,16 @@ export class Emulator {
 
     private writeMemory(address: number, value: number): void {
         this.accessMemory(address);
+        this.setMemory(address, value);
+    };
+
+    private setMemory(address: number, value: number): void {
         this.memory[address] = value;
+        this.memoryDirty[address >>> 5] |= (1 << (address & 31));
         if (this.callbacks.onWriteMemory) {
             this.callbacks.onWriteMemory(address, value);
         }
-    };
+    }
 
     public isEmpty(): boolean {
         for (const byte of this.memory) {
@@ -951,6 +982,31 @@ export class Emulator {
         return this.memoryBytesAccessed;
     }
 
+    /** True if memory has been written since the last call to takeMemoryUpdate (loading counts as writing all of memory). */
+    public hasMemoryUpdate(): boolean {
+        return this.memoryDirty.some(word => word !== 0);
+    }
+
+    /** Returns (and clears) the batch of addresses written since the last call, with their current values. */
+    public takeMemoryUpdate(): MemoryUpdate {
+        const addresses: number[] = [];
+        const values: number[] = [];
+        for (let i = 0; i < this.memoryDirty.length; i++) {
+            let bits = this.memoryDirty[i];
+            while (bits !== 0) {
+                // Lowest set bit first
+                const address = (i << 5) + (31 - Math.clz32(bits & -bits));
+                addresses.push(address);
+                values.push(this.memory[address]);
+                bits &= bits - 1;
+            }
+
+            this.memoryDirty[i] = 0;
+        }
+
+        return { addresses, values };
+    }
+
     public step(): void {
         if (this.isRunning()) {
             const a = this.readMemory(this.ip++);
@@ -1015,6 +1071,31 @@ export class Emulator {
         }
     };
 
+    /** Continues from the given state of this program, as if it had been reached by stepping (input and output aren't replayed). */
+    public restoreState(state: EmulatorState): void {
+        this.ip = state.ip;
+        this.running = this.isRunning();
+        this.cyclesExecuted = state.cyclesExecuted;
+        this.memoryAccessed = state.memoryAccessed.slice();
+        this.memoryBytesAccessed = state.memoryBytesAccessed;
+
+        // Only addresses that actually change are included in the next memory update
+        for (let i = 0; i <= Constants.addressMax; i++) {
+            if (this.memory[i] !== state.memory[i]) {
+                this.setMemory(i, state.memory[i]);
+            }
+        }
+
+        this.stateUpdated();
+
+        if (this.callbacks.onHalt && !this.running) {
+            this.callbacks.onHalt({
+                cyclesExecuted: this.cyclesExecuted,
+                memoryBytesAccessed: this.memoryBytesAccessed,
+            });
+        }
+    }
+
     /** Resets the emulator's memory back to its initial state. */
     public reset(): void {
         // Reset state
@@ -1024,14 +1105,14 @@ export class Emulator {
         this.memoryBytesAccessed = 0;
         this.cyclesExecuted = 0;
 
-        // Reset memory
+        // Reset memory (only addresses that actually change are included in the next memory update)
         for (let i = 0; i <= Constants.addressMax; i++) {
             const value = this.initialMemorySnapshot[i];
             if (this.memory[i] !== value) {
-                this.memory[i] = value;
-                if (this.callbacks.onWriteMemory) {
-                    this.callbacks.onWriteMemory(i, value);
-                }
+                this.setMemory(i, value);
+            } else if (this.callbacks.onWriteMemory) {
+                // Note: onWriteMemory has always been called for every address on reset
+                this.callbacks.onWriteMemory(i, value);
             }
         }
 
@@ -789,9 +789,17 @@ function verifyProgram(inputs: number[], expectedOutputs: number[], code: string
     const emulator = new Emulator(Assembler.assemble(code.split("\n")), {
         readInput: () => inputs[inputIndex++],
         writeOutput: n => assert.strictEqual(n, expectedOutputs[outputIndex++]),
-        onWriteMemory: onWriteMemory ?? undefined,
     });
 
+    const checkMemoryUpdate = () => {
+        const { addresses, values } = emulator.takeMemoryUpdate();
+        if (onWriteMemory) {
+            for (let i = 0; i < addresses.length; i++) {
+                onWriteMemory(addresses[i], values[i]);
+            }
+        }
+    };
+
     assert.strictEqual(emulator.isEmpty(), false);
     assert.strictEqual(emulator.isRunning(), true);
 
@@ -803,6 +811,7 @@ function verifyProgram(inputs: number[], expectedOutputs: number[], code: string
         }
 
         emulator.step();
+        checkMemoryUpdate();
     }
 }
 
@@ -977,6 +986,75 @@ describe("SIC-1 Emulator", () => {
         emulator.run();
     });
 
+    it("Memory updates", () => {
+        const emulator = new Emulator(Assembler.assemble(`
+            subleq @tmp, @five
+            subleq @tmp, @tmp, @HALT
+
+            @five: .data 5
+            @tmp: .data 0
+        `.split("\n")));
+
+        // Loading counts as writing all of memory
+        assert.strictEqual(emulator.hasMemoryUpdate(), true);
+        const initial = emulator.takeMemoryUpdate();
+        assert.strictEqual(initial.addresses.length, Constants.addressMax + 1);
+        assert.deepStrictEqual(initial.addresses.slice(0, 8), [0, 1, 2, 3, 4, 5, 6, 7]);
+        assert.deepStrictEqual(initial.values.slice(0, 8), [7, 6, 3, 7, 7, 255, 5, 0]);
+        assert.strictEqual(emulator.hasMemoryUpdate(), false);
+        assert.deepStrictEqual(emulator.takeMemoryUpdate(), { addresses: [], values: [] });
+
+        // Writes are batched until the next update
+        emulator.step();
+        assert.strictEqual(emulator.hasMemoryUpdate(), true);
+        assert.deepStrictEqual(emulator.takeMemoryUpdate(), { addresses: [7], values: [0xfb] });
+        emulator.step();
+        assert.deepStrictEqual(emulator.takeMemoryUpdate(), { addresses: [7], values: [0] });
+
+        // Resetting only reports addresses that changed
+        emulator.reset();
+        assert.deepStrictEqual(emulator.takeMemoryUpdate(), { addresses: [], values: [] });
+        emulator.step();
+        emulator.reset();
+        assert.deepStrictEqual(emulator.takeMemoryUpdate(), { addresses: [7], values: [0] });
+    });
+
+    it("Restore state", () => {
+        const emulator = new Emulator(Assembler.assemble(`
+            subleq @tmp, @five
+            subleq @tmp, @tmp, @HALT
+
+            @five: .data 5
+            @tmp: .data 0
+        `.split("\n")), {
+            onHalt: (data) => {
+                assert.strictEqual(data.cyclesExecuted, 2);
+                assert.strictEqual(data.memoryBytesAccessed, 8);
+            },
+        });
+
+        emulator.takeMemoryUpdate();
+
+        // State after the first instruction
+        const memoryAccessed: boolean[] = [];
+        [0, 1, 2, 6, 7].forEach(address => memoryAccessed[address] = true);
+        const memory = [7, 6, 3, 7, 7, 255, 5, 0xfb];
+        while (memory.length <= Constants.addressMax) {
+            memory.push(0);
+        }
+
+        emulator.restoreState({ ip: 3, cyclesExecuted: 1, memoryBytesAccessed: 5, memoryAccessed, memory });
+        assert.strictEqual(emulator.isRunning(), true);
+        assert.strictEqual(emulator.getCyclesExecuted(), 1);
+        assert.strictEqual(emulator.getMemoryBytesAccessed(), 5);
+        assert.deepStrictEqual(emulator.takeMemoryUpdate(), { addresses: [7], values: [0xfb] });
+
+        // Stepping continues from there (including counting memory accesses)
+        emulator.step();
+        assert.strictEqual(emulator.isRunning(), false);
+        assert.deepStrictEqual(emulator.takeMemoryUpdate(), { addresses: [7], values: [0] });
+    });
+
     it("Reset", () => {
         const inputs = [4, 5, 100, 101];
         const expectedOutputs = inputs.slice();
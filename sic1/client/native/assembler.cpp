@@ -0,0 +1,519 @@
+#include "assembler.h"
+#include "assemblerlexer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_map>
+
+using namespace Sic1;
+using Lexer::Token;
+using Lexer::TokenType;
+
+namespace {
+    typedef struct {
+        std::string_view text;
+        unsigned int sourceLineNumber;
+    } SourceLine;
+
+    const char* const compilationErrorTypeNames[] = {
+        "AddressLiteralRangeError",
+        "AddressReferenceRangeError",
+        "InternalCompilerError",
+        "InvalidAddressExpressionError",
+        "InvalidBreakpointError",
+        "InvalidCommandError",
+        "InvalidDataArgumentCountError",
+        "InvalidEscapeCodeError",
+        "InvalidSubleqArgumentCountError",
+        "InvalidTokenError",
+        "InvalidValueExpressionError",
+        "LabelAlreadyDefinedError",
+        "MissingCommaOrWhitespaceError",
+        "MissingWhitespaceError",
+        "ProgramTooLargeError",
+        "UndefinedReferenceError",
+        "ValueRangeError",
+    };
+
+    CompilationContext CreateContext(const SourceLine& line) {
+        CompilationContext context;
+        context.sourceLineNumber = line.sourceLineNumber;
+        context.sourceLine = std::string(line.text);
+        return context;
+    }
+
+    CompilationContext CreateContext(const SourceLine& line, std::string_view text) {
+        CompilationContext context = CreateContext(line);
+        context.text = std::string(text);
+        return context;
+    }
+
+    // Formats a number the way JavaScript's Number.prototype.toString does (for the values that appear in messages)
+    std::string FormatNumber(double value) {
+        if (std::isnan(value)) {
+            return "NaN";
+        }
+        else if (std::isinf(value)) {
+            return (value < 0) ? "-Infinity" : "Infinity";
+        }
+        else if (value == 0) {
+            return "0";
+        }
+
+        char buffer[32];
+        if (value == std::floor(value) && std::fabs(value) < 1e21) {
+            std::snprintf(buffer, sizeof(buffer), "%.0f", value);
+        }
+        else {
+            // Shortest representation that round-trips
+            for (int precision = 1; precision <= 17; precision++) {
+                std::snprintf(buffer, sizeof(buffer), "%.*g", precision, value);
+                if (std::strtod(buffer, nullptr) == value) {
+                    break;
+                }
+            }
+        }
+        return buffer;
+    }
+
+    // Tokens are views into the line, so tokenizing a line only allocates when the (reused) token buffer needs to grow
+    void TokenizeLine(const SourceLine& line, std::vector<Token>& tokens) {
+        const std::string_view text = line.text;
+        tokens.clear();
+
+        Token token = {};
+        for (size_t index = 0; index < text.size(); index += token.raw.size()) {
+            const Lexer::ScanResult result = Lexer::ScanToken(text, index, token);
+            if (result == Lexer::ScanResult::Comment) {
+                break;
+            }
+            else if (result == Lexer::ScanResult::Invalid) {
+                const CompilationContext errorContext = CreateContext(line, text.substr(index));
+                throw CompilationError(CompilationErrorType::InvalidTokenError, "Invalid token: \"" + *errorContext.text + "\"", errorContext);
+            }
+
+            tokens.push_back(token);
+        }
+    }
+
+    Expression CreateValue(uint8_t value) {
+        return { false, value, false, {}, 0 };
+    }
+
+    uint8_t ParseEscapeCode(char escapeCharacter, const SourceLine& line) {
+        const std::optional<uint8_t> value = Lexer::GetEscapeCodeValue(escapeCharacter);
+        if (!value) {
+            const CompilationContext errorContext = CreateContext(line, std::string("\\") + escapeCharacter);
+            throw CompilationError(CompilationErrorType::InvalidEscapeCodeError, "Invalid escape code: \"" + *errorContext.text + "\"", errorContext);
+        }
+        return *value;
+    }
+
+    Expression ParseReference(const Token& token) {
+        Expression expression = {};
+        expression.isReference = true;
+        expression.negated = (token.raw[0] == '-');
+        expression.label = token.group;
+        expression.offset = token.offset.empty() ? 0 : std::strtod(std::string(token.offset).c_str(), nullptr);
+        return expression;
+    }
+
+    uint8_t ParseAddress(const Token& token, const SourceLine& line) {
+        const int value = Lexer::ParseNumberLiteral(token.raw);
+        if (value < static_cast<int>(Constants::addressMin) || value > static_cast<int>(Constants::addressMax)) {
+            CompilationContext errorContext = CreateContext(line, token.raw);
+            errorContext.rangeMin = Constants::addressMin;
+            errorContext.rangeMax = Constants::addressMax;
+            throw CompilationError(CompilationErrorType::AddressLiteralRangeError,
+                "Invalid argument: \"" + *errorContext.text + "\" (must be an integer on the range [" + std::to_string(*errorContext.rangeMin) + ", " + std::to_string(*errorContext.rangeMax) + "])",
+                errorContext);
+        }
+        return static_cast<uint8_t>(value);
+    }
+
+    uint8_t ParseValue(const Token& token, const SourceLine& line) {
+        const int value = Lexer::ParseNumberLiteral(token.raw);
+        if (value < Constants::valueMin || value > Constants::valueMax) {
+            CompilationContext errorContext = CreateContext(line, token.raw);
+            errorContext.rangeMin = Constants::valueMin;
+            errorContext.rangeMax = Constants::valueMax;
+            throw CompilationError(CompilationErrorType::ValueRangeError,
+                "Invalid argument: " + *errorContext.text + " (must be an integer on the range [" + std::to_string(*errorContext.rangeMin) + ", " + std::to_string(*errorContext.rangeMax) + "])",
+                errorContext);
+        }
+        return SignedToUnsigned(value);
+    }
+
+    uint8_t ParseCharacter(const Token& token, const SourceLine& line) {
+        const std::string_view str = token.group;
+        const uint8_t value = (str[0] == '\\') ? ParseEscapeCode(str[1], line) : static_cast<uint8_t>(str[0]);
+        return (token.raw[0] == '-') ? SignedToUnsigned(-value) : value;
+    }
+
+    // Appends the string's characters (and a terminating zero), returning the number of bytes appended
+    unsigned int ParseString(const Token& token, const SourceLine& line, std::vector<Expression>& expressions) {
+        const std::string_view input = token.group;
+        const bool negated = (token.raw[0] == '-');
+        unsigned int count = 0;
+        for (size_t i = 0; i < input.size(); i++, count++) {
+            const uint8_t value = (input[i] == '\\') ? ParseEscapeCode(input[++i], line) : static_cast<uint8_t>(input[i]);
+            expressions.push_back(CreateValue(negated ? SignedToUnsigned(-value) : value));
+        }
+
+        // Terminating zero
+        expressions.push_back(CreateValue(0));
+        return count + 1;
+    }
+
+    Expression ParseAddressExpression(const Token& token, const SourceLine& line) {
+        switch (token.tokenType) {
+            case TokenType::NumberLiteral: return CreateValue(ParseAddress(token, line));
+            case TokenType::Reference: return ParseReference(token);
+
+            default:
+                {
+                    const CompilationContext errorContext = CreateContext(line, token.raw);
+                    throw CompilationError(CompilationErrorType::InvalidAddressExpressionError, "Expected number literal or reference, but got: \"" + *errorContext.text + "\"", errorContext);
+                }
+        }
+    }
+
+    // Appends the expression(s) for a ".data" argument, returning the number of bytes appended
+    unsigned int ParseValueExpression(const Token& token, const SourceLine& line, std::vector<Expression>& expressions) {
+        switch (token.tokenType) {
+            case TokenType::NumberLiteral: expressions.push_back(CreateValue(ParseValue(token, line))); return 1;
+            case TokenType::CharacterLiteral: expressions.push_back(CreateValue(ParseCharacter(token, line))); return 1;
+            case TokenType::Reference: expressions.push_back(ParseReference(token)); return 1;
+            case TokenType::StringLiteral: return ParseString(token, line, expressions);
+
+            default:
+                {
+                    const CompilationContext errorContext = CreateContext(line, token.raw);
+                    throw CompilationError(CompilationErrorType::InvalidValueExpressionError, "Expected number, character, string, or reference, but got: \"" + *errorContext.text + "\"", errorContext);
+                }
+        }
+    }
+
+    // Parses a tokenized line into the given (reused) ParsedLine; see Assembler.parseLineInternal
+    void ParseTokens(const std::vector<Token>& tokens, const SourceLine& line, ParsedLine& parsedLine) {
+        parsedLine.labelDefinitions.clear();
+        parsedLine.command.reset();
+        parsedLine.expressions.clear();
+        parsedLine.breakpoint = false;
+
+        size_t index = 0;
+        unsigned int offset = 0;
+
+        const auto skipWhiteSpace = [&]() {
+            while (index < tokens.size() && tokens[index].tokenType == TokenType::WhiteSpace) {
+                index++;
+            }
+        };
+
+        const auto addLabelDefinitions = [&](bool isInline) {
+            for (; index < tokens.size(); index++) {
+                const Token& token = tokens[index];
+                if (token.tokenType == TokenType::Label) {
+                    parsedLine.labelDefinitions.push_back({ token.group, offset, isInline });
+                }
+                else if (token.tokenType != TokenType::WhiteSpace) {
+                    break;
+                }
+            }
+        };
+
+        // Check for persistent breakpoint indicator at the beginning of the line
+        skipWhiteSpace();
+        if (index < tokens.size() && tokens[index].tokenType == TokenType::ExclamationMark) {
+            parsedLine.breakpoint = true;
+            index++;
+        }
+
+        // Check for label(s)
+        addLabelDefinitions(false);
+
+        // Check for command
+        skipWhiteSpace();
+        if (index < tokens.size()) {
+            const std::string_view commandName = tokens[index++].raw;
+            Command command;
+            if (commandName == Syntax::subleqInstruction) {
+                command = Command::SubleqInstruction;
+            }
+            else if (commandName == Syntax::dataDirective) {
+                command = Command::DataDirective;
+            }
+            else {
+                const CompilationContext errorContext = CreateContext(line, commandName);
+                throw CompilationError(CompilationErrorType::InvalidCommandError, "Unknown command: \"" + *errorContext.text + "\" (valid commands are: \"subleq\" and \".data\")", errorContext);
+            }
+            parsedLine.command = command;
+
+            // Add arguments
+            unsigned int argumentCount = 0;
+            while (index < tokens.size()) {
+                // Check for required whitespace/comma
+                const TokenType tokenType = tokens[index].tokenType;
+                if (parsedLine.expressions.empty()) {
+                    // Whitespace required after command
+                    if (tokenType != TokenType::WhiteSpace) {
+                        const CompilationContext errorContext = CreateContext(line, commandName);
+                        throw CompilationError(CompilationErrorType::MissingWhitespaceError, "Whitespace is required after \"" + *errorContext.text + "\"", errorContext);
+                    }
+                }
+                else {
+                    // Whitespace or comma required between arguments
+                    if (tokenType != TokenType::Comma && tokenType != TokenType::WhiteSpace) {
+                        const CompilationContext errorContext = CreateContext(line, tokens[index].raw);
+                        throw CompilationError(CompilationErrorType::MissingCommaOrWhitespaceError, "Whitespace or comma required before argument: \"" + *errorContext.text + "\"", errorContext);
+                    }
+
+                    skipWhiteSpace();
+                    if (index < tokens.size() && tokens[index].tokenType == TokenType::Comma) {
+                        index++;
+                    }
+                }
+
+                // Add any inline labels
+                addLabelDefinitions(true);
+
+                // Parse the argument
+                if (index < tokens.size()) {
+                    switch (command) {
+                        case Command::SubleqInstruction:
+                            parsedLine.expressions.push_back(ParseAddressExpression(tokens[index], line));
+                            offset++;
+                            break;
+
+                        case Command::DataDirective:
+                            offset += ParseValueExpression(tokens[index], line, parsedLine.expressions);
+                            break;
+                    }
+
+                    argumentCount++;
+                    index++;
+                }
+            }
+
+            // Check argument count
+            switch (command) {
+                case Command::SubleqInstruction:
+                    if (argumentCount < 2 || argumentCount > 3) {
+                        CompilationContext errorContext = CreateContext(line);
+                        errorContext.number = argumentCount;
+                        errorContext.rangeMin = 2;
+                        errorContext.rangeMax = 3;
+                        throw CompilationError(CompilationErrorType::InvalidSubleqArgumentCountError,
+                            "Invalid number of arguments for \"subleq\": " + std::to_string(argumentCount) + " (must be between 2 and 3, inclusive)",
+                            errorContext);
+                    }
+                    break;
+
+                case Command::DataDirective:
+                    if (argumentCount <= 0) {
+                        CompilationContext errorContext = CreateContext(line);
+                        errorContext.number = argumentCount;
+                        errorContext.rangeMin = 1;
+                        throw CompilationError(CompilationErrorType::InvalidDataArgumentCountError,
+                            "Invalid number of arguments for \".data\": " + std::to_string(argumentCount) + " (must have at least 1 argument)",
+                            errorContext);
+                    }
+                    break;
+            }
+        }
+
+        if (parsedLine.breakpoint && parsedLine.command != Command::SubleqInstruction) {
+            throw CompilationError(CompilationErrorType::InvalidBreakpointError, "Breakpoints are only supported on subleq instructions", CreateContext(line));
+        }
+    }
+
+    // Note: the result may be out of range (or not even an integer, for absurdly large offsets)
+    double GetReferenceValue(const Expression& expression, unsigned int labelAddress) {
+        return (expression.negated ? SignedToUnsigned(-static_cast<int>(labelAddress)) : labelAddress) + expression.offset;
+    }
+
+    AssembledProgram AssembleLines(const std::vector<std::string_view>& lines) {
+        AssembledProgram program;
+        unsigned int address = 0;
+
+        // Note: names are views into the source lines, which outlive the table
+        std::unordered_map<std::string_view, unsigned int> labels;
+
+        // References are resolved once all labels are known; until then, their bytes are placeholders
+        typedef struct {
+            Expression expression;
+            size_t byteIndex;
+            unsigned int lineIndex;
+        } UnresolvedReference;
+
+        std::vector<UnresolvedReference> references;
+
+        // Reused for every line
+        std::vector<Token> tokens;
+        ParsedLine parsedLine;
+
+        program.bytes.reserve(Constants::memorySize);
+        for (unsigned int i = 0; i < lines.size(); i++) {
+            const SourceLine line = { lines[i], i + 1 };
+            if (line.text.empty()) {
+                continue;
+            }
+
+            TokenizeLine(line, tokens);
+            ParseTokens(tokens, line, parsedLine);
+
+            // Add breakpoint, if desired
+            if (parsedLine.breakpoint) {
+                program.breakpoints.push_back(address);
+            }
+
+            // Add labels, if present
+            for (const auto& definition : parsedLine.labelDefinitions) {
+                if (Assembler::IsReservedLabel(definition.label) || !labels.emplace(definition.label, address + definition.offset).second) {
+                    throw Assembler::CreateLabelAlreadyDefinedError(definition.label, line.text, line.sourceLineNumber);
+                }
+
+                // Variables are labels defined on a ".data" directive or as *any* inline label
+                if (definition.isInline || parsedLine.command == Command::DataDirective) {
+                    program.variables.push_back({ std::string(1, Syntax::referencePrefix) + std::string(definition.label), address + definition.offset });
+                }
+            }
+
+            if (parsedLine.command) {
+                // Note: argument count validation ensures there is at least one expression
+                for (const auto& expression : parsedLine.expressions) {
+                    if (expression.isReference) {
+                        references.push_back({ expression, program.bytes.size(), i });
+                    }
+                    program.bytes.push_back(expression.value);
+                }
+
+                unsigned int nextAddress = address;
+                switch (*parsedLine.command) {
+                    case Command::SubleqInstruction:
+                        // Fill in optional address
+                        nextAddress += Constants::subleqInstructionBytes;
+                        if (parsedLine.expressions.size() < 3) {
+                            program.bytes.push_back(static_cast<uint8_t>(nextAddress));
+                        }
+                        break;
+
+                    case Command::DataDirective:
+                        nextAddress += static_cast<unsigned int>(parsedLine.expressions.size());
+                        break;
+                }
+
+                // Update source map
+                program.sourceMap.resize(address + 1);
+                program.sourceMap[address] = SourceMapEntry{ i, *parsedLine.command, std::string(line.text) };
+                address = nextAddress;
+            }
+        }
+
+        if (address > Constants::addressUserMax + 1) {
+            throw Assembler::CreateProgramTooLargeError(address);
+        }
+
+        // Resolve all references
+        //
+        // Note: Names inherited from Object.prototype (e.g. "@toString") are undefined here. The script assembler looks
+        // them up on its plain-object label table and emits meaningless bytes; rejecting them is intentional.
+        for (const auto& reference : references) {
+            const SourceLine line = { lines[reference.lineIndex], reference.lineIndex + 1 };
+            const auto it = labels.find(reference.expression.label);
+            const std::optional<unsigned int> builtInAddress = Assembler::GetBuiltInLabelAddress(reference.expression.label);
+            if (it == labels.end() && !builtInAddress) {
+                throw Assembler::CreateUndefinedReferenceError(reference.expression.label, line.text, line.sourceLineNumber);
+            }
+
+            const unsigned int labelAddress = builtInAddress ? *builtInAddress : it->second;
+            program.bytes[reference.byteIndex] = Assembler::ResolveReference(reference.expression, labelAddress, line.text, line.sourceLineNumber);
+        }
+
+        return program;
+    }
+}
+
+const char* Sic1::GetCompilationErrorTypeName(CompilationErrorType errorType) {
+    return compilationErrorTypeNames[static_cast<size_t>(errorType)];
+}
+
+AssembledProgram Assembler::Assemble(const std::vector<std::string>& lines) {
+    return AssembleLines(std::vector<std::string_view>(lines.begin(), lines.end()));
+}
+
+AssembledProgram Assembler::Assemble(std::string_view source) {
+    std::vector<std::string_view> lines;
+    while (true) {
+        const size_t end = source.find('\n');
+        lines.push_back(source.substr(0, end));
+        if (end == std::string_view::npos) {
+            break;
+        }
+        source.remove_prefix(end + 1);
+    }
+    return AssembleLines(lines);
+}
+
+ParsedLine Assembler::ParseLine(std::string_view line, unsigned int sourceLineNumber) {
+    const SourceLine sourceLine = { line, sourceLineNumber };
+    std::vector<Token> tokens;
+    ParsedLine parsedLine;
+    TokenizeLine(sourceLine, tokens);
+    ParseTokens(tokens, sourceLine, parsedLine);
+    return parsedLine;
+}
+
+CompilationError Assembler::CreateLabelAlreadyDefinedError(std::string_view label, std::string_view sourceLine, unsigned int sourceLineNumber) {
+    const CompilationContext errorContext = CreateContext({ sourceLine, sourceLineNumber }, std::string(1, Syntax::referencePrefix) + std::string(label));
+    return CompilationError(CompilationErrorType::LabelAlreadyDefinedError, "Label already defined: \"" + *errorContext.text + "\"", errorContext);
+}
+
+CompilationError Assembler::CreateProgramTooLargeError(unsigned int size) {
+    CompilationContext errorContext;
+    errorContext.number = size;
+    errorContext.rangeMax = Constants::addressUserMax + 1;
+    return CompilationError(CompilationErrorType::ProgramTooLargeError,
+        "Program is too long (maximum size: " + std::to_string(*errorContext.rangeMax) + " bytes; program size: " + std::to_string(size) + " bytes)",
+        errorContext);
+}
+
+CompilationError Assembler::CreateUndefinedReferenceError(std::string_view label, std::string_view sourceLine, unsigned int sourceLineNumber) {
+    const CompilationContext errorContext = CreateContext({ sourceLine, sourceLineNumber }, std::string(1, Syntax::referencePrefix) + std::string(label));
+    return CompilationError(CompilationErrorType::UndefinedReferenceError, "Undefined reference: \"" + *errorContext.text + "\"", errorContext);
+}
+
+std::optional<unsigned int> Assembler::GetBuiltInLabelAddress(std::string_view label) {
+    return Lexer::GetBuiltInLabelAddress(label);
+}
+
+bool Assembler::IsReservedLabel(std::string_view label) {
+    return Lexer::IsReservedLabel(label);
+}
+
+std::optional<uint8_t> Assembler::TryResolveReference(const Expression& expression, unsigned int labelAddress) {
+    const double value = GetReferenceValue(expression, labelAddress);
+    if (!(value >= Constants::addressMin && value <= Constants::addressMax)) {
+        return std::nullopt;
+    }
+    return static_cast<uint8_t>(value);
+}
+
+uint8_t Assembler::ResolveReference(const Expression& expression, unsigned int labelAddress, std::string_view sourceLine, unsigned int sourceLineNumber) {
+    const std::optional<uint8_t> resolved = TryResolveReference(expression, labelAddress);
+    if (!resolved) {
+        const double value = GetReferenceValue(expression, labelAddress);
+        CompilationContext errorContext = CreateContext({ sourceLine, sourceLineNumber },
+            std::string(1, Syntax::referencePrefix) + std::string(expression.label) + ((expression.offset >= 0) ? "+" : "") + FormatNumber(expression.offset));
+        errorContext.number = value;
+        errorContext.rangeMin = Constants::addressMin;
+        errorContext.rangeMax = Constants::addressMax;
+        throw CompilationError(CompilationErrorType::AddressReferenceRangeError,
+            "Address \"" + *errorContext.text + "\" (" + FormatNumber(value) + ") is outside of valid range of [" + std::to_string(*errorContext.rangeMin) + ", " + std::to_string(*errorContext.rangeMax) + "]",
+            errorContext);
+    }
+    return *resolved;
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "emulator.h"
+
+// Native SIC-1 assembler, accepting exactly the same syntax (and producing the same output and errors) as Assembler in
+// lib/src/sic1asm.ts
+namespace Sic1 {
+    namespace Syntax {
+        constexpr const char* subleqInstruction = "subleq";
+        constexpr const char* dataDirective = ".data";
+        constexpr char referencePrefix = '@';
+        constexpr char commentDelimiter = ';';
+        constexpr char optionalArgumentSeparator = ',';
+    }
+
+    enum class CompilationErrorType : uint8_t {
+        AddressLiteralRangeError,
+        AddressReferenceRangeError,
+        InternalCompilerError,
+        InvalidAddressExpressionError,
+        InvalidBreakpointError,
+        InvalidCommandError,
+        InvalidDataArgumentCountError,
+        InvalidEscapeCodeError,
+        InvalidSubleqArgumentCountError,
+        InvalidTokenError,
+        InvalidValueExpressionError,
+        LabelAlreadyDefinedError,
+        MissingCommaOrWhitespaceError,
+        MissingWhitespaceError,
+        ProgramTooLargeError,
+        UndefinedReferenceError,
+        ValueRangeError,
+    };
+
+    // Returns the name used for the error type in CompilationErrorType (e.g. "ValueRangeError")
+    const char* GetCompilationErrorTypeName(CompilationErrorType errorType);
+
+    // Fields are only present when the script assembler would set them
+    typedef struct {
+        // One-based
+        std::optional<unsigned int> sourceLineNumber;
+        std::optional<std::string> sourceLine;
+
+        // Error-specific fields
+        std::optional<std::string> text;
+        std::optional<double> number;
+        std::optional<int> rangeMin;
+        std::optional<int> rangeMax;
+    } CompilationContext;
+
+    class CompilationError : public std::runtime_error {
+    public:
+        CompilationError(CompilationErrorType errorType, const std::string& message, CompilationContext context)
+            : std::runtime_error(message), m_errorType(errorType), m_context(std::move(context)) {
+        }
+
+        CompilationErrorType GetErrorType() const {
+            return m_errorType;
+        }
+
+        const CompilationContext& GetContext() const {
+            return m_context;
+        }
+
+    private:
+        CompilationErrorType m_errorType;
+        CompilationContext m_context;
+    };
+
+    enum class Command : uint8_t {
+        SubleqInstruction,
+        DataDirective,
+    };
+
+    typedef struct {
+        // Zero-based (unlike CompilationContext)
+        unsigned int lineNumber;
+        Command command;
+        std::string source;
+    } SourceMapEntry;
+
+    typedef struct {
+        // Including the "@" prefix
+        std::string label;
+        unsigned int address;
+    } VariableDefinition;
+
+    typedef struct {
+        std::vector<uint8_t> bytes;
+
+        // Indexed by address, with an entry for the first address of each command (like the sparse array in the script
+        // assembler, this ends at the last command's address)
+        std::vector<std::optional<SourceMapEntry>> sourceMap;
+
+        std::vector<VariableDefinition> variables;
+        std::vector<unsigned int> breakpoints;
+    } AssembledProgram;
+
+    // Note: Names refer to the parsed line's source text, so they're only valid as long as it is
+    typedef struct {
+        std::string_view label;
+        unsigned int offset;
+        bool isInline;
+    } LabelDefinition;
+
+    // Either a literal byte or a (possibly negated) label reference with an offset
+    typedef struct {
+        bool isReference;
+        uint8_t value;
+        bool negated;
+        std::string_view label;
+        double offset;
+    } Expression;
+
+    typedef struct {
+        std::vector<LabelDefinition> labelDefinitions;
+        std::optional<Command> command;
+        std::vector<Expression> expressions;
+        bool breakpoint;
+    } ParsedLine;
+
+    class Assembler {
+    public:
+        // Assembles a program, throwing CompilationError if it's invalid
+        static AssembledProgram Assemble(const std::vector<std::string>& lines);
+
+        // Same, but for source that hasn't been split into lines (lines are separated by "\n" only, as in the IDE)
+        static AssembledProgram Assemble(std::string_view source);
+
+        // Parses a single line (reporting errors using the given one-based line number), without resolving references
+        static ParsedLine ParseLine(std::string_view line, unsigned int sourceLineNumber = 1);
+
+        // Errors that are reported after lines have been parsed (exposed for IncrementalAssembler)
+        static CompilationError CreateLabelAlreadyDefinedError(std::string_view label, std::string_view sourceLine, unsigned int sourceLineNumber);
+        static CompilationError CreateProgramTooLargeError(unsigned int size);
+        static CompilationError CreateUndefinedReferenceError(std::string_view label, std::string_view sourceLine, unsigned int sourceLineNumber);
+
+        // Returns the address of a built-in label (e.g. "IN"), if the label is built in
+        static std::optional<unsigned int> GetBuiltInLabelAddress(std::string_view label);
+
+        // Returns true if the label can't be defined: built-in labels and (for compatibility with the script assembler,
+        // whose label table is a plain object) names inherited from Object.prototype. Unlike the script assembler,
+        // references to the latter are undefined (instead of resolving to the inherited property).
+        static bool IsReservedLabel(std::string_view label);
+
+        // Resolves a reference to a label with the given address, returning nothing if the result is out of range
+        static std::optional<uint8_t> TryResolveReference(const Expression& expression, unsigned int labelAddress);
+
+        // Same, but throwing AddressReferenceRangeError (attributed to the given line) if the result is out of range
+        static uint8_t ResolveReference(const Expression& expression, unsigned int labelAddress, std::string_view sourceLine, unsigned int sourceLineNumber);
+    };
+}
@@ -0,0 +1,347 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include "assembler.h"
+
+// Lexical rules shared by Assembler and the compile-time EmbeddedAssembler (everything here is constexpr, so that both
+// tokenize lines identically)
+namespace Sic1 {
+    namespace Lexer {
+        enum class TokenType : uint8_t {
+            Label,
+            Command,
+
+            // Expressions
+            NumberLiteral,
+            CharacterLiteral,
+            Reference,
+            StringLiteral,
+
+            // Syntax
+            Comma,
+            ExclamationMark,
+            WhiteSpace,
+        };
+
+        // Tokens are views into the line being tokenized. Comments are discarded, as in the script tokenizer.
+        typedef struct {
+            TokenType tokenType;
+            std::string_view raw;
+
+            // Label/reference name or the contents of a character/string literal (without quotes)
+            std::string_view group;
+
+            // Reference offset, including its sign (empty if there is no offset)
+            std::string_view offset;
+        } Token;
+
+        enum class ScanResult : uint8_t {
+            Token,
+
+            // The rest of the line is a comment
+            Comment,
+
+            // No token matches (InvalidTokenError)
+            Invalid,
+        };
+
+        // The script assembler's label table is a plain object, so these names (inherited from Object.prototype) are
+        // always "defined" and can't be used as labels
+        constexpr std::string_view objectPropertyNames[] = {
+            "__defineGetter__",
+            "__defineSetter__",
+            "__lookupGetter__",
+            "__lookupSetter__",
+            "__proto__",
+            "constructor",
+            "hasOwnProperty",
+            "isPrototypeOf",
+            "propertyIsEnumerable",
+            "toLocaleString",
+            "toString",
+            "valueOf",
+        };
+
+        // Returns the length of the (possibly multi-byte) whitespace character at the given index, or zero if there
+        // isn't one. This is the same set of characters as JavaScript's "\s" (encoded as UTF-8).
+        constexpr size_t GetWhitespaceLength(std::string_view line, size_t index) {
+            const auto byteAt = [&](size_t offset) -> unsigned int {
+                return (index + offset < line.size()) ? static_cast<unsigned char>(line[index + offset]) : 0;
+            };
+
+            switch (byteAt(0)) {
+                case '\t': case '\n': case '\v': case '\f': case '\r': case ' ': return 1;
+                case 0xc2: return (byteAt(1) == 0xa0) ? 2 : 0; // U+00A0
+                case 0xe1: return (byteAt(1) == 0x9a && byteAt(2) == 0x80) ? 3 : 0; // U+1680
+                case 0xe3: return (byteAt(1) == 0x80 && byteAt(2) == 0x80) ? 3 : 0; // U+3000
+                case 0xef: return (byteAt(1) == 0xbb && byteAt(2) == 0xbf) ? 3 : 0; // U+FEFF
+
+                case 0xe2:
+                    if (byteAt(1) == 0x80) {
+                        // U+2000-U+200A, U+2028, U+2029, U+202F
+                        const unsigned int last = byteAt(2);
+                        return ((last >= 0x80 && last <= 0x8a) || last == 0xa8 || last == 0xa9 || last == 0xaf) ? 3 : 0;
+                    }
+                    return (byteAt(1) == 0x81 && byteAt(2) == 0x9f) ? 3 : 0; // U+205F
+
+                default: return 0;
+            }
+        }
+
+        // Characters that may not be used in identifiers (see Tokenizer.reservedCharacters)
+        constexpr bool IsReservedCharacter(char c) {
+            switch (c) {
+                case '!': case '@': case '\\': case '(': case ')': case ';': case ':': case '\'': case '"': case ',': case '+': case '-': return true;
+                default: return false;
+            }
+        }
+
+        constexpr bool IsDigit(char c) {
+            return c >= '0' && c <= '9';
+        }
+
+        constexpr bool IsCommandStartCharacter(char c) {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+        }
+
+        constexpr bool IsPrintable(char c) {
+            return c >= ' ' && c <= '~';
+        }
+
+        constexpr size_t ScanDigits(std::string_view line, size_t index) {
+            while (index < line.size() && IsDigit(line[index])) {
+                index++;
+            }
+            return index;
+        }
+
+        constexpr size_t ScanIdentifier(std::string_view line, size_t index) {
+            while (index < line.size() && !IsReservedCharacter(line[index]) && GetWhitespaceLength(line, index) == 0) {
+                index++;
+            }
+            return index;
+        }
+
+        // Scans a character literal's contents (starting just after the opening apostrophe), returning the index just
+        // past the closing apostrophe, or zero if the literal is malformed
+        constexpr size_t ScanCharacterLiteral(std::string_view line, size_t index) {
+            if (index < line.size() && line[index] == '\\') {
+                if (index + 1 >= line.size() || !IsPrintable(line[index + 1])) {
+                    return 0;
+                }
+                index += 2;
+            }
+            else if (index < line.size() && IsPrintable(line[index]) && line[index] != '\'') {
+                index++;
+            }
+            else {
+                return 0;
+            }
+            return (index < line.size() && line[index] == '\'') ? index + 1 : 0;
+        }
+
+        // Same, but for string literals (which may be empty)
+        constexpr size_t ScanStringLiteral(std::string_view line, size_t index) {
+            while (index < line.size()) {
+                const char c = line[index];
+                if (c == '"') {
+                    return index + 1;
+                }
+                else if (c == '\\') {
+                    if (index + 1 >= line.size() || !IsPrintable(line[index + 1])) {
+                        return 0;
+                    }
+                    index += 2;
+                }
+                else if (IsPrintable(c)) {
+                    index++;
+                }
+                else {
+                    return 0;
+                }
+            }
+            return 0;
+        }
+
+        // Comments extend to the end of the line, but (as with "." in a JavaScript regular expression) may not contain
+        // line terminators
+        constexpr bool IsValidComment(std::string_view comment) {
+            for (size_t i = 0; i < comment.size(); i++) {
+                const char c = comment[i];
+                if (c == '\n' || c == '\r') {
+                    return false;
+                }
+                else if (static_cast<unsigned char>(c) == 0xe2 && i + 2 < comment.size()
+                    && static_cast<unsigned char>(comment[i + 1]) == 0x80
+                    && (static_cast<unsigned char>(comment[i + 2]) == 0xa8 || static_cast<unsigned char>(comment[i + 2]) == 0xa9)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // Scans a reference (or label, if allowed) whose "@" is at the given index, returning the index just past the
+        // token (or zero if there is no name)
+        constexpr size_t ScanReference(std::string_view text, size_t prefixIndex, bool allowLabel, Token& token) {
+            const size_t nameStart = prefixIndex + 1;
+            const size_t nameEnd = ScanIdentifier(text, nameStart);
+            if (nameEnd == nameStart) {
+                return 0;
+            }
+
+            token.group = text.substr(nameStart, nameEnd - nameStart);
+            if (allowLabel && nameEnd < text.size() && text[nameEnd] == ':') {
+                token.tokenType = TokenType::Label;
+                return nameEnd + 1;
+            }
+
+            token.tokenType = TokenType::Reference;
+            size_t end = nameEnd;
+            if (end + 1 < text.size() && (text[end] == '+' || text[end] == '-') && IsDigit(text[end + 1])) {
+                end = ScanDigits(text, end + 1);
+                token.offset = text.substr(nameEnd, end - nameEnd);
+            }
+            return end;
+        }
+
+        // Scans a character or string literal whose opening quote is at the given index (returning zero if malformed)
+        constexpr size_t ScanQuoted(std::string_view text, size_t quoteIndex, Token& token) {
+            size_t end = 0;
+            if (text[quoteIndex] == '\'') {
+                token.tokenType = TokenType::CharacterLiteral;
+                end = ScanCharacterLiteral(text, quoteIndex + 1);
+            }
+            else {
+                token.tokenType = TokenType::StringLiteral;
+                end = ScanStringLiteral(text, quoteIndex + 1);
+            }
+
+            if (end > 0) {
+                token.group = text.substr(quoteIndex + 1, end - quoteIndex - 2);
+            }
+            return end;
+        }
+
+        // Single-pass equivalent of the script tokenizer's ordered list of regular expressions: the first character (or
+        // two, for negation) determines which rule could possibly match, so each token is only scanned once
+        constexpr ScanResult ScanToken(std::string_view text, size_t index, Token& token) {
+            token = {};
+            size_t end = 0;
+
+            const char c = text[index];
+            if (const size_t length = GetWhitespaceLength(text, index); length > 0) {
+                token.tokenType = TokenType::WhiteSpace;
+                end = index + length;
+                for (size_t next = 0; end < text.size() && (next = GetWhitespaceLength(text, end)) > 0; end += next) {
+                }
+            }
+            else if (c == Syntax::optionalArgumentSeparator) {
+                token.tokenType = TokenType::Comma;
+                end = index + 1;
+            }
+            else if (c == '!') {
+                token.tokenType = TokenType::ExclamationMark;
+                end = index + 1;
+            }
+            else if (IsCommandStartCharacter(c) || (c == '.' && index + 1 < text.size() && IsCommandStartCharacter(text[index + 1]))) {
+                token.tokenType = TokenType::Command;
+                end = index + 1;
+                while (end < text.size() && (IsCommandStartCharacter(text[end]) || IsDigit(text[end]))) {
+                    end++;
+                }
+            }
+            else if (IsDigit(c)) {
+                token.tokenType = TokenType::NumberLiteral;
+                end = ScanDigits(text, index);
+            }
+            else if (c == '\'' || c == '"') {
+                end = ScanQuoted(text, index, token);
+            }
+            else if (c == Syntax::referencePrefix) {
+                end = ScanReference(text, index, true, token);
+            }
+            else if (c == '-' && index + 1 < text.size()) {
+                const char next = text[index + 1];
+                if (IsDigit(next)) {
+                    token.tokenType = TokenType::NumberLiteral;
+                    end = ScanDigits(text, index + 1);
+                }
+                else if (next == '\'' || next == '"') {
+                    end = ScanQuoted(text, index + 1, token);
+                }
+                else if (next == Syntax::referencePrefix) {
+                    end = ScanReference(text, index + 1, false, token);
+                }
+            }
+            else if (c == Syntax::commentDelimiter && IsValidComment(text.substr(index))) {
+                return ScanResult::Comment;
+            }
+
+            if (end == 0) {
+                return ScanResult::Invalid;
+            }
+
+            token.raw = text.substr(index, end - index);
+            return ScanResult::Token;
+        }
+
+        // Equivalent to parseInt for the number literal pattern, but saturating (out-of-range values stay out of range)
+        constexpr int ParseNumberLiteral(std::string_view raw) {
+            const bool negative = (raw[0] == '-');
+            int value = 0;
+            for (size_t i = negative ? 1 : 0; i < raw.size(); i++) {
+                value = std::min(value * 10 + (raw[i] - '0'), 1000000);
+            }
+            return negative ? -value : value;
+        }
+
+        // Returns the value of an escape code (e.g. 'n' for "\n"), if it's valid
+        constexpr std::optional<uint8_t> GetEscapeCodeValue(char escapeCharacter) {
+            switch (escapeCharacter) {
+                case '0': return '\0';
+                case 'n': return '\n';
+
+                case '\\':
+                case '\'':
+                case '"':
+                    return static_cast<uint8_t>(escapeCharacter);
+
+                default: return std::nullopt;
+            }
+        }
+
+        // Returns the address of a built-in label (e.g. "IN"), if the label is built in
+        constexpr std::optional<unsigned int> GetBuiltInLabelAddress(std::string_view label) {
+            if (label == "MAX") {
+                return Constants::addressUserMax;
+            }
+            else if (label == "IN") {
+                return Constants::addressInput;
+            }
+            else if (label == "OUT") {
+                return Constants::addressOutput;
+            }
+            else if (label == "HALT") {
+                return Constants::addressHalt;
+            }
+            return std::nullopt;
+        }
+
+        // Built-in labels and names inherited from Object.prototype can't be defined
+        constexpr bool IsReservedLabel(std::string_view label) {
+            if (GetBuiltInLabelAddress(label)) {
+                return true;
+            }
+
+            for (std::string_view name : objectPropertyNames) {
+                if (label == name) {
+                    return true;
+                }
+            }
+            return false;
+        }
+    }
+}
@@ -0,0 +1,453 @@
+#include "batchverifier.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+#include "lockstep.h"
+#include "puzzles.h"
+
+using namespace Sic1;
+
+namespace {
+    // FNV-1a
+    uint64_t Hash(uint64_t hash, const uint8_t* data, size_t size) {
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ data[i]) * 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    bool AllSucceeded(const VerificationResult* results, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            if (results[i].status != VerificationStatus::Success) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Number of random test sets produced by each call to AddRandomTestSets
+    size_t GetRandomTestSetCount(const Puzzle& puzzle) {
+        if (!puzzle.createRandomTest) {
+            return 0;
+        }
+        return (puzzle.io.size() > 1) ? 2 : 1;
+    }
+
+    // Solutions that VerifyStream keeps in flight per worker thread (more than one, so workers have other chunks to
+    // take while a solution is being checked against its fixed test sets)
+    constexpr unsigned int streamSlotsPerThread = 2;
+
+    // Verdict for a distinct solution seen by VerifyStream (empty while it's still being verified), along with any
+    // identical solutions waiting on it
+    typedef struct {
+        std::optional<unsigned int> failureCount;
+        std::vector<Solution> waiting;
+    } StreamVerdict;
+
+    // Solution whose iterations are being verified in chunks; the last chunk to complete reports the verdict
+    typedef struct {
+        Solution solution;
+        const Puzzle* puzzle;
+        SolutionDigest digest;
+        std::atomic<unsigned int> failureCount;
+        std::atomic<unsigned int> remainingChunks;
+    } StreamEntry;
+}
+
+BatchVerifier::BatchVerifier(WorkStealingPool& pool, uint64_t seed, unsigned int iterations)
+    : m_pool(pool), m_seed(seed), m_iterations(iterations), m_cache(nullptr), m_statistics() {
+}
+
+uint64_t BatchVerifier::GetIterationSeed(const Solution& solution, unsigned int iteration) const {
+    // Note: The title's terminating null separates it from the program
+    uint64_t hash = Hash(0xcbf29ce484222325ull, reinterpret_cast<const uint8_t*>(solution.puzzleTitle.c_str()), solution.puzzleTitle.size() + 1);
+    hash = Hash(hash, solution.program.data(), solution.program.size());
+    return Random::DeriveSeed(Random::DeriveSeed(m_seed, hash), iteration);
+}
+
+bool BatchVerifier::VerifyFixedTestSets(const Solution& solution, const std::vector<TestSet>& testSets) const {
+    // Note: Only the standard test set uses the solution's own statistics as limits
+    std::vector<LockstepJob> jobs;
+    for (size_t i = 0; i < testSets.size(); i++) {
+        jobs.push_back({
+            &testSets[i],
+            (i == 0) ? solution.cycles.value_or(solutionCyclesExecutedMax) : verificationCyclesExecutedMax,
+            (i == 0) ? solution.bytes.value_or(solutionBytesMax) : solutionBytesMax,
+        });
+    }
+
+    LockstepVerifier verifier(solution.program);
+    const auto results = verifier.Verify(jobs);
+    return AllSucceeded(results.data(), results.size());
+}
+
+unsigned int BatchVerifier::GetIterationChunkSize(const Puzzle& puzzle) {
+    // Note: Zero means there are no random test sets
+    const size_t testSetsPerIteration = GetRandomTestSetCount(puzzle);
+    if (testSetsPerIteration == 0) {
+        return 0;
+    }
+    return (std::max)(1u, static_cast<unsigned int>(LockstepVerifier::laneCount / testSetsPerIteration));
+}
+
+unsigned int BatchVerifier::CountIterationFailures(const Solution& solution, const Puzzle& puzzle, unsigned int begin, unsigned int end) const {
+    const size_t testSetsPerIteration = GetRandomTestSetCount(puzzle);
+    std::vector<TestSet> testSets;
+    for (unsigned int iteration = begin; iteration < end; iteration++) {
+        Random random(GetIterationSeed(solution, iteration));
+        AddRandomTestSets(puzzle, random, testSets);
+    }
+
+    std::vector<LockstepJob> jobs;
+    for (const auto& testSet : testSets) {
+        jobs.push_back({ &testSet, verificationCyclesExecutedMax, solutionBytesMax });
+    }
+
+    LockstepVerifier verifier(solution.program);
+    const auto results = verifier.Verify(jobs);
+
+    unsigned int failureCount = 0;
+    for (unsigned int i = 0; i < end - begin; i++) {
+        if (!AllSucceeded(&results[i * testSetsPerIteration], testSetsPerIteration)) {
+            failureCount++;
+        }
+    }
+    return failureCount;
+}
+
+std::vector<unsigned int> BatchVerifier::CountFailures(const std::vector<Solution>& solutions, const BatchProgressCallback& onProgress, std::chrono::milliseconds progressPeriod) {
+    const auto& puzzles = GetPuzzles();
+    std::vector<size_t> puzzleIndexes;
+    for (const auto& solution : solutions) {
+        const Puzzle* puzzle = FindPuzzle(solution.puzzleTitle);
+        if (!puzzle) {
+            throw std::runtime_error("Unknown puzzle: " + solution.puzzleTitle);
+        }
+        puzzleIndexes.push_back(static_cast<size_t>(puzzle - puzzles.data()));
+    }
+
+    std::vector<std::vector<TestSet>> fixedTestSets(puzzles.size());
+    for (size_t puzzleIndex : puzzleIndexes) {
+        if (fixedTestSets[puzzleIndex].empty()) {
+            fixedTestSets[puzzleIndex] = GetFixedTestSets(puzzles[puzzleIndex]);
+        }
+    }
+
+    // Deduplicate by content, and skip anything that's already in the cache; only the first solution with a given
+    // digest is verified
+    std::unordered_map<SolutionDigest, size_t, SolutionDigestHash> digestToUniqueIndex;
+    std::vector<SolutionDigest> uniqueDigests;
+    std::vector<size_t> uniqueSolutionIndexes;
+    std::vector<size_t> uniqueIndexes;
+    for (size_t i = 0; i < solutions.size(); i++) {
+        const SolutionDigest digest = GetSolutionDigest(solutions[i]);
+        const auto inserted = digestToUniqueIndex.insert({ digest, uniqueDigests.size() });
+        if (inserted.second) {
+            uniqueDigests.push_back(digest);
+            uniqueSolutionIndexes.push_back(i);
+        }
+        uniqueIndexes.push_back(inserted.first->second);
+    }
+
+    if (m_cache) {
+        m_cache->SetParameters(m_seed, m_iterations);
+    }
+
+    m_statistics = { solutions.size(), uniqueDigests.size(), 0, 0 };
+    std::vector<unsigned int> uniqueFailures(uniqueDigests.size(), 0);
+    std::vector<size_t> uncachedUniqueIndexes;
+    for (size_t i = 0; i < uniqueDigests.size(); i++) {
+        if (m_cache && m_cache->TryGet(uniqueDigests[i], uniqueFailures[i])) {
+            m_statistics.cachedCount++;
+        }
+        else {
+            uncachedUniqueIndexes.push_back(i);
+        }
+    }
+    m_statistics.verifiedCount = uncachedUniqueIndexes.size();
+
+    // Note: Indexed by solution index, but only used for solutions that are verified
+    std::vector<std::atomic<unsigned int>> failures(solutions.size());
+    for (auto& failureCount : failures) {
+        failureCount.store(0);
+    }
+
+    std::atomic<uint64_t> completed(0);
+    const uint64_t total = static_cast<uint64_t>(uncachedUniqueIndexes.size()) * m_iterations;
+
+    // Verifies the random test sets for a range of iterations of one solution
+    auto verifyIterations = [&](size_t index, unsigned int begin, unsigned int end) {
+        failures[index] += CountIterationFailures(solutions[index], puzzles[puzzleIndexes[index]], begin, end);
+        completed += end - begin;
+    };
+
+    // Verifies test sets that are the same for every iteration, and then queues the random ones in chunks
+    auto verifySolution = [&](size_t index) {
+        const Puzzle& puzzle = puzzles[puzzleIndexes[index]];
+        if (!VerifyFixedTestSets(solutions[index], fixedTestSets[puzzleIndexes[index]])) {
+            failures[index] = m_iterations;
+            completed += m_iterations;
+            return;
+        }
+
+        const unsigned int chunkSize = GetIterationChunkSize(puzzle);
+        if (chunkSize == 0) {
+            completed += m_iterations;
+            return;
+        }
+
+        for (unsigned int begin = 0; begin < m_iterations; begin += chunkSize) {
+            const unsigned int end = (std::min)(m_iterations, begin + chunkSize);
+            m_pool.Submit([&verifyIterations, index, begin, end]() { verifyIterations(index, begin, end); });
+        }
+    };
+
+    for (size_t uniqueIndex : uncachedUniqueIndexes) {
+        const size_t index = uniqueSolutionIndexes[uniqueIndex];
+        m_pool.Submit([&verifySolution, index]() { verifySolution(index); });
+    }
+
+    while (!m_pool.WaitFor(progressPeriod)) {
+        if (onProgress) {
+            onProgress(completed.load(), total);
+        }
+    }
+
+    for (size_t uniqueIndex : uncachedUniqueIndexes) {
+        uniqueFailures[uniqueIndex] = failures[uniqueSolutionIndexes[uniqueIndex]].load();
+        if (m_cache) {
+            m_cache->Set(uniqueDigests[uniqueIndex], uniqueFailures[uniqueIndex]);
+        }
+    }
+
+    // Fan verdicts out to every solution with the same digest
+    std::vector<unsigned int> result;
+    for (size_t uniqueIndex : uniqueIndexes) {
+        result.push_back(uniqueFailures[uniqueIndex]);
+    }
+    return result;
+}
+
+
+void BatchVerifier::VerifyStream(BoundedQueue<Solution>& queue, const VerdictCallback& onVerdict, const BatchProgressCallback& onProgress, std::chrono::milliseconds progressPeriod) {
+    typedef BoundedQueue<Solution>::PopResult PopResult;
+    const auto& puzzles = GetPuzzles();
+    std::vector<std::vector<TestSet>> fixedTestSets(puzzles.size());
+    std::unique_ptr<std::once_flag[]> fixedTestSetsCreated(new std::once_flag[puzzles.size()]);
+
+    if (m_cache) {
+        m_cache->SetParameters(m_seed, m_iterations);
+    }
+
+    // Verdicts for the distinct solutions seen so far, along with the cache and statistics
+    std::mutex mutex;
+    std::unordered_map<SolutionDigest, StreamVerdict, SolutionDigestHash> verdicts;
+    m_statistics = { 0, 0, 0, 0 };
+
+    // Serializes verdict callbacks
+    std::mutex callbackMutex;
+
+    // Solutions are only taken from the queue while fewer than this many are in flight (received, but not yet
+    // completed), so only a few solutions are in flight, regardless of how many iterations they're split into
+    const uint64_t slotCount = static_cast<uint64_t>(m_pool.GetThreadCount()) * streamSlotsPerThread;
+    std::mutex slotMutex;
+    std::condition_variable slotFreed;
+    bool canceled = false;
+    std::atomic<uint64_t> completed(0);
+
+    // Note: Only used on this thread
+    uint64_t received = 0;
+
+    // Cancels the queue (to release the producer) and stops taking solutions
+    auto cancel = [&]() {
+        queue.Cancel();
+        {
+            std::lock_guard<std::mutex> lock(slotMutex);
+            canceled = true;
+        }
+        slotFreed.notify_all();
+    };
+
+    // Runs part of the verification on the pool, canceling if it throws; the pool rethrows the exception once everything
+    // that's already running has completed
+    auto guard = [&cancel](const auto& function) {
+        try {
+            function();
+        }
+        catch (...) {
+            cancel();
+            throw;
+        }
+    };
+
+    auto complete = [&](const Solution& solution, unsigned int failureCount) {
+        {
+            std::lock_guard<std::mutex> lock(callbackMutex);
+            onVerdict(solution, failureCount);
+        }
+        {
+            std::lock_guard<std::mutex> lock(slotMutex);
+            completed++;
+        }
+        slotFreed.notify_one();
+    };
+
+    // Records the verdict for a distinct solution and reports it for any identical solutions that were waiting on it
+    auto finish = [&](const Solution& solution, const SolutionDigest& digest, unsigned int failureCount) {
+        std::vector<Solution> waiting;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            StreamVerdict& verdict = verdicts[digest];
+            verdict.failureCount = failureCount;
+            waiting.swap(verdict.waiting);
+            if (m_cache) {
+                m_cache->Set(digest, failureCount);
+            }
+        }
+
+        complete(solution, failureCount);
+        for (const auto& waitingSolution : waiting) {
+            complete(waitingSolution, failureCount);
+        }
+    };
+
+    // Test sets that are the same for every iteration are verified first, and then the random ones are queued in chunks
+    // (the same work units as CountFailures)
+    auto verifySolution = [&](const std::shared_ptr<StreamEntry>& entry) {
+        guard([&]() {
+            const size_t puzzleIndex = static_cast<size_t>(entry->puzzle - puzzles.data());
+            std::call_once(fixedTestSetsCreated[puzzleIndex], [&]() { fixedTestSets[puzzleIndex] = GetFixedTestSets(*entry->puzzle); });
+            if (!VerifyFixedTestSets(entry->solution, fixedTestSets[puzzleIndex])) {
+                finish(entry->solution, entry->digest, m_iterations);
+                return;
+            }
+
+            const unsigned int chunkSize = GetIterationChunkSize(*entry->puzzle);
+            if (chunkSize == 0 || m_iterations == 0) {
+                finish(entry->solution, entry->digest, 0);
+                return;
+            }
+
+            entry->remainingChunks = (m_iterations + chunkSize - 1) / chunkSize;
+            for (unsigned int begin = 0; begin < m_iterations; begin += chunkSize) {
+                const unsigned int end = (std::min)(m_iterations, begin + chunkSize);
+                m_pool.Submit([&, entry, begin, end]() {
+                    guard([&]() {
+                        entry->failureCount += CountIterationFailures(entry->solution, *entry->puzzle, begin, end);
+                        if (--entry->remainingChunks == 0) {
+                            finish(entry->solution, entry->digest, entry->failureCount.load());
+                        }
+                    });
+                });
+            }
+        });
+    };
+
+    auto lastProgressTime = std::chrono::steady_clock::now();
+    auto reportProgressIfNeeded = [&]() {
+        const auto now = std::chrono::steady_clock::now();
+        if (onProgress && now - lastProgressTime >= progressPeriod) {
+            onProgress(completed.load(), received);
+            lastProgressTime = now;
+        }
+    };
+
+    // Solutions are taken from the queue on this thread (instead of by tasks on the pool), so that workers never block
+    // waiting on the producer while there are iteration chunks to verify
+    try {
+        while (true) {
+            reportProgressIfNeeded();
+            {
+                std::unique_lock<std::mutex> lock(slotMutex);
+                if (!slotFreed.wait_for(lock, progressPeriod, [&]() { return canceled || received - completed.load() < slotCount; })) {
+                    continue;
+                }
+
+                if (canceled) {
+                    break;
+                }
+            }
+
+            Solution solution;
+            const PopResult popResult = queue.PopFor(solution, progressPeriod);
+            if (popResult == PopResult::TimedOut) {
+                continue;
+            }
+            else if (popResult == PopResult::Finished) {
+                break;
+            }
+
+            received++;
+
+            const Puzzle* puzzle = FindPuzzle(solution.puzzleTitle);
+            if (!puzzle) {
+                throw std::runtime_error("Unknown puzzle: " + solution.puzzleTitle);
+            }
+
+            const SolutionDigest digest = GetSolutionDigest(solution);
+            std::optional<unsigned int> knownFailureCount;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                m_statistics.solutionCount++;
+                const auto inserted = verdicts.insert({ digest, StreamVerdict() });
+                StreamVerdict& verdict = inserted.first->second;
+                if (!inserted.second) {
+                    if (!verdict.failureCount) {
+                        // An identical solution is still being verified; this slot is freed up once it's done
+                        verdict.waiting.push_back(std::move(solution));
+                        continue;
+                    }
+                    knownFailureCount = verdict.failureCount;
+                }
+                else {
+                    m_statistics.uniqueCount++;
+                    unsigned int failureCount = 0;
+                    if (m_cache && m_cache->TryGet(digest, failureCount)) {
+                        m_statistics.cachedCount++;
+                        verdict.failureCount = failureCount;
+                        knownFailureCount = failureCount;
+                    }
+                    else {
+                        m_statistics.verifiedCount++;
+                    }
+                }
+            }
+
+            if (knownFailureCount) {
+                complete(solution, *knownFailureCount);
+                continue;
+            }
+
+            auto entry = std::make_shared<StreamEntry>();
+            entry->solution = std::move(solution);
+            entry->puzzle = puzzle;
+            entry->digest = digest;
+            entry->failureCount = 0;
+            entry->remainingChunks = 0;
+            m_pool.Submit([&verifySolution, entry]() { verifySolution(entry); });
+        }
+    }
+    catch (...) {
+        // Tasks that are already running refer to this function's state, so they have to complete first
+        cancel();
+        try {
+            m_pool.Wait();
+        }
+        catch (...) {
+        }
+        throw;
+    }
+
+    while (!m_pool.WaitFor(progressPeriod)) {
+        if (onProgress) {
+            onProgress(completed.load(), received);
+        }
+    }
+}
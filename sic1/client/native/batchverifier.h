@@ -0,0 +1,112 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+#include "boundedqueue.h"
+#include "puzzles.h"
+#include "solutiondb.h"
+#include "verdictcache.h"
+#include "workstealingpool.h"
+
+// Parallel equivalent of isSolutionRobustlyValid in tools/cli/shared.ts, for verifying entire solution databases
+namespace Sic1 {
+    // Number of validation iterations to run before deciding a solution is actually robust (validationIterations)
+    constexpr unsigned int validationIterations = 200;
+
+    // Cycle limit for solutions that don't specify one (cyclesExecutedMax in tools/cli/shared.ts)
+    constexpr uint64_t solutionCyclesExecutedMax = 10000;
+
+    typedef std::function<void(uint64_t completed, uint64_t total)> BatchProgressCallback;
+    typedef std::function<void(const Solution& solution, unsigned int failures)> VerdictCallback;
+
+    typedef struct {
+        // Solutions passed in
+        size_t solutionCount;
+
+        // Distinct solutions (by SolutionDigest), i.e. the work left after deduplication
+        size_t uniqueCount;
+
+        // Distinct solutions whose verdicts came from the cache
+        size_t cachedCount;
+
+        // Distinct solutions that were actually verified
+        size_t verifiedCount;
+    } BatchStatistics;
+
+    // Verifies each solution a number of times (each time with newly generated random test sets), spreading
+    // (solution, iteration) work units across the pool's workers.
+    //
+    // Test sets that never change (the standard test set and any fixed ones) are only verified once per solution, and
+    // the random test sets of several iterations are verified together using LockstepVerifier.
+    //
+    // Random test sets are generated from the seed, the solution's puzzle and program, and the iteration number, so
+    // results are reproducible (regardless of thread count or scheduling) and a failing iteration can be regenerated
+    // with GetIterationSeed.
+    //
+    // Identical solutions (see SolutionDigest) submitted by different users are only verified once, and, if a verdict
+    // cache is supplied, solutions verified by an earlier run are skipped entirely.
+    class BatchVerifier {
+    public:
+        BatchVerifier(WorkStealingPool& pool, uint64_t seed, unsigned int iterations = validationIterations);
+
+        uint64_t GetSeed() const {
+            return m_seed;
+        }
+
+        unsigned int GetIterations() const {
+            return m_iterations;
+        }
+
+        // Seed for GeneratePuzzleTest that reproduces the test sets of one iteration for a solution
+        uint64_t GetIterationSeed(const Solution& solution, unsigned int iteration) const;
+
+        // Verdicts are looked up in, and added to, the cache (which is reset if it was for a different seed or number of
+        // iterations); null disables caching. The caller is responsible for saving the cache.
+        void SetVerdictCache(VerdictCache* cache) {
+            m_cache = cache;
+        }
+
+        // Statistics for the most recent call to CountFailures
+        const BatchStatistics& GetStatistics() const {
+            return m_statistics;
+        }
+
+        // Returns the number of failed iterations for each solution. While waiting, the progress callback (if any) is
+        // called on the calling thread about once per period with the number of iterations completed so far (out of
+        // the iterations actually needed after deduplication and caching).
+        //
+        // Throws std::runtime_error if a solution is for an unknown puzzle.
+        std::vector<unsigned int> CountFailures(const std::vector<Solution>& solutions, const BatchProgressCallback& onProgress = nullptr, std::chrono::milliseconds progressPeriod = std::chrono::milliseconds(1000));
+
+        // Streaming equivalent of CountFailures: solutions are taken from the queue (which is typically filled by another
+        // thread using StreamSolutions) until it's closed and drained, and the verdict callback receives each
+        // solution's number of failed iterations (in no particular order, one call at a time, on worker threads or the
+        // calling thread).
+        //
+        // Solutions are taken from the queue on the calling thread, and each is split into the same (solution,
+        // iteration) work units as CountFailures, but only a couple of solutions per worker are in flight at a time, so
+        // verification overlaps with reading and memory use is bounded by the queue's capacity and thread count (plus a
+        // small entry per distinct solution, for deduplication) instead of the number of solutions.
+        //
+        // The progress callback receives the number of solutions completed and received so far (on the calling thread,
+        // about once per period). Verdicts and
+        // statistics are the same as CountFailures would produce. If anything throws (e.g. a solution is for an
+        // unknown puzzle), the queue is canceled (so the producer's pushes fail) and the exception is rethrown.
+        void VerifyStream(BoundedQueue<Solution>& queue, const VerdictCallback& onVerdict, const BatchProgressCallback& onProgress = nullptr, std::chrono::milliseconds progressPeriod = std::chrono::milliseconds(1000));
+
+    private:
+        // Returns true if the solution passes all of its puzzle's fixed test sets
+        bool VerifyFixedTestSets(const Solution& solution, const std::vector<TestSet>& testSets) const;
+
+        // Number of iterations whose random test sets fill one LockstepVerifier (or zero, if there are none)
+        static unsigned int GetIterationChunkSize(const Puzzle& puzzle);
+
+        unsigned int CountIterationFailures(const Solution& solution, const Puzzle& puzzle, unsigned int begin, unsigned int end) const;
+
+        WorkStealingPool& m_pool;
+        uint64_t m_seed;
+        unsigned int m_iterations;
+        VerdictCache* m_cache;
+        BatchStatistics m_statistics;
+    };
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+namespace Sic1 {
+    // Multi-producer, multi-consumer queue with a fixed capacity, for handing work from a producer (e.g. a streaming
+    // parser) to consumers without letting the producer run arbitrarily far ahead. Producers block while the queue is
+    // full and consumers block while it's empty.
+    template<typename T>
+    class BoundedQueue {
+    public:
+        enum class PopResult : uint8_t {
+            Popped,
+            TimedOut,
+
+            // Closed and drained (or canceled)
+            Finished,
+        };
+
+        explicit BoundedQueue(size_t capacity)
+            : m_capacity((capacity > 0) ? capacity : 1), m_closed(false), m_canceled(false) {
+        }
+
+        BoundedQueue(const BoundedQueue&) = delete;
+        BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+        size_t GetCapacity() const {
+            return m_capacity;
+        }
+
+        // Blocks while the queue is full; returns false (discarding the item) if the queue was closed or canceled
+        bool Push(T item) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_notFull.wait(lock, [this]() { return m_items.size() < m_capacity || m_closed || m_canceled; });
+            if (m_closed || m_canceled) {
+                return false;
+            }
+
+            m_items.push_back(std::move(item));
+            lock.unlock();
+            m_notEmpty.notify_one();
+            return true;
+        }
+
+        // Blocks while the queue is empty; returns false once the queue has been closed and drained (or canceled)
+        bool Pop(T& item) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_notEmpty.wait(lock, [this]() { return !m_items.empty() || m_closed || m_canceled; });
+            if (m_canceled || m_items.empty()) {
+                return false;
+            }
+
+            item = std::move(m_items.front());
+            m_items.pop_front();
+            lock.unlock();
+            m_notFull.notify_one();
+            return true;
+        }
+
+        // Same as Pop, but gives up if the queue is still empty after the timeout (e.g. so a consumer can do other work
+        // while waiting for the producer)
+        PopResult PopFor(T& item, std::chrono::milliseconds timeout) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (!m_notEmpty.wait_for(lock, timeout, [this]() { return !m_items.empty() || m_closed || m_canceled; })) {
+                return PopResult::TimedOut;
+            }
+
+            if (m_canceled || m_items.empty()) {
+                return PopResult::Finished;
+            }
+
+            item = std::move(m_items.front());
+            m_items.pop_front();
+            lock.unlock();
+            m_notFull.notify_one();
+            return PopResult::Popped;
+        }
+
+        // Indicates that nothing more will be pushed; consumers still receive the items that are already queued
+        void Close() {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_closed = true;
+            }
+            m_notEmpty.notify_all();
+            m_notFull.notify_all();
+        }
+
+        // Abandons the queue (e.g. after a consumer fails): queued items are discarded and all waiting producers and
+        // consumers are released
+        void Cancel() {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_canceled = true;
+                m_items.clear();
+            }
+            m_notEmpty.notify_all();
+            m_notFull.notify_all();
+        }
+
+    private:
+        const size_t m_capacity;
+        std::mutex m_mutex;
+        std::condition_variable m_notEmpty;
+        std::condition_variable m_notFull;
+        std::deque<T> m_items;
+        bool m_closed;
+        bool m_canceled;
+    };
+}
@@ -0,0 +1,12 @@
+#include "embeddedassembler.h"
+
+#include <stdexcept>
+#include <string>
+
+using namespace Sic1;
+
+void EmbeddedAssembler::ReportError(std::string_view source, const char* reason) {
+    // The full assembler reports the same error (with context) that a script would see
+    Assembler::Assemble(source);
+    throw std::length_error(std::string("Failed to assemble embedded program: ") + reason);
+}
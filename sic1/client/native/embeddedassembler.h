@@ -0,0 +1,366 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+#include "assemblerlexer.h"
+
+// Compile-time SIC-1 assembler, for embedding programs (e.g. in tests and benchmarks) without assembling them at run
+// time. In a constant expression, a program that doesn't assemble is a compile error (at a call to ReportError, whose
+// reason names the problem); otherwise, the error is thrown just as Assembler::Assemble would throw it.
+//
+// Example:
+//
+//   constexpr auto program = EmbeddedAssembler::Assemble("@loop: subleq @OUT, @IN, @loop");
+//   static_assert(program.size == 3);
+namespace Sic1 {
+    typedef struct {
+        // Without the "@" prefix (note: this is a view into the source)
+        std::string_view label;
+        unsigned int address;
+
+        // Labels that Assembler reports as variables (i.e. labels on ".data" directives and inline labels)
+        bool isVariable;
+    } EmbeddedLabel;
+
+    template<size_t LabelCapacity>
+    struct EmbeddedProgram {
+        // Memory image (zero after the end of the program)
+        std::array<uint8_t, Constants::memorySize> bytes;
+        unsigned int size;
+
+        // In order of definition
+        std::array<EmbeddedLabel, LabelCapacity> labels;
+        unsigned int labelCount;
+
+        constexpr std::optional<unsigned int> GetLabelAddress(std::string_view label) const {
+            for (unsigned int i = 0; i < labelCount; i++) {
+                if (labels[i].label == label) {
+                    return labels[i].address;
+                }
+            }
+            return std::nullopt;
+        }
+
+        std::vector<uint8_t> GetBytes() const {
+            return std::vector<uint8_t>(bytes.begin(), bytes.begin() + size);
+        }
+    };
+
+    class EmbeddedAssembler {
+    public:
+        // Assembles a program (lines are separated by "\n" only, as in Assembler::Assemble). Breakpoints are accepted,
+        // but not recorded, and there is no source map.
+        template<size_t LabelCapacity = 64>
+        static constexpr EmbeddedProgram<LabelCapacity> Assemble(std::string_view source) {
+            EmbeddedProgram<LabelCapacity> program = {};
+            State state = {};
+
+            for (size_t lineStart = 0; ; ) {
+                const size_t lineEnd = source.find('\n', lineStart);
+                AssembleLine(source, source.substr(lineStart, (lineEnd == std::string_view::npos) ? lineEnd : lineEnd - lineStart), program, state);
+                if (lineEnd == std::string_view::npos) {
+                    break;
+                }
+                lineStart = lineEnd + 1;
+            }
+            program.size = state.address;
+
+            for (unsigned int i = 0; i < state.referenceCount; i++) {
+                const Reference& reference = state.references[i];
+                std::optional<unsigned int> labelAddress = Lexer::GetBuiltInLabelAddress(reference.label);
+                if (!labelAddress) {
+                    labelAddress = program.GetLabelAddress(reference.label);
+                    if (!labelAddress) {
+                        ReportError(source, "Undefined reference");
+                    }
+                }
+
+                const int value = (reference.negated ? SignedToUnsigned(-static_cast<int>(*labelAddress)) : static_cast<int>(*labelAddress)) + reference.offset;
+                if (value < static_cast<int>(Constants::addressMin) || value > static_cast<int>(Constants::addressMax)) {
+                    ReportError(source, "Reference is out of range");
+                }
+                program.bytes[reference.address] = static_cast<uint8_t>(value);
+            }
+            return program;
+        }
+
+        // Throws the CompilationError that Assembler::Assemble reports for the source (or, if the program is valid, but
+        // exceeds one of EmbeddedAssembler's limits, std::length_error). This is not constexpr.
+        [[noreturn]] static void ReportError(std::string_view source, const char* reason);
+
+    private:
+        typedef struct {
+            std::string_view label;
+            bool negated;
+            int offset;
+
+            // Address of the byte to fill in
+            unsigned int address;
+        } Reference;
+
+        typedef struct {
+            unsigned int address;
+
+            // References are resolved once all labels are known (note: each reference is a byte of the program)
+            std::array<Reference, Constants::memorySize> references;
+            unsigned int referenceCount;
+        } State;
+
+        // Reads a line's tokens one at a time (reporting invalid tokens, and stopping at comments)
+        class TokenReader {
+        public:
+            constexpr TokenReader(std::string_view source, std::string_view line)
+                : m_source(source), m_line(line), m_index(0), m_token{}, m_hasToken(false) {
+                Advance();
+            }
+
+            constexpr bool HasToken() const {
+                return m_hasToken;
+            }
+
+            constexpr const Lexer::Token& GetToken() const {
+                return m_token;
+            }
+
+            constexpr bool IsAt(Lexer::TokenType tokenType) const {
+                return m_hasToken && m_token.tokenType == tokenType;
+            }
+
+            constexpr void Advance() {
+                m_hasToken = false;
+                if (m_index < m_line.size()) {
+                    switch (Lexer::ScanToken(m_line, m_index, m_token)) {
+                        case Lexer::ScanResult::Token:
+                            m_hasToken = true;
+                            m_index += m_token.raw.size();
+                            break;
+
+                        case Lexer::ScanResult::Comment:
+                            m_index = m_line.size();
+                            break;
+
+                        case Lexer::ScanResult::Invalid:
+                            ReportError(m_source, "Invalid token");
+                    }
+                }
+            }
+
+            constexpr void SkipWhiteSpace() {
+                while (IsAt(Lexer::TokenType::WhiteSpace)) {
+                    Advance();
+                }
+            }
+
+        private:
+            std::string_view m_source;
+            std::string_view m_line;
+            size_t m_index;
+            Lexer::Token m_token;
+            bool m_hasToken;
+        };
+
+        template<size_t LabelCapacity>
+        static constexpr void AddLabelDefinitions(std::string_view source, TokenReader& reader, unsigned int address, bool isInline, EmbeddedProgram<LabelCapacity>& program) {
+            for (; reader.HasToken(); reader.Advance()) {
+                if (reader.IsAt(Lexer::TokenType::Label)) {
+                    const std::string_view label = reader.GetToken().group;
+                    if (Lexer::IsReservedLabel(label) || program.GetLabelAddress(label)) {
+                        ReportError(source, "Label already defined");
+                    }
+                    else if (program.labelCount >= LabelCapacity) {
+                        ReportError(source, "Too many labels (increase LabelCapacity)");
+                    }
+                    program.labels[program.labelCount++] = { label, address, isInline };
+                }
+                else if (!reader.IsAt(Lexer::TokenType::WhiteSpace)) {
+                    break;
+                }
+            }
+        }
+
+        template<size_t LabelCapacity>
+        static constexpr void EmitByte(std::string_view source, unsigned int address, uint8_t value, EmbeddedProgram<LabelCapacity>& program) {
+            if (address > Constants::addressUserMax) {
+                ReportError(source, "Program is too large");
+            }
+            program.bytes[address] = value;
+        }
+
+        template<size_t LabelCapacity>
+        static constexpr void EmitReference(std::string_view source, const Lexer::Token& token, unsigned int address, EmbeddedProgram<LabelCapacity>& program, State& state) {
+            EmitByte(source, address, 0, program);
+
+            // Offsets are saturated (as with number literals), since large offsets are out of range anyway
+            const int offset = token.offset.empty() ? 0 : Lexer::ParseNumberLiteral(token.offset.substr((token.offset[0] == '+') ? 1 : 0));
+            state.references[state.referenceCount++] = { token.group, token.raw[0] == '-', offset, address };
+        }
+
+        static constexpr uint8_t ParseCharacter(std::string_view source, std::string_view text, size_t& index) {
+            if (text[index] != '\\') {
+                return static_cast<uint8_t>(text[index++]);
+            }
+
+            const std::optional<uint8_t> value = Lexer::GetEscapeCodeValue(text[index + 1]);
+            if (!value) {
+                ReportError(source, "Invalid escape code");
+            }
+            index += 2;
+            return *value;
+        }
+
+        // Emits a ".data" argument, returning the number of bytes emitted
+        template<size_t LabelCapacity>
+        static constexpr unsigned int EmitValueExpression(std::string_view source, const Lexer::Token& token, unsigned int address, EmbeddedProgram<LabelCapacity>& program, State& state) {
+            const bool negated = (token.raw[0] == '-');
+            switch (token.tokenType) {
+                case Lexer::TokenType::NumberLiteral:
+                    {
+                        const int value = Lexer::ParseNumberLiteral(token.raw);
+                        if (value < Constants::valueMin || value > Constants::valueMax) {
+                            ReportError(source, "Value is out of range");
+                        }
+                        EmitByte(source, address, SignedToUnsigned(value), program);
+                        return 1;
+                    }
+
+                case Lexer::TokenType::CharacterLiteral:
+                    {
+                        size_t index = 0;
+                        const uint8_t value = ParseCharacter(source, token.group, index);
+                        EmitByte(source, address, negated ? SignedToUnsigned(-value) : value, program);
+                        return 1;
+                    }
+
+                case Lexer::TokenType::Reference:
+                    EmitReference(source, token, address, program, state);
+                    return 1;
+
+                case Lexer::TokenType::StringLiteral:
+                    {
+                        // Characters followed by a terminating zero
+                        unsigned int count = 0;
+                        for (size_t index = 0; index < token.group.size(); count++) {
+                            const uint8_t value = ParseCharacter(source, token.group, index);
+                            EmitByte(source, address + count, negated ? SignedToUnsigned(-value) : value, program);
+                        }
+                        EmitByte(source, address + count, 0, program);
+                        return count + 1;
+                    }
+
+                default:
+                    ReportError(source, "Invalid value expression");
+            }
+        }
+
+        // See ParseTokens in assembler.cpp
+        template<size_t LabelCapacity>
+        static constexpr void AssembleLine(std::string_view source, std::string_view line, EmbeddedProgram<LabelCapacity>& program, State& state) {
+            TokenReader reader(source, line);
+            const unsigned int address = state.address;
+            const unsigned int firstLabel = program.labelCount;
+
+            // Check for persistent breakpoint indicator at the beginning of the line
+            reader.SkipWhiteSpace();
+            const bool breakpoint = reader.IsAt(Lexer::TokenType::ExclamationMark);
+            if (breakpoint) {
+                reader.Advance();
+            }
+
+            // Check for label(s)
+            AddLabelDefinitions(source, reader, address, false, program);
+
+            // Check for command
+            reader.SkipWhiteSpace();
+            if (!reader.HasToken()) {
+                if (breakpoint) {
+                    ReportError(source, "Breakpoints are only supported on subleq instructions");
+                }
+                return;
+            }
+
+            const std::string_view commandName = reader.GetToken().raw;
+            const bool subleq = (commandName == Syntax::subleqInstruction);
+            if (!subleq && commandName != Syntax::dataDirective) {
+                ReportError(source, "Unknown command");
+            }
+            else if (breakpoint && !subleq) {
+                ReportError(source, "Breakpoints are only supported on subleq instructions");
+            }
+            reader.Advance();
+
+            // Add arguments
+            unsigned int argumentCount = 0;
+            unsigned int offset = 0;
+            while (reader.HasToken()) {
+                // Check for required whitespace/comma
+                if (argumentCount == 0) {
+                    if (!reader.IsAt(Lexer::TokenType::WhiteSpace)) {
+                        ReportError(source, "Whitespace is required after the command");
+                    }
+                }
+                else {
+                    if (!reader.IsAt(Lexer::TokenType::Comma) && !reader.IsAt(Lexer::TokenType::WhiteSpace)) {
+                        ReportError(source, "Whitespace or comma required between arguments");
+                    }
+
+                    reader.SkipWhiteSpace();
+                    if (reader.IsAt(Lexer::TokenType::Comma)) {
+                        reader.Advance();
+                    }
+                }
+
+                // Add any inline labels
+                AddLabelDefinitions(source, reader, address + offset, true, program);
+
+                // Parse the argument
+                if (reader.HasToken()) {
+                    const Lexer::Token& token = reader.GetToken();
+                    if (!subleq) {
+                        offset += EmitValueExpression(source, token, address + offset, program, state);
+                    }
+                    else if (token.tokenType == Lexer::TokenType::NumberLiteral) {
+                        const int value = Lexer::ParseNumberLiteral(token.raw);
+                        if (value < static_cast<int>(Constants::addressMin) || value > static_cast<int>(Constants::addressMax)) {
+                            ReportError(source, "Address is out of range");
+                        }
+                        EmitByte(source, address + offset++, static_cast<uint8_t>(value), program);
+                    }
+                    else if (token.tokenType == Lexer::TokenType::Reference) {
+                        EmitReference(source, token, address + offset++, program, state);
+                    }
+                    else {
+                        ReportError(source, "Invalid address expression");
+                    }
+
+                    argumentCount++;
+                    reader.Advance();
+                }
+            }
+
+            // Check argument count, and fill in the optional address
+            if (subleq) {
+                if (argumentCount < 2 || argumentCount > Constants::subleqInstructionBytes) {
+                    ReportError(source, "Invalid number of arguments for subleq");
+                }
+                else if (argumentCount < Constants::subleqInstructionBytes) {
+                    EmitByte(source, address + offset, static_cast<uint8_t>(address + Constants::subleqInstructionBytes), program);
+                }
+                state.address += Constants::subleqInstructionBytes;
+            }
+            else {
+                if (argumentCount == 0) {
+                    ReportError(source, "Invalid number of arguments for .data");
+                }
+
+                // All labels on a ".data" directive are variables
+                for (unsigned int i = firstLabel; i < program.labelCount; i++) {
+                    program.labels[i].isVariable = true;
+                }
+                state.address += offset;
+            }
+        }
+    };
+}
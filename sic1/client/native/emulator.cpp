@@ -0,0 +1,25 @@
+#include "emulator.h"
+
+#include <utility>
+
+using namespace Sic1;
+
+namespace {
+    template<size_t... addresses>
+    constexpr std::array<uint64_t, sizeof...(addresses)> CreateHashWeights(std::index_sequence<addresses...>) {
+        return { { GetMemoryHashWeight(addresses)... } };
+    }
+}
+
+// Note: This is constant-initialized, so it's safe to use during static initialization
+const std::array<uint64_t, Constants::memorySize> Sic1::memoryHashWeights = CreateHashWeights(std::make_index_sequence<Constants::memorySize>());
+
+uint64_t Sic1::HashMemory(const uint8_t* memory) {
+    uint64_t hash = 0;
+    for (unsigned int address = 0; address < Constants::memorySize; address++) {
+        hash += memoryHashWeights[address] * memory[address];
+    }
+    return hash;
+}
+
+template class Sic1::BasicEmulator<Sic1Machine>;
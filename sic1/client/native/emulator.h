@@ -0,0 +1,440 @@
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+// Native SIC-1 emulator, matching the behavior (including cycle and memory access accounting) of Emulator in
+// lib/src/sic1asm.ts
+namespace Sic1 {
+    namespace Constants {
+        // Valid values
+        constexpr int valueMin = -128;
+        constexpr int valueMax = 127;
+
+        // Valid addresses
+        constexpr unsigned int subleqInstructionBytes = 3;
+        constexpr unsigned int addressMin = 0;
+        constexpr unsigned int addressMax = 255;
+        constexpr unsigned int addressInstructionMax = addressMax - subleqInstructionBytes;
+
+        // Built-in addresses
+        constexpr unsigned int addressUserMax = 252;
+        constexpr unsigned int addressInput = 253;
+        constexpr unsigned int addressOutput = 254;
+        constexpr unsigned int addressHalt = 255;
+
+        constexpr unsigned int memorySize = addressMax + 1;
+    }
+
+    // Weight of an address in the incremental memory hash (odd and pseudorandom, via SplitMix64)
+    constexpr uint64_t GetMemoryHashWeight(size_t address) {
+        uint64_t z = (address + 1) * 0x9e3779b97f4a7c15ull;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return (z ^ (z >> 31)) | 1;
+    }
+
+    // Per-address weights for the incremental memory hash (GetMemoryHashWeight, precomputed for SIC-1's addresses)
+    extern const std::array<uint64_t, Constants::memorySize> memoryHashWeights;
+
+    // Hashes memory as the sum of each byte multiplied by its address's weight, so that a write only needs to add the
+    // weighted difference (see Emulator::GetMemoryHash)
+    uint64_t HashMemory(const uint8_t* memory);
+
+    constexpr int8_t UnsignedToSigned(uint8_t unsignedValue) {
+        return static_cast<int8_t>(unsignedValue);
+    }
+
+    constexpr uint8_t SignedToUnsigned(int signedValue) {
+        return static_cast<uint8_t>(signedValue & 0xff);
+    }
+
+    // SIC-1's I/O port layout: the last three addresses are @IN, @OUT, and @HALT, and instructions can start anywhere
+    // below them.
+    //
+    // I/O layouts passed to SubleqMachine are instantiated with the memory size and must provide addressInput,
+    // addressOutput, and addressHalt (writes to the input and halt ports are discarded), along with
+    // addressInstructionMax (execution halts once the instruction pointer moves past it).
+    template<unsigned int memorySize>
+    struct TopIoLayout {
+        static constexpr unsigned int addressInput = memorySize - 3;
+        static constexpr unsigned int addressOutput = memorySize - 2;
+        static constexpr unsigned int addressHalt = memorySize - 1;
+        static constexpr unsigned int addressInstructionMax = memorySize - 1 - Constants::subleqInstructionBytes;
+    };
+
+    // Describes a SUBLEQ machine: an unsigned word type (arithmetic wraps around at the word size, and values are
+    // interpreted as two's complement when branching and for I/O), the number of address bits (memory holds
+    // 2^addressBits words, and operands are masked to fit), and the I/O port layout
+    template<typename TWord, unsigned int TAddressBits, template<unsigned int> class TIoLayout = TopIoLayout>
+    struct SubleqMachine {
+        static_assert(std::is_unsigned_v<TWord>, "Words must be unsigned");
+        static_assert(TAddressBits >= 3 && TAddressBits <= 20, "Address width must be between 3 and 20 bits");
+        static_assert(TAddressBits <= 8 * sizeof(TWord), "Addresses must fit in a word");
+
+        typedef TWord Word;
+        typedef std::make_signed_t<TWord> SignedWord;
+
+        static constexpr unsigned int addressBits = TAddressBits;
+        static constexpr unsigned int memorySize = 1u << TAddressBits;
+        static constexpr unsigned int addressMax = memorySize - 1;
+
+        typedef TIoLayout<memorySize> IoLayout;
+        static constexpr unsigned int addressInput = IoLayout::addressInput;
+        static constexpr unsigned int addressOutput = IoLayout::addressOutput;
+        static constexpr unsigned int addressHalt = IoLayout::addressHalt;
+        static constexpr unsigned int addressInstructionMax = IoLayout::addressInstructionMax;
+        static_assert(addressInstructionMax + Constants::subleqInstructionBytes <= addressMax, "Instructions must fit in memory");
+
+        // Small memories are stored inline (so that emulators can live on the stack), larger ones on the heap
+        static constexpr bool memoryInline = (memorySize * sizeof(TWord) <= 4096);
+        typedef std::conditional_t<memoryInline, TWord[memorySize], std::vector<TWord>> Memory;
+    };
+
+    typedef SubleqMachine<uint8_t, 8> Sic1Machine;
+    static_assert(Sic1Machine::addressInput == Constants::addressInput
+        && Sic1Machine::addressOutput == Constants::addressOutput
+        && Sic1Machine::addressHalt == Constants::addressHalt
+        && Sic1Machine::addressInstructionMax == Constants::addressInstructionMax
+        && Sic1Machine::memorySize == Constants::memorySize
+        && Sic1Machine::memoryInline);
+
+    // I/O handler that supplies zeros for input and discards output (equivalent to omitting readInput and
+    // writeOutput in EmulatorOptions).
+    //
+    // I/O handlers passed to Emulator::Step must provide (with uint8_t and int8_t being the machine's Word and
+    // SignedWord for other SubleqMachines):
+    //
+    // * bool TryReadInput(uint8_t& value): supply the next input byte; returning false indicates the input has been
+    //   exhausted (which, as in the script emulator, causes the subtraction to produce zero)
+    // * void WriteOutput(int8_t value): consume an output value
+    struct NullIo {
+        template<typename TWord>
+        bool TryReadInput(TWord& value) {
+            value = 0;
+            return true;
+        }
+
+        template<typename TSignedWord>
+        void WriteOutput(TSignedWord) {
+        }
+    };
+
+    // Profiler that records nothing (Emulator::Step's default, which compiles away entirely).
+    //
+    // Profilers passed to Emulator::Step must provide:
+    //
+    // * void OnInstruction(unsigned int ip, unsigned int a, unsigned int b, bool branched): called after each
+    //   instruction, with the instruction's address and operands, and whether its result was non-positive (i.e. it
+    //   branched to its third operand)
+    struct NullProfiler {
+        void OnInstruction(unsigned int, unsigned int, unsigned int, bool) {
+        }
+    };
+
+    // Emulator for any SubleqMachine. All of the machine's parameters are compile-time constants, so the SIC-1
+    // instantiation (Emulator, below) compiles to the same code as a hand-written 8-bit emulator.
+    template<typename TMachine>
+    class BasicEmulator {
+    public:
+        typedef TMachine Machine;
+        typedef typename TMachine::Word Word;
+        typedef typename TMachine::SignedWord SignedWord;
+
+        // Addresses written since the last TakeMemoryUpdate, along with their current values packed in address order
+        // (i.e. values[i] belongs to the i-th set bit of changed), so that a UI can apply one batch per frame
+        typedef struct {
+            std::bitset<TMachine::memorySize> changed;
+            std::vector<Word> values;
+        } MemoryUpdate;
+
+        BasicEmulator(const Word* words, size_t count);
+        explicit BasicEmulator(const std::vector<Word>& words);
+
+        bool IsEmpty() const;
+
+        bool IsRunning() const {
+            return m_ip <= TMachine::addressInstructionMax;
+        }
+
+        unsigned int GetIp() const {
+            return m_ip;
+        }
+
+        uint64_t GetCyclesExecuted() const {
+            return m_cyclesExecuted;
+        }
+
+        unsigned int GetMemoryBytesAccessed() const {
+            return m_memoryBytesAccessed;
+        }
+
+        // Addresses accessed so far (GetMemoryBytesAccessed is the number of these)
+        const std::bitset<TMachine::memorySize>& GetMemoryAccessed() const {
+            return m_memoryAccessed;
+        }
+
+        // Inspects memory without counting as an access
+        Word GetMemory(unsigned int address) const {
+            return m_memory[address];
+        }
+
+        const Word* GetMemory() const {
+            return &m_memory[0];
+        }
+
+        // Hash of the current memory contents (equal to HashMemory(GetMemory()), but updated incrementally); used to
+        // cheaply detect repeated states
+        uint64_t GetMemoryHash() const {
+            return m_memoryHash;
+        }
+
+        template<typename TIo>
+        void Step(TIo& io) {
+            NullProfiler profiler;
+            Step(io, profiler);
+        }
+
+        template<typename TIo, typename TProfiler>
+        void Step(TIo& io, TProfiler& profiler);
+
+        // Executes the next instruction. Engines that translate code into blocks (e.g. TranslatedEmulator) may
+        // instead execute several instructions at once, but only if the caller would have kept stepping, i.e. if the
+        // cycle and memory byte totals stay within the given (inclusive) limits before each instruction, and never
+        // past an output.
+        template<typename TIo>
+        void StepBlock(TIo& io, uint64_t, unsigned int) {
+            Step(io);
+        }
+
+        // Runs until halted
+        template<typename TIo>
+        void Run(TIo& io);
+
+        // Runs until halted or until the given number of cycles have been executed (in total)
+        template<typename TIo>
+        void Run(TIo& io, uint64_t cyclesExecutedMax);
+
+        // Resets the emulator's memory back to its initial state
+        void Reset();
+
+        // True if memory has been written since the last TakeMemoryUpdate (loading and resetting count as writing all
+        // of memory)
+        bool HasMemoryUpdate() const {
+            return m_memoryDirty.any();
+        }
+
+        // Returns (and clears) the batch of addresses written since the last call
+        MemoryUpdate TakeMemoryUpdate();
+
+        // Equivalent to HashMemory, for this machine's memory
+        static uint64_t HashMemory(const Word* memory);
+
+    protected:
+        static uint64_t GetHashWeight(unsigned int address) {
+            if constexpr (TMachine::memorySize <= Constants::memorySize) {
+                return memoryHashWeights[address];
+            }
+            else {
+                return GetMemoryHashWeight(address);
+            }
+        }
+
+        void AccessMemory(unsigned int address) {
+            if (!m_memoryAccessed[address]) {
+                m_memoryAccessed[address] = true;
+                m_memoryBytesAccessed++;
+            }
+        }
+
+        Word ReadMemory(unsigned int address) {
+            AccessMemory(address);
+            return m_memory[address];
+        }
+
+        void WriteMemory(unsigned int address, Word value) {
+            AccessMemory(address);
+            SetMemory(address, value);
+        }
+
+        // Note: All writes go through here, to keep the memory hash up to date
+        void SetMemory(unsigned int address, Word value) {
+            m_memoryHash += GetHashWeight(address) * static_cast<uint64_t>(static_cast<int64_t>(value) - m_memory[address]);
+            m_memory[address] = value;
+            m_memoryDirty[address] = true;
+        }
+
+        // State
+        unsigned int m_ip;
+
+        // Memory
+        typename TMachine::Memory m_memory;
+        typename TMachine::Memory m_initialMemorySnapshot;
+        uint64_t m_memoryHash;
+        std::bitset<TMachine::memorySize> m_memoryDirty;
+
+        // Metrics
+        std::bitset<TMachine::memorySize> m_memoryAccessed;
+        unsigned int m_memoryBytesAccessed;
+        uint64_t m_cyclesExecuted;
+    };
+
+    // SIC-1
+    typedef BasicEmulator<Sic1Machine> Emulator;
+    typedef Emulator::MemoryUpdate MemoryUpdate;
+
+    template<typename TMachine>
+    inline BasicEmulator<TMachine>::BasicEmulator(const Word* words, size_t count)
+        : m_ip(0), m_memoryBytesAccessed(0), m_cyclesExecuted(0) {
+        if constexpr (!TMachine::memoryInline) {
+            m_memory.resize(TMachine::memorySize);
+        }
+
+        // Note: Anything beyond the end of memory is ignored
+        const size_t loadedCount = (count < TMachine::memorySize) ? count : TMachine::memorySize;
+        std::memset(&m_memory[0], 0, TMachine::memorySize * sizeof(Word));
+        if (loadedCount > 0) {
+            std::memcpy(&m_memory[0], words, loadedCount * sizeof(Word));
+        }
+
+        // Save initial memory to support resetting
+        if constexpr (TMachine::memoryInline) {
+            std::memcpy(m_initialMemorySnapshot, m_memory, sizeof(m_memory));
+        }
+        else {
+            m_initialMemorySnapshot = m_memory;
+        }
+
+        m_memoryHash = HashMemory(&m_memory[0]);
+        m_memoryDirty.set();
+    }
+
+    template<typename TMachine>
+    inline BasicEmulator<TMachine>::BasicEmulator(const std::vector<Word>& words)
+        : BasicEmulator(words.data(), words.size()) {
+    }
+
+    template<typename TMachine>
+    inline bool BasicEmulator<TMachine>::IsEmpty() const {
+        for (unsigned int i = 0; i < TMachine::memorySize; i++) {
+            if (m_memory[i] != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template<typename TMachine>
+    inline void BasicEmulator<TMachine>::Reset() {
+        // Reset state
+        m_ip = 0;
+        m_memoryAccessed.reset();
+        m_memoryBytesAccessed = 0;
+        m_cyclesExecuted = 0;
+
+        // Reset memory
+        std::memcpy(&m_memory[0], &m_initialMemorySnapshot[0], TMachine::memorySize * sizeof(Word));
+        m_memoryHash = HashMemory(&m_memory[0]);
+        m_memoryDirty.set();
+    }
+
+    template<typename TMachine>
+    inline typename BasicEmulator<TMachine>::MemoryUpdate BasicEmulator<TMachine>::TakeMemoryUpdate() {
+        MemoryUpdate update;
+        update.changed = m_memoryDirty;
+        update.values.reserve(m_memoryDirty.count());
+        for (unsigned int address = 0; address < TMachine::memorySize; address++) {
+            if (m_memoryDirty[address]) {
+                update.values.push_back(m_memory[address]);
+            }
+        }
+
+        m_memoryDirty.reset();
+        return update;
+    }
+
+    template<typename TMachine>
+    inline uint64_t BasicEmulator<TMachine>::HashMemory(const Word* memory) {
+        uint64_t hash = 0;
+        for (unsigned int address = 0; address < TMachine::memorySize; address++) {
+            hash += GetHashWeight(address) * memory[address];
+        }
+        return hash;
+    }
+
+    template<typename TMachine>
+    template<typename TIo, typename TProfiler>
+    inline void BasicEmulator<TMachine>::Step(TIo& io, TProfiler& profiler) {
+        if (IsRunning()) {
+            // Note: Masking operands to the address width is a no-op when addresses span a whole word (e.g. SIC-1)
+            const unsigned int ip = m_ip;
+            const unsigned int a = ReadMemory(m_ip++) & TMachine::addressMax;
+            const unsigned int b = ReadMemory(m_ip++) & TMachine::addressMax;
+            const unsigned int c = ReadMemory(m_ip++) & TMachine::addressMax;
+
+            // Read operands
+            Word input = 0;
+            bool inputValid = true;
+            if (a == TMachine::addressInput || b == TMachine::addressInput) {
+                AccessMemory(TMachine::addressInput);
+                inputValid = io.TryReadInput(input);
+            }
+
+            const Word av = (a == TMachine::addressInput) ? input : ReadMemory(a);
+            const Word bv = (b == TMachine::addressInput) ? input : ReadMemory(b);
+
+            // Arithmetic (wraps around on overflow; reading past the end of the input yields zero, just like NaN
+            // does in the script emulator)
+            const Word result = inputValid ? static_cast<Word>(av - bv) : 0;
+
+            // Write result
+            const SignedWord resultSigned = static_cast<SignedWord>(result);
+            switch (a) {
+            case TMachine::addressInput:
+            case TMachine::addressHalt:
+                break;
+
+            case TMachine::addressOutput:
+                AccessMemory(TMachine::addressOutput);
+                io.WriteOutput(resultSigned);
+                break;
+
+            default:
+                WriteMemory(a, result);
+                break;
+            }
+
+            // Branch, if necessary
+            const bool branched = (resultSigned <= 0);
+            if (branched) {
+                m_ip = c;
+            }
+
+            m_cyclesExecuted++;
+            profiler.OnInstruction(ip, a, b, branched);
+        }
+    }
+
+    template<typename TMachine>
+    template<typename TIo>
+    inline void BasicEmulator<TMachine>::Run(TIo& io) {
+        while (IsRunning()) {
+            Step(io);
+        }
+    }
+
+    template<typename TMachine>
+    template<typename TIo>
+    inline void BasicEmulator<TMachine>::Run(TIo& io, uint64_t cyclesExecutedMax) {
+        while (IsRunning() && m_cyclesExecuted < cyclesExecutedMax) {
+            Step(io);
+        }
+    }
+
+    extern template class BasicEmulator<Sic1Machine>;
+}
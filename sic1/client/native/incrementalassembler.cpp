@@ -0,0 +1,523 @@
+#include "incrementalassembler.h"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+
+using namespace Sic1;
+
+struct IncrementalAssembler::Line {
+    std::string text;
+    size_t index = 0;
+
+    // Lines that fail to parse are treated as empty (until the error is reported)
+    std::optional<CompilationError> error;
+    ParsedLine parsed = {};
+
+    // Indexes of label references in parsed.expressions (which are also offsets into the line's bytes)
+    std::vector<unsigned int> references;
+    unsigned int failedReferenceCount = 0;
+
+    // Literal values, resolved references (zero if they failed), and the implicit jump address (if any)
+    std::vector<uint8_t> bytes;
+    unsigned int variableCount = 0;
+
+    unsigned int address = 0;
+
+    // Address of the line's current entry in the program's source map
+    std::optional<unsigned int> mappedAddress;
+
+    bool changed = false;
+    bool queued = false;
+};
+
+namespace {
+    constexpr size_t noLine = std::numeric_limits<size_t>::max();
+
+    bool HasImplicitAddress(const ParsedLine& parsed) {
+        return parsed.command == Command::SubleqInstruction && parsed.expressions.size() < Constants::subleqInstructionBytes;
+    }
+}
+
+IncrementalAssembler::IncrementalAssembler()
+    : m_firstChangedLine(noLine), m_layoutChanged(false), m_errorLineCount(0), m_failedReferenceCount(0), m_byteCount(0) {
+}
+
+IncrementalAssembler::IncrementalAssembler(const std::vector<std::string>& lines) : IncrementalAssembler() {
+    ReplaceLines(0, 0, lines);
+}
+
+IncrementalAssembler::~IncrementalAssembler() {
+}
+
+size_t IncrementalAssembler::GetLineCount() const {
+    return m_lines.size();
+}
+
+const std::string& IncrementalAssembler::GetLine(size_t index) const {
+    return m_lines.at(index)->text;
+}
+
+void IncrementalAssembler::ReplaceLines(size_t index, size_t count, const std::vector<std::string>& lines) {
+    if (index > m_lines.size() || count > m_lines.size() - index) {
+        throw std::out_of_range("Line range is out of range");
+    }
+
+    // Lines that are replaced one-for-one keep their identity (and source map entries, if they don't change size)
+    const size_t common = std::min(count, lines.size());
+    for (size_t i = 0; i < common; i++) {
+        SetLine(index + i, lines[i]);
+    }
+
+    if (count > common) {
+        const auto begin = m_lines.begin() + (index + common);
+        const auto end = m_lines.begin() + (index + count);
+        for (auto it = begin; it != end; ++it) {
+            Line& line = **it;
+            RemoveFromGraph(line);
+            if (line.changed) {
+                m_changedLines.erase(std::find(m_changedLines.begin(), m_changedLines.end(), &line));
+            }
+        }
+        m_lines.erase(begin, end);
+    }
+    else if (lines.size() > common) {
+        std::vector<std::unique_ptr<Line>> insertedLines;
+        for (size_t i = common; i < lines.size(); i++) {
+            auto line = std::make_unique<Line>();
+            line->text = lines[i];
+            line->index = index + i;
+            ParseLine(*line);
+            AddToGraph(*line);
+            MarkChanged(*line);
+            insertedLines.push_back(std::move(line));
+        }
+        m_lines.insert(m_lines.begin() + (index + common), std::make_move_iterator(insertedLines.begin()), std::make_move_iterator(insertedLines.end()));
+    }
+
+    if (count != lines.size()) {
+        m_layoutChanged = true;
+        m_firstChangedLine = std::min(m_firstChangedLine, index + common);
+    }
+}
+
+void IncrementalAssembler::SetLine(size_t index, std::string_view text) {
+    Line& line = *m_lines.at(index);
+    const size_t previousSize = line.bytes.size();
+
+    RemoveFromGraph(line);
+    line.text = text;
+    ParseLine(line);
+    AddToGraph(line);
+    MarkChanged(line);
+
+    if (line.bytes.size() != previousSize) {
+        m_layoutChanged = true;
+    }
+}
+
+const AssembledProgram& IncrementalAssembler::GetProgram() {
+    Update();
+    if (m_error) {
+        throw *m_error;
+    }
+    return m_program;
+}
+
+const std::optional<CompilationError>& IncrementalAssembler::GetError() {
+    Update();
+    return m_error;
+}
+
+unsigned int IncrementalAssembler::GetByteCount() {
+    Update();
+    return m_byteCount;
+}
+
+void IncrementalAssembler::ParseLine(Line& line) {
+    line.error.reset();
+    line.parsed = {};
+    line.references.clear();
+    line.bytes.clear();
+    line.variableCount = 0;
+
+    if (!line.text.empty()) {
+        try {
+            // Note: the parsed line refers to the line's text, which doesn't move (lines are never copied)
+            line.parsed = Assembler::ParseLine(line.text, static_cast<unsigned int>(line.index + 1));
+        }
+        catch (const CompilationError& error) {
+            line.error = error;
+            line.parsed = {};
+            m_errorLineCount++;
+            return;
+        }
+    }
+
+    if (line.parsed.command) {
+        for (unsigned int i = 0; i < line.parsed.expressions.size(); i++) {
+            const Expression& expression = line.parsed.expressions[i];
+            if (expression.isReference) {
+                line.references.push_back(i);
+            }
+            line.bytes.push_back(expression.value);
+        }
+
+        // Placeholder for the implicit jump address (which depends on where the line ends up)
+        if (HasImplicitAddress(line.parsed)) {
+            line.bytes.push_back(0);
+        }
+    }
+
+    for (const auto& definition : line.parsed.labelDefinitions) {
+        if (definition.isInline || line.parsed.command == Command::DataDirective) {
+            line.variableCount++;
+        }
+    }
+}
+
+void IncrementalAssembler::AddToGraph(Line& line) {
+    const auto findOrAdd = [this](std::string_view name) {
+        auto it = m_labels.find(name);
+        if (it == m_labels.end()) {
+            it = m_labels.emplace(std::string(name), Label()).first;
+        }
+        return it;
+    };
+
+    const auto& definitions = line.parsed.labelDefinitions;
+    for (unsigned int i = 0; i < definitions.size(); i++) {
+        const auto it = findOrAdd(definitions[i].label);
+        it->second.definitions.push_back({ &line, i });
+        UpdateConflict(it);
+        m_movedLabels.insert(it->first);
+    }
+
+    for (unsigned int reference : line.references) {
+        findOrAdd(line.parsed.expressions[reference].label)->second.uses.push_back(&line);
+    }
+}
+
+void IncrementalAssembler::RemoveFromGraph(Line& line) {
+    // Unreferenced labels are removed right away, unless the pending update still needs them
+    const auto removeIfUnused = [this](LabelMap::iterator it) {
+        if (it->second.definitions.empty() && it->second.uses.empty() && m_movedLabels.find(it->first) == m_movedLabels.end()) {
+            m_labels.erase(it);
+        }
+    };
+
+    for (const auto& definition : line.parsed.labelDefinitions) {
+        const auto it = m_labels.find(definition.label);
+        if (it != m_labels.end()) {
+            auto& sites = it->second.definitions;
+            sites.erase(std::remove_if(sites.begin(), sites.end(), [&](const DefinitionSite& site) { return site.line == &line; }), sites.end());
+            UpdateConflict(it);
+            m_movedLabels.insert(it->first);
+        }
+    }
+
+    for (unsigned int reference : line.references) {
+        const auto it = m_labels.find(line.parsed.expressions[reference].label);
+        if (it != m_labels.end()) {
+            auto& uses = it->second.uses;
+            uses.erase(std::remove(uses.begin(), uses.end(), &line), uses.end());
+            removeIfUnused(it);
+        }
+    }
+
+    if (line.error) {
+        m_errorLineCount--;
+    }
+
+    m_failedReferenceCount -= line.failedReferenceCount;
+    line.failedReferenceCount = 0;
+}
+
+void IncrementalAssembler::MarkChanged(Line& line) {
+    if (!line.changed) {
+        line.changed = true;
+        m_changedLines.push_back(&line);
+    }
+    m_firstChangedLine = std::min(m_firstChangedLine, line.index);
+}
+
+void IncrementalAssembler::UpdateConflict(LabelMap::iterator label) {
+    const auto& definitions = label->second.definitions;
+    if (definitions.size() >= 2 || (!definitions.empty() && Assembler::IsReservedLabel(label->first))) {
+        m_conflicts.insert(label->first);
+    }
+    else {
+        m_conflicts.erase(label->first);
+    }
+}
+
+std::optional<unsigned int> IncrementalAssembler::GetLabelAddress(std::string_view name) const {
+    if (const auto builtInAddress = Assembler::GetBuiltInLabelAddress(name)) {
+        return builtInAddress;
+    }
+
+    // Note: if a label is defined more than once, the error is reported before references are resolved
+    const auto it = m_labels.find(name);
+    if (it == m_labels.end() || it->second.definitions.empty()) {
+        return std::nullopt;
+    }
+
+    const DefinitionSite& site = it->second.definitions.front();
+    return site.line->address + site.line->parsed.labelDefinitions[site.position].offset;
+}
+
+void IncrementalAssembler::ResolveReferences(Line& line) {
+    m_failedReferenceCount -= line.failedReferenceCount;
+    line.failedReferenceCount = 0;
+
+    for (unsigned int reference : line.references) {
+        const Expression& expression = line.parsed.expressions[reference];
+        const std::optional<unsigned int> labelAddress = GetLabelAddress(expression.label);
+        const std::optional<uint8_t> value = labelAddress ? Assembler::TryResolveReference(expression, *labelAddress) : std::nullopt;
+        line.bytes[reference] = value.value_or(0);
+        if (!value) {
+            line.failedReferenceCount++;
+        }
+    }
+
+    m_failedReferenceCount += line.failedReferenceCount;
+}
+
+void IncrementalAssembler::Update() {
+    if (m_changedLines.empty() && !m_layoutChanged) {
+        return;
+    }
+
+    // Lay out lines from the first edit onward, noting labels that moved (only sizes are summed, so this is cheap)
+    const size_t first = std::min(m_firstChangedLine, m_lines.size());
+    unsigned int address = (first > 0) ? m_lines[first - 1]->address + static_cast<unsigned int>(m_lines[first - 1]->bytes.size()) : 0;
+    bool moved = m_layoutChanged;
+    for (size_t i = first; i < m_lines.size(); i++) {
+        Line& line = *m_lines[i];
+        line.index = i;
+        if (line.address != address) {
+            line.address = address;
+            moved = true;
+            for (const auto& definition : line.parsed.labelDefinitions) {
+                m_movedLabels.insert(m_labels.find(definition.label)->first);
+            }
+        }
+
+        if ((line.changed || moved) && HasImplicitAddress(line.parsed)) {
+            line.bytes[Constants::subleqInstructionBytes - 1] = static_cast<uint8_t>(address + Constants::subleqInstructionBytes);
+        }
+        address += static_cast<unsigned int>(line.bytes.size());
+    }
+    m_byteCount = address;
+
+    // Re-resolve references in changed lines and in lines that use labels that were (re)defined or moved
+    std::vector<Line*> queue;
+    const auto enqueue = [&](Line* line) {
+        if (!line->queued) {
+            line->queued = true;
+            queue.push_back(line);
+        }
+    };
+
+    for (std::string_view name : m_movedLabels) {
+        for (Line* line : m_labels.find(name)->second.uses) {
+            enqueue(line);
+        }
+    }
+
+    for (Line* line : m_changedLines) {
+        enqueue(line);
+    }
+
+    for (Line* line : queue) {
+        ResolveReferences(*line);
+    }
+
+    // Patch the program (lines before the first edit only change if they reference a label that moved)
+    if (moved) {
+        RewriteFrom(first);
+    }
+
+    for (Line* line : queue) {
+        if (!moved || line->index < first) {
+            std::copy(line->bytes.begin(), line->bytes.end(), m_program.bytes.begin() + line->address);
+        }
+    }
+
+    if (!moved) {
+
+        for (Line* line : m_changedLines) {
+            if (line->parsed.command) {
+                m_program.sourceMap[line->address] = SourceMapEntry{ static_cast<unsigned int>(line->index), *line->parsed.command, line->text };
+                line->mappedAddress = line->address;
+            }
+        }
+    }
+    RewriteAnnotationsFrom(first);
+
+    // Reset pending work
+    for (Line* line : queue) {
+        line->queued = false;
+    }
+
+    for (Line* line : m_changedLines) {
+        line->changed = false;
+    }
+
+    for (std::string_view name : m_movedLabels) {
+        const auto it = m_labels.find(name);
+        if (it->second.definitions.empty() && it->second.uses.empty()) {
+            m_labels.erase(it);
+        }
+    }
+
+    m_changedLines.clear();
+    m_movedLabels.clear();
+    m_firstChangedLine = noLine;
+    m_layoutChanged = false;
+
+    UpdateError();
+}
+
+void IncrementalAssembler::RewriteFrom(size_t first) {
+    const unsigned int start = (first < m_lines.size()) ? m_lines[first]->address : m_byteCount;
+
+    m_program.bytes.resize(m_byteCount);
+    for (size_t i = first; i < m_lines.size(); i++) {
+        const Line& line = *m_lines[i];
+        std::copy(line.bytes.begin(), line.bytes.end(), m_program.bytes.begin() + line.address);
+    }
+
+    // Source map entries for unchanged lines are moved to their new addresses (all of these entries are at or after the
+    // first line's address, since earlier lines weren't touched)
+    auto& sourceMap = m_program.sourceMap;
+    m_sourceMapScratch.clear();
+    if (start < sourceMap.size()) {
+        m_sourceMapScratch.assign(std::make_move_iterator(sourceMap.begin() + start), std::make_move_iterator(sourceMap.end()));
+        sourceMap.resize(start);
+    }
+
+    for (size_t i = first; i < m_lines.size(); i++) {
+        Line& line = *m_lines[i];
+        if (!line.parsed.command) {
+            line.mappedAddress.reset();
+            continue;
+        }
+
+        sourceMap.resize(line.address + 1);
+        auto& entry = sourceMap[line.address];
+        const size_t scratchIndex = line.mappedAddress ? *line.mappedAddress - start : noLine;
+        if (!line.changed && scratchIndex < m_sourceMapScratch.size() && m_sourceMapScratch[scratchIndex]) {
+            entry = std::move(m_sourceMapScratch[scratchIndex]);
+            entry->lineNumber = static_cast<unsigned int>(line.index);
+        }
+        else {
+            entry = SourceMapEntry{ static_cast<unsigned int>(line.index), *line.parsed.command, line.text };
+        }
+        line.mappedAddress = line.address;
+    }
+
+    // The source map ends at the last command, which may now be before the first line
+    while (!sourceMap.empty() && !sourceMap.back()) {
+        sourceMap.pop_back();
+    }
+}
+
+void IncrementalAssembler::RewriteAnnotationsFrom(size_t first) {
+    size_t variableCount = 0;
+    size_t breakpointCount = 0;
+    for (size_t i = 0; i < first; i++) {
+        variableCount += m_lines[i]->variableCount;
+        breakpointCount += m_lines[i]->parsed.breakpoint ? 1 : 0;
+    }
+
+    m_program.variables.erase(m_program.variables.begin() + variableCount, m_program.variables.end());
+    m_program.breakpoints.erase(m_program.breakpoints.begin() + breakpointCount, m_program.breakpoints.end());
+    for (size_t i = first; i < m_lines.size(); i++) {
+        const Line& line = *m_lines[i];
+        if (line.parsed.breakpoint) {
+            m_program.breakpoints.push_back(line.address);
+        }
+
+        for (const auto& definition : line.parsed.labelDefinitions) {
+            if (definition.isInline || line.parsed.command == Command::DataDirective) {
+                m_program.variables.push_back({ std::string(1, Syntax::referencePrefix) + std::string(definition.label), line.address + definition.offset });
+            }
+        }
+    }
+}
+
+// Determines which error a full assembly would report: the first line that either fails to parse or redefines a label,
+// then the program's size, then the first reference (in address order) that can't be resolved
+void IncrementalAssembler::UpdateError() {
+    m_error.reset();
+
+    size_t errorLine = noLine;
+    if (m_errorLineCount > 0) {
+        for (const auto& line : m_lines) {
+            if (line->error) {
+                errorLine = line->index;
+                break;
+            }
+        }
+    }
+
+    // Redefinitions are reported at the second definition (or the first, for reserved labels), in source order
+    const auto isBefore = [](const DefinitionSite& a, const DefinitionSite& b) {
+        return (a.line->index != b.line->index) ? (a.line->index < b.line->index) : (a.position < b.position);
+    };
+
+    std::optional<DefinitionSite> conflict;
+    std::string_view conflictLabel;
+    std::vector<DefinitionSite> sites;
+    for (std::string_view name : m_conflicts) {
+        sites = m_labels.find(name)->second.definitions;
+        const size_t reported = Assembler::IsReservedLabel(name) ? 0 : 1;
+        std::partial_sort(sites.begin(), sites.begin() + (reported + 1), sites.end(), isBefore);
+        if (!conflict || isBefore(sites[reported], *conflict)) {
+            conflict = sites[reported];
+            conflictLabel = name;
+        }
+    }
+
+    if (conflict && conflict->line->index < errorLine) {
+        const Line& line = *conflict->line;
+        m_error = Assembler::CreateLabelAlreadyDefinedError(conflictLabel, line.text, static_cast<unsigned int>(line.index + 1));
+    }
+    else if (errorLine != noLine) {
+        // Line numbers may have changed since the line was parsed
+        const CompilationError& error = *m_lines[errorLine]->error;
+        CompilationContext context = error.GetContext();
+        context.sourceLineNumber = static_cast<unsigned int>(errorLine + 1);
+        m_error = CompilationError(error.GetErrorType(), error.what(), std::move(context));
+    }
+    else if (m_byteCount > Constants::addressUserMax + 1) {
+        m_error = Assembler::CreateProgramTooLargeError(m_byteCount);
+    }
+    else if (m_failedReferenceCount > 0) {
+        for (const auto& line : m_lines) {
+            if (line->failedReferenceCount == 0) {
+                continue;
+            }
+
+            for (unsigned int reference : line->references) {
+                const Expression& expression = line->parsed.expressions[reference];
+                const std::optional<unsigned int> labelAddress = GetLabelAddress(expression.label);
+                const unsigned int sourceLineNumber = static_cast<unsigned int>(line->index + 1);
+                if (!labelAddress) {
+                    m_error = Assembler::CreateUndefinedReferenceError(expression.label, line->text, sourceLineNumber);
+                    return;
+                }
+
+                try {
+                    Assembler::ResolveReference(expression, *labelAddress, line->text, sourceLineNumber);
+                }
+                catch (const CompilationError& error) {
+                    m_error = error;
+                    return;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "assembler.h"
+
+namespace Sic1 {
+    // Assembler session for an editor. Each line's parse results are kept along with a label -> use dependency graph,
+    // so an edit only re-parses the changed lines and only re-resolves references whose labels (may have) moved, and
+    // the program's bytes, source map, etc. are patched in place. The result (including which CompilationError is
+    // reported, if any) is always identical to Assembler::Assemble on the current lines.
+    class IncrementalAssembler {
+    public:
+        IncrementalAssembler();
+        explicit IncrementalAssembler(const std::vector<std::string>& lines);
+        ~IncrementalAssembler();
+
+        IncrementalAssembler(const IncrementalAssembler&) = delete;
+        IncrementalAssembler& operator=(const IncrementalAssembler&) = delete;
+
+        size_t GetLineCount() const;
+        const std::string& GetLine(size_t index) const;
+
+        // Replaces "count" lines starting at "index" with the given lines (so this can also insert or remove lines)
+        void ReplaceLines(size_t index, size_t count, const std::vector<std::string>& lines);
+        void SetLine(size_t index, std::string_view line);
+
+        // Returns the assembled program, or throws the CompilationError that Assembler::Assemble would
+        const AssembledProgram& GetProgram();
+
+        // Returns the error that GetProgram would throw (if any), without throwing
+        const std::optional<CompilationError>& GetError();
+
+        // Size of the program as currently laid out (for a live byte count, this is available even when there are errors
+        // other than ProgramTooLargeError, with lines that failed to parse counting as empty)
+        unsigned int GetByteCount();
+
+    private:
+        struct Line;
+
+        typedef struct {
+            Line* line;
+
+            // Index into the line's label definitions
+            unsigned int position;
+        } DefinitionSite;
+
+        typedef struct {
+            std::vector<DefinitionSite> definitions;
+
+            // Lines that reference the label (possibly more than once)
+            std::vector<Line*> uses;
+        } Label;
+
+        // Note: label names are std::string (instead of views into lines) since lines come and go
+        typedef std::map<std::string, Label, std::less<>> LabelMap;
+
+        void ParseLine(Line& line);
+        void AddToGraph(Line& line);
+        void RemoveFromGraph(Line& line);
+        void MarkChanged(Line& line);
+        void UpdateConflict(LabelMap::iterator label);
+        void ResolveReferences(Line& line);
+        std::optional<unsigned int> GetLabelAddress(std::string_view name) const;
+
+        void Update();
+        void RewriteFrom(size_t first);
+        void RewriteAnnotationsFrom(size_t first);
+        void UpdateError();
+
+        std::vector<std::unique_ptr<Line>> m_lines;
+        LabelMap m_labels;
+
+        // Labels that are defined more than once (or are reserved); names are views into m_labels's keys
+        std::set<std::string_view> m_conflicts;
+
+        // Pending work since the last update (names are views into m_labels's keys, which aren't removed until the
+        // update completes)
+        std::vector<Line*> m_changedLines;
+        std::set<std::string_view> m_movedLabels;
+        size_t m_firstChangedLine;
+        bool m_layoutChanged;
+
+        unsigned int m_errorLineCount;
+        unsigned int m_failedReferenceCount;
+        unsigned int m_byteCount;
+
+        AssembledProgram m_program;
+        std::optional<CompilationError> m_error;
+
+        // Reused when moving source map entries
+        std::vector<std::optional<SourceMapEntry>> m_sourceMapScratch;
+    };
+}
@@ -0,0 +1,400 @@
+#include "inputsearch.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include "emulator.h"
+
+using namespace Sic1;
+
+namespace {
+    // Edges are indexed by (previous instruction address, instruction address)
+    constexpr unsigned int edgeCount = Constants::memorySize * Constants::memorySize;
+
+    // Distance of an instruction that never produced a result in memory (e.g. one that only writes to @OUT)
+    constexpr uint8_t distanceUnknown = UINT8_MAX;
+
+    // Fresh inputs are still generated occasionally, so the search is never worse than blind sampling for long
+    constexpr unsigned int freshInputOdds = 8;
+
+    // Mutations applied to a tape are stacked (1, 2, or 4 at a time)
+    constexpr unsigned int mutationStackShiftMax = 2;
+
+    // Nudges move a choice by 2^n for n in this range (NextInt only looks at the top bits, so smaller nudges would
+    // rarely change anything)
+    constexpr unsigned int nudgeShiftMin = 56;
+    constexpr unsigned int nudgeShiftCount = 8;
+
+    // Bisection steps when shrinking one choice (again, only the top bits matter)
+    constexpr unsigned int shrinkStepsMax = 24;
+
+    uint8_t GetHitCountBucket(uint32_t hits) {
+        if (hits <= 3) {
+            return static_cast<uint8_t>(1 << (hits - 1));
+        }
+        else if (hits <= 7) {
+            return 1 << 3;
+        }
+        else if (hits <= 15) {
+            return 1 << 4;
+        }
+        else if (hits <= 31) {
+            return 1 << 5;
+        }
+        else if (hits <= 127) {
+            return 1 << 6;
+        }
+        return 1 << 7;
+    }
+
+    // Coverage of a single execution
+    class Coverage {
+    public:
+        Coverage()
+            : m_hits(edgeCount, 0),
+            m_previousIp(0) {
+            m_distances.fill(distanceUnknown);
+        }
+
+        void Clear() {
+            for (uint32_t edge : m_edges) {
+                m_hits[edge] = 0;
+            }
+
+            m_edges.clear();
+            m_previousIp = 0;
+            m_distances.fill(distanceUnknown);
+        }
+
+        void OnInstruction(unsigned int ip, uint8_t distance) {
+            const uint32_t edge = m_previousIp * Constants::memorySize + ip;
+            if (m_hits[edge]++ == 0) {
+                m_edges.push_back(edge);
+            }
+
+            m_previousIp = ip;
+            m_distances[ip] = (std::min)(m_distances[ip], distance);
+        }
+
+        // Edges executed at least once, in the order they were first executed
+        const std::vector<uint32_t>& GetEdges() const {
+            return m_edges;
+        }
+
+        uint32_t GetHits(uint32_t edge) const {
+            return m_hits[edge];
+        }
+
+        // Smallest change to an instruction's result that would have made it branch the other way
+        const std::array<uint8_t, Constants::memorySize>& GetDistances() const {
+            return m_distances;
+        }
+
+    private:
+        std::vector<uint32_t> m_hits;
+        std::vector<uint32_t> m_edges;
+        unsigned int m_previousIp;
+        std::array<uint8_t, Constants::memorySize> m_distances;
+    };
+
+    // Coverage accumulated across all executions
+    class CoverageMap {
+    public:
+        CoverageMap()
+            : m_buckets(edgeCount, 0),
+            m_edgesCovered(0) {
+            m_distances.fill(distanceUnknown);
+        }
+
+        // Adds an execution's coverage, returning true if any of it was new
+        bool Merge(const Coverage& coverage) {
+            bool novel = false;
+            for (uint32_t edge : coverage.GetEdges()) {
+                const uint8_t bucket = GetHitCountBucket(coverage.GetHits(edge));
+                if ((m_buckets[edge] & bucket) == 0) {
+                    m_edgesCovered += (m_buckets[edge] == 0) ? 1 : 0;
+                    m_buckets[edge] |= bucket;
+                    novel = true;
+                }
+            }
+
+            const auto& distances = coverage.GetDistances();
+            for (unsigned int ip = 0; ip < Constants::memorySize; ip++) {
+                if (distances[ip] < m_distances[ip]) {
+                    m_distances[ip] = distances[ip];
+                    novel = true;
+                }
+            }
+            return novel;
+        }
+
+        size_t GetEdgesCovered() const {
+            return m_edgesCovered;
+        }
+
+    private:
+        // Hit count buckets seen for each edge
+        std::vector<uint8_t> m_buckets;
+        size_t m_edgesCovered;
+        std::array<uint8_t, Constants::memorySize> m_distances;
+    };
+
+    // Emulator that records Coverage as it runs (see ProfilingEmulator)
+    class CoverageEmulator : public Emulator {
+    public:
+        CoverageEmulator(const std::vector<uint8_t>& bytes, Coverage& coverage)
+            : Emulator(bytes),
+            m_coverage(coverage) {
+        }
+
+        template<typename TIo>
+        void Step(TIo& io) {
+            Recorder recorder(m_coverage, GetMemory());
+            Emulator::Step(io, recorder);
+        }
+
+        template<typename TIo>
+        void StepBlock(TIo& io, uint64_t, unsigned int) {
+            Step(io);
+        }
+
+    private:
+        class Recorder {
+        public:
+            Recorder(Coverage& coverage, const uint8_t* memory)
+                : m_coverage(coverage),
+                m_memory(memory) {
+            }
+
+            void OnInstruction(unsigned int ip, unsigned int a, unsigned int, bool) {
+                // Results are only visible once written to memory: positive results must drop to zero to branch,
+                // and the rest must rise to one to fall through
+                uint8_t distance = distanceUnknown;
+                if (a <= Constants::addressUserMax) {
+                    const int result = static_cast<int8_t>(m_memory[a]);
+                    distance = static_cast<uint8_t>((result > 0) ? result : (1 - result));
+                }
+                m_coverage.OnInstruction(ip, distance);
+            }
+
+        private:
+            Coverage& m_coverage;
+            const uint8_t* m_memory;
+        };
+
+        Coverage& m_coverage;
+    };
+
+    // Inputs are compared by the number of values, and then by the sum of their magnitudes
+    std::pair<size_t, uint64_t> GetInputSize(const PuzzleIoGroups& input) {
+        std::pair<size_t, uint64_t> size(0, 0);
+        for (const auto& group : input) {
+            size.first += group.size();
+            for (int value : group) {
+                size.second += static_cast<uint64_t>(std::abs(value));
+            }
+        }
+        return size;
+    }
+
+    class InputSearch {
+    public:
+        InputSearch(const Puzzle& puzzle, const std::vector<uint8_t>& bytes, const InputSearchOptions& options)
+            : m_puzzle(puzzle),
+            m_bytes(bytes),
+            m_options(options),
+            m_random(options.seed),
+            m_executions(0) {
+        }
+
+        InputSearchResult Search() {
+            InputSearchResult result = {};
+            std::vector<std::vector<uint64_t>> corpus;
+            std::vector<uint64_t> tape;
+            while (m_executions < m_options.executionsMax) {
+                tape.clear();
+                if (!corpus.empty() && NextIndex(freshInputOdds) != 0) {
+                    tape = corpus[NextIndex(corpus.size())];
+                    Mutate(tape, corpus);
+                }
+
+                if (Execute(tape, result.input, result.result)) {
+                    result.found = true;
+                    break;
+                }
+                else if (m_map.Merge(m_coverage)) {
+                    corpus.push_back(tape);
+                }
+            }
+
+            result.executions = m_executions;
+            result.corpusSize = corpus.size();
+            result.edgesCovered = m_map.GetEdgesCovered();
+            if (result.found) {
+                Minimize(tape, result);
+                result.minimizationExecutions = m_executions - result.executions;
+                result.testSet = CreateTestSet(m_puzzle, result.input);
+            }
+            return result;
+        }
+
+    private:
+        size_t NextIndex(size_t count) {
+            return static_cast<size_t>(m_random() % count);
+        }
+
+        // Returns true if the program fails on the given input
+        bool Execute(const PuzzleIoGroups& input, VerificationResult& result) {
+            m_executions++;
+            m_coverage.Clear();
+            CoverageEmulator emulator(m_bytes, m_coverage);
+            result = VerifyLoadedProgram(emulator, CreateTestSet(m_puzzle, input), verificationCyclesExecutedMax, solutionBytesMax);
+            return result.status != VerificationStatus::Success;
+        }
+
+        // Same as above, for the input generated from a tape. The tape is trimmed (or extended) to exactly the numbers
+        // the generator used.
+        bool Execute(std::vector<uint64_t>& tape, PuzzleIoGroups& input, VerificationResult& result) {
+            Random random(Random::DeriveSeed(m_options.seed, m_executions), &tape);
+            input = m_puzzle.createRandomTest(random);
+            tape.resize(static_cast<size_t>(random.GetCounter()));
+            return Execute(input, result);
+        }
+
+        void Mutate(std::vector<uint64_t>& tape, const std::vector<std::vector<uint64_t>>& corpus) {
+            if (tape.empty()) {
+                return;
+            }
+
+            const unsigned int count = 1u << NextIndex(mutationStackShiftMax + 1);
+            for (unsigned int i = 0; i < count; i++) {
+                const size_t index = NextIndex(tape.size());
+                switch (NextIndex(6)) {
+                case 0:
+                    // Make a different choice
+                    tape[index] = m_random();
+                    break;
+
+                case 1:
+                    // Make the smallest choice (e.g. the lowest value or the first option)
+                    tape[index] = 0;
+                    break;
+
+                case 2:
+                    // Make the largest choice
+                    tape[index] = UINT64_MAX;
+                    break;
+
+                case 3:
+                {
+                    // Nudge the choice up or down
+                    const uint64_t delta = 1ull << (nudgeShiftMin + NextIndex(nudgeShiftCount));
+                    tape[index] = NextIndex(2) ? (tape[index] + delta) : (tape[index] - delta);
+                }
+                break;
+
+                case 4:
+                    // Repeat another choice (e.g. so that two rows share a value)
+                    tape[index] = tape[NextIndex(tape.size())];
+                    break;
+
+                case 5:
+                {
+                    // Continue with another input's choices
+                    const std::vector<uint64_t>& other = corpus[NextIndex(corpus.size())];
+                    if (index < other.size()) {
+                        tape.resize(index);
+                        tape.insert(tape.end(), other.begin() + static_cast<ptrdiff_t>(index), other.end());
+                    }
+                }
+                break;
+                }
+            }
+        }
+
+        void Minimize(std::vector<uint64_t>& tape, InputSearchResult& result) {
+            const uint64_t executionsMax = m_executions + m_options.minimizationExecutionsMax;
+            PuzzleIoGroups input;
+            VerificationResult verificationResult;
+
+            // Accepts a smaller failing input (or an equally small one from a smaller choice)
+            auto tryTape = [&](std::vector<uint64_t> candidate) {
+                if (m_executions < executionsMax && Execute(candidate, input, verificationResult) && GetInputSize(input) <= GetInputSize(result.input)) {
+                    tape = std::move(candidate);
+                    result.input = std::move(input);
+                    result.result = verificationResult;
+                    return true;
+                }
+                return false;
+            };
+
+            // Make each choice as small as possible, by bisection (between a choice that's known to fail and one
+            // that's known not to)
+            bool progress = true;
+            while (progress && m_executions < executionsMax) {
+                progress = false;
+                for (size_t index = 0; index < tape.size() && m_executions < executionsMax; index++) {
+                    if (tape[index] == 0) {
+                        continue;
+                    }
+
+                    std::vector<uint64_t> candidate = tape;
+                    candidate[index] = 0;
+                    if (tryTape(candidate)) {
+                        progress = true;
+                        continue;
+                    }
+
+                    uint64_t low = 0;
+                    uint64_t high = tape[index];
+                    for (unsigned int step = 0; step < shrinkStepsMax && index < tape.size() && high - low > 1; step++) {
+                        const uint64_t middle = low + (high - low) / 2;
+                        candidate = tape;
+                        candidate[index] = middle;
+                        if (tryTape(candidate)) {
+                            high = middle;
+                            progress = true;
+                        }
+                        else {
+                            low = middle;
+                        }
+                    }
+                }
+            }
+
+            // Rows of puzzles with several rows are independent (see AddRandomTestSets), so remove any that aren't
+            // needed for the failure
+            if (m_puzzle.io.size() > 1) {
+                for (size_t index = result.input.size(); index-- > 0 && result.input.size() > 1 && m_executions < executionsMax;) {
+                    PuzzleIoGroups candidate = result.input;
+                    candidate.erase(candidate.begin() + static_cast<ptrdiff_t>(index));
+                    if (Execute(candidate, verificationResult)) {
+                        result.input = std::move(candidate);
+                        result.result = verificationResult;
+                    }
+                }
+            }
+        }
+
+        const Puzzle& m_puzzle;
+        const std::vector<uint8_t>& m_bytes;
+        const InputSearchOptions& m_options;
+        std::mt19937_64 m_random;
+        uint64_t m_executions;
+        Coverage m_coverage;
+        CoverageMap m_map;
+    };
+}
+
+InputSearchResult Sic1::SearchForFailingInput(const Puzzle& puzzle, const std::vector<uint8_t>& bytes, const InputSearchOptions& options) {
+    if (!puzzle.createRandomTest) {
+        throw std::invalid_argument(std::string("Puzzle \"") + puzzle.title + "\" has no random tests");
+    }
+
+    InputSearch search(puzzle, bytes, options);
+    return search.Search();
+}
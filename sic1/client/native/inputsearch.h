@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "puzzles.h"
+#include "verifier.h"
+
+// Coverage-guided search for inputs that break a solution, as a faster alternative to verifying it against lots of
+// randomly generated test sets (see isSolutionRobustlyValid in tools/cli/shared.ts).
+//
+// Inputs are never edited directly. Instead, the puzzle's random test generator is replayed from a tape of recorded
+// random numbers (see Random), and it's the tape that gets mutated, so every candidate is an input the generator could
+// have produced. Candidates that exercise new behavior are kept for further mutation, where new behavior is either an
+// instruction-to-instruction edge whose hit count reached a new bucket (1, 2, 3, 4-7, 8-15, 16-31, 32-127, 128+) or an
+// instruction whose result came closer than ever to branching the other way.
+namespace Sic1 {
+    typedef struct {
+        uint64_t seed;
+
+        // Budget for finding a failing input (i.e. runs of the program on one test set)
+        uint64_t executionsMax;
+
+        // Budget for shrinking a failing input once one has been found
+        uint64_t minimizationExecutionsMax;
+    } InputSearchOptions;
+
+    typedef struct {
+        bool found;
+
+        // Executions used to find the failing input (or the whole budget, if none was found), and to minimize it
+        uint64_t executions;
+        uint64_t minimizationExecutions;
+
+        // Inputs kept for exhibiting new behavior, and the number of distinct edges executed across all inputs
+        size_t corpusSize;
+        size_t edgesCovered;
+
+        // The minimized failing input, flattened into a test set (with its expected output), and the outcome of
+        // running the program on it
+        PuzzleIoGroups input;
+        TestSet testSet;
+        VerificationResult result;
+    } InputSearchResult;
+
+    // Searches for an input on which the program fails (with the same limits as verification of random test sets) and
+    // shrinks it: first each random choice is made as small as possible, then (for puzzles whose io table has several
+    // independent rows) any rows that aren't needed for the failure are removed. Throws if the puzzle doesn't generate
+    // random tests.
+    InputSearchResult SearchForFailingInput(const Puzzle& puzzle, const std::vector<uint8_t>& bytes, const InputSearchOptions& options);
+}
@@ -0,0 +1,197 @@
+#include "journal.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+using namespace Sic1;
+
+JournalingEmulator::JournalingEmulator(const std::vector<uint8_t>& bytes, std::vector<int8_t> input, uint64_t checkpointInterval, size_t budgetBytes)
+    : Emulator(bytes),
+    m_input(std::move(input)),
+    m_inputIndex(0),
+    m_outputCount(0),
+    m_checkpointInterval(checkpointInterval),
+    m_budgetBytes(budgetBytes),
+    m_instructionsExecuted(0) {
+    if (checkpointInterval == 0) {
+        throw std::invalid_argument("Checkpoint interval must be positive");
+    }
+
+    SaveCheckpoint();
+}
+
+bool JournalingEmulator::JournalIo::TryReadInput(uint8_t& value) {
+    // Note: Reads past the end are still counted, just like in VerificationIo
+    m_entry.flags |= ReadInput;
+    const size_t index = m_emulator.m_inputIndex++;
+    if (index >= m_emulator.m_input.size()) {
+        return false;
+    }
+
+    value = static_cast<uint8_t>(m_emulator.m_input[index]);
+    return true;
+}
+
+void JournalingEmulator::JournalIo::WriteOutput(int8_t value) {
+    m_entry.flags |= WroteOutput;
+    if (m_emulator.m_outputCount == m_emulator.m_output.size()) {
+        m_emulator.m_output.push_back(value);
+    }
+    m_emulator.m_outputCount++;
+}
+
+void JournalingEmulator::Step() {
+    if (!IsRunning()) {
+        return;
+    }
+
+    // Cycles that have already been recorded are just executed again (producing the same state as before)
+    m_instructionsExecuted++;
+    if (m_cyclesExecuted < GetLatestCycle()) {
+        JournalEntry entry = {};
+        JournalIo io(*this, entry);
+        Emulator::Step(io);
+        return;
+    }
+
+    const unsigned int ip = m_ip;
+    const unsigned int a = m_memory[ip];
+    const unsigned int b = m_memory[ip + 1];
+
+    JournalEntry entry = {};
+    entry.ip = static_cast<uint8_t>(ip);
+    if (a <= Constants::addressUserMax) {
+        entry.flags |= Wrote;
+        entry.writtenAddress = static_cast<uint8_t>(a);
+        entry.oldValue = m_memory[a];
+    }
+
+    const std::bitset<Constants::memorySize> accessedBefore = m_memoryAccessed;
+    JournalIo io(*this, entry);
+    Emulator::Step(io);
+
+    // Only the instruction's own bytes and operands can have been accessed for the first time
+    std::bitset<Constants::memorySize> accessed = m_memoryAccessed & ~accessedBefore;
+    for (unsigned int address : { ip, ip + 1, ip + 2, a, b }) {
+        if (accessed[address]) {
+            accessed[address] = false;
+            entry.accessedAddresses[entry.accessedCount++] = static_cast<uint8_t>(address);
+        }
+    }
+
+    m_entries.push_back(entry);
+    if (m_cyclesExecuted % m_checkpointInterval == 0) {
+        SaveCheckpoint();
+        Trim();
+    }
+}
+
+bool JournalingEmulator::StepBack() {
+    if (m_cyclesExecuted == GetEarliestCycle()) {
+        return false;
+    }
+
+    // Note: The entry is kept, so that the step can be executed again
+    const JournalEntry& entry = m_entries[static_cast<size_t>(m_cyclesExecuted - GetEarliestCycle() - 1)];
+    if (entry.flags & Wrote) {
+        SetMemory(entry.writtenAddress, entry.oldValue);
+    }
+
+    for (unsigned int i = 0; i < entry.accessedCount; i++) {
+        m_memoryAccessed[entry.accessedAddresses[i]] = false;
+    }
+
+    m_memoryBytesAccessed -= entry.accessedCount;
+    if (entry.flags & ReadInput) {
+        m_inputIndex--;
+    }
+
+    if (entry.flags & WroteOutput) {
+        m_outputCount--;
+    }
+
+    m_ip = entry.ip;
+    m_cyclesExecuted--;
+    return true;
+}
+
+bool JournalingEmulator::Seek(uint64_t cyclesExecuted) {
+    if (cyclesExecuted < GetEarliestCycle()) {
+        throw std::out_of_range("Cycle " + std::to_string(cyclesExecuted) + " is no longer in the journal");
+    }
+
+    // Start from the closest checkpoint at or before the target, unless the target is nearby (and reached more cheaply
+    // by undoing steps) or the current cycle is closer. This applies in both directions, since checkpoints past the
+    // current cycle are kept after rewinding.
+    const auto checkpoint = std::upper_bound(m_checkpoints.begin(), m_checkpoints.end(), cyclesExecuted, [](uint64_t cycles, const Checkpoint& checkpoint) {
+        return cycles < checkpoint.cyclesExecuted;
+    }) - 1;
+
+    const bool farBehind = cyclesExecuted < m_cyclesExecuted && m_cyclesExecuted - cyclesExecuted > m_checkpointInterval;
+    if (farBehind || checkpoint->cyclesExecuted > m_cyclesExecuted) {
+        RestoreCheckpoint(*checkpoint);
+    }
+
+    while (m_cyclesExecuted > cyclesExecuted) {
+        StepBack();
+    }
+
+    while (m_cyclesExecuted < cyclesExecuted && IsRunning()) {
+        Step();
+    }
+    return m_cyclesExecuted == cyclesExecuted;
+}
+
+void JournalingEmulator::EditMemory(unsigned int address, uint8_t value) {
+    SetMemory(address, value);
+    ClearJournal();
+}
+
+void JournalingEmulator::Reset() {
+    Emulator::Reset();
+    m_inputIndex = 0;
+    m_output.clear();
+    m_outputCount = 0;
+    ClearJournal();
+}
+
+void JournalingEmulator::ClearJournal() {
+    m_output.resize(m_outputCount);
+    m_entries.clear();
+    m_checkpoints.clear();
+    SaveCheckpoint();
+}
+
+void JournalingEmulator::SaveCheckpoint() {
+    Checkpoint& checkpoint = m_checkpoints.emplace_back();
+    checkpoint.cyclesExecuted = m_cyclesExecuted;
+    checkpoint.ip = m_ip;
+    checkpoint.memoryBytesAccessed = m_memoryBytesAccessed;
+    checkpoint.inputIndex = m_inputIndex;
+    checkpoint.outputCount = m_outputCount;
+    checkpoint.memoryAccessed = m_memoryAccessed;
+    std::memcpy(checkpoint.memory, m_memory, sizeof(m_memory));
+}
+
+void JournalingEmulator::RestoreCheckpoint(const Checkpoint& checkpoint) {
+    m_cyclesExecuted = checkpoint.cyclesExecuted;
+    m_ip = checkpoint.ip;
+    m_memoryBytesAccessed = checkpoint.memoryBytesAccessed;
+    m_inputIndex = checkpoint.inputIndex;
+    m_outputCount = checkpoint.outputCount;
+    m_memoryAccessed = checkpoint.memoryAccessed;
+    std::memcpy(m_memory, checkpoint.memory, sizeof(m_memory));
+    m_memoryHash = HashMemory(m_memory);
+    m_memoryDirty.set();
+}
+
+void JournalingEmulator::Trim() {
+    while (GetJournalBytes() > m_budgetBytes && m_checkpoints.size() > 1) {
+        const uint64_t discarded = m_checkpoints[1].cyclesExecuted - m_checkpoints[0].cyclesExecuted;
+        m_entries.erase(m_entries.begin(), m_entries.begin() + static_cast<ptrdiff_t>(discarded));
+        m_checkpoints.pop_front();
+    }
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include "emulator.h"
+
+// Time-travel debugging: instead of resetting and replaying from cycle zero, each step records just enough to undo it,
+// and full checkpoints are saved periodically so that distant cycles can be reached quickly
+namespace Sic1 {
+    constexpr uint64_t journalCheckpointIntervalDefault = 1024;
+    constexpr size_t journalBudgetBytesDefault = 16 * 1024 * 1024;
+
+    // Emulator that records a journal of its execution, so that it can step backwards (in constant time) or seek to any
+    // retained cycle (in logarithmic time, plus at most one checkpoint interval of stepping).
+    //
+    // Input is supplied up front (so that execution can be replayed), and output is collected. Since execution is
+    // deterministic, rewinding keeps the journal (and checkpoints) for later cycles, so seeking forward again is just
+    // as fast; the later cycles are only discarded when the state is edited.
+    //
+    // The journal's memory use is bounded by a budget: once it's exceeded, the oldest checkpoints (and the steps before
+    // them) are discarded, so only cycles from GetEarliestCycle() onward can be reached.
+    class JournalingEmulator : public Emulator {
+    public:
+        JournalingEmulator(const std::vector<uint8_t>& bytes, std::vector<int8_t> input, uint64_t checkpointInterval = journalCheckpointIntervalDefault, size_t budgetBytes = journalBudgetBytesDefault);
+
+        // Output written up to the current cycle
+        std::vector<int8_t> GetOutput() const {
+            return std::vector<int8_t>(m_output.begin(), m_output.begin() + static_cast<ptrdiff_t>(m_outputCount));
+        }
+
+        // Number of inputs read (including reads past the end)
+        size_t GetInputIndex() const {
+            return m_inputIndex;
+        }
+
+        // Earliest cycle that can still be reached
+        uint64_t GetEarliestCycle() const {
+            return m_checkpoints.front().cyclesExecuted;
+        }
+
+        // Latest cycle that has been recorded (cycles after this have never been executed)
+        uint64_t GetLatestCycle() const {
+            return GetEarliestCycle() + m_entries.size();
+        }
+
+        // Number of instructions executed so far, including ones executed again while seeking (for measuring the cost
+        // of seeks)
+        uint64_t GetInstructionsExecuted() const {
+            return m_instructionsExecuted;
+        }
+
+        // Approximate memory used by the journal and checkpoints
+        size_t GetJournalBytes() const {
+            return m_entries.size() * sizeof(JournalEntry) + m_checkpoints.size() * sizeof(Checkpoint);
+        }
+
+        // Executes (and records) the next instruction
+        void Step();
+
+        // Undoes the most recent instruction; returns false if there's nothing to undo (at the earliest cycle)
+        bool StepBack();
+
+        // Moves to the given cycle (stepping backward or forward); returns false if the program halted first. Throws
+        // std::out_of_range if the cycle is before the earliest cycle.
+        bool Seek(uint64_t cyclesExecuted);
+
+        // Edits memory (without counting as an access). Later cycles no longer follow from the current state, and
+        // earlier cycles would be replayed without the edit, so the journal is discarded and restarts at the current
+        // cycle.
+        void EditMemory(unsigned int address, uint8_t value);
+
+        // Resets the emulator's memory back to its initial state and clears the journal
+        void Reset();
+
+    private:
+        // Execution must go through Step (so that it's recorded)
+        using Emulator::StepBlock;
+        using Emulator::Run;
+
+        // Note: An instruction accesses at most five distinct addresses (its three bytes and two operands, one of which
+        // is @IN or @OUT for I/O)
+        static constexpr unsigned int accessedAddressesMax = 5;
+
+        enum JournalFlags : uint8_t {
+            Wrote = 0x1,
+            ReadInput = 0x2,
+            WroteOutput = 0x4,
+        };
+
+        // Everything needed to undo a single step
+        typedef struct {
+            uint8_t ip;
+            uint8_t flags;
+            uint8_t writtenAddress;
+            uint8_t oldValue;
+            uint8_t accessedCount;
+            uint8_t accessedAddresses[accessedAddressesMax];
+        } JournalEntry;
+
+        typedef struct {
+            uint64_t cyclesExecuted;
+            unsigned int ip;
+            unsigned int memoryBytesAccessed;
+            size_t inputIndex;
+            size_t outputCount;
+            std::bitset<Constants::memorySize> memoryAccessed;
+            uint8_t memory[Constants::memorySize];
+        } Checkpoint;
+
+        class JournalIo {
+        public:
+            JournalIo(JournalingEmulator& emulator, JournalEntry& entry)
+                : m_emulator(emulator),
+                m_entry(entry) {
+            }
+
+            bool TryReadInput(uint8_t& value);
+            void WriteOutput(int8_t value);
+
+        private:
+            JournalingEmulator& m_emulator;
+            JournalEntry& m_entry;
+        };
+
+        void SaveCheckpoint();
+        void RestoreCheckpoint(const Checkpoint& checkpoint);
+
+        // Discards the journal and checkpoints, and starts a new journal at the current cycle
+        void ClearJournal();
+
+        // Discards the oldest checkpoints (and steps) until the journal is within its budget (but always keeps at least
+        // one checkpoint)
+        void Trim();
+
+        std::vector<int8_t> m_input;
+        size_t m_inputIndex;
+
+        // Output up to the latest cycle, of which the first m_outputCount were written by the current cycle
+        std::vector<int8_t> m_output;
+        size_t m_outputCount;
+
+        uint64_t m_checkpointInterval;
+        size_t m_budgetBytes;
+        uint64_t m_instructionsExecuted;
+
+        // Steps from the first checkpoint up to the latest cycle (which may be past the current cycle, after rewinding)
+        std::deque<JournalEntry> m_entries;
+
+        // In increasing cycle order, starting at or before the first entry (and possibly past the current cycle)
+        std::deque<Checkpoint> m_checkpoints;
+    };
+}
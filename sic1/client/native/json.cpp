@@ -0,0 +1,653 @@
+#include "json.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+using namespace Sic1;
+
+namespace {
+    // Guard against stack exhaustion (or, for JsonReader, unbounded memory use) on pathological input
+    constexpr unsigned int depthMax = 256;
+
+    bool IsWhitespace(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    bool IsNumberCharacter(char c) {
+        return c != '\0' && std::strchr("0123456789+-.eE", c) != nullptr;
+    }
+
+    int HexDigitToValue(char c) {
+        if (c >= '0' && c <= '9') {
+            return c - '0';
+        }
+        else if (c >= 'a' && c <= 'f') {
+            return c - 'a' + 10;
+        }
+        else if (c >= 'A' && c <= 'F') {
+            return c - 'A' + 10;
+        }
+        return -1;
+    }
+
+    void AppendUtf8(std::string& str, unsigned int codePoint) {
+        if (codePoint < 0x80) {
+            str.push_back(static_cast<char>(codePoint));
+        }
+        else if (codePoint < 0x800) {
+            str.push_back(static_cast<char>(0xc0 | (codePoint >> 6)));
+            str.push_back(static_cast<char>(0x80 | (codePoint & 0x3f)));
+        }
+        else if (codePoint < 0x10000) {
+            str.push_back(static_cast<char>(0xe0 | (codePoint >> 12)));
+            str.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f)));
+            str.push_back(static_cast<char>(0x80 | (codePoint & 0x3f)));
+        }
+        else {
+            str.push_back(static_cast<char>(0xf0 | (codePoint >> 18)));
+            str.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3f)));
+            str.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f)));
+            str.push_back(static_cast<char>(0x80 | (codePoint & 0x3f)));
+        }
+    }
+}
+
+class JsonValue::Parser {
+public:
+    explicit Parser(const std::string& text) : m_text(text), m_index(0) {
+    }
+
+    JsonValue ParseDocument() {
+        JsonValue value = ParseValue(0);
+        SkipWhitespace();
+        if (m_index != m_text.size()) {
+            throw JsonParseError("Unexpected content after JSON value", m_index);
+        }
+        return value;
+    }
+
+private:
+    void SkipWhitespace() {
+        while (m_index < m_text.size()) {
+            if (!IsWhitespace(m_text[m_index])) {
+                break;
+            }
+            m_index++;
+        }
+    }
+
+    char Peek() {
+        SkipWhitespace();
+        if (m_index >= m_text.size()) {
+            throw JsonParseError("Unexpected end of JSON", m_index);
+        }
+        return m_text[m_index];
+    }
+
+    void Expect(char expected) {
+        if (Peek() != expected) {
+            throw JsonParseError(std::string("Expected '") + expected + "'", m_index);
+        }
+        m_index++;
+    }
+
+    void ExpectLiteral(const char* literal) {
+        const size_t length = std::strlen(literal);
+        if (m_text.compare(m_index, length, literal) != 0) {
+            throw JsonParseError("Invalid literal", m_index);
+        }
+        m_index += length;
+    }
+
+    JsonValue ParseValue(unsigned int depth) {
+        if (depth > depthMax) {
+            throw JsonParseError("JSON is nested too deeply", m_index);
+        }
+
+        JsonValue value;
+        switch (Peek()) {
+        case '{':
+            value.m_type = Type::Object;
+            m_index++;
+            if (Peek() == '}') {
+                m_index++;
+                break;
+            }
+
+            while (true) {
+                if (Peek() != '"') {
+                    throw JsonParseError("Expected property name", m_index);
+                }
+                value.m_names.push_back(ParseString());
+                Expect(':');
+                value.m_values.push_back(ParseValue(depth + 1));
+
+                const char c = Peek();
+                m_index++;
+                if (c == '}') {
+                    break;
+                }
+                else if (c != ',') {
+                    throw JsonParseError("Expected ',' or '}'", m_index - 1);
+                }
+            }
+            break;
+
+        case '[':
+            value.m_type = Type::Array;
+            m_index++;
+            if (Peek() == ']') {
+                m_index++;
+                break;
+            }
+
+            while (true) {
+                value.m_values.push_back(ParseValue(depth + 1));
+
+                const char c = Peek();
+                m_index++;
+                if (c == ']') {
+                    break;
+                }
+                else if (c != ',') {
+                    throw JsonParseError("Expected ',' or ']'", m_index - 1);
+                }
+            }
+            break;
+
+        case '"':
+            value.m_type = Type::String;
+            value.m_string = ParseString();
+            break;
+
+        case 't':
+            ExpectLiteral("true");
+            value.m_type = Type::Boolean;
+            value.m_boolean = true;
+            break;
+
+        case 'f':
+            ExpectLiteral("false");
+            value.m_type = Type::Boolean;
+            break;
+
+        case 'n':
+            ExpectLiteral("null");
+            break;
+
+        default:
+            value.m_type = Type::Number;
+            value.m_number = ParseNumber();
+            break;
+        }
+
+        return value;
+    }
+
+    double ParseNumber() {
+        const size_t start = m_index;
+        if (m_index < m_text.size() && m_text[m_index] == '-') {
+            m_index++;
+        }
+
+        const size_t digitsStart = m_index;
+        while (m_index < m_text.size() && IsNumberCharacter(m_text[m_index])) {
+            m_index++;
+        }
+
+        if (m_index == digitsStart) {
+            throw JsonParseError("Unexpected character", start);
+        }
+
+        const std::string number = m_text.substr(start, m_index - start);
+        char* end = nullptr;
+        const double value = std::strtod(number.c_str(), &end);
+        if (end != number.c_str() + number.size()) {
+            throw JsonParseError("Invalid number", start);
+        }
+        return value;
+    }
+
+    unsigned int ParseHexDigits() {
+        if (m_index + 4 > m_text.size()) {
+            throw JsonParseError("Invalid escape sequence", m_index);
+        }
+
+        unsigned int value = 0;
+        for (unsigned int i = 0; i < 4; i++) {
+            const int digit = HexDigitToValue(m_text[m_index++]);
+            if (digit < 0) {
+                throw JsonParseError("Invalid escape sequence", m_index - 1);
+            }
+            value = (value << 4) | static_cast<unsigned int>(digit);
+        }
+        return value;
+    }
+
+    std::string ParseString() {
+        Expect('"');
+        std::string str;
+        while (true) {
+            if (m_index >= m_text.size()) {
+                throw JsonParseError("Unterminated string", m_index);
+            }
+
+            const char c = m_text[m_index++];
+            if (c == '"') {
+                break;
+            }
+            else if (c != '\\') {
+                str.push_back(c);
+                continue;
+            }
+
+            if (m_index >= m_text.size()) {
+                throw JsonParseError("Unterminated string", m_index);
+            }
+
+            const char escaped = m_text[m_index++];
+            switch (escaped) {
+            case '"': str.push_back('"'); break;
+            case '\\': str.push_back('\\'); break;
+            case '/': str.push_back('/'); break;
+            case 'b': str.push_back('\b'); break;
+            case 'f': str.push_back('\f'); break;
+            case 'n': str.push_back('\n'); break;
+            case 'r': str.push_back('\r'); break;
+            case 't': str.push_back('\t'); break;
+
+            case 'u':
+            {
+                unsigned int codePoint = ParseHexDigits();
+                if (codePoint >= 0xd800 && codePoint < 0xdc00 && m_text.compare(m_index, 2, "\\u") == 0) {
+                    m_index += 2;
+                    const unsigned int low = ParseHexDigits();
+                    if (low >= 0xdc00 && low < 0xe000) {
+                        codePoint = 0x10000 + ((codePoint - 0xd800) << 10) + (low - 0xdc00);
+                    }
+                    else {
+                        AppendUtf8(str, codePoint);
+                        codePoint = low;
+                    }
+                }
+                AppendUtf8(str, codePoint);
+                break;
+            }
+
+            default:
+                throw JsonParseError("Invalid escape sequence", m_index - 1);
+            }
+        }
+        return str;
+    }
+
+    const std::string& m_text;
+    size_t m_index;
+};
+
+JsonReader::JsonReader(std::istream& stream, size_t bufferSize)
+    : m_stream(stream), m_buffer((std::max)(bufferSize, static_cast<size_t>(1))), m_position(0), m_end(0), m_bufferOffset(0) {
+}
+
+bool JsonReader::Read(JsonHandler& handler) {
+    // Containers that are currently open (true for objects, false for arrays)
+    std::vector<bool> containers;
+
+    // Reads "name":, raising the property name event
+    auto readPropertyName = [&]() {
+        if (Peek() != '"') {
+            throw JsonParseError("Expected property name", GetOffset());
+        }
+
+        ReadString();
+        const bool result = handler.OnPropertyName(m_token);
+        Expect(':');
+        return result;
+    };
+
+    while (true) {
+        // Parse a value
+        bool result = true;
+        switch (Peek()) {
+        case '{':
+        case '[':
+        {
+            const bool isObject = (Next() == '{');
+            if (containers.size() >= depthMax) {
+                throw JsonParseError("JSON is nested too deeply", GetOffset() - 1);
+            }
+
+            if (!(isObject ? handler.OnStartObject() : handler.OnStartArray())) {
+                return false;
+            }
+
+            if (Peek() == (isObject ? '}' : ']')) {
+                Next();
+                result = isObject ? handler.OnEndObject() : handler.OnEndArray();
+                break;
+            }
+
+            containers.push_back(isObject);
+            if (isObject && !readPropertyName()) {
+                return false;
+            }
+            continue;
+        }
+
+        case '"': ReadString(); result = handler.OnString(m_token); break;
+        case 't': ExpectLiteral("true"); result = handler.OnBoolean(true); break;
+        case 'f': ExpectLiteral("false"); result = handler.OnBoolean(false); break;
+        case 'n': ExpectLiteral("null"); result = handler.OnNull(); break;
+
+        default:
+        {
+            const size_t start = GetOffset();
+            ReadNumber();
+            char* end = nullptr;
+            const double value = std::strtod(m_token.c_str(), &end);
+            if (end != m_token.c_str() + m_token.size()) {
+                throw JsonParseError("Invalid number", start);
+            }
+            result = handler.OnNumber(value);
+            break;
+        }
+        }
+
+        if (!result) {
+            return false;
+        }
+
+        // Close any containers that end after the value, until there's another value to parse
+        while (true) {
+            if (containers.empty()) {
+                while (!IsAtEnd() && IsWhitespace(m_buffer[m_position])) {
+                    m_position++;
+                }
+
+                if (!IsAtEnd()) {
+                    throw JsonParseError("Unexpected content after JSON value", GetOffset());
+                }
+                return true;
+            }
+
+            const bool isObject = containers.back();
+            const char c = Peek();
+            Next();
+            if (c == ',') {
+                if (isObject && !readPropertyName()) {
+                    return false;
+                }
+                break;
+            }
+            else if (c == (isObject ? '}' : ']')) {
+                containers.pop_back();
+                if (!(isObject ? handler.OnEndObject() : handler.OnEndArray())) {
+                    return false;
+                }
+            }
+            else {
+                throw JsonParseError(isObject ? "Expected ',' or '}'" : "Expected ',' or ']'", GetOffset() - 1);
+            }
+        }
+    }
+}
+
+bool JsonReader::IsAtEnd() {
+    if (m_position == m_end) {
+        m_bufferOffset += m_end;
+        m_stream.read(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+        m_position = 0;
+        m_end = static_cast<size_t>(m_stream.gcount());
+        if (m_end == 0 && m_stream.bad()) {
+            throw std::runtime_error("Failed to read JSON stream");
+        }
+    }
+    return m_position == m_end;
+}
+
+char JsonReader::Peek() {
+    while (!IsAtEnd() && IsWhitespace(m_buffer[m_position])) {
+        m_position++;
+    }
+
+    if (IsAtEnd()) {
+        throw JsonParseError("Unexpected end of JSON", GetOffset());
+    }
+    return m_buffer[m_position];
+}
+
+char JsonReader::Next() {
+    if (IsAtEnd()) {
+        throw JsonParseError("Unexpected end of JSON", GetOffset());
+    }
+    return m_buffer[m_position++];
+}
+
+void JsonReader::Expect(char expected) {
+    if (Peek() != expected) {
+        throw JsonParseError(std::string("Expected '") + expected + "'", GetOffset());
+    }
+    m_position++;
+}
+
+void JsonReader::ExpectLiteral(const char* literal) {
+    const size_t start = GetOffset();
+    for (const char* c = literal; *c != '\0'; c++) {
+        if (IsAtEnd() || m_buffer[m_position] != *c) {
+            throw JsonParseError("Invalid literal", start);
+        }
+        m_position++;
+    }
+}
+
+size_t JsonReader::GetOffset() const {
+    return m_bufferOffset + m_position;
+}
+
+void JsonReader::ReadNumber() {
+    const size_t start = GetOffset();
+    m_token.clear();
+    if (!IsAtEnd() && m_buffer[m_position] == '-') {
+        m_token.push_back(m_buffer[m_position++]);
+    }
+
+    const size_t digitsStart = m_token.size();
+    while (!IsAtEnd() && IsNumberCharacter(m_buffer[m_position])) {
+        if (m_token.size() >= tokenLengthMax) {
+            throw JsonParseError("Number is too long", start);
+        }
+        m_token.push_back(m_buffer[m_position++]);
+    }
+
+    if (m_token.size() == digitsStart) {
+        throw JsonParseError("Unexpected character", start);
+    }
+}
+
+unsigned int JsonReader::ReadHexDigits() {
+    unsigned int value = 0;
+    for (unsigned int i = 0; i < 4; i++) {
+        if (IsAtEnd()) {
+            throw JsonParseError("Invalid escape sequence", GetOffset());
+        }
+
+        const int digit = HexDigitToValue(m_buffer[m_position++]);
+        if (digit < 0) {
+            throw JsonParseError("Invalid escape sequence", GetOffset() - 1);
+        }
+        value = (value << 4) | static_cast<unsigned int>(digit);
+    }
+    return value;
+}
+
+void JsonReader::ReadString() {
+    const size_t start = GetOffset();
+    Expect('"');
+    m_token.clear();
+
+    // High surrogate from the previous escape sequence, which is combined with a low surrogate if one immediately follows
+    unsigned int highSurrogate = 0;
+    auto flushHighSurrogate = [&]() {
+        if (highSurrogate != 0) {
+            AppendUtf8(m_token, highSurrogate);
+            highSurrogate = 0;
+        }
+    };
+
+    while (true) {
+        if (IsAtEnd()) {
+            throw JsonParseError("Unterminated string", GetOffset());
+        }
+
+        // Copy runs of unescaped characters directly from the buffer
+        const char* run = m_buffer.data() + m_position;
+        const char* runEnd = m_buffer.data() + m_end;
+        const char* special = run;
+        while (special != runEnd && *special != '"' && *special != '\\') {
+            special++;
+        }
+
+        if (special != run) {
+            if (m_token.size() + static_cast<size_t>(special - run) > tokenLengthMax) {
+                throw JsonParseError("String is too long", start);
+            }
+
+            flushHighSurrogate();
+            m_token.append(run, special);
+            m_position += static_cast<size_t>(special - run);
+            continue;
+        }
+
+        if (Next() == '"') {
+            flushHighSurrogate();
+            break;
+        }
+
+        const char escaped = Next();
+        if (escaped != 'u') {
+            flushHighSurrogate();
+        }
+
+        switch (escaped) {
+        case '"': m_token.push_back('"'); break;
+        case '\\': m_token.push_back('\\'); break;
+        case '/': m_token.push_back('/'); break;
+        case 'b': m_token.push_back('\b'); break;
+        case 'f': m_token.push_back('\f'); break;
+        case 'n': m_token.push_back('\n'); break;
+        case 'r': m_token.push_back('\r'); break;
+        case 't': m_token.push_back('\t'); break;
+
+        case 'u':
+        {
+            // Note: This matches JsonValue::Parse, which only pairs a high surrogate with the escape that follows it
+            unsigned int codePoint = ReadHexDigits();
+            if (highSurrogate != 0) {
+                if (codePoint >= 0xdc00 && codePoint < 0xe000) {
+                    codePoint = 0x10000 + ((highSurrogate - 0xd800) << 10) + (codePoint - 0xdc00);
+                    highSurrogate = 0;
+                }
+                flushHighSurrogate();
+                AppendUtf8(m_token, codePoint);
+            }
+            else if (codePoint >= 0xd800 && codePoint < 0xdc00) {
+                highSurrogate = codePoint;
+            }
+            else {
+                AppendUtf8(m_token, codePoint);
+            }
+            break;
+        }
+
+        default:
+            throw JsonParseError("Invalid escape sequence", GetOffset() - 1);
+        }
+    }
+}
+
+JsonValue JsonValue::Parse(const std::string& text) {
+    return Parser(text).ParseDocument();
+}
+
+void JsonValue::CheckType(Type type) const {
+    if (m_type != type) {
+        throw std::runtime_error("Unexpected JSON value type");
+    }
+}
+
+bool JsonValue::GetBoolean() const {
+    CheckType(Type::Boolean);
+    return m_boolean;
+}
+
+double JsonValue::GetNumber() const {
+    CheckType(Type::Number);
+    return m_number;
+}
+
+const std::string& JsonValue::GetString() const {
+    CheckType(Type::String);
+    return m_string;
+}
+
+const std::vector<JsonValue>& JsonValue::GetArray() const {
+    CheckType(Type::Array);
+    return m_values;
+}
+
+size_t JsonValue::GetPropertyCount() const {
+    CheckType(Type::Object);
+    return m_names.size();
+}
+
+const std::string& JsonValue::GetPropertyName(size_t index) const {
+    CheckType(Type::Object);
+    return m_names.at(index);
+}
+
+const JsonValue& JsonValue::GetPropertyValue(size_t index) const {
+    CheckType(Type::Object);
+    return m_values.at(index);
+}
+
+const JsonValue* JsonValue::FindProperty(const std::string& name) const {
+    CheckType(Type::Object);
+
+    // Note: As with JSON.parse, the last duplicate wins
+    for (size_t i = m_names.size(); i > 0; i--) {
+        if (m_names[i - 1] == name) {
+            return &m_values[i - 1];
+        }
+    }
+    return nullptr;
+}
+
+std::string Sic1::FormatJsonString(const std::string& value) {
+    static const char digits[] = "0123456789abcdef";
+    std::string text = "\"";
+    for (char c : value) {
+        switch (c) {
+        case '"': text += "\\\""; break;
+        case '\\': text += "\\\\"; break;
+        case '\b': text += "\\b"; break;
+        case '\f': text += "\\f"; break;
+        case '\n': text += "\\n"; break;
+        case '\r': text += "\\r"; break;
+        case '\t': text += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                text += "\\u00";
+                text.push_back(digits[(c >> 4) & 0xf]);
+                text.push_back(digits[c & 0xf]);
+            }
+            else {
+                text.push_back(c);
+            }
+            break;
+        }
+    }
+
+    text.push_back('"');
+    return text;
+}
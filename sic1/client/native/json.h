@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace Sic1 {
+    class JsonParseError : public std::runtime_error {
+    public:
+        JsonParseError(const std::string& message, size_t offset)
+            : std::runtime_error(message + " (at offset " + std::to_string(offset) + ")"), m_offset(offset) {
+        }
+
+        size_t GetOffset() const {
+            return m_offset;
+        }
+
+    private:
+        size_t m_offset;
+    };
+
+    // Minimal JSON document model (objects keep their properties in document order)
+    class JsonValue {
+    public:
+        enum class Type : uint8_t {
+            Null,
+            Boolean,
+            Number,
+            String,
+            Array,
+            Object,
+        };
+
+        JsonValue() : m_type(Type::Null), m_boolean(false), m_number(0) {
+        }
+
+        // Throws JsonParseError on malformed input
+        static JsonValue Parse(const std::string& text);
+
+        Type GetType() const {
+            return m_type;
+        }
+
+        bool IsNull() const {
+            return m_type == Type::Null;
+        }
+
+        // Accessors throw std::runtime_error if the value is of a different type
+        bool GetBoolean() const;
+        double GetNumber() const;
+        const std::string& GetString() const;
+        const std::vector<JsonValue>& GetArray() const;
+
+        // Objects
+        size_t GetPropertyCount() const;
+        const std::string& GetPropertyName(size_t index) const;
+        const JsonValue& GetPropertyValue(size_t index) const;
+
+        // Returns null if the object has no such property
+        const JsonValue* FindProperty(const std::string& name) const;
+
+    private:
+        class Parser;
+
+        void CheckType(Type type) const;
+
+        Type m_type;
+        bool m_boolean;
+        double m_number;
+        std::string m_string;
+
+        // Array elements or object property values (with names in m_names)
+        std::vector<JsonValue> m_values;
+        std::vector<std::string> m_names;
+    };
+
+    // Receives events from JsonReader, in document order; returning false from any event stops reading
+    class JsonHandler {
+    public:
+        virtual ~JsonHandler() = default;
+
+        virtual bool OnStartObject() { return true; }
+        virtual bool OnPropertyName(const std::string& /*name*/) { return true; }
+        virtual bool OnEndObject() { return true; }
+        virtual bool OnStartArray() { return true; }
+        virtual bool OnEndArray() { return true; }
+        virtual bool OnString(const std::string& /*value*/) { return true; }
+        virtual bool OnNumber(double /*value*/) { return true; }
+        virtual bool OnBoolean(bool /*value*/) { return true; }
+        virtual bool OnNull() { return true; }
+    };
+
+    // Streaming (SAX-style) JSON reader that reads a stream through a fixed-size buffer and reports values to a handler
+    // as they're parsed, without building a document. Memory use is independent of the document's size (only the
+    // current string or number, and the nesting of containers, is kept).
+    //
+    // Accepts exactly the same documents as JsonValue::Parse.
+    class JsonReader {
+    public:
+        // Strings (and numbers) longer than this are rejected, to keep memory use bounded on malformed input
+        static constexpr size_t tokenLengthMax = 16 * 1024 * 1024;
+
+        explicit JsonReader(std::istream& stream, size_t bufferSize = 64 * 1024);
+
+        // Reads a single document; returns false if the handler stopped reading. Throws JsonParseError on malformed
+        // input (and rethrows anything thrown by the handler).
+        bool Read(JsonHandler& handler);
+
+    private:
+        bool IsAtEnd();
+        char Peek();
+        char Next();
+        void Expect(char expected);
+        void ExpectLiteral(const char* literal);
+        size_t GetOffset() const;
+
+        void ReadNumber();
+        unsigned int ReadHexDigits();
+        void ReadString();
+
+        std::istream& m_stream;
+        std::vector<char> m_buffer;
+        size_t m_position;
+        size_t m_end;
+
+        // Stream offset of the start of the buffer, for error messages
+        size_t m_bufferOffset;
+
+        // Current string or number
+        std::string m_token;
+    };
+
+    // Formats a string as a JSON string literal (escaped just like JSON.stringify)
+    std::string FormatJsonString(const std::string& value);
+}
@@ -0,0 +1,76 @@
+#include "latencyhistogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace Sic1;
+
+namespace {
+    unsigned int GetHighestBit(uint64_t value) {
+        unsigned int bit = 0;
+        while (value >>= 1) {
+            bit++;
+        }
+        return bit;
+    }
+}
+
+unsigned int LatencyHistogram::GetBucket(uint64_t microseconds) {
+    constexpr uint64_t exactMax = 2ull << subBucketBits;
+    if (microseconds < exactMax) {
+        return static_cast<unsigned int>(microseconds);
+    }
+
+    // Buckets for each power of two are split by the bits following the highest one
+    const unsigned int highestBit = GetHighestBit(microseconds);
+    const unsigned int subBucket = static_cast<unsigned int>(microseconds >> (highestBit - subBucketBits)) & ((1u << subBucketBits) - 1);
+    return static_cast<unsigned int>(exactMax) + ((highestBit - subBucketBits - 1) << subBucketBits) + subBucket;
+}
+
+uint64_t LatencyHistogram::GetBucketUpperBound(unsigned int bucket) {
+    constexpr unsigned int exactMax = 2u << subBucketBits;
+    if (bucket < exactMax) {
+        return bucket;
+    }
+
+    const unsigned int highestBit = ((bucket - exactMax) >> subBucketBits) + subBucketBits + 1;
+    const uint64_t subBucket = bucket & ((1u << subBucketBits) - 1);
+    const unsigned int shift = highestBit - subBucketBits;
+    const uint64_t lowerBound = ((1ull << subBucketBits) + subBucket) << shift;
+    return lowerBound + ((1ull << shift) - 1);
+}
+
+void LatencyHistogram::Record(std::chrono::microseconds latency) {
+    const uint64_t microseconds = static_cast<uint64_t>((std::max)(latency.count(), static_cast<std::chrono::microseconds::rep>(0)));
+    m_buckets[GetBucket(microseconds)]++;
+    m_count++;
+    m_totalMicroseconds += microseconds;
+    m_maxMicroseconds = (std::max)(m_maxMicroseconds, microseconds);
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& other) {
+    for (unsigned int bucket = 0; bucket < bucketCount; bucket++) {
+        m_buckets[bucket] += other.m_buckets[bucket];
+    }
+
+    m_count += other.m_count;
+    m_totalMicroseconds += other.m_totalMicroseconds;
+    m_maxMicroseconds = (std::max)(m_maxMicroseconds, other.m_maxMicroseconds);
+}
+
+std::chrono::microseconds LatencyHistogram::GetPercentile(double percentile) const {
+    if (m_count == 0) {
+        return std::chrono::microseconds(0);
+    }
+
+    const double clamped = (std::min)((std::max)(percentile, 0.0), 100.0);
+    const uint64_t rank = (std::max)(static_cast<uint64_t>(std::ceil(clamped / 100 * m_count)), static_cast<uint64_t>(1));
+    uint64_t seen = 0;
+    for (unsigned int bucket = 0; bucket < bucketCount; bucket++) {
+        seen += m_buckets[bucket];
+        if (seen >= rank) {
+            return std::chrono::microseconds(static_cast<int64_t>((std::min)(GetBucketUpperBound(bucket), m_maxMicroseconds)));
+        }
+    }
+    return GetMax();
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+namespace Sic1 {
+    // Histogram of latencies (in microseconds) with logarithmic buckets: exact below 8 us, and then four buckets per
+    // power of two, so percentiles are reported to within 25% no matter the scale
+    class LatencyHistogram {
+    public:
+        LatencyHistogram()
+            : m_buckets{}, m_count(0), m_totalMicroseconds(0), m_maxMicroseconds(0) {
+        }
+
+        void Record(std::chrono::microseconds latency);
+
+        // Adds another histogram's latencies to this one
+        void Merge(const LatencyHistogram& other);
+
+        uint64_t GetCount() const {
+            return m_count;
+        }
+
+        std::chrono::microseconds GetMean() const {
+            return std::chrono::microseconds((m_count > 0) ? static_cast<int64_t>(m_totalMicroseconds / m_count) : 0);
+        }
+
+        std::chrono::microseconds GetMax() const {
+            return std::chrono::microseconds(static_cast<int64_t>(m_maxMicroseconds));
+        }
+
+        // Upper bound of the bucket holding the given percentile (0 to 100), e.g. 50 for the median; zero if empty
+        std::chrono::microseconds GetPercentile(double percentile) const;
+
+    private:
+        static constexpr unsigned int subBucketBits = 2;
+        static constexpr unsigned int bucketCount = 256;
+
+        static unsigned int GetBucket(uint64_t microseconds);
+        static uint64_t GetBucketUpperBound(unsigned int bucket);
+
+        std::array<uint64_t, bucketCount> m_buckets;
+        uint64_t m_count;
+        uint64_t m_totalMicroseconds;
+        uint64_t m_maxMicroseconds;
+    };
+}
@@ -0,0 +1,140 @@
+#include "leaderboardcache.h"
+
+#include <stdexcept>
+#include <utility>
+#include "json.h"
+
+using namespace Sic1;
+
+namespace {
+    // Bumped whenever the format changes (older caches are discarded)
+    constexpr int cacheVersion = 1;
+
+    // Note: Handles are 64-bit, so they're formatted as strings (JSON numbers are doubles)
+    SteamLeaderboardHandle ParseHandle(const std::string& text) {
+        size_t length = 0;
+        const unsigned long long handle = std::stoull(text, &length);
+        if (length != text.size()) {
+            throw std::runtime_error("Invalid leaderboard handle: " + text);
+        }
+        return static_cast<SteamLeaderboardHandle>(handle);
+    }
+}
+
+LeaderboardCache::LeaderboardCache(std::chrono::seconds rowsTimeToLive)
+    : m_rowsTimeToLive(rowsTimeToLive) {
+}
+
+std::optional<SteamLeaderboardHandle> LeaderboardCache::GetHandle(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto entry = m_entries.find(name);
+    return (entry != m_entries.end()) ? entry->second.handle : std::nullopt;
+}
+
+void LeaderboardCache::SetHandle(const std::string& name, SteamLeaderboardHandle handle) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries[name].handle = handle;
+}
+
+std::optional<LeaderboardCache::CachedRows> LeaderboardCache::GetRows(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto entry = m_entries.find(name);
+    return (entry != m_entries.end()) ? entry->second.rows : std::nullopt;
+}
+
+void LeaderboardCache::SetRows(const std::string& name, std::vector<FriendLeaderboardRow> rows, Clock::time_point time) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries[name].rows = CachedRows{ std::move(rows), time };
+}
+
+void LeaderboardCache::InvalidateRows(const std::string& name) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto entry = m_entries.find(name);
+    if (entry != m_entries.end()) {
+        entry->second.rows.reset();
+    }
+}
+
+bool LeaderboardCache::IsStale(const CachedRows& rows, Clock::time_point now) const {
+    // Note: Rows from the future (e.g. after the clock was changed) are treated as stale, too
+    return (rows.time > now) || (now - rows.time >= m_rowsTimeToLive);
+}
+
+std::string LeaderboardCache::Format() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::string text = "{\"version\":" + std::to_string(cacheVersion) + ",\"leaderboards\":{";
+    bool first = true;
+    for (const auto& [name, entry] : m_entries) {
+        if (!entry.handle && !entry.rows) {
+            continue;
+        }
+
+        text += first ? "" : ",";
+        text += FormatJsonString(name) + ":{";
+        first = false;
+
+        bool firstProperty = true;
+        if (entry.handle) {
+            text += "\"handle\":" + FormatJsonString(std::to_string(*entry.handle));
+            firstProperty = false;
+        }
+
+        if (entry.rows) {
+            const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(entry.rows->time.time_since_epoch()).count();
+            text += firstProperty ? "" : ",";
+            text += "\"time\":" + std::to_string(seconds) + ",\"rows\":[";
+            for (size_t i = 0; i < entry.rows->rows.size(); i++) {
+                const FriendLeaderboardRow& row = entry.rows->rows[i];
+                text += (i > 0) ? "," : "";
+                text += "[" + FormatJsonString(row.name) + "," + std::to_string(row.score) + "]";
+            }
+            text += "]";
+        }
+
+        text += "}";
+    }
+    text += "}}";
+    return text;
+}
+
+void LeaderboardCache::Parse(const std::string& text) {
+    const JsonValue root = JsonValue::Parse(text);
+    const JsonValue* version = root.FindProperty("version");
+    if (!version || version->GetNumber() != cacheVersion) {
+        throw std::runtime_error("Unsupported leaderboard cache version");
+    }
+
+    std::map<std::string, Entry> entries;
+    const JsonValue* leaderboards = root.FindProperty("leaderboards");
+    if (leaderboards) {
+        for (size_t i = 0; i < leaderboards->GetPropertyCount(); i++) {
+            const JsonValue& value = leaderboards->GetPropertyValue(i);
+            Entry& entry = entries[leaderboards->GetPropertyName(i)];
+
+            const JsonValue* handle = value.FindProperty("handle");
+            if (handle) {
+                entry.handle = ParseHandle(handle->GetString());
+            }
+
+            const JsonValue* time = value.FindProperty("time");
+            const JsonValue* rows = value.FindProperty("rows");
+            if (time && rows) {
+                CachedRows cachedRows;
+                cachedRows.time = Clock::time_point(std::chrono::duration_cast<Clock::duration>(std::chrono::seconds(static_cast<int64_t>(time->GetNumber()))));
+                for (const JsonValue& row : rows->GetArray()) {
+                    const std::vector<JsonValue>& fields = row.GetArray();
+                    if (fields.size() != 2) {
+                        throw std::runtime_error("Invalid friend leaderboard row");
+                    }
+
+                    cachedRows.rows.push_back({ fields[0].GetString(), static_cast<int>(fields[1].GetNumber()) });
+                }
+
+                entry.rows = std::move(cachedRows);
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries = std::move(entries);
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+#include "steamapi.h"
+
+namespace Sic1 {
+    // Leaderboard handles and friend leaderboard rows, by leaderboard name, so that leaderboards can be shown without
+    // waiting on Steam (including across sessions, by persisting the cache). Rows older than the time to live are
+    // stale: they can still be shown, but should be refreshed.
+    class LeaderboardCache {
+    public:
+        // Note: Times are persisted, so this is the system clock
+        typedef std::chrono::system_clock Clock;
+
+        static constexpr std::chrono::seconds rowsTimeToLiveDefault = std::chrono::minutes(5);
+
+        typedef struct {
+            std::vector<FriendLeaderboardRow> rows;
+            Clock::time_point time;
+        } CachedRows;
+
+        explicit LeaderboardCache(std::chrono::seconds rowsTimeToLive = rowsTimeToLiveDefault);
+
+        std::optional<SteamLeaderboardHandle> GetHandle(const std::string& name) const;
+        void SetHandle(const std::string& name, SteamLeaderboardHandle handle);
+
+        std::optional<CachedRows> GetRows(const std::string& name) const;
+        void SetRows(const std::string& name, std::vector<FriendLeaderboardRow> rows, Clock::time_point time);
+        void InvalidateRows(const std::string& name);
+        bool IsStale(const CachedRows& rows, Clock::time_point now) const;
+
+        // Formats the cache as JSON (for persisting)
+        std::string Format() const;
+
+        // Replaces the cache's contents with a formatted cache. Throws JsonParseError (or std::runtime_error) on malformed
+        // input, in which case the cache is left unchanged.
+        void Parse(const std::string& text);
+
+    private:
+        typedef struct {
+            std::optional<SteamLeaderboardHandle> handle;
+            std::optional<CachedRows> rows;
+        } Entry;
+
+        const std::chrono::seconds m_rowsTimeToLive;
+
+        mutable std::mutex m_mutex;
+        std::map<std::string, Entry> m_entries;
+    };
+}
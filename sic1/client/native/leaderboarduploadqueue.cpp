@@ -0,0 +1,329 @@
+#include "leaderboarduploadqueue.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include "json.h"
+
+using namespace Sic1;
+
+namespace {
+    // Bumped whenever the format changes (older queues are discarded)
+    constexpr int queueVersion = 1;
+}
+
+LeaderboardUploadQueue::LeaderboardUploadQueue(SteamLeaderboards& leaderboards, std::function<void()> onChanged, const LeaderboardUploadSchedule& schedule)
+    : m_leaderboards(leaderboards),
+    m_onChanged(std::move(onChanged)),
+    m_schedule(schedule),
+    m_stopping(false),
+    m_uploadCount(0),
+    m_thread([this]() { RunThread(); }) {
+}
+
+LeaderboardUploadQueue::~LeaderboardUploadQueue() {
+    Stop();
+}
+
+bool LeaderboardUploadQueue::IsUploadNeeded(const std::string& name, int score) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto entry = m_entries.find(name);
+    return entry == m_entries.end() || !entry->second.best || IsBetterScore(GetLeaderboardSortOrder(name), score, *entry->second.best);
+}
+
+void LeaderboardUploadQueue::Upload(const std::string& name, int score, std::vector<int> details, Completion completion) {
+    std::vector<PendingUpload> uploads;
+    std::vector<Completion> dropped;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const LeaderboardSortOrder order = GetLeaderboardSortOrder(name);
+        Entry& entry = m_entries[name];
+        if (entry.best && !IsBetterScore(order, score, *entry.best)) {
+            dropped.push_back(std::move(completion));
+        }
+        else {
+            // Worse scores just wait on the queued score (which will be uploaded instead)
+            if (!entry.queued || IsBetterScore(order, score, entry.queued->score)) {
+                entry.queued = Score{ score, std::move(details) };
+            }
+
+            entry.completions.push_back(std::move(completion));
+            TryTakeQueuedScore(name, entry, Clock::now(), uploads, dropped);
+        }
+    }
+
+    if (m_onChanged && (!uploads.empty() || dropped.empty())) {
+        m_onChanged();
+    }
+
+    for (const Completion& droppedCompletion : dropped) {
+        droppedCompletion(SteamCallStatus::Succeeded, false);
+    }
+
+    for (PendingUpload& upload : uploads) {
+        Send(std::move(upload));
+    }
+}
+
+void LeaderboardUploadQueue::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+
+    m_wake.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+size_t LeaderboardUploadQueue::GetQueuedCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return std::count_if(m_entries.begin(), m_entries.end(), [](const auto& entry) { return entry.second.queued || entry.second.uploading; });
+}
+
+uint64_t LeaderboardUploadQueue::GetUploadCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_uploadCount;
+}
+
+std::string LeaderboardUploadQueue::Format() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::string text = "{\"version\":" + std::to_string(queueVersion) + ",\"leaderboards\":{";
+    bool first = true;
+    for (const auto& [name, entry] : m_entries) {
+        // Outstanding uploads are persisted too, since they might never complete
+        const Score* score = nullptr;
+        if (entry.queued) {
+            score = &*entry.queued;
+        }
+
+        if (entry.uploading && (!score || IsBetterScore(GetLeaderboardSortOrder(name), entry.uploading->score, score->score))) {
+            score = &*entry.uploading;
+        }
+
+        if (!entry.best && !score) {
+            continue;
+        }
+
+        text += first ? "" : ",";
+        text += FormatJsonString(name) + ":{";
+        first = false;
+
+        bool firstProperty = true;
+        if (entry.best) {
+            text += "\"best\":" + std::to_string(*entry.best);
+            firstProperty = false;
+        }
+
+        if (score) {
+            text += firstProperty ? "" : ",";
+            text += "\"score\":" + std::to_string(score->score) + ",\"details\":[";
+            for (size_t i = 0; i < score->details.size(); i++) {
+                text += (i > 0) ? "," : "";
+                text += std::to_string(score->details[i]);
+            }
+            text += "]";
+        }
+
+        text += "}";
+    }
+    text += "}}";
+    return text;
+}
+
+void LeaderboardUploadQueue::Parse(const std::string& text) {
+    const JsonValue root = JsonValue::Parse(text);
+    const JsonValue* version = root.FindProperty("version");
+    if (!version || version->GetNumber() != queueVersion) {
+        throw std::runtime_error("Unsupported leaderboard upload queue version");
+    }
+
+    std::map<std::string, Entry> entries;
+    const JsonValue* leaderboards = root.FindProperty("leaderboards");
+    if (leaderboards) {
+        for (size_t i = 0; i < leaderboards->GetPropertyCount(); i++) {
+            const JsonValue& value = leaderboards->GetPropertyValue(i);
+            Entry& entry = entries[leaderboards->GetPropertyName(i)];
+
+            const JsonValue* best = value.FindProperty("best");
+            if (best) {
+                entry.best = static_cast<int>(best->GetNumber());
+            }
+
+            const JsonValue* score = value.FindProperty("score");
+            const JsonValue* details = value.FindProperty("details");
+            if (score && details) {
+                Score queued = { static_cast<int>(score->GetNumber()), {} };
+                for (const JsonValue& detail : details->GetArray()) {
+                    queued.details.push_back(static_cast<int>(detail.GetNumber()));
+                }
+
+                entry.queued = std::move(queued);
+            }
+        }
+    }
+
+    std::vector<PendingUpload> uploads;
+    std::vector<Completion> dropped;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const Clock::time_point now = Clock::now();
+        for (auto& [name, loaded] : entries) {
+            const LeaderboardSortOrder order = GetLeaderboardSortOrder(name);
+            Entry& entry = m_entries[name];
+            if (loaded.best && (!entry.best || IsBetterScore(order, *loaded.best, *entry.best))) {
+                entry.best = loaded.best;
+            }
+
+            if (loaded.queued && (!entry.queued || IsBetterScore(order, loaded.queued->score, entry.queued->score))) {
+                entry.queued = std::move(loaded.queued);
+            }
+
+            TryTakeQueuedScore(name, entry, now, uploads, dropped);
+        }
+    }
+
+    for (const Completion& completion : dropped) {
+        completion(SteamCallStatus::Succeeded, false);
+    }
+
+    for (PendingUpload& upload : uploads) {
+        Send(std::move(upload));
+    }
+}
+
+bool LeaderboardUploadQueue::TryTakeQueuedScore(const std::string& name, Entry& entry, Clock::time_point now, std::vector<PendingUpload>& uploads, std::vector<Completion>& dropped) {
+    if (!entry.queued || entry.uploading || m_stopping) {
+        return false;
+    }
+
+    if (entry.best && !IsBetterScore(GetLeaderboardSortOrder(name), entry.queued->score, *entry.best)) {
+        dropped.insert(dropped.end(), std::make_move_iterator(entry.completions.begin()), std::make_move_iterator(entry.completions.end()));
+        entry.completions.clear();
+        entry.queued.reset();
+        return false;
+    }
+
+    if (entry.retryTime > now) {
+        return false;
+    }
+
+    entry.uploading = std::move(entry.queued);
+    entry.queued.reset();
+    uploads.push_back({ name, *entry.uploading, std::move(entry.completions) });
+    entry.completions.clear();
+    m_uploadCount++;
+    return true;
+}
+
+void LeaderboardUploadQueue::Send(PendingUpload upload) {
+    const std::string name = upload.name;
+    const Score score = upload.score;
+    m_leaderboards.UploadLeaderboardScore(name, score.score, score.details, [this, upload = std::move(upload)](SteamCallStatus status, bool scoreChanged) {
+        OnUploaded(upload, status, scoreChanged);
+    });
+}
+
+void LeaderboardUploadQueue::OnUploaded(const PendingUpload& upload, SteamCallStatus status, bool scoreChanged) {
+    std::vector<PendingUpload> uploads;
+    std::vector<Completion> dropped;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const Clock::time_point now = Clock::now();
+        const LeaderboardSortOrder order = GetLeaderboardSortOrder(upload.name);
+        Entry& entry = m_entries[upload.name];
+        entry.uploading.reset();
+
+        switch (status) {
+        case SteamCallStatus::Succeeded:
+            // Steam keeps the best score, so this is a bound on the best score even if the score didn't change
+            if (!entry.best || IsBetterScore(order, upload.score.score, *entry.best)) {
+                entry.best = upload.score.score;
+            }
+            entry.failureCount = 0;
+            entry.retryTime = Clock::time_point();
+            break;
+
+        case SteamCallStatus::IoFailed:
+        case SteamCallStatus::Aborted:
+        {
+            // Keep the score queued (unless a better one has been queued since), and retry with backoff
+            if (!entry.queued || IsBetterScore(order, upload.score.score, entry.queued->score)) {
+                entry.queued = upload.score;
+            }
+
+            entry.failureCount++;
+            std::chrono::milliseconds delay = m_schedule.retryInitial;
+            for (unsigned int i = 1; i < entry.failureCount && delay < m_schedule.retryMax; i++) {
+                delay *= 2;
+            }
+
+            entry.retryTime = now + (std::min)(delay, m_schedule.retryMax);
+        }
+        break;
+
+        default:
+            // Steam rejected the upload, so retrying won't help
+            break;
+        }
+
+        TryTakeQueuedScore(upload.name, entry, now, uploads, dropped);
+    }
+
+    m_wake.notify_all();
+    if (m_onChanged) {
+        m_onChanged();
+    }
+
+    for (const Completion& completion : upload.completions) {
+        completion(status, scoreChanged);
+    }
+
+    for (const Completion& completion : dropped) {
+        completion(SteamCallStatus::Succeeded, false);
+    }
+
+    for (PendingUpload& next : uploads) {
+        Send(std::move(next));
+    }
+}
+
+void LeaderboardUploadQueue::RunThread() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stopping) {
+        // Start any retries that are due, and find out when the next one is due
+        const Clock::time_point now = Clock::now();
+        std::vector<PendingUpload> uploads;
+        std::vector<Completion> dropped;
+        std::optional<Clock::time_point> nextRetryTime;
+        for (auto& [name, entry] : m_entries) {
+            if (!TryTakeQueuedScore(name, entry, now, uploads, dropped) && entry.queued && !entry.uploading) {
+                nextRetryTime = nextRetryTime ? (std::min)(*nextRetryTime, entry.retryTime) : entry.retryTime;
+            }
+        }
+
+        if (!uploads.empty() || !dropped.empty()) {
+            lock.unlock();
+            if (!dropped.empty() && m_onChanged) {
+                m_onChanged();
+            }
+
+            for (const Completion& completion : dropped) {
+                completion(SteamCallStatus::Succeeded, false);
+            }
+
+            for (PendingUpload& upload : uploads) {
+                Send(std::move(upload));
+            }
+
+            lock.lock();
+        }
+        else if (nextRetryTime) {
+            m_wake.wait_until(lock, *nextRetryTime);
+        }
+        else {
+            m_wake.wait(lock);
+        }
+    }
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "steamapi.h"
+#include "steamleaderboards.h"
+
+namespace Sic1 {
+    // How long LeaderboardUploadQueue waits before retrying an upload that failed because Steam couldn't be reached
+    // (doubling after each consecutive failure, up to a maximum)
+    typedef struct {
+        std::chrono::milliseconds retryInitial;
+        std::chrono::milliseconds retryMax;
+    } LeaderboardUploadSchedule;
+
+    constexpr LeaderboardUploadSchedule leaderboardUploadScheduleDefault = { std::chrono::seconds(5), std::chrono::minutes(10) };
+
+    // Uploads scores to leaderboards (where Steam keeps the best score, according to the leaderboard's sort order, see
+    // GetLeaderboardSortOrder), without making redundant calls:
+    //
+    // * Scores that can't beat the best score already uploaded (by this queue) are dropped
+    // * At most one upload per leaderboard is outstanding; scores queued in the meantime are coalesced into a single
+    //   upload of the best of them
+    // * Uploads that fail because Steam couldn't be reached stay queued, and are retried with backoff
+    //
+    // The queue (i.e. scores that haven't been uploaded yet, and the best scores uploaded so far) can be persisted, so
+    // that scores from an offline session are uploaded on the next launch.
+    class LeaderboardUploadQueue {
+    public:
+        typedef std::chrono::steady_clock Clock;
+        typedef SteamLeaderboards::UploadCompletion Completion;
+
+        // Note: onChanged is called whenever the queue changes, e.g. to persist it
+        LeaderboardUploadQueue(SteamLeaderboards& leaderboards, std::function<void()> onChanged = nullptr, const LeaderboardUploadSchedule& schedule = leaderboardUploadScheduleDefault);
+
+        // Note: Stops uploading (see Stop). Outstanding uploads must have completed (or been aborted, e.g. by destroying
+        // the callback pump) before the queue is destroyed.
+        ~LeaderboardUploadQueue();
+
+        LeaderboardUploadQueue(const LeaderboardUploadQueue&) = delete;
+        LeaderboardUploadQueue& operator=(const LeaderboardUploadQueue&) = delete;
+
+        // True if the score could beat the best score uploaded so far (i.e. Upload wouldn't just drop it)
+        bool IsUploadNeeded(const std::string& name, int score) const;
+
+        // Queues a score for upload. The completion is run once the score (or a better one that it was coalesced with)
+        // has been uploaded, or right away (on the calling thread, with scoreChanged false) if the score was dropped.
+        //
+        // Note: If Steam can't be reached, the completion receives IoFailed, but the score stays queued (and is retried).
+        void Upload(const std::string& name, int score, std::vector<int> details, Completion completion);
+
+        // Stops starting uploads (e.g. before shutting down the callback pump), leaving queued scores in the queue
+        void Stop();
+
+        // Number of leaderboards with a score waiting to be uploaded (including outstanding uploads)
+        size_t GetQueuedCount() const;
+
+        // Number of uploads started
+        uint64_t GetUploadCount() const;
+
+        // Formats the queue as JSON (for persisting)
+        std::string Format() const;
+
+        // Adds a formatted queue's scores to the queue (and uploads them). Throws JsonParseError (or
+        // std::runtime_error) on malformed input, in which case nothing is added.
+        void Parse(const std::string& text);
+
+    private:
+        typedef struct {
+            int score;
+            std::vector<int> details;
+        } Score;
+
+        typedef struct {
+            // Bound on the best score stored by Steam (from previous uploads), i.e. Steam's best is at least this good
+            std::optional<int> best;
+
+            // Best score waiting to be uploaded, and completions waiting on it
+            std::optional<Score> queued;
+            std::vector<Completion> completions;
+
+            // Score currently being uploaded (if any)
+            std::optional<Score> uploading;
+
+            // Consecutive uploads that failed because Steam couldn't be reached
+            unsigned int failureCount;
+            Clock::time_point retryTime;
+        } Entry;
+
+        typedef struct {
+            std::string name;
+            Score score;
+            std::vector<Completion> completions;
+        } PendingUpload;
+
+        // Takes the entry's queued score if it can be uploaded now (adding it to uploads), or drops it if it can no longer
+        // beat the best score (adding its completions to dropped). Returns true if an upload was taken.
+        bool TryTakeQueuedScore(const std::string& name, Entry& entry, Clock::time_point now, std::vector<PendingUpload>& uploads, std::vector<Completion>& dropped);
+
+        void Send(PendingUpload upload);
+        void OnUploaded(const PendingUpload& upload, SteamCallStatus status, bool scoreChanged);
+        void RunThread();
+
+        SteamLeaderboards& m_leaderboards;
+        std::function<void()> m_onChanged;
+        const LeaderboardUploadSchedule m_schedule;
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_wake;
+        bool m_stopping;
+        std::map<std::string, Entry> m_entries;
+        uint64_t m_uploadCount;
+
+        // Retries failed uploads
+        std::thread m_thread;
+    };
+}
@@ -0,0 +1,600 @@
+#include "lockstep.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SIC1_LOCKSTEP_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SIC1_LOCKSTEP_SSE2
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using namespace Sic1;
+
+namespace {
+    static_assert(LockstepVerifier::laneCount == 32, "Lane vectors and masks hold exactly 32 lanes");
+
+    inline unsigned int FirstLane(uint32_t lanes) {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward(&index, lanes);
+        return static_cast<unsigned int>(index);
+#else
+        return static_cast<unsigned int>(__builtin_ctz(lanes));
+#endif
+    }
+
+    // Vector of one byte per lane
+#if defined(SIC1_LOCKSTEP_AVX2)
+    typedef __m256i LaneVector;
+
+    inline LaneVector LoadLanes(const uint8_t* lanes) {
+        return _mm256_load_si256(reinterpret_cast<const __m256i*>(lanes));
+    }
+
+    inline void StoreLanes(uint8_t* lanes, LaneVector v) {
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), v);
+    }
+
+    inline LaneVector BroadcastLanes(uint8_t value) {
+        return _mm256_set1_epi8(static_cast<char>(value));
+    }
+
+    inline LaneVector SubtractLanes(LaneVector a, LaneVector b) {
+        return _mm256_sub_epi8(a, b);
+    }
+
+    // Takes lanes from b where mask is set, otherwise from a
+    inline LaneVector SelectLanes(LaneVector a, LaneVector b, LaneVector mask) {
+        return _mm256_blendv_epi8(a, b, mask);
+    }
+
+    inline uint32_t EqualLanes(LaneVector a, LaneVector b) {
+        return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)));
+    }
+
+    inline uint32_t PositiveLanes(LaneVector v) {
+        return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpgt_epi8(v, _mm256_setzero_si256())));
+    }
+
+    // Converts a lane mask into a vector mask (0xff for each selected lane)
+    inline LaneVector ExpandLanes(uint32_t lanes) {
+        const __m256i maskBytes = _mm256_shuffle_epi8(_mm256_set1_epi32(static_cast<int>(lanes)), _mm256_setr_epi8(
+            0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1,
+            2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3));
+        const __m256i bits = _mm256_set1_epi64x(static_cast<long long>(0x8040201008040201ull));
+        return _mm256_cmpeq_epi8(_mm256_and_si256(maskBytes, bits), bits);
+    }
+
+    const char* const instructionSetName = "AVX2";
+#elif defined(SIC1_LOCKSTEP_SSE2)
+    typedef struct {
+        __m128i low;
+        __m128i high;
+    } LaneVector;
+
+    inline LaneVector LoadLanes(const uint8_t* lanes) {
+        return { _mm_load_si128(reinterpret_cast<const __m128i*>(lanes)), _mm_load_si128(reinterpret_cast<const __m128i*>(lanes + 16)) };
+    }
+
+    inline void StoreLanes(uint8_t* lanes, LaneVector v) {
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), v.low);
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes + 16), v.high);
+    }
+
+    inline LaneVector BroadcastLanes(uint8_t value) {
+        const __m128i v = _mm_set1_epi8(static_cast<char>(value));
+        return { v, v };
+    }
+
+    inline LaneVector SubtractLanes(LaneVector a, LaneVector b) {
+        return { _mm_sub_epi8(a.low, b.low), _mm_sub_epi8(a.high, b.high) };
+    }
+
+    // Takes lanes from b where mask is set, otherwise from a
+    inline LaneVector SelectLanes(LaneVector a, LaneVector b, LaneVector mask) {
+        return {
+            _mm_or_si128(_mm_and_si128(mask.low, b.low), _mm_andnot_si128(mask.low, a.low)),
+            _mm_or_si128(_mm_and_si128(mask.high, b.high), _mm_andnot_si128(mask.high, a.high)),
+        };
+    }
+
+    inline uint32_t EqualLanes(LaneVector a, LaneVector b) {
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(a.low, b.low)))
+            | (static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(a.high, b.high))) << 16);
+    }
+
+    inline uint32_t PositiveLanes(LaneVector v) {
+        const __m128i zero = _mm_setzero_si128();
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(v.low, zero)))
+            | (static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(v.high, zero))) << 16);
+    }
+
+    inline __m128i ExpandLanes16(uint32_t lanes) {
+        // Spread the low byte of the mask across bytes 0-7 and the high byte across bytes 8-15
+        __m128i maskBytes = _mm_cvtsi32_si128(static_cast<int>(lanes & 0xffff));
+        maskBytes = _mm_unpacklo_epi8(maskBytes, maskBytes);
+        maskBytes = _mm_unpacklo_epi16(maskBytes, maskBytes);
+        maskBytes = _mm_unpacklo_epi32(maskBytes, maskBytes);
+        const __m128i bits = _mm_set1_epi64x(static_cast<long long>(0x8040201008040201ull));
+        return _mm_cmpeq_epi8(_mm_and_si128(maskBytes, bits), bits);
+    }
+
+    // Converts a lane mask into a vector mask (0xff for each selected lane)
+    inline LaneVector ExpandLanes(uint32_t lanes) {
+        return { ExpandLanes16(lanes), ExpandLanes16(lanes >> 16) };
+    }
+
+    const char* const instructionSetName = "SSE2";
+#else
+    typedef struct {
+        uint8_t lane[LockstepVerifier::laneCount];
+    } LaneVector;
+
+    inline LaneVector LoadLanes(const uint8_t* lanes) {
+        LaneVector v;
+        std::memcpy(v.lane, lanes, sizeof(v.lane));
+        return v;
+    }
+
+    inline void StoreLanes(uint8_t* lanes, LaneVector v) {
+        std::memcpy(lanes, v.lane, sizeof(v.lane));
+    }
+
+    inline LaneVector BroadcastLanes(uint8_t value) {
+        LaneVector v;
+        std::memset(v.lane, value, sizeof(v.lane));
+        return v;
+    }
+
+    inline LaneVector SubtractLanes(LaneVector a, LaneVector b) {
+        LaneVector v;
+        for (unsigned int i = 0; i < LockstepVerifier::laneCount; i++) {
+            v.lane[i] = static_cast<uint8_t>(a.lane[i] - b.lane[i]);
+        }
+        return v;
+    }
+
+    // Takes lanes from b where mask is set, otherwise from a
+    inline LaneVector SelectLanes(LaneVector a, LaneVector b, LaneVector mask) {
+        LaneVector v;
+        for (unsigned int i = 0; i < LockstepVerifier::laneCount; i++) {
+            v.lane[i] = static_cast<uint8_t>((b.lane[i] & mask.lane[i]) | (a.lane[i] & ~mask.lane[i]));
+        }
+        return v;
+    }
+
+    inline uint32_t EqualLanes(LaneVector a, LaneVector b) {
+        uint32_t lanes = 0;
+        for (unsigned int i = 0; i < LockstepVerifier::laneCount; i++) {
+            lanes |= static_cast<uint32_t>(a.lane[i] == b.lane[i]) << i;
+        }
+        return lanes;
+    }
+
+    inline uint32_t PositiveLanes(LaneVector v) {
+        uint32_t lanes = 0;
+        for (unsigned int i = 0; i < LockstepVerifier::laneCount; i++) {
+            lanes |= static_cast<uint32_t>(UnsignedToSigned(v.lane[i]) > 0) << i;
+        }
+        return lanes;
+    }
+
+    // Converts a lane mask into a vector mask (0xff for each selected lane)
+    inline LaneVector ExpandLanes(uint32_t lanes) {
+        LaneVector v;
+        for (unsigned int i = 0; i < LockstepVerifier::laneCount; i++) {
+            v.lane[i] = ((lanes >> i) & 1) ? 0xff : 0;
+        }
+        return v;
+    }
+
+    const char* const instructionSetName = "scalar";
+#endif
+}
+
+LockstepVerifier::LockstepVerifier(const uint8_t* bytes, size_t count, bool detectLoops)
+    : m_active(0),
+    m_groupCount(0),
+    m_check(0),
+    m_stepsUntilCycleCheck(0),
+    m_results(nullptr),
+    m_detectLoops(detectLoops),
+    m_stepsUntilLoopSnapshotCheck(0),
+    m_writtenCount(0) {
+    // Note: Memory is initialized just like in Emulator
+    const size_t loadedCount = (std::min)(count, static_cast<size_t>(Constants::memorySize));
+    std::memset(m_initialMemory, 0, sizeof(m_initialMemory));
+    if (loadedCount > 0) {
+        std::memcpy(m_initialMemory, bytes, loadedCount);
+    }
+}
+
+LockstepVerifier::LockstepVerifier(const std::vector<uint8_t>& bytes, bool detectLoops)
+    : LockstepVerifier(bytes.data(), bytes.size(), detectLoops) {
+}
+
+const char* LockstepVerifier::GetInstructionSetName() {
+    return instructionSetName;
+}
+
+std::vector<VerificationResult> LockstepVerifier::Verify(const std::vector<LockstepJob>& jobs) {
+    std::vector<VerificationResult> results(jobs.size());
+    for (size_t first = 0; first < jobs.size(); first += laneCount) {
+        Verify(jobs.data() + first, (std::min)(jobs.size() - first, static_cast<size_t>(laneCount)), results.data() + first);
+    }
+    return results;
+}
+
+void LockstepVerifier::Verify(const LockstepJob* jobs, size_t jobCount, VerificationResult* results) {
+    m_results = results;
+    Load(jobs, jobCount);
+
+    while (m_active != 0) {
+        // Run the group with the lowest address
+        LaneGroup* group = &m_groups[0];
+        for (unsigned int i = 1; i < m_groupCount; i++) {
+            if (m_groups[i].ip < group->ip) {
+                group = &m_groups[i];
+            }
+        }
+
+        // Only lanes with the same instruction (as the first lane) can run together; the rest wait for the next step
+        const unsigned int ip = group->ip;
+        const unsigned int first = FirstLane(group->lanes);
+        LaneMask lanes = group->lanes;
+        for (unsigned int address = ip; address < ip + Constants::subleqInstructionBytes; address++) {
+            lanes &= EqualLanes(LoadLanes(m_memory[address]), BroadcastLanes(m_memory[address][first]));
+        }
+
+        Execute(*group, lanes);
+
+        // Remove empty groups
+        unsigned int groupCount = 0;
+        for (unsigned int i = 0; i < m_groupCount; i++) {
+            if (m_groups[i].lanes != 0) {
+                m_groups[groupCount++] = m_groups[i];
+            }
+        }
+        m_groupCount = groupCount;
+    }
+
+    m_results = nullptr;
+}
+
+void LockstepVerifier::Load(const LockstepJob* jobs, size_t jobCount) {
+    for (unsigned int address = 0; address < Constants::memorySize; address++) {
+        std::memset(m_memory[address], m_initialMemory[address], laneCount);
+        m_memoryAccessed[address] = 0;
+        m_loopLanes[address] = 0;
+        m_written[address] = false;
+    }
+
+    m_writtenCount = 0;
+    m_stepsUntilLoopSnapshotCheck = loopSnapshotCheckPeriod;
+
+    for (unsigned int lane = 0; lane < laneCount; lane++) {
+        m_cyclesExecuted[lane] = 0;
+        m_memoryBytesAccessed[lane] = 0;
+
+        LaneState& state = m_lanes[lane];
+        state = {};
+        if (lane < jobCount) {
+            state.testSet = jobs[lane].testSet;
+            state.cyclesExecutedMax = jobs[lane].cyclesExecutedMax;
+            state.memoryBytesAccessedMax = jobs[lane].memoryBytesAccessedMax;
+            state.correct = true;
+            state.loopPeriod = loopPeriodInitial;
+        }
+    }
+
+    m_active = (jobCount >= laneCount) ? ~static_cast<LaneMask>(0) : ((static_cast<LaneMask>(1) << jobCount) - 1);
+    m_groupCount = 0;
+    if (m_active != 0) {
+        m_groups[m_groupCount++] = { 0, m_active };
+    }
+
+    // Test sets without any output succeed without running at all
+    m_check = 0;
+    CheckLanes(m_active, 0);
+    UpdateCycleCheck();
+}
+
+void LockstepVerifier::Execute(LaneGroup& group, LaneMask lanes) {
+    const unsigned int ip = group.ip;
+    if (m_loopLanes[ip] & lanes) {
+        const LaneMask looping = FindLoopingLanes(lanes & m_loopLanes[ip]);
+        for (LaneMask remaining = looping; remaining != 0; remaining &= remaining - 1) {
+            FinishLane(FirstLane(remaining), VerificationStatus::NonTerminating);
+        }
+
+        lanes &= ~looping;
+        if (lanes == 0) {
+            return;
+        }
+    }
+
+    const unsigned int first = FirstLane(lanes);
+    const unsigned int a = m_memory[ip][first];
+    const unsigned int b = m_memory[ip + 1][first];
+    const unsigned int c = m_memory[ip + 2][first];
+    const unsigned int next = ip + Constants::subleqInstructionBytes;
+
+    // Note: This covers @IN, when it's read, and @OUT, when it's written
+    m_check = 0;
+    AccessMemory(ip, lanes);
+    AccessMemory(ip + 1, lanes);
+    AccessMemory(ip + 2, lanes);
+    AccessMemory(a, lanes);
+    AccessMemory(b, lanes);
+
+    // Read operands (each lane reads its own input)
+    LaneVector av;
+    LaneVector bv;
+    LaneMask inputExhausted = 0;
+    if (a == Constants::addressInput || b == Constants::addressInput) {
+        alignas(32) uint8_t input[laneCount] = {};
+        for (LaneMask remaining = lanes; remaining != 0; remaining &= remaining - 1) {
+            const unsigned int lane = FirstLane(remaining);
+            LaneState& state = m_lanes[lane];
+            const size_t index = state.inputIndex++;
+            if (index < state.testSet->input.size()) {
+                input[lane] = static_cast<uint8_t>(state.testSet->input[index]);
+            }
+            else {
+                inputExhausted |= static_cast<LaneMask>(1) << lane;
+            }
+        }
+
+        const LaneVector inputVector = LoadLanes(input);
+        av = (a == Constants::addressInput) ? inputVector : LoadLanes(m_memory[a]);
+        bv = (b == Constants::addressInput) ? inputVector : LoadLanes(m_memory[b]);
+    }
+    else {
+        av = LoadLanes(m_memory[a]);
+        bv = LoadLanes(m_memory[b]);
+    }
+
+    LaneVector result = SubtractLanes(av, bv);
+    if (inputExhausted != 0) {
+        result = SelectLanes(result, BroadcastLanes(0), ExpandLanes(inputExhausted));
+    }
+
+    // Write result
+    if (a < Constants::addressInput) {
+        if (!m_written[a]) {
+            m_written[a] = true;
+            m_writtenAddresses[m_writtenCount++] = static_cast<uint8_t>(a);
+        }
+
+        if (lanes == m_active) {
+            // Note: Lanes that have finished can be overwritten
+            StoreLanes(m_memory[a], result);
+        }
+        else {
+            StoreLanes(m_memory[a], SelectLanes(LoadLanes(m_memory[a]), result, ExpandLanes(lanes)));
+        }
+    }
+    else if (a == Constants::addressOutput) {
+        alignas(32) uint8_t output[laneCount];
+        StoreLanes(output, result);
+        for (LaneMask remaining = lanes; remaining != 0; remaining &= remaining - 1) {
+            const unsigned int lane = FirstLane(remaining);
+            LaneState& state = m_lanes[lane];
+            const size_t index = state.outputIndex++;
+            const int8_t actual = UnsignedToSigned(output[lane]);
+            const int8_t expected = state.testSet->output[index];
+            if (actual != expected && state.correct) {
+                state.correct = false;
+                state.errorOutputIndex = index;
+                state.errorExpected = expected;
+                state.errorActual = actual;
+            }
+        }
+        m_check |= lanes;
+    }
+
+    // Branch
+    const LaneMask taken = lanes & ~PositiveLanes(result);
+    const LaneMask notTaken = lanes & ~taken;
+
+    if (lanes == m_active) {
+        for (unsigned int lane = 0; lane < laneCount; lane++) {
+            m_cyclesExecuted[lane]++;
+        }
+    }
+    else {
+        for (LaneMask remaining = lanes; remaining != 0; remaining &= remaining - 1) {
+            m_cyclesExecuted[FirstLane(remaining)]++;
+        }
+    }
+
+    group.lanes &= ~lanes;
+    LaneMask halted = 0;
+    if (c > Constants::addressInstructionMax) {
+        halted |= taken;
+    }
+    else {
+        AddLanes(c, taken);
+    }
+
+    if (next > Constants::addressInstructionMax) {
+        halted |= notTaken;
+    }
+    else {
+        AddLanes(next, notTaken);
+    }
+
+    if (--m_stepsUntilCycleCheck == 0) {
+        for (LaneMask remaining = m_active; remaining != 0; remaining &= remaining - 1) {
+            const unsigned int lane = FirstLane(remaining);
+            if (m_cyclesExecuted[lane] > m_lanes[lane].cyclesExecutedMax) {
+                m_check |= static_cast<LaneMask>(1) << lane;
+            }
+        }
+    }
+
+    CheckLanes(m_check | halted, halted);
+    if (m_stepsUntilCycleCheck == 0) {
+        UpdateCycleCheck();
+    }
+
+    if (m_detectLoops && --m_stepsUntilLoopSnapshotCheck == 0) {
+        SaveLoopSnapshots();
+        m_stepsUntilLoopSnapshotCheck = loopSnapshotCheckPeriod;
+    }
+}
+
+void LockstepVerifier::AccessMemory(unsigned int address, LaneMask lanes) {
+    const LaneMask newlyAccessed = lanes & ~m_memoryAccessed[address];
+    if (newlyAccessed != 0) {
+        m_memoryAccessed[address] |= newlyAccessed;
+        for (LaneMask remaining = newlyAccessed; remaining != 0; remaining &= remaining - 1) {
+            const unsigned int lane = FirstLane(remaining);
+            if (++m_memoryBytesAccessed[lane] > m_lanes[lane].memoryBytesAccessedMax) {
+                m_check |= static_cast<LaneMask>(1) << lane;
+            }
+        }
+    }
+}
+
+void LockstepVerifier::AddLanes(unsigned int ip, LaneMask lanes) {
+    if (lanes == 0) {
+        return;
+    }
+
+    // Merge with lanes that are already at this address
+    for (unsigned int i = 0; i < m_groupCount; i++) {
+        if (m_groups[i].ip == ip) {
+            m_groups[i].lanes |= lanes;
+            return;
+        }
+    }
+
+    // Reuse an empty group, if possible
+    for (unsigned int i = 0; i < m_groupCount; i++) {
+        if (m_groups[i].lanes == 0) {
+            m_groups[i] = { ip, lanes };
+            return;
+        }
+    }
+
+    m_groups[m_groupCount++] = { ip, lanes };
+}
+
+void LockstepVerifier::CheckLanes(LaneMask lanes, LaneMask halted) {
+    // Note: Failures are prioritized just like in VerifyProgram
+    for (LaneMask remaining = lanes & m_active; remaining != 0; remaining &= remaining - 1) {
+        const unsigned int lane = FirstLane(remaining);
+        const LaneState& state = m_lanes[lane];
+        if ((halted >> lane) & 1) {
+            FinishLane(lane, VerificationStatus::HaltedUnexpectedly);
+        }
+        else if (m_cyclesExecuted[lane] > state.cyclesExecutedMax || m_memoryBytesAccessed[lane] > state.memoryBytesAccessedMax) {
+            FinishLane(lane, VerificationStatus::ResourceLimitExceeded);
+        }
+        else if (!state.correct) {
+            FinishLane(lane, VerificationStatus::IncorrectOutput);
+        }
+        else if (state.outputIndex >= state.testSet->output.size()) {
+            FinishLane(lane, VerificationStatus::Success);
+        }
+    }
+}
+
+void LockstepVerifier::UpdateCycleCheck() {
+    m_stepsUntilCycleCheck = UINT64_MAX;
+    for (LaneMask remaining = m_active; remaining != 0; remaining &= remaining - 1) {
+        const unsigned int lane = FirstLane(remaining);
+        const uint64_t cyclesRemaining = m_lanes[lane].cyclesExecutedMax - m_cyclesExecuted[lane];
+        if (cyclesRemaining < UINT64_MAX) {
+            m_stepsUntilCycleCheck = (std::min)(m_stepsUntilCycleCheck, cyclesRemaining + 1);
+        }
+    }
+}
+
+void LockstepVerifier::FinishLane(unsigned int lane, VerificationStatus status) {
+    const LaneState& state = m_lanes[lane];
+    VerificationResult& result = m_results[lane];
+    result.status = status;
+    result.cyclesExecuted = m_cyclesExecuted[lane];
+    result.memoryBytesAccessed = m_memoryBytesAccessed[lane];
+    result.inputIndex = state.inputIndex;
+    result.errorOutputIndex = state.errorOutputIndex;
+    result.errorExpected = state.errorExpected;
+    result.errorActual = state.errorActual;
+
+    const LaneMask mask = static_cast<LaneMask>(1) << lane;
+    m_active &= ~mask;
+    if (state.loopSaved) {
+        m_loopLanes[state.loopIp] &= ~mask;
+    }
+
+    for (unsigned int i = 0; i < m_groupCount; i++) {
+        m_groups[i].lanes &= ~mask;
+    }
+}
+
+LockstepVerifier::LaneMask LockstepVerifier::FindLoopingLanes(LaneMask lanes) const {
+    LaneMask looping = 0;
+    for (LaneMask remaining = lanes; remaining != 0; remaining &= remaining - 1) {
+        const unsigned int lane = FirstLane(remaining);
+        const LaneState& state = m_lanes[lane];
+
+        // Note: The snapshot is taken before executing the instruction at its address, so the lane must have run since
+        if (state.loopCyclesExecuted == m_cyclesExecuted[lane]
+            || state.loopOutputIndex != state.outputIndex
+            || state.loopInputPosition != (std::min)(state.inputIndex, state.testSet->input.size())) {
+            continue;
+        }
+
+        // Only addresses that have been written can differ from the snapshot
+        bool same = true;
+        for (unsigned int i = 0; i < m_writtenCount && same; i++) {
+            const unsigned int address = m_writtenAddresses[i];
+            same = (m_memory[address][lane] == m_loopMemory[lane][address]);
+        }
+
+        if (same) {
+            looping |= static_cast<LaneMask>(1) << lane;
+        }
+    }
+
+    return looping;
+}
+
+void LockstepVerifier::SaveLoopSnapshots() {
+    for (unsigned int i = 0; i < m_groupCount; i++) {
+        const unsigned int ip = m_groups[i].ip;
+        for (LaneMask remaining = m_groups[i].lanes; remaining != 0; remaining &= remaining - 1) {
+            const unsigned int lane = FirstLane(remaining);
+            LaneState& state = m_lanes[lane];
+            if (m_cyclesExecuted[lane] - state.loopCyclesExecuted < state.loopPeriod) {
+                continue;
+            }
+
+            // Move the snapshot to the lane's current address and double the interval (as in Brent's algorithm)
+            const LaneMask mask = static_cast<LaneMask>(1) << lane;
+            if (state.loopSaved) {
+                m_loopLanes[state.loopIp] &= ~mask;
+            }
+
+            m_loopLanes[ip] |= mask;
+            state.loopSaved = true;
+            state.loopIp = ip;
+            state.loopCyclesExecuted = m_cyclesExecuted[lane];
+            state.loopPeriod *= 2;
+            state.loopInputPosition = (std::min)(state.inputIndex, state.testSet->input.size());
+            state.loopOutputIndex = state.outputIndex;
+            for (unsigned int address = 0; address < Constants::memorySize; address++) {
+                m_loopMemory[lane][address] = m_memory[address][lane];
+            }
+        }
+    }
+}
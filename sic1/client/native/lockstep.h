@@ -0,0 +1,127 @@
+#pragma once
+
+#include "verifier.h"
+
+namespace Sic1 {
+    typedef struct {
+        const TestSet* testSet;
+        uint64_t cyclesExecutedMax;
+        unsigned int memoryBytesAccessedMax;
+    } LockstepJob;
+
+    // Verifies one program against many test sets at once, with each test set running in its own SIMD lane (using
+    // AVX2 or SSE2, when available, otherwise plain loops). Every lane has its own copy of memory, instruction
+    // pointer, input cursor, and metrics. Without loop detection, results are identical to VerifyProgram.
+    //
+    // Lanes that share an instruction pointer (and the same instruction bytes at that address) execute together. When
+    // branches diverge, lanes are split into groups by instruction pointer and the group with the lowest address runs
+    // next (with the other lanes masked off), which tends to bring lanes back together once loops exit.
+    //
+    // Loop detection (see VerifyProgram) is done per lane: every so often, a lane that has run for long enough since
+    // its last snapshot saves its state at its current address (doubling the interval each time), and the lane's state
+    // is compared to the snapshot whenever it executes that address again. Since these checks aren't made at the same
+    // points as VerifyLoadedProgram's, a NonTerminating result's cycle count and input index differ from
+    // VerifyProgram's (and a lane may reach the cycle limit before its loop is detected, or vice versa); its status
+    // and other fields match (see VerifyLoadedProgram).
+    class LockstepVerifier {
+    public:
+        static constexpr unsigned int laneCount = 32;
+
+        LockstepVerifier(const uint8_t* bytes, size_t count, bool detectLoops = true);
+        explicit LockstepVerifier(const std::vector<uint8_t>& bytes, bool detectLoops = true);
+
+        // Verifies up to laneCount jobs at once; results[i] corresponds to jobs[i]
+        void Verify(const LockstepJob* jobs, size_t jobCount, VerificationResult* results);
+
+        // Verifies any number of jobs (in batches of laneCount)
+        std::vector<VerificationResult> Verify(const std::vector<LockstepJob>& jobs);
+
+        // Name of the instruction set used for lanes (e.g. "AVX2")
+        static const char* GetInstructionSetName();
+
+    private:
+        typedef uint32_t LaneMask;
+
+        typedef struct {
+            unsigned int ip;
+            LaneMask lanes;
+        } LaneGroup;
+
+        typedef struct {
+            const TestSet* testSet;
+            uint64_t cyclesExecutedMax;
+            unsigned int memoryBytesAccessedMax;
+            size_t inputIndex;
+            size_t outputIndex;
+            bool correct;
+            size_t errorOutputIndex;
+            int8_t errorExpected;
+            int8_t errorActual;
+
+            // Loop detection snapshot (the memory is in m_loopMemory)
+            bool loopSaved;
+            unsigned int loopIp;
+            uint64_t loopCyclesExecuted;
+            uint64_t loopPeriod;
+            size_t loopInputPosition;
+            size_t loopOutputIndex;
+        } LaneState;
+
+        // Steps between checks for lanes that are due for a new loop detection snapshot
+        static constexpr unsigned int loopSnapshotCheckPeriod = 256;
+
+        // Cycles between a lane's first two snapshots
+        static constexpr uint64_t loopPeriodInitial = 16;
+
+        void Load(const LockstepJob* jobs, size_t jobCount);
+        void Execute(LaneGroup& group, LaneMask lanes);
+        void AccessMemory(unsigned int address, LaneMask lanes);
+        void AddLanes(unsigned int ip, LaneMask lanes);
+        void CheckLanes(LaneMask lanes, LaneMask halted);
+        void UpdateCycleCheck();
+        void FinishLane(unsigned int lane, VerificationStatus status);
+        LaneMask FindLoopingLanes(LaneMask lanes) const;
+        void SaveLoopSnapshots();
+
+        uint8_t m_initialMemory[Constants::memorySize];
+
+        // Memory is stored "transposed" (address-major), so that one vector holds an address for every lane
+        alignas(32) uint8_t m_memory[Constants::memorySize][laneCount];
+
+        // Lanes that have accessed each address
+        LaneMask m_memoryAccessed[Constants::memorySize];
+
+        alignas(32) uint64_t m_cyclesExecuted[laneCount];
+        unsigned int m_memoryBytesAccessed[laneCount];
+        LaneState m_lanes[laneCount];
+
+        LaneMask m_active;
+
+        // Lanes that are still running, grouped by instruction pointer (note: executing a group can temporarily add
+        // up to two more groups)
+        LaneGroup m_groups[laneCount + 2];
+        unsigned int m_groupCount;
+
+        // Lanes that need to be checked for completion after the current step
+        LaneMask m_check;
+
+        // Steps remaining before any active lane could exceed its cycle limit (conservatively)
+        uint64_t m_stepsUntilCycleCheck;
+
+        VerificationResult* m_results;
+
+        // Loop detection
+        bool m_detectLoops;
+        unsigned int m_stepsUntilLoopSnapshotCheck;
+
+        // Lanes whose snapshot was taken at each address
+        LaneMask m_loopLanes[Constants::memorySize];
+
+        // Every address that has been written by any lane (all other addresses still have their initial values)
+        bool m_written[Constants::memorySize];
+        uint8_t m_writtenAddresses[Constants::memorySize];
+        unsigned int m_writtenCount;
+
+        uint8_t m_loopMemory[laneCount][Constants::memorySize];
+    };
+}
@@ -0,0 +1,100 @@
+#include "mappedfile.h"
+
+#include <stdexcept>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace Sic1;
+
+#if defined(_WIN32)
+
+MappedFile::MappedFile(const std::string& path)
+    : m_data(nullptr), m_size(0), m_file(INVALID_HANDLE_VALUE), m_mapping(nullptr) {
+    m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Failed to open file: " + path);
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(m_file, &size)) {
+        CloseHandle(m_file);
+        throw std::runtime_error("Failed to get size of file: " + path);
+    }
+
+    m_size = static_cast<size_t>(size.QuadPart);
+
+    // Note: Empty files can't be mapped
+    if (m_size > 0) {
+        m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (m_mapping) {
+            m_data = static_cast<const uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+        }
+
+        if (!m_data) {
+            if (m_mapping) {
+                CloseHandle(m_mapping);
+            }
+            CloseHandle(m_file);
+            throw std::runtime_error("Failed to map file: " + path);
+        }
+    }
+}
+
+MappedFile::~MappedFile() {
+    if (m_data) {
+        UnmapViewOfFile(m_data);
+    }
+
+    if (m_mapping) {
+        CloseHandle(m_mapping);
+    }
+
+    CloseHandle(m_file);
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& path)
+    : m_data(nullptr), m_size(0), m_file(-1) {
+    m_file = open(path.c_str(), O_RDONLY);
+    if (m_file < 0) {
+        throw std::runtime_error("Failed to open file: " + path);
+    }
+
+    struct stat status;
+    if (fstat(m_file, &status) != 0) {
+        close(m_file);
+        throw std::runtime_error("Failed to get size of file: " + path);
+    }
+
+    m_size = static_cast<size_t>(status.st_size);
+
+    // Note: Empty files can't be mapped
+    if (m_size > 0) {
+        void* data = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, m_file, 0);
+        if (data == MAP_FAILED) {
+            close(m_file);
+            throw std::runtime_error("Failed to map file: " + path);
+        }
+        m_data = static_cast<const uint8_t*>(data);
+    }
+}
+
+MappedFile::~MappedFile() {
+    if (m_data) {
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+    }
+
+    close(m_file);
+}
+
+#endif
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Sic1 {
+    // Read-only memory mapping of an entire file (pages are only loaded as they're touched, so mapping large files is
+    // cheap and doesn't count against the process's private memory)
+    class MappedFile {
+    public:
+        // Throws std::runtime_error if the file can't be opened or mapped
+        explicit MappedFile(const std::string& path);
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        const uint8_t* GetData() const {
+            return m_data;
+        }
+
+        size_t GetSize() const {
+            return m_size;
+        }
+
+    private:
+        const uint8_t* m_data;
+        size_t m_size;
+
+#if defined(_WIN32)
+        void* m_file;
+        void* m_mapping;
+#else
+        int m_file;
+#endif
+    };
+}
@@ -0,0 +1,37 @@
+#include "predecoded.h"
+
+#include <algorithm>
+#include <iterator>
+
+using namespace Sic1;
+
+PredecodedEmulator::PredecodedEmulator(const uint8_t* bytes, size_t count)
+    : Emulator(bytes, count) {
+    InvalidateAll();
+}
+
+PredecodedEmulator::PredecodedEmulator(const std::vector<uint8_t>& bytes)
+    : PredecodedEmulator(bytes.data(), bytes.size()) {
+}
+
+void PredecodedEmulator::Reset() {
+    Emulator::Reset();
+    InvalidateAll();
+}
+
+void PredecodedEmulator::Invalidate(unsigned int address) {
+    // Any instruction starting at address - 2 through address includes the modified byte
+    const unsigned int first = (address >= 2) ? (address - 2) : 0;
+    const unsigned int last = (address < decodedInstructionCount) ? address : (decodedInstructionCount - 1);
+    for (unsigned int ip = first; ip <= last; ip++) {
+        m_decoded[ip].kind = InstructionKind::Undecoded;
+    }
+}
+
+void PredecodedEmulator::InvalidateAll() {
+    for (auto& instruction : m_decoded) {
+        instruction.kind = InstructionKind::Undecoded;
+    }
+
+    std::fill(std::begin(m_isCode), std::end(m_isCode), false);
+}
@@ -0,0 +1,269 @@
+#pragma once
+
+#include "emulator.h"
+
+namespace Sic1 {
+    // Emulator that decodes each subleq instruction once (per entry point) instead of on every cycle. Writes to
+    // memory invalidate only the decoded instructions that overlap the modified byte, so self-modifying programs
+    // behave exactly as they do in Emulator.
+    class PredecodedEmulator : public Emulator {
+    public:
+        PredecodedEmulator(const uint8_t* bytes, size_t count);
+        explicit PredecodedEmulator(const std::vector<uint8_t>& bytes);
+        virtual ~PredecodedEmulator() = default;
+
+        template<typename TIo>
+        void Step(TIo& io);
+
+        template<typename TIo>
+        void StepBlock(TIo& io, uint64_t, unsigned int) {
+            Step(io);
+        }
+
+        template<typename TIo>
+        void Run(TIo& io);
+
+        template<typename TIo>
+        void Run(TIo& io, uint64_t cyclesExecutedMax);
+
+        void Reset();
+
+    protected:
+        enum class InstructionKind : uint8_t {
+            // Not yet decoded (or invalidated by a write)
+            Undecoded,
+
+            // Plain memory-to-memory subtraction
+            Subtract,
+
+            // Subtracts an input from a memory address (i.e. "subleq a, @IN")
+            Input,
+
+            // Outputs the result of subtracting a memory address from @OUT (i.e. "subleq @OUT, b")
+            Output,
+
+            // Any other instruction that reads from @IN, writes to @OUT, or writes to @HALT
+            InputOutput,
+        };
+
+        // Note: Every instruction accesses exactly its own three bytes, a, and b (or @IN, when a or b is @IN), and
+        // instructions are only decoded right before they're executed, so accesses are counted when decoding (they're
+        // never "uncounted" until reset, so executing a decoded instruction never needs any bookkeeping)
+        typedef struct {
+            uint8_t a;
+            uint8_t b;
+            uint8_t c;
+            InstructionKind kind;
+        } DecodedInstruction;
+
+        // Note: An instruction can start at any address that leaves room for all three operands
+        static constexpr unsigned int decodedInstructionCount = Constants::addressInstructionMax + 1;
+
+        const DecodedInstruction& Decode(unsigned int ip);
+        void InvalidateAll();
+
+        // Called when a byte that may be part of decoded code is modified
+        virtual void Invalidate(unsigned int address);
+
+        void WriteMemory(unsigned int address, uint8_t value) {
+            AccessMemory(address);
+            StoreMemory(address, value);
+        }
+
+        // Writes without counting the access (for callers that have already counted it)
+        void StoreMemory(unsigned int address, uint8_t value) {
+            SetMemory(address, value);
+            if (m_isCode[address]) {
+                Invalidate(address);
+            }
+        }
+
+        // Executes a subtraction that has already been decoded (and its accesses counted)
+        //
+        // Note: The next address is chosen with a branch, rather than a conditional move (which is what compilers
+        // generate for a ternary), so that it's predicted instead of waiting on the memory loads and subtraction.
+        // Without this, the pre-decoded emulator was slower than Emulator.
+        void StepSubtract(const DecodedInstruction& instruction) {
+            // Note: Copy the operands before writing, since the write may invalidate this instruction
+            const unsigned int a = instruction.a;
+            const uint8_t c = instruction.c;
+            const uint8_t result = static_cast<uint8_t>(m_memory[a] - m_memory[instruction.b]);
+            m_ip += Constants::subleqInstructionBytes;
+            if (UnsignedToSigned(result) <= 0) {
+                m_ip = c;
+            }
+
+            StoreMemory(a, result);
+            m_cyclesExecuted++;
+        }
+
+        template<typename TIo>
+        void StepInput(TIo& io, const DecodedInstruction& instruction) {
+            const unsigned int a = instruction.a;
+            const uint8_t c = instruction.c;
+            uint8_t input = 0;
+            const uint8_t result = io.TryReadInput(input) ? static_cast<uint8_t>(m_memory[a] - input) : 0;
+            m_ip += Constants::subleqInstructionBytes;
+            if (UnsignedToSigned(result) <= 0) {
+                m_ip = c;
+            }
+
+            StoreMemory(a, result);
+            m_cyclesExecuted++;
+        }
+
+        template<typename TIo>
+        void StepOutput(TIo& io, const DecodedInstruction& instruction) {
+            const int8_t result = UnsignedToSigned(static_cast<uint8_t>(m_memory[Constants::addressOutput] - m_memory[instruction.b]));
+            io.WriteOutput(result);
+            m_ip += Constants::subleqInstructionBytes;
+            if (result <= 0) {
+                m_ip = instruction.c;
+            }
+
+            m_cyclesExecuted++;
+        }
+
+        // Decodes the current instruction (if needed) and executes it
+        template<typename TIo>
+        void StepSlow(TIo& io);
+
+        template<typename TIo>
+        void StepInputOutput(TIo& io, const DecodedInstruction& instruction);
+
+        DecodedInstruction m_decoded[decodedInstructionCount];
+
+        // Addresses that have been decoded as part of an instruction (conservatively, since this is only cleared on
+        // reset), used to skip invalidation on writes to data
+        bool m_isCode[Constants::memorySize];
+    };
+
+    inline const PredecodedEmulator::DecodedInstruction& PredecodedEmulator::Decode(unsigned int ip) {
+        DecodedInstruction& instruction = m_decoded[ip];
+        if (instruction.kind == InstructionKind::Undecoded) {
+            instruction.a = m_memory[ip];
+            instruction.b = m_memory[ip + 1];
+            instruction.c = m_memory[ip + 2];
+            if (instruction.a < Constants::addressInput) {
+                instruction.kind = (instruction.b == Constants::addressInput) ? InstructionKind::Input : InstructionKind::Subtract;
+            }
+            else {
+                instruction.kind = (instruction.a == Constants::addressOutput && instruction.b != Constants::addressInput)
+                    ? InstructionKind::Output
+                    : InstructionKind::InputOutput;
+            }
+
+            m_isCode[ip] = true;
+            m_isCode[ip + 1] = true;
+            m_isCode[ip + 2] = true;
+
+            AccessMemory(ip);
+            AccessMemory(ip + 1);
+            AccessMemory(ip + 2);
+            AccessMemory(instruction.a);
+            AccessMemory(instruction.b);
+        }
+        return instruction;
+    }
+
+    template<typename TIo>
+    inline void PredecodedEmulator::Step(TIo& io) {
+        if (IsRunning()) {
+            const DecodedInstruction& instruction = m_decoded[m_ip];
+            switch (instruction.kind) {
+            case InstructionKind::Subtract:
+                StepSubtract(instruction);
+                break;
+
+            case InstructionKind::Input:
+                StepInput(io, instruction);
+                break;
+
+            case InstructionKind::Output:
+                StepOutput(io, instruction);
+                break;
+
+            default:
+                StepSlow(io);
+                break;
+            }
+        }
+    }
+
+    template<typename TIo>
+    inline void PredecodedEmulator::StepSlow(TIo& io) {
+        const DecodedInstruction& instruction = Decode(m_ip);
+        switch (instruction.kind) {
+        case InstructionKind::Subtract:
+            StepSubtract(instruction);
+            break;
+
+        case InstructionKind::Input:
+            StepInput(io, instruction);
+            break;
+
+        case InstructionKind::Output:
+            StepOutput(io, instruction);
+            break;
+
+        default:
+            StepInputOutput(io, instruction);
+            break;
+        }
+    }
+
+    template<typename TIo>
+    inline void PredecodedEmulator::StepInputOutput(TIo& io, const DecodedInstruction& instruction) {
+        const unsigned int ip = m_ip;
+        const unsigned int a = instruction.a;
+        const unsigned int b = instruction.b;
+        const unsigned int c = instruction.c;
+
+        // The rest is identical to Emulator::Step (except that accesses were counted when decoding)
+        uint8_t input = 0;
+        bool inputValid = true;
+        if (a == Constants::addressInput || b == Constants::addressInput) {
+            inputValid = io.TryReadInput(input);
+        }
+
+        const uint8_t av = (a == Constants::addressInput) ? input : m_memory[a];
+        const uint8_t bv = (b == Constants::addressInput) ? input : m_memory[b];
+        const uint8_t result = inputValid ? static_cast<uint8_t>(av - bv) : 0;
+
+        const int8_t resultSigned = UnsignedToSigned(result);
+        switch (a) {
+        case Constants::addressInput:
+        case Constants::addressHalt:
+            break;
+
+        case Constants::addressOutput:
+            io.WriteOutput(resultSigned);
+            break;
+
+        default:
+            StoreMemory(a, result);
+            break;
+        }
+
+        m_ip = ip + Constants::subleqInstructionBytes;
+        if (resultSigned <= 0) {
+            m_ip = c;
+        }
+
+        m_cyclesExecuted++;
+    }
+
+    template<typename TIo>
+    inline void PredecodedEmulator::Run(TIo& io) {
+        while (IsRunning()) {
+            Step(io);
+        }
+    }
+
+    template<typename TIo>
+    inline void PredecodedEmulator::Run(TIo& io, uint64_t cyclesExecutedMax) {
+        while (IsRunning() && m_cyclesExecuted < cyclesExecutedMax) {
+            Step(io);
+        }
+    }
+}
@@ -0,0 +1,46 @@
+#include "profiler.h"
+
+using namespace Sic1;
+
+ProfilingEmulator::ProfilingEmulator(const uint8_t* bytes, size_t count)
+    : Emulator(bytes, count),
+    m_profile() {
+}
+
+ProfilingEmulator::ProfilingEmulator(const std::vector<uint8_t>& bytes)
+    : ProfilingEmulator(bytes.data(), bytes.size()) {
+}
+
+void ProfilingEmulator::Reset() {
+    Emulator::Reset();
+    m_profile = {};
+}
+
+std::vector<SourceLineProfile> Sic1::GetSourceLineProfiles(const Profile& profile, const AssembledProgram& program) {
+    const unsigned int programSize = static_cast<unsigned int>(program.bytes.size());
+    std::vector<SourceLineProfile> lines;
+    for (unsigned int address = 0; address < program.sourceMap.size() && address < programSize; address++) {
+        const auto& entry = program.sourceMap[address];
+        if (!entry) {
+            continue;
+        }
+
+        // Each line extends up to the next line's first address (or the end of the program)
+        unsigned int end = address + 1;
+        while (end < programSize && (end >= program.sourceMap.size() || !program.sourceMap[end])) {
+            end++;
+        }
+
+        SourceLineProfile line = { entry->lineNumber, address, end - address, 0, 0, 0, 0, 0 };
+        for (unsigned int i = address; i < end; i++) {
+            line.executions += profile.executions[i];
+            line.branchesTaken += profile.branchesTaken[i];
+            line.reads += profile.reads[i];
+            line.writes += profile.writes[i];
+        }
+
+        line.branchesNotTaken = line.executions - line.branchesTaken;
+        lines.push_back(line);
+    }
+    return lines;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include "assembler.h"
+#include "emulator.h"
+
+// Per-address execution profiling, for finding the instructions (and source lines) that a program spends its cycles on
+namespace Sic1 {
+    typedef struct {
+        // Indexed by the address of each executed instruction. Since every instruction takes one cycle, these sum to
+        // the number of cycles executed.
+        std::array<uint64_t, Constants::memorySize> executions;
+
+        // Number of executions whose result was non-positive, i.e. that branched to the third operand (the rest fell
+        // through, even if the third operand was the next instruction)
+        std::array<uint64_t, Constants::memorySize> branchesTaken;
+
+        // Indexed by operand address: each instruction reads its first two operands' addresses and writes its result to
+        // the first one (including @IN, @OUT, and @HALT, which aren't actually memory)
+        std::array<uint64_t, Constants::memorySize> reads;
+        std::array<uint64_t, Constants::memorySize> writes;
+    } Profile;
+
+    // Emulator that records a Profile as it runs. Other engines aren't affected (Emulator::Step's profiler defaults to
+    // one that does nothing), so profiling only costs anything when this engine is used.
+    class ProfilingEmulator : public Emulator {
+    public:
+        ProfilingEmulator(const uint8_t* bytes, size_t count);
+        explicit ProfilingEmulator(const std::vector<uint8_t>& bytes);
+
+        const Profile& GetProfile() const {
+            return m_profile;
+        }
+
+        template<typename TIo>
+        void Step(TIo& io) {
+            Recorder recorder(m_profile);
+            Emulator::Step(io, recorder);
+        }
+
+        template<typename TIo>
+        void StepBlock(TIo& io, uint64_t, unsigned int) {
+            Step(io);
+        }
+
+        template<typename TIo>
+        void Run(TIo& io) {
+            while (IsRunning()) {
+                Step(io);
+            }
+        }
+
+        template<typename TIo>
+        void Run(TIo& io, uint64_t cyclesExecutedMax) {
+            while (IsRunning() && m_cyclesExecuted < cyclesExecutedMax) {
+                Step(io);
+            }
+        }
+
+        // Resets memory and clears the profile
+        void Reset();
+
+    private:
+        class Recorder {
+        public:
+            explicit Recorder(Profile& profile)
+                : m_profile(profile) {
+            }
+
+            void OnInstruction(unsigned int ip, unsigned int a, unsigned int b, bool branched) {
+                m_profile.executions[ip]++;
+                m_profile.branchesTaken[ip] += branched ? 1 : 0;
+                m_profile.reads[a]++;
+                m_profile.reads[b]++;
+                m_profile.writes[a]++;
+            }
+
+        private:
+            Profile& m_profile;
+        };
+
+        Profile m_profile;
+    };
+
+    // Profile of a single source line that produced code or data
+    typedef struct {
+        // Zero-based (as in SourceMapEntry)
+        unsigned int lineNumber;
+
+        // Range of addresses produced by the line
+        unsigned int address;
+        unsigned int size;
+
+        // Totals for instructions starting within the line's range (normally only at its first address, unless the
+        // program jumps into the middle of a line or executes data)
+        uint64_t executions;
+        uint64_t branchesTaken;
+        uint64_t branchesNotTaken;
+
+        // Totals for operands within the line's range (e.g. a variable's reads and writes)
+        uint64_t reads;
+        uint64_t writes;
+    } SourceLineProfile;
+
+    // Maps a profile back to the program's source lines (via AssembledProgram::sourceMap), in address order. Addresses
+    // that weren't produced by any line (the built-in addresses and anything past the end of the program) aren't
+    // included.
+    std::vector<SourceLineProfile> GetSourceLineProfiles(const Profile& profile, const AssembledProgram& program);
+}
@@ -0,0 +1,1067 @@
+#include "puzzles.h"
+
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+#include "assembler.h"
+#include "emulator.h"
+
+using namespace Sic1;
+
+namespace {
+    // Helpers (see the corresponding functions in puzzles.ts)
+    int RandomPositive(Random& random) {
+        return random.NextInt(10) + 1;
+    }
+
+    int RandomKindOfLargePositive(Random& random) {
+        return random.NextInt(99) + 1;
+    }
+
+    int RandomLargePositive(Random& random) {
+        return random.NextInt(101) + 1;
+    }
+
+    int RandomNonnegative(Random& random) {
+        return random.NextInt(10);
+    }
+
+    std::vector<int> RandomPositiveSequence(Random& random, int sequenceLength = 6) {
+        std::vector<int> sequence;
+        for (int i = 0; i < sequenceLength; i++) {
+            sequence.push_back(RandomPositive(random));
+        }
+        sequence.push_back(0);
+        return sequence;
+    }
+
+    std::vector<int> RandomSet(Random& random, int setSize = 5) {
+        std::vector<int> pool;
+        for (int i = 0; i < setSize * 2; i++) {
+            pool.push_back(i + 1);
+        }
+
+        std::vector<int> set;
+        for (int i = 0; i < setSize; i++) {
+            const int index = random.NextInt(static_cast<int>(pool.size()));
+            set.push_back(pool[index]);
+            pool.erase(pool.begin() + index);
+        }
+        set.push_back(0);
+        return set;
+    }
+
+    std::vector<int> CharactersToNumbers(const std::string& characters) {
+        std::vector<int> numbers;
+        for (char character : characters) {
+            numbers.push_back(static_cast<unsigned char>(character));
+        }
+        return numbers;
+    }
+
+    std::vector<int> StringToNumbers(const std::string& str) {
+        std::vector<int> numbers = CharactersToNumbers(str);
+        numbers.push_back(0);
+        return numbers;
+    }
+
+    std::vector<int> StringsToNumbers(const std::vector<std::string>& strings) {
+        std::vector<int> numbers;
+        for (const auto& str : strings) {
+            const auto characters = CharactersToNumbers(str);
+            numbers.insert(numbers.end(), characters.begin(), characters.end());
+            numbers.push_back(0);
+        }
+        return numbers;
+    }
+
+    // Converts a zero-terminated sequence of character codes back into a string (dropping the terminator)
+    std::string NumbersToString(const std::vector<int>& sequence) {
+        std::string str;
+        for (size_t i = 0; i + 1 < sequence.size(); i++) {
+            str.push_back(static_cast<char>(sequence[i]));
+        }
+        return str;
+    }
+
+    void ShuffleInPlace(Random& random, std::vector<int>& array) {
+        for (size_t i = array.size() - 1; i >= 1 && i < array.size(); i--) {
+            const size_t index = static_cast<size_t>(random.NextInt(static_cast<int>(i + 1)));
+            std::swap(array[i], array[index]);
+        }
+    }
+
+    std::vector<std::string> Split(const std::string& str, const char* separators) {
+        std::vector<std::string> parts;
+        size_t start = 0;
+        while (true) {
+            const size_t end = str.find_first_of(separators, start);
+            parts.push_back(str.substr(start, end - start));
+            if (end == std::string::npos) {
+                break;
+            }
+            start = end + 1;
+        }
+        return parts;
+    }
+
+    std::string Trim(const std::string& str) {
+        const size_t first = str.find_first_not_of(" \t\r\n");
+        if (first == std::string::npos) {
+            return std::string();
+        }
+        return str.substr(first, str.find_last_not_of(" \t\r\n") - first + 1);
+    }
+
+    std::string RemoveAll(std::string str, const std::string& pattern) {
+        for (size_t index = str.find(pattern); index != std::string::npos; index = str.find(pattern, index)) {
+            str.erase(index, pattern.size());
+        }
+        return str;
+    }
+
+    int ParseInt(const std::string& str) {
+        return std::stoi(str);
+    }
+
+    PuzzleIoGroups Identity(const PuzzleIoGroups& input) {
+        return input;
+    }
+
+    // Assembles the program encoded by the sequence and records the first 50 steps' output (see getExpectedOutput for
+    // "Self-Hosting")
+    std::vector<int> RunSelfHostingTest(const std::vector<int>& sequence) {
+        const std::vector<uint8_t> bytes = Assembler::Assemble(NumbersToString(sequence)).bytes;
+
+        struct OutputIo {
+            bool TryReadInput(uint8_t& value) {
+                value = 0;
+                return true;
+            }
+
+            void WriteOutput(int8_t value) {
+                outputs.push_back(value);
+            }
+
+            std::vector<int> outputs;
+        } io;
+
+        Emulator emulator(bytes);
+        for (int step = 0; step < 50 && emulator.IsRunning(); step++) {
+            emulator.Step(io);
+        }
+        return io.outputs;
+    }
+
+    PuzzleIoGroups RunSelfHostingTests(const PuzzleIoGroups& input) {
+        PuzzleIoGroups output;
+        for (const auto& sequence : input) {
+            output.push_back(RunSelfHostingTest(sequence));
+        }
+        return output;
+    }
+
+    const std::vector<Puzzle> puzzles = {
+        {
+            "Subleq Instruction and Output",
+            {}, nullptr, nullptr,
+            {
+                { { 3 }, { -3 } },
+            },
+        },
+        {
+            "Data Directive and Looping",
+            {}, nullptr, nullptr,
+            {
+                { { 3 }, { -3 } },
+                { { 4 }, { -4 } },
+                { { 5 }, { -5 } },
+            },
+        },
+        {
+            "First Assessment",
+            {},
+            [](Random& random) {
+                PuzzleIoGroups input;
+                for (int i = 0; i < 3; i++) {
+                    input.push_back({ RandomPositive(random) });
+                }
+                return input;
+            },
+            Identity,
+            {
+                { { 1 }, { 1 } },
+                { { 2 }, { 2 } },
+                { { 3 }, { 3 } },
+            },
+        },
+        {
+            "Addition",
+            { { { 99, 28 }, { -100, 100 }, { 1, -2 } } },
+            [](Random& random) {
+                PuzzleIoGroups input;
+                for (int i = 0; i < 3; i++) {
+                    const int a = RandomNonnegative(random);
+                    const int b = RandomNonnegative(random);
+                    input.push_back({ a, b });
+                }
+                return input;
+            },
+            [](const PuzzleIoGroups& input) {
+                PuzzleIoGroups output;
+                for (const auto& a : input) {
+                    output.push_back({ a[0] + a[1] });
+                }
+                return output;
+            },
+            {
+                { { 1, 1 }, { 2 } },
+                { { 1, 2 }, { 3 } },
+                { { 1, -1 }, { 0 } },
+                { { 11, 25 }, { 36 } },
+                { { 82, 17 }, { 99 } },
+            },
+        },
+        {
+            "Subtraction",
+            { { { 100, 101 }, { 111, 72 }, { 1, -120 } } },
+            [](Random& random) {
+                PuzzleIoGroups input;
+                for (int i = 0; i < 3; i++) {
+                    const int a = RandomNonnegative(random);
+                    const int b = RandomNonnegative(random);
+                    input.push_back({ a, b });
+                }
+                return input;
+            },
+            [](const PuzzleIoGroups& input) {
+                PuzzleIoGroups output;
+                for (const auto& a : input) {
+                    output.push_back({ a[0] - a[1] });
+                }
+                return output;
+            },
+            {
+                { { 1, 1 }, { 0 } },
+                { { 1, 2 }, { -1 } },
+                { { 1, -1 }, { 2 } },
+                { { 11, 25 }, { -14 } },
+                { { 82, 17 }, { 65 } },
+            },
+        },
+        {
+            "Sign Function",
+            {
+                { { 127 }, { 99 }, { -100 }, { 1 }, { 0 }, { 99 }, { 1 } },
+                { { -1 }, { -1 }, { -2 }, { 3 }, { 0 }, { 0 } },
+                { { -1 }, { 1 }, { 2 }, { -3 }, { 0 }, { 0 } },
+            },
+            [](Random& random) {
+                PuzzleIoGroups input;
+                for (int i = 0; i < 4; i++) {
+                    input.push_back({ random.NextInt(5) - 2 });
+                }
+                return input;
+            },
+            [](const PuzzleIoGroups& input) {
+                PuzzleIoGroups output;
+                for (const auto& a : input) {
+                    std::vector<int> signs;
+                    for (int b : a) {
+                        signs.push_back((b < 0) ? -1 : ((b > 0) ? 1 : 0));
+                    }
+                    output.push_back(signs);
+                }
+                return output;
+            },
+            {
+                { { -1 }, { -1 } },
+                { { 0 }, { 0 } },
+                { { 1 }, { 1 } },
+                { { 7 }, { 1 } },
+                { { -29 }, { -1 } },
+                { { 99 }, { 1 } },
+                { { -99 }, { -1 } },
+            },
+        },
+        {
+            "Multiplication",
+            { { { 11, 11 }, { 2, 3, 0, 0 }, { 11, 0 } } },
+            [](Random& random) {
+                PuzzleIoGroups input;
+                for (int i = 0; i < 3; i++) {
+                    const int a = RandomNonnegative(random);
+                    const int b = RandomNonnegative(random);
+                    input.push_back({ a, b });
+                }
+                return input;
+            },
+            [](const PuzzleIoGroups& input) {
+                PuzzleIoGroups output;
+                for (const auto& a : input) {
+                    std::vector<int> result;
+                    for (size_t i = 0; i + 1 < a.size(); i += 2) {
+                        result.push_back(a[i] * a[i + 1]);
+                    }
+                    output.push_back(result);
+                }
+                return output;
+            },
+            {
+                { { 1, 0 }, { 0 } },
+                { { 0, 1 }, { 0 } },
+                { { 1, 1 }, { 1 } },
+                { { 2, 3 }, { 6 } },
+                { { 7, 13 }, { 91 } },
+            },
+        },
+        {
+            "Division",
+            { { { 122, 11 }, { 16, 3 }, { 7, 7 } } },
+            [](Random& random) {
+                PuzzleIoGroups input;
+                for (int i = 0; i < 4; i++) {
+                    const int a = RandomPositive(random);
+                    const int b = RandomPositive(random);
+                    input.push_back({ a, b });
+                }
+                return input;
+            },
+            [](const PuzzleIoGroups& input) {
+                // Note: All values are positive
+                PuzzleIoGroups output;
+                for (const auto& a : input) {
+                    output.push_back({ a[0] / a[1], a[0] % a[1] });
+                }
+                return output;
+            },
+            {
+                { { 1, 1 }, { 1, 0 } },
+                { { 9, 3 }, { 3, 0 } },
+                { { 17, 2 }, { 8, 1 } },
+                { { 67, 9 }, { 7, 4 } },
+            },
+        },
+        {
+            "Sequence Sum",
+            { { { 100, 20, 7, 0 } } },
+            [](Random& random) {
+                PuzzleIoGroups input;
+                for (int i = 0; i < 3; i++) {
+                    input.push_back(RandomPositiveSequence(random));
+                }
+                return input;
+            },
+            [](const PuzzleIoGroups& input) {
+                PuzzleIoGroups output;
+                for (const auto& a : input) {
+                    int sum = 0;
+                    for (int value : a) {
+                        sum += value;
+                    }
+                    output.push_back({ sum });
+                }
+                return output;
+            },
+            {
+                { { 1, 1, 1, 0 }, { 3 } },
+                { { 1, 2, 3, 0 }, { 6 } },
+                { { 3, 5, 7, 11, 0 }, { 26 } },
+                { { 53, 13, 22, 9, 0 }, { 97 } },
+            },
+        },
+        {
+            "Sequence Cardinality",
+            { { { 100, 100, 100, 0 } } },
+            [](Random& random) {
+                PuzzleIoGroups input;
+                for (int i = 0; i < 2; i++) {
+                    input.push_back(RandomPositiveSequence(random, random.NextInt(4) + 2));
+                }
+                return input;
+            },
+            [](const PuzzleIoGroups& input) {
+                PuzzleIoGroups output;
+                for (const auto& a : input) {
+                    output.push_back({ static_cast<int>(a.size()) - 1 });
+                }
+                return output;
+            },
+            {
+                { { 0 }, { 0 } },
+                { { 1, 0 }, { 1 } },
+                { { 3, 4, 0 }, { 2 } },
+                { { 9, 2, 7, 13, 26, 0 }, { 5 } },
+            },
+        },
+        {
+            "Number to Sequence",
+            { { { 2 }, { 0 }, { 3 }, { 0 } } },
+            [](Random& random) {
+                PuzzleIoGroups input;
+                for (int i = 0; i < 2; i++) {
+                    input.push_back({ RandomPositive(random) });
+                }
+                return input;
+            },
+            [](const PuzzleIoGroups& input) {
+                PuzzleIoGroups output;
+                for (const auto& value : input) {
+                    std::vector<int> sequence;
+                    for (int i = 0; i < value[0]; i++) {
+                        sequence.push_back(1);
+                    }
+                    sequence.push_back(0);
+                    output.push_back(sequence);
+                }
+                return output;
+            },
+            {
+                { { 0 }, { 0 } },
+                { { 1 }, { 1, 0 } },
+                { { 2 }, { 1, 1, 0 } },
+                { { 5 }, { 1, 1, 1, 1, 1, 0 } },
+                { { 3 }, { 1, 1, 1, 0 } },
+                { { 7 }, { 1, 1, 1, 1, 1, 1, 1, 0 } },
+            },
+        },
+        {
+            "Self-Modifying Code",
+            {}, nullptr, nullptr,
+            {
+                { { 0 }, { 12, 1, 3, -2, 12, 6, 1, 13, 9, 12, 12, 0 } },
+            },
+        },
+        {
+            "Stack Memory",
+            {}, nullptr, nullptr,
+            {
+                { { 3, 5, 7 }, { 7, 5, 3 } },
+            },
+        },
+        {
+            "Reverse Sequence",
+            { { { 98, 99, 100, 0 } } },
+            [](Random& random) {
+                PuzzleIoGroups input;
+                for (int i = 0; i < 2; i++) {
+                    input.push_back(RandomPositiveSequence(random));
+                }
+                return input;
+            },
+            [](const PuzzleIoGroups& input) {
+                PuzzleIoGroups output;
+                for (const auto& sequence : input) {
+                    std::vector<int> reversed(sequence.rbegin() + 1, sequence.rend());
+                    reversed.push_back(0);
+                    output.push_back(reversed);
+                }
+                return output;
+            },
+            {
+                { { 1, 2, 3, 0 }, { 3, 2, 1, 0 } },
+                { { 3, 2, 1, 0 }, { 1, 2, 3, 0 } },
+                { { 3, 5, 7, 11, 13, 15, 17, 0 }, { 17, 15, 13, 11, 7, 5, 3, 0 } },
+            },
+        },
+        {
+            "Interleave",
+            {},
+            [](Random& random) {
+                PuzzleIoGroups input;
+                for (int i = 0; i < 2; i++) {
+                    std::vector<int> sequence = RandomPositiveSequence(random, 3);
+                    const std::vector<int> second = RandomPositiveSequence(random, 3);
+                    sequence.insert(sequence.end(), second.begin(), second.end());
+                    input.push_back(sequence);
+                }
+                return input;
+            },
+            [](const PuzzleIoGroups& input) {
+                // Note: Both halves of each input are the same length (including the terminator)
+                PuzzleIoGroups output;
+                for (const auto& sequence : input) {
+                    const size_t half = sequence.size() / 2;
+                    std::vector<int> interleaved;
+                    for (size_t i = 0; i < half; i++) {
+                        interleaved.push_back(sequence[i]);
+                        interleaved.push_back(sequence[i + half]);
+                    }
+                    interleaved.pop_back();
+                    output.push_back(interleaved);
+                }
+                return output;
+            },
+            {
+                { { 1, 1, 1, 0, 2, 2, 2, 0 }, { 1, 2, 1, 2, 1, 2, 0 } },
+                { { 9, 8, 7, 0, 10, 20, 30, 0 }, { 9, 10, 8, 20, 7, 30, 0 } },
+                { { 3, 5, 7, 11, 0, 13, 17, 19, 23, 0 }, { 3, 13, 5, 17, 7, 19, 11, 23, 0 } },
+            },
+        },
+        {
+            "Indicator Function",
+            { { { 13, 57, 99, 63, 0, 13, 99, 57, 0 }, { 61, 62, 63, 64, 0, 66, 64, 62, 60, 0 }, { 97, 98, 99, 0, 77, 88, 99, 0 } } },
+            [](Random& random) {
+                PuzzleIoGroups input;
+                for (int i = 0; i < 2; i++) {
+                    std::vector<int> sequence = RandomSet(random);
+                    const std::vector<int> second = RandomSet(random);
+                    sequence.insert(sequence.end(), second.begin(), second.end());
+                    input.push_back(sequence);
+                }
+                return input;
+            },
+            [](const PuzzleIoGroups& input) {
+                PuzzleIoGroups output;
+                for (const auto& sequence : input) {
+                    const auto aEnd = std::find(sequence.begin(), sequence.end(), 0);
+                    const auto bBegin = aEnd + 1;
+                    const auto bEnd = std::find(bBegin, sequence.end(), 0);
+
+                    std::vector<int> indicators;
+                    for (auto value = bBegin; value != bEnd; ++value) {
+                        indicators.push_back((std::find(sequence.begin(), aEnd, *value) != aEnd) ? 1 : 0);
+                    }
+                    output.push_back(indicators);
+                }
+                return output;
+            },
+            {
+                { { 2, 4, 6, 0, 1, 2, 3, 0 }, { 0, 1, 0 } },
+                { { 3, 5, 7, 0, 9, 6, 3, 0 }, { 0, 0, 1 } },
+            },
+        },
+        {
+            "Sort",
+            { { { 93, 94, 95, 96, 97, 98, 99, 0 } } },
+            [](Random& random) {
+                PuzzleIoGroups input;
+                for (int i = 0; i < 2; i++) {
+                    input.push_back(RandomPositiveSequence(random));
+                }
+                return input;
+            },
+            [](const PuzzleIoGroups& input) {
+                PuzzleIoGroups output;
+                for (const auto& sequence : input) {
+                    std::vector<int> sorted(sequence.begin(), sequence.end() - 1);
+                    std::sort(sorted.begin(), sorted.end());
+                    sorted.push_back(0);
+                    output.push_back(sorted);
+                }
+                return output;
+            },
+            {
+                { { 3, 1, 2, 0 }, { 1, 2, 3, 0 } },
+                { { 9, 9, 5, 0 }, { 5, 9, 9, 0 } },
+                { { 17, 13, 19, 5, 23, 7, 0 }, { 5, 7, 13, 17, 19, 23, 0 } },
+            },
+        },
+        {
+            "Mode",
+            { { { 96, 97, 98, 97, 96, 98, 99, 96, 98, 96, 0 }, { 87, 49, 87, 3, 49, 49, 3, 0 } } },
+            [](Random& random) {
+                PuzzleIoGroups input;
+                for (int count = 1; count <= 2; count++) {
+                    int numbers[3];
+                    for (auto& number : numbers) {
+                        number = RandomKindOfLargePositive(random);
+                    }
+
+                    std::vector<int> sequence;
+                    for (int j = 0; j < 3; j++) {
+                        for (int c = 0; c <= count; c++) {
+                            sequence.push_back(numbers[j]);
+                        }
+                    }
+                    sequence.push_back(numbers[random.NextInt(3)]);
+                    ShuffleInPlace(random, sequence);
+                    sequence.push_back(0);
+                    input.push_back(sequence);
+                }
+                return input;
+            },
+            [](const PuzzleIoGroups& input) {
+                // Note: Object keys that are integers are enumerated in ascending order, so ties go to the smallest
+                // value (and all values here are non-negative)
+                PuzzleIoGroups output;
+                for (const auto& sequence : input) {
+                    std::map<int, int> counts;
+                    for (int value : sequence) {
+                        counts[value]++;
+                    }
+
+                    int max = 0;
+                    int mode = 0;
+                    for (const auto& entry : counts) {
+                        if (entry.second > max) {
+                            max = entry.second;
+                            mode = entry.first;
+                        }
+                    }
+                    output.push_back({ mode });
+                }
+                return output;
+            },
+            {
+                { { 1, 2, 3, 3, 0 }, { 3 } },
+                { { 1, 2, 1, 2, 1, 0 }, { 1 } },
+                { { 3, 1, 2, 3, 1, 2, 3, 3, 1, 2, 2, 2, 0 }, { 2 } },
+            },
+        },
+        {
+            "Characters",
+            {}, nullptr, nullptr,
+            {
+                { { 0 }, CharactersToNumbers("Hi") },
+            },
+        },
+        {
+            "Decimal Digits",
+            { { CharactersToNumbers("0"), CharactersToNumbers("9") } },
+            [](Random& random) {
+                PuzzleIoGroups input;
+                for (int i = 0; i < 6; i++) {
+                    input.push_back(CharactersToNumbers(std::to_string(random.NextInt(10))));
+                }
+                return input;
+            },
+            [](const PuzzleIoGroups& input) {
+                PuzzleIoGroups output;
+                for (const auto& sequence : input) {
+                    output.push_back({ sequence[0] - '0' });
+                }
+                return output;
+            },
+            {
+                { CharactersToNumbers("1"), { 1 } },
+                { CharactersToNumbers("2"), { 2 } },
+                { CharactersToNumbers("7"), { 7 } },
+            },
+        },
+        {
+            "Uppercase",
+            { { { 'a' }, { 'z' }, { 'a' - 1 }, { 'z' + 1 } } },
+            [](Random& random) {
+                PuzzleIoGroups input;
+                for (int i = 0; i < 13; i++) {
+                    input.push_back({ random.NextInt(75) + 48 });
+                }
+                return input;
+            },
+            [](const PuzzleIoGroups& input) {
+                PuzzleIoGroups output;
+                for (const auto& sequence : input) {
+                    const int character = sequence[0];
+                    output.push_back({ (character >= 'a' && character <= 'z') ? (character - 'a' + 'A') : character });
+                }
+                return output;
+            },
+            {
+                { CharactersToNumbers("U"), CharactersToNumbers("U") },
+                { CharactersToNumbers("r"), CharactersToNumbers("R") },
+                { CharactersToNumbers("g"), CharactersToNumbers("G") },
+                { CharactersToNumbers("e"), CharactersToNumbers("E") },
+                { CharactersToNumbers("n"), CharactersToNumbers("N") },
+                { CharactersToNumbers("t"), CharactersToNumbers("T") },
+                { CharactersToNumbers("!"), CharactersToNumbers("!") },
+            },
+        },
+        {
+            "Strings",
+            {}, nullptr, nullptr,
+            {
+                { { 0 }, StringToNumbers("Hello, world!") },
+            },
+        },
+        {
+            "Tokenizer",
+            { { StringToNumbers("subleq @OUT @IN"), StringToNumbers(".data 0") } },
+            [](Random& random) {
+                std::string str;
+                for (int i = 0; i < 3; i++) {
+                    if (i > 0) {
+                        str.push_back(' ');
+                    }
+
+                    for (int j = 0; j < 3; j++) {
+                        str.push_back(static_cast<char>(random.NextInt(75) + 48));
+                    }
+                }
+                return PuzzleIoGroups({ StringToNumbers(str) });
+            },
+            [](const PuzzleIoGroups& input) {
+                PuzzleIoGroups output;
+                for (const auto& sequence : input) {
+                    output.push_back(StringsToNumbers(Split(NumbersToString(sequence), " ")));
+                }
+                return output;
+            },
+            {
+                { StringToNumbers("The quick brown fox loves SIC Systems"), StringsToNumbers({ "The", "quick", "brown", "fox", "loves", "SIC", "Systems" }) },
+            },
+        },
+        {
+            "Parse Decimal",
+            { { StringToNumbers("123"), StringToNumbers("9") } },
+            [](Random& random) {
+                PuzzleIoGroups input;
+                for (int i = 0; i < 3; i++) {
+                    input.push_back(StringToNumbers(std::to_string(RandomLargePositive(random))));
+                }
+                return input;
+            },
+            [](const PuzzleIoGroups& input) {
+                PuzzleIoGroups output;
+                for (const auto& sequence : input) {
+                    output.push_back({ ParseInt(NumbersToString(sequence)) });
+                }
+                return output;
+            },
+            {
+                { StringToNumbers("1"), { 1 } },
+                { StringToNumbers("20"), { 20 } },
+                { StringToNumbers("74"), { 74 } },
+            },
+        },
+        {
+            "Print Decimal",
+            { { { 123 }, { 9 }, { 100 }, { 101 }, { 12 } } },
+            [](Random& random) {
+                PuzzleIoGroups input;
+                for (int i = 0; i < 3; i++) {
+                    input.push_back({ RandomLargePositive(random) });
+                }
+                return input;
+            },
+            [](const PuzzleIoGroups& input) {
+                PuzzleIoGroups output;
+                for (const auto& sequence : input) {
+                    output.push_back(StringToNumbers(std::to_string(sequence[0])));
+                }
+                return output;
+            },
+            {
+                { { 1 }, StringToNumbers("1") },
+                { { 20 }, StringToNumbers("20") },
+                { { 74 }, StringToNumbers("74") },
+            },
+        },
+        {
+            "Calculator",
+            { { StringToNumbers("10 * 11"), StringToNumbers("120 - 61"), StringToNumbers("61 + 62"), StringToNumbers("8 * 1") } },
+            [](Random& random) {
+                PuzzleIoGroups input;
+                for (int i = 0; i < 4; i++) {
+                    const char operations[] = { '+', '-', '*' };
+                    const char operation = operations[random.NextInt(3)];
+                    int a = 0;
+                    int b = 0;
+                    switch (operation) {
+                    case '+':
+                        a = RandomLargePositive(random);
+                        b = random.NextInt(120 - a) + 1;
+                        break;
+
+                    case '-':
+                        a = RandomLargePositive(random);
+                        b = RandomLargePositive(random);
+                        break;
+
+                    case '*':
+                        a = random.NextInt(11) + 1;
+                        b = random.NextInt(11) + 1;
+                        break;
+                    }
+
+                    input.push_back(StringToNumbers(std::to_string(a) + " " + operation + " " + std::to_string(b)));
+                }
+                return input;
+            },
+            [](const PuzzleIoGroups& input) {
+                PuzzleIoGroups output;
+                for (const auto& sequence : input) {
+                    const auto parts = Split(NumbersToString(sequence), " ");
+                    const int a = ParseInt(parts[0]);
+                    const int b = ParseInt(parts[2]);
+                    switch (parts[1][0]) {
+                    case '+': output.push_back({ a + b }); break;
+                    case '-': output.push_back({ a - b }); break;
+                    case '*': output.push_back({ a * b }); break;
+                    }
+                }
+                return output;
+            },
+            {
+                { StringToNumbers("1 + 1"), { 2 } },
+                { StringToNumbers("99 - 100"), { -1 } },
+                { StringToNumbers("10 * 4"), { 40 } },
+            },
+        },
+        {
+            "Multi-Line Strings",
+            {}, nullptr, nullptr,
+            {
+                { StringToNumbers(".data 1\n.data 2\n.data 3\n"), StringsToNumbers({ ".data 1", ".data 2", ".data 3" }) },
+            },
+        },
+        {
+            "Parse Data Directives",
+            { { StringToNumbers(".data 0\n.data -128\n.data 127\n") } },
+            [](Random& random) {
+                std::string str;
+                for (int i = 0; i < 4; i++) {
+                    if (i > 0) {
+                        str.push_back('\n');
+                    }
+                    str += ".data " + std::to_string(random.NextInt(256) - 128);
+                }
+                return PuzzleIoGroups({ StringToNumbers(str + "\n") });
+            },
+            [](const PuzzleIoGroups& input) {
+                PuzzleIoGroups output;
+                for (const auto& sequence : input) {
+                    std::vector<int> values;
+                    for (const auto& line : Split(RemoveAll(NumbersToString(sequence), ".data"), "\n")) {
+                        const std::string value = Trim(line);
+                        if (!value.empty()) {
+                            values.push_back(ParseInt(value));
+                        }
+                    }
+                    output.push_back(values);
+                }
+                return output;
+            },
+            {
+                { StringToNumbers(".data 5\n.data -7\n.data 11\n"), { 5, -7, 11 } },
+            },
+        },
+        {
+            "Parse Subleq Instructions",
+            { { StringToNumbers("subleq 7 253 255\nsubleq 7 7 0\n") } },
+            [](Random& random) {
+                std::string str;
+                for (int i = 0; i < 3; i++) {
+                    if (i > 0) {
+                        str.push_back('\n');
+                    }
+
+                    str += "subleq";
+                    for (int j = 0; j < 3; j++) {
+                        str += " " + std::to_string(random.NextInt(256));
+                    }
+                }
+                return PuzzleIoGroups({ StringToNumbers(str + "\n") });
+            },
+            [](const PuzzleIoGroups& input) {
+                PuzzleIoGroups output;
+                for (const auto& sequence : input) {
+                    std::vector<int> values;
+                    for (const auto& token : Split(RemoveAll(NumbersToString(sequence), "subleq"), " \n")) {
+                        const std::string value = Trim(token);
+                        if (!value.empty()) {
+                            values.push_back(UnsignedToSigned(static_cast<uint8_t>(ParseInt(value))));
+                        }
+                    }
+                    output.push_back(values);
+                }
+                return output;
+            },
+            {
+                { StringToNumbers("subleq 9 253 3\nsubleq 254 9 6\nsubleq 9 9 0\n"), { 9, -3, 3, -2, 9, 6, 9, 9, 0 } },
+            },
+        },
+        {
+            "Self-Hosting",
+            {
+                { StringToNumbers("subleq 18 17 3\nsubleq 17 18 6\nsubleq 254 17 9\nsubleq 16 15 255\nsubleq 18 18 0\n.data 1\n.data 5\n.data -1\n.data 0\n") },
+            },
+            [](Random& random) {
+                const int primes[] = { 1, -3, 5, -7, 11, -13, 17, -19 };
+                const int x = primes[random.NextInt(8)];
+                const int y = primes[random.NextInt(8)];
+                const int addresses[] = { 16, 17 };
+                const int a1 = addresses[random.NextInt(2)];
+                const int a2 = addresses[random.NextInt(2)];
+                const int a3 = addresses[random.NextInt(2)];
+                const int c1 = ((random.NextDouble() * 2) >= 1) ? 9 : 3;
+                const int c2 = ((random.NextDouble() * 2) >= 1) ? 9 : 6;
+                const std::string first = "subleq 15 " + std::to_string(a1) + " " + std::to_string(c1) + "\n"
+                    + "subleq 15 " + std::to_string(a2) + " " + std::to_string(c2) + "\n"
+                    + "subleq 15 " + std::to_string(a3) + " 9\n"
+                    + "subleq 254 15 12\n"
+                    + "subleq 15 15 255\n"
+                    + ".data " + std::to_string(x) + "\n"
+                    + ".data " + std::to_string(y) + "\n"
+                    + ".data 0\n";
+
+                const std::string second = std::string("subleq 18 17 3\nsubleq 17 18 6\nsubleq 254 17 9\nsubleq 16 15 255\nsubleq 18 18 0\n.data 1\n.data 5\n")
+                    + ".data -" + std::to_string(random.NextInt(3) + 1) + "\n"
+                    + ".data 0\n";
+
+                return PuzzleIoGroups({ StringToNumbers(first), StringToNumbers(second) });
+            },
+            RunSelfHostingTests,
+            {
+                { StringToNumbers("subleq 10 9 3\nsubleq 10 9 6\nsubleq 254 10 255\n\n.data -9\n.data 0\n"), { -18 } },
+            },
+        },
+        {
+            "Self-Hosting Part 2",
+            {
+                {
+                    StringToNumbers("subleq 8 0 3\nsubleq 254 8 6\nsubleq 1 11 0\nsubleq 15 0 255\nsubleq 8 8 0\n.data 15\n"),
+                    StringToNumbers("subleq 8 0 3\nsubleq 254 8 6\nsubleq 1 11 0\nsubleq 15 2 255\nsubleq 8 8 0\n.data 15\n"),
+                    StringToNumbers("subleq 8 0 3\nsubleq 254 8 6\nsubleq 1 11 0\nsubleq 15 5 255\nsubleq 8 8 0\n.data 15\n"),
+
+                    // Output every other byte
+                    StringToNumbers("subleq 254 0 3\nsubleq 1 12 6\nsubleq 14 12 0\nsubleq 15 15 255\n.data -2\n.data 1\n.data -11\n.data 0\n"),
+                },
+            },
+            [](Random& random) {
+                PuzzleIoGroups result;
+                for (int i = 0; i < 2; i++) {
+                    // Patches reading one byte
+                    const int a = random.NextInt(5) + 1;
+                    const int b = random.NextInt(5) + 1;
+                    result.push_back(StringToNumbers(
+                        "subleq 3 12 3\n"
+                        "subleq " + std::to_string(6 + a) + " 13 6\n"
+                        "subleq " + std::to_string(254 - b) + " " + std::to_string(random.NextInt(10)) + " 9\n"
+                        "subleq 14 14 255\n"
+                        ".data " + std::to_string(a) + "\n"
+                        ".data -" + std::to_string(b) + "\n"
+                        ".data 0\n"));
+                }
+
+                // Patches two instructions
+                const int mask = random.NextInt(30) + 20;
+                const int output = random.NextInt(30) + 20;
+                result.push_back(StringToNumbers(
+                    "subleq 9 16 3\n"
+                    "subleq 0 18 6\n"
+                    "subleq 17 18 0\n"
+                    ".data " + std::to_string(UnsignedToSigned(static_cast<uint8_t>(254 + mask))) + "\n"
+                    ".data " + std::to_string(15 + mask) + "\n"
+                    ".data " + std::to_string(12 + mask) + "\n"
+                    ".data " + std::to_string(15 + mask) + "\n"
+                    ".data " + std::to_string(15 + mask) + "\n"
+                    ".data " + std::to_string(UnsignedToSigned(static_cast<uint8_t>(255 + mask))) + "\n"
+                    ".data " + std::to_string(output + mask) + "\n"
+                    ".data " + std::to_string(mask) + "\n"
+                    ".data -6\n"
+                    ".data -1\n"));
+
+                return result;
+            },
+            RunSelfHostingTests,
+            {
+                {
+                    StringToNumbers(
+                        "subleq 254 0 3\n"
+                        "                subleq 1 12 6\n"
+                        "                subleq 14 12 0\n"
+                        "                subleq 15 15 255\n"
+                        "                .data -1\n"
+                        "                .data 1\n"
+                        "                .data -11\n"
+                        "                .data 0\n"
+                        "                "),
+                    { 2, -1, -3, -1, -12, -6, -14, -12, 0, -15, -15, 1 },
+                },
+            },
+        },
+    };
+
+    void Flatten(const std::vector<std::vector<int>>& groups, std::vector<int8_t>& values) {
+        for (const auto& group : groups) {
+            for (int value : group) {
+                values.push_back(static_cast<int8_t>(value));
+            }
+        }
+    }
+
+    // Equivalent to flattenFixedTest
+    TestSet FlattenFixedTest(const std::vector<PuzzleIoRow>& rows) {
+        TestSet testSet;
+        for (const auto& row : rows) {
+            for (int value : row.input) {
+                testSet.input.push_back(static_cast<int8_t>(value));
+            }
+
+            for (int value : row.output) {
+                testSet.output.push_back(static_cast<int8_t>(value));
+            }
+        }
+        return testSet;
+    }
+
+}
+
+const std::vector<Puzzle>& Sic1::GetPuzzles() {
+    return puzzles;
+}
+
+const Puzzle* Sic1::FindPuzzle(const std::string& title) {
+    for (const auto& puzzle : puzzles) {
+        if (title == puzzle.title) {
+            return &puzzle;
+        }
+    }
+    return nullptr;
+}
+
+TestSet Sic1::CreateTestSet(const Puzzle& puzzle, const PuzzleIoGroups& input) {
+    TestSet testSet;
+    Flatten(input, testSet.input);
+    Flatten(puzzle.getExpectedOutput(input), testSet.output);
+    return testSet;
+}
+
+std::vector<TestSet> Sic1::GetFixedTestSets(const Puzzle& puzzle) {
+    std::vector<TestSet> testSets;
+    testSets.push_back(FlattenFixedTest(puzzle.io));
+    if (puzzle.createRandomTest) {
+        for (const auto& fixedInput : puzzle.fixed) {
+            testSets.push_back(CreateTestSet(puzzle, fixedInput));
+        }
+    }
+    return testSets;
+}
+
+void Sic1::AddRandomTestSets(const Puzzle& puzzle, Random& random, std::vector<TestSet>& testSets) {
+    if (!puzzle.createRandomTest) {
+        return;
+    }
+
+    testSets.push_back(CreateTestSet(puzzle, puzzle.createRandomTest(random)));
+
+    // Also add one that's similar to the standard test set (but not identical!)
+    if (puzzle.io.size() > 1) {
+        while (true) {
+            const PuzzleIoGroups moreRandomInputGroups = puzzle.createRandomTest(random);
+            const size_t randomIndex = static_cast<size_t>(random.NextInt(static_cast<int>(moreRandomInputGroups.size())));
+            PuzzleIoRow row = { moreRandomInputGroups[randomIndex], puzzle.getExpectedOutput(moreRandomInputGroups)[randomIndex] };
+
+            // Only the last row is replaced, so comparing it is equivalent to comparing the flattened test sets
+            const PuzzleIoRow& last = puzzle.io.back();
+            if (row.input != last.input && row.output != last.output) {
+                std::vector<PuzzleIoRow> test = puzzle.io;
+                test.back() = std::move(row);
+                testSets.push_back(FlattenFixedTest(test));
+                break;
+            }
+        }
+    }
+}
+
+std::vector<TestSet> Sic1::GeneratePuzzleTest(const Puzzle& puzzle, Random& random) {
+    std::vector<TestSet> testSets = GetFixedTestSets(puzzle);
+    AddRandomTestSets(puzzle, random, testSets);
+    return testSets;
+}
+
+std::vector<TestSet> Sic1::GeneratePuzzleTest(const Puzzle& puzzle, uint64_t seed) {
+    Random random(seed);
+    return GeneratePuzzleTest(puzzle, random);
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "verifier.h"
+
+// Native port of the puzzle definitions and test generation in shared/puzzles.ts
+namespace Sic1 {
+    // Seedable source of uniformly distributed numbers in [0, 1), standing in for Math.random().
+    //
+    // This is counter-based (SplitMix64): the n-th number only depends on the seed and n, so a (puzzle, seed) pair
+    // always produces the same test sets, independent streams can be derived cheaply (e.g. one per verification
+    // iteration), and there is no state to share between threads.
+    //
+    // Optionally, numbers can be recorded on (and replayed from) a tape: the first numbers come from the tape, and any
+    // numbers generated past its end are appended to it. Replaying an edited tape makes a test generator produce a
+    // slightly different test that is still one it could have generated (see inputsearch.h).
+    class Random {
+    public:
+        explicit Random(uint64_t seed, uint64_t counter = 0)
+            : m_seed(seed), m_counter(counter), m_tape(nullptr) {
+        }
+
+        Random(uint64_t seed, std::vector<uint64_t>* tape)
+            : m_seed(seed), m_counter(0), m_tape(tape) {
+        }
+
+        // Derives the seed of an independent stream (e.g. for one iteration) from a parent seed
+        static uint64_t DeriveSeed(uint64_t seed, uint64_t stream) {
+            return Mix(seed ^ Mix(stream + golden));
+        }
+
+        uint64_t GetSeed() const {
+            return m_seed;
+        }
+
+        // Number of values generated so far
+        uint64_t GetCounter() const {
+            return m_counter;
+        }
+
+        uint64_t NextUInt64() {
+            if (!m_tape) {
+                return Mix(m_seed + (++m_counter) * golden);
+            }
+            else if (m_counter < m_tape->size()) {
+                return (*m_tape)[static_cast<size_t>(m_counter++)];
+            }
+
+            const uint64_t value = Mix(m_seed + (++m_counter) * golden);
+            m_tape->push_back(value);
+            return value;
+        }
+
+        double NextDouble() {
+            // Use the top 53 bits, for a uniformly distributed double in [0, 1)
+            return static_cast<double>(NextUInt64() >> 11) * (1.0 / 9007199254740992.0);
+        }
+
+        // Equivalent to Math.floor(Math.random() * count)
+        int NextInt(int count) {
+            return static_cast<int>(NextDouble() * count);
+        }
+
+    private:
+        static constexpr uint64_t golden = 0x9e3779b97f4a7c15ull;
+
+        static uint64_t Mix(uint64_t z) {
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            return z ^ (z >> 31);
+        }
+
+        uint64_t m_seed;
+        uint64_t m_counter;
+        std::vector<uint64_t>* m_tape;
+    };
+
+    // One group of values per row (e.g. the values read or written for one row of a puzzle's io table)
+    typedef std::vector<std::vector<int>> PuzzleIoGroups;
+
+    typedef struct {
+        std::vector<int> input;
+        std::vector<int> output;
+    } PuzzleIoRow;
+
+    typedef struct {
+        const char* title;
+
+        // Extra tests (createRandomTest and getExpectedOutput are null if the puzzle has no extra tests)
+        std::vector<PuzzleIoGroups> fixed;
+        PuzzleIoGroups (*createRandomTest)(Random& random);
+        PuzzleIoGroups (*getExpectedOutput)(const PuzzleIoGroups& input);
+
+        std::vector<PuzzleIoRow> io;
+    } Puzzle;
+
+    // Equivalent to puzzleFlatArray
+    const std::vector<Puzzle>& GetPuzzles();
+
+    // Returns null if there is no puzzle with the given title
+    const Puzzle* FindPuzzle(const std::string& title);
+
+    // Flattens a generated input (and its expected output) into a test set
+    TestSet CreateTestSet(const Puzzle& puzzle, const PuzzleIoGroups& input);
+
+    // Test sets that are the same every time: the standard test set (from the io table) and any fixed test sets
+    std::vector<TestSet> GetFixedTestSets(const Puzzle& puzzle);
+
+    // Appends the randomly generated test sets (the random test set and, if the io table has multiple rows, one that
+    // is similar to the standard test set)
+    void AddRandomTestSets(const Puzzle& puzzle, Random& random, std::vector<TestSet>& testSets);
+
+    // Equivalent to generatePuzzleTest: fixed test sets, followed by random ones
+    std::vector<TestSet> GeneratePuzzleTest(const Puzzle& puzzle, Random& random);
+
+    // Same as above, but with a new generator; a given (puzzle, seed) pair always produces the same test sets
+    std::vector<TestSet> GeneratePuzzleTest(const Puzzle& puzzle, uint64_t seed);
+}
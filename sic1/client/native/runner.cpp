@@ -0,0 +1,102 @@
+#include "runner.h"
+
+#include <algorithm>
+#include <cstdint>
+
+using namespace Sic1;
+
+// Supplies input and collects output the way the IDE does
+class RunSession::Io {
+public:
+    explicit Io(RunSession& session)
+        : m_session(session) {
+    }
+
+    bool TryReadInput(uint8_t& value) {
+        // Note: Unlike verification, the IDE supplies zeros once the input has been exhausted
+        const size_t index = m_session.m_inputIndex++;
+        value = (index < m_session.m_input.size()) ? static_cast<uint8_t>(m_session.m_input[index]) : 0;
+        return true;
+    }
+
+    void WriteOutput(int8_t value) {
+        std::vector<int8_t>& output = m_session.m_output;
+        if (!m_session.m_expectedOutput) {
+            output.push_back(value);
+        }
+        else if (output.size() < m_session.m_expectedOutput->size()) {
+            if (value != (*m_session.m_expectedOutput)[output.size()]) {
+                m_session.m_correct = false;
+            }
+            output.push_back(value);
+        }
+    }
+
+private:
+    RunSession& m_session;
+};
+
+RunSession::RunSession(const std::vector<uint8_t>& bytes, std::vector<int8_t> input, std::optional<std::vector<int8_t>> expectedOutput)
+    : m_emulator(bytes),
+    m_input(std::move(input)),
+    m_expectedOutput(std::move(expectedOutput)),
+    m_inputIndex(0),
+    m_correct(true) {
+}
+
+bool RunSession::IsComplete() const {
+    return m_expectedOutput && m_output.size() == m_expectedOutput->size();
+}
+
+RunResult RunSession::Run(const std::bitset<Constants::memorySize>& breakpoints, uint64_t resumeCycle, uint64_t cycleBudget) {
+    RunResult result = {};
+    const uint64_t cyclesExecutedMax = m_emulator.GetCyclesExecuted() + (std::min)(cycleBudget, UINT64_MAX - m_emulator.GetCyclesExecuted());
+
+    result.reason = RunStopReason::CycleLimit;
+    if (!m_correct) {
+        result.reason = RunStopReason::IncorrectOutput;
+    }
+    else if (!m_emulator.IsRunning()) {
+        result.reason = RunStopReason::Halted;
+    }
+    else if (IsComplete()) {
+        result.reason = RunStopReason::Completed;
+    }
+    else {
+        Io io(*this);
+        while (m_emulator.GetCyclesExecuted() < cyclesExecutedMax) {
+            m_emulator.Step(io);
+
+            if (!m_correct) {
+                result.reason = RunStopReason::IncorrectOutput;
+                break;
+            }
+            else if (!m_emulator.IsRunning()) {
+                result.reason = RunStopReason::Halted;
+                break;
+            }
+            else if (IsComplete()) {
+                result.reason = RunStopReason::Completed;
+                break;
+            }
+            else if (m_emulator.GetCyclesExecuted() > resumeCycle && breakpoints[m_emulator.GetIp()]) {
+                result.reason = RunStopReason::Breakpoint;
+                break;
+            }
+        }
+    }
+
+    result.ip = m_emulator.GetIp();
+    result.cyclesExecuted = m_emulator.GetCyclesExecuted();
+    result.memoryBytesAccessed = m_emulator.GetMemoryBytesAccessed();
+    result.inputIndex = m_inputIndex;
+    result.output = m_output;
+    result.memoryAccessed = m_emulator.GetMemoryAccessed();
+    std::copy(m_emulator.GetMemory(), m_emulator.GetMemory() + Constants::memorySize, result.memory.begin());
+    return result;
+}
+
+RunResult Sic1::RunUntilStopped(const std::vector<uint8_t>& bytes, const RunOptions& options) {
+    RunSession session(bytes, options.input, options.expectedOutput);
+    return session.Run(options.breakpoints, options.resumeCycle, options.cyclesExecutedMax);
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <optional>
+#include <vector>
+#include "predecoded.h"
+
+// Native equivalent of running a program in the IDE (Sic1Ide in client/ts/ide.tsx) at full speed: instead of stepping
+// on a timer (and updating the UI after every step), the program runs until something would stop it, and only the
+// final state is returned
+namespace Sic1 {
+    // Listed in the order they're checked (after each step)
+    enum class RunStopReason : uint8_t {
+        // An output didn't match the expected output
+        IncorrectOutput,
+
+        // Execution halted (i.e. branched past the last instruction address)
+        Halted,
+
+        // All expected outputs were produced
+        Completed,
+
+        // The next instruction has a breakpoint
+        Breakpoint,
+
+        // The cycle budget was used up
+        CycleLimit,
+    };
+
+    typedef struct {
+        std::vector<int8_t> input;
+
+        // If supplied, outputs are checked against this (and outputs past the end are ignored, as in the IDE)
+        std::optional<std::vector<int8_t>> expectedOutput;
+
+        // Addresses of instructions with breakpoints (AssembledProgram::breakpoints)
+        std::bitset<Constants::memorySize> breakpoints;
+
+        // Breakpoints are ignored until this many cycles have been executed, so that a paused run can be resumed by
+        // re-running from the start without stopping at the breakpoint it's paused on
+        uint64_t resumeCycle;
+
+        uint64_t cyclesExecutedMax;
+    } RunOptions;
+
+    typedef struct {
+        RunStopReason reason;
+        unsigned int ip;
+        uint64_t cyclesExecuted;
+        unsigned int memoryBytesAccessed;
+
+        // Number of inputs read (reads past the end supply zero, as in the IDE)
+        size_t inputIndex;
+
+        std::vector<int8_t> output;
+        std::array<uint8_t, Constants::memorySize> memory;
+
+        // Addresses accessed (so that a stepping emulator can pick up where this run stopped and keep counting)
+        std::bitset<Constants::memorySize> memoryAccessed;
+    } RunResult;
+
+    // Keeps a run's state between calls, so that a run that doesn't stop (e.g. an infinite loop) can be continued a
+    // slice at a time (e.g. once per UI update) instead of being re-run from the start with an ever larger budget
+    class RunSession {
+    public:
+        RunSession(const std::vector<uint8_t>& bytes, std::vector<int8_t> input, std::optional<std::vector<int8_t>> expectedOutput);
+
+        // Continues until the run stops for any of the reasons above, or until cycleBudget more cycles have been
+        // executed. Breakpoints are only checked after a step (so a run that stopped at a breakpoint continues past
+        // it), and only once more than resumeCycle cycles have been executed. Once the run has produced incorrect
+        // output, halted, or completed, the same result is returned without executing anything
+        RunResult Run(const std::bitset<Constants::memorySize>& breakpoints, uint64_t resumeCycle, uint64_t cycleBudget);
+
+    private:
+        class Io;
+
+        PredecodedEmulator m_emulator;
+        const std::vector<int8_t> m_input;
+        const std::optional<std::vector<int8_t>> m_expectedOutput;
+        size_t m_inputIndex;
+        std::vector<int8_t> m_output;
+        bool m_correct;
+
+        bool IsComplete() const;
+    };
+
+    // Runs a program from the start until it stops for any of the reasons above
+    RunResult RunUntilStopped(const std::vector<uint8_t>& bytes, const RunOptions& options);
+}
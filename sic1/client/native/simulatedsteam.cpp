@@ -0,0 +1,235 @@
+#include "simulatedsteam.h"
+
+#include <algorithm>
+#include <utility>
+
+using namespace Sic1;
+
+SimulatedSteamApi::SimulatedSteamApi(uint64_t seed, std::string userName)
+    : m_random(seed),
+    m_userName(std::move(userName)),
+    m_latencies{},
+    m_offline(false),
+    m_nextCall(1),
+    m_callCounts{},
+    m_runCallbacksCount(0) {
+}
+
+void SimulatedSteamApi::SetLatency(SteamCallType type, Latency latency) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_latencies[static_cast<size_t>(type)] = latency;
+}
+
+void SimulatedSteamApi::SetLatency(Latency latency) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& entry : m_latencies) {
+        entry = latency;
+    }
+}
+
+void SimulatedSteamApi::SetOffline(bool offline) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_offline = offline;
+}
+
+void SimulatedSteamApi::AddFriendScore(const std::string& leaderboardName, const std::string& friendName, int score) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_leaderboards[GetOrAddLeaderboard(leaderboardName) - 1].friendScores[friendName] = score;
+}
+
+std::optional<int> SimulatedSteamApi::GetUserScore(const std::string& leaderboardName) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const Leaderboard* leaderboard = FindLeaderboardByName(leaderboardName);
+    return leaderboard ? leaderboard->userScore : std::nullopt;
+}
+
+std::vector<int> SimulatedSteamApi::GetUserScoreDetails(const std::string& leaderboardName) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const Leaderboard* leaderboard = FindLeaderboardByName(leaderboardName);
+    return leaderboard ? leaderboard->userScoreDetails : std::vector<int>();
+}
+
+uint64_t SimulatedSteamApi::GetCallCount(SteamCallType type) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_callCounts[static_cast<size_t>(type)];
+}
+
+uint64_t SimulatedSteamApi::GetRunCallbacksCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_runCallbacksCount;
+}
+
+size_t SimulatedSteamApi::GetPendingCallCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pendingCalls.size();
+}
+
+void SimulatedSteamApi::SetResultHandler(ResultHandler handler) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_handler = std::move(handler);
+}
+
+void SimulatedSteamApi::RunCallbacks() {
+    std::vector<std::pair<SteamCallHandle, SteamCallResult>> results;
+    ResultHandler handler;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_runCallbacksCount++;
+
+        // Complete calls in the order their latencies elapsed
+        const Clock::time_point now = Clock::now();
+        const auto completed = std::stable_partition(m_pendingCalls.begin(), m_pendingCalls.end(), [&](const PendingCall& call) {
+            return call.completionTime > now;
+        });
+
+        std::stable_sort(completed, m_pendingCalls.end(), [](const PendingCall& a, const PendingCall& b) {
+            return a.completionTime < b.completionTime;
+        });
+
+        for (auto call = completed; call != m_pendingCalls.end(); ++call) {
+            results.emplace_back(call->call, Complete(*call));
+        }
+
+        m_pendingCalls.erase(completed, m_pendingCalls.end());
+        handler = m_handler;
+    }
+
+    // Note: Results are delivered without holding the lock, so handlers can start more calls
+    if (handler) {
+        for (const auto& [call, result] : results) {
+            handler(call, result);
+        }
+    }
+}
+
+SteamCallHandle SimulatedSteamApi::FindLeaderboard(const std::string& name) {
+    PendingCall call = {};
+    call.type = SteamCallType::FindLeaderboard;
+    call.name = name;
+    return Start(std::move(call));
+}
+
+SteamCallHandle SimulatedSteamApi::DownloadFriendLeaderboardEntries(SteamLeaderboardHandle leaderboard) {
+    PendingCall call = {};
+    call.type = SteamCallType::DownloadFriendLeaderboardEntries;
+    call.leaderboard = leaderboard;
+    return Start(std::move(call));
+}
+
+SteamCallHandle SimulatedSteamApi::UploadLeaderboardScore(SteamLeaderboardHandle leaderboard, int score, const std::vector<int>& details) {
+    PendingCall call = {};
+    call.type = SteamCallType::UploadLeaderboardScore;
+    call.leaderboard = leaderboard;
+    call.score = score;
+    call.details = details;
+    return Start(std::move(call));
+}
+
+SteamCallHandle SimulatedSteamApi::StoreStats() {
+    PendingCall call = {};
+    call.type = SteamCallType::StoreStats;
+    return Start(std::move(call));
+}
+
+SteamCallHandle SimulatedSteamApi::RequestCurrentStats() {
+    PendingCall call = {};
+    call.type = SteamCallType::RequestCurrentStats;
+    return Start(std::move(call));
+}
+
+bool SimulatedSteamApi::GetAchievement(const std::string& achievementId) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_achievements.count(achievementId) > 0;
+}
+
+void SimulatedSteamApi::SetAchievement(const std::string& achievementId) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_achievements.insert(achievementId);
+}
+
+SteamCallHandle SimulatedSteamApi::Start(PendingCall call) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const Latency& latency = m_latencies[static_cast<size_t>(call.type)];
+    const auto jitter = (latency.jitter.count() > 0)
+        ? std::chrono::microseconds(static_cast<int64_t>(m_random() % static_cast<uint64_t>(latency.jitter.count() + 1)))
+        : std::chrono::microseconds(0);
+
+    call.call = m_nextCall++;
+    call.completionTime = Clock::now() + latency.latency + jitter;
+    m_callCounts[static_cast<size_t>(call.type)]++;
+    m_pendingCalls.push_back(std::move(call));
+    return m_pendingCalls.back().call;
+}
+
+SteamCallResult SimulatedSteamApi::Complete(const PendingCall& call) {
+    SteamCallResult result = {};
+    result.type = call.type;
+    result.status = SteamCallStatus::Succeeded;
+    if (m_offline) {
+        result.status = SteamCallStatus::IoFailed;
+        return result;
+    }
+
+    Leaderboard* leaderboard = (call.leaderboard >= 1 && call.leaderboard <= m_leaderboards.size()) ? &m_leaderboards[static_cast<size_t>(call.leaderboard - 1)] : nullptr;
+    switch (call.type) {
+    case SteamCallType::FindLeaderboard:
+        result.leaderboard = GetOrAddLeaderboard(call.name);
+        break;
+
+    case SteamCallType::DownloadFriendLeaderboardEntries:
+        if (!leaderboard) {
+            result.status = SteamCallStatus::Failed;
+            break;
+        }
+
+        for (const auto& [name, score] : leaderboard->friendScores) {
+            result.rows.push_back({ name, score });
+        }
+
+        if (leaderboard->userScore) {
+            result.rows.push_back({ m_userName, *leaderboard->userScore });
+        }
+
+        std::stable_sort(result.rows.begin(), result.rows.end(), [order = GetLeaderboardSortOrder(leaderboard->name)](const FriendLeaderboardRow& a, const FriendLeaderboardRow& b) {
+            return IsBetterScore(order, a.score, b.score);
+        });
+        break;
+
+    case SteamCallType::UploadLeaderboardScore:
+        if (!leaderboard) {
+            result.status = SteamCallStatus::Failed;
+            break;
+        }
+
+        // Keep the best score (according to the leaderboard's sort order)
+        if (!leaderboard->userScore || IsBetterScore(GetLeaderboardSortOrder(leaderboard->name), call.score, *leaderboard->userScore)) {
+            leaderboard->userScore = call.score;
+            leaderboard->userScoreDetails = call.details;
+            result.scoreChanged = true;
+        }
+        break;
+
+    case SteamCallType::StoreStats:
+    case SteamCallType::RequestCurrentStats:
+        break;
+    }
+    return result;
+}
+
+const SimulatedSteamApi::Leaderboard* SimulatedSteamApi::FindLeaderboardByName(const std::string& name) const {
+    const auto leaderboard = std::find_if(m_leaderboards.begin(), m_leaderboards.end(), [&](const Leaderboard& leaderboard) {
+        return leaderboard.name == name;
+    });
+    return (leaderboard != m_leaderboards.end()) ? &*leaderboard : nullptr;
+}
+
+SteamLeaderboardHandle SimulatedSteamApi::GetOrAddLeaderboard(const std::string& name) {
+    const Leaderboard* existing = FindLeaderboardByName(name);
+    if (existing) {
+        return static_cast<SteamLeaderboardHandle>(existing - m_leaderboards.data()) + 1;
+    }
+
+    Leaderboard& leaderboard = m_leaderboards.emplace_back();
+    leaderboard.name = name;
+    return static_cast<SteamLeaderboardHandle>(m_leaderboards.size());
+}
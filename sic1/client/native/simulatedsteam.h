@@ -0,0 +1,103 @@
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+#include "steamapi.h"
+
+namespace Sic1 {
+    // In-process stand-in for Steam: calls complete after a simulated (configurable, randomly jittered) latency, once
+    // RunCallbacks is called after that. Leaderboards are created on demand, keep the lowest score uploaded (SIC-1's
+    // leaderboards are for cycles and bytes), and list the user's own score along with any friends' scores.
+    class SimulatedSteamApi : public SteamApi {
+    public:
+        typedef std::chrono::steady_clock Clock;
+
+        typedef struct {
+            std::chrono::microseconds latency;
+
+            // Each call takes up to this much longer (uniformly distributed)
+            std::chrono::microseconds jitter;
+        } Latency;
+
+        explicit SimulatedSteamApi(uint64_t seed = 0, std::string userName = "User");
+
+        // Applies to calls started afterwards
+        void SetLatency(SteamCallType type, Latency latency);
+        void SetLatency(Latency latency);
+
+        // While offline, calls fail (with IoFailed) once their latency has elapsed
+        void SetOffline(bool offline);
+
+        void AddFriendScore(const std::string& leaderboardName, const std::string& friendName, int score);
+
+        // The user's best uploaded score, if any
+        std::optional<int> GetUserScore(const std::string& leaderboardName) const;
+
+        // Details uploaded with the user's best score
+        std::vector<int> GetUserScoreDetails(const std::string& leaderboardName) const;
+
+        uint64_t GetCallCount(SteamCallType type) const;
+        uint64_t GetRunCallbacksCount() const;
+
+        // Calls that have been started, but whose results haven't been delivered yet
+        size_t GetPendingCallCount() const;
+
+        // SteamApi
+        void SetResultHandler(ResultHandler handler) override;
+        void RunCallbacks() override;
+        SteamCallHandle FindLeaderboard(const std::string& name) override;
+        SteamCallHandle DownloadFriendLeaderboardEntries(SteamLeaderboardHandle leaderboard) override;
+        SteamCallHandle UploadLeaderboardScore(SteamLeaderboardHandle leaderboard, int score, const std::vector<int>& details) override;
+        SteamCallHandle StoreStats() override;
+        SteamCallHandle RequestCurrentStats() override;
+        bool GetAchievement(const std::string& achievementId) override;
+        void SetAchievement(const std::string& achievementId) override;
+
+    private:
+        typedef struct {
+            std::string name;
+            std::map<std::string, int> friendScores;
+            std::optional<int> userScore;
+            std::vector<int> userScoreDetails;
+        } Leaderboard;
+
+        // Note: Results are computed when calls complete, so calls see the effects of calls that completed before
+        // them (e.g. downloads include uploads that have completed)
+        typedef struct {
+            SteamCallHandle call;
+            SteamCallType type;
+            Clock::time_point completionTime;
+            SteamLeaderboardHandle leaderboard;
+            std::string name;
+            int score;
+            std::vector<int> details;
+        } PendingCall;
+
+        SteamCallHandle Start(PendingCall call);
+        SteamCallResult Complete(const PendingCall& call);
+        const Leaderboard* FindLeaderboardByName(const std::string& name) const;
+        SteamLeaderboardHandle GetOrAddLeaderboard(const std::string& name);
+
+        mutable std::mutex m_mutex;
+        std::mt19937_64 m_random;
+        std::string m_userName;
+        ResultHandler m_handler;
+        Latency m_latencies[steamCallTypeCount];
+        bool m_offline;
+
+        // Leaderboard handles are indexes + 1
+        std::vector<Leaderboard> m_leaderboards;
+        std::set<std::string> m_achievements;
+
+        SteamCallHandle m_nextCall;
+        std::vector<PendingCall> m_pendingCalls;
+        uint64_t m_callCounts[steamCallTypeCount];
+        uint64_t m_runCallbacksCount;
+    };
+}
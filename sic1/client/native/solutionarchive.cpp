@@ -0,0 +1,378 @@
+#include "solutionarchive.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+
+using namespace Sic1;
+
+namespace {
+    constexpr char archiveMagic[8] = { 'S', 'I', 'C', '1', 'A', 'R', 'C', 'H' };
+    constexpr uint32_t archiveVersion = 1;
+
+    // Written in native byte order, to detect archives from (or on) big-endian machines
+    constexpr uint32_t byteOrderMark = 0x01020304;
+
+    // Column values for null statistics
+    constexpr uint64_t cyclesNull = UINT64_MAX;
+    constexpr uint32_t bytesNull = UINT32_MAX;
+
+    enum Section : unsigned int {
+        SectionPuzzles,
+        SectionUserIds,
+        SectionFoci,
+        SectionCycles,
+        SectionBytes,
+        SectionProgramOffsets,
+        SectionSources,
+        SectionTimes,
+        SectionStrings,
+        SectionStringData,
+        SectionProgramData,
+        SectionCount,
+    };
+
+    typedef struct {
+        uint64_t offset;
+        uint64_t size;
+    } SectionEntry;
+
+    typedef struct {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrder;
+        uint64_t fileSize;
+        uint32_t solutionCount;
+        uint32_t puzzleCount;
+        uint32_t stringCount;
+        uint32_t reserved;
+        SectionEntry sections[SectionCount];
+    } ArchiveHeader;
+
+    constexpr size_t sectionAlignment = 8;
+
+    size_t Align(size_t offset) {
+        return (offset + sectionAlignment - 1) & ~(sectionAlignment - 1);
+    }
+
+    [[noreturn]] void ThrowCorrupt(const char* message) {
+        throw std::runtime_error(std::string("Corrupt solution archive: ") + message);
+    }
+
+    uint32_t CheckedSize(size_t size) {
+        if (size >= UINT32_MAX) {
+            throw std::runtime_error("Solution archive is too large");
+        }
+        return static_cast<uint32_t>(size);
+    }
+
+    class StringTable {
+    public:
+        uint32_t Intern(const std::string& value) {
+            const auto inserted = m_indexes.insert({ value, CheckedSize(m_offsets.size()) });
+            if (inserted.second) {
+                m_offsets.push_back(CheckedSize(m_data.size()));
+                m_lengths.push_back(CheckedSize(value.size()));
+                m_data += value;
+            }
+            return inserted.first->second;
+        }
+
+        size_t GetCount() const {
+            return m_offsets.size();
+        }
+
+        std::vector<uint32_t> GetEntries() const {
+            std::vector<uint32_t> entries;
+            for (size_t i = 0; i < m_offsets.size(); i++) {
+                entries.push_back(m_offsets[i]);
+                entries.push_back(m_lengths[i]);
+            }
+            return entries;
+        }
+
+        const std::string& GetData() const {
+            return m_data;
+        }
+
+    private:
+        std::unordered_map<std::string, uint32_t> m_indexes;
+        std::vector<uint32_t> m_offsets;
+        std::vector<uint32_t> m_lengths;
+        std::string m_data;
+    };
+
+    template<typename T>
+    const T* GetSection(const uint8_t* data, const ArchiveHeader& header, Section section, size_t count) {
+        if (header.sections[section].size != count * sizeof(T)) {
+            ThrowCorrupt("unexpected section size");
+        }
+        return reinterpret_cast<const T*>(data + header.sections[section].offset);
+    }
+}
+
+Solution Sic1::CopySolution(const SolutionView& view) {
+    Solution solution;
+    solution.puzzleTitle = view.puzzleTitle;
+    solution.userId = view.userId;
+    solution.focus = view.focus;
+    solution.cycles = view.cycles;
+    solution.bytes = view.bytes;
+    solution.program.assign(view.program, view.program + view.programSize);
+    solution.source = view.source;
+    solution.time = view.time;
+    return solution;
+}
+
+SolutionArchive::SolutionArchive(const std::string& path)
+    : m_file(path) {
+    const uint8_t* data = m_file.GetData();
+    const size_t size = m_file.GetSize();
+    if (size < sizeof(ArchiveHeader)) {
+        ThrowCorrupt("missing header");
+    }
+
+    ArchiveHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, archiveMagic, sizeof(archiveMagic)) != 0) {
+        ThrowCorrupt("not a solution archive");
+    }
+
+    if (header.version != archiveVersion || header.byteOrder != byteOrderMark) {
+        throw std::runtime_error("Unsupported solution archive version or byte order: " + path);
+    }
+
+    if (header.fileSize != size) {
+        ThrowCorrupt("truncated");
+    }
+
+    for (const auto& section : header.sections) {
+        if ((section.offset % sectionAlignment) != 0 || section.offset > size || section.size > size - section.offset) {
+            ThrowCorrupt("invalid section");
+        }
+    }
+
+    m_solutionCount = header.solutionCount;
+    m_puzzleCount = header.puzzleCount;
+    m_stringCount = header.stringCount;
+    m_puzzles = GetSection<PuzzleEntry>(data, header, SectionPuzzles, m_puzzleCount);
+    m_userIds = GetSection<uint32_t>(data, header, SectionUserIds, m_solutionCount);
+    m_foci = GetSection<uint32_t>(data, header, SectionFoci, m_solutionCount);
+    m_cycles = GetSection<uint64_t>(data, header, SectionCycles, m_solutionCount);
+    m_bytes = GetSection<uint32_t>(data, header, SectionBytes, m_solutionCount);
+    m_programOffsets = GetSection<uint32_t>(data, header, SectionProgramOffsets, m_solutionCount + 1);
+    m_sources = GetSection<uint32_t>(data, header, SectionSources, m_solutionCount);
+    m_times = GetSection<uint32_t>(data, header, SectionTimes, m_solutionCount);
+    m_strings = GetSection<StringEntry>(data, header, SectionStrings, m_stringCount);
+    m_stringData = reinterpret_cast<const char*>(data + header.sections[SectionStringData].offset);
+    m_stringDataSize = static_cast<size_t>(header.sections[SectionStringData].size);
+    m_programData = data + header.sections[SectionProgramData].offset;
+    m_programDataSize = static_cast<size_t>(header.sections[SectionProgramData].size);
+
+    // The puzzle index must cover every solution, in order
+    size_t solutionIndex = 0;
+    for (size_t i = 0; i < m_puzzleCount; i++) {
+        if (m_puzzles[i].firstSolution != solutionIndex || m_puzzles[i].solutionCount > m_solutionCount - solutionIndex) {
+            ThrowCorrupt("invalid puzzle index");
+        }
+        solutionIndex += m_puzzles[i].solutionCount;
+    }
+
+    if (solutionIndex != m_solutionCount) {
+        ThrowCorrupt("invalid puzzle index");
+    }
+}
+
+bool SolutionArchive::IsArchive(const std::string& path) {
+    std::ifstream stream(path, std::ios::binary);
+    char magic[sizeof(archiveMagic)];
+    return stream.read(magic, sizeof(magic)) && std::memcmp(magic, archiveMagic, sizeof(magic)) == 0;
+}
+
+std::string_view SolutionArchive::GetPuzzleTitle(size_t puzzleIndex) const {
+    return GetString(m_puzzles[puzzleIndex].title);
+}
+
+size_t SolutionArchive::GetPuzzleFirstSolution(size_t puzzleIndex) const {
+    return m_puzzles[puzzleIndex].firstSolution;
+}
+
+size_t SolutionArchive::GetPuzzleSolutionCount(size_t puzzleIndex) const {
+    return m_puzzles[puzzleIndex].solutionCount;
+}
+
+size_t SolutionArchive::FindPuzzle(std::string_view title) const {
+    for (size_t i = 0; i < m_puzzleCount; i++) {
+        if (m_puzzles[i].solutionCount > 0 && GetPuzzleTitle(i) == title) {
+            return i;
+        }
+    }
+    return m_puzzleCount;
+}
+
+SolutionView SolutionArchive::GetSolution(size_t index) const {
+    if (index >= m_solutionCount) {
+        throw std::out_of_range("Solution index out of range");
+    }
+
+    // Find the first puzzle whose solutions end after this one (skipping puzzles with no solutions, which end where they
+    // start, and so never contain a solution)
+    const PuzzleEntry* puzzle = std::lower_bound(m_puzzles, m_puzzles + m_puzzleCount, index, [](const PuzzleEntry& entry, size_t value) {
+        return static_cast<size_t>(entry.firstSolution) + entry.solutionCount <= value;
+    });
+
+    const uint32_t programStart = m_programOffsets[index];
+    const uint32_t programEnd = m_programOffsets[index + 1];
+    if (programStart > programEnd || programEnd > m_programDataSize) {
+        ThrowCorrupt("invalid program offset");
+    }
+
+    SolutionView view;
+    view.puzzleTitle = GetString(puzzle->title);
+    view.userId = GetString(m_userIds[index]);
+    view.focus = GetString(m_foci[index]);
+    view.cycles = (m_cycles[index] != cyclesNull) ? std::optional<uint64_t>(m_cycles[index]) : std::nullopt;
+    view.bytes = (m_bytes[index] != bytesNull) ? std::optional<unsigned int>(m_bytes[index]) : std::nullopt;
+    view.program = m_programData + programStart;
+    view.programSize = programEnd - programStart;
+    view.source = GetString(m_sources[index]);
+    view.time = GetString(m_times[index]);
+    return view;
+}
+
+std::vector<Solution> SolutionArchive::ReadSolutions() const {
+    std::vector<Solution> solutions;
+    solutions.reserve(m_solutionCount);
+    for (size_t i = 0; i < m_solutionCount; i++) {
+        solutions.push_back(CopySolution(GetSolution(i)));
+    }
+    return solutions;
+}
+
+std::string_view SolutionArchive::GetString(uint32_t index) const {
+    if (index >= m_stringCount) {
+        ThrowCorrupt("invalid string index");
+    }
+
+    const StringEntry& entry = m_strings[index];
+    if (entry.offset > m_stringDataSize || entry.length > m_stringDataSize - entry.offset) {
+        ThrowCorrupt("invalid string");
+    }
+    return std::string_view(m_stringData + entry.offset, entry.length);
+}
+
+void Sic1::WriteSolutionArchive(const std::string& path, const std::vector<Solution>& solutions) {
+    // Group by puzzle (in order of first appearance)
+    std::vector<std::vector<const Solution*>> puzzleSolutions;
+    std::unordered_map<std::string, size_t> puzzleTitleToIndex;
+    for (const auto& solution : solutions) {
+        const auto inserted = puzzleTitleToIndex.insert({ solution.puzzleTitle, puzzleSolutions.size() });
+        if (inserted.second) {
+            puzzleSolutions.emplace_back();
+        }
+        puzzleSolutions[inserted.first->second].push_back(&solution);
+    }
+
+    StringTable strings;
+    std::vector<uint32_t> puzzles;
+    std::vector<uint32_t> userIds;
+    std::vector<uint32_t> foci;
+    std::vector<uint64_t> cycles;
+    std::vector<uint32_t> bytes;
+    std::vector<uint32_t> programOffsets;
+    std::vector<uint32_t> sources;
+    std::vector<uint32_t> times;
+    std::vector<uint8_t> programData;
+    for (const auto& group : puzzleSolutions) {
+        puzzles.push_back(strings.Intern(group[0]->puzzleTitle));
+        puzzles.push_back(CheckedSize(userIds.size()));
+        puzzles.push_back(CheckedSize(group.size()));
+        puzzles.push_back(0);
+
+        for (const Solution* solution : group) {
+            userIds.push_back(strings.Intern(solution->userId));
+            foci.push_back(strings.Intern(solution->focus));
+            cycles.push_back(solution->cycles.value_or(cyclesNull));
+            bytes.push_back(solution->bytes ? *solution->bytes : bytesNull);
+            programOffsets.push_back(CheckedSize(programData.size()));
+            programData.insert(programData.end(), solution->program.begin(), solution->program.end());
+            sources.push_back(strings.Intern(solution->source));
+            times.push_back(strings.Intern(solution->time));
+        }
+    }
+    programOffsets.push_back(CheckedSize(programData.size()));
+
+    const std::vector<uint32_t> stringEntries = strings.GetEntries();
+    const std::pair<const void*, size_t> sections[SectionCount] = {
+        { puzzles.data(), puzzles.size() * sizeof(uint32_t) },
+        { userIds.data(), userIds.size() * sizeof(uint32_t) },
+        { foci.data(), foci.size() * sizeof(uint32_t) },
+        { cycles.data(), cycles.size() * sizeof(uint64_t) },
+        { bytes.data(), bytes.size() * sizeof(uint32_t) },
+        { programOffsets.data(), programOffsets.size() * sizeof(uint32_t) },
+        { sources.data(), sources.size() * sizeof(uint32_t) },
+        { times.data(), times.size() * sizeof(uint32_t) },
+        { stringEntries.data(), stringEntries.size() * sizeof(uint32_t) },
+        { strings.GetData().data(), strings.GetData().size() },
+        { programData.data(), programData.size() },
+    };
+
+    ArchiveHeader header = {};
+    std::memcpy(header.magic, archiveMagic, sizeof(archiveMagic));
+    header.version = archiveVersion;
+    header.byteOrder = byteOrderMark;
+    header.solutionCount = CheckedSize(userIds.size());
+    header.puzzleCount = CheckedSize(puzzleSolutions.size());
+    header.stringCount = CheckedSize(strings.GetCount());
+
+    size_t offset = Align(sizeof(header));
+    for (unsigned int i = 0; i < SectionCount; i++) {
+        header.sections[i] = { offset, sections[i].second };
+        offset = Align(offset + sections[i].second);
+    }
+    header.fileSize = offset;
+
+    std::vector<uint8_t> buffer(offset, 0);
+    std::memcpy(buffer.data(), &header, sizeof(header));
+    for (unsigned int i = 0; i < SectionCount; i++) {
+        if (sections[i].second > 0) {
+            std::memcpy(buffer.data() + header.sections[i].offset, sections[i].first, sections[i].second);
+        }
+    }
+
+    // Write to a temporary file first, so readers never see a partial archive
+    const std::string temporaryPath = path + ".tmp";
+    {
+        std::ofstream stream(temporaryPath, std::ios::binary | std::ios::trunc);
+        stream.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+        stream.flush();
+        if (!stream) {
+            throw std::runtime_error("Failed to write solution archive: " + temporaryPath);
+        }
+    }
+
+    std::filesystem::rename(temporaryPath, path);
+}
+
+std::vector<Solution> Sic1::ReadSolutions(const std::string& path) {
+    if (SolutionArchive::IsArchive(path)) {
+        return SolutionArchive(path).ReadSolutions();
+    }
+    return ReadSolutionDatabase(path);
+}
+
+bool Sic1::StreamSolutions(const std::string& path, const SolutionCallback& onSolution) {
+    if (SolutionArchive::IsArchive(path)) {
+        const SolutionArchive archive(path);
+        for (size_t i = 0; i < archive.GetSolutionCount(); i++) {
+            if (!onSolution(CopySolution(archive.GetSolution(i)))) {
+                return false;
+            }
+        }
+        return true;
+    }
+    return StreamSolutionDatabase(path, onSolution);
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "mappedfile.h"
+#include "solutiondb.h"
+
+namespace Sic1 {
+    // Solution whose strings and program point directly into an archive (valid as long as the archive is open)
+    typedef struct {
+        std::string_view puzzleTitle;
+        std::string_view userId;
+        std::string_view focus;
+        std::optional<uint64_t> cycles;
+        std::optional<unsigned int> bytes;
+        const uint8_t* program;
+        size_t programSize;
+        std::string_view source;
+        std::string_view time;
+    } SolutionView;
+
+    Solution CopySolution(const SolutionView& view);
+
+    // Compact binary alternative to db.json that is memory-mapped and read in place (without parsing or copying), so
+    // opening an archive takes constant time and memory, regardless of its size.
+    //
+    // Layout (little-endian; all sections are 8-byte aligned):
+    //
+    // * Fixed-size header: magic, version, counts, and the offset and size of each section
+    // * Puzzle index: title, first solution, and solution count for each puzzle (solutions are grouped by puzzle)
+    // * Columns, with one entry per solution: user ID, focus, cycles, bytes, program offset (plus a final entry for
+    //   the end of the last program), source, and time
+    // * String table: offset and length of each string (titles, user IDs, and other strings are interned)
+    // * String data and raw program bytes
+    //
+    // Structure is validated when the archive is opened; indexes within columns are validated when accessed. Both
+    // throw std::runtime_error if the archive is corrupt.
+    class SolutionArchive {
+    public:
+        explicit SolutionArchive(const std::string& path);
+
+        // Returns true if the file exists and starts with an archive header
+        static bool IsArchive(const std::string& path);
+
+        size_t GetSolutionCount() const {
+            return m_solutionCount;
+        }
+
+        size_t GetPuzzleCount() const {
+            return m_puzzleCount;
+        }
+
+        std::string_view GetPuzzleTitle(size_t puzzleIndex) const;
+
+        // Solutions for a puzzle are contiguous, starting at this index
+        size_t GetPuzzleFirstSolution(size_t puzzleIndex) const;
+        size_t GetPuzzleSolutionCount(size_t puzzleIndex) const;
+
+        // Returns GetPuzzleCount() if the archive has no solutions for the puzzle
+        size_t FindPuzzle(std::string_view title) const;
+
+        SolutionView GetSolution(size_t index) const;
+
+        // Copies every solution
+        std::vector<Solution> ReadSolutions() const;
+
+    private:
+        typedef struct {
+            uint32_t title;
+            uint32_t firstSolution;
+            uint32_t solutionCount;
+            uint32_t reserved;
+        } PuzzleEntry;
+
+        typedef struct {
+            uint32_t offset;
+            uint32_t length;
+        } StringEntry;
+
+        std::string_view GetString(uint32_t index) const;
+
+        MappedFile m_file;
+        size_t m_solutionCount;
+        size_t m_puzzleCount;
+        size_t m_stringCount;
+
+        const PuzzleEntry* m_puzzles;
+        const uint32_t* m_userIds;
+        const uint32_t* m_foci;
+        const uint64_t* m_cycles;
+        const uint32_t* m_bytes;
+        const uint32_t* m_programOffsets;
+        const uint32_t* m_sources;
+        const uint32_t* m_times;
+        const StringEntry* m_strings;
+        const char* m_stringData;
+        size_t m_stringDataSize;
+        const uint8_t* m_programData;
+        size_t m_programDataSize;
+
+        friend void WriteSolutionArchive(const std::string& path, const std::vector<Solution>& solutions);
+    };
+
+    // Writes solutions to an archive (grouped by puzzle, but otherwise in order)
+    void WriteSolutionArchive(const std::string& path, const std::vector<Solution>& solutions);
+
+    // Reads solutions from either an archive or a database file (db.json)
+    std::vector<Solution> ReadSolutions(const std::string& path);
+
+    // Same as ReadSolutions, but passes solutions to the callback one at a time (see StreamSolutionDatabase); returns
+    // false if the callback stopped reading
+    bool StreamSolutions(const std::string& path, const SolutionCallback& onSolution);
+}
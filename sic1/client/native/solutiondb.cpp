@@ -0,0 +1,559 @@
+#include "solutiondb.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include "json.h"
+#include "puzzles.h"
+
+using namespace Sic1;
+
+namespace {
+    int HexDigitToValue(char c) {
+        if (c >= '0' && c <= '9') {
+            return c - '0';
+        }
+        else if (c >= 'a' && c <= 'f') {
+            return c - 'a' + 10;
+        }
+        else if (c >= 'A' && c <= 'F') {
+            return c - 'A' + 10;
+        }
+        return -1;
+    }
+
+    // Formats seconds since the epoch like Date.prototype.toISOString
+    std::string FormatIsoTime(int64_t seconds) {
+        int64_t days = seconds / 86400;
+        int64_t remainder = seconds % 86400;
+        if (remainder < 0) {
+            remainder += 86400;
+            days--;
+        }
+
+        // Civil from days (proleptic Gregorian calendar)
+        days += 719468;
+        const int64_t era = ((days >= 0) ? days : (days - 146096)) / 146097;
+        const int64_t dayOfEra = days - era * 146097;
+        const int64_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+        const int64_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+        const int64_t monthIndex = (5 * dayOfYear + 2) / 153;
+        const int64_t day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+        const int64_t month = (monthIndex < 10) ? (monthIndex + 3) : (monthIndex - 9);
+        const int64_t year = yearOfEra + era * 400 + ((month <= 2) ? 1 : 0);
+
+        char buffer[64];
+        std::snprintf(buffer, sizeof(buffer), "%04lld-%02lld-%02lldT%02lld:%02lld:%02lld.000Z",
+            static_cast<long long>(year),
+            static_cast<long long>(month),
+            static_cast<long long>(day),
+            static_cast<long long>(remainder / 3600),
+            static_cast<long long>((remainder / 60) % 60),
+            static_cast<long long>(remainder % 60));
+        return buffer;
+    }
+
+    // Splits "Puzzle_<user ID>_<puzzle title>_<focus>" (where no part contains an underscore)
+    bool ParseSolutionDocumentId(const std::string& id, std::string& userId, std::string& puzzleTitle, std::string& focus) {
+        static const std::string prefix = "Puzzle_";
+        if (id.compare(0, prefix.size(), prefix) != 0) {
+            return false;
+        }
+
+        std::string* parts[] = { &userId, &puzzleTitle, &focus };
+        size_t start = prefix.size();
+        for (size_t i = 0; i < 3; i++) {
+            const size_t end = (i < 2) ? id.find('_', start) : id.size();
+            if (end == std::string::npos || end == start || (i == 2 && id.find('_', start) != std::string::npos)) {
+                return false;
+            }
+            *parts[i] = id.substr(start, end - start);
+            start = end + 1;
+        }
+        return true;
+    }
+
+    [[noreturn]] void ThrowUnexpectedType() {
+        throw std::runtime_error("Unexpected JSON value type");
+    }
+
+    // Builds solutions from a database file's events: { [puzzleTitle]: { [userId]: { [focus]: { cycles, ... } } } }
+    class SolutionDatabaseHandler : public JsonHandler {
+    public:
+        explicit SolutionDatabaseHandler(const SolutionCallback& onSolution)
+            : m_onSolution(onSolution), m_depth(0) {
+        }
+
+        bool OnStartObject() override {
+            CheckValue(true, true);
+            if (m_depth == 3) {
+                m_solution = Solution();
+                m_solution.puzzleTitle = m_names[0];
+                m_solution.userId = m_names[1];
+                m_solution.focus = m_names[2];
+            }
+
+            m_depth++;
+            return true;
+        }
+
+        bool OnPropertyName(const std::string& name) override {
+            if (m_depth <= 4) {
+                m_names[m_depth - 1] = name;
+            }
+            return true;
+        }
+
+        bool OnEndObject() override {
+            m_depth--;
+            return (m_depth == 3) ? m_onSolution(std::move(m_solution)) : true;
+        }
+
+        bool OnStartArray() override {
+            CheckValue(false, true);
+            m_depth++;
+            return true;
+        }
+
+        bool OnEndArray() override {
+            m_depth--;
+            return true;
+        }
+
+        bool OnString(const std::string& value) override {
+            const std::string* field = CheckValue(false, false);
+            if (!field) {
+                return true;
+            }
+
+            if (*field == "program") {
+                m_solution.program = UnhexifyBytes(value);
+            }
+            else if (*field == "source") {
+                m_solution.source = value;
+            }
+            else if (*field == "time") {
+                m_solution.time = value;
+            }
+            else {
+                ThrowUnexpectedType();
+            }
+            return true;
+        }
+
+        bool OnNumber(double value) override {
+            const std::string* field = CheckValue(false, false);
+            if (!field) {
+                return true;
+            }
+
+            if (*field == "cycles") {
+                m_solution.cycles = static_cast<uint64_t>(value);
+            }
+            else if (*field == "bytes") {
+                m_solution.bytes = static_cast<unsigned int>(value);
+            }
+            else {
+                ThrowUnexpectedType();
+            }
+            return true;
+        }
+
+        bool OnBoolean(bool /*value*/) override {
+            if (CheckValue(false, false)) {
+                ThrowUnexpectedType();
+            }
+            return true;
+        }
+
+        bool OnNull() override {
+            const std::string* field = CheckValue(false, false);
+            if (!field) {
+                return true;
+            }
+
+            if (*field == "cycles") {
+                m_solution.cycles.reset();
+            }
+            else if (*field == "bytes") {
+                m_solution.bytes.reset();
+            }
+            else if (*field == "program") {
+                m_solution.program.clear();
+            }
+            else if (*field == "source") {
+                m_solution.source.clear();
+            }
+            else if (*field == "time") {
+                m_solution.time.clear();
+            }
+            return true;
+        }
+
+    private:
+        // Everything above a solution's fields must be an object, and known fields can't be containers; returns the
+        // field name if the value is a known field, or null if the value should be ignored
+        const std::string* CheckValue(bool isObject, bool isContainer) const {
+            if (m_depth < 4) {
+                if (!isObject) {
+                    ThrowUnexpectedType();
+                }
+            }
+            else if (m_depth == 4) {
+                static const char* const fields[] = { "cycles", "bytes", "program", "source", "time" };
+                for (const char* field : fields) {
+                    if (m_names[3] == field) {
+                        if (isContainer) {
+                            ThrowUnexpectedType();
+                        }
+                        return &m_names[3];
+                    }
+                }
+            }
+            return nullptr;
+        }
+
+        const SolutionCallback& m_onSolution;
+        unsigned int m_depth;
+
+        // Puzzle title, user ID, focus, and field name
+        std::string m_names[4];
+        Solution m_solution;
+    };
+
+    // Builds solutions from the web leaderboard's archive: { [documentId]: { data: { program, cyclesExecuted,
+    // memoryBytesAccessed, timestamp: { _seconds } }, ... } }, ignoring documents other than solutions to known puzzles
+    class WebArchiveHandler : public JsonHandler {
+    public:
+        explicit WebArchiveHandler(const SolutionCallback& onSolution)
+            : m_onSolution(onSolution), m_depth(0), m_matched(false), m_hasData(false) {
+        }
+
+        bool OnStartObject() override {
+            if (IsField(2, "data")) {
+                // Note: As with JSON.parse, the last duplicate wins
+                m_hasData = true;
+                m_solution.cycles.reset();
+                m_solution.bytes.reset();
+                m_solution.program.clear();
+                m_seconds.reset();
+            }
+            else {
+                CheckValue(true, true);
+            }
+
+            m_depth++;
+            return true;
+        }
+
+        bool OnPropertyName(const std::string& name) override {
+            if (m_depth <= 4) {
+                m_names[m_depth - 1] = name;
+            }
+
+            if (m_depth == 1) {
+                std::string focus;
+                m_solution = Solution();
+                m_matched = ParseSolutionDocumentId(name, m_solution.userId, m_solution.puzzleTitle, focus) && FindPuzzle(m_solution.puzzleTitle);
+                m_hasData = false;
+                if (m_matched) {
+                    m_solution.userId = "web:" + m_solution.userId;
+                    m_solution.source = "web";
+                    if (focus == "cyclesExecuted") {
+                        m_solution.focus = "cycles";
+                    }
+                    else if (focus == "memoryBytesAccessed") {
+                        m_solution.focus = "bytes";
+                    }
+                    else {
+                        throw std::runtime_error("Unknown focus in web archive: " + focus);
+                    }
+                }
+            }
+            return true;
+        }
+
+        bool OnEndObject() override {
+            m_depth--;
+            if (m_depth == 1 && m_matched) {
+                if (!m_hasData) {
+                    throw std::runtime_error("Missing data for web archive document: " + m_names[0]);
+                }
+
+                if (!m_seconds) {
+                    throw std::runtime_error("Missing timestamp in web archive document: " + m_names[0]);
+                }
+
+                m_solution.time = FormatIsoTime(*m_seconds);
+                m_matched = false;
+                return m_onSolution(std::move(m_solution));
+            }
+            return true;
+        }
+
+        bool OnStartArray() override {
+            CheckValue(false, true);
+            m_depth++;
+            return true;
+        }
+
+        bool OnEndArray() override {
+            m_depth--;
+            return true;
+        }
+
+        bool OnString(const std::string& value) override {
+            const std::string* field = CheckValue(false, false);
+            if (field && *field == "program") {
+                m_solution.program = UnhexifyBytes(value);
+            }
+            else if (field) {
+                ThrowUnexpectedType();
+            }
+            return true;
+        }
+
+        bool OnNumber(double value) override {
+            const std::string* field = CheckValue(false, false);
+            if (!field) {
+                return true;
+            }
+
+            if (*field == "cyclesExecuted") {
+                m_solution.cycles = static_cast<uint64_t>(value);
+            }
+            else if (*field == "memoryBytesAccessed") {
+                m_solution.bytes = static_cast<unsigned int>(value);
+            }
+            else if (*field == "_seconds") {
+                m_seconds = static_cast<int64_t>(value);
+            }
+            else {
+                ThrowUnexpectedType();
+            }
+            return true;
+        }
+
+        bool OnBoolean(bool /*value*/) override {
+            if (CheckValue(false, false)) {
+                ThrowUnexpectedType();
+            }
+            return true;
+        }
+
+        bool OnNull() override {
+            const std::string* field = CheckValue(false, false);
+            if (!field) {
+                return true;
+            }
+
+            if (*field == "cyclesExecuted") {
+                m_solution.cycles.reset();
+            }
+            else if (*field == "memoryBytesAccessed") {
+                m_solution.bytes.reset();
+            }
+            else if (*field == "program") {
+                m_solution.program.clear();
+            }
+            else {
+                ThrowUnexpectedType();
+            }
+            return true;
+        }
+
+    private:
+        // Returns true if the current value is a matched document's property at the given depth with the given name
+        // (and is within the document's data, if it's deeper than that)
+        bool IsField(unsigned int depth, const char* name) const {
+            return m_matched && m_depth == depth && m_names[depth - 1] == name && (depth == 2 || m_names[1] == "data");
+        }
+
+        // The root and matched documents must be objects (as must their data and timestamp), and known fields can't be
+        // containers; returns the field name if the value is a known field, or null if the value should be ignored
+        const std::string* CheckValue(bool isObject, bool isContainer) const {
+            if (m_depth == 0 || (m_matched && m_depth == 1) || IsField(2, "data") || IsField(3, "timestamp")) {
+                if (!isObject) {
+                    ThrowUnexpectedType();
+                }
+                return nullptr;
+            }
+
+            const std::string* field = nullptr;
+            static const char* const fields[] = { "cyclesExecuted", "memoryBytesAccessed", "program" };
+            for (const char* name : fields) {
+                if (IsField(3, name)) {
+                    field = &m_names[2];
+                }
+            }
+
+            if (m_matched && m_depth == 4 && m_names[1] == "data" && m_names[2] == "timestamp" && m_names[3] == "_seconds") {
+                field = &m_names[3];
+            }
+
+            if (field && isContainer) {
+                ThrowUnexpectedType();
+            }
+            return field;
+        }
+
+        const SolutionCallback& m_onSolution;
+        unsigned int m_depth;
+
+        // Document ID, document property, data field, and timestamp field
+        std::string m_names[4];
+
+        // True if the current document is a solution to a known puzzle
+        bool m_matched;
+        bool m_hasData;
+        Solution m_solution;
+        std::optional<int64_t> m_seconds;
+    };
+}
+
+std::vector<Solution> Sic1::ReadSolutionDatabase(const std::string& path) {
+    std::vector<Solution> solutions;
+    StreamSolutionDatabase(path, [&](Solution&& solution) {
+        solutions.push_back(std::move(solution));
+        return true;
+    });
+    return solutions;
+}
+
+std::vector<Solution> Sic1::ParseSolutionDatabase(const std::string& text) {
+    std::istringstream stream(text);
+    std::vector<Solution> solutions;
+    StreamSolutionDatabase(stream, [&](Solution&& solution) {
+        solutions.push_back(std::move(solution));
+        return true;
+    });
+    return solutions;
+}
+
+bool Sic1::StreamSolutionDatabase(const std::string& path, const SolutionCallback& onSolution) {
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream) {
+        return true;
+    }
+    return StreamSolutionDatabase(stream, onSolution);
+}
+
+bool Sic1::StreamSolutionDatabase(std::istream& stream, const SolutionCallback& onSolution) {
+    SolutionDatabaseHandler handler(onSolution);
+    return JsonReader(stream).Read(handler);
+}
+
+std::string Sic1::FormatSolutionDatabase(const std::vector<Solution>& solutions) {
+    // Group by puzzle, then user (keeping the order of first appearance, like object properties in JavaScript)
+    typedef std::vector<const Solution*> UserSolutions;
+    typedef std::vector<std::pair<const std::string*, UserSolutions>> PuzzleUsers;
+    std::vector<std::pair<const std::string*, PuzzleUsers>> puzzles;
+    std::map<std::string, size_t> puzzleTitleToIndex;
+    std::map<std::pair<std::string, std::string>, size_t> userToIndex;
+    for (const auto& solution : solutions) {
+        const auto puzzle = puzzleTitleToIndex.insert({ solution.puzzleTitle, puzzles.size() });
+        if (puzzle.second) {
+            puzzles.push_back({ &solution.puzzleTitle, {} });
+        }
+
+        PuzzleUsers& users = puzzles[puzzle.first->second].second;
+        const auto user = userToIndex.insert({ { solution.puzzleTitle, solution.userId }, users.size() });
+        if (user.second) {
+            users.push_back({ &solution.userId, {} });
+        }
+
+        // Note: A later entry for the same focus replaces the earlier one (in the earlier one's position)
+        UserSolutions& foci = users[user.first->second].second;
+        auto existing = std::find_if(foci.begin(), foci.end(), [&](const Solution* other) { return other->focus == solution.focus; });
+        if (existing != foci.end()) {
+            *existing = &solution;
+        }
+        else {
+            foci.push_back(&solution);
+        }
+    }
+
+    std::string text = "{";
+    for (size_t i = 0; i < puzzles.size(); i++) {
+        text += (i > 0) ? "," : "";
+        text += FormatJsonString(*puzzles[i].first) + ":{";
+        const PuzzleUsers& users = puzzles[i].second;
+        for (size_t j = 0; j < users.size(); j++) {
+            text += (j > 0) ? "," : "";
+            text += FormatJsonString(*users[j].first) + ":{";
+            const UserSolutions& foci = users[j].second;
+            for (size_t k = 0; k < foci.size(); k++) {
+                const Solution& solution = *foci[k];
+                text += (k > 0) ? "," : "";
+                text += FormatJsonString(solution.focus) + ":{";
+                text += "\"cycles\":" + (solution.cycles ? std::to_string(*solution.cycles) : std::string("null"));
+                text += ",\"bytes\":" + (solution.bytes ? std::to_string(*solution.bytes) : std::string("null"));
+                text += ",\"program\":" + FormatJsonString(HexifyBytes(solution.program));
+                if (!solution.source.empty()) {
+                    text += ",\"source\":" + FormatJsonString(solution.source);
+                }
+
+                if (!solution.time.empty()) {
+                    text += ",\"time\":" + FormatJsonString(solution.time);
+                }
+                text += "}";
+            }
+            text += "}";
+        }
+        text += "}";
+    }
+
+    text += "}";
+    return text;
+}
+
+void Sic1::WriteSolutionDatabase(const std::string& path, const std::vector<Solution>& solutions) {
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    stream << FormatSolutionDatabase(solutions);
+    stream.flush();
+    if (!stream) {
+        throw std::runtime_error("Failed to write solution database: " + path);
+    }
+}
+
+std::vector<Solution> Sic1::ParseWebArchive(const std::string& text) {
+    std::istringstream stream(text);
+    std::vector<Solution> solutions;
+    StreamWebArchive(stream, [&](Solution&& solution) {
+        solutions.push_back(std::move(solution));
+        return true;
+    });
+    return solutions;
+}
+
+bool Sic1::StreamWebArchive(std::istream& stream, const SolutionCallback& onSolution) {
+    WebArchiveHandler handler(onSolution);
+    return JsonReader(stream).Read(handler);
+}
+
+std::string Sic1::HexifyBytes(const std::vector<uint8_t>& bytes) {
+    static const char digits[] = "0123456789abcdef";
+    std::string text;
+    for (uint8_t byte : bytes) {
+        text.push_back(digits[byte >> 4]);
+        text.push_back(digits[byte & 0xf]);
+    }
+    return text;
+}
+
+std::vector<uint8_t> Sic1::UnhexifyBytes(const std::string& text) {
+    // Note: A trailing odd digit is ignored, as in unhexifyBytes
+    std::vector<uint8_t> bytes;
+    for (size_t i = 0; (i + 1) < text.size(); i += 2) {
+        const int high = HexDigitToValue(text[i]);
+        const int low = HexDigitToValue(text[i + 1]);
+        if (high < 0 || low < 0) {
+            throw std::runtime_error("Invalid hexadecimal program: " + text);
+        }
+        bytes.push_back(static_cast<uint8_t>((high << 4) | low));
+    }
+    return bytes;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Native equivalent of the solution database helpers in tools/cli/shared.ts
+namespace Sic1 {
+    typedef struct {
+        std::string puzzleTitle;
+        std::string userId;
+        std::string focus;
+
+        // Claimed statistics (null in the database when unknown)
+        std::optional<uint64_t> cycles;
+        std::optional<unsigned int> bytes;
+
+        std::vector<uint8_t> program;
+
+        // Metadata
+        std::string source;
+        std::string time;
+    } Solution;
+
+    // Default path of the database (solutionDatabasePath)
+    constexpr const char* solutionDatabasePath = "db.json";
+
+    // Receives solutions one at a time as they're read; returning false stops reading
+    typedef std::function<bool(Solution&& solution)> SolutionCallback;
+
+    // Reads every solution from a database file, in document order (puzzle, then user, then focus); a missing file is
+    // treated as an empty database
+    std::vector<Solution> ReadSolutionDatabase(const std::string& path);
+
+    // Parses the contents of a database file
+    std::vector<Solution> ParseSolutionDatabase(const std::string& text);
+
+    // Same as ReadSolutionDatabase, but passes each solution to the callback as soon as it has been parsed, so memory
+    // use doesn't depend on the size of the database. Returns false if the callback stopped reading. Note that
+    // malformed input is only detected when it's reached, so the callback may already have seen some solutions.
+    bool StreamSolutionDatabase(const std::string& path, const SolutionCallback& onSolution);
+    bool StreamSolutionDatabase(std::istream& stream, const SolutionCallback& onSolution);
+
+    // Formats solutions as a database file (in the same format as JSON.stringify, with puzzles, users, and foci in order
+    // of first appearance); empty sources and times are omitted
+    std::string FormatSolutionDatabase(const std::vector<Solution>& solutions);
+
+    void WriteSolutionDatabase(const std::string& path, const std::vector<Solution>& solutions);
+
+    // Extracts solutions for known puzzles from the web leaderboard's archive (equivalent to
+    // server/utils/archive-to-solutions.ts); other documents are ignored
+    std::vector<Solution> ParseWebArchive(const std::string& text);
+
+    // Streaming equivalent of ParseWebArchive (see StreamSolutionDatabase)
+    bool StreamWebArchive(std::istream& stream, const SolutionCallback& onSolution);
+
+    std::string HexifyBytes(const std::vector<uint8_t>& bytes);
+    std::vector<uint8_t> UnhexifyBytes(const std::string& text);
+}
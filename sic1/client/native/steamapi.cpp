@@ -0,0 +1,21 @@
+#include "steamapi.h"
+
+using namespace Sic1;
+
+namespace {
+    const char* const steamCallTypeNames[steamCallTypeCount] = {
+        "FindLeaderboard",
+        "DownloadFriendLeaderboardEntries",
+        "UploadLeaderboardScore",
+        "StoreStats",
+        "RequestCurrentStats",
+    };
+}
+
+const char* Sic1::GetSteamCallTypeName(SteamCallType type) {
+    return steamCallTypeNames[static_cast<size_t>(type)];
+}
+
+LeaderboardSortOrder Sic1::GetLeaderboardSortOrder(const std::string& name) {
+    return (name == solvedCountLeaderboardName) ? LeaderboardSortOrder::Descending : LeaderboardSortOrder::Ascending;
+}
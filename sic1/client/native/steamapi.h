@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// The parts of the Steamworks API that the client uses (leaderboards and achievements), behind an interface. The
+// Windows client implements it with Steamworks (client/windows/steamworksapi.h); SimulatedSteamApi stands in for it
+// elsewhere, so that the code built on top (e.g. SteamCallbackPump) can be built, tested, and measured without Steam.
+namespace Sic1 {
+    // Stand-ins for SteamAPICall_t and SteamLeaderboard_t
+    typedef uint64_t SteamCallHandle;
+    typedef uint64_t SteamLeaderboardHandle;
+
+    // Same as k_uAPICallInvalid
+    constexpr SteamCallHandle steamCallHandleInvalid = 0;
+
+    enum class SteamCallType : uint8_t {
+        // ISteamUserStats::FindLeaderboard
+        FindLeaderboard,
+
+        // ISteamUserStats::DownloadLeaderboardEntries (friends only)
+        DownloadFriendLeaderboardEntries,
+
+        // ISteamUserStats::UploadLeaderboardScore (keeping the best score)
+        UploadLeaderboardScore,
+
+        // ISteamUserStats::StoreStats, which completes with a UserStatsStored_t callback instead of a call result
+        StoreStats,
+
+        // ISteamUserStats::RequestCurrentStats, which completes with a UserStatsReceived_t callback
+        RequestCurrentStats,
+    };
+
+    constexpr size_t steamCallTypeCount = 5;
+
+    const char* GetSteamCallTypeName(SteamCallType type);
+
+    // See Sic1SteamService.solvedCountLeaderboardName
+    constexpr const char* solvedCountLeaderboardName = "Solved Count";
+
+    // How a leaderboard is sorted (as configured in Steamworks), which determines which of two scores is best. Puzzle
+    // leaderboards (cycles and bytes) are ascending, but the solved count leaderboard is descending.
+    enum class LeaderboardSortOrder : uint8_t {
+        Ascending,
+        Descending,
+    };
+
+    LeaderboardSortOrder GetLeaderboardSortOrder(const std::string& name);
+
+    // True if score is strictly better than other
+    inline bool IsBetterScore(LeaderboardSortOrder order, int score, int other) {
+        return (order == LeaderboardSortOrder::Ascending) ? (score < other) : (score > other);
+    }
+
+    enum class SteamCallStatus : uint8_t {
+        Succeeded,
+
+        // The call result reported an I/O failure (e.g. there's no network connection)
+        IoFailed,
+
+        // The call completed, but reported failure (e.g. the leaderboard wasn't found)
+        Failed,
+
+        // The call was abandoned before it completed (e.g. on shutdown)
+        Aborted,
+    };
+
+    typedef struct {
+        std::string name;
+        int score;
+    } FriendLeaderboardRow;
+
+    typedef struct {
+        SteamCallType type;
+        SteamCallStatus status;
+
+        // FindLeaderboard
+        SteamLeaderboardHandle leaderboard;
+
+        // UploadLeaderboardScore: true if the new score replaced the previous one
+        bool scoreChanged;
+
+        // DownloadFriendLeaderboardEntries
+        std::vector<FriendLeaderboardRow> rows;
+    } SteamCallResult;
+
+    class SteamApi {
+    public:
+        // Receives the results of completed calls, identified by the handles returned when the calls were started
+        typedef std::function<void(SteamCallHandle call, const SteamCallResult& result)> ResultHandler;
+
+        virtual ~SteamApi() {}
+
+        // Note: Results are only delivered from within RunCallbacks (on the thread that calls it)
+        virtual void SetResultHandler(ResultHandler handler) = 0;
+
+        // Equivalent to SteamAPI_RunCallbacks: delivers the results of any calls that have completed
+        virtual void RunCallbacks() = 0;
+
+        // Each of these starts an asynchronous call (from any thread), returning steamCallHandleInvalid if the call
+        // couldn't be started
+        virtual SteamCallHandle FindLeaderboard(const std::string& name) = 0;
+        virtual SteamCallHandle DownloadFriendLeaderboardEntries(SteamLeaderboardHandle leaderboard) = 0;
+        virtual SteamCallHandle UploadLeaderboardScore(SteamLeaderboardHandle leaderboard, int score, const std::vector<int>& details) = 0;
+        virtual SteamCallHandle StoreStats() = 0;
+        virtual SteamCallHandle RequestCurrentStats() = 0;
+
+        // Achievements are cached locally once the current stats have been received, so these are synchronous (and
+        // throw on failure)
+        virtual bool GetAchievement(const std::string& achievementId) = 0;
+        virtual void SetAchievement(const std::string& achievementId) = 0;
+    };
+}
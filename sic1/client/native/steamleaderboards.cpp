@@ -0,0 +1,207 @@
+#include "steamleaderboards.h"
+
+#include <exception>
+#include <utility>
+#include "puzzles.h"
+
+using namespace Sic1;
+
+namespace {
+    const char* const foci[] = {
+        "cycles",
+        "bytes",
+    };
+
+    // Starts a call, completing it with a failure (instead of throwing) if it couldn't be started
+    void StartCall(SteamCallbackPump& pump, SteamCallType type, const std::function<SteamCallHandle(SteamApi&)>& start, const SteamCallbackPump::Completion& completion) {
+        try {
+            pump.Start(type, start, completion);
+        }
+        catch (const std::exception&) {
+            SteamCallResult result = {};
+            result.type = type;
+            result.status = SteamCallStatus::Failed;
+            completion(result);
+        }
+    }
+}
+
+std::vector<std::string> Sic1::GetPuzzleLeaderboardNames() {
+    std::vector<std::string> names;
+    for (const Puzzle& puzzle : GetPuzzles()) {
+        for (const char* focus : foci) {
+            names.push_back(std::string(puzzle.title) + "_" + focus);
+        }
+    }
+
+    names.push_back(solvedCountLeaderboardName);
+    return names;
+}
+
+SteamLeaderboards::SteamLeaderboards(SteamCallbackPump& pump, LeaderboardCache& cache, std::function<void()> onCacheChanged)
+    : m_pump(pump),
+    m_cache(cache),
+    m_onCacheChanged(std::move(onCacheChanged)) {
+}
+
+void SteamLeaderboards::Prefetch(const std::vector<std::string>& names) {
+    for (const std::string& name : names) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_lookups.try_emplace(name).second) {
+                continue;
+            }
+        }
+
+        FindLeaderboard(name);
+    }
+}
+
+void SteamLeaderboards::GetLeaderboard(const std::string& name, LeaderboardCompletion completion) {
+    const std::optional<SteamLeaderboardHandle> cachedHandle = m_cache.GetHandle(name);
+    if (cachedHandle) {
+        completion(SteamCallStatus::Succeeded, *cachedHandle);
+        return;
+    }
+
+    bool started = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const auto [lookup, inserted] = m_lookups.try_emplace(name);
+        lookup->second.push_back(std::move(completion));
+        started = !inserted;
+    }
+
+    if (!started) {
+        FindLeaderboard(name);
+    }
+}
+
+void SteamLeaderboards::GetFriendLeaderboardEntries(const std::string& name, RowsCompletion completion) {
+    const std::optional<LeaderboardCache::CachedRows> cachedRows = m_cache.GetRows(name);
+    if (!cachedRows) {
+        DownloadFriendLeaderboardEntries(name, std::move(completion));
+        return;
+    }
+
+    completion(SteamCallStatus::Succeeded, cachedRows->rows);
+    if (m_cache.IsStale(*cachedRows, LeaderboardCache::Clock::now())) {
+        DownloadFriendLeaderboardEntries(name, nullptr);
+    }
+}
+
+void SteamLeaderboards::UploadLeaderboardScore(const std::string& name, int score, const std::vector<int>& details, UploadCompletion completion) {
+    GetLeaderboard(name, [this, name, score, details, completion = std::move(completion)](SteamCallStatus status, SteamLeaderboardHandle leaderboard) {
+        if (status != SteamCallStatus::Succeeded) {
+            completion(status, false);
+            return;
+        }
+
+        StartCall(m_pump, SteamCallType::UploadLeaderboardScore,
+            [&](SteamApi& steam) { return steam.UploadLeaderboardScore(leaderboard, score, details); },
+            [this, name, completion](const SteamCallResult& result) {
+                // The cached friend leaderboard no longer has the user's best score
+                if (result.status == SteamCallStatus::Succeeded && result.scoreChanged) {
+                    InvalidateFriendLeaderboardEntries(name);
+                }
+
+                completion(result.status, result.scoreChanged);
+            });
+    });
+}
+
+void SteamLeaderboards::InvalidateFriendLeaderboardEntries(const std::string& name) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_rowsGenerations[name]++;
+        m_cache.InvalidateRows(name);
+    }
+
+    if (m_onCacheChanged) {
+        m_onCacheChanged();
+    }
+}
+
+void SteamLeaderboards::FindLeaderboard(const std::string& name) {
+    StartCall(m_pump, SteamCallType::FindLeaderboard,
+        [&](SteamApi& steam) { return steam.FindLeaderboard(name); },
+        [this, name](const SteamCallResult& result) { OnLeaderboardFound(name, result); });
+}
+
+void SteamLeaderboards::OnLeaderboardFound(const std::string& name, const SteamCallResult& result) {
+    if (result.status == SteamCallStatus::Succeeded) {
+        m_cache.SetHandle(name, result.leaderboard);
+        if (m_onCacheChanged) {
+            m_onCacheChanged();
+        }
+    }
+
+    std::vector<LeaderboardCompletion> completions;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const auto lookup = m_lookups.find(name);
+        if (lookup != m_lookups.end()) {
+            completions = std::move(lookup->second);
+            m_lookups.erase(lookup);
+        }
+    }
+
+    for (const LeaderboardCompletion& completion : completions) {
+        completion(result.status, result.leaderboard);
+    }
+}
+
+void SteamLeaderboards::DownloadFriendLeaderboardEntries(const std::string& name, RowsCompletion completion) {
+    uint64_t generation = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const auto [download, inserted] = m_downloads.try_emplace(name);
+        if (completion) {
+            download->second.completions.push_back(std::move(completion));
+        }
+
+        if (!inserted) {
+            return;
+        }
+
+        generation = m_rowsGenerations[name];
+        download->second.generation = generation;
+    }
+
+    GetLeaderboard(name, [this, name, generation](SteamCallStatus status, SteamLeaderboardHandle leaderboard) {
+        if (status != SteamCallStatus::Succeeded) {
+            OnFriendLeaderboardEntriesDownloaded(name, generation, status, {});
+            return;
+        }
+
+        StartCall(m_pump, SteamCallType::DownloadFriendLeaderboardEntries,
+            [&](SteamApi& steam) { return steam.DownloadFriendLeaderboardEntries(leaderboard); },
+            [this, name, generation](const SteamCallResult& result) { OnFriendLeaderboardEntriesDownloaded(name, generation, result.status, result.rows); });
+    });
+}
+
+void SteamLeaderboards::OnFriendLeaderboardEntriesDownloaded(const std::string& name, uint64_t generation, SteamCallStatus status, const std::vector<FriendLeaderboardRow>& rows) {
+    bool cached = false;
+    std::vector<RowsCompletion> completions;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const auto download = m_downloads.find(name);
+        if (download != m_downloads.end()) {
+            completions = std::move(download->second.completions);
+            m_downloads.erase(download);
+        }
+
+        if (status == SteamCallStatus::Succeeded && m_rowsGenerations[name] == generation) {
+            m_cache.SetRows(name, rows, LeaderboardCache::Clock::now());
+            cached = true;
+        }
+    }
+
+    if (cached && m_onCacheChanged) {
+        m_onCacheChanged();
+    }
+
+    for (const RowsCompletion& completion : completions) {
+        completion(status, rows);
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "leaderboardcache.h"
+#include "steamapi.h"
+#include "steampump.h"
+
+namespace Sic1 {
+    // Names of every puzzle's leaderboards (see Sic1SteamService.getLeaderboardName in service.ts), plus the solved count
+    // leaderboard
+    std::vector<std::string> GetPuzzleLeaderboardNames();
+
+    // Leaderboard lookups and friend leaderboard downloads, by name, served from a LeaderboardCache where possible:
+    // cached handles are used as-is, and cached rows are delivered immediately, with stale rows then refreshed in the
+    // background (stale-while-revalidate). Concurrent requests for the same leaderboard share a single call.
+    //
+    // Completions are run either on the calling thread (when served from the cache) or on the pump's thread.
+    class SteamLeaderboards {
+    public:
+        typedef std::function<void(SteamCallStatus status, SteamLeaderboardHandle leaderboard)> LeaderboardCompletion;
+        typedef std::function<void(SteamCallStatus status, const std::vector<FriendLeaderboardRow>& rows)> RowsCompletion;
+        typedef std::function<void(SteamCallStatus status, bool scoreChanged)> UploadCompletion;
+
+        // Note: onCacheChanged is called (on the pump's thread) whenever the cache is updated, e.g. to persist it. Since a
+        // lookup or download is still finishing when it's called, the pump must be stopped before this is destroyed.
+        SteamLeaderboards(SteamCallbackPump& pump, LeaderboardCache& cache, std::function<void()> onCacheChanged = nullptr);
+
+        // Looks up all of the given leaderboards at once, refreshing any cached handles
+        void Prefetch(const std::vector<std::string>& names);
+
+        // Note: Calls that can't be started are completed with a Failed status (on the calling thread)
+        void GetLeaderboard(const std::string& name, LeaderboardCompletion completion);
+        void GetFriendLeaderboardEntries(const std::string& name, RowsCompletion completion);
+
+        // Uploads a score (keeping the best score), dropping any cached rows if the user's score changed
+        void UploadLeaderboardScore(const std::string& name, int score, const std::vector<int>& details, UploadCompletion completion);
+
+        // Drops any cached rows (e.g. after the user's score changed), so that the next request downloads them again
+        void InvalidateFriendLeaderboardEntries(const std::string& name);
+
+    private:
+        typedef struct {
+            std::vector<RowsCompletion> completions;
+
+            // Rows invalidated while they were being downloaded aren't cached
+            uint64_t generation;
+        } RowsDownload;
+
+        void FindLeaderboard(const std::string& name);
+        void OnLeaderboardFound(const std::string& name, const SteamCallResult& result);
+
+        // Downloads rows, for the given completion (if any) and any others that are waiting on the same leaderboard
+        void DownloadFriendLeaderboardEntries(const std::string& name, RowsCompletion completion);
+        void OnFriendLeaderboardEntriesDownloaded(const std::string& name, uint64_t generation, SteamCallStatus status, const std::vector<FriendLeaderboardRow>& rows);
+
+        SteamCallbackPump& m_pump;
+        LeaderboardCache& m_cache;
+        std::function<void()> m_onCacheChanged;
+
+        std::mutex m_mutex;
+
+        // Outstanding lookups (with the requests waiting on each) and downloads, by name
+        std::map<std::string, std::vector<LeaderboardCompletion>> m_lookups;
+        std::map<std::string, RowsDownload> m_downloads;
+        std::map<std::string, uint64_t> m_rowsGenerations;
+    };
+}
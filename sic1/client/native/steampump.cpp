@@ -0,0 +1,183 @@
+#include "steampump.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+using namespace Sic1;
+
+namespace {
+    // Caps the sleep doubling (well past any reasonable maximum)
+    constexpr unsigned int sleepDoublingsMax = 20;
+}
+
+SteamCallbackPump::SteamCallbackPump(SteamApi& api, SteamApi::ResultHandler handler, const SteamPumpSchedule& schedule)
+    : m_api(api),
+    m_handler(std::move(handler)),
+    m_schedule(schedule),
+    m_stopping(false),
+    m_lastActivityTime(Clock::now()),
+    m_activityCount(0),
+    m_pollCount(0) {
+    m_api.SetResultHandler([this](SteamCallHandle call, const SteamCallResult& result) {
+        OnResult(call, result);
+    });
+
+    m_thread = std::thread(&SteamCallbackPump::RunThread, this);
+}
+
+SteamCallbackPump::~SteamCallbackPump() {
+    Stop();
+}
+
+void SteamCallbackPump::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+        m_api.SetResultHandler(nullptr);
+    }
+
+    std::unordered_map<SteamCallHandle, OutstandingCall> abandoned;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        abandoned.swap(m_outstandingCalls);
+    }
+
+    for (const auto& [call, outstanding] : abandoned) {
+        SteamCallResult result = {};
+        result.type = outstanding.type;
+        result.status = SteamCallStatus::Aborted;
+        Deliver(call, result, outstanding.completion);
+    }
+}
+
+SteamCallHandle SteamCallbackPump::Start(SteamCallType type, const std::function<SteamCallHandle(SteamApi&)>& start, Completion completion) {
+    const Clock::time_point startTime = Clock::now();
+    const SteamCallHandle call = start(m_api);
+    if (call == steamCallHandleInvalid) {
+        throw std::runtime_error(std::string("Failed to start Steam call: ") + GetSteamCallTypeName(type));
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    const auto early = m_earlyResults.find(call);
+    if (early != m_earlyResults.end()) {
+        const SteamCallResult result = std::move(early->second);
+        m_earlyResults.erase(early);
+        m_latencies[static_cast<size_t>(type)].Record(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - startTime));
+        lock.unlock();
+
+        Deliver(call, result, completion);
+        return call;
+    }
+
+    if (m_stopping) {
+        // Nothing will poll for the result
+        lock.unlock();
+
+        SteamCallResult result = {};
+        result.type = type;
+        result.status = SteamCallStatus::Aborted;
+        Deliver(call, result, completion);
+        return call;
+    }
+
+    m_outstandingCalls[call] = { type, startTime, std::move(completion) };
+    RecordActivity();
+    lock.unlock();
+
+    m_wake.notify_all();
+    return call;
+}
+
+size_t SteamCallbackPump::GetOutstandingCallCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_outstandingCalls.size();
+}
+
+uint64_t SteamCallbackPump::GetPollCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pollCount;
+}
+
+LatencyHistogram SteamCallbackPump::GetLatencyHistogram(SteamCallType type) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_latencies[static_cast<size_t>(type)];
+}
+
+void SteamCallbackPump::RecordActivity() {
+    m_lastActivityTime = Clock::now();
+    m_activityCount++;
+}
+
+void SteamCallbackPump::RunThread() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    uint64_t activityCount = m_activityCount;
+    unsigned int sleepCount = 0;
+    while (true) {
+        m_wake.wait(lock, [this]() { return m_stopping || !m_outstandingCalls.empty(); });
+        if (m_stopping) {
+            break;
+        }
+
+        // Note: Results are delivered (via OnResult) from within RunCallbacks, so the lock can't be held
+        lock.unlock();
+        m_api.RunCallbacks();
+        lock.lock();
+        m_pollCount++;
+
+        if (m_activityCount != activityCount) {
+            activityCount = m_activityCount;
+            sleepCount = 0;
+        }
+
+        if (m_outstandingCalls.empty()) {
+            continue;
+        }
+        else if (Clock::now() - m_lastActivityTime < m_schedule.spinDuration) {
+            lock.unlock();
+            std::this_thread::yield();
+            lock.lock();
+        }
+        else {
+            const std::chrono::microseconds doubled = m_schedule.sleepInitial * (1ll << (std::min)(sleepCount, sleepDoublingsMax));
+            const std::chrono::microseconds sleep = (std::min)(doubled, m_schedule.sleepMax);
+            sleepCount++;
+
+            // Newly started calls are polled for immediately
+            m_wake.wait_for(lock, sleep, [&]() { return m_stopping || m_activityCount != activityCount; });
+        }
+    }
+}
+
+void SteamCallbackPump::OnResult(SteamCallHandle call, const SteamCallResult& result) {
+    Completion completion;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const auto outstanding = m_outstandingCalls.find(call);
+        if (outstanding == m_outstandingCalls.end()) {
+            m_earlyResults[call] = result;
+            return;
+        }
+
+        m_latencies[static_cast<size_t>(outstanding->second.type)].Record(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - outstanding->second.startTime));
+        completion = std::move(outstanding->second.completion);
+        m_outstandingCalls.erase(outstanding);
+        RecordActivity();
+    }
+
+    Deliver(call, result, completion);
+}
+
+void SteamCallbackPump::Deliver(SteamCallHandle call, const SteamCallResult& result, const Completion& completion) {
+    if (completion) {
+        completion(result);
+    }
+    else if (m_handler) {
+        m_handler(call, result);
+    }
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include "latencyhistogram.h"
+#include "steamapi.h"
+
+namespace Sic1 {
+    // How often SteamCallbackPump polls for results while calls are outstanding: right after a call starts (or a result
+    // arrives), it spins (yielding between polls), and then sleeps between polls, doubling the sleep each time up to a
+    // maximum. While no calls are outstanding, it doesn't poll at all.
+    typedef struct {
+        std::chrono::microseconds spinDuration;
+        std::chrono::microseconds sleepInitial;
+        std::chrono::microseconds sleepMax;
+    } SteamPumpSchedule;
+
+    // Results are noticed within 8 ms (instead of within 200 ms, as with polling every 200 ms)
+    constexpr SteamPumpSchedule steamPumpScheduleDefault = { std::chrono::microseconds(1000), std::chrono::microseconds(1000), std::chrono::microseconds(8000) };
+
+    // Polls every 200 ms (which is what the Windows client used to do), for comparison
+    constexpr SteamPumpSchedule steamPumpScheduleFixed = { std::chrono::microseconds(0), std::chrono::microseconds(200000), std::chrono::microseconds(200000) };
+
+    // Runs Steam callbacks on a dedicated thread while calls are outstanding, delivering each call's result to a handler
+    // (on that thread) and recording each call's latency (from starting the call to delivering its result) by type. Any
+    // number of calls (of any type) can be outstanding at once; they're tracked by call handle.
+    class SteamCallbackPump {
+    public:
+        typedef std::chrono::steady_clock Clock;
+
+        // Receives a single call's result (instead of the pump's handler)
+        typedef std::function<void(const SteamCallResult& result)> Completion;
+
+        // Note: The handler is optional if every call is started with a completion
+        SteamCallbackPump(SteamApi& api, SteamApi::ResultHandler handler, const SteamPumpSchedule& schedule = steamPumpScheduleDefault);
+
+        // Note: Calls that are still outstanding are delivered Aborted results (on the destroying thread)
+        ~SteamCallbackPump();
+
+        SteamCallbackPump(const SteamCallbackPump&) = delete;
+        SteamCallbackPump& operator=(const SteamCallbackPump&) = delete;
+
+        // Starts a call (from any thread) and tracks it until its result has been delivered, either to the completion
+        // (if supplied) or to the pump's handler. Throws if the call couldn't be started.
+        //
+        // Note: If the result arrives before this returns (e.g. while polling for another call), it's delivered on the
+        // calling thread instead.
+        SteamCallHandle Start(SteamCallType type, const std::function<SteamCallHandle(SteamApi&)>& start, Completion completion = nullptr);
+
+        // Stops polling (from any thread other than the pump's), delivering Aborted results for calls that are still
+        // outstanding (on the calling thread). Calls started afterwards are aborted too. Safe to call more than once.
+        void Stop();
+
+        size_t GetOutstandingCallCount() const;
+
+        // Number of times RunCallbacks has been called
+        uint64_t GetPollCount() const;
+
+        LatencyHistogram GetLatencyHistogram(SteamCallType type) const;
+
+    private:
+        typedef struct {
+            SteamCallType type;
+            Clock::time_point startTime;
+            Completion completion;
+        } OutstandingCall;
+
+        void RunThread();
+        void OnResult(SteamCallHandle call, const SteamCallResult& result);
+        void Deliver(SteamCallHandle call, const SteamCallResult& result, const Completion& completion);
+        void RecordActivity();
+
+        SteamApi& m_api;
+        SteamApi::ResultHandler m_handler;
+        const SteamPumpSchedule m_schedule;
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_wake;
+        bool m_stopping;
+        std::unordered_map<SteamCallHandle, OutstandingCall> m_outstandingCalls;
+
+        // Results that arrived before the Start call that started them had finished
+        std::unordered_map<SteamCallHandle, SteamCallResult> m_earlyResults;
+
+        // Calls starting and results arriving restart the schedule
+        Clock::time_point m_lastActivityTime;
+        uint64_t m_activityCount;
+
+        uint64_t m_pollCount;
+        LatencyHistogram m_latencies[steamCallTypeCount];
+
+        std::thread m_thread;
+    };
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <vector>
+#include "emulator.h"
+
+// Small programs for any SubleqMachine, shared by the tests and the benchmark suite
+namespace Sic1 {
+    // Adds pairs of inputs (with the same layout on every machine, so only the I/O addresses differ):
+    //
+    // @loop:
+    // subleq @t, @IN
+    // subleq @t, @IN
+    // subleq @OUT, @t
+    // subleq @t, @t, @loop
+    // @t: .data 0
+    template<typename TMachine>
+    std::vector<typename TMachine::Word> CreateAdditionProgram() {
+        typedef typename TMachine::Word Word;
+        const Word t = 12;
+        const Word in = TMachine::addressInput;
+        const Word out = TMachine::addressOutput;
+        return { t, in, 3, t, in, 6, out, t, 9, t, t, 0, 0 };
+    }
+}
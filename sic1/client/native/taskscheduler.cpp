@@ -0,0 +1,272 @@
+#include "taskscheduler.h"
+
+#include <algorithm>
+#include <string>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace Sic1;
+
+namespace {
+    const char* const taskPriorityNames[] = {
+        "Interactive",
+        "Io",
+        "Network",
+        "Compute",
+    };
+
+    // Worker that the current thread belongs to, if any
+    thread_local const TaskScheduler* currentScheduler = nullptr;
+    thread_local TaskPriority currentPriority = TaskPriority::Interactive;
+    thread_local unsigned int currentWorkerIndex = 0;
+
+    // Names the current worker thread (for debuggers and profilers) and adjusts its OS priority to match its class:
+    // interactive workers are boosted, and compute workers are lowered so they can't starve the rest of the process
+    void ConfigureWorkerThread(TaskPriority priority, unsigned int index) {
+        const std::string name = std::string("sic1-") + GetTaskPriorityName(priority) + "-" + std::to_string(index);
+
+#if defined(_WIN32)
+        const std::wstring wideName(name.begin(), name.end());
+        SetThreadDescription(GetCurrentThread(), wideName.c_str());
+
+        switch (priority) {
+        case TaskPriority::Interactive:
+            SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_ABOVE_NORMAL);
+            break;
+
+        case TaskPriority::Compute:
+            SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+            break;
+
+        default:
+            break;
+        }
+#else
+        // Note: Thread names are limited to 15 characters on Linux
+        pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+
+        // Note: Raising a thread's nice value doesn't need any privileges (but lowering it does, so interactive workers
+        // are left alone)
+        if (priority == TaskPriority::Compute) {
+            setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 5);
+        }
+#endif
+    }
+}
+
+const char* Sic1::GetTaskPriorityName(TaskPriority priority) {
+    return taskPriorityNames[static_cast<size_t>(priority)];
+}
+
+TaskScheduler::TaskScheduler(const TaskSchedulerOptions& options)
+    : m_freeNodes(nullptr), m_stopping(false), m_pendingCount(0) {
+    for (size_t priority = 0; priority < taskPriorityCount; priority++) {
+        unsigned int threadCount = options.threadCounts[priority];
+        if (threadCount == 0) {
+            threadCount = (static_cast<TaskPriority>(priority) == TaskPriority::Compute) ? (std::max)(1u, std::thread::hardware_concurrency()) : 1;
+        }
+
+        m_groups[priority] = std::make_unique<WorkerGroup>();
+        for (unsigned int i = 0; i < threadCount; i++) {
+            m_groups[priority]->workers.push_back(std::make_unique<Worker>());
+        }
+    }
+
+    for (size_t priority = 0; priority < taskPriorityCount; priority++) {
+        for (unsigned int i = 0; i < GetThreadCount(static_cast<TaskPriority>(priority)); i++) {
+            m_threads.emplace_back(&TaskScheduler::WorkerLoop, this, static_cast<TaskPriority>(priority), i);
+        }
+    }
+}
+
+TaskScheduler::~TaskScheduler() {
+    m_stopping = true;
+    for (auto& group : m_groups) {
+        std::lock_guard<std::mutex> lock(group->mutex);
+        group->taskQueued.notify_all();
+    }
+
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+
+    // Skip any tasks that didn't get to run
+    for (auto& group : m_groups) {
+        for (auto& worker : group->workers) {
+            for (TaskNode* node : worker->tasks) {
+                FreeNode(node);
+            }
+        }
+    }
+}
+
+void TaskScheduler::Wait() {
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_idle.wait(lock, [this]() { return m_pendingCount.load() == 0; });
+    }
+    RethrowIfNeeded();
+}
+
+bool TaskScheduler::WaitFor(std::chrono::milliseconds timeout) {
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_idle.wait_for(lock, timeout, [this]() { return m_pendingCount.load() == 0; })) {
+            return false;
+        }
+    }
+    RethrowIfNeeded();
+    return true;
+}
+
+size_t TaskScheduler::GetTaskNodeCount() const {
+    std::lock_guard<std::mutex> lock(m_poolMutex);
+    return m_nodeBlocks.size() * nodesPerBlock;
+}
+
+void TaskScheduler::RethrowIfNeeded() {
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::swap(error, m_error);
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+TaskScheduler::TaskNode* TaskScheduler::AllocateNode() {
+    std::lock_guard<std::mutex> lock(m_poolMutex);
+    TaskNode* node = m_freeNodes.load(std::memory_order_acquire);
+    while (node && !m_freeNodes.compare_exchange_weak(node, node->next, std::memory_order_acquire)) {
+    }
+
+    if (!node) {
+        // Keep the first node of a new block, and add the rest to the pool
+        std::unique_ptr<TaskNode[]> block = std::make_unique<TaskNode[]>(nodesPerBlock);
+        for (size_t i = 1; i < nodesPerBlock; i++) {
+            PushFreeNode(&block[i]);
+        }
+
+        node = &block[0];
+        m_nodeBlocks.push_back(std::move(block));
+    }
+
+    return node;
+}
+
+void TaskScheduler::FreeNode(TaskNode* node) {
+    // Note: Release the closure (and anything it captured) before returning the node to the pool
+    node->task.Reset();
+    node->token = CancellationToken();
+    PushFreeNode(node);
+}
+
+void TaskScheduler::PushFreeNode(TaskNode* node) {
+    node->next = m_freeNodes.load(std::memory_order_relaxed);
+    while (!m_freeNodes.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {
+    }
+}
+
+void TaskScheduler::Enqueue(TaskPriority priority, TaskNode* node) {
+    WorkerGroup& group = *m_groups[static_cast<size_t>(priority)];
+    const unsigned int index = (currentScheduler == this && currentPriority == priority)
+        ? currentWorkerIndex
+        : (group.nextWorker.fetch_add(1, std::memory_order_relaxed) % static_cast<unsigned int>(group.workers.size()));
+
+    // Note: Count the task before queuing it, so that the count never drops below zero
+    m_pendingCount.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lock(group.mutex);
+        group.queuedCount++;
+    }
+
+    {
+        Worker& worker = *group.workers[index];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.tasks.push_back(node);
+    }
+    group.taskQueued.notify_one();
+}
+
+bool TaskScheduler::TryTake(WorkerGroup& group, unsigned int index, TaskNode*& node) {
+    // Newest task from this worker's own deque first
+    {
+        Worker& worker = *group.workers[index];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (!worker.tasks.empty()) {
+            node = worker.tasks.back();
+            worker.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // Otherwise, steal the oldest task from another worker in the group
+    const unsigned int count = static_cast<unsigned int>(group.workers.size());
+    for (unsigned int offset = 1; offset < count; offset++) {
+        Worker& victim = *group.workers[(index + offset) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            node = victim.tasks.front();
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void TaskScheduler::Run(TaskNode* node) {
+    if (!node->token.IsCanceled()) {
+        try {
+            node->task();
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_error) {
+                m_error = std::current_exception();
+            }
+        }
+    }
+
+    // Note: Release the task (and anything it captured) before reporting completion
+    FreeNode(node);
+    if (m_pendingCount.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_idle.notify_all();
+    }
+}
+
+void TaskScheduler::WorkerLoop(TaskPriority priority, unsigned int index) {
+    currentScheduler = this;
+    currentPriority = priority;
+    currentWorkerIndex = index;
+    ConfigureWorkerThread(priority, index);
+
+    WorkerGroup& group = *m_groups[static_cast<size_t>(priority)];
+    while (!m_stopping) {
+        TaskNode* node = nullptr;
+        if (TryTake(group, index, node)) {
+            {
+                std::lock_guard<std::mutex> lock(group.mutex);
+                group.queuedCount--;
+            }
+
+            Run(node);
+        }
+        else {
+            std::unique_lock<std::mutex> lock(group.mutex);
+            group.taskQueued.wait(lock, [&]() { return group.queuedCount > 0 || m_stopping; });
+        }
+    }
+}
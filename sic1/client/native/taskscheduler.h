@@ -0,0 +1,260 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Sic1 {
+    // Each class of task runs on its own workers, so e.g. a slow Steam call can never delay a promise that the UI is
+    // waiting on
+    enum class TaskPriority : uint8_t {
+        // Latency-sensitive work the UI is waiting on (e.g. settling promises); should be quick
+        Interactive,
+
+        // File persistence
+        Io,
+
+        // Calls that may block on the network
+        Network,
+
+        // Long-running, CPU-bound work
+        Compute,
+    };
+
+    constexpr size_t taskPriorityCount = 4;
+
+    const char* GetTaskPriorityName(TaskPriority priority);
+
+    // Number of workers for each class of task (indexed by TaskPriority)
+    typedef struct {
+        std::array<unsigned int, taskPriorityCount> threadCounts;
+    } TaskSchedulerOptions;
+
+    // Note: A thread count of zero means one thread (or, for Compute, one thread per hardware thread)
+    constexpr TaskSchedulerOptions taskSchedulerOptionsDefault = { { 2, 1, 2, 0 } };
+
+    // Checked by tasks to find out whether they've been canceled. Default-constructed tokens are never canceled.
+    class CancellationToken {
+    public:
+        CancellationToken() = default;
+
+        bool IsCanceled() const {
+            return m_canceled && m_canceled->load(std::memory_order_acquire);
+        }
+
+    private:
+        friend class CancellationSource;
+
+        explicit CancellationToken(std::shared_ptr<const std::atomic<bool>> canceled)
+            : m_canceled(std::move(canceled)) {
+        }
+
+        std::shared_ptr<const std::atomic<bool>> m_canceled;
+    };
+
+    // Cancels every task submitted with one of its tokens: tasks that haven't started are skipped, and running tasks can
+    // check their token
+    class CancellationSource {
+    public:
+        CancellationSource()
+            : m_canceled(std::make_shared<std::atomic<bool>>(false)) {
+        }
+
+        CancellationToken GetToken() const {
+            return CancellationToken(m_canceled);
+        }
+
+        void Cancel() {
+            m_canceled->store(true, std::memory_order_release);
+        }
+
+        bool IsCanceled() const {
+            return m_canceled->load(std::memory_order_acquire);
+        }
+
+    private:
+        std::shared_ptr<std::atomic<bool>> m_canceled;
+    };
+
+    // Type-erased closure that's stored inline when it fits (so queuing a task usually doesn't allocate), and on the heap
+    // otherwise. It's never moved, so closures don't need to be movable once stored.
+    class InlineTask {
+    public:
+        static constexpr size_t capacity = 64;
+
+        InlineTask()
+            : m_invoke(nullptr), m_destroy(nullptr), m_inline(false) {
+        }
+
+        ~InlineTask() {
+            Reset();
+        }
+
+        InlineTask(const InlineTask&) = delete;
+        InlineTask& operator=(const InlineTask&) = delete;
+
+        // Note: Replaces any stored closure
+        template<typename TFunction>
+        void Emplace(TFunction&& function) {
+            typedef std::decay_t<TFunction> Function;
+            Reset();
+            if constexpr (sizeof(Function) <= capacity && alignof(Function) <= alignof(std::max_align_t)) {
+                new (m_storage) Function(std::forward<TFunction>(function));
+                m_invoke = [](void* storage) { (*std::launder(static_cast<Function*>(storage)))(); };
+                m_destroy = [](void* storage) { std::launder(static_cast<Function*>(storage))->~Function(); };
+                m_inline = true;
+            }
+            else {
+                new (m_storage) Function*(new Function(std::forward<TFunction>(function)));
+                m_invoke = [](void* storage) { (**std::launder(static_cast<Function**>(storage)))(); };
+                m_destroy = [](void* storage) { delete *std::launder(static_cast<Function**>(storage)); };
+                m_inline = false;
+            }
+        }
+
+        void operator()() {
+            m_invoke(m_storage);
+        }
+
+        // Destroys the stored closure (and anything it captured)
+        void Reset() {
+            if (m_destroy) {
+                m_destroy(m_storage);
+                m_invoke = nullptr;
+                m_destroy = nullptr;
+            }
+        }
+
+        explicit operator bool() const {
+            return m_invoke != nullptr;
+        }
+
+        // True if the stored closure didn't need a heap allocation
+        bool IsInline() const {
+            return m_inline;
+        }
+
+    private:
+        alignas(std::max_align_t) unsigned char m_storage[capacity];
+        void (*m_invoke)(void* storage);
+        void (*m_destroy)(void* storage);
+        bool m_inline;
+    };
+
+    // Task scheduler with a separate group of workers for each TaskPriority. Within a group, each worker has its own
+    // deque of tasks: workers take their own most recently queued task first and, when they run out, steal the oldest
+    // task from another worker in the group. Tasks may queue more tasks (which go onto the current worker's deque, if
+    // they're of the same class).
+    //
+    // Tasks are stored in pooled nodes (with closures stored inline, see InlineTask), so submitting a task doesn't
+    // normally allocate.
+    class TaskScheduler {
+    public:
+        explicit TaskScheduler(const TaskSchedulerOptions& options = taskSchedulerOptionsDefault);
+
+        // Note: Waits for running tasks to complete, but skips any that haven't started. Tasks must not be submitted
+        // once the scheduler is being destroyed.
+        ~TaskScheduler();
+
+        TaskScheduler(const TaskScheduler&) = delete;
+        TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+        unsigned int GetThreadCount(TaskPriority priority) const {
+            return static_cast<unsigned int>(m_groups[static_cast<size_t>(priority)]->workers.size());
+        }
+
+        // Note: The task is skipped if the token is canceled before the task starts
+        template<typename TFunction>
+        void Submit(TaskPriority priority, TFunction&& function, CancellationToken token = CancellationToken()) {
+            TaskNode* node = AllocateNode();
+            try {
+                node->task.Emplace(std::forward<TFunction>(function));
+            }
+            catch (...) {
+                FreeNode(node);
+                throw;
+            }
+
+            node->token = std::move(token);
+            Enqueue(priority, node);
+        }
+
+        // Waits for all queued tasks (including any they queued) to complete or be skipped, rethrowing the first
+        // exception thrown by a task, if any
+        void Wait();
+
+        // Same as Wait, but returns false if tasks are still running after the timeout
+        bool WaitFor(std::chrono::milliseconds timeout);
+
+        // Number of task nodes allocated (nodes are reused once their tasks complete, so this stays at the peak number
+        // of outstanding tasks)
+        size_t GetTaskNodeCount() const;
+
+    private:
+        typedef struct TaskNode {
+            InlineTask task;
+            CancellationToken token;
+
+            // Next free node (while the node is in the pool)
+            TaskNode* next;
+        } TaskNode;
+
+        typedef struct {
+            std::mutex mutex;
+            std::deque<TaskNode*> tasks;
+        } Worker;
+
+        typedef struct {
+            std::vector<std::unique_ptr<Worker>> workers;
+
+            // Signaled when a task is queued for this group (or the scheduler is shutting down)
+            std::mutex mutex;
+            std::condition_variable taskQueued;
+            size_t queuedCount;
+
+            // Used to spread tasks submitted from outside the group across its workers
+            std::atomic<unsigned int> nextWorker;
+        } WorkerGroup;
+
+        static constexpr size_t nodesPerBlock = 64;
+
+        TaskNode* AllocateNode();
+        void FreeNode(TaskNode* node);
+        void PushFreeNode(TaskNode* node);
+
+        void Enqueue(TaskPriority priority, TaskNode* node);
+        void WorkerLoop(TaskPriority priority, unsigned int index);
+        bool TryTake(WorkerGroup& group, unsigned int index, TaskNode*& node);
+        void Run(TaskNode* node);
+        void RethrowIfNeeded();
+
+        // Pool of task nodes, allocated in blocks. Free nodes are kept on a lock-free stack: nodes are pushed from any
+        // thread, but only popped while holding m_poolMutex (so a node can't be popped and pushed back while another
+        // thread is popping it).
+        mutable std::mutex m_poolMutex;
+        std::vector<std::unique_ptr<TaskNode[]>> m_nodeBlocks;
+        std::atomic<TaskNode*> m_freeNodes;
+
+        std::array<std::unique_ptr<WorkerGroup>, taskPriorityCount> m_groups;
+        std::vector<std::thread> m_threads;
+        std::atomic<bool> m_stopping;
+
+        // Tasks that have been submitted, but not yet completed (or skipped)
+        std::mutex m_mutex;
+        std::condition_variable m_idle;
+        std::atomic<size_t> m_pendingCount;
+        std::exception_ptr m_error;
+    };
+}
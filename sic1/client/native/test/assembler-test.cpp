@@ -0,0 +1,186 @@
+#include "test.h"
+#include "test-programs.h"
+#include "../assembler.h"
+
+using namespace Sic1;
+
+namespace {
+    // Returns the error thrown when assembling the source, failing if it assembles successfully
+    CompilationError GetError(std::string_view source) {
+        try {
+            Assembler::Assemble(source);
+        }
+        catch (const CompilationError& error) {
+            return error;
+        }
+        throw Test::AssertionError("Expected a compilation error for: " + std::string(source));
+    }
+
+    void VerifyError(std::string_view source, CompilationErrorType errorType, unsigned int sourceLineNumber) {
+        const CompilationError error = GetError(source);
+        ASSERT_EQUAL(GetCompilationErrorTypeName(errorType), std::string(GetCompilationErrorTypeName(error.GetErrorType())));
+        ASSERT_EQUAL(sourceLineNumber, error.GetContext().sourceLineNumber.value_or(0));
+    }
+}
+
+TEST_CASE("Assembler", "subleq") {
+    const ParsedLine parsed = Assembler::ParseLine("subleq 1, 2");
+    ASSERT_TRUE(parsed.command == Command::SubleqInstruction);
+    ASSERT_EQUAL(2u, parsed.expressions.size());
+    ASSERT_EQUAL(1, parsed.expressions[0].value);
+    ASSERT_EQUAL(2, parsed.expressions[1].value);
+
+    for (const char* line : { "subleq 1 2 3", "subleq 1,2,3\t", "subleq 1 , 2 ,3 ", "!subleq 1 2 ; Comment", " ! subleq 1 2" }) {
+        ASSERT_TRUE(Assembler::ParseLine(line).expressions.size() >= 2);
+    }
+    ASSERT_TRUE(Assembler::ParseLine(" ! subleq 1 2").breakpoint);
+}
+
+TEST_CASE("Assembler", "References") {
+    const ParsedLine parsed = Assembler::ParseLine("@command: .data 1, @inline1:-2 @one, @inline3: @inline3_2: -@two @inline4:@inline4_2:@three+3, -@4-4 'a', -'A' \"abc\", -\"DEF\"");
+    ASSERT_TRUE(parsed.command == Command::DataDirective);
+    ASSERT_EQUAL(16u, parsed.expressions.size());
+    ASSERT_EQUAL(SignedToUnsigned(-2), parsed.expressions[1].value);
+    ASSERT_TRUE(parsed.expressions[2].isReference);
+    ASSERT_EQUAL(std::string("one"), std::string(parsed.expressions[2].label));
+    ASSERT_TRUE(parsed.expressions[3].negated);
+    ASSERT_EQUAL(3.0, parsed.expressions[4].offset);
+    ASSERT_EQUAL(std::string("4"), std::string(parsed.expressions[5].label));
+    ASSERT_EQUAL(-4.0, parsed.expressions[5].offset);
+    ASSERT_TRUE(parsed.expressions[5].negated);
+    ASSERT_EQUAL('a', parsed.expressions[6].value);
+    ASSERT_EQUAL(SignedToUnsigned(-'A'), parsed.expressions[7].value);
+    ASSERT_EQUAL('c', parsed.expressions[10].value);
+    ASSERT_EQUAL(0, parsed.expressions[11].value);
+    ASSERT_EQUAL(SignedToUnsigned(-'F'), parsed.expressions[14].value);
+    ASSERT_EQUAL(0, parsed.expressions[15].value);
+
+    const unsigned int offsets[] = { 0, 1, 3, 3, 4, 4 };
+    ASSERT_EQUAL(6u, parsed.labelDefinitions.size());
+    for (size_t i = 0; i < parsed.labelDefinitions.size(); i++) {
+        ASSERT_EQUAL(offsets[i], parsed.labelDefinitions[i].offset);
+        ASSERT_EQUAL(i > 0, parsed.labelDefinitions[i].isInline);
+    }
+    ASSERT_EQUAL(std::string("inline3_2"), std::string(parsed.labelDefinitions[3].label));
+}
+
+TEST_CASE("Assembler", "Characters and strings") {
+    const ParsedLine parsed = Assembler::ParseLine(".data '\\n' '\\'' \"with \\\"quotes\\\"\" -\"\" @\xf0\x9f\x9c\x82:7 '\\0'");
+    const uint8_t expected[] = { '\n', '\'', 'w', 'i', 't', 'h', ' ', '"', 'q', 'u', 'o', 't', 'e', 's', '"', 0, 0, 7, 0 };
+    ASSERT_EQUAL(sizeof(expected), parsed.expressions.size());
+    for (size_t i = 0; i < sizeof(expected); i++) {
+        ASSERT_EQUAL(expected[i], parsed.expressions[i].value);
+    }
+    ASSERT_EQUAL(std::string("\xf0\x9f\x9c\x82"), std::string(parsed.labelDefinitions[0].label));
+
+    // Unicode whitespace separates tokens, as in JavaScript
+    ASSERT_EQUAL(2u, Assembler::ParseLine("subleq\xe3\x80\x80" "1\xc2\xa0" "2").expressions.size());
+}
+
+TEST_CASE("Assembler", "Invalid lines") {
+    const char* const lines[] = {
+        "subleq", "subleq 1", "subleq @one@two", "subleq@one @two", "subleq,@one @two", "subleq @one @inline:, @two",
+        "subleq @one,,@two", "subleq @one, , @two", "subleq 1, 2, 3, 4",
+        "@-1 .data -1", "@! .data -1", "@@ .data -1", "@\\ .data -1", "@( .data -1", "@) .data -1", "@; .data -1",
+        "@: .data -1", "@' .data -1", "@\" .data -1", "@, .data -1", "@+ .data -1",
+        ".data", ".data 'ab'", ".data '''", ".data ''", ".data '\\t'", ".data '\\'", ".data -'\\'",
+        ".data \"\\\"", ".data \"\\t\"", ".data \"\"\"", ".data \"\"\"\"", ".data @one@two", ".data 0-@tmp",
+        "!", "!.data 0", "subleq 1 2 3 !", ".data 1 ; Comment\r",
+    };
+
+    for (const char* line : lines) {
+        ASSERT_THROWS(Assembler::ParseLine(line), CompilationError);
+    }
+}
+
+TEST_CASE("Assembler", "Programs") {
+    const AssembledProgram program = Assembler::Assemble(
+        "\n"
+        "    @loop:\n"
+        "    subleq @OUT, @IN\n"
+        "    !subleq @zero, @zero, @loop\n"
+        "\n"
+        "    @zero: .data 0\n");
+
+    ASSERT_TRUE(program.bytes == std::vector<uint8_t>({ 254, 253, 3, 6, 6, 0, 0 }));
+    ASSERT_EQUAL(1u, program.variables.size());
+    ASSERT_EQUAL(std::string("@zero"), program.variables[0].label);
+    ASSERT_EQUAL(6u, program.variables[0].address);
+    ASSERT_TRUE(program.breakpoints == std::vector<unsigned int>({ 3 }));
+
+    ASSERT_EQUAL(7u, program.sourceMap.size());
+    ASSERT_EQUAL(2u, program.sourceMap[0]->lineNumber);
+    ASSERT_TRUE(program.sourceMap[0]->command == Command::SubleqInstruction);
+    ASSERT_FALSE(program.sourceMap[1].has_value());
+    ASSERT_EQUAL(5u, program.sourceMap[6]->lineNumber);
+    ASSERT_TRUE(program.sourceMap[6]->command == Command::DataDirective);
+    ASSERT_EQUAL(std::string("    @zero: .data 0"), program.sourceMap[6]->source);
+
+    const AssembledProgram passthrough = Assembler::Assemble(std::vector<std::string>({
+        "@loop:",
+        "subleq @tmp: 0, @IN",
+        "subleq @tmp, @IN",
+        "subleq @OUT, @tmp",
+        "subleq @tmp, @tmp, @loop",
+    }));
+    ASSERT_TRUE(passthrough.bytes == std::vector<uint8_t>({ 0, 253, 3, 0, 253, 6, 254, 0, 9, 0, 0, 0 }));
+    ASSERT_EQUAL(std::string("@tmp"), passthrough.variables[0].label);
+
+    ASSERT_TRUE(Assembler::Assemble(".data @tmp: 0 @tmp2: 2 @three: -@HALT+4").bytes == std::vector<uint8_t>({ 0, 2, 5 }));
+    ASSERT_TRUE(Assembler::Assemble(TestPrograms::sampleSource).bytes == TestPrograms::sampleProgram);
+    ASSERT_TRUE(Assembler::Assemble("").bytes.empty());
+    ASSERT_TRUE(Assembler::Assemble("; Comment only\n\n").sourceMap.empty());
+}
+
+TEST_CASE("Assembler", "Errors") {
+    VerifyError("\nsubleq @OUT, @IN\n@zero: .data 128", CompilationErrorType::ValueRangeError, 3);
+    VerifyError("\nsubleq @OUT, @IN\nsubleq 256, @IN", CompilationErrorType::AddressLiteralRangeError, 3);
+    VerifyError("\nsubleq 'a', 'b', 'c'", CompilationErrorType::InvalidAddressExpressionError, 2);
+    VerifyError("\nsubleq @OUT, @IN\nsubleq @OUT", CompilationErrorType::InvalidSubleqArgumentCountError, 3);
+    VerifyError("\nsubleq @OUT, @IN\n.data", CompilationErrorType::InvalidDataArgumentCountError, 3);
+    VerifyError("\nsubleq @OUT, @IN\n.duh 1", CompilationErrorType::InvalidCommandError, 3);
+    VerifyError("\nsubleq @OUT, @IN\n@tmp: .data 5\n@tmp: .data 6", CompilationErrorType::LabelAlreadyDefinedError, 4);
+    VerifyError("@tmp:\nsubleq @tmp, @IN\n@tmp: .data 0", CompilationErrorType::LabelAlreadyDefinedError, 3);
+    VerifyError("@IN: .data 0", CompilationErrorType::LabelAlreadyDefinedError, 1);
+    VerifyError("@constructor: .data 0", CompilationErrorType::LabelAlreadyDefinedError, 1);
+
+    // Names inherited from Object.prototype can't be referenced either (intentionally unlike the script assembler, which
+    // resolves them to the inherited property and emits meaningless bytes)
+    VerifyError("subleq @OUT, @toString", CompilationErrorType::UndefinedReferenceError, 1);
+    VerifyError("\n.data -@constructor", CompilationErrorType::UndefinedReferenceError, 2);
+    VerifyError("\n\n.data @__proto__+1", CompilationErrorType::UndefinedReferenceError, 3);
+    VerifyError("\nsubleq @OUT, @IN\nsubleq @zero, @zero, @loop\n\n@zero: .data 0", CompilationErrorType::UndefinedReferenceError, 3);
+    VerifyError("\n@loop:\nsubleq @OUT, @IN\nsubleq @OUT, @IN, @loop-1", CompilationErrorType::AddressReferenceRangeError, 4);
+    VerifyError("\n!.data 1 2 3", CompilationErrorType::InvalidBreakpointError, 2);
+    VerifyError("\n.data '\\a'", CompilationErrorType::InvalidEscapeCodeError, 2);
+    VerifyError("\n.data %", CompilationErrorType::InvalidTokenError, 2);
+    VerifyError("\n!.data .data", CompilationErrorType::InvalidValueExpressionError, 2);
+    VerifyError("\nsubleq @a@b@c", CompilationErrorType::MissingCommaOrWhitespaceError, 2);
+    VerifyError("\n.data'a'", CompilationErrorType::MissingWhitespaceError, 2);
+
+    // Context and messages match the script assembler's
+    const CompilationError range = GetError("@loop:\nsubleq @OUT, @IN, @loop-1");
+    ASSERT_EQUAL(std::string("@loop-1"), *range.GetContext().text);
+    ASSERT_EQUAL(-1.0, *range.GetContext().number);
+    ASSERT_EQUAL(std::string("subleq @OUT, @IN, @loop-1"), *range.GetContext().sourceLine);
+    ASSERT_EQUAL(std::string("Address \"@loop-1\" (-1) is outside of valid range of [0, 255]"), std::string(range.what()));
+    ASSERT_EQUAL(std::string("Address \"@HALT+1\" (256) is outside of valid range of [0, 255]"), std::string(GetError("subleq 0 0 @HALT+1").what()));
+    ASSERT_EQUAL(std::string("Invalid argument: 128 (must be an integer on the range [-128, 127])"), std::string(GetError(".data 128").what()));
+    ASSERT_EQUAL(std::string("Invalid token: \"% ; Rest\""), std::string(GetError(".data 1 % ; Rest").what()));
+
+    // Program size is checked before references are resolved, and has no line
+    std::string tooLong = "subleq @last @last @last\n";
+    for (unsigned int i = 0; i < Constants::addressUserMax; i++) {
+        tooLong += ".data -1\n";
+    }
+    const CompilationError tooLarge = GetError(tooLong);
+    ASSERT_TRUE(tooLarge.GetErrorType() == CompilationErrorType::ProgramTooLargeError);
+    ASSERT_FALSE(tooLarge.GetContext().sourceLineNumber.has_value());
+    ASSERT_EQUAL(255.0, *tooLarge.GetContext().number);
+
+    std::string maxLength;
+    for (unsigned int i = 0; i < Constants::addressUserMax; i++) {
+        maxLength += ".data 1\n";
+    }
+    ASSERT_EQUAL(static_cast<size_t>(Constants::addressUserMax), Assembler::Assemble(maxLength).bytes.size());
+}
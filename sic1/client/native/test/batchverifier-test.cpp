@@ -0,0 +1,269 @@
+#include "test.h"
+#include "../batchverifier.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+using namespace Sic1;
+
+namespace {
+    // Reads and outputs each input (a solution to "First Assessment")
+    const char* const echoProgram = "0c0c030cfd06fe0c090d0d000000";
+
+    Solution CreateSolution(const std::string& puzzleTitle, const std::string& program, std::optional<uint64_t> cycles = std::nullopt) {
+        Solution solution;
+        solution.puzzleTitle = puzzleTitle;
+        solution.userId = "user";
+        solution.focus = "cycles";
+        solution.cycles = cycles;
+        solution.program = UnhexifyBytes(program);
+        return solution;
+    }
+}
+
+TEST_CASE("Batch verifier", "Solution database") {
+    const auto solutions = ParseSolutionDatabase(R"({
+        "First Assessment": {
+            "1": { "cycles": {"cycles": 27, "bytes": 14, "program": "0c0c03", "source": "", "time": "2023-01-01"} },
+            "2": { "bytes": {"cycles": null, "bytes": null, "program": "ff"} }
+        },
+        "Addition": {}
+    })");
+
+    ASSERT_EQUAL(2u, solutions.size());
+    ASSERT_EQUAL(std::string("First Assessment"), solutions[0].puzzleTitle);
+    ASSERT_EQUAL(std::string("1"), solutions[0].userId);
+    ASSERT_EQUAL(std::string("cycles"), solutions[0].focus);
+    ASSERT_EQUAL(27ull, static_cast<unsigned long long>(*solutions[0].cycles));
+    ASSERT_EQUAL(14u, *solutions[0].bytes);
+    ASSERT_EQUAL(3u, solutions[0].program.size());
+    ASSERT_EQUAL(std::string("2023-01-01"), solutions[0].time);
+
+    ASSERT_FALSE(solutions[1].cycles.has_value());
+    ASSERT_FALSE(solutions[1].bytes.has_value());
+    ASSERT_EQUAL(std::string("ff"), HexifyBytes(solutions[1].program));
+
+    ASSERT_THROWS(UnhexifyBytes("0g"), std::runtime_error);
+}
+
+TEST_CASE("Batch verifier", "Failure counts") {
+    WorkStealingPool pool(4);
+    BatchVerifier verifier(pool, 1, 50);
+
+    const std::vector<Solution> solutions = {
+        CreateSolution("First Assessment", echoProgram),
+        CreateSolution("First Assessment", echoProgram, 4),
+        CreateSolution("First Assessment", "0c0c030cfd06"),
+        CreateSolution("Addition", echoProgram),
+    };
+
+    unsigned int progressCount = 0;
+    const auto failures = verifier.CountFailures(solutions, [&](uint64_t completed, uint64_t total) {
+        ASSERT_TRUE(completed <= total);
+        progressCount++;
+    }, std::chrono::milliseconds(1));
+
+    ASSERT_EQUAL(4u, failures.size());
+    ASSERT_EQUAL(0u, failures[0]);
+    ASSERT_EQUAL(50u, failures[1]);
+    ASSERT_EQUAL(50u, failures[2]);
+    ASSERT_EQUAL(50u, failures[3]);
+}
+
+TEST_CASE("Batch verifier", "Unknown puzzle") {
+    WorkStealingPool pool(1);
+    BatchVerifier verifier(pool, 1);
+    ASSERT_THROWS(verifier.CountFailures({ CreateSolution("Not a puzzle", echoProgram) }), std::runtime_error);
+}
+
+TEST_CASE("Batch verifier", "Iteration seeds") {
+    WorkStealingPool pool(1);
+    const BatchVerifier verifier(pool, 1);
+    const Solution solution = CreateSolution("First Assessment", echoProgram);
+
+    // Seeds only depend on the puzzle, program, and iteration
+    Solution other = solution;
+    other.userId = "other";
+    ASSERT_EQUAL(verifier.GetIterationSeed(solution, 3), verifier.GetIterationSeed(other, 3));
+    ASSERT_FALSE(verifier.GetIterationSeed(solution, 3) == verifier.GetIterationSeed(solution, 4));
+    ASSERT_FALSE(verifier.GetIterationSeed(solution, 3) == verifier.GetIterationSeed(CreateSolution("Addition", echoProgram), 3));
+    ASSERT_FALSE(verifier.GetIterationSeed(solution, 3) == verifier.GetIterationSeed(CreateSolution("First Assessment", "0c0c03"), 3));
+    ASSERT_FALSE(verifier.GetIterationSeed(solution, 3) == BatchVerifier(pool, 2).GetIterationSeed(solution, 3));
+}
+
+TEST_CASE("Batch verifier", "Deduplication and caching") {
+    WorkStealingPool pool(2);
+    BatchVerifier verifier(pool, 1, 20);
+
+    std::vector<Solution> solutions = {
+        CreateSolution("First Assessment", echoProgram),
+        CreateSolution("First Assessment", echoProgram),
+        CreateSolution("First Assessment", "0c0c030cfd06"),
+        CreateSolution("Addition", echoProgram),
+        CreateSolution("First Assessment", echoProgram, 4),
+    };
+    solutions[1].userId = "other";
+
+    auto failures = verifier.CountFailures(solutions);
+    ASSERT_TRUE(failures == std::vector<unsigned int>({ 0, 0, 20, 20, 20 }));
+    ASSERT_EQUAL(5u, verifier.GetStatistics().solutionCount);
+    ASSERT_EQUAL(4u, verifier.GetStatistics().uniqueCount);
+    ASSERT_EQUAL(0u, verifier.GetStatistics().cachedCount);
+    ASSERT_EQUAL(4u, verifier.GetStatistics().verifiedCount);
+
+    // Only new solutions are verified once verdicts are cached
+    VerdictCache cache;
+    verifier.SetVerdictCache(&cache);
+    verifier.CountFailures(solutions);
+    ASSERT_EQUAL(4u, cache.GetSize());
+    ASSERT_EQUAL(1ull, static_cast<unsigned long long>(cache.GetSeed()));
+
+    solutions.push_back(CreateSolution("First Assessment", echoProgram, 3));
+    failures = verifier.CountFailures(solutions);
+    ASSERT_TRUE(failures == std::vector<unsigned int>({ 0, 0, 20, 20, 20, 20 }));
+    ASSERT_EQUAL(5u, verifier.GetStatistics().uniqueCount);
+    ASSERT_EQUAL(4u, verifier.GetStatistics().cachedCount);
+    ASSERT_EQUAL(1u, verifier.GetStatistics().verifiedCount);
+
+    // Cached verdicts aren't reused for a different seed
+    BatchVerifier reseeded(pool, 2, 20);
+    reseeded.SetVerdictCache(&cache);
+    reseeded.CountFailures(solutions);
+    ASSERT_EQUAL(0u, reseeded.GetStatistics().cachedCount);
+    ASSERT_EQUAL(2ull, static_cast<unsigned long long>(cache.GetSeed()));
+}
+
+TEST_CASE("Batch verifier", "Streaming solution database") {
+    const std::string text = R"({
+        "First Assessment": {
+            "1": { "cycles": {"cycles": 27, "bytes": 14, "program": "0c0c03", "extra": {"ignored": [1, 2]}} },
+            "2": { "bytes": {"cycles": null, "bytes": null, "program": "ff"}, "cycles": {"program": "00"} }
+        },
+        "Addition": { "3": { "bytes": {} } }
+    })";
+
+    // Streaming produces the same solutions, one at a time, and can stop early
+    std::istringstream stream(text);
+    std::vector<Solution> solutions;
+    ASSERT_FALSE(StreamSolutionDatabase(stream, [&](Solution&& solution) {
+        solutions.push_back(std::move(solution));
+        return solutions.size() < 3;
+    }));
+
+    ASSERT_EQUAL(3u, solutions.size());
+    ASSERT_EQUAL(std::string("2"), solutions[2].userId);
+    ASSERT_EQUAL(std::string("cycles"), solutions[2].focus);
+    ASSERT_EQUAL(std::string("00"), HexifyBytes(solutions[2].program));
+    ASSERT_EQUAL(4u, ParseSolutionDatabase(text).size());
+
+    ASSERT_THROWS(ParseSolutionDatabase("[]"), std::runtime_error);
+    ASSERT_THROWS(ParseSolutionDatabase(R"({"a": {"b": 1}})"), std::runtime_error);
+    ASSERT_THROWS(ParseSolutionDatabase(R"({"a": {"b": {"c": {"cycles": "1"}}}})"), std::runtime_error);
+    ASSERT_THROWS(ParseSolutionDatabase(R"({"a": {"b": {"c": {"program": []}}}})"), std::runtime_error);
+}
+
+TEST_CASE("Batch verifier", "Streaming verification") {
+    WorkStealingPool pool(3);
+    BatchVerifier verifier(pool, 1, 20);
+
+    std::vector<Solution> solutions;
+    for (unsigned int i = 0; i < 30; i++) {
+        solutions.push_back(CreateSolution((i % 3 == 2) ? "Addition" : "First Assessment", (i % 2 == 0) ? echoProgram : "0c0c030cfd06"));
+        solutions.back().userId = std::to_string(i);
+    }
+
+    const auto expected = BatchVerifier(pool, 1, 20).CountFailures(solutions);
+
+    // Verdicts match CountFailures, even though the queue is much smaller than the number of solutions
+    BoundedQueue<Solution> queue(2);
+    std::thread producer([&]() {
+        for (const auto& solution : solutions) {
+            queue.Push(solution);
+        }
+        queue.Close();
+    });
+
+    std::vector<unsigned int> failures(solutions.size(), UINT32_MAX);
+    verifier.VerifyStream(queue, [&](const Solution& solution, unsigned int failureCount) {
+        failures[std::stoul(solution.userId)] = failureCount;
+    });
+    producer.join();
+
+    ASSERT_TRUE(expected == failures);
+    ASSERT_EQUAL(30u, verifier.GetStatistics().solutionCount);
+    ASSERT_EQUAL(4u, verifier.GetStatistics().uniqueCount);
+    ASSERT_EQUAL(4u, verifier.GetStatistics().verifiedCount);
+
+    // Same verdicts on a single thread, where identical solutions have to wait on each other's iteration chunks
+    WorkStealingPool singlePool(1);
+    BatchVerifier singleVerifier(singlePool, 1, 20);
+    BoundedQueue<Solution> singleQueue(1);
+    std::thread singleProducer([&]() {
+        for (const auto& solution : solutions) {
+            singleQueue.Push(solution);
+        }
+        singleQueue.Close();
+    });
+
+    std::vector<unsigned int> singleFailures(solutions.size(), UINT32_MAX);
+    singleVerifier.VerifyStream(singleQueue, [&](const Solution& solution, unsigned int failureCount) {
+        singleFailures[std::stoul(solution.userId)] = failureCount;
+    });
+    singleProducer.join();
+
+    ASSERT_TRUE(expected == singleFailures);
+    ASSERT_EQUAL(4u, singleVerifier.GetStatistics().verifiedCount);
+}
+
+TEST_CASE("Batch verifier", "Streaming verification with a waiting producer") {
+    // Workers never wait on the producer, so a producer that waits for each verdict before pushing the next solution
+    // doesn't stall a single worker
+    WorkStealingPool pool(1);
+    BatchVerifier verifier(pool, 1, 20);
+    BoundedQueue<Solution> queue(1);
+    std::mutex mutex;
+    std::condition_variable verdictReported;
+    unsigned int verdictCount = 0;
+    bool timedOut = false;
+    std::thread producer([&]() {
+        for (unsigned int i = 0; i < 6; i++) {
+            queue.Push(CreateSolution((i % 2 == 0) ? "First Assessment" : "Addition", (i % 3 == 0) ? echoProgram : "0c0c030cfd06"));
+
+            std::unique_lock<std::mutex> lock(mutex);
+            if (!verdictReported.wait_for(lock, std::chrono::seconds(10), [&]() { return verdictCount > i; })) {
+                timedOut = true;
+                break;
+            }
+        }
+        queue.Close();
+    });
+
+    verifier.VerifyStream(queue, [&](const Solution&, unsigned int) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            verdictCount++;
+        }
+        verdictReported.notify_all();
+    });
+    producer.join();
+
+    ASSERT_FALSE(timedOut);
+    ASSERT_EQUAL(6u, verdictCount);
+}
+
+TEST_CASE("Batch verifier", "Streaming verification errors") {
+    WorkStealingPool pool(2);
+    BatchVerifier verifier(pool, 1, 20);
+
+    // The producer is released when verification fails
+    BoundedQueue<Solution> queue(1);
+    std::thread producer([&]() {
+        while (queue.Push(CreateSolution("Not a puzzle", echoProgram))) {
+        }
+    });
+
+    ASSERT_THROWS(verifier.VerifyStream(queue, [](const Solution&, unsigned int) {}), std::runtime_error);
+    producer.join();
+}
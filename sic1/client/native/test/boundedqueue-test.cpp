@@ -0,0 +1,107 @@
+#include "test.h"
+#include "../boundedqueue.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace Sic1;
+
+TEST_CASE("Bounded queue", "Producers and consumers") {
+    BoundedQueue<unsigned int> queue(4);
+    std::atomic<uint64_t> sum(0);
+    std::atomic<unsigned int> maxCount(0);
+    std::vector<std::thread> consumers;
+    for (unsigned int i = 0; i < 3; i++) {
+        consumers.emplace_back([&]() {
+            unsigned int value = 0;
+            while (queue.Pop(value)) {
+                sum += value;
+            }
+        });
+    }
+
+    std::vector<std::thread> producers;
+    for (unsigned int i = 0; i < 2; i++) {
+        producers.emplace_back([&, i]() {
+            for (unsigned int value = 1; value <= 5000; value++) {
+                ASSERT_TRUE(queue.Push(value + i * 5000));
+            }
+        });
+    }
+
+    for (auto& producer : producers) {
+        producer.join();
+    }
+
+    // Items queued before closing are still delivered
+    queue.Close();
+    for (auto& consumer : consumers) {
+        consumer.join();
+    }
+
+    ASSERT_EQUAL(50005000ull, static_cast<unsigned long long>(sum.load()));
+    ASSERT_FALSE(queue.Push(1));
+}
+
+TEST_CASE("Bounded queue", "Capacity") {
+    BoundedQueue<unsigned int> queue(2);
+    ASSERT_TRUE(queue.Push(1));
+    ASSERT_TRUE(queue.Push(2));
+
+    // The third push blocks until there's room
+    std::atomic<bool> pushed(false);
+    std::thread producer([&]() {
+        queue.Push(3);
+        pushed = true;
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    ASSERT_FALSE(pushed.load());
+
+    unsigned int value = 0;
+    ASSERT_TRUE(queue.Pop(value));
+    ASSERT_EQUAL(1u, value);
+    producer.join();
+    ASSERT_TRUE(pushed.load());
+}
+
+TEST_CASE("Bounded queue", "Cancel") {
+    BoundedQueue<unsigned int> queue(1);
+    ASSERT_TRUE(queue.Push(1));
+
+    // Cancelling releases a blocked producer and discards queued items
+    std::atomic<bool> result(true);
+    std::thread producer([&]() { result = queue.Push(2); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    queue.Cancel();
+    producer.join();
+    ASSERT_FALSE(result.load());
+
+    unsigned int value = 0;
+    ASSERT_FALSE(queue.Pop(value));
+}
+
+TEST_CASE("Bounded queue", "Timed pop") {
+    typedef BoundedQueue<unsigned int>::PopResult PopResult;
+    BoundedQueue<unsigned int> queue(2);
+    unsigned int value = 0;
+    ASSERT_TRUE(queue.PopFor(value, std::chrono::milliseconds(1)) == PopResult::TimedOut);
+
+    // Waits for the producer, up to the timeout
+    std::thread producer([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        queue.Push(5);
+    });
+
+    ASSERT_TRUE(queue.PopFor(value, std::chrono::seconds(10)) == PopResult::Popped);
+    ASSERT_EQUAL(5u, value);
+    producer.join();
+
+    // Queued items are still delivered after closing
+    ASSERT_TRUE(queue.Push(6));
+    queue.Close();
+    ASSERT_TRUE(queue.PopFor(value, std::chrono::milliseconds(1)) == PopResult::Popped);
+    ASSERT_EQUAL(6u, value);
+    ASSERT_TRUE(queue.PopFor(value, std::chrono::milliseconds(1)) == PopResult::Finished);
+}
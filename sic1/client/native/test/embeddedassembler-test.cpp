@@ -0,0 +1,200 @@
+#include "test.h"
+#include "test-programs.h"
+#include "../embeddedassembler.h"
+
+#include <random>
+#include <stdexcept>
+#include <string>
+
+using namespace Sic1;
+
+namespace {
+    // Assembled at compile time
+    constexpr const auto& sample = TestPrograms::sampleEmbedded;
+    static_assert(sample.size == 20);
+    static_assert(sample.bytes[0] == 15 && sample.bytes[1] == Constants::addressInput && sample.bytes[2] == 3);
+    static_assert(sample.GetLabelAddress("loop") == 6u);
+    static_assert(sample.GetLabelAddress("n_one") == 19u);
+    static_assert(!sample.GetLabelAddress("IN"));
+
+    constexpr const auto& bounds = TestPrograms::boundsEmbedded;
+    static_assert(bounds.size == 28);
+    static_assert(bounds.bytes[0] == Constants::addressOutput && bounds.bytes[1] == 21 && bounds.bytes[20] == Constants::addressHalt);
+    static_assert(bounds.bytes[21] == 0x80 && bounds.bytes[22] == 127 && bounds.bytes[24] == 0xff);
+    static_assert(bounds.GetLabelAddress("a") == 21u);
+    static_assert(bounds.GetLabelAddress("max") == 27u);
+    static_assert(bounds.labelCount == 7 && bounds.labels[0].isVariable);
+
+    // Expected results from lib/test/sic1asm.spec.ts
+    constexpr auto singleInstruction = EmbeddedAssembler::Assemble(TestPrograms::singleInstructionSource);
+    static_assert(singleInstruction.size == 3);
+    static_assert(singleInstruction.bytes[0] == Constants::addressOutput && singleInstruction.bytes[1] == Constants::addressInput && singleInstruction.bytes[2] == 3);
+
+    constexpr auto negationLoop = EmbeddedAssembler::Assemble(TestPrograms::negationLoopSource);
+    static_assert(negationLoop.size == 7);
+    static_assert(negationLoop.bytes[0] == Constants::addressOutput && negationLoop.bytes[1] == Constants::addressInput && negationLoop.bytes[2] == 3);
+    static_assert(negationLoop.bytes[3] == 6 && negationLoop.bytes[4] == 6 && negationLoop.bytes[5] == 0 && negationLoop.bytes[6] == 0);
+    static_assert(negationLoop.GetLabelAddress("zero") == 6u);
+    static_assert(negationLoop.labelCount == 2 && !negationLoop.labels[0].isVariable && negationLoop.labels[1].isVariable);
+
+    constexpr auto dataWithoutLabel = EmbeddedAssembler::Assemble(TestPrograms::dataWithoutLabelSource);
+    static_assert(dataWithoutLabel.size == 1 && dataWithoutLabel.bytes[0] == 0 && dataWithoutLabel.labelCount == 0);
+
+    constexpr auto inlineVariables = EmbeddedAssembler::Assemble(TestPrograms::inlineVariablesSource);
+    static_assert(inlineVariables.size == 3);
+    static_assert(inlineVariables.bytes[0] == 0 && inlineVariables.bytes[1] == 2 && inlineVariables.bytes[2] == 3);
+    static_assert(inlineVariables.GetLabelAddress("tmp") == 0u && inlineVariables.GetLabelAddress("tmp2") == 1u && inlineVariables.GetLabelAddress("three") == 2u);
+    static_assert(inlineVariables.labelCount == 3 && inlineVariables.labels[0].isVariable && inlineVariables.labels[1].isVariable && inlineVariables.labels[2].isVariable);
+
+    constexpr auto inlineLabelLoop = EmbeddedAssembler::Assemble(TestPrograms::inlineLabelLoopSource);
+    static_assert(inlineLabelLoop.size == 12);
+    static_assert(inlineLabelLoop.bytes[0] == 0 && inlineLabelLoop.bytes[1] == Constants::addressInput && inlineLabelLoop.bytes[2] == 3);
+    static_assert(inlineLabelLoop.bytes[6] == Constants::addressOutput && inlineLabelLoop.bytes[8] == 9 && inlineLabelLoop.bytes[11] == 0);
+    static_assert(inlineLabelLoop.GetLabelAddress("tmp") == 0u && inlineLabelLoop.labels[1].isVariable);
+
+    // Verifies that the embedded assembler (run at run time) produces the same program or error as Assembler
+    template<size_t LabelCapacity = 64>
+    void VerifyMatchesAssembler(const std::string& source) {
+        std::optional<AssembledProgram> expected;
+        std::optional<CompilationError> expectedError;
+        try {
+            expected = Assembler::Assemble(source);
+        }
+        catch (const CompilationError& error) {
+            expectedError = error;
+        }
+
+        if (expectedError) {
+            try {
+                EmbeddedAssembler::Assemble<LabelCapacity>(source);
+            }
+            catch (const CompilationError& error) {
+                ASSERT_EQUAL(std::string(GetCompilationErrorTypeName(expectedError->GetErrorType())), std::string(GetCompilationErrorTypeName(error.GetErrorType())));
+                ASSERT_EQUAL(std::string(expectedError->what()), std::string(error.what()));
+                return;
+            }
+            throw Test::AssertionError("Expected a compilation error for: " + source);
+        }
+
+        const EmbeddedProgram<LabelCapacity> program = EmbeddedAssembler::Assemble<LabelCapacity>(source);
+        ASSERT_TRUE(expected->bytes == program.GetBytes());
+        for (unsigned int address = program.size; address < Constants::memorySize; address++) {
+            ASSERT_EQUAL(0, program.bytes[address]);
+        }
+
+        std::vector<VariableDefinition> variables;
+        for (unsigned int i = 0; i < program.labelCount; i++) {
+            if (program.labels[i].isVariable) {
+                variables.push_back({ std::string(1, Syntax::referencePrefix) + std::string(program.labels[i].label), program.labels[i].address });
+            }
+        }
+
+        ASSERT_EQUAL(expected->variables.size(), variables.size());
+        for (size_t i = 0; i < variables.size(); i++) {
+            ASSERT_EQUAL(expected->variables[i].label, variables[i].label);
+            ASSERT_EQUAL(expected->variables[i].address, variables[i].address);
+        }
+    }
+
+    // Mostly valid lines (referring to labels that are usually defined), with a bit of everything
+    std::string CreateRandomLine(std::mt19937& random) {
+        const char* const addresses[] = { "0", "255", "@a", "@b+1", "-@a", "@loop-1", "@OUT", "@HALT", "@MAX", "@t1" };
+        const char* const values[] = { "0", "-128", "127", "'x'", "-'\\n'", "\"hi\\0\"", "-\"\"", "@a", "-@b+3", "@IN" };
+        const char* const invalidArguments[] = { "256", "128", "'\\q'", "@loop+300", ",", "@nowhere", "'x'", "%" };
+        const char* const invalidLabels[] = { "a", "IN", "constructor" };
+        const char* const separators[] = { " ", ", ", ",", "\t", "\xc2\xa0" };
+        const auto roll = [&](unsigned int n) { return std::uniform_int_distribution<unsigned int>(0, n - 1)(random); };
+
+        const bool subleq = (roll(2) == 0);
+        std::string line = ((subleq && roll(10) == 0) || roll(50) == 0) ? "!" : "";
+        if (roll(3) == 0) {
+            line += std::string("@") + ((roll(30) == 0) ? std::string(invalidLabels[roll(3)]) : ("t" + std::to_string(roll(20)))) + ": ";
+        }
+        line += (roll(50) == 0) ? "sub" : (subleq ? "subleq" : ".data");
+
+        const unsigned int count = (roll(30) == 0) ? roll(5) : (subleq ? 2 + roll(2) : 1 + roll(3));
+        for (unsigned int i = 0; i < count; i++) {
+            line += (roll(50) == 0) ? "" : ((i == 0) ? " " : separators[roll(5)]);
+            if (roll(8) == 0) {
+                line += "@i" + std::to_string(roll(100)) + ": ";
+            }
+
+            if (roll(30) == 0) {
+                line += invalidArguments[roll(8)];
+            }
+            else {
+                line += subleq ? addresses[roll(10)] : values[roll(10)];
+            }
+        }
+
+        if (roll(4) == 0) {
+            line += " ; Comment";
+        }
+        return line;
+    }
+}
+
+TEST_CASE("EmbeddedAssembler", "Programs") {
+    // The shared test programs are these images, so they're checked against the assembler
+    VerifyMatchesAssembler(TestPrograms::sampleSource);
+    VerifyMatchesAssembler(TestPrograms::boundsSource);
+
+    ASSERT_TRUE(negationLoop.GetBytes() == std::vector<uint8_t>({ 254, 253, 3, 6, 6, 0, 0 }));
+    ASSERT_TRUE(inlineLabelLoop.GetBytes() == std::vector<uint8_t>({ 0, 253, 3, 0, 253, 6, 254, 0, 9, 0, 0, 0 }));
+    for (const char* source : { TestPrograms::singleInstructionSource, TestPrograms::negationLoopSource, TestPrograms::dataWithoutLabelSource, TestPrograms::inlineVariablesSource, TestPrograms::inlineLabelLoopSource }) {
+        VerifyMatchesAssembler(source);
+    }
+
+    constexpr auto program = EmbeddedAssembler::Assemble(
+        "!@a: subleq @OUT, @text, @HALT\n"
+        "@text: .data \"Hi\\n\", @b: -'\\0', -@a+1, @MAX\n"
+        "@end:"
+    );
+    static_assert(program.size == 10);
+    static_assert(program.GetLabelAddress("b") == 7u);
+    static_assert(program.GetLabelAddress("end") == 10u);
+    static_assert(program.labelCount == 4 && program.labels[1].isVariable && program.labels[2].isVariable && !program.labels[3].isVariable);
+    ASSERT_TRUE(program.GetBytes() == std::vector<uint8_t>({ 254, 3, 255, 'H', 'i', '\n', 0, 0, 1, 252 }));
+
+    constexpr auto empty = EmbeddedAssembler::Assemble<1>("; Comment only\n\n");
+    static_assert(empty.size == 0 && empty.labelCount == 0);
+
+    std::string largest;
+    for (unsigned int i = 0; i <= Constants::addressUserMax; i++) {
+        largest += ".data 0\n";
+    }
+    VerifyMatchesAssembler(largest);
+    VerifyMatchesAssembler(largest + ".data 0");
+    VerifyMatchesAssembler("@x: .data \"" + std::string(Constants::addressUserMax, 'x') + "\"");
+    VerifyMatchesAssembler("@x: .data \"" + std::string(Constants::addressUserMax + 1, 'x') + "\"");
+}
+
+TEST_CASE("EmbeddedAssembler", "Errors") {
+    // Note: in a constant expression, these would fail to compile
+    VerifyMatchesAssembler("\nsubleq @OUT, @IN\n@zero: .data 128");
+    VerifyMatchesAssembler("\nsubleq @zero, @zero, @loop\n\n@zero: .data 0");
+    VerifyMatchesAssembler("\n@loop:\nsubleq @OUT, @IN, @loop-1");
+    VerifyMatchesAssembler("@tmp:\nsubleq @tmp, @IN\n@tmp: .data 0");
+    VerifyMatchesAssembler("\n!.data 1 2 3");
+    VerifyMatchesAssembler("\n.data %");
+
+    // Valid programs that exceed the label capacity aren't compilation errors
+    VerifyMatchesAssembler<2>("@a: @b: .data 1");
+    ASSERT_THROWS(EmbeddedAssembler::Assemble<2>("@a: @b: @c: .data 1"), std::length_error);
+}
+
+TEST_CASE("EmbeddedAssembler", "Random programs") {
+    std::mt19937 random(13);
+    for (int i = 0; i < 5000; i++) {
+        std::string source;
+        const unsigned int lineCount = std::uniform_int_distribution<unsigned int>(1, 6)(random);
+        for (unsigned int line = 0; line < lineCount; line++) {
+            source += ((line > 0) ? "\n" : "") + CreateRandomLine(random);
+        }
+
+        if (std::uniform_int_distribution<unsigned int>(0, 3)(random) != 0) {
+            source += "\n@a: .data 1\n@b: .data 2\n@loop: subleq @a, @b";
+        }
+        VerifyMatchesAssembler(source);
+    }
+}
@@ -0,0 +1,266 @@
+#include <vector>
+#include "test.h"
+#include "test-programs.h"
+#include "../emulator.h"
+
+using namespace Sic1;
+using namespace TestPrograms;
+
+namespace {
+    // Runs until the expected number of outputs have been produced
+    void VerifyProgram(const std::vector<int>& inputs, const std::vector<int>& expectedOutputs, const std::vector<uint8_t>& bytes) {
+        Emulator emulator(bytes);
+        ListIo io(inputs);
+
+        ASSERT_FALSE(emulator.IsEmpty());
+        ASSERT_TRUE(emulator.IsRunning());
+
+        unsigned int steps = 0;
+        while (io.outputs.size() < expectedOutputs.size()) {
+            ASSERT_TRUE(++steps <= 1000);
+            emulator.Step(io);
+        }
+
+        ASSERT_TRUE(io.outputs == expectedOutputs);
+    }
+}
+
+TEST_CASE("SIC-1 Emulator", "Empty program") {
+    Emulator emulator(std::vector<uint8_t>{});
+    ASSERT_TRUE(emulator.IsEmpty());
+}
+
+TEST_CASE("SIC-1 Emulator", "Negation input/output") {
+    // @loop:
+    // subleq @OUT, @IN
+    // subleq @0, @0, @loop
+    // @0: .data 0
+    VerifyProgram({ 4, 5, 100, 101 }, { -4, -5, -100, -101 }, { 254, 253, 3, 6, 6, 0, 0 });
+}
+
+TEST_CASE("SIC-1 Emulator", "Writes to reserved addresses shouldn't update memory") {
+    // subleq @IN, @one
+    // subleq @OUT, @one
+    // subleq @HALT, @one
+    // subleq @OUT, @IN
+    // subleq @OUT, @OUT
+    // subleq @OUT, @HALT
+    // @one: .data 1
+    const std::vector<uint8_t> bytes = {
+        253, 18, 3,
+        254, 18, 6,
+        255, 18, 9,
+        254, 253, 12,
+        254, 254, 15,
+        254, 255, 18,
+        1,
+    };
+
+    VerifyProgram({ 45, 123 }, { -1, -123, 0, 0 }, bytes);
+
+    Emulator emulator(bytes);
+    ListIo io({ 45, 123 });
+    emulator.Run(io, 6);
+    ASSERT_EQUAL(0, emulator.GetMemory(Constants::addressInput));
+    ASSERT_EQUAL(0, emulator.GetMemory(Constants::addressOutput));
+    ASSERT_EQUAL(0, emulator.GetMemory(Constants::addressHalt));
+}
+
+TEST_CASE("SIC-1 Emulator", "Sample program") {
+    Emulator emulator(sampleProgram);
+    ListIo io({ 3 });
+    emulator.Run(io);
+
+    ASSERT_TRUE(io.outputs == std::vector<int>({ 1, 1, 1 }));
+    ASSERT_FALSE(emulator.IsRunning());
+    ASSERT_EQUAL(12u, emulator.GetCyclesExecuted());
+    ASSERT_EQUAL(22u, emulator.GetMemoryBytesAccessed());
+}
+
+TEST_CASE("SIC-1 Emulator", "Metrics") {
+    // subleq @tmp, @five
+    // subleq @tmp, @tmp, @HALT
+    // @five: .data 5
+    // @tmp: .data 0
+    Emulator emulator(std::vector<uint8_t>{ 7, 6, 3, 7, 7, 255, 5, 0 });
+    NullIo io;
+
+    emulator.Step(io);
+    ASSERT_TRUE(emulator.IsRunning());
+    ASSERT_EQUAL(3u, emulator.GetIp());
+    ASSERT_EQUAL(1u, emulator.GetCyclesExecuted());
+    ASSERT_EQUAL(5u, emulator.GetMemoryBytesAccessed());
+    ASSERT_EQUAL(0xfb, emulator.GetMemory(7));
+
+    emulator.Step(io);
+    ASSERT_FALSE(emulator.IsRunning());
+    ASSERT_EQUAL(2u, emulator.GetCyclesExecuted());
+    ASSERT_EQUAL(8u, emulator.GetMemoryBytesAccessed());
+}
+
+TEST_CASE("SIC-1 Emulator", "Wrapping arithmetic") {
+    // subleq @a, @b
+    // subleq @OUT, @a, @HALT
+    // @a: .data -128
+    // @b: .data 1
+    Emulator emulator(std::vector<uint8_t>{ 6, 7, 3, 254, 6, 255, 0x80, 1 });
+    ListIo io({});
+    emulator.Run(io);
+
+    ASSERT_EQUAL(127, emulator.GetMemory(6));
+    ASSERT_TRUE(io.outputs == std::vector<int>({ -127 }));
+}
+
+TEST_CASE("SIC-1 Emulator", "Reading past the end of input produces zero") {
+    // subleq @a, @IN, @zero
+    // subleq @OUT, @a, @HALT
+    // @zero:
+    // subleq @OUT, @a, @HALT
+    // @a: .data 5
+    Emulator emulator(std::vector<uint8_t>{ 9, 253, 6, 254, 9, 255, 254, 9, 255, 5 });
+    ListIo io({});
+    emulator.Step(io);
+
+    ASSERT_EQUAL(0, emulator.GetMemory(9));
+    ASSERT_EQUAL(6u, emulator.GetIp());
+}
+
+TEST_CASE("SIC-1 Emulator", "Reset") {
+    Emulator emulator(sampleProgram);
+    ListIo io({ 3, 2 });
+    emulator.Run(io);
+    emulator.Reset();
+
+    ASSERT_TRUE(emulator.IsRunning());
+    ASSERT_EQUAL(0u, emulator.GetCyclesExecuted());
+    ASSERT_EQUAL(0u, emulator.GetMemoryBytesAccessed());
+    for (unsigned int i = 0; i < sampleProgram.size(); i++) {
+        ASSERT_EQUAL(sampleProgram[i], emulator.GetMemory(i));
+    }
+
+    emulator.Run(io);
+    ASSERT_TRUE(io.outputs == std::vector<int>({ 1, 1, 1, 1, 1 }));
+}
+
+TEST_CASE("SIC-1 Emulator", "Memory updates") {
+    Emulator emulator(sampleProgram);
+    ListIo io({ 3 });
+
+    // Loading counts as writing all of memory
+    ASSERT_TRUE(emulator.HasMemoryUpdate());
+    MemoryUpdate update = emulator.TakeMemoryUpdate();
+    ASSERT_TRUE(update.changed.all());
+    ASSERT_EQUAL(static_cast<size_t>(Constants::memorySize), update.values.size());
+    for (unsigned int i = 0; i < sampleProgram.size(); i++) {
+        ASSERT_EQUAL(sampleProgram[i], update.values[i]);
+    }
+    ASSERT_FALSE(emulator.HasMemoryUpdate());
+
+    // subleq @tmp, @IN
+    emulator.Step(io);
+    update = emulator.TakeMemoryUpdate();
+    ASSERT_EQUAL(1u, update.changed.count());
+    ASSERT_TRUE(update.changed[15]);
+    ASSERT_EQUAL(1u, update.values.size());
+    ASSERT_EQUAL(0xfc, update.values[0]);
+
+    // Repeated writes to @count and @zero are coalesced (and output isn't a memory write)
+    emulator.Run(io);
+    update = emulator.TakeMemoryUpdate();
+    ASSERT_EQUAL(2u, update.changed.count());
+    ASSERT_TRUE(update.changed[16] && update.changed[17]);
+    ASSERT_EQUAL(2u, update.values.size());
+    ASSERT_EQUAL(0, update.values[0]);
+    ASSERT_EQUAL(0, update.values[1]);
+
+    emulator.Reset();
+    ASSERT_TRUE(emulator.TakeMemoryUpdate().changed.all());
+}
+
+namespace {
+    // Ports just below the top of memory, with one unused address above them
+    template<unsigned int memorySize>
+    struct OffsetIoLayout {
+        static constexpr unsigned int addressInput = memorySize - 4;
+        static constexpr unsigned int addressOutput = memorySize - 3;
+        static constexpr unsigned int addressHalt = memorySize - 2;
+        static constexpr unsigned int addressInstructionMax = memorySize - 5 - Constants::subleqInstructionBytes;
+    };
+}
+
+TEST_CASE("SIC-1 Emulator", "Wider machines") {
+    // 16-bit words and addresses (stored on the heap)
+    typedef SubleqMachine<uint16_t, 16> Machine16;
+    static_assert(Machine16::addressInput == 65533 && !Machine16::memoryInline);
+    {
+        BasicEmulator<Machine16> emulator(CreateAdditionProgram<Machine16>());
+        WordListIo<Machine16> io({ 1000, 2000, 30000, 2767, 32767, 1 });
+        while (io.outputs.size() < 3) {
+            emulator.Step(io);
+        }
+
+        // Arithmetic wraps around at the word size
+        ASSERT_TRUE(io.outputs == std::vector<int64_t>({ 3000, 32767, -32768 }));
+        ASSERT_EQUAL(11u, emulator.GetCyclesExecuted());
+        ASSERT_EQUAL(BasicEmulator<Machine16>::HashMemory(emulator.GetMemory()), emulator.GetMemoryHash());
+    }
+
+    // 32-bit words with 12-bit addresses: operands are masked to the address width
+    typedef SubleqMachine<uint32_t, 12> Machine32;
+    {
+        std::vector<uint32_t> words = CreateAdditionProgram<Machine32>();
+        words[0] |= 0xfffff000;
+        words[2] |= 0x12345000;
+        BasicEmulator<Machine32> emulator(words);
+        WordListIo<Machine32> io({ 100000, -300000 });
+        while (io.outputs.empty()) {
+            emulator.Step(io);
+        }
+
+        ASSERT_EQUAL(-200000, io.outputs[0]);
+        ASSERT_EQUAL(9u, emulator.GetIp());
+        ASSERT_EQUAL(200000u, emulator.GetMemory(12));
+        ASSERT_EQUAL(0xfffff00cu, emulator.GetMemory(0));
+
+        emulator.Reset();
+        ASSERT_EQUAL(0u, emulator.GetMemory(12));
+        ASSERT_TRUE(emulator.IsRunning());
+    }
+
+    // Alternate I/O layout
+    typedef SubleqMachine<uint8_t, 8, OffsetIoLayout> OffsetMachine;
+    {
+        BasicEmulator<OffsetMachine> emulator(CreateAdditionProgram<OffsetMachine>());
+        WordListIo<OffsetMachine> io({ 3, 4 });
+        emulator.Run(io, 3);
+        ASSERT_TRUE(io.outputs == std::vector<int64_t>({ 7 }));
+
+        // Writes to the unused top address are ordinary memory writes
+        BasicEmulator<OffsetMachine> writer(std::vector<uint8_t>{ 255, 1, 249 });
+        writer.Step(io);
+        ASSERT_EQUAL(0xff, writer.GetMemory(255));
+        ASSERT_EQUAL(249u, writer.GetIp());
+        ASSERT_FALSE(writer.IsRunning());
+    }
+}
+
+TEST_CASE("SIC-1 Emulator", "Halt") {
+    const struct {
+        uint8_t target;
+        bool shouldHalt;
+    } cases[] = {
+        { Constants::addressUserMax, false },
+        { Constants::addressInstructionMax, false },
+        { Constants::addressUserMax + 1, true },
+        { Constants::addressUserMax + 2, true },
+        { Constants::addressHalt, true },
+        { Constants::addressInstructionMax + 1, true },
+    };
+
+    for (const auto& testCase : cases) {
+        Emulator emulator(std::vector<uint8_t>{ 0, 0, testCase.target });
+        NullIo io;
+        emulator.Step(io);
+        ASSERT_EQUAL(!testCase.shouldHalt, emulator.IsRunning());
+    }
+}
@@ -0,0 +1,198 @@
+#include "test.h"
+#include "../incrementalassembler.h"
+
+#include <random>
+
+using namespace Sic1;
+
+namespace {
+    // Verifies that the session produces exactly what a full assembly of its lines does
+    void VerifyMatchesFullAssembly(IncrementalAssembler& session) {
+        std::vector<std::string> lines;
+        for (size_t i = 0; i < session.GetLineCount(); i++) {
+            lines.push_back(session.GetLine(i));
+        }
+
+        std::optional<AssembledProgram> expected;
+        std::optional<CompilationError> expectedError;
+        try {
+            expected = Assembler::Assemble(lines);
+        }
+        catch (const CompilationError& error) {
+            expectedError = error;
+        }
+
+        const auto& error = session.GetError();
+        ASSERT_EQUAL(expectedError.has_value(), error.has_value());
+        if (expectedError) {
+            ASSERT_EQUAL(std::string(GetCompilationErrorTypeName(expectedError->GetErrorType())), std::string(GetCompilationErrorTypeName(error->GetErrorType())));
+            ASSERT_EQUAL(std::string(expectedError->what()), std::string(error->what()));
+
+            const auto& expectedContext = expectedError->GetContext();
+            const auto& context = error->GetContext();
+            ASSERT_TRUE(expectedContext.sourceLineNumber == context.sourceLineNumber);
+            ASSERT_TRUE(expectedContext.sourceLine == context.sourceLine);
+            ASSERT_TRUE(expectedContext.text == context.text);
+            ASSERT_TRUE(expectedContext.number == context.number);
+            ASSERT_TRUE(expectedContext.rangeMin == context.rangeMin);
+            ASSERT_TRUE(expectedContext.rangeMax == context.rangeMax);
+            ASSERT_THROWS(session.GetProgram(), CompilationError);
+            return;
+        }
+
+        const AssembledProgram& program = session.GetProgram();
+        ASSERT_TRUE(expected->bytes == program.bytes);
+        ASSERT_TRUE(expected->breakpoints == program.breakpoints);
+
+        ASSERT_EQUAL(expected->sourceMap.size(), program.sourceMap.size());
+        for (size_t i = 0; i < program.sourceMap.size(); i++) {
+            ASSERT_EQUAL(expected->sourceMap[i].has_value(), program.sourceMap[i].has_value());
+            if (program.sourceMap[i]) {
+                ASSERT_EQUAL(expected->sourceMap[i]->lineNumber, program.sourceMap[i]->lineNumber);
+                ASSERT_TRUE(expected->sourceMap[i]->command == program.sourceMap[i]->command);
+                ASSERT_EQUAL(expected->sourceMap[i]->source, program.sourceMap[i]->source);
+            }
+        }
+
+        ASSERT_EQUAL(expected->variables.size(), program.variables.size());
+        for (size_t i = 0; i < program.variables.size(); i++) {
+            ASSERT_EQUAL(expected->variables[i].label, program.variables[i].label);
+            ASSERT_EQUAL(expected->variables[i].address, program.variables[i].address);
+        }
+
+        ASSERT_EQUAL(static_cast<unsigned int>(program.bytes.size()), session.GetByteCount());
+    }
+
+    // Mostly valid lines that reference a few labels (which get defined, redefined, and removed as lines change)
+    std::string CreateRandomLine(std::mt19937& random) {
+        const char* const labels[] = { "a", "b", "c", "loop" };
+        const char* const addresses[] = { "0", "9", "@a", "@b+1", "-@c", "@loop", "@IN", "@OUT", "@HALT", "@IN", "@OUT", "12" };
+        const char* const values[] = { "0", "-1", "127", "'x'", "\"hi\"", "@a", "-@b", "@loop+1", "@OUT" };
+        const char* const invalidArguments[] = { "300", "'x'", "@d", "@a-5", "@b+250" };
+        const auto roll = [&](unsigned int n) { return std::uniform_int_distribution<unsigned int>(0, n - 1)(random); };
+
+        switch (roll(40)) {
+            case 0: return "";
+            case 1: return "; Comment";
+            case 2: return std::string("@") + labels[roll(4)] + ":";
+            case 3: return "subleq @a @a @a%";
+        }
+
+        const bool subleq = (roll(2) == 0);
+        std::string line = (subleq && roll(10) == 0) ? "!" : "";
+        if (roll(3) == 0) {
+            // Mostly new labels, so that redefinitions are occasional
+            line += "@t" + std::to_string(roll(100)) + ": ";
+        }
+        line += subleq ? "subleq" : ".data";
+
+        const unsigned int count = subleq ? 2 + roll(2) : 1 + roll(3);
+        for (unsigned int i = 0; i < count; i++) {
+            line += (i == 0) ? " " : ", ";
+            if (roll(10) == 0) {
+                line += "@i" + std::to_string(roll(1000)) + ": ";
+            }
+
+            if (roll(100) == 0) {
+                line += invalidArguments[roll(5)];
+            }
+            else {
+                line += subleq ? addresses[roll(12)] : values[roll(9)];
+            }
+        }
+        return line;
+    }
+}
+
+TEST_CASE("IncrementalAssembler", "Edits") {
+    IncrementalAssembler session({
+        "@loop:",
+        "subleq @OUT, @IN",
+        "subleq @zero, @zero, @loop",
+        "@zero: .data 0",
+    });
+
+    ASSERT_TRUE(session.GetProgram().bytes == std::vector<uint8_t>({ 254, 253, 3, 6, 6, 0, 0 }));
+    VerifyMatchesFullAssembly(session);
+
+    // Same size: only the line itself changes
+    session.SetLine(1, "subleq @OUT, @zero");
+    ASSERT_TRUE(session.GetProgram().bytes == std::vector<uint8_t>({ 254, 6, 3, 6, 6, 0, 0 }));
+    VerifyMatchesFullAssembly(session);
+
+    // Inserting a line moves @zero, so its references are re-resolved
+    session.ReplaceLines(1, 0, { "subleq @IN, @IN" });
+    ASSERT_TRUE(session.GetProgram().bytes == std::vector<uint8_t>({ 253, 253, 3, 254, 9, 6, 9, 9, 0, 0 }));
+    ASSERT_EQUAL(2u, session.GetProgram().sourceMap[3]->lineNumber);
+    VerifyMatchesFullAssembly(session);
+
+    // Errors match a full assembly (and clear once fixed)
+    session.SetLine(3, "subleq @zero, @zero, @nowhere");
+    ASSERT_TRUE(session.GetError()->GetErrorType() == CompilationErrorType::UndefinedReferenceError);
+    VerifyMatchesFullAssembly(session);
+
+    session.SetLine(3, "subleq @zero, @zero, @toString");
+    ASSERT_TRUE(session.GetError()->GetErrorType() == CompilationErrorType::UndefinedReferenceError);
+    VerifyMatchesFullAssembly(session);
+
+    session.SetLine(3, "subleq @zero, @zero, @nowhere");
+
+    session.ReplaceLines(0, 1, { "@nowhere:", "@zero: .data 1" });
+    ASSERT_TRUE(session.GetError()->GetErrorType() == CompilationErrorType::LabelAlreadyDefinedError);
+    ASSERT_EQUAL(6u, *session.GetError()->GetContext().sourceLineNumber);
+    VerifyMatchesFullAssembly(session);
+
+    session.ReplaceLines(1, 1, {});
+    ASSERT_FALSE(session.GetError().has_value());
+    VerifyMatchesFullAssembly(session);
+}
+
+TEST_CASE("IncrementalAssembler", "Random edits") {
+    std::mt19937 random(12);
+    const auto roll = [&](unsigned int n) { return std::uniform_int_distribution<unsigned int>(0, n - 1)(random); };
+
+    for (int sequence = 0; sequence < 100; sequence++) {
+        // The labels are defined at the end (so they move as lines are edited), and are usually left alone
+        IncrementalAssembler session({ "@a: .data 1", "@b: .data 2", "@c: subleq @a, @b", "@loop: subleq @c, @c, @loop" });
+        for (int edit = 0; edit < 60; edit++) {
+            const size_t lineCount = (roll(20) == 0) ? session.GetLineCount() : session.GetLineCount() - std::min<size_t>(session.GetLineCount(), 4);
+            const size_t index = roll(static_cast<unsigned int>(lineCount + 1));
+            switch (roll(4)) {
+                case 0:
+                    session.ReplaceLines(index, 0, { CreateRandomLine(random), CreateRandomLine(random) });
+                    break;
+
+                case 1:
+                    session.ReplaceLines(index, std::min<size_t>(lineCount - index, roll(3)), {});
+                    break;
+
+                default:
+                    if (index < lineCount) {
+                        session.SetLine(index, CreateRandomLine(random));
+                    }
+                    else {
+                        session.ReplaceLines(index, 0, { CreateRandomLine(random) });
+                    }
+                    break;
+            }
+
+            // Occasionally batch multiple edits before checking
+            if (roll(4) != 0) {
+                VerifyMatchesFullAssembly(session);
+            }
+        }
+    }
+}
+
+TEST_CASE("IncrementalAssembler", "Program size") {
+    IncrementalAssembler session(std::vector<std::string>(Constants::addressUserMax + 1, ".data 0"));
+    ASSERT_FALSE(session.GetError().has_value());
+
+    session.ReplaceLines(0, 0, { "@last: .data @last" });
+    ASSERT_TRUE(session.GetError()->GetErrorType() == CompilationErrorType::ProgramTooLargeError);
+    ASSERT_EQUAL(Constants::addressUserMax + 2, session.GetByteCount());
+    VerifyMatchesFullAssembly(session);
+
+    session.SetLine(1, "");
+    VerifyMatchesFullAssembly(session);
+}
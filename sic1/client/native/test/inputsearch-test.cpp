@@ -0,0 +1,187 @@
+#include <stdexcept>
+#include "test.h"
+#include "../assembler.h"
+#include "../inputsearch.h"
+
+using namespace Sic1;
+
+namespace {
+    // Addition solution that's only wrong on the third row whose inputs are both 9, so it only fails on the one random
+    // test (out of a million) whose rows are all { 9, 9 }
+    const char* trapdoorSource =
+        "@loop:\n"
+        "subleq @a, @IN\n"
+        "subleq @b, @IN\n"
+        "subleq @s, @a\n"
+        "subleq @s, @b\n"
+        "subleq @x, @s\n"
+        "subleq @t, @a\n"
+        "subleq @t, @nine, @aLow\n"
+        "subleq @zero, @zero, @output\n"
+        "@aLow:\n"
+        "subleq @u, @t, @aNine\n"
+        "subleq @zero, @zero, @output\n"
+        "@aNine:\n"
+        "subleq @v, @b\n"
+        "subleq @v, @nine, @bLow\n"
+        "subleq @zero, @zero, @output\n"
+        "@bLow:\n"
+        "subleq @w, @v, @bNine\n"
+        "subleq @zero, @zero, @output\n"
+        "@bNine:\n"
+        "subleq @count, @one, @bug\n"
+        "subleq @zero, @zero, @output\n"
+        "@bug:\n"
+        "subleq @x, @one\n"
+        "@output:\n"
+        "subleq @OUT, @x\n"
+        "subleq @a, @a\n"
+        "subleq @b, @b\n"
+        "subleq @s, @s\n"
+        "subleq @x, @x\n"
+        "subleq @t, @t\n"
+        "subleq @u, @u\n"
+        "subleq @v, @v\n"
+        "subleq @w, @w, @loop\n"
+        "@a: .data 0\n"
+        "@b: .data 0\n"
+        "@s: .data 0\n"
+        "@x: .data 0\n"
+        "@t: .data 0\n"
+        "@u: .data 0\n"
+        "@v: .data 0\n"
+        "@w: .data 0\n"
+        "@count: .data 3\n"
+        "@one: .data 1\n"
+        "@nine: .data 9\n"
+        "@zero: .data 0\n";
+
+    // Addition solution that's wrong whenever the sum is at least 15
+    const char* largeSumSource =
+        "@loop:\n"
+        "subleq @a, @IN\n"
+        "subleq @b, @IN\n"
+        "subleq @s, @a\n"
+        "subleq @s, @b\n"
+        "subleq @x, @s\n"
+        "subleq @t, @s\n"
+        "subleq @t, @n_fifteen, @bug\n"
+        "subleq @zero, @zero, @output\n"
+        "@bug:\n"
+        "subleq @x, @one\n"
+        "@output:\n"
+        "subleq @OUT, @x\n"
+        "subleq @a, @a\n"
+        "subleq @b, @b\n"
+        "subleq @s, @s\n"
+        "subleq @x, @x\n"
+        "subleq @t, @t, @loop\n"
+        "@a: .data 0\n"
+        "@b: .data 0\n"
+        "@s: .data 0\n"
+        "@x: .data 0\n"
+        "@t: .data 0\n"
+        "@one: .data 1\n"
+        "@n_fifteen: .data -15\n"
+        "@zero: .data 0\n";
+
+    // Correct Addition solution
+    const char* correctSource =
+        "@loop:\n"
+        "subleq @s, @IN\n"
+        "subleq @s, @IN\n"
+        "subleq @OUT, @s\n"
+        "subleq @s, @s, @loop\n"
+        "@s: .data 0\n";
+
+    InputSearchOptions CreateOptions(uint64_t seed, uint64_t executionsMax) {
+        InputSearchOptions options = {};
+        options.seed = seed;
+        options.executionsMax = executionsMax;
+        options.minimizationExecutionsMax = 1000;
+        return options;
+    }
+
+    bool IsFoundBlindly(const Puzzle& puzzle, const std::vector<uint8_t>& bytes, uint64_t seed, uint64_t executionsMax) {
+        for (uint64_t i = 0; i < executionsMax; i++) {
+            Random random(Random::DeriveSeed(seed, i));
+            if (VerifyProgram(bytes, CreateTestSet(puzzle, puzzle.createRandomTest(random)), verificationCyclesExecutedMax, solutionBytesMax).status != VerificationStatus::Success) {
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+TEST_CASE("InputSearch", "Random tapes") {
+    // Numbers are recorded on the tape, and replayed from it
+    std::vector<uint64_t> tape;
+    Random recording(7, &tape);
+    const uint64_t first = recording.NextUInt64();
+    recording.NextUInt64();
+    ASSERT_EQUAL(2u, tape.size());
+    ASSERT_EQUAL(first, tape[0]);
+    ASSERT_EQUAL(Random(7).NextUInt64(), first);
+
+    tape[1] = 0;
+    Random replaying(8, &tape);
+    ASSERT_EQUAL(first, replaying.NextUInt64());
+    ASSERT_EQUAL(0u, replaying.NextUInt64());
+    ASSERT_EQUAL(Random(8, 2).NextUInt64(), replaying.NextUInt64());
+    ASSERT_EQUAL(3u, tape.size());
+}
+
+TEST_CASE("InputSearch", "Rare failure") {
+    const Puzzle& puzzle = *FindPuzzle("Addition");
+    const std::vector<uint8_t> bytes = Assembler::Assemble(trapdoorSource).bytes;
+    const uint64_t executionsMax = 20000;
+
+    // Blind sampling would need about a million test sets...
+    ASSERT_FALSE(IsFoundBlindly(puzzle, bytes, 1, executionsMax));
+
+    // ... but coverage leads the search to the failure
+    const InputSearchResult result = SearchForFailingInput(puzzle, bytes, CreateOptions(1, executionsMax));
+    ASSERT_TRUE(result.found);
+    ASSERT_TRUE(result.executions < executionsMax);
+    ASSERT_TRUE(result.corpusSize > 0);
+    ASSERT_TRUE(result.input == PuzzleIoGroups({ { 9, 9 }, { 9, 9 }, { 9, 9 } }));
+    ASSERT_TRUE(result.testSet.input == std::vector<int8_t>({ 9, 9, 9, 9, 9, 9 }));
+    ASSERT_TRUE(result.testSet.output == std::vector<int8_t>({ 18, 18, 18 }));
+    ASSERT_TRUE(result.result.status == VerificationStatus::IncorrectOutput);
+    ASSERT_EQUAL(2u, result.result.errorOutputIndex);
+    ASSERT_EQUAL(18, result.result.errorExpected);
+    ASSERT_EQUAL(19, result.result.errorActual);
+}
+
+TEST_CASE("InputSearch", "Minimization") {
+    const Puzzle& puzzle = *FindPuzzle("Addition");
+    const std::vector<uint8_t> bytes = Assembler::Assemble(largeSumSource).bytes;
+
+    // Unneeded rows are removed, and the remaining row's sum is as small as possible
+    const InputSearchResult result = SearchForFailingInput(puzzle, bytes, CreateOptions(2, 1000));
+    ASSERT_TRUE(result.found);
+    ASSERT_TRUE(result.minimizationExecutions > 0);
+    ASSERT_EQUAL(1u, result.input.size());
+    ASSERT_EQUAL(15, result.input[0][0] + result.input[0][1]);
+    ASSERT_TRUE(result.result.status == VerificationStatus::IncorrectOutput);
+    ASSERT_EQUAL(0u, result.result.errorOutputIndex);
+}
+
+TEST_CASE("InputSearch", "Correct solution") {
+    const Puzzle& puzzle = *FindPuzzle("Addition");
+    const std::vector<uint8_t> bytes = Assembler::Assemble(correctSource).bytes;
+
+    const InputSearchResult result = SearchForFailingInput(puzzle, bytes, CreateOptions(3, 2000));
+    ASSERT_FALSE(result.found);
+    ASSERT_EQUAL(2000u, result.executions);
+    ASSERT_EQUAL(0u, result.minimizationExecutions);
+    ASSERT_TRUE(result.input.empty() || result.result.status == VerificationStatus::Success);
+
+    // Puzzles without random tests can't be searched
+    for (const auto& other : GetPuzzles()) {
+        if (!other.createRandomTest) {
+            ASSERT_THROWS(SearchForFailingInput(other, bytes, CreateOptions(3, 10)), std::invalid_argument);
+            break;
+        }
+    }
+}
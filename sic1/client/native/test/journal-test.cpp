@@ -0,0 +1,175 @@
+#include <random>
+#include <stdexcept>
+#include "test.h"
+#include "test-programs.h"
+#include "../journal.h"
+
+using namespace Sic1;
+using namespace TestPrograms;
+
+namespace {
+    std::vector<int8_t> ToInput(const std::vector<int>& values) {
+        return std::vector<int8_t>(values.begin(), values.end());
+    }
+
+    // Checks that the journaling emulator is in exactly the state that a fresh emulator reaches after the same number of
+    // cycles
+    void VerifyMatchesReplay(const JournalingEmulator& actual, const std::vector<uint8_t>& bytes, const std::vector<int>& inputs) {
+        Emulator expected(bytes);
+        ListIo io(inputs);
+        expected.Run(io, actual.GetCyclesExecuted());
+
+        ASSERT_EQUAL(expected.GetCyclesExecuted(), actual.GetCyclesExecuted());
+        ASSERT_EQUAL(expected.IsRunning(), actual.IsRunning());
+        ASSERT_EQUAL(expected.GetIp(), actual.GetIp());
+        ASSERT_EQUAL(expected.GetMemoryBytesAccessed(), actual.GetMemoryBytesAccessed());
+        ASSERT_EQUAL(expected.GetMemoryHash(), actual.GetMemoryHash());
+        for (unsigned int address = 0; address <= Constants::addressMax; address++) {
+            ASSERT_EQUAL(expected.GetMemory(address), actual.GetMemory(address));
+        }
+
+        ASSERT_EQUAL(io.outputs.size(), actual.GetOutput().size());
+        for (size_t i = 0; i < io.outputs.size(); i++) {
+            ASSERT_EQUAL(io.outputs[i], static_cast<int>(actual.GetOutput()[i]));
+        }
+    }
+}
+
+TEST_CASE("Journal", "Sample program") {
+    JournalingEmulator emulator(sampleProgram, { 3 });
+    while (emulator.IsRunning()) {
+        emulator.Step();
+    }
+
+    ASSERT_TRUE(emulator.GetOutput() == std::vector<int8_t>({ 1, 1, 1 }));
+    ASSERT_EQUAL(12u, emulator.GetCyclesExecuted());
+    ASSERT_EQUAL(22u, emulator.GetMemoryBytesAccessed());
+
+    // Step all the way back (undoing output, input, writes, and memory accesses)
+    for (uint64_t cycle = 12; cycle > 0; cycle--) {
+        ASSERT_TRUE(emulator.StepBack());
+        VerifyMatchesReplay(emulator, sampleProgram, { 3 });
+    }
+
+    ASSERT_FALSE(emulator.StepBack());
+    ASSERT_EQUAL(0u, emulator.GetInputIndex());
+    ASSERT_EQUAL(0u, emulator.GetMemoryBytesAccessed());
+
+    // Seeking past the end stops once halted
+    ASSERT_TRUE(emulator.Seek(5));
+    VerifyMatchesReplay(emulator, sampleProgram, { 3 });
+    ASSERT_FALSE(emulator.Seek(100));
+    ASSERT_EQUAL(12u, emulator.GetCyclesExecuted());
+
+    emulator.Reset();
+    VerifyMatchesReplay(emulator, sampleProgram, { 3 });
+}
+
+TEST_CASE("Journal", "Random seeks") {
+    std::mt19937 random(16);
+    for (int i = 0; i < 50; i++) {
+        const std::vector<uint8_t> bytes = CreateRandomProgram(random);
+        const std::vector<int> inputs = CreateRandomInputs(random, 50);
+        JournalingEmulator emulator(bytes, ToInput(inputs), 16);
+
+        for (int seek = 0; seek < 30; seek++) {
+            const uint64_t cycle = std::uniform_int_distribution<uint64_t>(0, 300)(random);
+            if (std::uniform_int_distribution<int>(0, 3)(random) == 0) {
+                for (uint64_t steps = cycle % 20; steps > 0 && emulator.StepBack(); steps--) {
+                }
+            }
+            else {
+                emulator.Seek(cycle);
+            }
+            VerifyMatchesReplay(emulator, bytes, inputs);
+        }
+    }
+}
+
+TEST_CASE("Journal", "Budget") {
+    // @loop:
+    // subleq @OUT, @IN
+    // subleq @0, @0, @loop
+    // @0: .data 0
+    const std::vector<uint8_t> bytes = { 254, 253, 3, 6, 6, 0, 0 };
+    std::vector<int> inputs;
+    for (int i = 0; i < 50000; i++) {
+        inputs.push_back(i % 100);
+    }
+
+    const size_t budgetBytes = 64 * 1024;
+    JournalingEmulator emulator(bytes, ToInput(inputs), 1000, budgetBytes);
+    ASSERT_TRUE(emulator.Seek(100000));
+    ASSERT_TRUE(emulator.GetJournalBytes() <= budgetBytes);
+
+    // Old cycles have been discarded, but recent ones are still reachable
+    const uint64_t earliest = emulator.GetEarliestCycle();
+    ASSERT_TRUE(earliest > 0 && earliest % 1000 == 0);
+    ASSERT_THROWS(emulator.Seek(earliest - 1), std::out_of_range);
+
+    ASSERT_TRUE(emulator.Seek(earliest + 1));
+    VerifyMatchesReplay(emulator, bytes, inputs);
+    ASSERT_TRUE(emulator.Seek(99999));
+    VerifyMatchesReplay(emulator, bytes, inputs);
+    ASSERT_TRUE(emulator.Seek(earliest));
+    ASSERT_FALSE(emulator.StepBack());
+    VerifyMatchesReplay(emulator, bytes, inputs);
+}
+
+TEST_CASE("Journal", "Rewind and seek forward") {
+    // Same program as "Budget"
+    const std::vector<uint8_t> bytes = { 254, 253, 3, 6, 6, 0, 0 };
+    std::vector<int> inputs;
+    for (int i = 0; i < 50000; i++) {
+        inputs.push_back(i % 100);
+    }
+
+    JournalingEmulator emulator(bytes, ToInput(inputs), 1000);
+    ASSERT_TRUE(emulator.Seek(100000));
+    ASSERT_EQUAL(100000u, emulator.GetInstructionsExecuted());
+
+    // Rewinding keeps the later cycles...
+    ASSERT_TRUE(emulator.Seek(0));
+    ASSERT_EQUAL(100000u, emulator.GetLatestCycle());
+    ASSERT_EQUAL(0u, emulator.GetOutput().size());
+    VerifyMatchesReplay(emulator, bytes, inputs);
+
+    // ...so seeking forward again starts from the closest checkpoint instead of replaying everything
+    uint64_t executed = emulator.GetInstructionsExecuted();
+    ASSERT_TRUE(emulator.Seek(99000));
+    ASSERT_EQUAL(executed, emulator.GetInstructionsExecuted());
+    VerifyMatchesReplay(emulator, bytes, inputs);
+
+    executed = emulator.GetInstructionsExecuted();
+    ASSERT_TRUE(emulator.Seek(99500));
+    ASSERT_EQUAL(executed + 500, emulator.GetInstructionsExecuted());
+    VerifyMatchesReplay(emulator, bytes, inputs);
+
+    // Stepping back and forward stays within the recorded cycles, and seeking past them records more
+    ASSERT_TRUE(emulator.StepBack());
+    emulator.Step();
+    ASSERT_EQUAL(100000u, emulator.GetLatestCycle());
+    ASSERT_TRUE(emulator.Seek(100100));
+    ASSERT_EQUAL(100100u, emulator.GetLatestCycle());
+    VerifyMatchesReplay(emulator, bytes, inputs);
+}
+
+TEST_CASE("Journal", "Edits") {
+    JournalingEmulator emulator(sampleProgram, { 3 });
+    ASSERT_TRUE(emulator.Seek(10));
+    ASSERT_TRUE(emulator.Seek(4));
+    ASSERT_EQUAL(10u, emulator.GetLatestCycle());
+
+    // Editing discards the journal (in both directions), and execution continues from the edited state
+    const uint8_t value = emulator.GetMemory(15);
+    emulator.EditMemory(15, static_cast<uint8_t>(value + 1));
+    ASSERT_EQUAL(4u, emulator.GetEarliestCycle());
+    ASSERT_EQUAL(4u, emulator.GetLatestCycle());
+    ASSERT_FALSE(emulator.StepBack());
+    ASSERT_EQUAL(static_cast<uint8_t>(value + 1), emulator.GetMemory(15));
+
+    emulator.Step();
+    ASSERT_EQUAL(5u, emulator.GetLatestCycle());
+    ASSERT_TRUE(emulator.StepBack());
+    ASSERT_EQUAL(static_cast<uint8_t>(value + 1), emulator.GetMemory(15));
+}
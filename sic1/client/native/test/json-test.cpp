@@ -0,0 +1,112 @@
+#include "test.h"
+#include "../json.h"
+
+#include <sstream>
+
+using namespace Sic1;
+
+TEST_CASE("JSON", "Values") {
+    const JsonValue value = JsonValue::Parse(" { \"a\": [1, -2.5, 3e2], \"b\": true, \"c\": null, \"d\": \"text\" } ");
+    ASSERT_EQUAL(4u, value.GetPropertyCount());
+    ASSERT_EQUAL(std::string("a"), value.GetPropertyName(0));
+    ASSERT_EQUAL(std::string("d"), value.GetPropertyName(3));
+
+    const auto& array = value.FindProperty("a")->GetArray();
+    ASSERT_EQUAL(3u, array.size());
+    ASSERT_EQUAL(1.0, array[0].GetNumber());
+    ASSERT_EQUAL(-2.5, array[1].GetNumber());
+    ASSERT_EQUAL(300.0, array[2].GetNumber());
+
+    ASSERT_TRUE(value.FindProperty("b")->GetBoolean());
+    ASSERT_TRUE(value.FindProperty("c")->IsNull());
+    ASSERT_EQUAL(std::string("text"), value.FindProperty("d")->GetString());
+    ASSERT_TRUE(value.FindProperty("e") == nullptr);
+}
+
+TEST_CASE("JSON", "String escapes") {
+    ASSERT_EQUAL(std::string("a\"\\/\b\f\n\r\tb"), JsonValue::Parse("\"a\\\"\\\\\\/\\b\\f\\n\\r\\tb\"").GetString());
+    ASSERT_EQUAL(std::string("\xc3\xa9"), JsonValue::Parse("\"\\u00e9\"").GetString());
+    ASSERT_EQUAL(std::string("\xf0\x9f\x98\x80"), JsonValue::Parse("\"\\ud83d\\ude00\"").GetString());
+}
+
+TEST_CASE("JSON", "Errors") {
+    ASSERT_THROWS(JsonValue::Parse(""), JsonParseError);
+    ASSERT_THROWS(JsonValue::Parse("{"), JsonParseError);
+    ASSERT_THROWS(JsonValue::Parse("[1,]"), JsonParseError);
+    ASSERT_THROWS(JsonValue::Parse("{\"a\" 1}"), JsonParseError);
+    ASSERT_THROWS(JsonValue::Parse("\"unterminated"), JsonParseError);
+    ASSERT_THROWS(JsonValue::Parse("1 2"), JsonParseError);
+    ASSERT_THROWS(JsonValue::Parse("tru"), JsonParseError);
+    ASSERT_THROWS(JsonValue::Parse(std::string(1000, '[')), JsonParseError);
+    ASSERT_THROWS(JsonValue::Parse("1").GetString(), std::runtime_error);
+}
+
+TEST_CASE("JSON", "Formatting strings") {
+    ASSERT_EQUAL(std::string("\"abc\""), FormatJsonString("abc"));
+    ASSERT_EQUAL(std::string("\"\\\"\\\\\\n\\t\\u0001\""), FormatJsonString("\"\\\n\t\x01"));
+    ASSERT_EQUAL(std::string("\"\xc3\xa9/\""), FormatJsonString("\xc3\xa9/"));
+
+    const std::string text = "a\"b\\c\x1f\xe2\x82\xac";
+    ASSERT_EQUAL(text, JsonValue::Parse(FormatJsonString(text)).GetString());
+}
+
+namespace {
+    // Records events as text, e.g. {a:[1,"x",null]}
+    class RecordingHandler : public JsonHandler {
+    public:
+        bool OnStartObject() override { m_events += "{"; return true; }
+        bool OnPropertyName(const std::string& name) override { m_events += name + ":"; return true; }
+        bool OnEndObject() override { m_events += "}"; return true; }
+        bool OnStartArray() override { m_events += "["; return true; }
+        bool OnEndArray() override { m_events += "]"; return true; }
+        bool OnString(const std::string& value) override { m_events += "\"" + value + "\","; return true; }
+        bool OnNumber(double value) override { m_events += std::to_string(static_cast<long long>(value)) + ","; return true; }
+        bool OnBoolean(bool value) override { m_events += value ? "true," : "false,"; return true; }
+        bool OnNull() override { m_events += "null,"; return ++m_nullCount < m_nullLimit; }
+
+        std::string m_events;
+        unsigned int m_nullCount = 0;
+        unsigned int m_nullLimit = 100;
+    };
+
+    std::string ReadEvents(const std::string& text, size_t bufferSize) {
+        std::istringstream stream(text);
+        RecordingHandler handler;
+        JsonReader(stream, bufferSize).Read(handler);
+        return handler.m_events;
+    }
+}
+
+TEST_CASE("JSON", "Streaming reader") {
+    const std::string text = " { \"a\" : [1, -20, \"x\\\"y\\u00e9\\ud83d\\ude00\", true, false, null, {}, []], \"b\": {\"c\": \"d\"} } ";
+    const std::string expected = "{a:[1,-20,\"x\"y\xc3\xa9\xf0\x9f\x98\x80\",true,false,null,{}[]]b:{c:\"d\",}}";
+
+    // Results don't depend on how the input is split across buffers
+    for (size_t bufferSize : { 1, 2, 3, 7, 64 * 1024 }) {
+        ASSERT_EQUAL(expected, ReadEvents(text, bufferSize));
+    }
+
+    ASSERT_EQUAL(std::string("\"abc\","), ReadEvents("\"abc\"", 2));
+    ASSERT_EQUAL(std::string("42,"), ReadEvents("42", 1));
+
+    // Unpaired surrogates are handled the same as JsonValue::Parse
+    const std::string surrogates = "\"\\ud83dx\\ud83d\\u0041\\ud83d\"";
+    ASSERT_EQUAL("\"" + JsonValue::Parse(surrogates).GetString() + "\",", ReadEvents(surrogates, 3));
+}
+
+TEST_CASE("JSON", "Streaming reader stops") {
+    std::istringstream stream("[null, null, null, malformed");
+    RecordingHandler handler;
+    handler.m_nullLimit = 2;
+    ASSERT_FALSE(JsonReader(stream, 4).Read(handler));
+    ASSERT_EQUAL(std::string("[null,null,"), handler.m_events);
+}
+
+TEST_CASE("JSON", "Streaming reader errors") {
+    const char* const malformed[] = { "", "{", "[1,]", "{\"a\" 1}", "\"unterminated", "1 2", "tru", "{\"a\":1,}", "[1 2]", "{1:2}", "\"\\x\"", "\"\\u12\"" };
+    for (const char* text : malformed) {
+        ASSERT_THROWS(ReadEvents(text, 3), JsonParseError);
+    }
+
+    ASSERT_THROWS(ReadEvents(std::string(1000, '['), 64), JsonParseError);
+}
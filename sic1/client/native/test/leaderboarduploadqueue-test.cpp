@@ -0,0 +1,236 @@
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "test.h"
+#include "../json.h"
+#include "../leaderboardcache.h"
+#include "../leaderboarduploadqueue.h"
+#include "../simulatedsteam.h"
+#include "../steamleaderboards.h"
+
+using namespace Sic1;
+
+namespace {
+    SimulatedSteamApi::Latency CreateLatency(int milliseconds) {
+        return { std::chrono::milliseconds(milliseconds), std::chrono::microseconds(0) };
+    }
+
+    // Records completions (which may run on the pump's thread)
+    class Recorder {
+    public:
+        LeaderboardUploadQueue::Completion Record() {
+            // Note: Notifies while holding the lock, since the recorder may be destroyed as soon as it sees the status
+            return [this](SteamCallStatus status, bool scoreChanged) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_statuses.push_back(status);
+                m_changedCount += scoreChanged ? 1 : 0;
+                m_signaled.notify_all();
+            };
+        }
+
+        bool Wait(size_t count) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            return m_signaled.wait_for(lock, std::chrono::seconds(10), [&]() { return m_statuses.size() >= count; });
+        }
+
+        std::vector<SteamCallStatus> GetStatuses() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_statuses;
+        }
+
+        size_t GetChangedCount() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_changedCount;
+        }
+
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_signaled;
+        std::vector<SteamCallStatus> m_statuses;
+        size_t m_changedCount = 0;
+    };
+
+    bool WaitUntil(const std::function<bool()>& predicate) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (!predicate()) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                return false;
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+}
+
+TEST_CASE("LeaderboardUploadQueue", "Coalescing") {
+    SimulatedSteamApi api;
+    api.SetLatency(CreateLatency(20));
+    LeaderboardCache cache;
+    SteamCallbackPump pump(api, nullptr);
+    SteamLeaderboards leaderboards(pump, cache);
+    LeaderboardUploadQueue queue(leaderboards);
+
+    // Scores queued while an upload is outstanding are coalesced into a single upload of the best of them (and every
+    // completion receives its result)
+    Recorder recorder;
+    queue.Upload("Addition_cycles", 100, { 1 }, recorder.Record());
+    queue.Upload("Addition_cycles", 90, { 2 }, recorder.Record());
+    queue.Upload("Addition_cycles", 80, { 3 }, recorder.Record());
+    queue.Upload("Addition_cycles", 95, { 4 }, recorder.Record());
+    ASSERT_EQUAL(1u, queue.GetQueuedCount());
+
+    ASSERT_TRUE(recorder.Wait(4));
+    ASSERT_TRUE(recorder.GetStatuses() == std::vector<SteamCallStatus>(4, SteamCallStatus::Succeeded));
+    ASSERT_EQUAL(4u, recorder.GetChangedCount());
+    ASSERT_EQUAL(2u, queue.GetUploadCount());
+    ASSERT_EQUAL(2u, api.GetCallCount(SteamCallType::UploadLeaderboardScore));
+    ASSERT_EQUAL(80, *api.GetUserScore("Addition_cycles"));
+    ASSERT_TRUE(api.GetUserScoreDetails("Addition_cycles") == std::vector<int>({ 3 }));
+    ASSERT_TRUE(WaitUntil([&]() { return queue.GetQueuedCount() == 0; }));
+
+    // Scores that can't beat the best score are dropped (completing on the calling thread)
+    ASSERT_FALSE(queue.IsUploadNeeded("Addition_cycles", 80));
+    ASSERT_TRUE(queue.IsUploadNeeded("Addition_cycles", 79));
+    ASSERT_TRUE(queue.IsUploadNeeded("Addition_bytes", 1000));
+    queue.Upload("Addition_cycles", 85, { 5 }, recorder.Record());
+    ASSERT_EQUAL(5u, recorder.GetStatuses().size());
+    ASSERT_TRUE(recorder.GetStatuses()[4] == SteamCallStatus::Succeeded);
+    ASSERT_EQUAL(2u, queue.GetUploadCount());
+
+    // Uploads may still be finishing on the pump's thread
+    pump.Stop();
+}
+
+TEST_CASE("LeaderboardUploadQueue", "Sort order") {
+    SimulatedSteamApi api;
+    api.SetLatency(CreateLatency(1));
+    LeaderboardCache cache;
+    SteamCallbackPump pump(api, nullptr);
+    SteamLeaderboards leaderboards(pump, cache);
+    LeaderboardUploadQueue queue(leaderboards);
+
+    // Higher solved counts are better, so each new solved count is uploaded
+    Recorder recorder;
+    for (int solvedCount = 1; solvedCount <= 5; solvedCount++) {
+        ASSERT_TRUE(queue.IsUploadNeeded("Solved Count", solvedCount));
+        queue.Upload("Solved Count", solvedCount, {}, recorder.Record());
+        ASSERT_TRUE(recorder.Wait(static_cast<size_t>(solvedCount)));
+        ASSERT_TRUE(WaitUntil([&]() { return queue.GetQueuedCount() == 0; }));
+        ASSERT_EQUAL(solvedCount, *api.GetUserScore("Solved Count"));
+    }
+
+    ASSERT_EQUAL(5u, queue.GetUploadCount());
+    ASSERT_TRUE(recorder.GetStatuses() == std::vector<SteamCallStatus>(5, SteamCallStatus::Succeeded));
+    ASSERT_EQUAL(5u, recorder.GetChangedCount());
+
+    // ...and lower ones are dropped (also after a restart)
+    ASSERT_FALSE(queue.IsUploadNeeded("Solved Count", 5));
+    ASSERT_FALSE(queue.IsUploadNeeded("Solved Count", 4));
+    queue.Upload("Solved Count", 4, {}, recorder.Record());
+    ASSERT_EQUAL(5u, queue.GetUploadCount());
+
+    LeaderboardUploadQueue loaded(leaderboards);
+    loaded.Parse(queue.Format());
+    ASSERT_FALSE(loaded.IsUploadNeeded("Solved Count", 5));
+    ASSERT_TRUE(loaded.IsUploadNeeded("Solved Count", 6));
+    ASSERT_TRUE(loaded.IsUploadNeeded("Addition_cycles", 1000));
+
+    // Scores queued behind an outstanding upload are coalesced into the highest
+    api.SetLatency(CreateLatency(20));
+    queue.Upload("Solved Count", 6, {}, recorder.Record());
+    queue.Upload("Solved Count", 8, {}, recorder.Record());
+    queue.Upload("Solved Count", 7, {}, recorder.Record());
+    ASSERT_TRUE(recorder.Wait(9));
+    ASSERT_TRUE(WaitUntil([&]() { return queue.GetQueuedCount() == 0; }));
+    ASSERT_EQUAL(7u, queue.GetUploadCount());
+    ASSERT_EQUAL(8, *api.GetUserScore("Solved Count"));
+    pump.Stop();
+}
+
+TEST_CASE("LeaderboardUploadQueue", "Offline retry") {
+    SimulatedSteamApi api;
+    api.SetLatency(CreateLatency(1));
+    api.SetOffline(true);
+    LeaderboardCache cache;
+    SteamCallbackPump pump(api, nullptr);
+    SteamLeaderboards leaderboards(pump, cache);
+    LeaderboardUploadQueue queue(leaderboards, nullptr, { std::chrono::milliseconds(10), std::chrono::milliseconds(40) });
+
+    // Failures are reported, but the score stays queued
+    Recorder recorder;
+    queue.Upload("Addition_cycles", 50, { 1, 2 }, recorder.Record());
+    ASSERT_TRUE(recorder.Wait(1));
+    ASSERT_TRUE(recorder.GetStatuses()[0] == SteamCallStatus::IoFailed);
+    ASSERT_EQUAL(1u, queue.GetQueuedCount());
+
+    // Retries back off (10, 20, 40, 40, ... milliseconds)
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    const uint64_t uploadCount = queue.GetUploadCount();
+    ASSERT_TRUE(uploadCount >= 3);
+    ASSERT_TRUE(uploadCount <= 8);
+
+    // Once Steam can be reached, the score is uploaded
+    api.SetOffline(false);
+    ASSERT_TRUE(WaitUntil([&]() { return queue.GetQueuedCount() == 0; }));
+    ASSERT_EQUAL(50, *api.GetUserScore("Addition_cycles"));
+    ASSERT_TRUE(api.GetUserScoreDetails("Addition_cycles") == std::vector<int>({ 1, 2 }));
+    ASSERT_FALSE(queue.IsUploadNeeded("Addition_cycles", 50));
+    ASSERT_EQUAL(1u, recorder.GetStatuses().size());
+    pump.Stop();
+}
+
+TEST_CASE("LeaderboardUploadQueue", "Persistence") {
+    std::string text;
+    {
+        // Scores from an offline session stay queued
+        SimulatedSteamApi api;
+        api.SetLatency(CreateLatency(1));
+        api.SetOffline(true);
+        LeaderboardCache cache;
+        SteamCallbackPump pump(api, nullptr);
+        SteamLeaderboards leaderboards(pump, cache);
+        LeaderboardUploadQueue queue(leaderboards, nullptr, { std::chrono::minutes(1), std::chrono::minutes(1) });
+
+        Recorder recorder;
+        queue.Upload("Addition_cycles", 40, { 7, -8 }, recorder.Record());
+        queue.Upload("Solved Count", 3, {}, recorder.Record());
+        ASSERT_TRUE(recorder.Wait(2));
+        ASSERT_EQUAL(2u, queue.GetQueuedCount());
+        text = queue.Format();
+        pump.Stop();
+    }
+
+    // ...and are uploaded on the next launch
+    SimulatedSteamApi api;
+    api.SetLatency(CreateLatency(1));
+    LeaderboardCache cache;
+    SteamCallbackPump pump(api, nullptr);
+    SteamLeaderboards leaderboards(pump, cache);
+    LeaderboardUploadQueue queue(leaderboards);
+
+    // Malformed queues (or queues from other versions) are rejected without uploading anything
+    ASSERT_THROWS(queue.Parse("{\"version\":1,\"leaderboards\":{"), JsonParseError);
+    ASSERT_THROWS(queue.Parse("{\"version\":2,\"leaderboards\":{}}"), std::runtime_error);
+    ASSERT_THROWS(queue.Parse("{\"version\":1,\"leaderboards\":{\"A\":{\"score\":1,\"details\":2}}}"), std::exception);
+    ASSERT_EQUAL(0u, queue.GetUploadCount());
+
+    queue.Parse(text);
+    ASSERT_TRUE(WaitUntil([&]() { return queue.GetQueuedCount() == 0; }));
+    ASSERT_EQUAL(2u, queue.GetUploadCount());
+    ASSERT_EQUAL(40, *api.GetUserScore("Addition_cycles"));
+    ASSERT_TRUE(api.GetUserScoreDetails("Addition_cycles") == std::vector<int>({ 7, -8 }));
+    ASSERT_EQUAL(3, *api.GetUserScore("Solved Count"));
+
+    // Best scores are persisted too (so worse scores are still dropped after a restart)
+    LeaderboardUploadQueue loaded(leaderboards);
+    loaded.Parse(queue.Format());
+    ASSERT_EQUAL(queue.Format(), loaded.Format());
+    ASSERT_FALSE(loaded.IsUploadNeeded("Addition_cycles", 40));
+    ASSERT_EQUAL(0u, loaded.GetUploadCount());
+    pump.Stop();
+}
@@ -0,0 +1,141 @@
+#include <random>
+#include "test.h"
+#include "test-programs.h"
+#include "../lockstep.h"
+
+using namespace Sic1;
+using namespace TestPrograms;
+
+namespace {
+    void CompareWithVerifier(const std::vector<uint8_t>& program, const std::vector<LockstepJob>& jobs) {
+        LockstepVerifier verifier(program, false);
+        const auto results = verifier.Verify(jobs);
+        ASSERT_EQUAL(jobs.size(), results.size());
+
+        LockstepVerifier loopDetectingVerifier(program);
+        const auto loopDetectingResults = loopDetectingVerifier.Verify(jobs);
+        ASSERT_EQUAL(jobs.size(), loopDetectingResults.size());
+
+        for (size_t i = 0; i < jobs.size(); i++) {
+            const auto expected = VerifyProgram<Emulator>(program, *jobs[i].testSet, jobs[i].cyclesExecutedMax, jobs[i].memoryBytesAccessedMax, false);
+            AssertVerificationResultsEqual(expected, results[i]);
+            AssertVerificationResultsAgree(expected, loopDetectingResults[i]);
+            AssertVerificationResultsAgree(VerifyProgram<Emulator>(program, *jobs[i].testSet, jobs[i].cyclesExecutedMax, jobs[i].memoryBytesAccessedMax), loopDetectingResults[i]);
+        }
+    }
+}
+
+TEST_CASE("Lockstep verifier", "Sample program") {
+    // Lanes diverge (different input lengths and results), halt, and fail in different ways
+    const std::vector<TestSet> testSets = {
+        { { 3 }, { 1, 1, 1 } },
+        { { 1 }, { 1 } },
+        { { 5 }, { 1, 1, 1, 1, 1 } },
+        { { 3 }, { 1, 2, 1 } },
+        { { 2 }, { 1, 1, 1 } },
+        { {}, {} },
+        { {}, { 1 } },
+        { { 100 }, { 1, 1 } },
+    };
+
+    std::vector<LockstepJob> jobs;
+    for (const auto& testSet : testSets) {
+        jobs.push_back({ &testSet, verificationCyclesExecutedMax, solutionBytesMax });
+        jobs.push_back({ &testSet, 4, solutionBytesMax });
+        jobs.push_back({ &testSet, verificationCyclesExecutedMax, 12 });
+    }
+
+    CompareWithVerifier(sampleProgram, jobs);
+}
+
+TEST_CASE("Lockstep verifier", "Partial batches") {
+    const TestSet testSet = { { 3 }, { 1, 1, 1 } };
+    for (size_t count = 0; count <= LockstepVerifier::laneCount * 2 + 1; count++) {
+        CompareWithVerifier(sampleProgram, std::vector<LockstepJob>(count, { &testSet, verificationCyclesExecutedMax, solutionBytesMax }));
+    }
+}
+
+TEST_CASE("Lockstep verifier", "Lanes that modify code differently") {
+    // Each lane patches the branch target of an instruction with its own input:
+    //
+    // subleq @patch+2, @IN
+    // @patch:
+    // subleq @zero, @zero, 0   ; Target is overwritten
+    // subleq @OUT, @one        ; Reached for "-3" only
+    // subleq @OUT, @zero, @HALT
+    // @zero: .data 0
+    // @one: .data 1
+    const std::vector<uint8_t> program = {
+        5, 253, 6,
+        12, 12, 0,
+        254, 13, 9,
+        254, 12, 255,
+        0, 1,
+    };
+
+    const std::vector<TestSet> testSets = {
+        { { -6 }, { 0 } },
+        { { -9 }, { 0 } },
+        { { -3 }, { -1, 0 } },
+        { { -6 }, { -1 } },
+        { { 0 }, { 0 } },
+    };
+
+    std::vector<LockstepJob> jobs;
+    for (const auto& testSet : testSets) {
+        jobs.push_back({ &testSet, verificationCyclesExecutedMax, solutionBytesMax });
+    }
+
+    CompareWithVerifier(program, jobs);
+}
+
+TEST_CASE("Lockstep verifier", "Matches verifier on random programs") {
+    std::mt19937 random(1357);
+    std::uniform_int_distribution<unsigned int> cycles(1, 2000);
+    std::uniform_int_distribution<unsigned int> bytes(10, Constants::memorySize);
+    std::uniform_int_distribution<unsigned int> counts(0, 12);
+    std::uniform_int_distribution<unsigned int> jobCounts(1, LockstepVerifier::laneCount + 8);
+    for (unsigned int i = 0; i < 300; i++) {
+        const auto program = CreateRandomProgram(random);
+        const unsigned int jobCount = jobCounts(random);
+
+        std::vector<TestSet> testSets;
+        for (unsigned int j = 0; j < jobCount; j++) {
+            testSets.push_back(CreateRandomTestSet(random, counts(random), counts(random)));
+        }
+
+        std::vector<LockstepJob> jobs;
+        for (const auto& testSet : testSets) {
+            jobs.push_back({ &testSet, cycles(random), bytes(random) });
+        }
+
+        CompareWithVerifier(program, jobs);
+    }
+}
+
+TEST_CASE("Lockstep verifier", "Non-terminating lanes") {
+    // Reads inputs (subtracting them from @t) until the input is exhausted and then loops forever: subleq @t, @IN, 0
+    const std::vector<uint8_t> program = { 3, 253, 0, 0 };
+    std::vector<TestSet> testSets;
+    for (unsigned int i = 0; i < LockstepVerifier::laneCount; i++) {
+        testSets.push_back({ std::vector<int8_t>(i, 1), { 1 } });
+    }
+
+    std::vector<LockstepJob> jobs;
+    for (const auto& testSet : testSets) {
+        jobs.push_back({ &testSet, verificationCyclesExecutedMax, solutionBytesMax });
+    }
+
+    LockstepVerifier verifier(program);
+    const auto results = verifier.Verify(jobs);
+    for (size_t i = 0; i < results.size(); i++) {
+        ASSERT_EQUAL(static_cast<int>(VerificationStatus::NonTerminating), static_cast<int>(results[i].status));
+        ASSERT_TRUE(results[i].cyclesExecuted < 1000);
+        ASSERT_TRUE(results[i].inputIndex > i);
+
+        // Only the cycle count and input index depend on where loops are checked for
+        const auto expected = VerifyProgram<Emulator>(program, testSets[i], verificationCyclesExecutedMax, solutionBytesMax);
+        ASSERT_EQUAL(static_cast<int>(VerificationStatus::NonTerminating), static_cast<int>(expected.status));
+        AssertVerificationResultsAgree(expected, results[i]);
+    }
+}
@@ -0,0 +1,30 @@
+#include <cstdio>
+#include <exception>
+#include "test.h"
+
+int Test::RunAll() {
+    int failures = 0;
+    const char* currentSuite = nullptr;
+    for (const auto& testCase : GetTestCases()) {
+        if (currentSuite == nullptr || std::string(currentSuite) != testCase.suite) {
+            currentSuite = testCase.suite;
+            std::printf("%s\n", currentSuite);
+        }
+
+        try {
+            testCase.run();
+            std::printf("    ok: %s\n", testCase.name);
+        }
+        catch (const std::exception& error) {
+            failures++;
+            std::printf("    FAILED: %s\n        %s\n", testCase.name, error.what());
+        }
+    }
+
+    std::printf("\n%zu passing, %d failing\n", GetTestCases().size() - failures, failures);
+    return (failures == 0) ? 0 : 1;
+}
+
+int main() {
+    return Test::RunAll();
+}
@@ -0,0 +1,79 @@
+#include <random>
+#include "test.h"
+#include "test-programs.h"
+#include "../predecoded.h"
+
+using namespace Sic1;
+using namespace TestPrograms;
+
+TEST_CASE("Predecoded emulator", "Sample program") {
+    PredecodedEmulator emulator(sampleProgram);
+    ListIo io({ 3 });
+    emulator.Run(io);
+
+    ASSERT_TRUE(io.outputs == std::vector<int>({ 1, 1, 1 }));
+    ASSERT_EQUAL(12u, emulator.GetCyclesExecuted());
+    ASSERT_EQUAL(22u, emulator.GetMemoryBytesAccessed());
+}
+
+TEST_CASE("Predecoded emulator", "Self-modifying code") {
+    // @loop:
+    // subleq @OUT, @n_one
+    // @patch:
+    // subleq @loop+1, @one    ; Changes the second operand of the first instruction
+    // subleq @zero, @zero, @loop
+    // @n_one: .data -1
+    // @one: .data 1
+    // @zero: .data 0
+    const std::vector<uint8_t> bytes = {
+        254, 9, 3,
+        1, 10, 6,
+        11, 11, 0,
+        0xff, 1, 0,
+    };
+
+    CompareWithEmulator<PredecodedEmulator>(bytes, {}, 100);
+
+    PredecodedEmulator emulator(bytes);
+    ListIo io({});
+    emulator.Run(io, 9);
+    ASSERT_TRUE(io.outputs == std::vector<int>({ 1, 0, -11 }));
+}
+
+TEST_CASE("Predecoded emulator", "Overwritten I/O instructions") {
+    // @loop:
+    // subleq @t, @IN
+    // subleq @OUT, @t
+    // subleq @loop+1, @n_one   ; Changes "@IN" to "@OUT", then "@HALT", then an ordinary address
+    // subleq @zero, @zero, @loop
+    // @t: .data 0
+    // @n_one: .data -1
+    // @zero: .data 0
+    const std::vector<uint8_t> bytes = {
+        12, 253, 3,
+        254, 12, 6,
+        1, 13, 9,
+        14, 14, 0,
+        0, 0xff, 0,
+    };
+
+    CompareWithEmulator<PredecodedEmulator>(bytes, { 5, -3, 7, 100, -128 }, 100);
+}
+
+TEST_CASE("Predecoded emulator", "Reset") {
+    PredecodedEmulator emulator(sampleProgram);
+    ListIo io({ 3, 2 });
+    emulator.Run(io);
+    emulator.Reset();
+    emulator.Run(io);
+
+    ASSERT_TRUE(io.outputs == std::vector<int>({ 1, 1, 1, 1, 1 }));
+    ASSERT_EQUAL(9u, emulator.GetCyclesExecuted());
+}
+
+TEST_CASE("Predecoded emulator", "Matches emulator on random programs") {
+    std::mt19937 random(1234);
+    for (unsigned int i = 0; i < 2000; i++) {
+        CompareWithEmulator<PredecodedEmulator>(CreateRandomProgram(random), CreateRandomInputs(random, 20), 500);
+    }
+}
@@ -0,0 +1,106 @@
+#include <numeric>
+#include <random>
+#include "test.h"
+#include "test-programs.h"
+#include "../profiler.h"
+
+using namespace Sic1;
+using namespace TestPrograms;
+
+TEST_CASE("Profiler", "Sample program") {
+    ProfilingEmulator emulator(sampleProgram);
+    ListIo io({ 3 });
+    emulator.Run(io);
+
+    ASSERT_TRUE(io.outputs == std::vector<int>({ 1, 1, 1 }));
+    ASSERT_EQUAL(12u, emulator.GetCyclesExecuted());
+    ASSERT_EQUAL(22u, emulator.GetMemoryBytesAccessed());
+
+    // The loop's first instruction runs once per iteration (plus once more, to halt)
+    const Profile& profile = emulator.GetProfile();
+    ASSERT_EQUAL(1u, profile.executions[0]);
+    ASSERT_EQUAL(1u, profile.executions[3]);
+    ASSERT_EQUAL(4u, profile.executions[6]);
+    ASSERT_EQUAL(3u, profile.executions[9]);
+    ASSERT_EQUAL(3u, profile.executions[12]);
+    ASSERT_EQUAL(0u, profile.executions[15]);
+
+    ASSERT_EQUAL(1u, profile.branchesTaken[0]);
+    ASSERT_EQUAL(0u, profile.branchesTaken[3]);
+    ASSERT_EQUAL(1u, profile.branchesTaken[6]);
+    ASSERT_EQUAL(0u, profile.branchesTaken[9]);
+    ASSERT_EQUAL(3u, profile.branchesTaken[12]);
+
+    // @tmp, @count, @zero, @one, @n_one, @IN, and @OUT
+    ASSERT_EQUAL(2u, profile.reads[15]);
+    ASSERT_EQUAL(1u, profile.writes[15]);
+    ASSERT_EQUAL(5u, profile.reads[16]);
+    ASSERT_EQUAL(5u, profile.writes[16]);
+    ASSERT_EQUAL(6u, profile.reads[17]);
+    ASSERT_EQUAL(3u, profile.writes[17]);
+    ASSERT_EQUAL(4u, profile.reads[18]);
+    ASSERT_EQUAL(0u, profile.writes[18]);
+    ASSERT_EQUAL(3u, profile.reads[19]);
+    ASSERT_EQUAL(1u, profile.reads[Constants::addressInput]);
+    ASSERT_EQUAL(3u, profile.writes[Constants::addressOutput]);
+
+    emulator.Reset();
+    ASSERT_EQUAL(0u, emulator.GetProfile().executions[6]);
+    ASSERT_EQUAL(0u, emulator.GetProfile().reads[16]);
+}
+
+TEST_CASE("Profiler", "Source lines") {
+    const AssembledProgram program = Assembler::Assemble(sampleSource);
+    ProfilingEmulator emulator(program.bytes);
+    ListIo io({ 3 });
+    emulator.Run(io);
+
+    const std::vector<SourceLineProfile> lines = GetSourceLineProfiles(emulator.GetProfile(), program);
+    ASSERT_EQUAL(10u, lines.size());
+
+    // subleq @count, @one, @HALT
+    ASSERT_EQUAL(8u, lines[2].lineNumber);
+    ASSERT_EQUAL(6u, lines[2].address);
+    ASSERT_EQUAL(3u, lines[2].size);
+    ASSERT_EQUAL(4u, lines[2].executions);
+    ASSERT_EQUAL(1u, lines[2].branchesTaken);
+    ASSERT_EQUAL(3u, lines[2].branchesNotTaken);
+
+    // @count: .data 0
+    ASSERT_EQUAL(14u, lines[6].lineNumber);
+    ASSERT_EQUAL(16u, lines[6].address);
+    ASSERT_EQUAL(1u, lines[6].size);
+    ASSERT_EQUAL(0u, lines[6].executions);
+    ASSERT_EQUAL(5u, lines[6].reads);
+    ASSERT_EQUAL(5u, lines[6].writes);
+
+    // Every cycle is attributed to a line
+    uint64_t executions = 0;
+    for (const SourceLineProfile& line : lines) {
+        executions += line.executions;
+    }
+    ASSERT_EQUAL(emulator.GetCyclesExecuted(), executions);
+}
+
+TEST_CASE("Profiler", "Random programs") {
+    std::mt19937 random(15);
+    for (int i = 0; i < 200; i++) {
+        const std::vector<uint8_t> bytes = CreateRandomProgram(random);
+        const std::vector<int> inputs = CreateRandomInputs(random, 20);
+        CompareWithEmulator<ProfilingEmulator>(bytes, inputs, 500);
+
+        // Each cycle executes one instruction, which reads two operands and writes one
+        ProfilingEmulator emulator(bytes);
+        ListIo io(inputs);
+        emulator.Run(io, 500);
+
+        const Profile& profile = emulator.GetProfile();
+        const uint64_t cycles = emulator.GetCyclesExecuted();
+        ASSERT_EQUAL(cycles, std::accumulate(profile.executions.begin(), profile.executions.end(), uint64_t(0)));
+        ASSERT_EQUAL(2 * cycles, std::accumulate(profile.reads.begin(), profile.reads.end(), uint64_t(0)));
+        ASSERT_EQUAL(cycles, std::accumulate(profile.writes.begin(), profile.writes.end(), uint64_t(0)));
+        for (unsigned int address = 0; address < Constants::memorySize; address++) {
+            ASSERT_TRUE(profile.branchesTaken[address] <= profile.executions[address]);
+        }
+    }
+}
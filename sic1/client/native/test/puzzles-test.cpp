@@ -0,0 +1,126 @@
+#include "test.h"
+#include "test-programs.h"
+#include "../puzzles.h"
+
+using namespace Sic1;
+using namespace TestPrograms;
+
+TEST_CASE("Puzzles", "Random test validators") {
+    // Same as puzzles.spec.ts: expected output for the io table's inputs must match its outputs
+    for (const auto& puzzle : GetPuzzles()) {
+        if (puzzle.getExpectedOutput) {
+            PuzzleIoGroups inputs;
+            PuzzleIoGroups outputs;
+            for (const auto& row : puzzle.io) {
+                inputs.push_back(row.input);
+                outputs.push_back(row.output);
+            }
+
+            ASSERT_TRUE(outputs == puzzle.getExpectedOutput(inputs));
+        }
+    }
+}
+
+TEST_CASE("Puzzles", "Puzzle lookup") {
+    ASSERT_EQUAL(31u, GetPuzzles().size());
+    ASSERT_EQUAL(std::string("Sort"), std::string(FindPuzzle("Sort")->title));
+    ASSERT_TRUE(FindPuzzle("Not a puzzle") == nullptr);
+}
+
+TEST_CASE("Puzzles", "Random numbers") {
+    // Same sequence as SplitMix64
+    Random random(0);
+    ASSERT_EQUAL(0xe220a8397b1dcdafull, random.NextUInt64());
+    ASSERT_EQUAL(0x6e789e6aa1b965f4ull, random.NextUInt64());
+    ASSERT_EQUAL(2ull, random.GetCounter());
+
+    // Counter-based, so any position can be generated directly
+    Random skipped(0, 1);
+    ASSERT_EQUAL(0x6e789e6aa1b965f4ull, skipped.NextUInt64());
+
+    for (unsigned int i = 0; i < 10000; i++) {
+        const double value = random.NextDouble();
+        ASSERT_TRUE(value >= 0 && value < 1);
+
+        const int integer = random.NextInt(7);
+        ASSERT_TRUE(integer >= 0 && integer < 7);
+    }
+
+    ASSERT_FALSE(Random::DeriveSeed(1, 0) == Random::DeriveSeed(1, 1));
+    ASSERT_FALSE(Random::DeriveSeed(1, 0) == Random::DeriveSeed(2, 0));
+}
+
+TEST_CASE("Puzzles", "Seeded test generation") {
+    for (const auto& puzzle : GetPuzzles()) {
+        bool differs = false;
+        for (uint64_t seed = 0; seed < 20; seed++) {
+            const auto testSets = GeneratePuzzleTest(puzzle, seed);
+            const auto repeated = GeneratePuzzleTest(puzzle, seed);
+            const auto next = GeneratePuzzleTest(puzzle, seed + 100);
+            ASSERT_EQUAL(testSets.size(), repeated.size());
+            for (size_t i = 0; i < testSets.size(); i++) {
+                ASSERT_TRUE(testSets[i].input == repeated[i].input);
+                ASSERT_TRUE(testSets[i].output == repeated[i].output);
+                differs = differs || (testSets[i].input != next[i].input);
+            }
+        }
+
+        ASSERT_EQUAL(puzzle.createRandomTest != nullptr, differs);
+    }
+}
+
+TEST_CASE("Puzzles", "Generated test sets") {
+    Random random(1234);
+    for (const auto& puzzle : GetPuzzles()) {
+        const TestSet standard = GetFixedTestSets(puzzle)[0];
+        for (unsigned int i = 0; i < 50; i++) {
+            const auto testSets = GeneratePuzzleTest(puzzle, random);
+            ASSERT_TRUE(testSets[0].input == standard.input);
+            ASSERT_TRUE(testSets[0].output == standard.output);
+
+            if (puzzle.createRandomTest) {
+                ASSERT_EQUAL(1 + puzzle.fixed.size() + ((puzzle.io.size() > 1) ? 2 : 1), testSets.size());
+                for (const auto& testSet : testSets) {
+                    ASSERT_FALSE(testSet.output.empty());
+                }
+
+                // The last test set is similar to the standard one (but not identical)
+                if (puzzle.io.size() > 1) {
+                    const TestSet& similar = testSets.back();
+                    ASSERT_FALSE(similar.input == standard.input);
+                    ASSERT_FALSE(similar.output == standard.output);
+                }
+            }
+            else {
+                ASSERT_EQUAL(1u, testSets.size());
+            }
+        }
+    }
+}
+
+TEST_CASE("Puzzles", "Verify sample solution") {
+    // Reads and outputs each input:
+    //
+    // @loop:
+    // subleq @t, @t
+    // subleq @t, @IN
+    // subleq @OUT, @t
+    // subleq @z, @z, @loop
+    // @t: .data 0
+    // @z: .data 0
+    const std::vector<uint8_t> program = {
+        12, 12, 3,
+        12, 253, 6,
+        254, 12, 9,
+        13, 13, 0,
+        0, 0,
+    };
+
+    Random random(5678);
+    const Puzzle& puzzle = *FindPuzzle("First Assessment");
+    for (unsigned int i = 0; i < 20; i++) {
+        for (const auto& testSet : GeneratePuzzleTest(puzzle, random)) {
+            ASSERT_EQUAL(static_cast<int>(VerificationStatus::Success), static_cast<int>(VerifyProgram(program, testSet, verificationCyclesExecutedMax, solutionBytesMax).status));
+        }
+    }
+}
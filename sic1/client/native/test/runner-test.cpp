@@ -0,0 +1,205 @@
+#include <random>
+#include "test.h"
+#include "test-programs.h"
+#include "../assembler.h"
+#include "../runner.h"
+
+using namespace Sic1;
+using namespace TestPrograms;
+
+namespace {
+    RunOptions CreateOptions(std::vector<int8_t> input, uint64_t cyclesExecutedMax = 1000) {
+        RunOptions options = {};
+        options.input = std::move(input);
+        options.cyclesExecutedMax = cyclesExecutedMax;
+        return options;
+    }
+}
+
+TEST_CASE("Runner", "Sample program") {
+    // Without expected output, the program runs until it halts
+    RunResult result = RunUntilStopped(sampleProgram, CreateOptions({ 3 }));
+    ASSERT_TRUE(result.reason == RunStopReason::Halted);
+    ASSERT_TRUE(result.output == std::vector<int8_t>({ 1, 1, 1 }));
+    ASSERT_EQUAL(12u, result.cyclesExecuted);
+    ASSERT_EQUAL(22u, result.memoryBytesAccessed);
+    ASSERT_EQUAL(Constants::addressHalt, result.ip);
+    ASSERT_EQUAL(1u, result.inputIndex);
+    ASSERT_EQUAL(0xfc, result.memory[15]);
+
+    // With expected output, it stops as soon as the last output is produced
+    RunOptions options = CreateOptions({ 3 });
+    options.expectedOutput = std::vector<int8_t>({ 1, 1, 1 });
+    result = RunUntilStopped(sampleProgram, options);
+    ASSERT_TRUE(result.reason == RunStopReason::Completed);
+    ASSERT_EQUAL(10u, result.cyclesExecuted);
+    ASSERT_EQUAL(12u, result.ip);
+
+    // ... or as soon as an output is incorrect (which is still reported)
+    options.expectedOutput = std::vector<int8_t>({ 1, 2, 1 });
+    result = RunUntilStopped(sampleProgram, options);
+    ASSERT_TRUE(result.reason == RunStopReason::IncorrectOutput);
+    ASSERT_TRUE(result.output == std::vector<int8_t>({ 1, 1 }));
+
+    // Outputs past the expected output are ignored (halting is reported first)
+    options.expectedOutput = std::vector<int8_t>({ 1, 1, 1, 1 });
+    result = RunUntilStopped(sampleProgram, options);
+    ASSERT_TRUE(result.reason == RunStopReason::Halted);
+    ASSERT_EQUAL(3u, result.output.size());
+}
+
+TEST_CASE("Runner", "Breakpoints") {
+    // !subleq @OUT, @n_one is the instruction at address 9
+    const AssembledProgram program = Assembler::Assemble(
+        "subleq @tmp, @IN\n"
+        "subleq @count, @tmp\n"
+        "@loop:\n"
+        "subleq @count, @one, @HALT\n"
+        "!subleq @OUT, @n_one\n"
+        "subleq @zero, @zero, @loop\n"
+        "@tmp: .data -1\n"
+        "@count: .data 0\n"
+        "@zero: .data 0\n"
+        "@one: .data 1\n"
+        "@n_one: .data -1\n");
+    ASSERT_TRUE(program.breakpoints == std::vector<unsigned int>({ 9 }));
+
+    RunOptions options = CreateOptions({ 3 });
+    for (unsigned int address : program.breakpoints) {
+        options.breakpoints[address] = true;
+    }
+
+    RunResult result = RunUntilStopped(program.bytes, options);
+    ASSERT_TRUE(result.reason == RunStopReason::Breakpoint);
+    ASSERT_EQUAL(9u, result.ip);
+    ASSERT_EQUAL(3u, result.cyclesExecuted);
+    ASSERT_EQUAL(0u, result.output.size());
+
+    // Resuming continues past the current breakpoint to the next one
+    options.resumeCycle = result.cyclesExecuted;
+    result = RunUntilStopped(program.bytes, options);
+    ASSERT_TRUE(result.reason == RunStopReason::Breakpoint);
+    ASSERT_EQUAL(6u, result.cyclesExecuted);
+    ASSERT_TRUE(result.output == std::vector<int8_t>({ 1 }));
+
+    options.resumeCycle = 100;
+    result = RunUntilStopped(program.bytes, options);
+    ASSERT_TRUE(result.reason == RunStopReason::Halted);
+}
+
+TEST_CASE("Runner", "Input and cycle limit") {
+    // @loop:
+    // subleq @OUT, @IN
+    // subleq @0, @0, @loop
+    // @0: .data 0
+    const std::vector<uint8_t> bytes = { 254, 253, 3, 6, 6, 0, 0 };
+
+    // Zeros are read once the input is exhausted
+    RunResult result = RunUntilStopped(bytes, CreateOptions({ 5, -7 }, 10));
+    ASSERT_TRUE(result.reason == RunStopReason::CycleLimit);
+    ASSERT_EQUAL(10u, result.cyclesExecuted);
+    ASSERT_EQUAL(5u, result.inputIndex);
+    ASSERT_TRUE(result.output == std::vector<int8_t>({ -5, 7, 0, 0, 0 }));
+
+    result = RunUntilStopped(bytes, CreateOptions({}, 0));
+    ASSERT_TRUE(result.reason == RunStopReason::CycleLimit);
+    ASSERT_EQUAL(0u, result.cyclesExecuted);
+
+    // An empty program ("subleq 0, 0, 0") loops forever
+    result = RunUntilStopped({}, CreateOptions({}, 1000));
+    ASSERT_TRUE(result.reason == RunStopReason::CycleLimit);
+    ASSERT_EQUAL(0u, result.ip);
+}
+
+TEST_CASE("Runner", "Random programs") {
+    std::mt19937 random(17);
+    for (int i = 0; i < 200; i++) {
+        const std::vector<uint8_t> bytes = CreateRandomProgram(random);
+        const std::vector<int> inputs = CreateRandomInputs(random, 1000);
+
+        // Runs to the cycle limit (or halt) should end in the same state as the reference emulator
+        const RunResult result = RunUntilStopped(bytes, CreateOptions(std::vector<int8_t>(inputs.begin(), inputs.end()), 500));
+        Emulator expected(bytes);
+        ListIo io(inputs);
+        expected.Run(io, 500);
+
+        ASSERT_TRUE(result.reason == (expected.IsRunning() ? RunStopReason::CycleLimit : RunStopReason::Halted));
+        ASSERT_EQUAL(expected.GetCyclesExecuted(), result.cyclesExecuted);
+        ASSERT_EQUAL(expected.GetIp(), result.ip);
+        ASSERT_EQUAL(expected.GetMemoryBytesAccessed(), result.memoryBytesAccessed);
+        ASSERT_TRUE(expected.GetMemoryAccessed() == result.memoryAccessed);
+        ASSERT_TRUE(std::vector<int>(result.output.begin(), result.output.end()) == io.outputs);
+        for (unsigned int address = 0; address < Constants::memorySize; address++) {
+            ASSERT_EQUAL(expected.GetMemory(address), result.memory[address]);
+        }
+    }
+}
+
+TEST_CASE("Runner", "Sessions") {
+    // @loop:
+    // subleq @OUT, @IN
+    // subleq @0, @0, @loop
+    // @0: .data 0
+    const std::vector<uint8_t> bytes = { 254, 253, 3, 6, 6, 0, 0 };
+
+    // A run that doesn't stop continues where the previous slice stopped
+    RunSession session(bytes, { 5, -7 }, std::nullopt);
+    RunResult result = session.Run({}, 0, 3);
+    ASSERT_TRUE(result.reason == RunStopReason::CycleLimit);
+    ASSERT_EQUAL(3u, result.cyclesExecuted);
+    ASSERT_EQUAL(2u, result.inputIndex);
+    ASSERT_TRUE(result.output == std::vector<int8_t>({ -5, 7 }));
+
+    result = session.Run({}, 0, 7);
+    ASSERT_TRUE(result.reason == RunStopReason::CycleLimit);
+    ASSERT_EQUAL(10u, result.cyclesExecuted);
+    ASSERT_EQUAL(5u, result.inputIndex);
+    ASSERT_TRUE(result.output == std::vector<int8_t>({ -5, 7, 0, 0, 0 }));
+
+    // Once complete, the run stays complete
+    RunSession completed(bytes, { 5 }, std::vector<int8_t>({ -5, 0 }));
+    result = completed.Run({}, 0, 1000);
+    ASSERT_TRUE(result.reason == RunStopReason::Completed);
+    ASSERT_EQUAL(3u, result.cyclesExecuted);
+    result = completed.Run({}, 0, 1000);
+    ASSERT_TRUE(result.reason == RunStopReason::Completed);
+    ASSERT_EQUAL(3u, result.cyclesExecuted);
+
+    // Breakpoints stop the run, and continuing steps past the current one (here, to the same breakpoint on the next
+    // iteration); breakpoints before resumeCycle are ignored
+    std::bitset<Constants::memorySize> breakpoints;
+    breakpoints[0] = true;
+    RunSession paused(bytes, {}, std::nullopt);
+    result = paused.Run(breakpoints, 0, 1000);
+    ASSERT_TRUE(result.reason == RunStopReason::Breakpoint);
+    ASSERT_EQUAL(2u, result.cyclesExecuted);
+    result = paused.Run(breakpoints, 0, 1000);
+    ASSERT_TRUE(result.reason == RunStopReason::Breakpoint);
+    ASSERT_EQUAL(4u, result.cyclesExecuted);
+    result = paused.Run(breakpoints, 9, 1000);
+    ASSERT_TRUE(result.reason == RunStopReason::Breakpoint);
+    ASSERT_EQUAL(10u, result.cyclesExecuted);
+
+    // Running in slices ends in the same state as running all at once
+    std::mt19937 random(23);
+    for (int i = 0; i < 100; i++) {
+        const std::vector<uint8_t> program = CreateRandomProgram(random);
+        const std::vector<int> inputs = CreateRandomInputs(random, 1000);
+        const std::vector<int8_t> input(inputs.begin(), inputs.end());
+
+        const RunResult expected = RunUntilStopped(program, CreateOptions(input, 500));
+        RunSession sliced(program, input, std::nullopt);
+        do {
+            result = sliced.Run({}, 0, 5);
+        } while (result.reason == RunStopReason::CycleLimit && result.cyclesExecuted < 500);
+
+        ASSERT_TRUE(expected.reason == result.reason);
+        ASSERT_EQUAL(expected.cyclesExecuted, result.cyclesExecuted);
+        ASSERT_EQUAL(expected.ip, result.ip);
+        ASSERT_EQUAL(expected.memoryBytesAccessed, result.memoryBytesAccessed);
+        ASSERT_EQUAL(expected.inputIndex, result.inputIndex);
+        ASSERT_TRUE(expected.output == result.output);
+        ASSERT_TRUE(expected.memory == result.memory);
+        ASSERT_TRUE(expected.memoryAccessed == result.memoryAccessed);
+    }
+}
@@ -0,0 +1,260 @@
+#include "test.h"
+#include "../solutionarchive.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+using namespace Sic1;
+
+namespace {
+    Solution CreateSolution(const std::string& puzzleTitle, const std::string& userId, const std::string& focus, std::optional<uint64_t> cycles, std::optional<unsigned int> bytes, const std::vector<uint8_t>& program) {
+        Solution solution;
+        solution.puzzleTitle = puzzleTitle;
+        solution.userId = userId;
+        solution.focus = focus;
+        solution.cycles = cycles;
+        solution.bytes = bytes;
+        solution.program = program;
+        return solution;
+    }
+
+    std::vector<Solution> CreateSolutions() {
+        std::vector<Solution> solutions;
+        solutions.push_back(CreateSolution("First Assessment", "1", "cycles", 9, 16, { 12, 12, 3, 12, 253, 6, 254, 12, 9, 13, 13, 0, 0, 0 }));
+        solutions.push_back(CreateSolution("Addition", "1", "bytes", std::nullopt, 20, { 1, 2, 3 }));
+        solutions.push_back(CreateSolution("First Assessment", "2", "bytes", std::nullopt, std::nullopt, {}));
+        solutions.back().source = "web";
+        solutions.back().time = "2023-01-02T03:04:05.000Z";
+        solutions.push_back(CreateSolution("Addition", "\xc3\xa9\"\\", "", 0, 0, { 255 }));
+        return solutions;
+    }
+
+    std::string GetTemporaryPath(const char* name) {
+        return (std::filesystem::temp_directory_path() / name).string();
+    }
+
+    void AssertSolutionsEqual(const Solution& expected, const Solution& actual) {
+        ASSERT_EQUAL(expected.puzzleTitle, actual.puzzleTitle);
+        ASSERT_EQUAL(expected.userId, actual.userId);
+        ASSERT_EQUAL(expected.focus, actual.focus);
+        ASSERT_TRUE(expected.cycles == actual.cycles);
+        ASSERT_TRUE(expected.bytes == actual.bytes);
+        ASSERT_TRUE(expected.program == actual.program);
+        ASSERT_EQUAL(expected.source, actual.source);
+        ASSERT_EQUAL(expected.time, actual.time);
+    }
+
+    std::vector<uint8_t> ReadFile(const std::string& path) {
+        std::ifstream stream(path, std::ios::binary);
+        return std::vector<uint8_t>(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+    }
+
+    void WriteFile(const std::string& path, const std::vector<uint8_t>& bytes) {
+        std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+        stream.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    }
+}
+
+TEST_CASE("Solution archive", "Round trip") {
+    const std::string path = GetTemporaryPath("sic1-solutionarchive-test.bin");
+    const auto solutions = CreateSolutions();
+    WriteSolutionArchive(path, solutions);
+    ASSERT_TRUE(SolutionArchive::IsArchive(path));
+
+    {
+        const SolutionArchive archive(path);
+        ASSERT_EQUAL(4u, archive.GetSolutionCount());
+        ASSERT_EQUAL(2u, archive.GetPuzzleCount());
+
+        // Solutions are grouped by puzzle, in order of first appearance
+        const auto read = archive.ReadSolutions();
+        ASSERT_EQUAL(4u, read.size());
+        AssertSolutionsEqual(solutions[0], read[0]);
+        AssertSolutionsEqual(solutions[2], read[1]);
+        AssertSolutionsEqual(solutions[1], read[2]);
+        AssertSolutionsEqual(solutions[3], read[3]);
+
+        const SolutionView view = archive.GetSolution(2);
+        ASSERT_TRUE(view.puzzleTitle == "Addition");
+        ASSERT_EQUAL(3u, view.programSize);
+        ASSERT_EQUAL(2, view.program[1]);
+        ASSERT_THROWS(archive.GetSolution(4), std::out_of_range);
+    }
+
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Solution archive", "Puzzle index") {
+    const std::string path = GetTemporaryPath("sic1-solutionarchive-index-test.bin");
+    WriteSolutionArchive(path, CreateSolutions());
+
+    {
+        const SolutionArchive archive(path);
+        const size_t addition = archive.FindPuzzle("Addition");
+        ASSERT_EQUAL(1u, addition);
+        ASSERT_TRUE(archive.GetPuzzleTitle(addition) == "Addition");
+        ASSERT_EQUAL(2u, archive.GetPuzzleFirstSolution(addition));
+        ASSERT_EQUAL(2u, archive.GetPuzzleSolutionCount(addition));
+        ASSERT_EQUAL(archive.GetPuzzleCount(), archive.FindPuzzle("Subtraction"));
+    }
+
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Solution archive", "Puzzles without solutions") {
+    const std::string path = GetTemporaryPath("sic1-solutionarchive-empty-puzzle-test.bin");
+    std::vector<Solution> solutions;
+    solutions.push_back(CreateSolution("First Assessment", "1", "cycles", 1, 1, { 1 }));
+    solutions.push_back(CreateSolution("First Assessment", "2", "cycles", 2, 2, { 2 }));
+    solutions.push_back(CreateSolution("Addition", "3", "cycles", 3, 3, { 3 }));
+    solutions.push_back(CreateSolution("Subtraction", "4", "cycles", 4, 4, { 4 }));
+    solutions.push_back(CreateSolution("Subtraction", "5", "cycles", 5, 5, { 5 }));
+    WriteSolutionArchive(path, solutions);
+
+    // Archives are never written with empty puzzles, so move Addition's only solution to Subtraction by editing the
+    // puzzle index (whose offset follows the magic, version, byte order, file size, and counts in the header), leaving
+    // Addition empty between two puzzles that start at the same solution
+    std::vector<uint8_t> bytes = ReadFile(path);
+    uint64_t puzzlesOffset;
+    std::memcpy(&puzzlesOffset, bytes.data() + 40, sizeof(puzzlesOffset));
+    uint32_t puzzles[3][4];
+    std::memcpy(puzzles, bytes.data() + puzzlesOffset, sizeof(puzzles));
+    ASSERT_EQUAL(2u, puzzles[1][1]);
+    ASSERT_EQUAL(3u, puzzles[2][1]);
+    puzzles[1][2] = 0;
+    puzzles[2][1] = 2;
+    puzzles[2][2] = 3;
+    std::memcpy(bytes.data() + puzzlesOffset, puzzles, sizeof(puzzles));
+    WriteFile(path, bytes);
+
+    {
+        const SolutionArchive archive(path);
+        ASSERT_EQUAL(3u, archive.GetPuzzleCount());
+        ASSERT_EQUAL(0u, archive.GetPuzzleSolutionCount(1));
+        ASSERT_EQUAL(archive.GetPuzzleCount(), archive.FindPuzzle("Addition"));
+        ASSERT_EQUAL(2u, archive.FindPuzzle("Subtraction"));
+
+        const char* const expectedTitles[] = { "First Assessment", "First Assessment", "Subtraction", "Subtraction", "Subtraction" };
+        for (size_t i = 0; i < archive.GetSolutionCount(); i++) {
+            const SolutionView view = archive.GetSolution(i);
+            ASSERT_TRUE(view.puzzleTitle == expectedTitles[i]);
+            ASSERT_EQUAL(i + 1, static_cast<size_t>(view.program[0]));
+        }
+    }
+
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Solution archive", "Empty") {
+    const std::string path = GetTemporaryPath("sic1-solutionarchive-empty-test.bin");
+    WriteSolutionArchive(path, {});
+
+    {
+        const SolutionArchive archive(path);
+        ASSERT_EQUAL(0u, archive.GetSolutionCount());
+        ASSERT_EQUAL(0u, archive.GetPuzzleCount());
+        ASSERT_EQUAL(0u, archive.ReadSolutions().size());
+    }
+
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Solution archive", "Corrupt archives") {
+    const std::string path = GetTemporaryPath("sic1-solutionarchive-corrupt-test.bin");
+    const std::string corruptPath = GetTemporaryPath("sic1-solutionarchive-corrupt-test-2.bin");
+    WriteSolutionArchive(path, CreateSolutions());
+    const std::vector<uint8_t> bytes = ReadFile(path);
+
+    // Truncated
+    WriteFile(corruptPath, std::vector<uint8_t>(bytes.begin(), bytes.end() - 8));
+    ASSERT_THROWS(SolutionArchive{ corruptPath }, std::runtime_error);
+
+    WriteFile(corruptPath, std::vector<uint8_t>(bytes.begin(), bytes.begin() + 16));
+    ASSERT_THROWS(SolutionArchive{ corruptPath }, std::runtime_error);
+
+    // Bad magic
+    std::vector<uint8_t> corrupt = bytes;
+    corrupt[0] = 'X';
+    WriteFile(corruptPath, corrupt);
+    ASSERT_FALSE(SolutionArchive::IsArchive(corruptPath));
+    ASSERT_THROWS(SolutionArchive{ corruptPath }, std::runtime_error);
+
+    // Damaged section table or contents: either rejected on open or on access, but never read out of bounds
+    for (size_t offset = 8; offset < bytes.size(); offset += 4) {
+        corrupt = bytes;
+        corrupt[offset] ^= 0xff;
+        corrupt[offset + 3] ^= 0x7f;
+        WriteFile(corruptPath, corrupt);
+        try {
+            const SolutionArchive archive(corruptPath);
+            archive.ReadSolutions();
+        }
+        catch (const std::runtime_error&) {
+        }
+    }
+
+    std::remove(path.c_str());
+    std::remove(corruptPath.c_str());
+}
+
+TEST_CASE("Solution archive", "Reading either format") {
+    const std::string archivePath = GetTemporaryPath("sic1-solutionarchive-either-test.bin");
+    const std::string databasePath = GetTemporaryPath("sic1-solutionarchive-either-test.json");
+    const auto solutions = CreateSolutions();
+    WriteSolutionArchive(archivePath, solutions);
+    WriteSolutionDatabase(databasePath, solutions);
+    ASSERT_FALSE(SolutionArchive::IsArchive(databasePath));
+
+    const auto fromArchive = ReadSolutions(archivePath);
+    const auto fromDatabase = ReadSolutions(databasePath);
+    ASSERT_EQUAL(fromArchive.size(), fromDatabase.size());
+    for (size_t i = 0; i < fromArchive.size(); i++) {
+        AssertSolutionsEqual(fromDatabase[i], fromArchive[i]);
+    }
+
+    std::remove(archivePath.c_str());
+    std::remove(databasePath.c_str());
+}
+
+TEST_CASE("Solution archive", "Database formatting") {
+    auto solutions = CreateSolutions();
+    ASSERT_EQUAL(
+        std::string("{\"First Assessment\":{\"1\":{\"cycles\":{\"cycles\":9,\"bytes\":16,\"program\":\"0c0c030cfd06fe0c090d0d000000\"}},")
+        + "\"2\":{\"bytes\":{\"cycles\":null,\"bytes\":null,\"program\":\"\",\"source\":\"web\",\"time\":\"2023-01-02T03:04:05.000Z\"}}},"
+        + "\"Addition\":{\"1\":{\"bytes\":{\"cycles\":null,\"bytes\":20,\"program\":\"010203\"}},"
+        + "\"\xc3\xa9\\\"\\\\\":{\"\":{\"cycles\":0,\"bytes\":0,\"program\":\"ff\"}}}}",
+        FormatSolutionDatabase(solutions));
+
+    // Later entries for the same focus replace earlier ones
+    solutions.push_back(CreateSolution("First Assessment", "1", "cycles", 8, 16, { 1 }));
+    const auto parsed = ParseSolutionDatabase(FormatSolutionDatabase(solutions));
+    ASSERT_EQUAL(4u, parsed.size());
+    AssertSolutionsEqual(solutions.back(), parsed[0]);
+    AssertSolutionsEqual(solutions[2], parsed[1]);
+}
+
+TEST_CASE("Solution archive", "Web archive import") {
+    const std::string text = R"({
+        "Puzzle_abc_First Assessment_cyclesExecuted": { "createTime": {}, "data": { "userId": "abc", "testName": "First Assessment", "program": "0c0c", "cyclesExecuted": 9, "memoryBytesAccessed": 16, "timestamp": { "_seconds": 1672628645, "_nanoseconds": 5 } } },
+        "Puzzle_abc_Addition_memoryBytesAccessed": { "data": { "program": "ff", "cyclesExecuted": 100, "memoryBytesAccessed": 20, "timestamp": { "_seconds": 0, "_nanoseconds": 0 } } },
+        "Puzzle_abc_Unknown Puzzle_cyclesExecuted": { "data": {} },
+        "User_abc": { "data": { "name": "abc" } },
+        "Histogram_First Assessment_cyclesExecuted": { "data": { "9": 1 } }
+    })";
+
+    const auto solutions = ParseWebArchive(text);
+    ASSERT_EQUAL(2u, solutions.size());
+    AssertSolutionsEqual(CreateSolution("First Assessment", "web:abc", "cycles", 9, 16, { 12, 12 }), [&]() {
+        Solution solution = solutions[0];
+        ASSERT_EQUAL(std::string("web"), solution.source);
+        ASSERT_EQUAL(std::string("2023-01-02T03:04:05.000Z"), solution.time);
+        solution.source.clear();
+        solution.time.clear();
+        return solution;
+    }());
+
+    ASSERT_EQUAL(std::string("bytes"), solutions[1].focus);
+    ASSERT_EQUAL(std::string("1970-01-01T00:00:00.000Z"), solutions[1].time);
+}
@@ -0,0 +1,196 @@
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "test.h"
+#include "../json.h"
+#include "../leaderboardcache.h"
+#include "../puzzles.h"
+#include "../simulatedsteam.h"
+#include "../steamleaderboards.h"
+
+using namespace Sic1;
+
+namespace {
+    SimulatedSteamApi::Latency CreateLatency(int milliseconds) {
+        return { std::chrono::milliseconds(milliseconds), std::chrono::microseconds(0) };
+    }
+
+    // Waits for completions (which may run on the pump's thread)
+    class Waiter {
+    public:
+        // Note: Notifies while holding the lock, since the waiter may be destroyed as soon as it sees the count
+        void Signal() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_count++;
+            m_signaled.notify_all();
+        }
+
+        bool Wait(size_t count) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            return m_signaled.wait_for(lock, std::chrono::seconds(10), [&]() { return m_count >= count; });
+        }
+
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_signaled;
+        size_t m_count = 0;
+    };
+
+    std::vector<FriendLeaderboardRow> GetRows(SteamLeaderboards& leaderboards, const std::string& name) {
+        Waiter waiter;
+        SteamCallStatus status = SteamCallStatus::Aborted;
+        std::vector<FriendLeaderboardRow> rows;
+        leaderboards.GetFriendLeaderboardEntries(name, [&](SteamCallStatus s, const std::vector<FriendLeaderboardRow>& r) {
+            status = s;
+            rows = r;
+            waiter.Signal();
+        });
+
+        ASSERT_TRUE(waiter.Wait(1));
+        ASSERT_TRUE(status == SteamCallStatus::Succeeded);
+        return rows;
+    }
+}
+
+TEST_CASE("LeaderboardCache", "Rows") {
+    LeaderboardCache cache(std::chrono::seconds(60));
+    ASSERT_FALSE(cache.GetHandle("Addition_cycles").has_value());
+    ASSERT_FALSE(cache.GetRows("Addition_cycles").has_value());
+
+    const auto now = LeaderboardCache::Clock::now();
+    cache.SetHandle("Addition_cycles", 0x123456789abcdefull);
+    cache.SetRows("Addition_cycles", { { "Me", 10 }, { "Friend", 20 } }, now);
+    ASSERT_EQUAL(0x123456789abcdefull, *cache.GetHandle("Addition_cycles"));
+
+    const auto rows = cache.GetRows("Addition_cycles");
+    ASSERT_EQUAL(2u, rows->rows.size());
+    ASSERT_FALSE(cache.IsStale(*rows, now + std::chrono::seconds(59)));
+    ASSERT_TRUE(cache.IsStale(*rows, now + std::chrono::seconds(60)));
+    ASSERT_TRUE(cache.IsStale(*rows, now - std::chrono::seconds(1)));
+
+    // Invalidating rows keeps the handle
+    cache.InvalidateRows("Addition_cycles");
+    ASSERT_FALSE(cache.GetRows("Addition_cycles").has_value());
+    ASSERT_TRUE(cache.GetHandle("Addition_cycles").has_value());
+}
+
+TEST_CASE("LeaderboardCache", "Persistence") {
+    const auto time = LeaderboardCache::Clock::time_point(std::chrono::seconds(1700000000));
+    LeaderboardCache cache;
+    cache.SetHandle("Addition_cycles", 0xfedcba9876543210ull);
+    cache.SetRows("Addition_cycles", { { "Me \"quoted\"", -5 }, { "Friend", 20 } }, time);
+    cache.SetRows("Solved Count", {}, time);
+
+    LeaderboardCache loaded;
+    loaded.Parse(cache.Format());
+    ASSERT_EQUAL(cache.Format(), loaded.Format());
+    ASSERT_EQUAL(0xfedcba9876543210ull, *loaded.GetHandle("Addition_cycles"));
+    ASSERT_FALSE(loaded.GetHandle("Solved Count").has_value());
+
+    const auto rows = loaded.GetRows("Addition_cycles");
+    ASSERT_TRUE(rows->time == time);
+    ASSERT_EQUAL(std::string("Me \"quoted\""), rows->rows[0].name);
+    ASSERT_EQUAL(-5, rows->rows[0].score);
+    ASSERT_TRUE(loaded.GetRows("Solved Count")->rows.empty());
+
+    // Malformed caches (or caches from other versions) are rejected without changing anything
+    ASSERT_THROWS(loaded.Parse("{\"version\":1,\"leaderboards\":{"), JsonParseError);
+    ASSERT_THROWS(loaded.Parse("{\"version\":2,\"leaderboards\":{}}"), std::runtime_error);
+    ASSERT_THROWS(loaded.Parse("{\"version\":1,\"leaderboards\":{\"A\":{\"handle\":\"x\"}}}"), std::exception);
+    ASSERT_EQUAL(cache.Format(), loaded.Format());
+}
+
+TEST_CASE("SteamLeaderboards", "Prefetch") {
+    const std::vector<std::string> names = GetPuzzleLeaderboardNames();
+    ASSERT_TRUE(std::find(names.begin(), names.end(), "Addition_cycles") != names.end());
+    ASSERT_TRUE(std::find(names.begin(), names.end(), "Addition_bytes") != names.end());
+    ASSERT_EQUAL(std::string("Solved Count"), names.back());
+    ASSERT_EQUAL(GetPuzzles().size() * 2 + 1, names.size());
+
+    SimulatedSteamApi api;
+    api.SetLatency(CreateLatency(50));
+    LeaderboardCache cache;
+    Waiter cacheChanged;
+    SteamCallbackPump pump(api, nullptr);
+    SteamLeaderboards leaderboards(pump, cache, [&]() { cacheChanged.Signal(); });
+
+    // Every leaderboard is looked up at once, so prefetching takes about one round trip
+    const auto start = std::chrono::steady_clock::now();
+    leaderboards.Prefetch(names);
+    ASSERT_TRUE(cacheChanged.Wait(names.size()));
+    ASSERT_TRUE(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(500));
+    ASSERT_EQUAL(names.size(), api.GetCallCount(SteamCallType::FindLeaderboard));
+
+    // Lookups are then served from the cache (on the calling thread)
+    bool found = false;
+    leaderboards.GetLeaderboard("Addition_cycles", [&](SteamCallStatus status, SteamLeaderboardHandle leaderboard) {
+        found = (status == SteamCallStatus::Succeeded) && leaderboard == *cache.GetHandle("Addition_cycles");
+    });
+    ASSERT_TRUE(found);
+    ASSERT_EQUAL(names.size(), api.GetCallCount(SteamCallType::FindLeaderboard));
+
+    // The last lookup may still be finishing on the pump's thread
+    pump.Stop();
+}
+
+TEST_CASE("SteamLeaderboards", "Stale while revalidate") {
+    SimulatedSteamApi api(0, "Me");
+    api.SetLatency(CreateLatency(5));
+    api.AddFriendScore("Addition_cycles", "Friend", 20);
+
+    LeaderboardCache cache(std::chrono::seconds(60));
+    Waiter cacheChanged;
+    SteamCallbackPump pump(api, nullptr);
+    SteamLeaderboards leaderboards(pump, cache, [&]() { cacheChanged.Signal(); });
+
+    // Concurrent requests share a lookup and a download
+    Waiter waiter;
+    std::vector<size_t> rowCounts(3);
+    for (size_t i = 0; i < rowCounts.size(); i++) {
+        leaderboards.GetFriendLeaderboardEntries("Addition_cycles", [&, i](SteamCallStatus status, const std::vector<FriendLeaderboardRow>& rows) {
+            rowCounts[i] = (status == SteamCallStatus::Succeeded) ? rows.size() : 0;
+            waiter.Signal();
+        });
+    }
+
+    ASSERT_TRUE(waiter.Wait(rowCounts.size()));
+    ASSERT_TRUE(rowCounts == std::vector<size_t>({ 1, 1, 1 }));
+    ASSERT_EQUAL(1u, api.GetCallCount(SteamCallType::FindLeaderboard));
+    ASSERT_EQUAL(1u, api.GetCallCount(SteamCallType::DownloadFriendLeaderboardEntries));
+
+    // Fresh rows are served from the cache, without calling Steam
+    api.AddFriendScore("Addition_cycles", "Other friend", 30);
+    ASSERT_EQUAL(1u, GetRows(leaderboards, "Addition_cycles").size());
+    ASSERT_EQUAL(1u, api.GetCallCount(SteamCallType::DownloadFriendLeaderboardEntries));
+
+    // Stale rows are still served immediately, but then refreshed in the background
+    cache.SetRows("Addition_cycles", cache.GetRows("Addition_cycles")->rows, LeaderboardCache::Clock::now() - std::chrono::minutes(2));
+    ASSERT_EQUAL(1u, GetRows(leaderboards, "Addition_cycles").size());
+    ASSERT_TRUE(cacheChanged.Wait(3));
+    ASSERT_EQUAL(2u, api.GetCallCount(SteamCallType::DownloadFriendLeaderboardEntries));
+    ASSERT_EQUAL(2u, GetRows(leaderboards, "Addition_cycles").size());
+
+    // Invalidated rows are downloaded again
+    leaderboards.InvalidateFriendLeaderboardEntries("Addition_cycles");
+    api.AddFriendScore("Addition_cycles", "Third friend", 40);
+    ASSERT_EQUAL(3u, GetRows(leaderboards, "Addition_cycles").size());
+    ASSERT_EQUAL(3u, api.GetCallCount(SteamCallType::DownloadFriendLeaderboardEntries));
+
+    // Failures aren't cached
+    leaderboards.InvalidateFriendLeaderboardEntries("Addition_cycles");
+    api.SetOffline(true);
+    Waiter failed;
+    SteamCallStatus failedStatus = SteamCallStatus::Succeeded;
+    leaderboards.GetFriendLeaderboardEntries("Addition_cycles", [&](SteamCallStatus status, const std::vector<FriendLeaderboardRow>&) {
+        failedStatus = status;
+        failed.Signal();
+    });
+
+    ASSERT_TRUE(failed.Wait(1));
+    ASSERT_TRUE(failedStatus == SteamCallStatus::IoFailed);
+    ASSERT_FALSE(cache.GetRows("Addition_cycles").has_value());
+    pump.Stop();
+}
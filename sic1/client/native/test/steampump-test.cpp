@@ -0,0 +1,256 @@
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "test.h"
+#include "../simulatedsteam.h"
+#include "../steampump.h"
+
+using namespace Sic1;
+
+namespace {
+    // Collects results delivered by a pump
+    class ResultCollector {
+    public:
+        void OnResult(SteamCallHandle call, const SteamCallResult& result) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_results[call] = result;
+            }
+            m_delivered.notify_all();
+        }
+
+        // Waits for the given number of results (in total)
+        bool Wait(size_t count) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            return m_delivered.wait_for(lock, std::chrono::seconds(10), [&]() { return m_results.size() >= count; });
+        }
+
+        SteamCallResult Get(SteamCallHandle call) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_results.at(call);
+        }
+
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_delivered;
+        std::map<SteamCallHandle, SteamCallResult> m_results;
+    };
+
+    SimulatedSteamApi::Latency CreateLatency(int milliseconds) {
+        return { std::chrono::milliseconds(milliseconds), std::chrono::microseconds(0) };
+    }
+
+    // Finds leaderboards concurrently and returns the median latency
+    std::chrono::microseconds MeasureFindLeaderboard(const SteamPumpSchedule& schedule, int latencyMilliseconds) {
+        SimulatedSteamApi api;
+        api.SetLatency(CreateLatency(latencyMilliseconds));
+
+        ResultCollector collector;
+        SteamCallbackPump pump(api, [&](SteamCallHandle call, const SteamCallResult& result) { collector.OnResult(call, result); }, schedule);
+        const size_t count = 4;
+        for (size_t i = 0; i < count; i++) {
+            pump.Start(SteamCallType::FindLeaderboard, [&](SteamApi& steam) { return steam.FindLeaderboard("Puzzle " + std::to_string(i)); });
+        }
+
+        ASSERT_TRUE(collector.Wait(count));
+        const LatencyHistogram histogram = pump.GetLatencyHistogram(SteamCallType::FindLeaderboard);
+        ASSERT_EQUAL(count, histogram.GetCount());
+        return histogram.GetPercentile(50);
+    }
+}
+
+TEST_CASE("SteamPump", "Latency histogram") {
+    LatencyHistogram histogram;
+    ASSERT_EQUAL(0u, histogram.GetCount());
+    ASSERT_EQUAL(0, histogram.GetPercentile(50).count());
+
+    for (int i = 1; i <= 1000; i++) {
+        histogram.Record(std::chrono::microseconds(i));
+    }
+
+    ASSERT_EQUAL(1000u, histogram.GetCount());
+    ASSERT_EQUAL(500, histogram.GetMean().count());
+    ASSERT_EQUAL(1000, histogram.GetMax().count());
+    ASSERT_EQUAL(1, histogram.GetPercentile(0).count());
+    ASSERT_EQUAL(1000, histogram.GetPercentile(100).count());
+
+    // Percentiles are reported to within a bucket (25%)
+    const auto median = histogram.GetPercentile(50).count();
+    ASSERT_TRUE(median >= 500 && median < 625);
+
+    const auto p99 = histogram.GetPercentile(99).count();
+    ASSERT_TRUE(p99 >= 990 && p99 <= 1000);
+
+    // Small latencies are exact
+    LatencyHistogram small;
+    small.Record(std::chrono::microseconds(3));
+    small.Record(std::chrono::microseconds(5));
+    ASSERT_EQUAL(3, small.GetPercentile(50).count());
+
+    // Large ones still land in a bucket
+    small.Record(std::chrono::hours(24 * 365));
+    ASSERT_EQUAL(std::chrono::microseconds(std::chrono::hours(24 * 365)).count(), small.GetPercentile(100).count());
+
+    histogram.Merge(small);
+    ASSERT_EQUAL(1003u, histogram.GetCount());
+}
+
+TEST_CASE("SteamPump", "Simulated Steam") {
+    SimulatedSteamApi api(1, "Me");
+    api.SetLatency(CreateLatency(0));
+    api.SetLatency(SteamCallType::UploadLeaderboardScore, CreateLatency(60000));
+    api.AddFriendScore("Addition", "Friend", 20);
+
+    std::vector<std::pair<SteamCallHandle, SteamCallResult>> results;
+    api.SetResultHandler([&](SteamCallHandle call, const SteamCallResult& result) { results.emplace_back(call, result); });
+
+    // Results are only delivered by RunCallbacks
+    const SteamCallHandle find = api.FindLeaderboard("Addition");
+    ASSERT_TRUE(find != steamCallHandleInvalid);
+    ASSERT_EQUAL(1u, api.GetPendingCallCount());
+    api.RunCallbacks();
+    ASSERT_EQUAL(1u, results.size());
+    ASSERT_EQUAL(find, results[0].first);
+    ASSERT_TRUE(results[0].second.status == SteamCallStatus::Succeeded);
+    const SteamLeaderboardHandle leaderboard = results[0].second.leaderboard;
+
+    // ... once their latency has elapsed
+    api.UploadLeaderboardScore(leaderboard, 30, { 1, 2 });
+    api.RunCallbacks();
+    ASSERT_EQUAL(1u, results.size());
+    ASSERT_EQUAL(1u, api.GetPendingCallCount());
+
+    // Lower scores are better
+    api.SetLatency(SteamCallType::UploadLeaderboardScore, CreateLatency(0));
+    api.UploadLeaderboardScore(leaderboard, 10, { 3 });
+    api.UploadLeaderboardScore(leaderboard, 15, {});
+    api.RunCallbacks();
+    ASSERT_EQUAL(3u, results.size());
+    ASSERT_TRUE(results[1].second.scoreChanged);
+    ASSERT_FALSE(results[2].second.scoreChanged);
+    ASSERT_EQUAL(10, *api.GetUserScore("Addition"));
+    ASSERT_TRUE(api.GetUserScoreDetails("Addition") == std::vector<int>({ 3 }));
+    ASSERT_FALSE(api.GetUserScore("Subtraction").has_value());
+
+    // Friend entries include the user's own score
+    api.DownloadFriendLeaderboardEntries(leaderboard);
+    api.RunCallbacks();
+    const auto& rows = results.back().second.rows;
+    ASSERT_EQUAL(2u, rows.size());
+    ASSERT_EQUAL(std::string("Me"), rows[0].name);
+    ASSERT_EQUAL(10, rows[0].score);
+    ASSERT_EQUAL(std::string("Friend"), rows[1].name);
+
+    // Calls fail while offline
+    api.SetOffline(true);
+    api.StoreStats();
+    api.RunCallbacks();
+    ASSERT_TRUE(results.back().second.status == SteamCallStatus::IoFailed);
+    ASSERT_EQUAL(1u, api.GetCallCount(SteamCallType::StoreStats));
+
+    api.SetAchievement("SIC1_COMPLETE");
+    ASSERT_TRUE(api.GetAchievement("SIC1_COMPLETE"));
+    ASSERT_FALSE(api.GetAchievement("SIC1_OTHER"));
+}
+
+TEST_CASE("SteamPump", "Results") {
+    SimulatedSteamApi api;
+    api.SetLatency(CreateLatency(5));
+
+    ResultCollector collector;
+    SteamCallbackPump pump(api, [&](SteamCallHandle call, const SteamCallResult& result) { collector.OnResult(call, result); });
+    const SteamCallHandle find = pump.Start(SteamCallType::FindLeaderboard, [](SteamApi& steam) { return steam.FindLeaderboard("Addition"); });
+    const SteamCallHandle store = pump.Start(SteamCallType::StoreStats, [](SteamApi& steam) { return steam.StoreStats(); });
+    ASSERT_TRUE(collector.Wait(2));
+    ASSERT_TRUE(collector.Get(find).type == SteamCallType::FindLeaderboard);
+    ASSERT_TRUE(collector.Get(find).leaderboard != 0);
+    ASSERT_TRUE(collector.Get(store).type == SteamCallType::StoreStats);
+    ASSERT_EQUAL(0u, pump.GetOutstandingCallCount());
+    ASSERT_EQUAL(1u, pump.GetLatencyHistogram(SteamCallType::StoreStats).GetCount());
+
+    // Nothing is polled while no calls are outstanding (after the poll that delivered the last result)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    const uint64_t pollCount = pump.GetPollCount();
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    ASSERT_EQUAL(pollCount, pump.GetPollCount());
+
+    // Calls that can't be started throw
+    ASSERT_THROWS(pump.Start(SteamCallType::StoreStats, [](SteamApi&) { return steamCallHandleInvalid; }), std::runtime_error);
+}
+
+TEST_CASE("SteamPump", "Shutdown") {
+    SimulatedSteamApi api;
+    api.SetLatency(CreateLatency(60000));
+
+    ResultCollector collector;
+    SteamCallHandle call = steamCallHandleInvalid;
+    {
+        SteamCallbackPump pump(api, [&](SteamCallHandle call, const SteamCallResult& result) { collector.OnResult(call, result); });
+        call = pump.Start(SteamCallType::UploadLeaderboardScore, [](SteamApi& steam) { return steam.UploadLeaderboardScore(1, 10, {}); });
+    }
+
+    // Outstanding calls are aborted
+    ASSERT_TRUE(collector.Wait(1));
+    ASSERT_TRUE(collector.Get(call).status == SteamCallStatus::Aborted);
+    ASSERT_TRUE(collector.Get(call).type == SteamCallType::UploadLeaderboardScore);
+
+    // Pumps can also be stopped before they're destroyed, after which new calls are aborted immediately
+    SteamCallbackPump pump(api, [&](SteamCallHandle call, const SteamCallResult& result) { collector.OnResult(call, result); });
+    const SteamCallHandle outstanding = pump.Start(SteamCallType::FindLeaderboard, [](SteamApi& steam) { return steam.FindLeaderboard("Addition_cycles"); });
+    pump.Stop();
+    ASSERT_TRUE(collector.Wait(2));
+    ASSERT_TRUE(collector.Get(outstanding).status == SteamCallStatus::Aborted);
+    ASSERT_EQUAL(0u, pump.GetOutstandingCallCount());
+
+    const SteamCallHandle late = pump.Start(SteamCallType::StoreStats, [](SteamApi& steam) { return steam.StoreStats(); });
+    ASSERT_TRUE(collector.Wait(3));
+    ASSERT_TRUE(collector.Get(late).status == SteamCallStatus::Aborted);
+    pump.Stop();
+}
+
+TEST_CASE("SteamPump", "Pipelining") {
+    SimulatedSteamApi api;
+    api.SetLatency(CreateLatency(50));
+
+    // Each call's result goes to its own completion, and nothing is delivered to the pump's handler
+    std::mutex mutex;
+    std::condition_variable delivered;
+    std::map<std::string, SteamLeaderboardHandle> leaderboards;
+    SteamCallbackPump pump(api, nullptr);
+
+    const size_t count = 16;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++) {
+        const std::string name = "Puzzle " + std::to_string(i);
+        pump.Start(SteamCallType::FindLeaderboard, [&](SteamApi& steam) { return steam.FindLeaderboard(name); }, [&, name](const SteamCallResult& result) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                leaderboards[name] = result.leaderboard;
+            }
+            delivered.notify_all();
+        });
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        ASSERT_TRUE(delivered.wait_for(lock, std::chrono::seconds(10), [&]() { return leaderboards.size() == count; }));
+    }
+
+    // All of the calls were outstanding at once, so together they took about one round trip
+    ASSERT_TRUE(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(50 * count / 2));
+    ASSERT_EQUAL(count, api.GetCallCount(SteamCallType::FindLeaderboard));
+    for (size_t i = 0; i < count; i++) {
+        ASSERT_EQUAL(static_cast<SteamLeaderboardHandle>(i + 1), leaderboards.at("Puzzle " + std::to_string(i)));
+    }
+}
+
+TEST_CASE("SteamPump", "Latency") {
+    // Polling every 200 ms adds up to 200 ms to each call...
+    ASSERT_TRUE(MeasureFindLeaderboard(steamPumpScheduleFixed, 20) >= std::chrono::milliseconds(200));
+
+    // ... but the adaptive schedule notices results soon after they arrive
+    ASSERT_TRUE(MeasureFindLeaderboard(steamPumpScheduleDefault, 20) < std::chrono::milliseconds(100));
+}
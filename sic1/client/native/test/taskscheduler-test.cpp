@@ -0,0 +1,194 @@
+#include "test.h"
+#include "../taskscheduler.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+using namespace Sic1;
+
+namespace {
+    // Blocks tasks until it's opened
+    class Gate {
+    public:
+        void Open() {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_open = true;
+            }
+            m_opened.notify_all();
+        }
+
+        void Wait() {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_opened.wait(lock, [this]() { return m_open; });
+        }
+
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_opened;
+        bool m_open = false;
+    };
+}
+
+TEST_CASE("Task scheduler", "Runs all tasks") {
+    TaskScheduler scheduler(TaskSchedulerOptions{ { 2, 1, 2, 4 } });
+    ASSERT_EQUAL(2u, scheduler.GetThreadCount(TaskPriority::Interactive));
+    ASSERT_EQUAL(1u, scheduler.GetThreadCount(TaskPriority::Io));
+    ASSERT_EQUAL(4u, scheduler.GetThreadCount(TaskPriority::Compute));
+
+    std::atomic<uint64_t> sum(0);
+    for (unsigned int i = 1; i <= 10000; i++) {
+        scheduler.Submit(static_cast<TaskPriority>(i % taskPriorityCount), [&sum, i]() { sum += i; });
+    }
+
+    scheduler.Wait();
+    ASSERT_EQUAL(50005000ull, static_cast<unsigned long long>(sum.load()));
+
+    // Tasks can queue more tasks (of any class)
+    std::atomic<unsigned int> count(0);
+    for (unsigned int i = 0; i < 100; i++) {
+        scheduler.Submit(TaskPriority::Compute, [&scheduler, &count, i]() {
+            for (unsigned int j = 0; j < 100; j++) {
+                scheduler.Submit((j % 2) ? TaskPriority::Compute : TaskPriority::Io, [&count]() { count++; });
+            }
+        });
+    }
+
+    scheduler.Wait();
+    ASSERT_EQUAL(10000u, count.load());
+}
+
+TEST_CASE("Task scheduler", "Classes are isolated") {
+    TaskScheduler scheduler(TaskSchedulerOptions{ { 1, 1, 2, 1 } });
+
+    // Tie up every network worker (like slow Steam calls would)
+    Gate gate;
+    for (unsigned int i = 0; i < 8; i++) {
+        scheduler.Submit(TaskPriority::Network, [&gate]() { gate.Wait(); });
+    }
+
+    // Interactive and I/O tasks still run
+    std::atomic<unsigned int> count(0);
+    for (unsigned int i = 0; i < 10; i++) {
+        scheduler.Submit(TaskPriority::Interactive, [&count]() { count++; });
+        scheduler.Submit(TaskPriority::Io, [&count]() { count++; });
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (count.load() < 20 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    ASSERT_EQUAL(20u, count.load());
+    ASSERT_FALSE(scheduler.WaitFor(std::chrono::milliseconds(10)));
+
+    gate.Open();
+    scheduler.Wait();
+}
+
+TEST_CASE("Task scheduler", "Cancellation") {
+    TaskScheduler scheduler(TaskSchedulerOptions{ { 1, 1, 1, 1 } });
+    Gate gate;
+    Gate started;
+    scheduler.Submit(TaskPriority::Io, [&]() {
+        started.Open();
+        gate.Wait();
+    });
+    started.Wait();
+
+    // Queued tasks are skipped once their token is canceled
+    CancellationSource source;
+    std::atomic<unsigned int> count(0);
+    for (unsigned int i = 0; i < 10; i++) {
+        scheduler.Submit(TaskPriority::Io, [&count]() { count++; }, source.GetToken());
+    }
+
+    // ...but tasks with other tokens aren't
+    CancellationSource otherSource;
+    scheduler.Submit(TaskPriority::Io, [&count]() { count += 100; }, otherSource.GetToken());
+    scheduler.Submit(TaskPriority::Io, [&count]() { count += 1000; });
+
+    // Running tasks can check their token
+    std::atomic<bool> observed(false);
+    Gate running;
+    scheduler.Submit(TaskPriority::Compute, [&, token = source.GetToken()]() {
+        running.Open();
+        while (!token.IsCanceled()) {
+            std::this_thread::yield();
+        }
+        observed = true;
+    });
+
+    running.Wait();
+    source.Cancel();
+    ASSERT_TRUE(source.IsCanceled());
+    ASSERT_FALSE(otherSource.IsCanceled());
+    ASSERT_FALSE(CancellationToken().IsCanceled());
+
+    gate.Open();
+    scheduler.Wait();
+    ASSERT_EQUAL(1100u, count.load());
+    ASSERT_TRUE(observed.load());
+}
+
+TEST_CASE("Task scheduler", "Task pool") {
+    // Small closures are stored inline, and large ones on the heap
+    std::array<char, InlineTask::capacity * 2> large = {};
+    large[0] = 1;
+    int result = 0;
+    InlineTask task;
+    task.Emplace([&result]() { result = 1; });
+    ASSERT_TRUE(task.IsInline());
+    task();
+    ASSERT_EQUAL(1, result);
+
+    task.Emplace([&result, large]() { result = 2 + large[0]; });
+    ASSERT_FALSE(task.IsInline());
+    task();
+    ASSERT_EQUAL(3, result);
+
+    // Captured state is released when the task is reset
+    auto shared = std::make_shared<int>(0);
+    task.Emplace([shared]() {});
+    ASSERT_EQUAL(2l, shared.use_count());
+    task.Reset();
+    ASSERT_FALSE(static_cast<bool>(task));
+    ASSERT_EQUAL(1l, shared.use_count());
+
+    // Task nodes are reused
+    TaskScheduler scheduler(TaskSchedulerOptions{ { 1, 1, 1, 2 } });
+    std::atomic<unsigned int> count(0);
+    for (unsigned int round = 0; round < 100; round++) {
+        for (unsigned int i = 0; i < 32; i++) {
+            scheduler.Submit(TaskPriority::Compute, [&count, shared]() { count++; });
+        }
+        scheduler.Wait();
+    }
+
+    ASSERT_EQUAL(3200u, count.load());
+    ASSERT_EQUAL(64u, scheduler.GetTaskNodeCount());
+    ASSERT_EQUAL(1l, shared.use_count());
+}
+
+TEST_CASE("Task scheduler", "Exceptions") {
+    TaskScheduler scheduler(TaskSchedulerOptions{ { 1, 1, 1, 2 } });
+    std::atomic<unsigned int> count(0);
+    for (unsigned int i = 0; i < 10; i++) {
+        scheduler.Submit(TaskPriority::Compute, [&count, i]() {
+            count++;
+            if (i == 5) {
+                throw std::runtime_error("Task failed");
+            }
+        });
+    }
+
+    // Other tasks still run, and the first exception is rethrown (once)
+    ASSERT_THROWS(scheduler.Wait(), std::runtime_error);
+    ASSERT_EQUAL(10u, count.load());
+    scheduler.Wait();
+}
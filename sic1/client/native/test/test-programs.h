@@ -0,0 +1,290 @@
+#pragma once
+
+#include <random>
+#include <vector>
+#include "test.h"
+#include "../embeddedassembler.h"
+#include "../emulator.h"
+#include "../subleqprograms.h"
+#include "../verifier.h"
+
+// Shared programs and helpers for tests that compare execution engines
+namespace TestPrograms {
+    // Supplies inputs from a list and records outputs
+    class ListIo {
+    public:
+        explicit ListIo(std::vector<int> inputs) : m_inputs(std::move(inputs)), m_inputIndex(0) {
+        }
+
+        bool TryReadInput(uint8_t& value) {
+            if (m_inputIndex >= m_inputs.size()) {
+                return false;
+            }
+
+            value = Sic1::SignedToUnsigned(m_inputs[m_inputIndex++]);
+            return true;
+        }
+
+        void WriteOutput(int8_t value) {
+            outputs.push_back(value);
+        }
+
+        std::vector<int> outputs;
+
+    private:
+        std::vector<int> m_inputs;
+        size_t m_inputIndex;
+    };
+
+    // tools/samples/sample.ois
+    constexpr const char* sampleSource =
+        "; Read a number and print out that many 1s (e.g. 3 -> [1, 1, 1])\n"
+        "\n"
+        "    ; Instruction                ; Explanation (using input of 3 as an example)\n"
+        "                                 ; Note: as defined in the \"State\" section below: @tmp = -1 and @count = 0\n"
+        "    ;----------------------------|------------------------------------------------------------------------\n"
+        "    subleq @tmp,   @IN           ; Read input and subtract from @tmp (@tmp = -1 - 3 = -4)\n"
+        "    subleq @count, @tmp          ; Negate tmp into count (@count = 0 - (-4) = 4)\n"
+        "@loop:                           ;\n"
+        "    subleq @count, @one,   @HALT ; Subtract 1 from count and halt if <= 0 (@count = 4 - 1 = 3, for the first iteration)\n"
+        "    subleq @OUT,   @n_one        ; Output 1 (note the constant is -1 since we'll be subtracting: @OUT = 0 - (-1) = 1)\n"
+        "    subleq @zero,  @zero,  @loop ; Jump to address 9 (@zero = 0 - 0 = 0, which is <= 0, so  jump to @loop and iterate)\n"
+        "\n"
+        "; State \n"
+        "    @tmp:   .data -1\n"
+        "    @count: .data 0\n"
+        "\n"
+        "; Constants \n"
+        "    @zero:  .data 0\n"
+        "    @one:   .data 1\n"
+        "    @n_one: .data -1";
+
+    // Assembled at compile time (see embeddedassembler-test.cpp for checks of the expected bytes)
+    constexpr auto sampleEmbedded = Sic1::EmbeddedAssembler::Assemble(sampleSource);
+    const std::vector<uint8_t> sampleProgram = sampleEmbedded.GetBytes();
+
+    // tools/samples/bounds.ois (outputs -128, -127, -128, 127, and then halts)
+    constexpr const char* boundsSource =
+        "subleq @OUT, @a\n"
+        "subleq @OUT, @b\n"
+        "subleq @b, @n_one\n"
+        "subleq @OUT, @b\n"
+        "subleq @b, @n_one\n"
+        "subleq @OUT, @b\n"
+        "subleq @zero, @zero, @HALT\n"
+        "\n"
+        "@a: .data -128\n"
+        "@b: .data 127\n"
+        "\n"
+        "@zero: .data 0\n"
+        "@n_one: .data -1\n"
+        "@one: .data 1\n"
+        "@min: .data -128\n"
+        "@max: .data 127\n";
+
+    constexpr auto boundsEmbedded = Sic1::EmbeddedAssembler::Assemble(boundsSource);
+    const std::vector<uint8_t> boundsProgram = boundsEmbedded.GetBytes();
+
+    // Programs from the "Valid programs" tests in lib/test/sic1asm.spec.ts (see embeddedassembler-test.cpp for their
+    // expected bytes)
+    constexpr const char* singleInstructionSource =
+        "subleq @OUT, @IN\n";
+
+    constexpr const char* negationLoopSource =
+        "@loop:\n"
+        "subleq @OUT, @IN\n"
+        "!subleq @zero, @zero, @loop\n"
+        "\n"
+        "@zero: .data 0\n";
+
+    constexpr const char* dataWithoutLabelSource =
+        ".data 0\n";
+
+    constexpr const char* inlineVariablesSource =
+        ".data @tmp: 0 @tmp2: 2 @three: 3\n";
+
+    constexpr const char* inlineLabelLoopSource =
+        "@loop:\n"
+        "subleq @tmp: 0, @IN\n"
+        "subleq @tmp, @IN\n"
+        "subleq @OUT, @tmp\n"
+        "subleq @tmp, @tmp, @loop\n";
+
+    // ListIo for other SubleqMachines
+    template<typename TMachine>
+    class WordListIo {
+    public:
+        explicit WordListIo(std::vector<int64_t> inputs) : m_inputs(std::move(inputs)), m_inputIndex(0) {
+        }
+
+        bool TryReadInput(typename TMachine::Word& value) {
+            if (m_inputIndex >= m_inputs.size()) {
+                return false;
+            }
+
+            value = static_cast<typename TMachine::Word>(m_inputs[m_inputIndex++]);
+            return true;
+        }
+
+        void WriteOutput(typename TMachine::SignedWord value) {
+            outputs.push_back(value);
+        }
+
+        std::vector<int64_t> outputs;
+
+    private:
+        std::vector<int64_t> m_inputs;
+        size_t m_inputIndex;
+    };
+
+    // Random (but mostly non-halting) programs, including ones that modify their own code
+    inline std::vector<uint8_t> CreateRandomProgram(std::mt19937& random) {
+        const unsigned int instructionCount = std::uniform_int_distribution<unsigned int>(2, 40)(random);
+        const unsigned int dataCount = std::uniform_int_distribution<unsigned int>(1, 20)(random);
+        const unsigned int size = instructionCount * Sic1::Constants::subleqInstructionBytes + dataCount;
+
+        std::uniform_int_distribution<unsigned int> anyAddress(0, Sic1::Constants::addressMax);
+        std::uniform_int_distribution<unsigned int> programAddress(0, size - 1);
+        std::uniform_int_distribution<unsigned int> percent(0, 99);
+
+        std::vector<uint8_t> bytes;
+        for (unsigned int i = 0; i < instructionCount; i++) {
+            for (unsigned int operand = 0; operand < Sic1::Constants::subleqInstructionBytes; operand++) {
+                const unsigned int roll = percent(random);
+                if (roll < 3) {
+                    bytes.push_back(static_cast<uint8_t>(anyAddress(random)));
+                }
+                else if (operand < 2 && roll < 15) {
+                    bytes.push_back(static_cast<uint8_t>(Sic1::Constants::addressInput + (roll % 3)));
+                }
+                else if (operand == 2 && roll < 40) {
+                    // Jump to the start of an instruction
+                    bytes.push_back(static_cast<uint8_t>(std::uniform_int_distribution<unsigned int>(0, instructionCount - 1)(random) * Sic1::Constants::subleqInstructionBytes));
+                }
+                else {
+                    bytes.push_back(static_cast<uint8_t>(programAddress(random)));
+                }
+            }
+        }
+
+        for (unsigned int i = 0; i < dataCount; i++) {
+            bytes.push_back(static_cast<uint8_t>(anyAddress(random)));
+        }
+
+        return bytes;
+    }
+
+    inline std::vector<int> CreateRandomInputs(std::mt19937& random, unsigned int count) {
+        std::uniform_int_distribution<int> value(Sic1::Constants::valueMin, Sic1::Constants::valueMax);
+        std::vector<int> inputs;
+        for (unsigned int i = 0; i < count; i++) {
+            inputs.push_back(value(random));
+        }
+        return inputs;
+    }
+
+    // Runs an alternate engine in lockstep with the reference emulator, checking that all observable state matches
+    template<typename TEngine>
+    void CompareWithEmulator(const std::vector<uint8_t>& bytes, const std::vector<int>& inputs, unsigned int steps) {
+        Sic1::Emulator expected(bytes);
+        TEngine actual(bytes);
+        ListIo expectedIo(inputs);
+        ListIo actualIo(inputs);
+        expected.TakeMemoryUpdate();
+        actual.TakeMemoryUpdate();
+
+        for (unsigned int i = 0; i < steps && expected.IsRunning(); i++) {
+            expected.Step(expectedIo);
+            actual.Step(actualIo);
+
+            ASSERT_EQUAL(expected.IsRunning(), actual.IsRunning());
+            ASSERT_EQUAL(expected.GetIp(), actual.GetIp());
+            ASSERT_EQUAL(expected.GetCyclesExecuted(), actual.GetCyclesExecuted());
+            ASSERT_EQUAL(expected.GetMemoryBytesAccessed(), actual.GetMemoryBytesAccessed());
+            ASSERT_TRUE(expectedIo.outputs == actualIo.outputs);
+        }
+
+        for (unsigned int address = 0; address <= Sic1::Constants::addressMax; address++) {
+            ASSERT_EQUAL(expected.GetMemory(address), actual.GetMemory(address));
+        }
+
+        // The same addresses should have been reported as written
+        ASSERT_TRUE(expected.TakeMemoryUpdate().changed == actual.TakeMemoryUpdate().changed);
+    }
+
+    // Runs an alternate engine and the reference emulator the way verification does (stopping after a number of
+    // outputs or when a limit is exceeded), checking that the final state matches
+    template<typename TEngine>
+    void CompareVerificationWithEmulator(const std::vector<uint8_t>& bytes, const std::vector<int>& inputs, size_t outputCount, uint64_t cyclesExecutedMax, unsigned int memoryBytesAccessedMax) {
+        Sic1::Emulator expected(bytes);
+        TEngine actual(bytes);
+        ListIo expectedIo(inputs);
+        ListIo actualIo(inputs);
+        expected.TakeMemoryUpdate();
+        actual.TakeMemoryUpdate();
+
+        while (expected.IsRunning() && expectedIo.outputs.size() < outputCount && expected.GetCyclesExecuted() <= cyclesExecutedMax && expected.GetMemoryBytesAccessed() <= memoryBytesAccessedMax) {
+            expected.Step(expectedIo);
+        }
+
+        while (actual.IsRunning() && actualIo.outputs.size() < outputCount && actual.GetCyclesExecuted() <= cyclesExecutedMax && actual.GetMemoryBytesAccessed() <= memoryBytesAccessedMax) {
+            actual.StepBlock(actualIo, cyclesExecutedMax, memoryBytesAccessedMax);
+        }
+
+        ASSERT_EQUAL(expected.IsRunning(), actual.IsRunning());
+        ASSERT_EQUAL(expected.GetIp(), actual.GetIp());
+        ASSERT_EQUAL(expected.GetCyclesExecuted(), actual.GetCyclesExecuted());
+        ASSERT_EQUAL(expected.GetMemoryBytesAccessed(), actual.GetMemoryBytesAccessed());
+        ASSERT_TRUE(expectedIo.outputs == actualIo.outputs);
+        for (unsigned int address = 0; address <= Sic1::Constants::addressMax; address++) {
+            ASSERT_EQUAL(expected.GetMemory(address), actual.GetMemory(address));
+        }
+        ASSERT_TRUE(expected.TakeMemoryUpdate().changed == actual.TakeMemoryUpdate().changed);
+    }
+
+    inline Sic1::TestSet CreateRandomTestSet(std::mt19937& random, unsigned int inputCount, unsigned int outputCount) {
+        std::uniform_int_distribution<int> value(Sic1::Constants::valueMin, Sic1::Constants::valueMax);
+        Sic1::TestSet testSet;
+        for (unsigned int i = 0; i < inputCount; i++) {
+            testSet.input.push_back(static_cast<int8_t>(value(random)));
+        }
+
+        // Note: Random programs rarely produce the "right" output, so mostly use small values
+        std::uniform_int_distribution<int> smallValue(-2, 2);
+        for (unsigned int i = 0; i < outputCount; i++) {
+            testSet.output.push_back(static_cast<int8_t>(smallValue(random)));
+        }
+        return testSet;
+    }
+
+    inline void AssertVerificationResultsEqual(const Sic1::VerificationResult& expected, const Sic1::VerificationResult& actual) {
+        ASSERT_EQUAL(static_cast<int>(expected.status), static_cast<int>(actual.status));
+        ASSERT_EQUAL(expected.cyclesExecuted, actual.cyclesExecuted);
+        ASSERT_EQUAL(expected.memoryBytesAccessed, actual.memoryBytesAccessed);
+        ASSERT_EQUAL(expected.inputIndex, actual.inputIndex);
+        if (expected.status == Sic1::VerificationStatus::IncorrectOutput) {
+            ASSERT_EQUAL(expected.errorOutputIndex, actual.errorOutputIndex);
+            ASSERT_EQUAL(expected.errorExpected, actual.errorExpected);
+            ASSERT_EQUAL(expected.errorActual, actual.errorActual);
+        }
+    }
+
+    // For comparing results when loop detection is enabled: loops may be detected at different times (or not at all,
+    // before reaching the cycle limit), but otherwise results must be identical.
+    //
+    // When both results are NonTerminating, only the cycle count and input index (which counts reads past the end of
+    // the input) depend on where each engine checks for loops. The loop has been run all the way around at least once
+    // by the time it's detected, so every address it accesses has been counted.
+    inline void AssertVerificationResultsAgree(const Sic1::VerificationResult& expected, const Sic1::VerificationResult& actual) {
+        if (expected.status == Sic1::VerificationStatus::NonTerminating && actual.status == Sic1::VerificationStatus::NonTerminating) {
+            ASSERT_EQUAL(expected.memoryBytesAccessed, actual.memoryBytesAccessed);
+        }
+        else if (expected.status == Sic1::VerificationStatus::NonTerminating || actual.status == Sic1::VerificationStatus::NonTerminating) {
+            ASSERT_TRUE(expected.status == Sic1::VerificationStatus::NonTerminating || expected.status == Sic1::VerificationStatus::ResourceLimitExceeded);
+            ASSERT_TRUE(actual.status == Sic1::VerificationStatus::NonTerminating || actual.status == Sic1::VerificationStatus::ResourceLimitExceeded);
+        }
+        else {
+            AssertVerificationResultsEqual(expected, actual);
+        }
+    }
+}
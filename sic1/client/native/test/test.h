@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Minimal test harness (in the spirit of mocha's describe/it) so the native code has no external dependencies
+namespace Test {
+    typedef void (*TestFunction)();
+
+    typedef struct {
+        const char* suite;
+        const char* name;
+        TestFunction run;
+    } TestCase;
+
+    inline std::vector<TestCase>& GetTestCases() {
+        static std::vector<TestCase> testCases;
+        return testCases;
+    }
+
+    class Registration {
+    public:
+        Registration(const char* suite, const char* name, TestFunction run) {
+            GetTestCases().push_back({ suite, name, run });
+        }
+    };
+
+    class AssertionError : public std::runtime_error {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+
+    // Print bytes as numbers instead of characters
+    template<typename T>
+    const T& Printable(const T& value) {
+        return value;
+    }
+
+    inline int Printable(int8_t value) {
+        return value;
+    }
+
+    inline int Printable(uint8_t value) {
+        return value;
+    }
+
+    template<typename TExpected, typename TActual>
+    void AssertEqual(const TExpected& expected, const TActual& actual, const char* expression, const char* file, int line) {
+        if (!(expected == actual)) {
+            std::ostringstream message;
+            message << file << "(" << line << "): " << expression << ": expected " << Printable(expected) << " but got " << Printable(actual);
+            throw AssertionError(message.str());
+        }
+    }
+
+    inline void AssertTrue(bool condition, const char* expression, const char* file, int line) {
+        if (!condition) {
+            std::ostringstream message;
+            message << file << "(" << line << "): assertion failed: " << expression;
+            throw AssertionError(message.str());
+        }
+    }
+
+    int RunAll();
+}
+
+#define TEST_CONCAT_INNER(a, b) a##b
+#define TEST_CONCAT(a, b) TEST_CONCAT_INNER(a, b)
+
+#define TEST_CASE(suite, name) \
+    static void TEST_CONCAT(TestFunction, __LINE__)(); \
+    static Test::Registration TEST_CONCAT(testRegistration, __LINE__)(suite, name, &TEST_CONCAT(TestFunction, __LINE__)); \
+    static void TEST_CONCAT(TestFunction, __LINE__)()
+
+#define ASSERT_EQUAL(expected, actual) Test::AssertEqual((expected), (actual), #actual, __FILE__, __LINE__)
+#define ASSERT_TRUE(condition) Test::AssertTrue((condition), #condition, __FILE__, __LINE__)
+#define ASSERT_FALSE(condition) Test::AssertTrue(!(condition), "!(" #condition ")", __FILE__, __LINE__)
+#define ASSERT_THROWS(expression, exceptionType) \
+    do { \
+        bool thrown = false; \
+        try { expression; } \
+        catch (const exceptionType&) { thrown = true; } \
+        Test::AssertTrue(thrown, #expression " throws " #exceptionType, __FILE__, __LINE__); \
+    } while (false)
@@ -0,0 +1,128 @@
+#include <random>
+#include "test.h"
+#include "test-programs.h"
+#include "../translated.h"
+
+using namespace Sic1;
+using namespace TestPrograms;
+
+TEST_CASE("Translated emulator", "Sample program") {
+    TranslatedEmulator emulator(sampleProgram);
+    ListIo io({ 3 });
+    emulator.Run(io);
+
+    ASSERT_TRUE(io.outputs == std::vector<int>({ 1, 1, 1 }));
+    ASSERT_EQUAL(12u, emulator.GetCyclesExecuted());
+    ASSERT_EQUAL(22u, emulator.GetMemoryBytesAccessed());
+}
+
+TEST_CASE("Translated emulator", "Fused copy") {
+    // @loop:
+    // subleq @tmp, @tmp
+    // subleq @tmp, @x
+    // subleq @y, @y
+    // subleq @y, @tmp
+    // subleq @x, @n_one        ; Increment @x
+    // subleq @OUT, @y
+    // subleq @zero, @zero, @loop
+    // @tmp: .data 0
+    // @x: .data 5
+    // @y: .data 0
+    // @n_one: .data -1
+    // @zero: .data 0
+    const std::vector<uint8_t> bytes = {
+        21, 21, 3,
+        21, 22, 6,
+        23, 23, 9,
+        23, 21, 12,
+        22, 24, 15,
+        254, 23, 18,
+        25, 25, 0,
+        0, 5, 0, 0xff, 0,
+    };
+
+    TranslatedEmulator emulator(bytes);
+    ListIo io({});
+    emulator.Run(io, 70);
+    ASSERT_TRUE(io.outputs == std::vector<int>({ -5, -6, -7, -8, -9, -10, -11, -12, -13, -14 }));
+
+    for (unsigned int cycles = 1; cycles < 60; cycles++) {
+        CompareVerificationWithEmulator<TranslatedEmulator>(bytes, {}, 1000, cycles, Constants::memorySize);
+    }
+}
+
+TEST_CASE("Translated emulator", "Self-modifying loop falls back to interpreter") {
+    // Sums bytes from a table using an instruction that is patched on each iteration:
+    //
+    // @loop:
+    // subleq @sum, @table       ; Operand is incremented below
+    // subleq @loop+1, @n_one
+    // subleq @count, @one, @done
+    // subleq @zero, @zero, @loop
+    // @done:
+    // subleq @OUT, @sum, @HALT
+    const std::vector<uint8_t> bytes = {
+        15, 20, 3,
+        1, 16, 6,
+        18, 17, 12,
+        19, 19, 0,
+        254, 15, 255,
+        0, 0xff, 1, 5, 0,
+        1, 2, 3, 4, 5,
+    };
+
+    TranslatedEmulator emulator(bytes);
+    ListIo io({});
+    emulator.Run(io);
+    ASSERT_TRUE(io.outputs == std::vector<int>({ 15 }));
+
+    CompareWithEmulator<TranslatedEmulator>(bytes, {}, 1000);
+    CompareVerificationWithEmulator<TranslatedEmulator>(bytes, {}, 1, 100000, Constants::memorySize);
+}
+
+TEST_CASE("Translated emulator", "Matches emulator on random programs") {
+    std::mt19937 random(5678);
+    std::uniform_int_distribution<unsigned int> cycles(1, 2000);
+    std::uniform_int_distribution<unsigned int> bytes(10, Constants::memorySize);
+    std::uniform_int_distribution<unsigned int> outputs(1, 20);
+    for (unsigned int i = 0; i < 2000; i++) {
+        const auto program = CreateRandomProgram(random);
+        const auto inputs = CreateRandomInputs(random, 20);
+        CompareWithEmulator<TranslatedEmulator>(program, inputs, 500);
+        CompareVerificationWithEmulator<TranslatedEmulator>(program, inputs, outputs(random), cycles(random), bytes(random));
+    }
+}
+
+TEST_CASE("Translated emulator", "Reset keeps translations") {
+    // Blocks translated (or discarded, for self-modifying code) during one run must not change the results of the next
+    std::mt19937 random(91011);
+    for (unsigned int i = 0; i < 500; i++) {
+        const auto program = CreateRandomProgram(random);
+        TranslatedEmulator translated(program);
+        for (unsigned int run = 0; run < 3; run++) {
+            const auto inputs = CreateRandomInputs(random, 20);
+            Emulator expected(program);
+            ListIo expectedIo(inputs);
+            ListIo actualIo(inputs);
+            if (run > 0) {
+                translated.Reset();
+            }
+
+            while (expected.IsRunning() && expected.GetCyclesExecuted() < 2000) {
+                expected.Step(expectedIo);
+            }
+
+            while (translated.IsRunning() && translated.GetCyclesExecuted() < 2000) {
+                translated.StepBlock(actualIo, 1999, Constants::memorySize);
+            }
+
+            ASSERT_EQUAL(expected.GetIp(), translated.GetIp());
+            ASSERT_EQUAL(expected.GetCyclesExecuted(), translated.GetCyclesExecuted());
+            ASSERT_EQUAL(expected.GetMemoryBytesAccessed(), translated.GetMemoryBytesAccessed());
+            ASSERT_TRUE(expectedIo.outputs == actualIo.outputs);
+            for (unsigned int address = 0; address <= Constants::addressMax; address++) {
+                ASSERT_EQUAL(expected.GetMemory(address), translated.GetMemory(address));
+            }
+        }
+    }
+}
@@ -0,0 +1,146 @@
+#include "test.h"
+#include "../batchverifier.h"
+#include "../verdictcache.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+using namespace Sic1;
+
+namespace {
+    Solution CreateSolution(const std::string& userId, const std::vector<uint8_t>& program, std::optional<uint64_t> cycles = std::nullopt) {
+        Solution solution;
+        solution.puzzleTitle = "First Assessment";
+        solution.userId = userId;
+        solution.focus = "cycles";
+        solution.cycles = cycles;
+        solution.program = program;
+        return solution;
+    }
+
+    std::string GetTemporaryPath(const char* name) {
+        return (std::filesystem::temp_directory_path() / name).string();
+    }
+}
+
+TEST_CASE("Verdict cache", "Solution digests") {
+    const Solution solution = CreateSolution("1", { 1, 2, 3 });
+    ASSERT_TRUE(GetSolutionDigest(solution) == GetSolutionDigest(CreateSolution("2", { 1, 2, 3 })));
+    ASSERT_TRUE(GetSolutionDigest(solution) == GetSolutionDigest(CreateSolution("1", { 1, 2, 3 }, solutionCyclesExecutedMax)));
+    ASSERT_FALSE(GetSolutionDigest(solution) == GetSolutionDigest(CreateSolution("1", { 1, 2, 3, 0 })));
+    ASSERT_FALSE(GetSolutionDigest(solution) == GetSolutionDigest(CreateSolution("1", { 1, 2, 3 }, 100)));
+
+    Solution other = solution;
+    other.puzzleTitle = "Addition";
+    ASSERT_FALSE(GetSolutionDigest(solution) == GetSolutionDigest(other));
+
+    other = solution;
+    other.bytes = 10;
+    ASSERT_FALSE(GetSolutionDigest(solution) == GetSolutionDigest(other));
+
+    ASSERT_EQUAL(32u, FormatSolutionDigest(GetSolutionDigest(solution)).size());
+}
+
+TEST_CASE("Verdict cache", "Save and load") {
+    const std::string path = GetTemporaryPath("sic1-verdictcache-test.txt");
+    const SolutionDigest first = GetSolutionDigest(CreateSolution("1", { 1, 2, 3 }));
+    const SolutionDigest second = GetSolutionDigest(CreateSolution("1", { 4, 5, 6 }));
+
+    VerdictCache cache;
+    cache.SetParameters(1234, 200);
+    cache.Set(first, 0);
+    cache.Set(second, 17);
+    cache.Save(path);
+
+    VerdictCache loaded;
+    loaded.Load(path);
+    ASSERT_EQUAL(1234ull, static_cast<unsigned long long>(loaded.GetSeed()));
+    ASSERT_EQUAL(200u, loaded.GetIterations());
+    ASSERT_EQUAL(2u, loaded.GetSize());
+
+    unsigned int failures = 0;
+    ASSERT_TRUE(loaded.TryGet(second, failures));
+    ASSERT_EQUAL(17u, failures);
+    ASSERT_TRUE(loaded.TryGet(first, failures));
+    ASSERT_EQUAL(0u, failures);
+
+    // Verdicts only apply to the seed and number of iterations they were computed with
+    loaded.SetParameters(1234, 200);
+    ASSERT_EQUAL(2u, loaded.GetSize());
+    loaded.SetParameters(1234, 100);
+    ASSERT_EQUAL(0u, loaded.GetSize());
+    ASSERT_FALSE(loaded.TryGet(first, failures));
+
+    std::filesystem::remove(path);
+
+    // Missing files are treated as empty caches
+    loaded.Load(path);
+    ASSERT_EQUAL(0u, loaded.GetSize());
+}
+
+TEST_CASE("Verdict cache", "Malformed files") {
+    const std::string path = GetTemporaryPath("sic1-verdictcache-malformed-test.txt");
+    const char* const contents[] = {
+        "not a cache\n",
+        "sic1-verdicts x\n",
+        "sic1-verdicts 2\nverifier 1\nseed x\n",
+        "sic1-verdicts 2\nseed 1\niterations 10\n",
+        "sic1-verdicts 2\nverifier 1\nseed 1\niterations 10\n0123 1\n",
+        "sic1-verdicts 2\nverifier 1\nseed 1\niterations 10\n0123456789abcdef0123456789abcdef 11\n",
+        "sic1-verdicts 2\nverifier 1\nseed 1\niterations 10\n0123456789abcdef0123456789abcdef x\n",
+
+        // Digests must be entirely hexadecimal
+        "sic1-verdicts 2\nverifier 1\nseed 1\niterations 10\n0123456789abcdef0123456789abcdeg 1\n",
+        "sic1-verdicts 2\nverifier 1\nseed 1\niterations 10\n-123456789abcdef0123456789abcdef 1\n",
+        "sic1-verdicts 2\nverifier 1\nseed 1\niterations 10\n0123456789abcdef 123456789abcdef 1\n",
+    };
+
+    for (const char* content : contents) {
+        {
+            std::ofstream stream(path, std::ios::trunc);
+            stream << content;
+        }
+
+        VerdictCache cache;
+        ASSERT_THROWS(cache.Load(path), std::runtime_error);
+    }
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Verdict cache", "Versions") {
+    const std::string path = GetTemporaryPath("sic1-verdictcache-version-test.txt");
+    const std::string entries = "seed 1\niterations 10\n0123456789ABCDEF0123456789abcdef 3\n";
+    const auto load = [&](const std::string& content) {
+        {
+            std::ofstream stream(path, std::ios::trunc);
+            stream << content;
+        }
+
+        VerdictCache cache;
+        cache.Load(path);
+        return cache;
+    };
+
+    const VerdictCache current = load("sic1-verdicts 2\nverifier " + std::to_string(verdictCacheVerifierVersion) + "\n" + entries);
+    unsigned int failures = 0;
+    ASSERT_EQUAL(1u, current.GetSize());
+    ASSERT_TRUE(current.TryGet({ 0x0123456789abcdefull, 0x0123456789abcdefull }, failures));
+    ASSERT_EQUAL(3u, failures);
+
+    // Verdicts from other verifier or file format versions may be stale, so they're discarded
+    const std::string staleContents[] = {
+        "sic1-verdicts 2\nverifier " + std::to_string(verdictCacheVerifierVersion + 1) + "\n" + entries,
+        "sic1-verdicts 1\n" + entries,
+        "sic1-verdicts 3\nanything\n",
+    };
+
+    for (const std::string& content : staleContents) {
+        const VerdictCache stale = load(content);
+        ASSERT_EQUAL(0u, stale.GetSize());
+        ASSERT_EQUAL(0u, stale.GetIterations());
+    }
+
+    std::filesystem::remove(path);
+}
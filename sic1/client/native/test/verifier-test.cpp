@@ -0,0 +1,146 @@
+#include <random>
+#include "test.h"
+#include "test-programs.h"
+#include "../translated.h"
+#include "../verifier.h"
+
+using namespace Sic1;
+using namespace TestPrograms;
+
+TEST_CASE("Verifier", "Correct output") {
+    const VerificationResult result = VerifyProgram(sampleProgram, { { 3 }, { 1, 1, 1 } }, 100, 100);
+    ASSERT_EQUAL(static_cast<int>(VerificationStatus::Success), static_cast<int>(result.status));
+    ASSERT_EQUAL(1u, result.inputIndex);
+
+    // Verification stops after the last output (before halting)
+    ASSERT_TRUE(result.cyclesExecuted < 12);
+}
+
+TEST_CASE("Verifier", "Incorrect output") {
+    const VerificationResult result = VerifyProgram(sampleProgram, { { 3 }, { 1, 2, 1 } }, 100, 100);
+    ASSERT_EQUAL(static_cast<int>(VerificationStatus::IncorrectOutput), static_cast<int>(result.status));
+    ASSERT_EQUAL(1u, result.errorOutputIndex);
+    ASSERT_EQUAL(2, static_cast<int>(result.errorExpected));
+    ASSERT_EQUAL(1, static_cast<int>(result.errorActual));
+}
+
+TEST_CASE("Verifier", "Halted unexpectedly") {
+    const VerificationResult result = VerifyProgram(sampleProgram, { { 3 }, { 1, 1, 1, 1 } }, 100, 100);
+    ASSERT_EQUAL(static_cast<int>(VerificationStatus::HaltedUnexpectedly), static_cast<int>(result.status));
+    ASSERT_EQUAL(12u, result.cyclesExecuted);
+    ASSERT_EQUAL(22u, result.memoryBytesAccessed);
+}
+
+TEST_CASE("Verifier", "Resource limits") {
+    const TestSet testSet = { { 3 }, { 1, 1, 1 } };
+    ASSERT_EQUAL(static_cast<int>(VerificationStatus::ResourceLimitExceeded), static_cast<int>(VerifyProgram(sampleProgram, testSet, 3, 100).status));
+    ASSERT_EQUAL(static_cast<int>(VerificationStatus::ResourceLimitExceeded), static_cast<int>(VerifyProgram(sampleProgram, testSet, 100, 10).status));
+
+    // Exceeding a limit takes precedence over incorrect output
+    ASSERT_EQUAL(static_cast<int>(VerificationStatus::ResourceLimitExceeded), static_cast<int>(VerifyProgram(sampleProgram, { { 3 }, { 2, 1, 1 } }, 100, 17).status));
+}
+
+TEST_CASE("Verifier", "No expected output") {
+    const VerificationResult result = VerifyProgram(sampleProgram, { {}, {} }, 0, 0);
+    ASSERT_EQUAL(static_cast<int>(VerificationStatus::Success), static_cast<int>(result.status));
+    ASSERT_EQUAL(0u, result.cyclesExecuted);
+}
+
+TEST_CASE("Verifier", "Engines agree on random programs") {
+    std::mt19937 random(2468);
+    std::uniform_int_distribution<unsigned int> cycles(1, 2000);
+    std::uniform_int_distribution<unsigned int> bytes(10, Constants::memorySize);
+    std::uniform_int_distribution<unsigned int> counts(0, 12);
+    for (unsigned int i = 0; i < 2000; i++) {
+        const auto program = CreateRandomProgram(random);
+        const auto testSet = CreateRandomTestSet(random, counts(random), counts(random));
+        const uint64_t cyclesExecutedMax = cycles(random);
+        const unsigned int memoryBytesAccessedMax = bytes(random);
+        const auto expected = VerifyProgram<Emulator>(program, testSet, cyclesExecutedMax, memoryBytesAccessedMax, false);
+        AssertVerificationResultsEqual(expected, VerifyProgram<PredecodedEmulator>(program, testSet, cyclesExecutedMax, memoryBytesAccessedMax, false));
+        AssertVerificationResultsEqual(expected, VerifyProgram<TranslatedEmulator>(program, testSet, cyclesExecutedMax, memoryBytesAccessedMax, false));
+
+        // Loops may only be detected if the cycle limit would otherwise have been exceeded
+        AssertVerificationResultsAgree(expected, VerifyProgram<Emulator>(program, testSet, cyclesExecutedMax, memoryBytesAccessedMax));
+        AssertVerificationResultsAgree(expected, VerifyProgram<PredecodedEmulator>(program, testSet, cyclesExecutedMax, memoryBytesAccessedMax));
+        AssertVerificationResultsAgree(expected, VerifyProgram<TranslatedEmulator>(program, testSet, cyclesExecutedMax, memoryBytesAccessedMax));
+    }
+}
+
+TEST_CASE("Verifier", "Engine-independent loop detection results") {
+    // Engines check for loops at different points (e.g. per instruction or per block), so a NonTerminating result's
+    // cycle count (and input index) varies by engine; everything else must match
+    std::mt19937 random(1357);
+    std::uniform_int_distribution<unsigned int> counts(0, 12);
+    unsigned int nonTerminatingCount = 0;
+    unsigned int cyclesDifferCount = 0;
+    for (unsigned int i = 0; i < 2000; i++) {
+        const auto program = CreateRandomProgram(random);
+        const auto testSet = CreateRandomTestSet(random, counts(random), counts(random));
+        const auto reference = VerifyProgram<Emulator>(program, testSet, verificationCyclesExecutedMax, solutionBytesMax);
+        const auto predecoded = VerifyProgram<PredecodedEmulator>(program, testSet, verificationCyclesExecutedMax, solutionBytesMax);
+        const auto translated = VerifyProgram<TranslatedEmulator>(program, testSet, verificationCyclesExecutedMax, solutionBytesMax);
+        AssertVerificationResultsAgree(reference, predecoded);
+        AssertVerificationResultsAgree(reference, translated);
+
+        if (reference.status == VerificationStatus::NonTerminating) {
+            nonTerminatingCount++;
+            ASSERT_EQUAL(static_cast<int>(VerificationStatus::NonTerminating), static_cast<int>(translated.status));
+            if (reference.cyclesExecuted != translated.cyclesExecuted) {
+                cyclesDifferCount++;
+            }
+        }
+    }
+
+    ASSERT_TRUE(nonTerminatingCount > 100);
+    ASSERT_TRUE(cyclesDifferCount > 0);
+}
+
+TEST_CASE("Verifier", "Non-terminating programs") {
+    // subleq @t, @t, 0 (loops forever without changing anything after the first iteration)
+    const std::vector<uint8_t> loop = { 3, 3, 0, 1 };
+    const TestSet testSet = { {}, { 1 } };
+    VerificationResult result = VerifyProgram(loop, testSet, verificationCyclesExecutedMax, solutionBytesMax);
+    ASSERT_EQUAL(static_cast<int>(VerificationStatus::NonTerminating), static_cast<int>(result.status));
+    ASSERT_TRUE(result.cyclesExecuted < 10);
+
+    result = VerifyProgram(loop, testSet, verificationCyclesExecutedMax, solutionBytesMax, false);
+    ASSERT_EQUAL(static_cast<int>(VerificationStatus::ResourceLimitExceeded), static_cast<int>(result.status));
+    ASSERT_EQUAL(verificationCyclesExecutedMax + 1, result.cyclesExecuted);
+
+    // Reading input and decrementing a counter in a loop (the state only repeats once the input is exhausted and the
+    // counter wraps around): subleq @t, @IN; subleq @n, @one, 0; subleq @z, @z, 0
+    const std::vector<uint8_t> countdown = { 12, 253, 3, 13, 14, 0, 15, 15, 0, 0, 0, 0, 0, 127, 1, 0 };
+    for (bool detectLoops : { true, false }) {
+        result = VerifyProgram<Emulator>(countdown, { { 1, 2, 3 }, { 1 } }, verificationCyclesExecutedMax, solutionBytesMax, detectLoops);
+        ASSERT_EQUAL(static_cast<int>(detectLoops ? VerificationStatus::NonTerminating : VerificationStatus::ResourceLimitExceeded), static_cast<int>(result.status));
+        ASSERT_EQUAL(detectLoops, result.cyclesExecuted < verificationCyclesExecutedMax / 10);
+    }
+
+    // Outputting the same value forever (subleq @OUT, @one, 0) repeats everything but the output position, so it can
+    // still succeed
+    const std::vector<uint8_t> negativeOnes = { 254, 3, 0, 1 };
+    result = VerifyProgram(negativeOnes, { {}, { -1, -1, -1, -1, -1 } }, verificationCyclesExecutedMax, solutionBytesMax);
+    ASSERT_EQUAL(static_cast<int>(VerificationStatus::Success), static_cast<int>(result.status));
+}
+
+TEST_CASE("Verifier", "Wider machines") {
+    typedef SubleqMachine<uint16_t, 16> Machine16;
+    typedef BasicEmulator<Machine16> Engine16;
+    const std::vector<uint16_t> program = CreateAdditionProgram<Machine16>();
+
+    const BasicVerificationResult<int16_t> result = VerifyProgram<Engine16>(program, { { 1000, 2000, -30000, -2768 }, { 3000, -32768 } }, 100, 100);
+    ASSERT_EQUAL(static_cast<int>(VerificationStatus::Success), static_cast<int>(result.status));
+    ASSERT_EQUAL(7u, result.cyclesExecuted);
+    ASSERT_EQUAL(4u, result.inputIndex);
+
+    const BasicVerificationResult<int16_t> incorrect = VerifyProgram<Engine16>(program, { { 1000, 2000, 300, 400 }, { 3000, 7000 } }, 100, 100);
+    ASSERT_EQUAL(static_cast<int>(VerificationStatus::IncorrectOutput), static_cast<int>(incorrect.status));
+    ASSERT_EQUAL(7000, static_cast<int>(incorrect.errorExpected));
+    ASSERT_EQUAL(700, static_cast<int>(incorrect.errorActual));
+
+    // Loop detection works for large memories too: "subleq @t, @t, 0" never produces output
+    const std::vector<uint16_t> loop = { 3, 3, 0 };
+    const BasicVerificationResult<int16_t> looping = VerifyProgram<Engine16>(loop, { {}, { 1 } }, 100000, 100);
+    ASSERT_EQUAL(static_cast<int>(VerificationStatus::NonTerminating), static_cast<int>(looping.status));
+}
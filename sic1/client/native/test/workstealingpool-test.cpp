@@ -0,0 +1,74 @@
+#include "test.h"
+#include "../workstealingpool.h"
+
+#include <atomic>
+#include <stdexcept>
+
+using namespace Sic1;
+
+TEST_CASE("Work-stealing pool", "Runs all tasks") {
+    WorkStealingPool pool(4);
+    ASSERT_EQUAL(4u, pool.GetThreadCount());
+
+    std::atomic<uint64_t> sum(0);
+    for (unsigned int i = 1; i <= 10000; i++) {
+        pool.Submit([&sum, i]() { sum += i; });
+    }
+
+    pool.Wait();
+    ASSERT_EQUAL(50005000ull, static_cast<unsigned long long>(sum.load()));
+}
+
+TEST_CASE("Work-stealing pool", "Nested tasks") {
+    WorkStealingPool pool(4);
+    std::atomic<unsigned int> count(0);
+    for (unsigned int i = 0; i < 100; i++) {
+        pool.Submit([&pool, &count]() {
+            for (unsigned int j = 0; j < 100; j++) {
+                pool.Submit([&count]() { count++; });
+            }
+        });
+    }
+
+    pool.Wait();
+    ASSERT_EQUAL(10000u, count.load());
+
+    // The pool can be reused
+    pool.Submit([&count]() { count++; });
+    pool.Wait();
+    ASSERT_EQUAL(10001u, count.load());
+}
+
+TEST_CASE("Work-stealing pool", "Exceptions") {
+    WorkStealingPool pool(2);
+    std::atomic<unsigned int> count(0);
+    for (unsigned int i = 0; i < 10; i++) {
+        pool.Submit([&count, i]() {
+            count++;
+            if (i == 5) {
+                throw std::runtime_error("Task failed");
+            }
+        });
+    }
+
+    ASSERT_THROWS(pool.Wait(), std::runtime_error);
+    ASSERT_EQUAL(10u, count.load());
+
+    // The error is only reported once
+    pool.Wait();
+}
+
+TEST_CASE("Work-stealing pool", "Wait with timeout") {
+    WorkStealingPool pool(1);
+    std::atomic<bool> release(false);
+    pool.Submit([&release]() {
+        while (!release.load()) {
+            std::this_thread::yield();
+        }
+    });
+
+    ASSERT_FALSE(pool.WaitFor(std::chrono::milliseconds(10)));
+    release = true;
+    while (!pool.WaitFor(std::chrono::milliseconds(10))) {
+    }
+}
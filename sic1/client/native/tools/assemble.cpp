@@ -0,0 +1,75 @@
+// Tool for assembling SIC-1 Assembly Language source files (e.g. tools/samples/*.ois)
+//
+// Usage:
+//   assemble <file.ois> [<file.ois> ...]
+//
+// Each program's bytes are printed as decimal numbers (16 per line). Compilation errors are reported along with the
+// offending line, and the exit code is nonzero if any file failed to assemble.
+
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "assembler.h"
+
+using namespace Sic1;
+
+namespace {
+    std::string ReadText(const std::string& path) {
+        std::ifstream stream(path, std::ios::binary);
+        if (!stream) {
+            throw std::runtime_error("Failed to open file: " + path);
+        }
+
+        std::ostringstream text;
+        text << stream.rdbuf();
+        return text.str();
+    }
+
+    void PrintProgram(const char* path, const AssembledProgram& program) {
+        std::printf("%s: %zu bytes\n", path, program.bytes.size());
+        for (size_t i = 0; i < program.bytes.size(); i++) {
+            std::printf("%s%u", (i % 16 == 0) ? "  " : ", ", program.bytes[i]);
+            if (i % 16 == 15 || i + 1 == program.bytes.size()) {
+                std::printf("\n");
+            }
+        }
+    }
+
+    int Run(int argc, char** argv) {
+        if (argc < 2) {
+            std::fprintf(stderr, "Usage: assemble <file.ois> [<file.ois> ...]\n");
+            return 1;
+        }
+
+        int result = 0;
+        for (int i = 1; i < argc; i++) {
+            try {
+                PrintProgram(argv[i], Assembler::Assemble(ReadText(argv[i])));
+            }
+            catch (const CompilationError& error) {
+                const auto& context = error.GetContext();
+                if (context.sourceLineNumber) {
+                    std::fprintf(stderr, "%s(%u): %s: %s\n    %s\n", argv[i], *context.sourceLineNumber, GetCompilationErrorTypeName(error.GetErrorType()), error.what(), context.sourceLine->c_str());
+                }
+                else {
+                    std::fprintf(stderr, "%s: %s: %s\n", argv[i], GetCompilationErrorTypeName(error.GetErrorType()), error.what());
+                }
+                result = 1;
+            }
+        }
+        return result;
+    }
+}
+
+int main(int argc, char** argv) {
+    try {
+        return Run(argc, argv);
+    }
+    catch (const std::exception& error) {
+        std::fprintf(stderr, "Error: %s\n", error.what());
+        return 1;
+    }
+}
@@ -0,0 +1,682 @@
+// Benchmark suite for the native emulators, assembler, and verifier
+//
+// Usage: benchmark [--duration <seconds>] [--samples <count>] [--filter <text>] [--output <results.json>]
+//                  [--baseline <results.json>] [--threshold <percent>] [--sample-directory <path>]
+//
+// Each benchmark is run for the given duration (default: 0.5 seconds), split into a number of samples (default: 5), and
+// the median rate is reported (along with the slowest and fastest samples). Only benchmarks whose names contain the
+// filter text are run.
+//
+// Results are written as JSON (to standard output, or to the given file). With --baseline, each benchmark is also
+// compared against the result of the same name in a previous run's output, and the exit code is nonzero if any
+// benchmark's rate dropped by more than the threshold (default: 10 percent).
+//
+// The programs are a small corpus of puzzle solutions (embedded below), each of which is checked against its puzzle's
+// test sets before anything is measured. Wider SUBLEQ machines (16-bit and 32-bit words) are measured with an
+// equivalent of the Addition solution.
+//
+// The sample programs in tools/samples are also measured (read from the repository at run time, or from the given
+// directory), after checking that they produce their expected output.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "assembler.h"
+#include "embeddedassembler.h"
+#include "json.h"
+#include "puzzles.h"
+#include "subleqprograms.h"
+#include "translated.h"
+#include "verifier.h"
+
+using namespace Sic1;
+
+namespace {
+    typedef struct {
+        const char* puzzleTitle;
+        std::string_view source;
+        std::vector<uint8_t> bytes;
+    } CorpusEntry;
+
+    // Straightforward (i.e. not especially optimized) solutions, so that the programs spend their time in a mix of
+    // arithmetic, branching, and I/O
+    constexpr std::string_view firstAssessmentSource =
+        "@loop:\n"
+        "subleq @t, @IN\n"
+        "subleq @OUT, @t\n"
+        "subleq @t, @t, @loop\n"
+        "\n"
+        "@t: .data 0\n";
+
+    constexpr std::string_view additionSource =
+        "@loop:\n"
+        "subleq @t, @IN\n"
+        "subleq @t, @IN\n"
+        "subleq @OUT, @t\n"
+        "subleq @t, @t, @loop\n"
+        "\n"
+        "@t: .data 0\n";
+
+    constexpr std::string_view subtractionSource =
+        "@loop:\n"
+        "subleq @t, @IN\n"
+        "subleq @u, @IN\n"
+        "subleq @t, @u\n"
+        "subleq @OUT, @t\n"
+        "subleq @u, @u\n"
+        "subleq @t, @t, @loop\n"
+        "\n"
+        "@t: .data 0\n"
+        "@u: .data 0\n";
+
+    constexpr std::string_view signFunctionSource =
+        "@loop:\n"
+        "subleq @t, @IN, @nonnegative\n"
+        "subleq @OUT, @one\n"
+        "subleq @t, @t, @loop\n"
+        "\n"
+        "@nonnegative:\n"
+        "subleq @u, @t, @zero\n"
+        "subleq @OUT, @n_one\n"
+        "subleq @u, @u\n"
+        "subleq @t, @t, @loop\n"
+        "\n"
+        "@zero:\n"
+        "subleq @OUT, @z\n"
+        "subleq @t, @t, @loop\n"
+        "\n"
+        "@one: .data 1\n"
+        "@n_one: .data -1\n"
+        "@z: .data 0\n"
+        "@t: .data 0\n"
+        "@u: .data 0\n";
+
+    constexpr std::string_view multiplicationSource =
+        "@loop:\n"
+        "subleq @na, @IN\n"
+        "subleq @nb, @IN\n"
+        "subleq @a, @na\n"
+        "subleq @c, @nb, @done\n"
+        "\n"
+        "@add:\n"
+        "subleq @nr, @a\n"
+        "subleq @c, @one, @done\n"
+        "subleq @z, @z, @add\n"
+        "\n"
+        "@done:\n"
+        "subleq @OUT, @nr\n"
+        "subleq @na, @na\n"
+        "subleq @nb, @nb\n"
+        "subleq @a, @a\n"
+        "subleq @nr, @nr\n"
+        "subleq @c, @c, @loop\n"
+        "\n"
+        "@one: .data 1\n"
+        "@z: .data 0\n"
+        "@na: .data 0\n"
+        "@nb: .data 0\n"
+        "@a: .data 0\n"
+        "@c: .data 0\n"
+        "@nr: .data 0\n";
+
+    constexpr std::string_view sequenceSumSource =
+        "@loop:\n"
+        "subleq @nx, @IN\n"
+        "subleq @x, @nx, @end\n"
+        "subleq @ns, @x\n"
+        "subleq @nx, @nx\n"
+        "subleq @x, @x, @loop\n"
+        "\n"
+        "@end:\n"
+        "subleq @OUT, @ns\n"
+        "subleq @ns, @ns, @loop\n"
+        "\n"
+        "@nx: .data 0\n"
+        "@x: .data 0\n"
+        "@ns: .data 0\n";
+
+    constexpr std::string_view sequenceCardinalitySource =
+        "@loop:\n"
+        "subleq @nx, @IN\n"
+        "subleq @x, @nx, @end\n"
+        "subleq @nc, @one\n"
+        "subleq @nx, @nx\n"
+        "subleq @x, @x, @loop\n"
+        "\n"
+        "@end:\n"
+        "subleq @OUT, @nc\n"
+        "subleq @nc, @nc, @loop\n"
+        "\n"
+        "@one: .data 1\n"
+        "@nx: .data 0\n"
+        "@x: .data 0\n"
+        "@nc: .data 0\n";
+
+    constexpr std::string_view numberToSequenceSource =
+        "@loop:\n"
+        "subleq @nx, @IN\n"
+        "subleq @c, @nx, @end\n"
+        "\n"
+        "@print:\n"
+        "subleq @OUT, @n_one\n"
+        "subleq @c, @one, @end\n"
+        "subleq @z, @z, @print\n"
+        "\n"
+        "@end:\n"
+        "subleq @OUT, @z\n"
+        "subleq @nx, @nx\n"
+        "subleq @c, @c, @loop\n"
+        "\n"
+        "@one: .data 1\n"
+        "@n_one: .data -1\n"
+        "@z: .data 0\n"
+        "@nx: .data 0\n"
+        "@c: .data 0\n";
+
+    // Assembled at compile time (so a typo in the corpus is a build break)
+    constexpr auto firstAssessment = EmbeddedAssembler::Assemble(firstAssessmentSource);
+    constexpr auto addition = EmbeddedAssembler::Assemble(additionSource);
+    constexpr auto subtraction = EmbeddedAssembler::Assemble(subtractionSource);
+    constexpr auto signFunction = EmbeddedAssembler::Assemble(signFunctionSource);
+    constexpr auto multiplication = EmbeddedAssembler::Assemble(multiplicationSource);
+    constexpr auto sequenceSum = EmbeddedAssembler::Assemble(sequenceSumSource);
+    constexpr auto sequenceCardinality = EmbeddedAssembler::Assemble(sequenceCardinalitySource);
+    constexpr auto numberToSequence = EmbeddedAssembler::Assemble(numberToSequenceSource);
+
+    const std::vector<CorpusEntry>& GetCorpus() {
+        static const std::vector<CorpusEntry> corpus = {
+            { "First Assessment", firstAssessmentSource, firstAssessment.GetBytes() },
+            { "Addition", additionSource, addition.GetBytes() },
+            { "Subtraction", subtractionSource, subtraction.GetBytes() },
+            { "Sign Function", signFunctionSource, signFunction.GetBytes() },
+            { "Multiplication", multiplicationSource, multiplication.GetBytes() },
+            { "Sequence Sum", sequenceSumSource, sequenceSum.GetBytes() },
+            { "Sequence Cardinality", sequenceCardinalitySource, sequenceCardinality.GetBytes() },
+            { "Number to Sequence", numberToSequenceSource, numberToSequence.GetBytes() },
+        };
+        return corpus;
+    }
+
+    // Sample programs (from tools/samples), with an input and the output it should produce
+    typedef struct {
+        const char* fileName;
+        std::vector<int8_t> input;
+        std::vector<int8_t> expectedOutput;
+    } SampleDefinition;
+
+    typedef struct {
+        const char* fileName;
+        std::vector<int8_t> input;
+        std::string source;
+        std::vector<uint8_t> bytes;
+    } SampleEntry;
+
+    const std::vector<SampleDefinition>& GetSampleDefinitions() {
+        static const std::vector<SampleDefinition> definitions = {
+            // Prints the input number of 1s
+            { "sample.ois", { 100 }, std::vector<int8_t>(100, 1) },
+
+            // Values at (and past) the edges of the signed range (the input is unused)
+            { "bounds.ois", { 0 }, { -128, -127, -128, 127 } },
+        };
+        return definitions;
+    }
+
+    std::string ReadText(const std::string& path) {
+        std::ifstream stream(path, std::ios::binary);
+        if (!stream) {
+            throw std::runtime_error("Failed to open file: " + path);
+        }
+
+        std::ostringstream text;
+        text << stream.rdbuf();
+        return text.str();
+    }
+
+    // Reads and assembles the sample programs, checking that each one is correct
+    std::vector<SampleEntry> LoadSamples(const std::string& directory) {
+        std::vector<SampleEntry> samples;
+        for (const SampleDefinition& definition : GetSampleDefinitions()) {
+            SampleEntry& sample = samples.emplace_back();
+            sample.fileName = definition.fileName;
+            sample.input = definition.input;
+            sample.source = ReadText(directory + "/" + definition.fileName);
+            sample.bytes = Assembler::Assemble(sample.source).bytes;
+
+            TestSet testSet;
+            testSet.input = definition.input;
+            testSet.output = definition.expectedOutput;
+            if (VerifyProgram<Emulator>(sample.bytes.data(), sample.bytes.size(), testSet, verificationCyclesExecutedMax, solutionBytesMax).status != VerificationStatus::Success) {
+                throw std::runtime_error(std::string("Sample program is incorrect: ") + definition.fileName);
+            }
+        }
+        return samples;
+    }
+
+    const Puzzle& GetPuzzle(const char* title) {
+        const Puzzle* puzzle = FindPuzzle(title);
+        if (!puzzle) {
+            throw std::runtime_error(std::string("Unknown puzzle: ") + title);
+        }
+        return *puzzle;
+    }
+
+    // A submitted solution's statistics (i.e. its results on the standard test set)
+    typedef struct {
+        uint64_t cycles;
+        unsigned int bytes;
+    } SolutionStats;
+
+    // Equivalent to verifySolution: the standard test set must match the submitted statistics exactly, and the other
+    // test sets must complete within the usual limits. Returns false if the solution is incorrect.
+    //
+    // One engine is reset between test sets (rather than constructing a new one for each), so engines that keep work
+    // across resets (e.g. TranslatedEmulator) can reuse it.
+    template<typename TEngine>
+    bool VerifySolution(const Puzzle& puzzle, const std::vector<uint8_t>& bytes, const SolutionStats& stats, uint64_t seed) {
+        const std::vector<TestSet> testSets = GeneratePuzzleTest(puzzle, seed);
+        TEngine emulator(bytes);
+        for (size_t i = 0; i < testSets.size(); i++) {
+            const bool standard = (i == 0);
+            if (!standard) {
+                emulator.Reset();
+            }
+
+            const VerificationResult result = VerifyLoadedProgram(emulator, testSets[i], standard ? stats.cycles : verificationCyclesExecutedMax, standard ? stats.bytes : solutionBytesMax);
+            if (result.status != VerificationStatus::Success
+                || (standard && (result.cyclesExecuted != stats.cycles || result.memoryBytesAccessed != stats.bytes))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Checks that each solution in the corpus is correct (otherwise the benchmarks would measure failures), and returns
+    // each solution's statistics
+    std::vector<SolutionStats> CheckCorpus() {
+        std::vector<SolutionStats> corpusStats;
+        for (const CorpusEntry& entry : GetCorpus()) {
+            const Puzzle& puzzle = GetPuzzle(entry.puzzleTitle);
+            const VerificationResult result = VerifyProgram<Emulator>(entry.bytes.data(), entry.bytes.size(), GetFixedTestSets(puzzle)[0], verificationCyclesExecutedMax, solutionBytesMax);
+            const SolutionStats stats = { result.cyclesExecuted, result.memoryBytesAccessed };
+            for (uint64_t seed = 0; seed < 100; seed++) {
+                if (result.status != VerificationStatus::Success || !VerifySolution<Emulator>(puzzle, entry.bytes, stats, seed)) {
+                    throw std::runtime_error(std::string("Benchmark solution is incorrect: ") + entry.puzzleTitle);
+                }
+            }
+            corpusStats.push_back(stats);
+        }
+        return corpusStats;
+    }
+
+    // Supplies the same input over and over (and ignores output), so that solutions run indefinitely
+    template<typename TValue>
+    class CyclicIo {
+    public:
+        explicit CyclicIo(const std::vector<TValue>& input)
+            : m_input(input),
+            m_index(0) {
+        }
+
+        template<typename TWord>
+        bool TryReadInput(TWord& value) {
+            value = static_cast<TWord>(m_input[m_index]);
+            m_index = (m_index + 1) % m_input.size();
+            return true;
+        }
+
+        void WriteOutput(TValue) {
+        }
+
+    private:
+        const std::vector<TValue>& m_input;
+        size_t m_index;
+    };
+
+    typedef SubleqMachine<uint16_t, 16> Machine16;
+    typedef SubleqMachine<uint32_t, 16> Machine32;
+
+    // Random pairs of inputs spanning the machine's whole value range, with their (wrapped around) sums
+    template<typename TMachine>
+    BasicTestSet<typename TMachine::SignedWord> CreateAdditionTestSet(uint64_t seed) {
+        typedef typename TMachine::Word Word;
+        typedef typename TMachine::SignedWord SignedWord;
+        std::mt19937_64 random(seed);
+        BasicTestSet<SignedWord> testSet;
+        for (unsigned int i = 0; i < 50; i++) {
+            const Word a = static_cast<Word>(random());
+            const Word b = static_cast<Word>(random());
+            testSet.input.push_back(static_cast<SignedWord>(a));
+            testSet.input.push_back(static_cast<SignedWord>(b));
+            testSet.output.push_back(static_cast<SignedWord>(static_cast<Word>(a + b)));
+        }
+        return testSet;
+    }
+
+    template<typename TMachine>
+    bool VerifyAddition(uint64_t seed) {
+        const BasicTestSet<typename TMachine::SignedWord> testSet = CreateAdditionTestSet<TMachine>(seed);
+        return VerifyProgram<BasicEmulator<TMachine>>(CreateAdditionProgram<TMachine>(), testSet, verificationCyclesExecutedMax, solutionBytesMax).status == VerificationStatus::Success;
+    }
+
+    typedef struct {
+        std::string name;
+        const char* unit;
+        double median;
+        double min;
+        double max;
+    } BenchmarkResult;
+
+    typedef struct {
+        double duration;
+        unsigned int samples;
+        std::string filter;
+        std::string sampleDirectory;
+    } BenchmarkOptions;
+
+    // Prevents measured work from being optimized away
+    volatile uint64_t sink = 0;
+
+    // Repeatedly runs the body (which returns the number of units of work it did) and records the rate for each sample
+    void Measure(const BenchmarkOptions& options, std::vector<BenchmarkResult>& results, const std::string& name, const char* unit, const std::function<uint64_t()>& body) {
+        if (name.find(options.filter) == std::string::npos) {
+            return;
+        }
+
+        // Warm up (caches, branch predictors, and lazily initialized data)
+        sink = sink + body();
+
+        typedef std::chrono::steady_clock Clock;
+        const auto sampleDuration = std::chrono::duration<double>(options.duration / options.samples);
+        std::vector<double> rates;
+        for (unsigned int sample = 0; sample < options.samples; sample++) {
+            uint64_t work = 0;
+            const Clock::time_point start = Clock::now();
+            Clock::time_point end;
+            do {
+                work += body();
+                end = Clock::now();
+            } while (end - start < sampleDuration);
+
+            rates.push_back(work / std::chrono::duration<double>(end - start).count());
+        }
+
+        std::sort(rates.begin(), rates.end());
+        const BenchmarkResult result = { name, unit, rates[rates.size() / 2], rates.front(), rates.back() };
+        std::fprintf(stderr, "%-48s %14.0f %s\n", name.c_str(), result.median, unit);
+        results.push_back(result);
+    }
+
+    // Steps per second for a program that runs continuously on its standard test set's input
+    template<typename TEngine>
+    uint64_t RunEmulator(const std::vector<typename TEngine::Word>& bytes, const std::vector<typename TEngine::SignedWord>& input) {
+        constexpr uint64_t cyclesPerCall = 1000000;
+        TEngine emulator(bytes);
+        CyclicIo<typename TEngine::SignedWord> io(input);
+        emulator.Run(io, cyclesPerCall);
+        sink = sink + emulator.GetMemory()[0];
+        return emulator.GetCyclesExecuted();
+    }
+
+    // Full verifications per second (including test set generation) of a corpus solution, using the given engine
+    template<typename TEngine>
+    void MeasureVerifier(const BenchmarkOptions& options, std::vector<BenchmarkResult>& results, const char* engineName, const CorpusEntry& entry, const SolutionStats& stats) {
+        const Puzzle& puzzle = GetPuzzle(entry.puzzleTitle);
+        uint64_t seed = 0;
+        Measure(options, results, std::string("verifier/") + engineName + "/" + entry.puzzleTitle, "validations/s", [&]() {
+            if (!VerifySolution<TEngine>(puzzle, entry.bytes, stats, seed++)) {
+                throw std::runtime_error(std::string("Benchmark solution is incorrect: ") + entry.puzzleTitle);
+            }
+            return uint64_t(1);
+        });
+    }
+
+    std::vector<BenchmarkResult> RunBenchmarks(const BenchmarkOptions& options) {
+        const std::vector<CorpusEntry>& corpus = GetCorpus();
+        const std::vector<SolutionStats> corpusStats = CheckCorpus();
+        const std::vector<SampleEntry> samples = LoadSamples(options.sampleDirectory);
+        std::vector<BenchmarkResult> results;
+
+        // Emulators
+        for (const CorpusEntry& entry : corpus) {
+            const std::vector<int8_t> input = GetFixedTestSets(GetPuzzle(entry.puzzleTitle))[0].input;
+            const std::string suffix = std::string("/") + entry.puzzleTitle;
+            Measure(options, results, "emulator/reference" + suffix, "steps/s", [&]() { return RunEmulator<Emulator>(entry.bytes, input); });
+            Measure(options, results, "emulator/predecoded" + suffix, "steps/s", [&]() { return RunEmulator<PredecodedEmulator>(entry.bytes, input); });
+            Measure(options, results, "emulator/translated" + suffix, "steps/s", [&]() { return RunEmulator<TranslatedEmulator>(entry.bytes, input); });
+        }
+
+        // Sample programs (which halt, so each run includes loading the program)
+        for (const SampleEntry& sample : samples) {
+            const std::string suffix = std::string("/") + sample.fileName;
+            Measure(options, results, "emulator/reference" + suffix, "steps/s", [&]() { return RunEmulator<Emulator>(sample.bytes, sample.input); });
+            Measure(options, results, "emulator/predecoded" + suffix, "steps/s", [&]() { return RunEmulator<PredecodedEmulator>(sample.bytes, sample.input); });
+            Measure(options, results, "emulator/translated" + suffix, "steps/s", [&]() { return RunEmulator<TranslatedEmulator>(sample.bytes, sample.input); });
+        }
+
+        // Wider machines
+        const std::vector<uint16_t> addition16 = CreateAdditionProgram<Machine16>();
+        const std::vector<int16_t> input16 = CreateAdditionTestSet<Machine16>(0).input;
+        const std::vector<uint32_t> addition32 = CreateAdditionProgram<Machine32>();
+        const std::vector<int32_t> input32 = CreateAdditionTestSet<Machine32>(0).input;
+        Measure(options, results, "emulator/word16/Addition", "steps/s", [&]() { return RunEmulator<BasicEmulator<Machine16>>(addition16, input16); });
+        Measure(options, results, "emulator/word32/Addition", "steps/s", [&]() { return RunEmulator<BasicEmulator<Machine32>>(addition32, input32); });
+
+        // Assembler
+        std::vector<std::string> sources;
+        uint64_t lineCount = 0;
+        for (const CorpusEntry& entry : corpus) {
+            sources.emplace_back(entry.source);
+            lineCount += std::count(entry.source.begin(), entry.source.end(), '\n');
+        }
+
+        Measure(options, results, "assembler/corpus", "lines/s", [&]() {
+            for (const std::string& source : sources) {
+                sink = sink + Assembler::Assemble(source).bytes.size();
+            }
+            return lineCount;
+        });
+
+        // Note: The sample files don't necessarily end with a newline, so count their last lines too
+        uint64_t sampleLineCount = 0;
+        for (const SampleEntry& sample : samples) {
+            sampleLineCount += std::count(sample.source.begin(), sample.source.end(), '\n') + 1;
+        }
+
+        Measure(options, results, "assembler/samples", "lines/s", [&]() {
+            for (const SampleEntry& sample : samples) {
+                sink = sink + Assembler::Assemble(sample.source).bytes.size();
+            }
+            return sampleLineCount;
+        });
+
+        // Test set generation (for every puzzle, since each has its own generator)
+        uint64_t generateSeed = 0;
+        Measure(options, results, "puzzles/generate", "tests/s", [&]() {
+            const std::vector<Puzzle>& puzzles = GetPuzzles();
+            for (const Puzzle& puzzle : puzzles) {
+                sink = sink + GeneratePuzzleTest(puzzle, generateSeed++).size();
+            }
+            return static_cast<uint64_t>(puzzles.size());
+        });
+
+        // Full verification (including test set generation), with each engine named explicitly so that results stay
+        // comparable even if VerifyProgram's default engine changes
+        for (size_t i = 0; i < corpus.size(); i++) {
+            MeasureVerifier<Emulator>(options, results, "reference", corpus[i], corpusStats[i]);
+            MeasureVerifier<PredecodedEmulator>(options, results, "predecoded", corpus[i], corpusStats[i]);
+            MeasureVerifier<TranslatedEmulator>(options, results, "translated", corpus[i], corpusStats[i]);
+        }
+
+        uint64_t verifySeed16 = 0;
+        Measure(options, results, "verifier/reference/word16/Addition", "validations/s", [&]() {
+            if (!VerifyAddition<Machine16>(verifySeed16++)) {
+                throw std::runtime_error("Benchmark solution is incorrect: 16-bit Addition");
+            }
+            return uint64_t(1);
+        });
+
+        uint64_t verifySeed32 = 0;
+        Measure(options, results, "verifier/reference/word32/Addition", "validations/s", [&]() {
+            if (!VerifyAddition<Machine32>(verifySeed32++)) {
+                throw std::runtime_error("Benchmark solution is incorrect: 32-bit Addition");
+            }
+            return uint64_t(1);
+        });
+
+        return results;
+    }
+
+    // Reads the median rate of each benchmark in a previous run's output
+    std::map<std::string, double> ReadBaseline(const std::string& path) {
+        const JsonValue root = JsonValue::Parse(ReadText(path));
+        const JsonValue* benchmarks = root.FindProperty("benchmarks");
+        if (!benchmarks) {
+            throw std::runtime_error("Baseline has no benchmarks: " + path);
+        }
+
+        std::map<std::string, double> baseline;
+        for (const JsonValue& benchmark : benchmarks->GetArray()) {
+            const JsonValue* name = benchmark.FindProperty("name");
+            const JsonValue* median = benchmark.FindProperty("median");
+            if (name && median) {
+                baseline[name->GetString()] = median->GetNumber();
+            }
+        }
+        return baseline;
+    }
+
+    std::string FormatNumber(double value) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.6g", value);
+        return buffer;
+    }
+
+    std::string FormatResults(const BenchmarkOptions& options, const std::vector<BenchmarkResult>& results, const std::map<std::string, double>* baseline) {
+        std::string json = "{\n  \"duration\": " + FormatNumber(options.duration) + ",\n  \"samples\": " + std::to_string(options.samples) + ",\n  \"benchmarks\": [";
+        for (size_t i = 0; i < results.size(); i++) {
+            const BenchmarkResult& result = results[i];
+            json += (i > 0) ? ",\n    {" : "\n    {";
+            json += " \"name\": " + FormatJsonString(result.name);
+            json += ", \"unit\": " + FormatJsonString(result.unit);
+            json += ", \"median\": " + FormatNumber(result.median);
+            json += ", \"min\": " + FormatNumber(result.min);
+            json += ", \"max\": " + FormatNumber(result.max);
+            if (baseline) {
+                const auto it = baseline->find(result.name);
+                if (it != baseline->end() && it->second > 0) {
+                    json += ", \"baseline\": " + FormatNumber(it->second);
+                    json += ", \"change\": " + FormatNumber((result.median / it->second - 1) * 100);
+                }
+            }
+            json += " }";
+        }
+        json += "\n  ]\n}\n";
+        return json;
+    }
+
+    // Prints each benchmark's change relative to the baseline; returns the number of regressions
+    unsigned int CompareResults(const std::vector<BenchmarkResult>& results, const std::map<std::string, double>& baseline, double threshold) {
+        unsigned int regressions = 0;
+        std::fprintf(stderr, "\nComparison with baseline (threshold: %g%%):\n", threshold);
+        for (const BenchmarkResult& result : results) {
+            const auto it = baseline.find(result.name);
+            if (it == baseline.end() || it->second <= 0) {
+                std::fprintf(stderr, "%-48s %14s\n", result.name.c_str(), "(new)");
+                continue;
+            }
+
+            const double change = (result.median / it->second - 1) * 100;
+            const bool regressed = (change < -threshold);
+            std::fprintf(stderr, "%-48s %+13.1f%%%s\n", result.name.c_str(), change, regressed ? "  REGRESSION" : "");
+            if (regressed) {
+                regressions++;
+            }
+        }
+
+        if (regressions > 0) {
+            std::fprintf(stderr, "\n%u benchmark(s) regressed by more than %g%%\n", regressions, threshold);
+        }
+        return regressions;
+    }
+
+    int Run(int argc, char** argv) {
+        BenchmarkOptions options = { 0.5, 5, "", SIC1_SAMPLE_DIRECTORY };
+        std::optional<std::string> outputPath;
+        std::optional<std::string> baselinePath;
+        double threshold = 10;
+        for (int i = 1; i < argc; i++) {
+            const std::string argument = argv[i];
+            if (argument == "--duration" && (i + 1) < argc) {
+                options.duration = std::stod(argv[++i]);
+            }
+            else if (argument == "--samples" && (i + 1) < argc) {
+                options.samples = static_cast<unsigned int>(std::stoul(argv[++i]));
+            }
+            else if (argument == "--filter" && (i + 1) < argc) {
+                options.filter = argv[++i];
+            }
+            else if (argument == "--output" && (i + 1) < argc) {
+                outputPath = argv[++i];
+            }
+            else if (argument == "--baseline" && (i + 1) < argc) {
+                baselinePath = argv[++i];
+            }
+            else if (argument == "--threshold" && (i + 1) < argc) {
+                threshold = std::stod(argv[++i]);
+            }
+            else if (argument == "--sample-directory" && (i + 1) < argc) {
+                options.sampleDirectory = argv[++i];
+            }
+            else {
+                std::fprintf(stderr, "Usage: benchmark [--duration <seconds>] [--samples <count>] [--filter <text>] [--output <results.json>] [--baseline <results.json>] [--threshold <percent>] [--sample-directory <path>]\n");
+                return 1;
+            }
+        }
+
+        if (!(options.duration > 0) || options.samples == 0) {
+            throw std::runtime_error("Duration and sample count must be positive");
+        }
+
+        // Read the baseline first, so that a bad path is reported before spending time on benchmarks
+        std::optional<std::map<std::string, double>> baseline;
+        if (baselinePath) {
+            baseline = ReadBaseline(*baselinePath);
+        }
+
+        const std::vector<BenchmarkResult> results = RunBenchmarks(options);
+        const std::string json = FormatResults(options, results, baseline ? &*baseline : nullptr);
+        if (outputPath) {
+            std::ofstream stream(*outputPath, std::ios::binary);
+            if (!stream || !(stream << json)) {
+                throw std::runtime_error("Failed to write file: " + *outputPath);
+            }
+        }
+        else {
+            std::fputs(json.c_str(), stdout);
+        }
+
+        return (baseline && CompareResults(results, *baseline, threshold) > 0) ? 1 : 0;
+    }
+}
+
+int main(int argc, char** argv) {
+    try {
+        return Run(argc, argv);
+    }
+    catch (const std::exception& error) {
+        std::fprintf(stderr, "Error: %s\n", error.what());
+        return 1;
+    }
+}
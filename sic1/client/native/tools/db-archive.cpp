@@ -0,0 +1,83 @@
+// Tool for converting between the solution database (db.json) and the binary solution archive
+//
+// Usage:
+//   db-archive pack <db.json> <archive>             Converts a database into an archive
+//   db-archive unpack <archive> <db.json>           Converts an archive back into a database
+//   db-archive import-web <archive.json> <archive>  Converts the web leaderboard's archive (see
+//                                                   server/utils/archive-to-solutions.ts) into an archive
+//   db-archive info <archive>                       Lists the number of solutions for each puzzle
+//
+// Note: Any tool that accepts --db (e.g. db-verify) also accepts an archive.
+
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "solutionarchive.h"
+
+using namespace Sic1;
+
+namespace {
+    std::string ReadText(const std::string& path) {
+        std::ifstream stream(path, std::ios::binary);
+        if (!stream) {
+            throw std::runtime_error("Failed to open file: " + path);
+        }
+
+        std::ostringstream text;
+        text << stream.rdbuf();
+        return text.str();
+    }
+
+    int PrintUsage() {
+        std::fprintf(stderr, "Usage: db-archive pack <db.json> <archive>\n");
+        std::fprintf(stderr, "       db-archive unpack <archive> <db.json>\n");
+        std::fprintf(stderr, "       db-archive import-web <archive.json> <archive>\n");
+        std::fprintf(stderr, "       db-archive info <archive>\n");
+        return 1;
+    }
+
+    int Run(int argc, char** argv) {
+        const std::string command = (argc > 1) ? argv[1] : "";
+        if (command == "pack" && argc == 4) {
+            const auto solutions = ParseSolutionDatabase(ReadText(argv[2]));
+            WriteSolutionArchive(argv[3], solutions);
+            std::fprintf(stderr, "Wrote %zu solutions to %s\n", solutions.size(), argv[3]);
+        }
+        else if (command == "unpack" && argc == 4) {
+            const auto solutions = SolutionArchive(argv[2]).ReadSolutions();
+            WriteSolutionDatabase(argv[3], solutions);
+            std::fprintf(stderr, "Wrote %zu solutions to %s\n", solutions.size(), argv[3]);
+        }
+        else if (command == "import-web" && argc == 4) {
+            const auto solutions = ParseWebArchive(ReadText(argv[2]));
+            WriteSolutionArchive(argv[3], solutions);
+            std::fprintf(stderr, "Wrote %zu solutions to %s\n", solutions.size(), argv[3]);
+        }
+        else if (command == "info" && argc == 3) {
+            const SolutionArchive archive(argv[2]);
+            for (size_t i = 0; i < archive.GetPuzzleCount(); i++) {
+                const std::string title(archive.GetPuzzleTitle(i));
+                std::printf("%s: %zu\n", title.c_str(), archive.GetPuzzleSolutionCount(i));
+            }
+            std::printf("Total: %zu\n", archive.GetSolutionCount());
+        }
+        else {
+            return PrintUsage();
+        }
+        return 0;
+    }
+}
+
+int main(int argc, char** argv) {
+    try {
+        return Run(argc, argv);
+    }
+    catch (const std::exception& error) {
+        std::fprintf(stderr, "Error: %s\n", error.what());
+        return 1;
+    }
+}
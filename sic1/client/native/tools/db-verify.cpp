@@ -0,0 +1,318 @@
+// Tool for verifying solutions and writing out statistics and failing users (native, multi-threaded version of
+// tools/cli/db-verify.ts, with identical output)
+//
+// Usage: db-verify [--db <path>] [--threads <count>] [--seed <seed>] [--cache <path>] [puzzle title]
+//
+// The database can be either db.json or a binary solution archive (see tools/db-archive.cpp).
+//
+// Random test sets are generated from the seed (which is chosen randomly, if not specified, and then logged), so a
+// run can be reproduced by passing in the same seed.
+//
+// Solutions are streamed from the database into a bounded queue as they're verified, so memory use doesn't grow with the
+// size of the database. Solutions are counted first (for progress and ETA), which is free for archives and takes one
+// extra pass over db.json.
+//
+// With --cache, verdicts are saved to (and reused from) the given file, so subsequent runs only verify solutions that
+// weren't seen before. If no seed is specified, the cache's seed is reused.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <map>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "batchverifier.h"
+#include "puzzles.h"
+#include "solutionarchive.h"
+
+using namespace Sic1;
+
+namespace {
+    typedef struct {
+        unsigned int count;
+        std::optional<uint64_t> cycles;
+        std::optional<unsigned int> bytes;
+    } FailureData;
+
+    typedef struct {
+        uint64_t valid;
+        uint64_t invalid;
+        uint64_t cyclesMin;
+        uint64_t cyclesMax;
+        unsigned int bytesMin;
+        unsigned int bytesMax;
+        std::map<std::string, FailureData> userIdToFailures;
+    } PuzzleData;
+
+    // Approximates String.prototype.localeCompare (i.e. the root collation order) for ASCII: whitespace and
+    // punctuation come first, then digits, then letters (ignoring case, except as a tiebreaker, with lowercase first)
+    int GetCollationWeight(unsigned char c) {
+        static const char order[] = "\t\n\r _-,;:!?.'\"()[]{}@*/\\&#%`^+<=>|~$0123456789abcdefghijklmnopqrstuvwxyz";
+        if (c >= 'A' && c <= 'Z') {
+            c = static_cast<unsigned char>(c - 'A' + 'a');
+        }
+
+        const char* position = (c != 0) ? std::strchr(order, c) : nullptr;
+        return position ? static_cast<int>(position - order) : (static_cast<int>(sizeof(order)) + c);
+    }
+
+    bool LocaleLess(const std::string& a, const std::string& b) {
+        const size_t length = (std::min)(a.size(), b.size());
+        for (size_t i = 0; i < length; i++) {
+            const int weightA = GetCollationWeight(static_cast<unsigned char>(a[i]));
+            const int weightB = GetCollationWeight(static_cast<unsigned char>(b[i]));
+            if (weightA != weightB) {
+                return weightA < weightB;
+            }
+        }
+
+        if (a.size() != b.size()) {
+            return a.size() < b.size();
+        }
+
+        for (size_t i = 0; i < length; i++) {
+            if (a[i] != b[i]) {
+                // Note: Only case differs at this point
+                return a[i] > b[i];
+            }
+        }
+        return false;
+    }
+
+    // Formats Math.ceil(numerator / denominator * 100) the way JavaScript would
+    std::string FormatPercentage(double value) {
+        return std::isnan(value) ? std::string("NaN") : std::to_string(static_cast<long long>(std::ceil(value)));
+    }
+
+    template<typename T>
+    std::string FormatOptional(const std::optional<T>& value) {
+        return value ? std::to_string(*value) : std::string("undefined");
+    }
+
+    std::string FormatDuration(double seconds) {
+        const long long total = static_cast<long long>(seconds);
+        char buffer[64];
+        std::snprintf(buffer, sizeof(buffer), "%lld:%02lld:%02lld", total / 3600, (total / 60) % 60, total % 60);
+        return buffer;
+    }
+
+    // Counts the solutions (optionally, only those for one puzzle) without keeping them around
+    uint64_t CountSolutions(const std::string& path, const std::string& puzzleTitle) {
+        if (SolutionArchive::IsArchive(path)) {
+            const SolutionArchive archive(path);
+            if (puzzleTitle.empty()) {
+                return archive.GetSolutionCount();
+            }
+
+            const size_t puzzleIndex = archive.FindPuzzle(puzzleTitle);
+            return (puzzleIndex < archive.GetPuzzleCount()) ? archive.GetPuzzleSolutionCount(puzzleIndex) : 0;
+        }
+
+        uint64_t count = 0;
+        StreamSolutionDatabase(path, [&](Solution&& solution) {
+            if (puzzleTitle.empty() || solution.puzzleTitle == puzzleTitle) {
+                count++;
+            }
+            return true;
+        });
+        return count;
+    }
+
+    int Run(int argc, char** argv) {
+        std::string databasePath = solutionDatabasePath;
+        unsigned int threadCount = 0;
+        std::optional<uint64_t> seed;
+        std::string cachePath;
+        std::string puzzleTitleArg;
+        for (int i = 1; i < argc; i++) {
+            const std::string arg = argv[i];
+            if (arg == "--db" && (i + 1) < argc) {
+                databasePath = argv[++i];
+            }
+            else if (arg == "--threads" && (i + 1) < argc) {
+                threadCount = static_cast<unsigned int>(std::stoul(argv[++i]));
+            }
+            else if (arg == "--seed" && (i + 1) < argc) {
+                seed = std::stoull(argv[++i]);
+            }
+            else if (arg == "--cache" && (i + 1) < argc) {
+                cachePath = argv[++i];
+            }
+            else {
+                puzzleTitleArg = arg;
+            }
+        }
+
+        std::map<std::string, PuzzleData> puzzleTitleToData;
+
+        VerdictCache cache;
+        if (!cachePath.empty()) {
+            cache.Load(cachePath);
+            if (!seed && cache.GetSize() > 0) {
+                seed = cache.GetSeed();
+            }
+        }
+
+        if (!seed) {
+            std::random_device device;
+            seed = (static_cast<uint64_t>(device()) << 32) | device();
+        }
+
+        WorkStealingPool pool(threadCount);
+        BatchVerifier verifier(pool, *seed);
+        if (!cachePath.empty()) {
+            verifier.SetVerdictCache(&cache);
+        }
+
+        const uint64_t total = CountSolutions(databasePath, puzzleTitleArg);
+        std::fprintf(stderr, "Processing %llu solutions on %u threads (seed: %llu)...\n", static_cast<unsigned long long>(total), pool.GetThreadCount(), static_cast<unsigned long long>(*seed));
+
+        // Solutions are read on a separate thread while they're being verified (a few per thread are queued up)
+        BoundedQueue<Solution> queue(static_cast<size_t>(pool.GetThreadCount()) * 4);
+        std::exception_ptr readError;
+        std::thread reader([&]() {
+            try {
+                StreamSolutions(databasePath, [&](Solution&& solution) {
+                    return (!puzzleTitleArg.empty() && solution.puzzleTitle != puzzleTitleArg) || queue.Push(std::move(solution));
+                });
+            }
+            catch (...) {
+                readError = std::current_exception();
+            }
+            queue.Close();
+        });
+
+        const unsigned int iterations = verifier.GetIterations();
+        const auto start = std::chrono::steady_clock::now();
+        try {
+            verifier.VerifyStream(queue, [&](const Solution& solution, unsigned int failureCount) {
+                PuzzleData& data = puzzleTitleToData.insert({ solution.puzzleTitle, { 0, 0, solutionCyclesExecutedMax, 0, solutionBytesMax, 0, {} } }).first->second;
+                data.valid += iterations - failureCount;
+                data.invalid += failureCount;
+
+                if (failureCount > 0) {
+                    FailureData& failureData = data.userIdToFailures[solution.userId + "_" + solution.focus];
+                    failureData.count += failureCount;
+
+                    // Note: Zero is treated as unknown
+                    if (solution.cycles.value_or(0) != 0) {
+                        failureData.cycles = (std::min)(failureData.cycles.value_or(solutionCyclesExecutedMax), *solution.cycles);
+                    }
+
+                    if (solution.bytes.value_or(0) != 0) {
+                        failureData.bytes = (std::min)(failureData.bytes.value_or(solutionBytesMax), *solution.bytes);
+                    }
+                }
+                else {
+                    // Solution was robustly valid; check to see if it's the *best* solution
+                    if (solution.cycles.value_or(0) != 0) {
+                        data.cyclesMin = (std::min)(data.cyclesMin, *solution.cycles);
+                        data.cyclesMax = (std::max)(data.cyclesMax, *solution.cycles);
+                    }
+
+                    if (solution.bytes.value_or(0) != 0) {
+                        data.bytesMin = (std::min)(data.bytesMin, *solution.bytes);
+                        data.bytesMax = (std::max)(data.bytesMax, *solution.bytes);
+                    }
+                }
+            }, [&](uint64_t completed, uint64_t) {
+                const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                const std::string eta = (completed > 0 && completed <= total) ? FormatDuration(elapsed * static_cast<double>(total - completed) / static_cast<double>(completed)) : std::string("?");
+                std::fprintf(stderr, "\tSolutions processed: %llu of %llu (%s%%, ETA: %s)\n",
+                    static_cast<unsigned long long>(completed),
+                    static_cast<unsigned long long>(total),
+                    FormatPercentage(static_cast<double>(completed) / static_cast<double>(total) * 100).c_str(),
+                    eta.c_str());
+            });
+        }
+        catch (...) {
+            reader.join();
+            throw;
+        }
+
+        reader.join();
+        if (readError) {
+            std::rethrow_exception(readError);
+        }
+
+        const BatchStatistics& statistics = verifier.GetStatistics();
+        std::fprintf(stderr, "Verified %zu solutions (of %zu total, %zu distinct, %zu cached; deduplication and caching saved %s%% of the work)\n",
+            statistics.verifiedCount,
+            statistics.solutionCount,
+            statistics.uniqueCount,
+            statistics.cachedCount,
+            FormatPercentage(100.0 * static_cast<double>(statistics.solutionCount - statistics.verifiedCount) / static_cast<double>(statistics.solutionCount)).c_str());
+
+        if (!cachePath.empty()) {
+            cache.Save(cachePath);
+        }
+
+        std::vector<std::string> titles;
+        if (!puzzleTitleArg.empty()) {
+            titles.push_back(puzzleTitleArg);
+            puzzleTitleToData.insert({ puzzleTitleArg, { 0, 0, solutionCyclesExecutedMax, 0, solutionBytesMax, 0, {} } });
+        }
+        else {
+            for (const auto& entry : puzzleTitleToData) {
+                titles.push_back(entry.first);
+            }
+        }
+
+        std::printf("\n=== Summary ===\n\n");
+        size_t maxTitleLength = 0;
+        for (const auto& entry : puzzleTitleToData) {
+            maxTitleLength = (std::max)(maxTitleLength, entry.first.size());
+        }
+        maxTitleLength++;
+
+        for (const auto& title : titles) {
+            const PuzzleData& data = puzzleTitleToData[title];
+            const double rate = static_cast<double>(data.invalid) / static_cast<double>(data.valid + data.invalid) * 100;
+            std::printf("%s:%s Failure rate: %s%%\n", title.c_str(), std::string(maxTitleLength - title.size() - 1, ' ').c_str(), FormatPercentage(rate).c_str());
+        }
+
+        std::printf("\n=== Failures ===\n\n");
+        for (const auto& title : titles) {
+            const PuzzleData& data = puzzleTitleToData[title];
+            std::printf("%s: (cycles: %llu - %llu, bytes: %u - %u)\n",
+                title.c_str(),
+                static_cast<unsigned long long>(data.cyclesMin),
+                static_cast<unsigned long long>(data.cyclesMax),
+                data.bytesMin,
+                data.bytesMax);
+
+            std::vector<const std::pair<const std::string, FailureData>*> entries;
+            for (const auto& entry : data.userIdToFailures) {
+                entries.push_back(&entry);
+            }
+
+            std::sort(entries.begin(), entries.end(), [](const auto* a, const auto* b) { return LocaleLess(a->first, b->first); });
+            for (const auto* entry : entries) {
+                const FailureData& failureData = entry->second;
+                std::printf("\t%s\t%s%% (cycles: %s, bytes: %s)\n",
+                    entry->first.c_str(),
+                    FormatPercentage(100.0 * failureData.count / iterations).c_str(),
+                    FormatOptional(failureData.cycles).c_str(),
+                    FormatOptional(failureData.bytes).c_str());
+            }
+        }
+
+        return 0;
+    }
+}
+
+int main(int argc, char** argv) {
+    try {
+        return Run(argc, argv);
+    }
+    catch (const std::exception& error) {
+        std::fprintf(stderr, "Error: %s\n", error.what());
+        return 1;
+    }
+}
@@ -0,0 +1,196 @@
+// Tool for profiling a SIC-1 Assembly Language program, to find the source lines (e.g. the hot loop) that its cycles
+// are spent on
+//
+// Usage: profile <file.ois> [--puzzle <title>] [--json]
+//
+// With a puzzle, the program is run on the puzzle's standard test set (just like when computing its cycle count);
+// otherwise, it's run with zeros as input until it halts or the cycle limit is reached.
+//
+// The report lists each source line with its execution count (and share of cycles), branches taken and not taken, and
+// reads and writes of the line's bytes, followed by a heatmap of reads and writes by address. With --json, the same
+// data is written as JSON (e.g. for an editor overlay), with one-based line numbers.
+
+#include <algorithm>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "assembler.h"
+#include "profiler.h"
+#include "puzzles.h"
+#include "verifier.h"
+
+using namespace Sic1;
+
+namespace {
+    std::string ReadText(const std::string& path) {
+        std::ifstream stream(path, std::ios::binary);
+        if (!stream) {
+            throw std::runtime_error("Failed to open file: " + path);
+        }
+
+        std::ostringstream text;
+        text << stream.rdbuf();
+        return text.str();
+    }
+
+    // Runs the program the way verification does, but without stopping on incorrect output (the profile is still
+    // useful for a program that's being debugged)
+    void RunProgram(ProfilingEmulator& emulator, const Puzzle* puzzle) {
+        if (puzzle) {
+            const TestSet testSet = GetFixedTestSets(*puzzle)[0];
+            VerificationIo io(testSet);
+            while (emulator.IsRunning() && !io.IsComplete() && emulator.GetCyclesExecuted() < verificationCyclesExecutedMax) {
+                emulator.Step(io);
+            }
+        }
+        else {
+            NullIo io;
+            emulator.Run(io, verificationCyclesExecutedMax);
+        }
+    }
+
+    void PrintReport(const AssembledProgram& program, const Profile& profile, const std::vector<SourceLineProfile>& lines, uint64_t cyclesExecuted) {
+        std::printf("Cycles: %llu\n\n", static_cast<unsigned long long>(cyclesExecuted));
+        std::printf("%5s %7s %10s %7s %10s %10s %10s %10s  %s\n", "Line", "Address", "Executed", "Cycles", "Taken", "Not taken", "Reads", "Writes", "Source");
+        for (const SourceLineProfile& line : lines) {
+            const double share = (cyclesExecuted > 0) ? (100.0 * line.executions / cyclesExecuted) : 0;
+            std::printf("%5u %7u %10llu %6.1f%% %10llu %10llu %10llu %10llu  %s\n",
+                line.lineNumber + 1,
+                line.address,
+                static_cast<unsigned long long>(line.executions),
+                share,
+                static_cast<unsigned long long>(line.branchesTaken),
+                static_cast<unsigned long long>(line.branchesNotTaken),
+                static_cast<unsigned long long>(line.reads),
+                static_cast<unsigned long long>(line.writes),
+                program.sourceMap[line.address]->source.c_str());
+        }
+
+        // Heatmap: one character per address, scaled relative to the most accessed address
+        uint64_t accessesMax = 0;
+        for (unsigned int address = 0; address < Constants::memorySize; address++) {
+            accessesMax = (std::max)(accessesMax, profile.reads[address] + profile.writes[address]);
+        }
+
+        static const char shades[] = " .:-=+*#%@";
+        std::printf("\nMemory accesses (reads and writes) by address:\n\n     ");
+        for (unsigned int column = 0; column < 16; column++) {
+            std::printf("%x", column);
+        }
+
+        for (unsigned int address = 0; address < Constants::memorySize; address++) {
+            if (address % 16 == 0) {
+                std::printf("\n  %02x ", address);
+            }
+
+            const uint64_t accesses = profile.reads[address] + profile.writes[address];
+            const size_t shade = (accesses == 0) ? 0 : 1 + static_cast<size_t>((accesses - 1) * (sizeof(shades) - 2) / accessesMax);
+            std::printf("%c", shades[shade]);
+        }
+        std::printf("\n");
+    }
+
+    void PrintJson(const Profile& profile, const std::vector<SourceLineProfile>& lines, uint64_t cyclesExecuted) {
+        std::printf("{\n  \"cycles\": %llu,\n  \"lines\": [", static_cast<unsigned long long>(cyclesExecuted));
+        for (size_t i = 0; i < lines.size(); i++) {
+            const SourceLineProfile& line = lines[i];
+            std::printf("%s\n    { \"line\": %u, \"address\": %u, \"size\": %u, \"executions\": %llu, \"branchesTaken\": %llu, \"branchesNotTaken\": %llu, \"reads\": %llu, \"writes\": %llu }",
+                (i > 0) ? "," : "",
+                line.lineNumber + 1,
+                line.address,
+                line.size,
+                static_cast<unsigned long long>(line.executions),
+                static_cast<unsigned long long>(line.branchesTaken),
+                static_cast<unsigned long long>(line.branchesNotTaken),
+                static_cast<unsigned long long>(line.reads),
+                static_cast<unsigned long long>(line.writes));
+        }
+
+        // Per-address data, for a heatmap
+        const auto printArray = [](const char* name, const std::array<uint64_t, Constants::memorySize>& values) {
+            std::printf(",\n  \"%s\": [", name);
+            for (unsigned int address = 0; address < Constants::memorySize; address++) {
+                std::printf("%s%llu", (address > 0) ? ", " : "", static_cast<unsigned long long>(values[address]));
+            }
+            std::printf("]");
+        };
+
+        std::printf("\n  ]");
+        printArray("executions", profile.executions);
+        printArray("branchesTaken", profile.branchesTaken);
+        printArray("reads", profile.reads);
+        printArray("writes", profile.writes);
+        std::printf("\n}\n");
+    }
+
+    int Run(int argc, char** argv) {
+        std::optional<std::string> path;
+        std::optional<std::string> puzzleTitle;
+        bool json = false;
+        for (int i = 1; i < argc; i++) {
+            const std::string argument = argv[i];
+            if (argument == "--puzzle" && (i + 1) < argc) {
+                puzzleTitle = argv[++i];
+            }
+            else if (argument == "--json") {
+                json = true;
+            }
+            else if (!path && argument.rfind("--", 0) != 0) {
+                path = argument;
+            }
+            else {
+                path.reset();
+                break;
+            }
+        }
+
+        if (!path) {
+            std::fprintf(stderr, "Usage: profile <file.ois> [--puzzle <title>] [--json]\n");
+            return 1;
+        }
+
+        const Puzzle* puzzle = nullptr;
+        if (puzzleTitle) {
+            puzzle = FindPuzzle(*puzzleTitle);
+            if (!puzzle) {
+                throw std::runtime_error("Unknown puzzle: " + *puzzleTitle);
+            }
+        }
+
+        AssembledProgram program;
+        try {
+            program = Assembler::Assemble(ReadText(*path));
+        }
+        catch (const CompilationError& error) {
+            const auto& context = error.GetContext();
+            std::fprintf(stderr, "%s(%u): %s: %s\n", path->c_str(), context.sourceLineNumber.value_or(0), GetCompilationErrorTypeName(error.GetErrorType()), error.what());
+            return 1;
+        }
+
+        ProfilingEmulator emulator(program.bytes);
+        RunProgram(emulator, puzzle);
+
+        const std::vector<SourceLineProfile> lines = GetSourceLineProfiles(emulator.GetProfile(), program);
+        if (json) {
+            PrintJson(emulator.GetProfile(), lines, emulator.GetCyclesExecuted());
+        }
+        else {
+            PrintReport(program, emulator.GetProfile(), lines, emulator.GetCyclesExecuted());
+        }
+        return 0;
+    }
+}
+
+int main(int argc, char** argv) {
+    try {
+        return Run(argc, argv);
+    }
+    catch (const std::exception& error) {
+        std::fprintf(stderr, "Error: %s\n", error.what());
+        return 1;
+    }
+}
@@ -0,0 +1,167 @@
+// Tool for finding an input that breaks a SIC-1 Assembly Language solution, using a coverage-guided search over the
+// puzzle's random tests (see inputsearch.h) instead of verifying against lots of random test sets
+//
+// Usage: search-inputs <file.ois> --puzzle <title> [--executions <count>] [--seed <seed>] [--blind]
+//
+// The search is seeded randomly (and the seed is logged), unless a seed is specified. If a failing input is found, it's
+// reported after minimization, along with the expected and actual output. With --blind, random test sets are also
+// verified (with the same budget) for comparison. Exits with 2 if a failing input was found.
+
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "assembler.h"
+#include "inputsearch.h"
+#include "puzzles.h"
+#include "verifier.h"
+
+using namespace Sic1;
+
+namespace {
+    constexpr uint64_t executionsMaxDefault = 100000;
+    constexpr uint64_t minimizationExecutionsMax = 10000;
+
+    std::string ReadText(const std::string& path) {
+        std::ifstream stream(path, std::ios::binary);
+        if (!stream) {
+            throw std::runtime_error("Failed to open file: " + path);
+        }
+
+        std::ostringstream text;
+        text << stream.rdbuf();
+        return text.str();
+    }
+
+    const char* GetStatusName(VerificationStatus status) {
+        switch (status) {
+        case VerificationStatus::Success: return "Success";
+        case VerificationStatus::HaltedUnexpectedly: return "Halted unexpectedly";
+        case VerificationStatus::ResourceLimitExceeded: return "Resource limit exceeded";
+        case VerificationStatus::IncorrectOutput: return "Incorrect output";
+        case VerificationStatus::NonTerminating: return "Non-terminating";
+        }
+        return "Unknown";
+    }
+
+    void PrintValues(const char* name, const std::vector<int8_t>& values) {
+        std::printf("%s:", name);
+        for (int8_t value : values) {
+            std::printf(" %d", value);
+        }
+        std::printf("\n");
+    }
+
+    // Number of random test sets verified before one failed (or nothing, if none did within the budget)
+    std::optional<uint64_t> SearchBlindly(const Puzzle& puzzle, const std::vector<uint8_t>& bytes, uint64_t seed, uint64_t executionsMax) {
+        for (uint64_t i = 0; i < executionsMax; i++) {
+            Random random(Random::DeriveSeed(seed, i));
+            const TestSet testSet = CreateTestSet(puzzle, puzzle.createRandomTest(random));
+            if (VerifyProgram(bytes, testSet, verificationCyclesExecutedMax, solutionBytesMax).status != VerificationStatus::Success) {
+                return i + 1;
+            }
+        }
+        return std::nullopt;
+    }
+
+    int Run(int argc, char** argv) {
+        std::optional<std::string> path;
+        std::optional<std::string> puzzleTitle;
+        std::optional<uint64_t> seed;
+        uint64_t executionsMax = executionsMaxDefault;
+        bool blind = false;
+        for (int i = 1; i < argc; i++) {
+            const std::string argument = argv[i];
+            if (argument == "--puzzle" && (i + 1) < argc) {
+                puzzleTitle = argv[++i];
+            }
+            else if (argument == "--executions" && (i + 1) < argc) {
+                executionsMax = std::stoull(argv[++i]);
+            }
+            else if (argument == "--seed" && (i + 1) < argc) {
+                seed = std::stoull(argv[++i]);
+            }
+            else if (argument == "--blind") {
+                blind = true;
+            }
+            else if (!path && argument.rfind("--", 0) != 0) {
+                path = argument;
+            }
+            else {
+                path.reset();
+                break;
+            }
+        }
+
+        if (!path || !puzzleTitle) {
+            std::fprintf(stderr, "Usage: search-inputs <file.ois> --puzzle <title> [--executions <count>] [--seed <seed>] [--blind]\n");
+            return 1;
+        }
+
+        const Puzzle* puzzle = FindPuzzle(*puzzleTitle);
+        if (!puzzle) {
+            throw std::runtime_error("Unknown puzzle: " + *puzzleTitle);
+        }
+
+        AssembledProgram program;
+        try {
+            program = Assembler::Assemble(ReadText(*path));
+        }
+        catch (const CompilationError& error) {
+            const auto& context = error.GetContext();
+            std::fprintf(stderr, "%s(%u): %s: %s\n", path->c_str(), context.sourceLineNumber.value_or(0), GetCompilationErrorTypeName(error.GetErrorType()), error.what());
+            return 1;
+        }
+
+        if (!seed) {
+            std::random_device device;
+            seed = (static_cast<uint64_t>(device()) << 32) | device();
+        }
+        std::printf("Seed: %llu\n", static_cast<unsigned long long>(*seed));
+
+        InputSearchOptions options = {};
+        options.seed = *seed;
+        options.executionsMax = executionsMax;
+        options.minimizationExecutionsMax = minimizationExecutionsMax;
+        const InputSearchResult result = SearchForFailingInput(*puzzle, program.bytes, options);
+
+        std::printf("Executions: %llu (corpus: %zu inputs, %zu edges covered)\n", static_cast<unsigned long long>(result.executions), result.corpusSize, result.edgesCovered);
+        if (blind) {
+            const std::optional<uint64_t> blindExecutions = SearchBlindly(*puzzle, program.bytes, *seed, executionsMax);
+            if (blindExecutions) {
+                std::printf("Blind sampling: failed after %llu executions\n", static_cast<unsigned long long>(*blindExecutions));
+            }
+            else {
+                std::printf("Blind sampling: no failure in %llu executions\n", static_cast<unsigned long long>(executionsMax));
+            }
+        }
+
+        if (!result.found) {
+            std::printf("No failing input found\n");
+            return 0;
+        }
+
+        std::printf("Failing input found (minimized in %llu executions): %s\n", static_cast<unsigned long long>(result.minimizationExecutions), GetStatusName(result.result.status));
+        PrintValues("Input", result.testSet.input);
+        PrintValues("Expected output", result.testSet.output);
+        if (result.result.status == VerificationStatus::IncorrectOutput) {
+            std::printf("Output %zu: expected %d, actual %d\n", result.result.errorOutputIndex, result.result.errorExpected, result.result.errorActual);
+        }
+        return 2;
+    }
+}
+
+int main(int argc, char** argv) {
+    try {
+        return Run(argc, argv);
+    }
+    catch (const std::exception& error) {
+        std::fprintf(stderr, "Error: %s\n", error.what());
+        return 1;
+    }
+}
@@ -0,0 +1,143 @@
+// Tool for measuring how quickly Steam call results are delivered, using the simulated Steam backend, with the adaptive
+// callback pump and with the fixed 200 ms polling that the Windows client used to do
+//
+// Usage: steam-latency [--calls <count>] [--latency <ms>] [--jitter <ms>] [--seed <seed>]
+//
+// Calls are started in bursts (like the UI does when opening a puzzle), and each call type's latency (from starting the
+// call until its result is delivered) is reported as percentiles, along with the number of times callbacks were run.
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "simulatedsteam.h"
+#include "steampump.h"
+
+using namespace Sic1;
+
+namespace {
+    constexpr unsigned int burstSize = 4;
+
+    typedef struct {
+        unsigned int callCount;
+        std::chrono::milliseconds latency;
+        std::chrono::milliseconds jitter;
+        uint64_t seed;
+    } Workload;
+
+    void PrintHistogram(const char* name, const LatencyHistogram& histogram) {
+        const auto toMilliseconds = [](std::chrono::microseconds value) {
+            return value.count() / 1000.0;
+        };
+
+        std::printf("  %-34s %6llu %9.1f %9.1f %9.1f %9.1f\n",
+            name,
+            static_cast<unsigned long long>(histogram.GetCount()),
+            toMilliseconds(histogram.GetPercentile(50)),
+            toMilliseconds(histogram.GetPercentile(90)),
+            toMilliseconds(histogram.GetPercentile(99)),
+            toMilliseconds(histogram.GetMax()));
+    }
+
+    void Measure(const char* name, const SteamPumpSchedule& schedule, const Workload& workload) {
+        SimulatedSteamApi api(workload.seed);
+        api.SetLatency({ workload.latency, workload.jitter });
+
+        std::mutex mutex;
+        std::condition_variable delivered;
+        unsigned int deliveredCount = 0;
+        SteamCallbackPump pump(api, [&](SteamCallHandle, const SteamCallResult&) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                deliveredCount++;
+            }
+            delivered.notify_all();
+        }, schedule);
+
+        // Bursts of leaderboard lookups and downloads, with an upload and a stats store at the end of each burst
+        const auto start = std::chrono::steady_clock::now();
+        unsigned int startedCount = 0;
+        while (startedCount < workload.callCount) {
+            for (unsigned int i = 0; i < burstSize && startedCount < workload.callCount; i++, startedCount++) {
+                const std::string leaderboardName = "Puzzle " + std::to_string(startedCount);
+                switch (i % burstSize) {
+                case 0:
+                    pump.Start(SteamCallType::FindLeaderboard, [&](SteamApi& steam) { return steam.FindLeaderboard(leaderboardName); });
+                    break;
+
+                case 1:
+                    pump.Start(SteamCallType::DownloadFriendLeaderboardEntries, [](SteamApi& steam) { return steam.DownloadFriendLeaderboardEntries(1); });
+                    break;
+
+                case 2:
+                    pump.Start(SteamCallType::UploadLeaderboardScore, [&](SteamApi& steam) { return steam.UploadLeaderboardScore(1, static_cast<int>(startedCount), {}); });
+                    break;
+
+                default:
+                    pump.Start(SteamCallType::StoreStats, [](SteamApi& steam) { return steam.StoreStats(); });
+                    break;
+                }
+            }
+
+            std::unique_lock<std::mutex> lock(mutex);
+            delivered.wait(lock, [&]() { return deliveredCount == startedCount; });
+        }
+
+        const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        std::printf("%s: %u calls in %lld ms, %llu polls\n", name, workload.callCount, static_cast<long long>(elapsed.count()), static_cast<unsigned long long>(pump.GetPollCount()));
+        std::printf("  %-34s %6s %9s %9s %9s %9s\n", "Call (latency in ms)", "Count", "Median", "90th", "99th", "Max");
+
+        LatencyHistogram total;
+        for (size_t type = 0; type < steamCallTypeCount; type++) {
+            const LatencyHistogram histogram = pump.GetLatencyHistogram(static_cast<SteamCallType>(type));
+            if (histogram.GetCount() > 0) {
+                PrintHistogram(GetSteamCallTypeName(static_cast<SteamCallType>(type)), histogram);
+                total.Merge(histogram);
+            }
+        }
+
+        PrintHistogram("All", total);
+        std::printf("\n");
+    }
+
+    int Run(int argc, char** argv) {
+        Workload workload = { 40, std::chrono::milliseconds(50), std::chrono::milliseconds(50), 0 };
+        for (int i = 1; i < argc; i++) {
+            const std::string argument = argv[i];
+            if (argument == "--calls" && (i + 1) < argc) {
+                workload.callCount = static_cast<unsigned int>(std::stoul(argv[++i]));
+            }
+            else if (argument == "--latency" && (i + 1) < argc) {
+                workload.latency = std::chrono::milliseconds(std::stoul(argv[++i]));
+            }
+            else if (argument == "--jitter" && (i + 1) < argc) {
+                workload.jitter = std::chrono::milliseconds(std::stoul(argv[++i]));
+            }
+            else if (argument == "--seed" && (i + 1) < argc) {
+                workload.seed = std::stoull(argv[++i]);
+            }
+            else {
+                std::fprintf(stderr, "Usage: steam-latency [--calls <count>] [--latency <ms>] [--jitter <ms>] [--seed <seed>]\n");
+                return 1;
+            }
+        }
+
+        std::printf("Simulated backend latency: %lld ms + up to %lld ms\n\n", static_cast<long long>(workload.latency.count()), static_cast<long long>(workload.jitter.count()));
+        Measure("Adaptive pump", steamPumpScheduleDefault, workload);
+        Measure("Fixed 200 ms polling", steamPumpScheduleFixed, workload);
+        return 0;
+    }
+}
+
+int main(int argc, char** argv) {
+    try {
+        return Run(argc, argv);
+    }
+    catch (const std::exception& error) {
+        std::fprintf(stderr, "Error: %s\n", error.what());
+        return 1;
+    }
+}
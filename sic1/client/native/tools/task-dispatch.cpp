@@ -0,0 +1,215 @@
+// Tool for measuring task dispatch latency and throughput of the task scheduler, compared with a single shared
+// work-stealing pool of std::function tasks (which is roughly how the Windows client used the Win32 thread pool)
+//
+// Usage: task-dispatch [--tasks <count>] [--threads <count>] [--blocking <ms>]
+//
+// Three workloads are run:
+//
+// * Latency: tasks are submitted one at a time (to idle workers), and the time from submitting each task until it
+//   starts is reported as percentiles
+// * Throughput: tiny tasks are submitted as quickly as possible, and the rate at which they complete is reported
+// * Head-of-line blocking: every network worker is tied up with slow (blocking) calls, and the latency of interactive
+//   tasks submitted in the meantime is reported
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include "latencyhistogram.h"
+#include "taskscheduler.h"
+#include "workstealingpool.h"
+
+using namespace Sic1;
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    typedef struct {
+        unsigned int taskCount;
+        unsigned int threadCount;
+        std::chrono::milliseconds blocking;
+    } Workload;
+
+    // Adapters so that each workload can be run on the scheduler or on the shared pool (which ignores task classes)
+    class SchedulerTarget {
+    public:
+        explicit SchedulerTarget(TaskScheduler& scheduler)
+            : m_scheduler(scheduler) {
+        }
+
+        template<typename TFunction>
+        void Submit(TaskPriority priority, TFunction&& function) {
+            m_scheduler.Submit(priority, std::forward<TFunction>(function));
+        }
+
+        void Wait() {
+            m_scheduler.Wait();
+        }
+
+    private:
+        TaskScheduler& m_scheduler;
+    };
+
+    class PoolTarget {
+    public:
+        explicit PoolTarget(WorkStealingPool& pool)
+            : m_pool(pool) {
+        }
+
+        template<typename TFunction>
+        void Submit(TaskPriority, TFunction&& function) {
+            m_pool.Submit(std::forward<TFunction>(function));
+        }
+
+        void Wait() {
+            m_pool.Wait();
+        }
+
+    private:
+        WorkStealingPool& m_pool;
+    };
+
+    // Records latencies from any thread
+    class Recorder {
+    public:
+        void Record(Clock::time_point submitted) {
+            const auto latency = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - submitted);
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_histogram.Record(latency);
+        }
+
+        LatencyHistogram GetHistogram() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_histogram;
+        }
+
+    private:
+        std::mutex m_mutex;
+        LatencyHistogram m_histogram;
+    };
+
+    void PrintHistogram(const char* name, const LatencyHistogram& histogram) {
+        std::printf("  %-34s %8llu %9lld %9lld %9lld %9lld\n",
+            name,
+            static_cast<unsigned long long>(histogram.GetCount()),
+            static_cast<long long>(histogram.GetPercentile(50).count()),
+            static_cast<long long>(histogram.GetPercentile(90).count()),
+            static_cast<long long>(histogram.GetPercentile(99).count()),
+            static_cast<long long>(histogram.GetMax().count()));
+    }
+
+    void PrintHistogramHeader(const char* title) {
+        std::printf("%s\n", title);
+        std::printf("  %-34s %8s %9s %9s %9s %9s\n", "Latency (us)", "Count", "Median", "90th", "99th", "Max");
+    }
+
+    template<typename TTarget>
+    LatencyHistogram MeasureLatency(TTarget target, unsigned int taskCount) {
+        Recorder recorder;
+        for (unsigned int i = 0; i < taskCount; i++) {
+            std::atomic<bool> done(false);
+            const Clock::time_point submitted = Clock::now();
+            target.Submit(TaskPriority::Interactive, [&recorder, &done, submitted]() {
+                recorder.Record(submitted);
+                done = true;
+            });
+
+            while (!done.load()) {
+                std::this_thread::yield();
+            }
+        }
+
+        return recorder.GetHistogram();
+    }
+
+    template<typename TTarget>
+    double MeasureThroughput(TTarget target, unsigned int taskCount) {
+        std::atomic<uint64_t> sum(0);
+        const Clock::time_point start = Clock::now();
+        for (unsigned int i = 0; i < taskCount; i++) {
+            target.Submit(TaskPriority::Compute, [&sum, i]() { sum.fetch_add(i, std::memory_order_relaxed); });
+        }
+
+        target.Wait();
+        const std::chrono::duration<double> elapsed = Clock::now() - start;
+        return taskCount / elapsed.count();
+    }
+
+    template<typename TTarget>
+    LatencyHistogram MeasureHeadOfLine(TTarget target, const Workload& workload) {
+        // Slow calls (more than there are workers)
+        for (unsigned int i = 0; i < workload.threadCount * 2; i++) {
+            target.Submit(TaskPriority::Network, [&workload]() { std::this_thread::sleep_for(workload.blocking); });
+        }
+
+        // Interactive tasks, spread out over the time that the slow calls are running
+        Recorder recorder;
+        const unsigned int interactiveCount = 20;
+        for (unsigned int i = 0; i < interactiveCount; i++) {
+            const Clock::time_point submitted = Clock::now();
+            target.Submit(TaskPriority::Interactive, [&recorder, submitted]() { recorder.Record(submitted); });
+            std::this_thread::sleep_for(workload.blocking / interactiveCount);
+        }
+
+        target.Wait();
+        return recorder.GetHistogram();
+    }
+
+    int Run(int argc, char** argv) {
+        Workload workload = { 100000, 4, std::chrono::milliseconds(50) };
+        for (int i = 1; i < argc; i++) {
+            const std::string argument = argv[i];
+            if (argument == "--tasks" && (i + 1) < argc) {
+                workload.taskCount = static_cast<unsigned int>(std::stoul(argv[++i]));
+            }
+            else if (argument == "--threads" && (i + 1) < argc) {
+                workload.threadCount = static_cast<unsigned int>(std::stoul(argv[++i]));
+            }
+            else if (argument == "--blocking" && (i + 1) < argc) {
+                workload.blocking = std::chrono::milliseconds(std::stoul(argv[++i]));
+            }
+            else {
+                std::fprintf(stderr, "Usage: task-dispatch [--tasks <count>] [--threads <count>] [--blocking <ms>]\n");
+                return 1;
+            }
+        }
+
+        // Note: The scheduler gets the same number of threads for its network and compute classes as the pool has
+        TaskScheduler scheduler(TaskSchedulerOptions{ { 2, 1, workload.threadCount, workload.threadCount } });
+        WorkStealingPool pool(workload.threadCount);
+
+        const unsigned int latencyTaskCount = (std::min)(workload.taskCount, 10000u);
+        PrintHistogramHeader("Dispatch latency (idle workers)");
+        PrintHistogram("Task scheduler", MeasureLatency(SchedulerTarget(scheduler), latencyTaskCount));
+        PrintHistogram("Shared pool", MeasureLatency(PoolTarget(pool), latencyTaskCount));
+        std::printf("\n");
+
+        std::printf("Throughput (%u tiny tasks, %u threads)\n", workload.taskCount, workload.threadCount);
+        const double schedulerRate = MeasureThroughput(SchedulerTarget(scheduler), workload.taskCount);
+        std::printf("  %-34s %12.0f tasks/s (%zu pooled task nodes)\n", "Task scheduler", schedulerRate, scheduler.GetTaskNodeCount());
+        std::printf("  %-34s %12.0f tasks/s\n", "Shared pool", MeasureThroughput(PoolTarget(pool), workload.taskCount));
+        std::printf("\n");
+
+        char title[128];
+        std::snprintf(title, sizeof(title), "Interactive tasks behind %u blocking %lld ms calls", workload.threadCount * 2, static_cast<long long>(workload.blocking.count()));
+        PrintHistogramHeader(title);
+        PrintHistogram("Task scheduler", MeasureHeadOfLine(SchedulerTarget(scheduler), workload));
+        PrintHistogram("Shared pool", MeasureHeadOfLine(PoolTarget(pool), workload));
+        return 0;
+    }
+}
+
+int main(int argc, char** argv) {
+    try {
+        return Run(argc, argv);
+    }
+    catch (const std::exception& error) {
+        std::fprintf(stderr, "Error: %s\n", error.what());
+        return 1;
+    }
+}
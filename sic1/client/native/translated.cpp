@@ -0,0 +1,177 @@
+#include "translated.h"
+
+#include <algorithm>
+#include <iterator>
+
+using namespace Sic1;
+
+TranslatedEmulator::TranslatedEmulator(const uint8_t* bytes, size_t count)
+    : PredecodedEmulator(bytes, count) {
+    std::fill(std::begin(m_entryHits), std::end(m_entryHits), uint8_t(0));
+    std::fill(std::begin(m_blockIndexes), std::end(m_blockIndexes), uint8_t(0));
+}
+
+TranslatedEmulator::TranslatedEmulator(const std::vector<uint8_t>& bytes)
+    : TranslatedEmulator(bytes.data(), bytes.size()) {
+}
+
+void TranslatedEmulator::Reset() {
+    // Blocks are kept (along with how often each entry point has been reached), except for ones whose code no longer
+    // matches the initial program
+    std::bitset<Constants::memorySize> modified;
+    for (unsigned int address = 0; address < Constants::memorySize; address++) {
+        modified[address] = (m_memory[address] != m_initialMemorySnapshot[address]);
+    }
+
+    std::bitset<Constants::memorySize> code;
+    for (auto& block : m_blocks) {
+        block.accessesCounted = false;
+        if (block.state == BlockState::Translated) {
+            if ((block.code & modified).any()) {
+                block.state = BlockState::Untranslated;
+            }
+            else {
+                code |= block.code;
+            }
+        }
+    }
+
+    PredecodedEmulator::Reset();
+
+    // Note: Resetting forgets which bytes are code, but writes to the remaining blocks' code still need to discard them
+    for (unsigned int address = 0; address < Constants::memorySize; address++) {
+        m_isCode[address] = code[address];
+    }
+}
+
+TranslatedEmulator::Block& TranslatedEmulator::GetBlock(unsigned int entry) {
+    if (m_blockIndexes[entry] == 0) {
+        Block block = {};
+        block.state = BlockState::Untranslated;
+        m_blocks.push_back(block);
+        m_blockIndexes[entry] = static_cast<uint8_t>(m_blocks.size());
+    }
+    return m_blocks[m_blockIndexes[entry] - 1];
+}
+
+void TranslatedEmulator::FlushBlocks() {
+    for (auto& block : m_blocks) {
+        if (block.state == BlockState::Translated) {
+            block.state = BlockState::Untranslated;
+        }
+    }
+
+    m_operations.clear();
+    m_accesses.clear();
+}
+
+void TranslatedEmulator::Translate(unsigned int entry) {
+    if (m_operations.size() + blockCyclesMax + 1 > operationCountMax) {
+        FlushBlocks();
+    }
+
+    Block& block = GetBlock(entry);
+    block.accessesCounted = false;
+    block.firstOperation = static_cast<uint32_t>(m_operations.size());
+    block.cycles = 0;
+    block.code.reset();
+    block.firstAccess = static_cast<uint32_t>(m_accesses.size());
+
+    std::bitset<Constants::memorySize> accesses;
+    auto addAccess = [&](unsigned int address) {
+        if (!accesses[address]) {
+            accesses.set(address);
+            m_accesses.push_back(static_cast<uint8_t>(address));
+        }
+    };
+
+    // Addresses written by the block so far (code that is modified by the block itself can't be translated)
+    std::bitset<Constants::memorySize> written;
+
+    unsigned int ip = entry;
+    while (true) {
+        if (ip > Constants::addressInstructionMax
+            || block.cycles >= blockCyclesMax
+            || block.code[ip] || block.code[ip + 1] || block.code[ip + 2]
+            || written[ip] || written[ip + 1] || written[ip + 2]) {
+            m_operations.push_back({ OperationKind::Jump, 0, 0, static_cast<uint8_t>(ip), 0 });
+            break;
+        }
+
+        const uint8_t a = m_memory[ip];
+        const uint8_t b = m_memory[ip + 1];
+        const uint8_t c = m_memory[ip + 2];
+        const uint8_t next = static_cast<uint8_t>(ip + Constants::subleqInstructionBytes);
+        for (unsigned int address = ip; address < next; address++) {
+            block.code.set(address);
+            addAccess(address);
+            m_isCode[address] = true;
+        }
+
+        addAccess(a);
+        addAccess(b);
+        block.cycles++;
+
+        // Outputs and conditional branches end the block
+        const bool inputOutput = (a >= Constants::addressInput || b == Constants::addressInput);
+        const bool staticSuccessor = (a == b) || (c == next);
+        if (a == Constants::addressOutput || !staticSuccessor) {
+            m_operations.push_back({ inputOutput ? OperationKind::InputOutputBranch : OperationKind::Branch, a, b, c, next });
+            break;
+        }
+
+        if (inputOutput) {
+            m_operations.push_back({ OperationKind::InputOutput, a, b, 0, 0 });
+        }
+        else {
+            m_operations.push_back({ (a == b) ? OperationKind::Clear : OperationKind::Subtract, a, b, 0, 0 });
+        }
+
+        if (a < Constants::addressInput) {
+            written.set(a);
+        }
+
+        // Note: If both operands are the same, the result is zero, so the branch is always taken
+        ip = (a == b) ? c : next;
+    }
+
+    // Fuse common idioms (the terminator is always last and never fused)
+    const size_t first = block.firstOperation;
+    size_t count = m_operations.size() - first;
+    auto fuse = [&](size_t index, const Operation& fused) {
+        m_operations[first + index] = fused;
+        m_operations.erase(m_operations.begin() + (first + index + 1));
+        count--;
+    };
+
+    for (size_t i = 0; i + 2 < count; i++) {
+        const Operation& current = m_operations[first + i];
+        const Operation& following = m_operations[first + i + 1];
+        if (current.kind == OperationKind::Clear && following.kind == OperationKind::Subtract && following.a == current.a) {
+            fuse(i, { OperationKind::NegateCopy, current.a, following.b, 0, 0 });
+        }
+    }
+
+    for (size_t i = 0; i + 2 < count; i++) {
+        const Operation& current = m_operations[first + i];
+        const Operation& following = m_operations[first + i + 1];
+        if (current.kind == OperationKind::NegateCopy && following.kind == OperationKind::NegateCopy && following.b == current.a) {
+            fuse(i, { OperationKind::Copy, following.a, current.b, current.a, 0 });
+        }
+    }
+
+    block.accessCount = static_cast<uint32_t>(m_accesses.size() - block.firstAccess);
+
+    block.state = BlockState::Translated;
+}
+
+void TranslatedEmulator::Invalidate(unsigned int address) {
+    PredecodedEmulator::Invalidate(address);
+
+    // Note: Only hot entry points have blocks, so there are only ever a few to check
+    for (auto& block : m_blocks) {
+        if (block.state == BlockState::Translated && block.code[address]) {
+            block.state = (++block.invalidationCount >= invalidationCountMax) ? BlockState::Interpreted : BlockState::Untranslated;
+        }
+    }
+}
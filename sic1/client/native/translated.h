@@ -0,0 +1,281 @@
+#pragma once
+
+#include <bitset>
+#include <vector>
+#include "predecoded.h"
+
+namespace Sic1 {
+    // Emulator that translates straight-line runs of code into blocks of fused operations ("superinstructions").
+    //
+    // A block starts at an entry point and follows every instruction whose successor is known statically (i.e. the
+    // branch target is the next instruction, or both operands are the same, so the result is always zero). It ends
+    // with a conditional branch, an output, or a jump to code that was already included. Common idioms are fused:
+    //
+    // * subleq @x, @x          -> clear
+    // * subleq @x, @x + subleq @x, @y -> negate and copy
+    // * two chained negate and copy operations -> copy (via a temporary)
+    //
+    // Cycles and memory bytes accessed are accounted for per block (each block records its instruction count and
+    // the addresses it touches), so totals are identical to Emulator. Writes to any byte of a translated block discard
+    // the block; entry points that are repeatedly overwritten (e.g. by self-modifying loops) fall back to the
+    // pre-decoded interpreter permanently.
+    //
+    // Entry points are interpreted until they've been reached a few times, so code that only runs once is never
+    // translated, and blocks are only allocated once they're needed. Resetting keeps every block whose code still
+    // matches the initial program, so verifying several test sets with one emulator (see VerifyLoadedProgram) only
+    // translates each block once.
+    class TranslatedEmulator : public PredecodedEmulator {
+    public:
+        TranslatedEmulator(const uint8_t* bytes, size_t count);
+        explicit TranslatedEmulator(const std::vector<uint8_t>& bytes);
+
+        template<typename TIo>
+        void StepBlock(TIo& io, uint64_t cyclesExecutedMax, unsigned int memoryBytesAccessedMax);
+
+        template<typename TIo>
+        void Run(TIo& io);
+
+        template<typename TIo>
+        void Run(TIo& io, uint64_t cyclesExecutedMax);
+
+        void Reset();
+
+    protected:
+        enum class OperationKind : uint8_t {
+            // mem[a] = mem[a] - mem[b]
+            Subtract,
+
+            // mem[a] = 0
+            Clear,
+
+            // mem[a] = -mem[b]
+            NegateCopy,
+
+            // mem[c] = -mem[b]; mem[a] = -mem[c]
+            Copy,
+
+            // Any instruction that reads @IN or discards its result (but doesn't output); the successor is static
+            InputOutput,
+
+            // Terminators:
+
+            // ip = c
+            Jump,
+
+            // Subtract, then branch to c (if result <= 0) or d
+            Branch,
+
+            // Any instruction involving I/O, then branch to c (if result <= 0) or d
+            InputOutputBranch,
+        };
+
+        typedef struct {
+            OperationKind kind;
+            uint8_t a;
+            uint8_t b;
+            uint8_t c;
+            uint8_t d;
+        } Operation;
+
+        enum class BlockState : uint8_t {
+            Untranslated,
+            Translated,
+
+            // Overwritten too many times; always use the interpreter
+            Interpreted,
+        };
+
+        typedef struct {
+            BlockState state;
+            uint8_t invalidationCount;
+
+            // True once every address in the block's accesses has been counted (since the last reset)
+            bool accessesCounted;
+
+            uint32_t firstOperation;
+            uint32_t cycles;
+
+            // Every address read or written by the block, including the bytes of its own instructions (stored in
+            // m_accesses, without duplicates)
+            uint32_t firstAccess;
+            uint32_t accessCount;
+
+            // Bytes of the block's own instructions
+            std::bitset<Constants::memorySize> code;
+        } Block;
+
+        static constexpr unsigned int entryCount = decodedInstructionCount;
+        static constexpr unsigned int blockCyclesMax = 64;
+        static constexpr uint8_t invalidationCountMax = 4;
+        static constexpr size_t operationCountMax = 16384;
+
+        // Number of times an entry point is interpreted before it's translated
+        static constexpr uint8_t translationThreshold = 32;
+
+        // Returns the entry point's block (allocating it, if needed)
+        Block& GetBlock(unsigned int entry);
+
+        void Translate(unsigned int entry);
+        void FlushBlocks();
+        void Invalidate(unsigned int address) override;
+
+        void StoreMemoryInBlock(unsigned int address, uint8_t value) {
+            SetMemory(address, value);
+            if (m_isCode[address]) {
+                Invalidate(address);
+            }
+        }
+
+        // Executes an instruction that involves I/O (without any accounting) and returns the result
+        template<typename TIo>
+        int8_t ExecuteInputOutput(TIo& io, unsigned int a, unsigned int b);
+
+        // Times each entry point without a block has been reached, and the index of each entry point's block in
+        // m_blocks plus one (zero means no block has been allocated yet)
+        uint8_t m_entryHits[entryCount];
+        uint8_t m_blockIndexes[entryCount];
+
+        std::vector<Block> m_blocks;
+        std::vector<Operation> m_operations;
+        std::vector<uint8_t> m_accesses;
+    };
+
+    template<typename TIo>
+    inline int8_t TranslatedEmulator::ExecuteInputOutput(TIo& io, unsigned int a, unsigned int b) {
+        uint8_t input = 0;
+        bool inputValid = true;
+        if (a == Constants::addressInput || b == Constants::addressInput) {
+            inputValid = io.TryReadInput(input);
+        }
+
+        const uint8_t av = (a == Constants::addressInput) ? input : m_memory[a];
+        const uint8_t bv = (b == Constants::addressInput) ? input : m_memory[b];
+        const uint8_t result = inputValid ? static_cast<uint8_t>(av - bv) : 0;
+
+        const int8_t resultSigned = UnsignedToSigned(result);
+        switch (a) {
+        case Constants::addressInput:
+        case Constants::addressHalt:
+            break;
+
+        case Constants::addressOutput:
+            io.WriteOutput(resultSigned);
+            break;
+
+        default:
+            StoreMemoryInBlock(a, result);
+            break;
+        }
+
+        return resultSigned;
+    }
+
+    template<typename TIo>
+    inline void TranslatedEmulator::StepBlock(TIo& io, uint64_t cyclesExecutedMax, unsigned int memoryBytesAccessedMax) {
+        if (!IsRunning()) {
+            return;
+        }
+
+        // Interpret entry points until they're hot
+        unsigned int blockIndex = m_blockIndexes[m_ip];
+        if (blockIndex == 0) {
+            if (++m_entryHits[m_ip] < translationThreshold) {
+                Step(io);
+                return;
+            }
+
+            Translate(m_ip);
+            blockIndex = m_blockIndexes[m_ip];
+        }
+
+        Block& block = m_blocks[blockIndex - 1];
+        if (block.state == BlockState::Untranslated) {
+            Translate(m_ip);
+        }
+
+        // Only run the block as a unit if no limit could be reached partway through (otherwise, step)
+        if (block.state != BlockState::Translated || (m_cyclesExecuted + block.cycles - 1) > cyclesExecutedMax) {
+            Step(io);
+            return;
+        }
+
+        if (!block.accessesCounted) {
+            const uint8_t* accesses = &m_accesses[block.firstAccess];
+            unsigned int newlyAccessedCount = 0;
+            for (uint32_t i = 0; i < block.accessCount; i++) {
+                newlyAccessedCount += m_memoryAccessed[accesses[i]] ? 0 : 1;
+            }
+
+            if (m_memoryBytesAccessed + newlyAccessedCount > memoryBytesAccessedMax) {
+                Step(io);
+                return;
+            }
+
+            for (uint32_t i = 0; i < block.accessCount; i++) {
+                AccessMemory(accesses[i]);
+            }
+            block.accessesCounted = true;
+        }
+
+        m_cyclesExecuted += block.cycles;
+
+        // Note: Invalidation (even of this block) never releases operations, so this pointer remains valid
+        const Operation* operation = &m_operations[block.firstOperation];
+        while (true) {
+            switch (operation->kind) {
+            case OperationKind::Subtract:
+                StoreMemoryInBlock(operation->a, static_cast<uint8_t>(m_memory[operation->a] - m_memory[operation->b]));
+                break;
+
+            case OperationKind::Clear:
+                StoreMemoryInBlock(operation->a, 0);
+                break;
+
+            case OperationKind::NegateCopy:
+                StoreMemoryInBlock(operation->a, static_cast<uint8_t>(-m_memory[operation->b]));
+                break;
+
+            case OperationKind::Copy:
+                StoreMemoryInBlock(operation->c, static_cast<uint8_t>(-m_memory[operation->b]));
+                StoreMemoryInBlock(operation->a, static_cast<uint8_t>(-m_memory[operation->c]));
+                break;
+
+            case OperationKind::InputOutput:
+                ExecuteInputOutput(io, operation->a, operation->b);
+                break;
+
+            case OperationKind::Jump:
+                m_ip = operation->c;
+                return;
+
+            case OperationKind::Branch:
+            {
+                const uint8_t result = static_cast<uint8_t>(m_memory[operation->a] - m_memory[operation->b]);
+                m_ip = (UnsignedToSigned(result) <= 0) ? operation->c : operation->d;
+                StoreMemoryInBlock(operation->a, result);
+                return;
+            }
+
+            case OperationKind::InputOutputBranch:
+                m_ip = (ExecuteInputOutput(io, operation->a, operation->b) <= 0) ? operation->c : operation->d;
+                return;
+            }
+
+            operation++;
+        }
+    }
+
+    template<typename TIo>
+    inline void TranslatedEmulator::Run(TIo& io) {
+        while (IsRunning()) {
+            StepBlock(io, UINT64_MAX, Constants::memorySize);
+        }
+    }
+
+    template<typename TIo>
+    inline void TranslatedEmulator::Run(TIo& io, uint64_t cyclesExecutedMax) {
+        while (IsRunning() && m_cyclesExecuted < cyclesExecutedMax) {
+            StepBlock(io, cyclesExecutedMax - 1, Constants::memorySize);
+        }
+    }
+}
@@ -0,0 +1,197 @@
+#include "verdictcache.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include "batchverifier.h"
+#include "verifier.h"
+
+using namespace Sic1;
+
+namespace {
+    const char* const fileMagic = "sic1-verdicts";
+    constexpr unsigned int fileVersion = 2;
+
+    // SplitMix64 finalizer
+    uint64_t Mix(uint64_t z) {
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+
+    // Two independent 64-bit hashes: FNV-1a, and a multiplicative hash with a different multiplier (finalized with
+    // SplitMix64)
+    class DigestBuilder {
+    public:
+        DigestBuilder()
+            : m_fnv(0xcbf29ce484222325ull), m_multiplicative(0x6a09e667f3bcc909ull) {
+        }
+
+        void Add(const uint8_t* data, size_t size) {
+            for (size_t i = 0; i < size; i++) {
+                m_fnv = (m_fnv ^ data[i]) * 0x100000001b3ull;
+                m_multiplicative = (m_multiplicative + data[i] + 1) * 0xd6e8feb86659fd93ull;
+            }
+        }
+
+        void Add(uint64_t value) {
+            uint8_t bytes[8];
+            for (unsigned int i = 0; i < 8; i++) {
+                bytes[i] = static_cast<uint8_t>(value >> (i * 8));
+            }
+            Add(bytes, sizeof(bytes));
+        }
+
+        SolutionDigest Finish() const {
+            return { m_fnv, Mix(m_multiplicative) };
+        }
+
+    private:
+        uint64_t m_fnv;
+        uint64_t m_multiplicative;
+    };
+
+    int HexDigitToValue(char c) {
+        if (c >= '0' && c <= '9') {
+            return c - '0';
+        }
+        else if (c >= 'a' && c <= 'f') {
+            return c - 'a' + 10;
+        }
+        else if (c >= 'A' && c <= 'F') {
+            return c - 'A' + 10;
+        }
+        return -1;
+    }
+
+    bool TryParseDigest(const std::string& text, SolutionDigest& digest) {
+        if (text.size() != 32) {
+            return false;
+        }
+
+        digest = { 0, 0 };
+        for (unsigned int i = 0; i < 16; i++) {
+            const int high = HexDigitToValue(text[i]);
+            const int low = HexDigitToValue(text[i + 16]);
+            if (high < 0 || low < 0) {
+                return false;
+            }
+
+            digest.high = (digest.high << 4) | static_cast<uint64_t>(high);
+            digest.low = (digest.low << 4) | static_cast<uint64_t>(low);
+        }
+        return true;
+    }
+}
+
+SolutionDigest Sic1::GetSolutionDigest(const Solution& solution) {
+    // Note: Lengths are included so that adjacent fields can't run together
+    DigestBuilder builder;
+    builder.Add(solution.puzzleTitle.size());
+    builder.Add(reinterpret_cast<const uint8_t*>(solution.puzzleTitle.data()), solution.puzzleTitle.size());
+    builder.Add(solution.program.size());
+    builder.Add(solution.program.data(), solution.program.size());
+    builder.Add(solution.cycles.value_or(solutionCyclesExecutedMax));
+    builder.Add(solution.bytes.value_or(solutionBytesMax));
+    return builder.Finish();
+}
+
+std::string Sic1::FormatSolutionDigest(const SolutionDigest& digest) {
+    char buffer[33];
+    std::snprintf(buffer, sizeof(buffer), "%016llx%016llx", static_cast<unsigned long long>(digest.high), static_cast<unsigned long long>(digest.low));
+    return buffer;
+}
+
+void VerdictCache::Load(const std::string& path) {
+    m_seed = 0;
+    m_iterations = 0;
+    m_verdicts.clear();
+
+    std::ifstream stream(path);
+    if (!stream) {
+        return;
+    }
+
+    std::string name;
+    unsigned int version;
+    if (!(stream >> name >> version) || name != fileMagic) {
+        throw std::runtime_error("Unrecognized verdict cache: " + path);
+    }
+
+    // Verdicts from other versions may be stale, so they're discarded
+    if (version != fileVersion) {
+        return;
+    }
+
+    unsigned int verifierVersion;
+    uint64_t seed;
+    unsigned int iterations;
+    if (!(stream >> name >> verifierVersion) || name != "verifier" || !(stream >> name >> seed) || name != "seed" || !(stream >> name >> iterations) || name != "iterations") {
+        throw std::runtime_error("Invalid verdict cache header: " + path);
+    }
+
+    if (verifierVersion != verdictCacheVerifierVersion) {
+        return;
+    }
+
+    m_seed = seed;
+    m_iterations = iterations;
+
+    std::string digestText;
+    unsigned int failures;
+    while (stream >> digestText >> failures) {
+        SolutionDigest digest;
+        if (!TryParseDigest(digestText, digest) || failures > m_iterations) {
+            throw std::runtime_error("Invalid verdict cache entry: " + digestText);
+        }
+        m_verdicts[digest] = failures;
+    }
+
+    if (!stream.eof()) {
+        throw std::runtime_error("Invalid verdict cache entry in: " + path);
+    }
+}
+
+void VerdictCache::Save(const std::string& path) const {
+    const std::string temporaryPath = path + ".tmp";
+    {
+        std::ofstream stream(temporaryPath, std::ios::trunc);
+        stream << fileMagic << " " << fileVersion << "\n";
+        stream << "verifier " << verdictCacheVerifierVersion << "\n";
+        stream << "seed " << m_seed << "\n";
+        stream << "iterations " << m_iterations << "\n";
+        for (const auto& entry : m_verdicts) {
+            stream << FormatSolutionDigest(entry.first) << " " << entry.second << "\n";
+        }
+
+        stream.flush();
+        if (!stream) {
+            throw std::runtime_error("Failed to write verdict cache: " + temporaryPath);
+        }
+    }
+
+    std::filesystem::rename(temporaryPath, path);
+}
+
+void VerdictCache::SetParameters(uint64_t seed, unsigned int iterations) {
+    if (seed != m_seed || iterations != m_iterations) {
+        m_seed = seed;
+        m_iterations = iterations;
+        m_verdicts.clear();
+    }
+}
+
+bool VerdictCache::TryGet(const SolutionDigest& digest, unsigned int& failures) const {
+    const auto it = m_verdicts.find(digest);
+    if (it == m_verdicts.end()) {
+        return false;
+    }
+
+    failures = it->second;
+    return true;
+}
+
+void VerdictCache::Set(const SolutionDigest& digest, unsigned int failures) {
+    m_verdicts[digest] = failures;
+}
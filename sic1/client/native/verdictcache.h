@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include "solutiondb.h"
+
+namespace Sic1 {
+    // Content address of a solution: a 128-bit digest of everything that determines its verdict (for a given seed and
+    // iteration count), i.e. the puzzle, the program bytes, and the limits used for the standard test set. Solutions
+    // from different users with identical digests are verified once.
+    typedef struct {
+        uint64_t high;
+        uint64_t low;
+    } SolutionDigest;
+
+    inline bool operator==(const SolutionDigest& a, const SolutionDigest& b) {
+        return a.high == b.high && a.low == b.low;
+    }
+
+    struct SolutionDigestHash {
+        size_t operator()(const SolutionDigest& digest) const {
+            return static_cast<size_t>(digest.low);
+        }
+    };
+
+    // Note: Unspecified limits are hashed as the defaults they stand for, so they match explicit defaults
+    SolutionDigest GetSolutionDigest(const Solution& solution);
+
+    std::string FormatSolutionDigest(const SolutionDigest& digest);
+
+    // Version of everything (besides the digest's inputs) that determines a verdict, i.e. verification logic and test set
+    // generation. Bump this whenever either changes, so that verdicts cached by older builds are discarded.
+    constexpr unsigned int verdictCacheVerifierVersion = 1;
+
+    // Persistent map from solution digests to failure counts, so repeated runs (with the same seed and number of
+    // iterations) only verify programs they haven't seen before.
+    //
+    // The file is plain text: a "sic1-verdicts <format version>" line, "verifier <version>", "seed <seed>", and
+    // "iterations <count>" lines, and then one "<digest> <failures>" line per solution.
+    class VerdictCache {
+    public:
+        VerdictCache()
+            : m_seed(0), m_iterations(0) {
+        }
+
+        // Replaces the contents of the cache with a file's contents; a missing file, or one written by a different
+        // format or verifier version, leaves the cache empty. Throws std::runtime_error if the file is malformed.
+        void Load(const std::string& path);
+
+        // Writes to a temporary file, and then replaces the given file (so an interrupted save doesn't lose the cache)
+        void Save(const std::string& path) const;
+
+        uint64_t GetSeed() const {
+            return m_seed;
+        }
+
+        unsigned int GetIterations() const {
+            return m_iterations;
+        }
+
+        size_t GetSize() const {
+            return m_verdicts.size();
+        }
+
+        // Verdicts are only valid for one seed and iteration count, so changing either discards them
+        void SetParameters(uint64_t seed, unsigned int iterations);
+
+        bool TryGet(const SolutionDigest& digest, unsigned int& failures) const;
+        void Set(const SolutionDigest& digest, unsigned int failures);
+
+    private:
+        uint64_t m_seed;
+        unsigned int m_iterations;
+        std::unordered_map<SolutionDigest, unsigned int, SolutionDigestHash> m_verdicts;
+    };
+}
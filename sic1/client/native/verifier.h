@@ -0,0 +1,271 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include "predecoded.h"
+
+// Native equivalent of verifyProgram in shared/puzzles.ts
+namespace Sic1 {
+    // Limits for test sets other than the standard one (verificationMaxCycles and solutionBytesMax)
+    constexpr uint64_t verificationCyclesExecutedMax = 100000;
+    constexpr unsigned int solutionBytesMax = 256;
+
+    // Test sets hold signed words (int8_t for SIC-1, but other SubleqMachines can be verified too)
+    template<typename TValue>
+    struct BasicTestSet {
+        std::vector<TValue> input;
+        std::vector<TValue> output;
+    };
+
+    typedef BasicTestSet<int8_t> TestSet;
+
+    enum class VerificationStatus : uint8_t {
+        // All expected outputs were produced (within the limits)
+        Success,
+
+        // "Execution halted unexpectedly"
+        HaltedUnexpectedly,
+
+        // "Execution during ... did not complete within ... cycles and ... bytes"
+        ResourceLimitExceeded,
+
+        // "Incorrect output produced during ..."
+        IncorrectOutput,
+
+        // The program reached a state (instruction pointer, memory, and I/O position) it had already been in, so it
+        // would have kept looping (without output) until exceeding the cycle limit. This is only detected natively
+        // (the script version reports ResourceLimitExceeded once the limit is reached).
+        NonTerminating,
+    };
+
+    template<typename TValue>
+    struct BasicVerificationResult {
+        VerificationStatus status;
+        uint64_t cyclesExecuted;
+        unsigned int memoryBytesAccessed;
+
+        // Number of inputs read (including reads past the end), as reported in ProgramVerificationError
+        size_t inputIndex;
+
+        // First incorrect output (only valid for IncorrectOutput)
+        size_t errorOutputIndex;
+        TValue errorExpected;
+        TValue errorActual;
+    };
+
+    typedef BasicVerificationResult<int8_t> VerificationResult;
+
+    // I/O handler that supplies a test set's input and checks output against the expected output
+    template<typename TMachine>
+    class BasicVerificationIo {
+    public:
+        typedef typename TMachine::Word Word;
+        typedef typename TMachine::SignedWord SignedWord;
+
+        explicit BasicVerificationIo(const BasicTestSet<SignedWord>& testSet)
+            : m_testSet(testSet),
+            m_inputIndex(0),
+            m_outputIndex(0),
+            m_correct(true),
+            m_errorOutputIndex(0),
+            m_errorExpected(0),
+            m_errorActual(0) {
+        }
+
+        bool TryReadInput(Word& value) {
+            // Note: Reads past the end are still counted, just like in the script version
+            const size_t index = m_inputIndex++;
+            if (index >= m_testSet.input.size()) {
+                return false;
+            }
+
+            value = static_cast<Word>(m_testSet.input[index]);
+            return true;
+        }
+
+        void WriteOutput(SignedWord value) {
+            const size_t index = m_outputIndex++;
+            const SignedWord expected = m_testSet.output[index];
+            if (value != expected && m_correct) {
+                m_correct = false;
+                m_errorOutputIndex = index;
+                m_errorExpected = expected;
+                m_errorActual = value;
+            }
+        }
+
+        bool IsCorrect() const {
+            return m_correct;
+        }
+
+        bool IsComplete() const {
+            return m_outputIndex >= m_testSet.output.size();
+        }
+
+        // Position in the input for the purpose of comparing states (reads past the end all behave the same, so they
+        // are not distinguished)
+        size_t GetInputPosition() const {
+            return (std::min)(m_inputIndex, m_testSet.input.size());
+        }
+
+        size_t GetOutputIndex() const {
+            return m_outputIndex;
+        }
+
+        void GetResult(BasicVerificationResult<SignedWord>& result) const {
+            result.inputIndex = m_inputIndex;
+            result.errorOutputIndex = m_errorOutputIndex;
+            result.errorExpected = m_errorExpected;
+            result.errorActual = m_errorActual;
+        }
+
+    private:
+        const BasicTestSet<SignedWord>& m_testSet;
+        size_t m_inputIndex;
+        size_t m_outputIndex;
+        bool m_correct;
+        size_t m_errorOutputIndex;
+        SignedWord m_errorExpected;
+        SignedWord m_errorActual;
+    };
+
+    typedef BasicVerificationIo<Sic1Machine> VerificationIo;
+
+    // Detects repeated machine states using Brent's algorithm: a state is saved after 1, 2, 4, 8, ... checks and each
+    // check compares against the saved state. Comparisons use the incrementally updated memory hash, so memory itself
+    // is only compared when everything else matches.
+    //
+    // Any deterministic sequence of checks works (e.g. one per block), as long as checks are made while running.
+    template<typename TMachine>
+    class BasicLoopDetector {
+    public:
+        typedef typename TMachine::Word Word;
+
+        BasicLoopDetector()
+            : m_saved(false),
+            m_checksUntilSave(1),
+            m_savePeriod(1),
+            m_ip(0),
+            m_memoryHash(0),
+            m_inputPosition(0),
+            m_outputIndex(0),
+            m_memory() {
+            if constexpr (!TMachine::memoryInline) {
+                m_memory.resize(TMachine::memorySize);
+            }
+        }
+
+        // Returns true if the state has already been seen
+        bool Check(unsigned int ip, uint64_t memoryHash, const Word* memory, size_t inputPosition, size_t outputIndex) {
+            if (m_saved
+                && ip == m_ip
+                && memoryHash == m_memoryHash
+                && inputPosition == m_inputPosition
+                && outputIndex == m_outputIndex
+                && std::memcmp(memory, &m_memory[0], TMachine::memorySize * sizeof(Word)) == 0) {
+                return true;
+            }
+
+            if (--m_checksUntilSave == 0) {
+                m_saved = true;
+                m_savePeriod *= 2;
+                m_checksUntilSave = m_savePeriod;
+                m_ip = ip;
+                m_memoryHash = memoryHash;
+                m_inputPosition = inputPosition;
+                m_outputIndex = outputIndex;
+                std::memcpy(&m_memory[0], memory, TMachine::memorySize * sizeof(Word));
+            }
+            return false;
+        }
+
+    private:
+        bool m_saved;
+        uint64_t m_checksUntilSave;
+        uint64_t m_savePeriod;
+
+        unsigned int m_ip;
+        uint64_t m_memoryHash;
+        size_t m_inputPosition;
+        size_t m_outputIndex;
+        typename TMachine::Memory m_memory;
+    };
+
+    typedef BasicLoopDetector<Sic1Machine> LoopDetector;
+
+    // Runs a program on a single test set, stopping at the first incorrect output or once all expected outputs have
+    // been produced. The outcome (including which failure is reported when several apply) is identical to
+    // verifyProgram, except that, if loop detection is enabled, programs that are stuck in a loop fail early with
+    // NonTerminating instead of eventually exceeding the cycle limit.
+    //
+    // Loops are checked for after each call to the engine's StepBlock (i.e. after every instruction, or after every
+    // translated block), so a NonTerminating result's cycle count and input index (which includes reads past the end
+    // of the input) vary by engine. Its other fields are the same for every engine, since the loop has been run all
+    // the way around by the time it's detected. An engine may even reach the cycle limit (ResourceLimitExceeded)
+    // before detecting a loop that another engine detects.
+    //
+    // Any engine works, including BasicEmulators for other SubleqMachines (whose programs and test sets are made of
+    // the machine's words).
+    //
+    // This overload runs an engine that has already been constructed (e.g. one that needs extra arguments, or one
+    // that's reset and reused for each test set of a program).
+    template<typename TEngine, typename TMachine = typename TEngine::Machine>
+    BasicVerificationResult<typename TMachine::SignedWord> VerifyLoadedProgram(TEngine& emulator, const BasicTestSet<typename TMachine::SignedWord>& testSet, uint64_t cyclesExecutedMax, unsigned int memoryBytesAccessedMax, bool detectLoops = true) {
+        BasicVerificationIo<TMachine> io(testSet);
+        BasicLoopDetector<TMachine> loopDetector;
+        BasicVerificationResult<typename TMachine::SignedWord> result = {};
+
+        bool halted = false;
+        bool looping = false;
+        while (io.IsCorrect() && !io.IsComplete() && emulator.GetCyclesExecuted() <= cyclesExecutedMax && emulator.GetMemoryBytesAccessed() <= memoryBytesAccessedMax) {
+            emulator.StepBlock(io, cyclesExecutedMax, memoryBytesAccessedMax);
+
+            // Halting is reported immediately (even if the final output was just produced)
+            if (!emulator.IsRunning()) {
+                halted = true;
+                break;
+            }
+
+            if (detectLoops && loopDetector.Check(emulator.GetIp(), emulator.GetMemoryHash(), emulator.GetMemory(), io.GetInputPosition(), io.GetOutputIndex())) {
+                looping = true;
+                break;
+            }
+        }
+
+        result.cyclesExecuted = emulator.GetCyclesExecuted();
+        result.memoryBytesAccessed = emulator.GetMemoryBytesAccessed();
+        io.GetResult(result);
+
+        if (halted) {
+            result.status = VerificationStatus::HaltedUnexpectedly;
+        }
+        else if (result.cyclesExecuted > cyclesExecutedMax || result.memoryBytesAccessed > memoryBytesAccessedMax) {
+            result.status = VerificationStatus::ResourceLimitExceeded;
+        }
+        else if (!io.IsCorrect()) {
+            result.status = VerificationStatus::IncorrectOutput;
+        }
+        else if (looping) {
+            result.status = VerificationStatus::NonTerminating;
+        }
+        else {
+            result.status = VerificationStatus::Success;
+        }
+
+        return result;
+    }
+
+    // Note: PredecodedEmulator is the default engine because it's the fastest on short runs like these (see the
+    // verifier benchmarks in tools/benchmark.cpp)
+    template<typename TEngine = PredecodedEmulator, typename TMachine = typename TEngine::Machine>
+    BasicVerificationResult<typename TMachine::SignedWord> VerifyProgram(const typename TMachine::Word* bytes, size_t count, const BasicTestSet<typename TMachine::SignedWord>& testSet, uint64_t cyclesExecutedMax, unsigned int memoryBytesAccessedMax, bool detectLoops = true) {
+        TEngine emulator(bytes, count);
+        return VerifyLoadedProgram(emulator, testSet, cyclesExecutedMax, memoryBytesAccessedMax, detectLoops);
+    }
+
+    template<typename TEngine = PredecodedEmulator, typename TMachine = typename TEngine::Machine>
+    BasicVerificationResult<typename TMachine::SignedWord> VerifyProgram(const std::vector<typename TMachine::Word>& bytes, const BasicTestSet<typename TMachine::SignedWord>& testSet, uint64_t cyclesExecutedMax, unsigned int memoryBytesAccessedMax, bool detectLoops = true) {
+        return VerifyProgram<TEngine>(bytes.data(), bytes.size(), testSet, cyclesExecutedMax, memoryBytesAccessedMax, detectLoops);
+    }
+}
@@ -0,0 +1,155 @@
+#include "workstealingpool.h"
+
+#include <algorithm>
+
+using namespace Sic1;
+
+namespace {
+    // Index of the current thread's worker, if the current thread belongs to a pool
+    thread_local const WorkStealingPool* currentPool = nullptr;
+    thread_local unsigned int currentWorkerIndex = 0;
+}
+
+WorkStealingPool::WorkStealingPool(unsigned int threadCount)
+    : m_queuedCount(0), m_stopping(false), m_pendingCount(0), m_nextWorker(0) {
+    if (threadCount == 0) {
+        threadCount = (std::max)(1u, std::thread::hardware_concurrency());
+    }
+
+    for (unsigned int i = 0; i < threadCount; i++) {
+        m_workers.push_back(std::make_unique<Worker>());
+    }
+
+    for (unsigned int i = 0; i < threadCount; i++) {
+        m_threads.emplace_back(&WorkStealingPool::WorkerLoop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_taskQueued.notify_all();
+
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+void WorkStealingPool::Submit(Task task) {
+    const unsigned int index = (currentPool == this)
+        ? currentWorkerIndex
+        : (m_nextWorker.fetch_add(1, std::memory_order_relaxed) % GetThreadCount());
+
+    // Note: Count the task before queuing it, so that the count never drops below zero
+    m_pendingCount.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queuedCount++;
+    }
+
+    {
+        Worker& worker = *m_workers[index];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.tasks.push_back(std::move(task));
+    }
+    m_taskQueued.notify_one();
+}
+
+void WorkStealingPool::Wait() {
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_idle.wait(lock, [this]() { return m_pendingCount.load() == 0; });
+    }
+    RethrowIfNeeded();
+}
+
+bool WorkStealingPool::WaitFor(std::chrono::milliseconds timeout) {
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_idle.wait_for(lock, timeout, [this]() { return m_pendingCount.load() == 0; })) {
+            return false;
+        }
+    }
+    RethrowIfNeeded();
+    return true;
+}
+
+void WorkStealingPool::RethrowIfNeeded() {
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::swap(error, m_error);
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+bool WorkStealingPool::TryTake(unsigned int index, Task& task) {
+    // Newest task from this worker's own deque first
+    {
+        Worker& worker = *m_workers[index];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (!worker.tasks.empty()) {
+            task = std::move(worker.tasks.back());
+            worker.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // Otherwise, steal the oldest task from another worker
+    const unsigned int count = GetThreadCount();
+    for (unsigned int offset = 1; offset < count; offset++) {
+        Worker& victim = *m_workers[(index + offset) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void WorkStealingPool::WorkerLoop(unsigned int index) {
+    currentPool = this;
+    currentWorkerIndex = index;
+
+    while (true) {
+        Task task;
+        if (TryTake(index, task)) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_queuedCount--;
+            }
+
+            try {
+                task();
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (!m_error) {
+                    m_error = std::current_exception();
+                }
+            }
+
+            // Note: Release the task (and anything it captured) before reporting completion
+            task = nullptr;
+            if (m_pendingCount.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_idle.notify_all();
+            }
+        }
+        else {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_taskQueued.wait(lock, [this]() { return m_queuedCount > 0 || m_stopping; });
+            if (m_stopping) {
+                break;
+            }
+        }
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Sic1 {
+    // Thread pool where each worker has its own deque of tasks. Workers take their own most recently queued task first
+    // (so related work stays on one core) and, when they run out, steal the oldest task from another worker. Tasks
+    // may queue more tasks (which go onto the current worker's deque).
+    class WorkStealingPool {
+    public:
+        typedef std::function<void()> Task;
+
+        // Note: A thread count of zero means one thread per hardware thread
+        explicit WorkStealingPool(unsigned int threadCount = 0);
+        ~WorkStealingPool();
+
+        WorkStealingPool(const WorkStealingPool&) = delete;
+        WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+        // Note: Counts workers (which are all created before any thread starts), since workers call this while threads
+        // are still being started
+        unsigned int GetThreadCount() const {
+            return static_cast<unsigned int>(m_workers.size());
+        }
+
+        void Submit(Task task);
+
+        // Waits for all queued tasks (including any they queued) to complete, rethrowing the first exception thrown by a
+        // task, if any
+        void Wait();
+
+        // Same as Wait, but returns false if tasks are still running after the timeout
+        bool WaitFor(std::chrono::milliseconds timeout);
+
+    private:
+        typedef struct {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        } Worker;
+
+        void WorkerLoop(unsigned int index);
+        bool TryTake(unsigned int index, Task& task);
+        void RethrowIfNeeded();
+
+        std::vector<std::unique_ptr<Worker>> m_workers;
+        std::vector<std::thread> m_threads;
+
+        // Signaled when a task is queued (or the pool is shutting down)
+        std::mutex m_mutex;
+        std::condition_variable m_taskQueued;
+        std::condition_variable m_idle;
+        size_t m_queuedCount;
+        bool m_stopping;
+
+        // Tasks that have been submitted, but not yet completed
+        std::atomic<size_t> m_pendingCount;
+
+        // Used to spread tasks submitted from outside the pool across workers
+        std::atomic<unsigned int> m_nextWorker;
+
+        std::exception_ptr m_error;
+    };
+}
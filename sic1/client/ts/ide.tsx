@@ -1,4 +1,4 @@
-import { Assembler, Emulator, CompilationError, Constants, Variable, Command } from "../../../lib/src/sic1asm";
+import { Assembler, Emulator, CompilationError, Constants, Variable, Command, SourceMapEntry } from "../../../lib/src/sic1asm";
 import { Format } from "./puzzles";
 import { PuzzleTest, generatePuzzleTest, PuzzleTestSet } from "../../shared/puzzles";
 import React from "react";
@@ -12,6 +12,7 @@ import { parseValues, Sic1InputEditor } from "./ide-input-editor";
 import { Shared } from "./shared";
 import { Sic1CodeView } from "./ide-code-view";
 import { FormattedMessage, IntlShape } from "react-intl";
+import { NativeRunStopReason, Platform } from "./platform";
 
 // State management
 enum StateFlags {
@@ -151,6 +152,10 @@ export class Sic1Ide extends React.Component<Sic1IdeProperties, Sic1IdeState> {
         },
     ];
 
+    // Native runs (at the fastest step rate) execute at most this many cycles per timer tick (a few milliseconds), so
+    // that programs that never halt don't block the UI and can still be paused
+    private static readonly nativeCycleBudget = 1000000;
+
     private codeView = React.createRef<Sic1CodeView>();
 
     private stateFlags = StateFlags.none;
@@ -160,11 +165,27 @@ export class Sic1Ide extends React.Component<Sic1IdeProperties, Sic1IdeState> {
     private runToken?: number;
     private memoryMap: number[][];
     private programBytes: number[];
+    private sourceMap: SourceMapEntry[];
     private emulator: Emulator;
     private testSetIndex: number;
+
+    // I/O progress for the current test set
+    private inputIndex = 0;
+    private outputIndex = 0;
+    private actualOutputCount = 0;
+    private readInput = false;
+    private done = false;
+
+    // Native run that's continued on each timer tick at the fastest step rate, and the emulator state it belongs to
+    private nativeRun?: { emulator: Emulator, testSetIndex: number, cyclesExecuted: number };
+
     private solutionCyclesExecuted?: number;
     private solutionMemoryBytesAccessed?: number;
 
+    // Memory writes are tracked by the emulator and published in a batch once per display frame, so that rendering cost
+    // depends on the number of frames shown rather than the number of instructions executed
+    private memoryFrameToken?: number;
+
     constructor(props: Sic1IdeProperties) {
         super(props);
 
@@ -313,8 +334,30 @@ export class Sic1Ide extends React.Component<Sic1IdeProperties, Sic1IdeState> {
         }
     }
 
-    private updateMemory(address: number, value: number): void {
-        this.setState({ [address]: value });
+    private scheduleMemoryUpdate(): void {
+        if (this.emulator && this.memoryFrameToken === undefined && this.emulator.hasMemoryUpdate()) {
+            this.memoryFrameToken = window.requestAnimationFrame(this.publishMemory);
+        }
+    }
+
+    private publishMemory = () => {
+        this.memoryFrameToken = undefined;
+        if (this.emulator) {
+            const { addresses, values } = this.emulator.takeMemoryUpdate();
+            const memory: { [address: number]: number } = {};
+            for (let i = 0; i < addresses.length; i++) {
+                memory[addresses[i]] = values[i];
+            }
+
+            this.setState(memory);
+        }
+    }
+
+    private discardMemoryUpdates(): void {
+        if (this.memoryFrameToken !== undefined) {
+            window.cancelAnimationFrame(this.memoryFrameToken);
+            this.memoryFrameToken = undefined;
+        }
     }
 
     private load(): boolean {
@@ -325,10 +368,11 @@ export class Sic1Ide extends React.Component<Sic1IdeProperties, Sic1IdeState> {
             this.emulator = null;
             this.setStateFlags(StateFlags.none);
 
-            let inputIndex = 0;
-            let outputIndex = 0;
-            let done = false;
-            let readInput = false;
+            this.inputIndex = 0;
+            this.outputIndex = 0;
+            this.actualOutputCount = 0;
+            this.readInput = false;
+            this.done = false;
             const assembledProgram = Assembler.assemble(sourceLines);
             const breakpointSet = new Set(assembledProgram.breakpoints);
 
@@ -342,47 +386,19 @@ export class Sic1Ide extends React.Component<Sic1IdeProperties, Sic1IdeState> {
             });
 
             this.programBytes = assembledProgram.bytes.slice();
+            this.sourceMap = assembledProgram.sourceMap;
             this.emulator = new Emulator(assembledProgram, {
                 readInput: () => {
                     // Get next input, or zero if past the end
                     const inputBytes = this.state.test.testSets[this.testSetIndex].input;
-                    var value = (inputIndex < inputBytes.length) ? inputBytes[inputIndex] : 0;
-                    inputIndex++;
-                    readInput = true;
+                    var value = (this.inputIndex < inputBytes.length) ? inputBytes[this.inputIndex] : 0;
+                    this.inputIndex++;
+                    this.readInput = true;
 
                     return value;
                 },
 
-                writeOutput: (value) => {
-                    const expectedOutputBytes = this.state.test.testSets[this.testSetIndex]["output"];
-                    if (expectedOutputBytes) {
-                        if (outputIndex < expectedOutputBytes.length) {
-                            this.setState(state => ({ actualOutputBytes: [...state.actualOutputBytes, value] }));
-    
-                            if (value !== expectedOutputBytes[outputIndex]) {
-                                this.setStateFlag(StateFlags.error);
-                                const index = outputIndex;
-                                this.setState(state => {
-                                    const unexpectedOutputIndexes = {};
-                                    for (let key in state.unexpectedOutputIndexes) {
-                                        unexpectedOutputIndexes[key] = state.unexpectedOutputIndexes[key];
-                                    }
-                                    unexpectedOutputIndexes[index] = true;
-                                    return { unexpectedOutputIndexes };
-                                });
-                            }
-    
-                            this.props.onOutputCorrect();
-                            ++outputIndex;
-                        }
-                    } else {
-                        this.setState(state => ({ actualOutputBytes: [...state.actualOutputBytes, value] }));
-                    }
-                },
-
-                onWriteMemory: (address, value) => {
-                    this.updateMemory(address, value);
-                },
+                writeOutput: (value) => this.writeOutput(value),
 
                 onStateUpdated: (data) => {
                     // Check for program
@@ -399,7 +415,7 @@ export class Sic1Ide extends React.Component<Sic1IdeProperties, Sic1IdeState> {
                     // Check for completion, or a need to advance to the next test set
                     const expectedOutputBytes = this.state.test.testSets[this.testSetIndex]["output"];
                     if (expectedOutputBytes) {
-                        if (this.emulator && this.emulator.isRunning() && outputIndex == expectedOutputBytes.length && !this.hasError()) {
+                        if (this.emulator && this.emulator.isRunning() && this.outputIndex == expectedOutputBytes.length && !this.hasError()) {
                             if (this.testSetIndex === 0) {
                                 // Record stats from the first test set
                                 this.solutionCyclesExecuted = this.emulator.getCyclesExecuted();
@@ -407,11 +423,12 @@ export class Sic1Ide extends React.Component<Sic1IdeProperties, Sic1IdeState> {
                             }
     
                             if (this.testSetIndex === this.state.test.testSets.length - 1) {
-                                done = true;
+                                this.done = true;
                             } else {
                                 this.testSetIndex++;
-                                inputIndex = 0;
-                                outputIndex = 0;
+                                this.inputIndex = 0;
+                                this.outputIndex = 0;
+                                this.actualOutputCount = 0;
                                 this.setState({ actualOutputBytes: [] });
                                 this.resetRequired = true;
                             }
@@ -425,18 +442,19 @@ export class Sic1Ide extends React.Component<Sic1IdeProperties, Sic1IdeState> {
                         memoryBytesAccessed: data.memoryBytesAccessed,
                         currentSourceLine: (data.ip <= Constants.addressUserMax) ? data.sourceLineNumber : undefined,
                         currentAddress: data.ip,
-                        currentInputIndex: (inputIndex < this.state.test.testSets[this.testSetIndex].input.length) ? inputIndex : null,
-                        currentOutputIndex: (outputIndex < this.state.test.testSets[this.testSetIndex]["output"]?.length) ? outputIndex : null,
+                        currentInputIndex: (this.inputIndex < this.state.test.testSets[this.testSetIndex].input.length) ? this.inputIndex : null,
+                        currentOutputIndex: (this.outputIndex < this.state.test.testSets[this.testSetIndex]["output"]?.length) ? this.outputIndex : null,
                         variables: data.variables,
-                        hasReadInput: state.hasReadInput || readInput,
+                        hasReadInput: state.hasReadInput || this.readInput,
                     }));
 
-                    if (done) {
+                    if (this.done) {
                         this.setStateFlag(StateFlags.done);
                     }
                 },
             });
 
+            this.scheduleMemoryUpdate();
             return true;
         } catch (error) {
             if (error instanceof CompilationError) {
@@ -454,18 +472,114 @@ export class Sic1Ide extends React.Component<Sic1IdeProperties, Sic1IdeState> {
         return false;
     }
 
+    private writeOutput(value: number): void {
+        const expectedOutputBytes = this.state.test.testSets[this.testSetIndex]["output"];
+        if (expectedOutputBytes) {
+            if (this.outputIndex < expectedOutputBytes.length) {
+                this.setState(state => ({ actualOutputBytes: [...state.actualOutputBytes, value] }));
+                this.actualOutputCount++;
+
+                if (value !== expectedOutputBytes[this.outputIndex]) {
+                    this.setStateFlag(StateFlags.error);
+                    const index = this.outputIndex;
+                    this.setState(state => {
+                        const unexpectedOutputIndexes = {};
+                        for (let key in state.unexpectedOutputIndexes) {
+                            unexpectedOutputIndexes[key] = state.unexpectedOutputIndexes[key];
+                        }
+                        unexpectedOutputIndexes[index] = true;
+                        return { unexpectedOutputIndexes };
+                    });
+                }
+
+                this.props.onOutputCorrect();
+                ++this.outputIndex;
+            }
+        } else {
+            this.setState(state => ({ actualOutputBytes: [...state.actualOutputBytes, value] }));
+            this.actualOutputCount++;
+        }
+    }
+
     private stepInternal() {
         if (this.emulator && !this.isDone()) {
             this.emulator.step();
-            if (!this.emulator.isRunning()) {
-                // Execution halted
-                this.setStepRateIndex(undefined);
-                this.props.onHalt();
-            } else if (this.resetRequired) {
-                this.resetRequired = false;
-                this.emulator.reset();
+            this.completeStep();
+        }
+    }
+
+    private completeStep() {
+        if (!this.emulator.isRunning()) {
+            // Execution halted
+            this.setStepRateIndex(undefined);
+            this.props.onHalt();
+        } else if (this.resetRequired) {
+            this.resetRequired = false;
+            this.emulator.reset();
+        }
+
+        this.scheduleMemoryUpdate();
+    }
+
+    private canRunNatively(): boolean {
+        // Note: Native runs stop at incorrect output, so the rest of a failed run is stepped
+        return !!Platform.continueNativeRun && (this.stepRateIndex === Sic1Ide.stepRates.length - 1) && !this.hasError();
+    }
+
+    // Continues the current test set natively for up to one cycle budget, and then continues stepping from the resulting
+    // state, instead of stepping (and updating the UI) one instruction at a time. Returns false if the native run can't
+    // reproduce the current state, in which case the caller should step instead.
+    private runNatively(): boolean {
+        if (this.emulator && !this.isDone()) {
+            const testSet = this.state.test.testSets[this.testSetIndex];
+            const breakpoints = Object.entries(this.sourceMap)
+                .filter(([address, sme]) => (sme && sme.command === Command.subleqInstruction && this.state.sourceLineToBreakpointState[sme.lineNumber]))
+                .map(([address, sme]) => parseInt(address));
+
+            // The native run keeps its state between ticks, so it's only restarted if the current state wasn't reached
+            // by it (e.g. after stepping manually or running at a slower rate). A restarted run catches up to the
+            // current state (ignoring breakpoints) one budget at a time, and its results aren't applied until it does.
+            const cyclesExecuted = this.emulator.getCyclesExecuted();
+            if (!this.nativeRun
+                || this.nativeRun.emulator !== this.emulator
+                || this.nativeRun.testSetIndex !== this.testSetIndex
+                || this.nativeRun.cyclesExecuted > cyclesExecuted) {
+                Platform.startNativeRun({
+                    programBytes: this.programBytes,
+                    input: testSet.input,
+                    expectedOutput: testSet["output"],
+                });
+
+                this.nativeRun = { emulator: this.emulator, testSetIndex: this.testSetIndex, cyclesExecuted: 0 };
+            }
+
+            const result = Platform.continueNativeRun({
+                breakpoints,
+                resumeCycle: cyclesExecuted,
+                cycleBudget: Sic1Ide.nativeCycleBudget,
+            });
+
+            this.nativeRun.cyclesExecuted = result.cyclesExecuted;
+            if (result.cyclesExecuted < cyclesExecuted) {
+                // Still catching up, unless the native run stopped short of the current state (which shouldn't happen,
+                // since runs are deterministic); a stopped run stays stopped, so the rest of this test set is stepped
+                return result.reason === NativeRunStopReason.cycleLimit;
             }
+
+            // Apply I/O that happened after the current state, and then continue from where the native run stopped
+            if (result.inputIndex > this.inputIndex) {
+                this.inputIndex = result.inputIndex;
+                this.readInput = true;
+            }
+
+            for (const value of result.output.slice(this.actualOutputCount)) {
+                this.writeOutput(value);
+            }
+
+            this.emulator.restoreState(result);
+            this.completeStep();
         }
+        return true;
     }
 
     private step = () => {
@@ -478,8 +592,10 @@ export class Sic1Ide extends React.Component<Sic1IdeProperties, Sic1IdeState> {
     }
 
     private runCallback = () => {
-        for (let i = 0; (i < this.stepsPerInterval) && (this.stepRateIndex !== undefined); i++) {
-            this.stepInternal();
+        if (!this.canRunNatively() || !this.runNatively()) {
+            for (let i = 0; (i < this.stepsPerInterval) && (this.stepRateIndex !== undefined); i++) {
+                this.stepInternal();
+            }
         }
     }
 
@@ -671,6 +787,7 @@ export class Sic1Ide extends React.Component<Sic1IdeProperties, Sic1IdeState> {
     }
 
     public reset(puzzle: ClientPuzzle, solutionName: string) {
+        this.discardMemoryUpdates();
         this.setState(Sic1Ide.createEmptyTransientState(this.props.intl, puzzle, solutionName));
         this.setStateFlags(StateFlags.none);
         this.testSetIndex = 0;
@@ -703,6 +820,7 @@ export class Sic1Ide extends React.Component<Sic1IdeProperties, Sic1IdeState> {
 
     public componentWillUnmount() {
         this.setStepRateIndex(undefined);
+        this.discardMemoryUpdates();
         window.removeEventListener("keydown", this.keyDownHandler);
     }
 
@@ -31,6 +31,12 @@ declare const chrome: { webview: { hostObjects: {
             // Manual
             OpenManual: (locale: string) => void;
         },
+        nativeEmulator: {
+            StartRun: (programBytes: number[], input: number[], expectedOutput: number[] | undefined) => void;
+
+            // Returned as a flat array: [stopReason, ip, cyclesExecuted, memoryBytesAccessed, inputIndex, outputCount, ...output, ...memory, ...memoryAccessed]
+            ContinueRun: (breakpoints: number[] | undefined, resumeCycle: number, cycleBudget: number) => number[];
+        },
     },
     options: {
         forceAsyncMethodMatches: RegExp[],
@@ -1,3 +1,4 @@
+import { Constants } from "../../../lib/src/sic1asm";
 import { Achievement } from "./achievements";
 import { localeToHrefOrMessages, localeToManualHref } from "./language-data";
 import { getBestLocale, steamApiLanguageCodeToLocale } from "./language-default";
@@ -59,6 +60,44 @@ class CoalescedFunction {
     }
 }
 
+/** Reasons a native run stopped (matches Sic1::RunStopReason in native/runner.h). */
+export enum NativeRunStopReason {
+    incorrectOutput,
+    halted,
+    completed,
+    breakpoint,
+    cycleLimit,
+}
+
+export interface NativeRunOptions {
+    programBytes: number[];
+    input: number[];
+    expectedOutput?: number[];
+}
+
+export interface NativeRunContinueOptions {
+    breakpoints?: number[];
+
+    /** Breakpoints are ignored until this many cycles have executed (for catching up to a state that was reached by stepping). */
+    resumeCycle: number;
+
+    /** Maximum number of cycles to execute in this call. */
+    cycleBudget: number;
+}
+
+export interface NativeRunResult {
+    reason: NativeRunStopReason;
+    ip: number;
+    cyclesExecuted: number;
+    memoryBytesAccessed: number;
+    inputIndex: number;
+    output: number[];
+    memory: number[];
+
+    /** True for each address that was accessed (memoryBytesAccessed is the number of these). */
+    memoryAccessed: boolean[];
+}
+
 export interface Platform {
     /** Indicates the program should have native app semantics, e.g. it should have an "exit" option in the menu. */
     readonly app: boolean;
@@ -107,13 +146,19 @@ export interface Platform {
 
     /** Used for suppressing achievement notification when windowed for Steam (because Steam UI pops up a notification on the desktop). */
     readonly shouldShowAchievementNotification?: () => boolean;
+
+    /** Starts running a program natively (from the start), replacing any previous native run. */
+    readonly startNativeRun?: (options: NativeRunOptions) => void;
+
+    /** Continues the native run until it halts, completes, fails, hits a breakpoint, or exhausts the cycle budget (continuing past a breakpoint it stopped at). */
+    readonly continueNativeRun?: (options: NativeRunContinueOptions) => NativeRunResult;
 }
 
 const availableLocales = Object.keys(localeToHrefOrMessages);
 
 const createPlatform: Record<PlatformName, () => Platform> = {
     steam: () => {
-        const { steam, webViewWindow } = chrome.webview.hostObjects.sync;
+        const { steam, webViewWindow, nativeEmulator } = chrome.webview.hostObjects.sync;
         const userName = steam.UserName;
 
         // Helpers for saving and restoring localStorage (used for Steam Cloud integration)
@@ -232,6 +277,24 @@ const createPlatform: Record<PlatformName, () => Platform> = {
                 return false;
             },
             shouldShowAchievementNotification: () => webViewWindow.Fullscreen, // Only show when in full-screen
+            startNativeRun: (options) => nativeEmulator.StartRun(options.programBytes, options.input, options.expectedOutput),
+            continueNativeRun: (options) => {
+                const flatArray = nativeEmulator.ContinueRun(options.breakpoints, options.resumeCycle, options.cycleBudget);
+                const [reason, ip, cyclesExecuted, memoryBytesAccessed, inputIndex, outputCount] = flatArray;
+                const outputStart = 6;
+                const memoryStart = outputStart + outputCount;
+                const memoryAccessedStart = memoryStart + Constants.addressMax + 1;
+                return {
+                    reason,
+                    ip,
+                    cyclesExecuted,
+                    memoryBytesAccessed,
+                    inputIndex,
+                    output: flatArray.slice(outputStart, memoryStart),
+                    memory: flatArray.slice(memoryStart, memoryAccessedStart),
+                    memoryAccessed: flatArray.slice(memoryAccessedStart).map(accessed => accessed !== 0),
+                };
+            },
         };
 
         // On exit, provide updated localStorage data for export
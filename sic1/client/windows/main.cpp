@@ -17,6 +17,7 @@
 #include "common.h"
 #include "wvwindow.h"
 #include "promisehandler.h"
+#include "nativeemulator.h"
 
 #ifdef _DEBUG
 #define ENABLE_DEV_TOOLS TRUE
@@ -38,8 +39,9 @@ static TCHAR szWindowClass[] = L"DesktopApp";
 static TCHAR szTitle[] = L"SIC-1";
 static com_ptr<ICoreWebView2Controller> webViewController;
 static com_ptr<ICoreWebView2> webView;
-static com_ptr<ISteam> steam;
+static com_ptr<Steam> steam;
 static com_ptr<WebViewWindow> webViewWindow;
+static com_ptr<INativeEmulator> nativeEmulator;
 static PresentationSettings presentationSettings;
 static critical_section localStorageIOLock;
 static critical_section presentationSettingsIOLock;
@@ -377,7 +379,8 @@ int CALLBACK WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLi
 									}).Get(), nullptr), "Failed to setup window.close() handler!");
 
 								// Expose native wrappers on navigation start
-								steam = Make<Steam>();
+								steam = Make<Steam>(GetDataPath(L"leaderboards.json").get(), GetDataPath(L"uploads.json").get());
+								nativeEmulator = Make<NativeEmulator>();
 								webViewWindow = Make<WebViewWindow>(
 									hWnd,
 									&presentationSettings,
@@ -404,6 +407,7 @@ int CALLBACK WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLi
 											} table[] = {
 												{ L"steam", steam.query<IDispatch>() },
 												{ HOST_OBJECT_WEBVIEWWINDOW_NAME, webViewWindow.query<IDispatch>() },
+												{ HOST_OBJECT_NATIVEEMULATOR_NAME, nativeEmulator.query<IDispatch>() },
 											};
 
 											for (const auto& row : table) {
@@ -481,6 +485,11 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 							SavePresentationSettings(presentationSettings);
 						}
 
+						// Stop Steam calls (whose completions run on the thread pool) before cleaning up the thread pool
+						if (steam) {
+							steam->Stop();
+						}
+
 						// Wait for thread pool tasks to clean up
 						{
 							auto lock = cleanupLock.lock();
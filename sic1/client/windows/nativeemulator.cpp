@@ -0,0 +1,106 @@
+#include "stdafx.h"
+
+#include <bitset>
+#include <optional>
+#include <vector>
+#include <wil/result.h>
+#include "nativeemulator.h"
+#include "utils.h"
+#include "../native/runner.h"
+
+using namespace std;
+using namespace wil;
+
+namespace {
+    // Largest integer that script numbers (doubles) represent exactly (2^53)
+    constexpr double maxExactCycles = 9007199254740992.0;
+
+    // Extracts an array of integers (each within [min, max]); missing arrays are reported as nullopt
+    optional<vector<int>> ToIntegers(const VARIANT& variant, int min, int max) {
+        if (variant.vt == VT_EMPTY || variant.vt == VT_NULL) {
+            return nullopt;
+        }
+
+        THROW_HR_IF(E_INVALIDARG, (variant.vt != (VT_ARRAY | VT_VARIANT)) || (variant.parray->cDims != 1));
+
+        vector<int> values;
+        Ole::SafeArrayAccessor<VARIANT> array(variant.parray);
+        for (size_t i = 0; i < array.Count(); i++) {
+            const VARIANT* element = &array.Get()[i];
+            THROW_HR_IF(E_INVALIDARG, element->vt != VT_I4 || element->lVal > max || element->lVal < min);
+            values.push_back(element->lVal);
+        }
+        return values;
+    }
+
+    vector<int8_t> ToWords(const optional<vector<int>>& values) {
+        return values ? vector<int8_t>(values->begin(), values->end()) : vector<int8_t>();
+    }
+}
+
+STDMETHODIMP NativeEmulator::StartRun(VARIANT programBytes, VARIANT input, VARIANT expectedOutput) try {
+    const optional<vector<int>> program = ToIntegers(programBytes, 0, static_cast<int>(Sic1::Constants::addressMax));
+    THROW_HR_IF(E_INVALIDARG, !program || program->size() > Sic1::Constants::memorySize);
+
+    optional<vector<int8_t>> expectedWords;
+    if (const optional<vector<int>> expected = ToIntegers(expectedOutput, -128, 127)) {
+        expectedWords = ToWords(expected);
+    }
+
+    m_run.emplace(vector<uint8_t>(program->begin(), program->end()), ToWords(ToIntegers(input, -128, 127)), move(expectedWords));
+    return S_OK;
+}
+CATCH_RETURN();
+
+STDMETHODIMP NativeEmulator::ContinueRun(VARIANT breakpoints, DOUBLE resumeCycle, UINT32 cycleBudget, VARIANT* flatArray) try {
+    VariantInit(flatArray);
+    THROW_HR_IF(E_ILLEGAL_METHOD_CALL, !m_run);
+
+    // Cycle counts are passed as doubles (script numbers), so they're only exact up to 2^53
+    THROW_HR_IF(E_INVALIDARG, !(resumeCycle >= 0 && resumeCycle <= maxExactCycles));
+
+    bitset<Sic1::Constants::memorySize> breakpointAddresses;
+    if (const optional<vector<int>> addresses = ToIntegers(breakpoints, 0, static_cast<int>(Sic1::Constants::addressMax))) {
+        for (int address : *addresses) {
+            breakpointAddresses[address] = true;
+        }
+    }
+
+    const Sic1::RunResult result = m_run->Run(breakpointAddresses, static_cast<uint64_t>(resumeCycle), cycleBudget);
+    THROW_HR_IF(E_BOUNDS, result.cyclesExecuted > maxExactCycles);
+
+    // Flatten into [stopReason, ip, cyclesExecuted, memoryBytesAccessed, inputIndex, outputCount, ...output, ...memory,
+    // ...memoryAccessed] (with memoryAccessed as 0 or 1 for each address)
+    // Note: Runs can be continued indefinitely, so values are returned as doubles (since cycle counts and input indices
+    // can exceed 32 bits)
+    vector<double> values = {
+        static_cast<double>(result.reason),
+        static_cast<double>(result.ip),
+        static_cast<double>(result.cyclesExecuted),
+        static_cast<double>(result.memoryBytesAccessed),
+        static_cast<double>(result.inputIndex),
+        static_cast<double>(result.output.size()),
+    };
+
+    values.insert(values.end(), result.output.begin(), result.output.end());
+    values.insert(values.end(), result.memory.begin(), result.memory.end());
+    for (size_t address = 0; address < result.memoryAccessed.size(); address++) {
+        values.push_back(result.memoryAccessed[address] ? 1 : 0);
+    }
+
+    SAFEARRAYBOUND bounds;
+    bounds.lLbound = 0;
+    bounds.cElements = static_cast<ULONG>(values.size());
+    wilx::unique_safearray array = wilx::make_unique_safearray(VT_VARIANT, 1, &bounds);
+    for (LONG index = 0; index < static_cast<LONG>(values.size()); index++) {
+        unique_variant value;
+        value.vt = VT_R8;
+        value.dblVal = values[index];
+        THROW_IF_FAILED(SafeArrayPutElement(array.get(), &index, reinterpret_cast<void*>(&value)));
+    }
+
+    flatArray->vt = VT_ARRAY | VT_VARIANT;
+    flatArray->parray = array.release();
+    return S_OK;
+}
+CATCH_RETURN();
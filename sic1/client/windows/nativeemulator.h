@@ -0,0 +1,21 @@
+#pragma once
+
+#include <optional>
+#include "host-objects_h.h"
+#include "dispatchable.h"
+#include "../native/runner.h"
+
+#define HOST_OBJECT_NATIVEEMULATOR_NAME L"nativeEmulator"
+
+// Exposes the native emulator (client/native/runner.h) so that the IDE can run programs at full speed without
+// stepping (and updating the UI) in script
+class NativeEmulator : public Dispatchable<INativeEmulator> {
+public:
+    // INativeEmulator
+    STDMETHODIMP StartRun(VARIANT programBytes, VARIANT input, VARIANT expectedOutput) override;
+    STDMETHODIMP ContinueRun(VARIANT breakpoints, DOUBLE resumeCycle, UINT32 cycleBudget, VARIANT* flatArray) override;
+
+private:
+    // Note: The IDE only runs one program at a time, so there's a single run, continued once per UI update
+    std::optional<Sic1::RunSession> m_run;
+};
@@ -3,102 +3,121 @@
 
 #define IID_UNK_ARGS(pType) __uuidof(*(pType)), reinterpret_cast<IUnknown*>(pType)
 
-static PTP_POOL threadpool = nullptr;
-static PTP_CLEANUP_GROUP threadpoolCleanupGroup = nullptr;
-static TP_CALLBACK_ENVIRON threadpoolEnvironment = {};
+// Note: Held exclusively only to take the scheduler during cleanup (tasks that are running while it's destroyed may
+// still try to submit more tasks, which are dropped)
+static std::shared_mutex schedulerLock;
+static std::unique_ptr<Sic1::TaskScheduler> scheduler;
 static Promise::CleanupCallback cleanupCallback = nullptr;
 
 void Promise::Initialize() {
-    threadpool = CreateThreadpool(nullptr);
-    THROW_LAST_ERROR_IF_NULL(threadpool);
-    THROW_LAST_ERROR_IF(!SetThreadpoolThreadMinimum(threadpool, 3));
-    SetThreadpoolThreadMaximum(threadpool, 15);
-
-    threadpoolCleanupGroup = CreateThreadpoolCleanupGroup();
-    THROW_LAST_ERROR_IF_NULL(threadpoolCleanupGroup);
-
-    InitializeThreadpoolEnvironment(&threadpoolEnvironment);
-    SetThreadpoolCallbackPool(&threadpoolEnvironment, threadpool);
-    SetThreadpoolCallbackCleanupGroup(&threadpoolEnvironment, threadpoolCleanupGroup, nullptr);
+    // Note: Steam calls don't block (see SteamCallManager), and the client has no long-running computations, so only a
+    // couple of workers are needed for those classes
+    scheduler = std::make_unique<Sic1::TaskScheduler>(Sic1::TaskSchedulerOptions{ { 2, 1, 2, 2 } });
 }
 
-void Promise::RunClosureOnThreadPool(std::unique_ptr<std::function<void()>> pf) {
-    auto callback = [](PTP_CALLBACK_INSTANCE, void* pv, PTP_WORK) {
-        std::unique_ptr<std::function<void()>> pf(reinterpret_cast<std::function<void()>*>(pv));
-        (*(pf.get()))();
-    };
-
-    PTP_WORK workItem = CreateThreadpoolWork(callback, pf.get(), &threadpoolEnvironment);
-    THROW_LAST_ERROR_IF_NULL(workItem);
-
-    SubmitThreadpoolWork(workItem);
-
-    // Ownership of the closure has passed to the thread pool callback
-    pf.release();
+Sic1::TaskScheduler* Promise::TryGetScheduler(std::shared_lock<std::shared_mutex>& lock) {
+    lock = std::shared_lock<std::shared_mutex>(schedulerLock);
+    return scheduler.get();
 }
 
-void Promise::ExecutePromiseOnThreadPool(const VARIANT& resolveVariant, const VARIANT& rejectVariant, std::shared_ptr<Promise::Handler> handler) {
-    THROW_HR_IF(E_INVALIDARG, resolveVariant.vt != VT_DISPATCH || rejectVariant.vt != VT_DISPATCH);
-    IDispatch* resolve = resolveVariant.pdispVal;
-    IDispatch* reject = rejectVariant.pdispVal;
-
-    wil::com_ptr<IStream> resolveStream;
-    wil::com_ptr<IStream> rejectStream;
-
-    THROW_IF_FAILED(CoMarshalInterThreadInterfaceInStream(IID_UNK_ARGS(resolve), &resolveStream));
-    THROW_IF_FAILED(CoMarshalInterThreadInterfaceInStream(IID_UNK_ARGS(reject), &rejectStream));
-
-    RunClosureOnThreadPool(std::make_unique<std::function<void()>>([resolveStream = resolveStream.detach(), rejectStream = rejectStream.detach(), handler]() {
-        try {
-            auto coinit = wil::CoInitializeEx(COINIT_MULTITHREADED);
-            wil::com_ptr<IDispatch> resolve;
-            wil::com_ptr<IDispatch> reject;
-
-            HRESULT hrUnmarshal1 = CoGetInterfaceAndReleaseStream(resolveStream, IID_PPV_ARGS(&resolve));
-            HRESULT hrUnmarshal2 = CoGetInterfaceAndReleaseStream(rejectStream, IID_PPV_ARGS(&reject));
-
-            THROW_IF_FAILED(hrUnmarshal1);
-            THROW_IF_FAILED(hrUnmarshal2);
+namespace {
+    // Promise callbacks, marshaled so that they can be invoked from a thread pool thread
+    class MarshaledCallbacks {
+    public:
+        MarshaledCallbacks(const VARIANT& resolveVariant, const VARIANT& rejectVariant) {
+            THROW_HR_IF(E_INVALIDARG, resolveVariant.vt != VT_DISPATCH || rejectVariant.vt != VT_DISPATCH);
+            IDispatch* resolve = resolveVariant.pdispVal;
+            IDispatch* reject = rejectVariant.pdispVal;
+
+            THROW_IF_FAILED(CoMarshalInterThreadInterfaceInStream(IID_UNK_ARGS(resolve), &m_resolveStream));
+            THROW_IF_FAILED(CoMarshalInterThreadInterfaceInStream(IID_UNK_ARGS(reject), &m_rejectStream));
+        }
 
-            // Run the supplied handler
-            wil::unique_variant result;
-            HRESULT hr = ([&]() -> HRESULT {
+        // Runs the handler (unless hr is already a failure) and then resolves or rejects the promise (on the given class's
+        // workers)
+        static void SettleOnThreadPool(std::shared_ptr<MarshaledCallbacks> callbacks, HRESULT hr, std::shared_ptr<Promise::Handler> handler, Sic1::TaskPriority priority) {
+            Promise::RunOnThreadPool(priority, [callbacks, hr, handler]() {
                 try {
-                    (*handler)(result.addressof());
-                    return S_OK;
+                    auto coinit = wil::CoInitializeEx(COINIT_MULTITHREADED);
+                    wil::com_ptr<IDispatch> resolve;
+                    wil::com_ptr<IDispatch> reject;
+
+                    HRESULT hrUnmarshal1 = CoGetInterfaceAndReleaseStream(callbacks->m_resolveStream.detach(), IID_PPV_ARGS(&resolve));
+                    HRESULT hrUnmarshal2 = CoGetInterfaceAndReleaseStream(callbacks->m_rejectStream.detach(), IID_PPV_ARGS(&reject));
+
+                    THROW_IF_FAILED(hrUnmarshal1);
+                    THROW_IF_FAILED(hrUnmarshal2);
+
+                    // Run the supplied handler
+                    wil::unique_variant result;
+                    HRESULT hrHandler = FAILED(hr) ? hr : ([&]() -> HRESULT {
+                        try {
+                            if (handler && *handler) {
+                                (*handler)(result.addressof());
+                            }
+                            return S_OK;
+                        }
+                        CATCH_RETURN();
+                    })();
+
+                    if (SUCCEEDED(hrHandler)) {
+                        // Handler succeeded; resolve the promise
+                        DISPPARAMS params = { nullptr, nullptr, 0, 0 };
+
+                        if (result.vt != VT_EMPTY) {
+                            params.cArgs = 1;
+                            params.rgvarg = &result;
+                        }
+
+                        THROW_IF_FAILED(resolve->Invoke(DISPID_VALUE, IID_NULL, LOCALE_USER_DEFAULT, DISPATCH_METHOD, &params, nullptr, nullptr, nullptr));
+                    }
+                    else {
+                        // Handler failed; reject the promise
+                        VARIANTARG reason;
+                        VariantInit(&reason);
+                        reason.vt = VT_I4;
+                        reason.lVal = hrHandler;
+
+                        DISPPARAMS params;
+                        params.cArgs = 1;
+                        params.cNamedArgs = 0;
+                        params.rgdispidNamedArgs = nullptr;
+                        params.rgvarg = &reason;
+
+                        THROW_IF_FAILED(reject->Invoke(DISPID_VALUE, IID_NULL, LOCALE_USER_DEFAULT, DISPATCH_METHOD, &params, nullptr, nullptr, nullptr));
+                    }
                 }
-                CATCH_RETURN();
-            })();
+                CATCH_LOG();
+            });
+        }
 
-            if (SUCCEEDED(hr)) {
-                // Handler succeeded; resolve the promise
-                DISPPARAMS params = { nullptr, nullptr, 0, 0 };
+    private:
+        wil::com_ptr<IStream> m_resolveStream;
+        wil::com_ptr<IStream> m_rejectStream;
+    };
+}
 
-                if (result.vt != VT_EMPTY) {
-                    params.cArgs = 1;
-                    params.rgvarg = &result;
-                }
+void Promise::ExecutePromiseOnThreadPool(const VARIANT& resolveVariant, const VARIANT& rejectVariant, std::shared_ptr<Promise::Handler> handler, Sic1::TaskPriority priority) {
+    MarshaledCallbacks::SettleOnThreadPool(std::make_shared<MarshaledCallbacks>(resolveVariant, rejectVariant), S_OK, handler, priority);
+}
 
-                THROW_IF_FAILED(resolve->Invoke(DISPID_VALUE, IID_NULL, LOCALE_USER_DEFAULT, DISPATCH_METHOD, &params, nullptr, nullptr, nullptr));
-            }
-            else {
-                // Handler failed; reject the promise
-                VARIANTARG reason;
-                VariantInit(&reason);
-                reason.vt = VT_I4;
-                reason.lVal = hr;
-
-                DISPPARAMS params;
-                params.cArgs = 1;
-                params.cNamedArgs = 0;
-                params.rgdispidNamedArgs = nullptr;
-                params.rgvarg = &reason;
-
-                THROW_IF_FAILED(reject->Invoke(DISPID_VALUE, IID_NULL, LOCALE_USER_DEFAULT, DISPATCH_METHOD, &params, nullptr, nullptr, nullptr));
-            }
+void Promise::ExecutePromiseAsync(const VARIANT& resolveVariant, const VARIANT& rejectVariant, Promise::AsyncHandler handler) {
+    auto callbacks = std::make_shared<MarshaledCallbacks>(resolveVariant, rejectVariant);
+    Promise::Settle settle = [callbacks](HRESULT hr, Promise::Handler handler) {
+        MarshaledCallbacks::SettleOnThreadPool(callbacks, hr, std::make_shared<Promise::Handler>(std::move(handler)), Sic1::TaskPriority::Interactive);
+    };
+
+    HRESULT hr = ([&]() -> HRESULT {
+        try {
+            handler(settle);
+            return S_OK;
         }
-        CATCH_LOG();
-    }));
+        CATCH_RETURN();
+    })();
+
+    if (FAILED(hr)) {
+        settle(hr, nullptr);
+    }
 }
 
 void Promise::Cleanup(Promise::CleanupCallback onCompleted) {
@@ -106,10 +125,14 @@ void Promise::Cleanup(Promise::CleanupCallback onCompleted) {
 
     cleanupCallback = onCompleted;
     CreateThread(nullptr, 0, [](LPVOID data) -> DWORD {
-        CloseThreadpoolCleanupGroupMembers(threadpoolCleanupGroup, TRUE, nullptr);
-        CloseThreadpoolCleanupGroup(threadpoolCleanupGroup);
-        CloseThreadpool(threadpool);
-        DestroyThreadpoolEnvironment(&threadpoolEnvironment);
+        std::unique_ptr<Sic1::TaskScheduler> stopping;
+        {
+            std::unique_lock<std::shared_mutex> lock(schedulerLock);
+            std::swap(stopping, scheduler);
+        }
+
+        // Note: This waits for running tasks, but skips any that haven't started
+        stopping.reset();
 
         cleanupCallback();
         return 0;
@@ -2,18 +2,47 @@
 
 #include <functional>
 #include <memory>
+#include <shared_mutex>
+#include <utility>
 #include <objbase.h>
 #include <windows.h>
 #include <wil/result.h>
 #include <wil/com.h>
+#include "../native/taskscheduler.h"
 
 namespace Promise {
     using Handler = std::function<void(VARIANT*)>;
     using CleanupCallback = void (*)();
 
+    // Settles a promise (from any thread): rejects it if hr is a failure, otherwise resolves it with the result that
+    // the handler (which is run on the thread pool, and may be null) fills in. Call it exactly once.
+    using Settle = std::function<void(HRESULT hr, Handler handler)>;
+    using AsyncHandler = std::function<void(Settle settle)>;
+
     void Initialize();
-    void RunClosureOnThreadPool(std::unique_ptr<std::function<void()>> pf);
-    void ExecutePromiseOnThreadPool(const VARIANT& resolveVariant, const VARIANT& rejectVariant, std::shared_ptr<Handler> handler);
+
+    // Scheduler that runs closures (and promise handlers) off the UI thread, with separate workers for each class of
+    // task, so that e.g. file persistence never delays settling a promise. Returns null once cleanup has started; the
+    // scheduler can't be destroyed while the returned lock is held.
+    Sic1::TaskScheduler* TryGetScheduler(std::shared_lock<std::shared_mutex>& lock);
+
+    // Note: The task is skipped if the token is canceled before it starts (or if cleanup has already started)
+    template<typename TFunction>
+    void RunOnThreadPool(Sic1::TaskPriority priority, TFunction&& function, Sic1::CancellationToken token = Sic1::CancellationToken()) {
+        std::shared_lock<std::shared_mutex> lock;
+        Sic1::TaskScheduler* scheduler = TryGetScheduler(lock);
+        if (scheduler) {
+            scheduler->Submit(priority, std::forward<TFunction>(function), std::move(token));
+        }
+    }
+
+    // Runs the handler on the given class's workers, and then resolves or rejects the promise
+    void ExecutePromiseOnThreadPool(const VARIANT& resolveVariant, const VARIANT& rejectVariant, std::shared_ptr<Handler> handler, Sic1::TaskPriority priority = Sic1::TaskPriority::Interactive);
+
+    // Runs the handler on the calling thread, to start asynchronous work that settles the promise when it completes
+    // (so no thread pool thread waits for the work); if the handler throws instead, the promise is rejected
+    void ExecutePromiseAsync(const VARIANT& resolveVariant, const VARIANT& rejectVariant, AsyncHandler handler);
+
     void Cleanup(CleanupCallback onCompleted);
 }
 
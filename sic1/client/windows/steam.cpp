@@ -10,11 +10,56 @@
 using namespace std;
 using namespace wil;
 
-Steam::Steam() {
+namespace {
+    // Packs (optional) detail bytes into int32s, for uploading with a leaderboard score
+    std::vector<int> PackDetailBytes(const VARIANT& detailBytes) {
+        std::vector<int> packedBytes;
+        if (detailBytes.vt != VT_EMPTY) {
+            // Check array types and extract into a vector
+            THROW_HR_IF(E_INVALIDARG, (detailBytes.vt != (VT_ARRAY | VT_VARIANT)) || (detailBytes.parray->cDims != 1) || detailBytes.parray->rgsabound[0].cElements > 256);
+
+            // Pack bytes into int32s
+            unsigned int tmp = 0;
+            int tmpIndex = 0;
+            Ole::SafeArrayAccessor<VARIANT> array(detailBytes.parray);
+            for (size_t i = 0; i < array.Count(); i++) {
+                const VARIANT* element = &array.Get()[i];
+                THROW_HR_IF(E_INVALIDARG, element->vt != VT_I4 || element->lVal >= 256 || element->lVal < 0);
+                unsigned char byte = static_cast<unsigned char>(element->lVal);
+                tmp |= (byte << ((tmpIndex++) * 8));
+
+                if (tmpIndex == 4 || i == (array.Count() - 1)) {
+                    int packed = 0;
+                    memcpy(&packed, &tmp, sizeof(int));
+                    packedBytes.push_back(packed);
+                    tmpIndex = 0;
+                    tmp = 0;
+                }
+            }
+        }
+
+        return packedBytes;
+    }
+
+    void SettleScoreChanged(const Promise::Settle& settle, HRESULT hr, bool scoreChanged) {
+        settle(hr, [scoreChanged](VARIANT* result) {
+            result->vt = VT_BOOL;
+            result->boolVal = scoreChanged ? VARIANT_TRUE : VARIANT_FALSE;
+        });
+    }
+}
+
+Steam::Steam(const wchar_t* leaderboardCacheFileName, const wchar_t* uploadQueueFileName)
+    : m_callManager(m_steamApi, leaderboardCacheFileName, uploadQueueFileName) {
+}
+
+void Steam::Stop() {
+    m_callManager.Stop();
 }
 
-SteamLeaderboard_t Steam::GetLeaderboardNativeHandle(unsigned int jsHandle) {
+std::string Steam::GetLeaderboardName(unsigned int jsHandle) {
     auto lock = m_leaderboardHandleMappingLock.Lock();
+    THROW_HR_IF(E_INVALIDARG, jsHandle < 1 || jsHandle > m_leaderboardHandleMapping.size());
     return m_leaderboardHandleMapping[jsHandle - 1];
 }
 
@@ -33,122 +78,102 @@ STDMETHODIMP Steam::get_AppLanguage(BSTR* stringResult) try {
 CATCH_RETURN();
 
 STDMETHODIMP Steam::ResolveGetLeaderboard(VARIANT resolve, VARIANT reject, BSTR leaderboardNameIn) try {
-    wil::shared_bstr leaderboardName(wilx::make_unique_bstr(leaderboardNameIn));
+    const auto name = String::Narrow(leaderboardNameIn);
+
+    Promise::ExecutePromiseAsync(resolve, reject, [this, name](Promise::Settle settle) {
+        auto setResult = [](unsigned int jsHandle) -> Promise::Handler {
+            return [jsHandle](VARIANT* result) {
+                result->vt = VT_UI4;
+                result->ulVal = jsHandle;
+            };
+        };
 
-    Promise::ExecutePromiseOnThreadPool(resolve, reject, std::make_shared<Promise::Handler>(
-        [this, leaderboardName](VARIANT* result)
         {
-            result->vt = VT_UI4;
-            result->ulVal = 0;
+            auto lock = m_leaderboardHandleMappingLock.Lock();
+            const auto existingEntry = m_leaderboardNameToJSHandle.find(name);
+            if (existingEntry != m_leaderboardNameToJSHandle.end()) {
+                settle(S_OK, setResult(existingEntry->second));
+                return;
+            }
+        }
 
-            const auto name = String::Narrow(leaderboardName.get());
+        // Note: This completes immediately if the leaderboard's handle is cached
+        m_callManager.GetLeaderboard(name, [this, name, settle, setResult](HRESULT hr, SteamLeaderboard_t) {
+            if (FAILED(hr)) {
+                settle(hr, nullptr);
+                return;
+            }
 
+            unsigned int jsHandle = 0;
             {
+                // Note: Another lookup for the same leaderboard may have finished first
                 auto lock = m_leaderboardHandleMappingLock.Lock();
                 const auto existingEntry = m_leaderboardNameToJSHandle.find(name);
                 if (existingEntry != m_leaderboardNameToJSHandle.end()) {
-                    result->ulVal = existingEntry->second;
-                    return;
+                    jsHandle = existingEntry->second;
+                }
+                else {
+                    m_leaderboardHandleMapping.push_back(name);
+                    jsHandle = static_cast<unsigned int>(m_leaderboardHandleMapping.size());
+                    m_leaderboardNameToJSHandle[name] = jsHandle;
                 }
             }
 
-            const auto nativeHandle = m_callManager.GetLeaderboard(name.c_str());
-
-            {
-                auto lock = m_leaderboardHandleMappingLock.Lock();
-                m_leaderboardHandleMapping.push_back(nativeHandle);
-                const unsigned int jsHandle = static_cast<unsigned int>(m_leaderboardHandleMapping.size());
-
-                m_leaderboardNameToJSHandle[name] = jsHandle;
-                result->ulVal = jsHandle;
-            }
-        }
-    ));
+            settle(S_OK, setResult(jsHandle));
+        });
+    });
     return S_OK;
 }
 CATCH_RETURN();
 
-STDMETHODIMP Steam::ResolveSetLeaderboardEntry(VARIANT resolve, VARIANT reject, UINT32 jsHandle, INT32 score, VARIANT detailBytesIn) try {
-    std::shared_ptr<wil::unique_variant> detailBytes = std::make_shared<wil::unique_variant>();
-    THROW_IF_FAILED(VariantCopy(detailBytes->addressof(), &detailBytesIn));
-
-    Promise::ExecutePromiseOnThreadPool(resolve, reject, std::make_shared<Promise::Handler>(
-        [this, jsHandle, score, detailBytes](VARIANT* result)
-        {
-            result->vt = VT_BOOL;
-            result->boolVal = VARIANT_FALSE;
-
-            // Note: Details are optional!
-            int* details = nullptr;
-            int detailsSize = 0;
-
-            std::vector<int> packedBytes;
-            if (detailBytes->vt != VT_EMPTY) {
-                // Check array types and extract into a vector
-                THROW_HR_IF(E_INVALIDARG, (detailBytes->vt != (VT_ARRAY | VT_VARIANT)) || (detailBytes->parray->cDims != 1) || detailBytes->parray->rgsabound[0].cElements > 256);
-
-                // Pack bytes into int32s
-                unsigned int tmp = 0;
-                int tmpIndex = 0;
-                Ole::SafeArrayAccessor<VARIANT> array(detailBytes->parray);
-                for (size_t i = 0; i < array.Count(); i++) {
-                    const VARIANT* element = &array.Get()[i];
-                    THROW_HR_IF(E_INVALIDARG, element->vt != VT_I4 || element->lVal >= 256 || element->lVal < 0);
-                    unsigned char byte = static_cast<unsigned char>(element->lVal);
-                    tmp |= (byte << ((tmpIndex++) * 8));
-
-                    if (tmpIndex == 4 || i == (array.Count() - 1)) {
-                        int packed = 0;
-                        memcpy(&packed, &tmp, sizeof(int));
-                        packedBytes.push_back(packed);
-                        tmpIndex = 0;
-                        tmp = 0;
-                    }
-                }
-
-                details = packedBytes.data();
-                detailsSize = static_cast<int>(packedBytes.size());
-            }
-
-            SteamLeaderboard_t nativeHandle = GetLeaderboardNativeHandle(jsHandle);
-            result->boolVal = m_callManager.SetLeaderboardEntry(nativeHandle, score, details, detailsSize) ? VARIANT_TRUE : VARIANT_FALSE;
+STDMETHODIMP Steam::ResolveSetLeaderboardEntry(VARIANT resolve, VARIANT reject, UINT32 jsHandle, INT32 score, VARIANT detailBytes) try {
+    Promise::ExecutePromiseAsync(resolve, reject, [this, jsHandle, score, &detailBytes](Promise::Settle settle) {
+        // Scores that can't beat the user's best score are skipped (without even packing their details)
+        const std::string name = GetLeaderboardName(jsHandle);
+        if (!m_callManager.IsLeaderboardEntryNeeded(name, score)) {
+            SettleScoreChanged(settle, S_OK, false);
+            return;
         }
-    ));
+
+        m_callManager.SetLeaderboardEntry(name, score, PackDetailBytes(detailBytes), [settle](HRESULT hr, bool scoreChanged) {
+            SettleScoreChanged(settle, hr, scoreChanged);
+        });
+    });
     return S_OK;
 }
 CATCH_RETURN();
 
 STDMETHODIMP Steam::ResolveGetFriendLeaderboardEntries(VARIANT resolve, VARIANT reject, UINT32 jsHandle) try {
-    Promise::ExecutePromiseOnThreadPool(resolve, reject, std::make_shared<Promise::Handler>(
-        [this, jsHandle](VARIANT* flatArray)
-        {
-            SteamLeaderboard_t nativeHandle = GetLeaderboardNativeHandle(jsHandle);
-            auto rows = m_callManager.GetFriendLeaderboardEntries(nativeHandle);
-
-            SAFEARRAYBOUND bounds;
-            bounds.lLbound = 0;
-            bounds.cElements = 2 * static_cast<ULONG>(rows.size());
-            wilx::unique_safearray array = wilx::make_unique_safearray(VT_VARIANT, 1, &bounds);
-            LONG index = 0;
-            for (const auto& row : rows) {
-                // Create an array for this row and fill in the values [name, score]
-                unique_variant name;
-                name.bstrVal = wilx::make_unique_bstr(String::Widen(row.name.c_str()).c_str()).release();
-                name.vt = VT_BSTR;
-                THROW_IF_FAILED(SafeArrayPutElement(array.get(), &index, reinterpret_cast<void*>(&name)));
-                ++index;
-
-                unique_variant score;
-                score.vt = VT_I4;
-                score.lVal = row.score;
-                THROW_IF_FAILED(SafeArrayPutElement(array.get(), &index, reinterpret_cast<void*>(&score)));
-                ++index;
-            }
+    Promise::ExecutePromiseAsync(resolve, reject, [this, jsHandle](Promise::Settle settle) {
+        // Note: Cached rows are delivered immediately (and refreshed afterwards, if they're stale)
+        m_callManager.GetFriendLeaderboardEntries(GetLeaderboardName(jsHandle), [settle](HRESULT hr, std::vector<Sic1::FriendLeaderboardRow> rows) {
+            // Note: The result array is built on the thread pool, rather than on the callback pump's thread
+            settle(hr, [rows = std::move(rows)](VARIANT* flatArray) {
+                SAFEARRAYBOUND bounds;
+                bounds.lLbound = 0;
+                bounds.cElements = 2 * static_cast<ULONG>(rows.size());
+                wilx::unique_safearray array = wilx::make_unique_safearray(VT_VARIANT, 1, &bounds);
+                LONG index = 0;
+                for (const auto& row : rows) {
+                    // Create an array for this row and fill in the values [name, score]
+                    unique_variant name;
+                    name.bstrVal = wilx::make_unique_bstr(String::Widen(row.name.c_str()).c_str()).release();
+                    name.vt = VT_BSTR;
+                    THROW_IF_FAILED(SafeArrayPutElement(array.get(), &index, reinterpret_cast<void*>(&name)));
+                    ++index;
+
+                    unique_variant score;
+                    score.vt = VT_I4;
+                    score.lVal = row.score;
+                    THROW_IF_FAILED(SafeArrayPutElement(array.get(), &index, reinterpret_cast<void*>(&score)));
+                    ++index;
+                }
 
-            flatArray->vt = VT_ARRAY | VT_VARIANT;
-            flatArray->parray = array.release();
-        }
-    ));
+                flatArray->vt = VT_ARRAY | VT_VARIANT;
+                flatArray->parray = array.release();
+            });
+        });
+    });
 
     return S_OK;
 }
@@ -176,7 +201,7 @@ STDMETHODIMP Steam::ResolveStoreAchievements(VARIANT resolve, VARIANT reject) tr
         {
             m_callManager.StoreAchievements();
         }
-    ));
+    ), Sic1::TaskPriority::Network);
     return S_OK;
 }
 CATCH_RETURN();
@@ -9,10 +9,15 @@
 #include "utils.h"
 #include "host-objects_h.h"
 #include "steamcallmanager.h"
+#include "steamworksapi.h"
 
 class Steam : public Dispatchable<ISteam> {
 public:
-    Steam();
+    // Note: Leaderboards are cached in the given file, and scores that haven't been uploaded yet are saved in the other
+    Steam(const wchar_t* leaderboardCacheFileName, const wchar_t* uploadQueueFileName);
+
+    // Stops all Steam calls (see SteamCallManager::Stop); must be called before Promise::Cleanup
+    void Stop();
 
     STDMETHODIMP get_UserName(BSTR* stringResult) override;
     STDMETHODIMP get_AppLanguage(BSTR* stringResult) override;
@@ -26,13 +31,15 @@ public:
     STDMETHODIMP ResolveStoreAchievements(VARIANT resolve, VARIANT reject);
 
 private:
+    SteamworksApi m_steamApi;
     SteamCallManager m_callManager;
 
     // Steam Leaderboard handles are uint64, so map them to small numbers for use in JavaScript (where the number type
-    // is a double). The JavaScript-side handles are just the offset+1 in m_leaderboardHandleMapping.
+    // is a double). The JavaScript-side handles are just the offset+1 in m_leaderboardHandleMapping, which holds the
+    // leaderboard's name (since that's how SteamCallManager identifies leaderboards).
     Sync::CriticalSection m_leaderboardHandleMappingLock;
-    std::vector<SteamLeaderboard_t> m_leaderboardHandleMapping;
+    std::vector<std::string> m_leaderboardHandleMapping;
     std::map<std::string, unsigned int> m_leaderboardNameToJSHandle;
 
-    SteamLeaderboard_t GetLeaderboardNativeHandle(unsigned int jsHandle);
+    std::string GetLeaderboardName(unsigned int jsHandle);
 };
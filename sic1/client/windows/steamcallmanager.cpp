@@ -1,156 +1,136 @@
 #include "stdafx.h"
 
+#include <utility>
 #include <wil/result.h>
-#include "steam/isteamfriends.h"
 #include "steamcallmanager.h"
-#include "common.h"
+#include "promisehandler.h"
 
-DWORD WINAPI SteamCallManager_ThreadEntryPoint(void* data) try {
-    SteamCallManager* steamManager = reinterpret_cast<SteamCallManager*>(data);
-    steamManager->RunThread();
-    return 0;
+namespace {
+    HRESULT GetCallResultHResult(Sic1::SteamCallType type, Sic1::SteamCallStatus status) {
+        switch (status) {
+        case Sic1::SteamCallStatus::Succeeded:
+            return S_OK;
+
+        case Sic1::SteamCallStatus::IoFailed:
+            return HRESULT_FROM_WIN32(ERROR_NETWORK_NOT_AVAILABLE);
+
+        case Sic1::SteamCallStatus::Failed:
+            return (type == Sic1::SteamCallType::FindLeaderboard) ? HRESULT_FROM_WIN32(ERROR_NOT_FOUND) : E_FAIL;
+
+        default:
+            return E_ABORT;
+        }
+    }
 }
-CATCH_RETURN();
-
-SteamCallManager::SteamCallManager()
-    : m_achievementsInitialized(false),
-    m_callbackUserStatsReceived(this, &SteamCallManager::OnUserStatsReceived),
-    m_callbackUserStatsStored(this, &SteamCallManager::OnUserStatsStored),
-    m_callbackAchievementStored(this, &SteamCallManager::OnAchievementStored),
-    m_getLeaderboard(this,
-        [](const char* name) -> SteamAPICall_t {
-            return SteamUserStats()->FindLeaderboard(name);
-        },
-        [](LeaderboardFindResult_t* result, GetLeaderboardState* state) -> void {
-            if (!result->m_bLeaderboardFound) {
-                state->hr = HRESULT_FROM_WIN32(ERROR_NOT_FOUND);
-            }
-            else {
-                state->data = result->m_hSteamLeaderboard;
-            }
-        }),
-    m_getFriendLeaderboardEntries(this,
-        [](SteamLeaderboard_t nativeHandle) -> SteamAPICall_t {
-            return SteamUserStats()->DownloadLeaderboardEntries(nativeHandle, k_ELeaderboardDataRequestFriends, 0, 0);
-        },
-        [](LeaderboardScoresDownloaded_t* result, GetFriendLeaderboardEntriesState* state) -> void {
-            auto stats = SteamUserStats();
-            auto friends = SteamFriends();
-            for (int i = 0; i < result->m_cEntryCount; i++) {
-                LeaderboardEntry_t entry;
-                THROW_HR_IF(E_FAIL, !stats->GetDownloadedLeaderboardEntry(result->m_hSteamLeaderboardEntries, i, &entry, nullptr, 0));
-                state->data.push_back({ friends->GetFriendPersonaName(entry.m_steamIDUser), entry.m_nScore });
-            }
-        }),
-    m_setLeaderboardEntry(this,
-        [](SteamLeaderboard_t nativeHandle, int score, const int* scoreDetails, int scoreDetailsCount) -> SteamAPICall_t {
-            return SteamUserStats()->UploadLeaderboardScore(nativeHandle, k_ELeaderboardUploadScoreMethodKeepBest, score, scoreDetails, scoreDetailsCount);
-        },
-        [](LeaderboardScoreUploaded_t* result, SetLeaderboardEntryState* state) -> void {
-            if (result->m_bSuccess) {
-                state->data = result->m_bScoreChanged;
-            }
-            else {
-                state->hr = E_FAIL;
-            }
-        })
+
+SteamCallManager::SteamCallManager(Sic1::SteamApi& api, std::wstring cacheFileName, std::wstring uploadQueueFileName)
+    : m_api(api),
+    m_achievementsInitialized(false),
+    m_cacheFileName(std::move(cacheFileName)),
+    m_cacheSavePending(false),
+    m_leaderboards(m_pump, m_cache, [this]() { Save(m_cacheSavePending, m_cacheFileName, [this]() { return m_cache.Format(); }); }),
+    m_uploadQueueFileName(std::move(uploadQueueFileName)),
+    m_uploadQueueSavePending(false),
+    m_uploadQueue(m_leaderboards, [this]() { Save(m_uploadQueueSavePending, m_uploadQueueFileName, [this]() { return m_uploadQueue.Format(); }); }),
+    m_pump(api, nullptr)
 {
-    m_thread.reset(CreateThread(nullptr, 0, &SteamCallManager_ThreadEntryPoint, reinterpret_cast<void*>(this), CREATE_SUSPENDED, nullptr));
-    THROW_LAST_ERROR_IF_NULL(m_thread.get());
-    THROW_LAST_ERROR_IF(ResumeThread(m_thread.get()) == -1);
+    // Load the cache from the previous session (if it can't be loaded, everything will just be looked up again)
+    std::wstring cacheText;
+    if (File::TryReadAllTextUtf8(m_cacheFileName.c_str(), cacheText)) {
+        try {
+            m_cache.Parse(String::Narrow(cacheText.c_str()));
+        }
+        CATCH_LOG();
+    }
 
     // Kick off user stats request (to initialize achievements)
-    if (SteamUserStats()->RequestCurrentStats()) {
-        // Should get a OnUserStatsReceived callback
-        IncrementOutstandingCallCount();
+    m_pump.Start(Sic1::SteamCallType::RequestCurrentStats, [](Sic1::SteamApi& steam) { return steam.RequestCurrentStats(); }, [this](const Sic1::SteamCallResult& result) {
+        if (result.status == Sic1::SteamCallStatus::Succeeded) {
+            m_achievementsInitialized = true;
+        }
+    });
+
+    // Look up every puzzle's leaderboards at once (refreshing any cached handles)
+    m_leaderboards.Prefetch(Sic1::GetPuzzleLeaderboardNames());
+
+    // Upload any scores left over from the previous session (e.g. if it was offline)
+    std::wstring uploadQueueText;
+    if (File::TryReadAllTextUtf8(m_uploadQueueFileName.c_str(), uploadQueueText)) {
+        try {
+            m_uploadQueue.Parse(String::Narrow(uploadQueueText.c_str()));
+        }
+        CATCH_LOG();
     }
 }
 
 SteamCallManager::~SteamCallManager() {
-    // Note: The thread pool threads that call into these functions are generally cleaned up in main.cpp, so there
-    // probably won't be any outstanding calls here
-
-    m_shutdown.Signal();
-    DWORD result = WaitForSingleObject(m_thread.get(), INFINITE);
-    THROW_LAST_ERROR_IF(result == WAIT_FAILED);
-
-    DWORD threadResult;
-    THROW_LAST_ERROR_IF(!GetExitCodeThread(m_thread.get(), &threadResult));
-    THROW_IF_FAILED(static_cast<HRESULT>(threadResult));
+    Stop();
 }
 
-unsigned int SteamCallManager::GetOutstandingCallCount() {
-    return m_outstandingCalls.Get();
-}
+void SteamCallManager::Stop() {
+    if (m_saveCancellation.IsCanceled()) {
+        return;
+    }
 
-void SteamCallManager::IncrementOutstandingCallCount() {
-    if (m_outstandingCalls.Increment() == 1) {
-        // First outstanding call; kick off processing now
-        m_startProcessing.Signal();
+    // Outstanding uploads are aborted when the pump is stopped, so save them (for the next launch) once nothing else
+    // can change the queue
+    m_uploadQueue.Stop();
+    m_saveCancellation.Cancel();
+    m_pump.Stop();
+    try {
+        auto lock = m_fileLock.Lock();
+        File::TryWriteAllTextUtf8(m_uploadQueueFileName.c_str(), String::Widen(m_uploadQueue.Format().c_str()).c_str());
     }
+    CATCH_LOG();
 }
 
-void SteamCallManager::DecrementOutstandingCallCount() {
-    m_outstandingCalls.Decrement();
-}
+void SteamCallManager::Save(std::atomic<bool>& savePending, const std::wstring& fileName, std::function<std::string()> format) {
+    if (m_saveCancellation.IsCanceled() || savePending.exchange(true)) {
+        return;
+    }
 
-void SteamCallManager::RunThread() {
-    while (true) {
-        std::vector<HANDLE> handles;
-        handles.push_back(m_startProcessing.Get());
-        handles.push_back(m_shutdown.Get());
-        unsigned int signalledIndex = Sync::AutoResetEvent::WaitForAny(handles);
-        if (signalledIndex == 1) {
-            // Shutdown
-            break;
+    Promise::RunOnThreadPool(Sic1::TaskPriority::Io, [this, &savePending, &fileName, format = std::move(format)]() {
+        try {
+            auto lock = m_fileLock.Lock();
+            savePending = false;
+            File::TryWriteAllTextUtf8(fileName.c_str(), String::Widen(format().c_str()).c_str());
         }
-        else {
-            // Start processing
-            while (true) {
-                SteamAPI_RunCallbacks();
-                if (GetOutstandingCallCount() <= 0) {
-                    break;
-                }
-                Sleep(SteamCallManager::pollingPeriodMS);
-            }
-        }
-    }
+        CATCH_LOG();
+    }, m_saveCancellation.GetToken());
 }
 
-SteamLeaderboard_t SteamCallManager::GetLeaderboard(const char* name) {
-    return m_getLeaderboard.Call(name);
+bool SteamCallManager::IsLeaderboardEntryNeeded(const std::string& name, int score) const {
+    return m_uploadQueue.IsUploadNeeded(name, score);
 }
 
-std::vector<FriendLeaderboardRow> SteamCallManager::GetFriendLeaderboardEntries(SteamLeaderboard_t nativeHandle) {
-    return m_getFriendLeaderboardEntries.Call(nativeHandle);
+void SteamCallManager::GetLeaderboard(const std::string& name, Completion<SteamLeaderboard_t> completion) {
+    m_leaderboards.GetLeaderboard(name, [completion = std::move(completion)](Sic1::SteamCallStatus status, Sic1::SteamLeaderboardHandle leaderboard) {
+        completion(GetCallResultHResult(Sic1::SteamCallType::FindLeaderboard, status), leaderboard);
+    });
 }
 
-bool SteamCallManager::SetLeaderboardEntry(SteamLeaderboard_t nativeHandle, int score, const int* scoreDetails, int scoreDetailsCount) {
-    return m_setLeaderboardEntry.Call(nativeHandle, score, scoreDetails, scoreDetailsCount);
+void SteamCallManager::GetFriendLeaderboardEntries(const std::string& name, Completion<std::vector<Sic1::FriendLeaderboardRow>> completion) {
+    m_leaderboards.GetFriendLeaderboardEntries(name, [completion = std::move(completion)](Sic1::SteamCallStatus status, const std::vector<Sic1::FriendLeaderboardRow>& rows) {
+        completion(GetCallResultHResult(Sic1::SteamCallType::DownloadFriendLeaderboardEntries, status), rows);
+    });
 }
 
-bool SteamCallManager::GetAchievement(const char* achievementId) {
-    auto userStats = SteamUserStats();
-    bool achieved = false;
-
-    THROW_HR_IF_NULL(E_UNEXPECTED, userStats);
-    THROW_HR_IF(E_FAIL, !userStats->GetAchievement(achievementId, &achieved));
+void SteamCallManager::SetLeaderboardEntry(const std::string& name, int score, const std::vector<int>& scoreDetails, Completion<bool> completion) {
+    m_uploadQueue.Upload(name, score, scoreDetails, [completion = std::move(completion)](Sic1::SteamCallStatus status, bool scoreChanged) {
+        completion(GetCallResultHResult(Sic1::SteamCallType::UploadLeaderboardScore, status), scoreChanged);
+    });
+}
 
-    return achieved;
+bool SteamCallManager::GetAchievement(const char* achievementId) {
+    return m_api.GetAchievement(achievementId);
 }
 
 bool SteamCallManager::SetAchievement(const char* achievementId) {
-    auto userStats = SteamUserStats();
-    bool achieved = false;
-
-    THROW_HR_IF_NULL(E_UNEXPECTED, userStats);
-    THROW_HR_IF(E_FAIL, !userStats->GetAchievement(achievementId, &achieved));
-
-    if (achieved) {
+    if (m_api.GetAchievement(achievementId)) {
         return false;
     }
     else {
-        THROW_HR_IF(E_FAIL, !userStats->SetAchievement(achievementId));
+        m_api.SetAchievement(achievementId);
         return true;
 
         // Make sure to call StoreAchievements eventually!
@@ -158,29 +138,10 @@ bool SteamCallManager::SetAchievement(const char* achievementId) {
 }
 
 void SteamCallManager::StoreAchievements() {
-    auto userStats = SteamUserStats();
-    THROW_HR_IF_NULL(E_UNEXPECTED, userStats);
-    THROW_HR_IF(E_FAIL, !userStats->StoreStats());
-
-    // Should get OnUserStatsStored callback. OnAchievementStored is only hit if the achievement was newly achieved.
-    IncrementOutstandingCallCount();
-}
-
-void SteamCallManager::OnUserStatsReceived(UserStatsReceived_t* data) {
-    if (!m_achievementsInitialized && data->m_nGameID == c_steamAppId) {
-        DecrementOutstandingCallCount();
-        if (data->m_eResult == k_EResultOK) {
-            m_achievementsInitialized = true;
-        }
-    }
-
-}
-
-void SteamCallManager::OnUserStatsStored(UserStatsStored_t* data) {
-    if (data->m_nGameID == c_steamAppId) {
-        DecrementOutstandingCallCount();
-    }
+    // Note: This doesn't wait for the stats to be stored
+    m_pump.Start(Sic1::SteamCallType::StoreStats, [](Sic1::SteamApi& steam) { return steam.StoreStats(); });
 }
 
-void SteamCallManager::OnAchievementStored(UserAchievementStored_t* data) {
+Sic1::LatencyHistogram SteamCallManager::GetLatencyHistogram(Sic1::SteamCallType type) const {
+    return m_pump.GetLatencyHistogram(type);
 }
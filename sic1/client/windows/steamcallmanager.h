@@ -1,137 +1,78 @@
 #pragma once
 
-#include <vector>
+#include <atomic>
 #include <functional>
-#include <wil/resource.h>
+#include <string>
+#include <vector>
 #include <steam/steam_api.h>
-#include "steam/isteamuserstats.h"
 #include "utils.h"
-
-class SteamCallManager;
-
-// Helper class for serializing a specific Steam API call that returns a Call Result
-template<typename TSteamResult, typename TState, typename TResult, typename ...TArgs>
-class SteamCall {
-public:
-    SteamCall(SteamCallManager* parent, std::function<SteamAPICall_t(TArgs...)> start, std::function<void(TSteamResult*, TState*)> translateResult)
-        : m_parent(parent), m_start(start), m_translateResult(translateResult), m_state(nullptr) {
-    }
-
-    ~SteamCall() {
-        // Note: This isn't meticulously synchronized and doesn't update the outstanding call count because
-        // SteamAPI_RunCallbacks won't be called again in the caller anyway
-        if (m_state != nullptr) {
-            m_state->hr = E_ABORT;
-        }
-        m_completed.Signal();
-    }
-
-    // (Hopefully) Thread-safe, serialized, synchronous call to Steam API
-    TResult Call(TArgs...args) {
-        auto lock = m_lock.Lock();
-
-        SteamAPICall_t call = m_start(args...);
-        auto state = std::make_unique<TState>();
-        m_state = state.get();
-
-        m_callResult.Set(call, this, &SteamCall<TSteamResult, TState, TResult, TArgs...>::OnCallback);
-        m_parent->IncrementOutstandingCallCount();
-        m_completed.Wait();
-
-        THROW_IF_FAILED(state->hr);
-
-        return state->data;
-    }
-
-private:
-    // Call result callback
-    void OnCallback(TSteamResult* result, bool ioFailed) {
-        auto onScopeExit = wil::scope_exit([&] {
-            m_parent->DecrementOutstandingCallCount();
-            m_completed.Signal();
-        });
-
-        if (ioFailed) {
-            m_state->hr = HRESULT_FROM_WIN32(ERROR_NETWORK_NOT_AVAILABLE);
-            return;
-        }
-
-        m_state->hr = S_OK;
-        m_translateResult(result, m_state);
-    }
-
-    SteamCallManager* m_parent;
-
-    // Functions for calling the Steam API and processing the result
-    std::function<SteamAPICall_t(TArgs...)> m_start;
-    std::function<void(TSteamResult*, TState*)> m_translateResult;
-
-    // Synchronization and state
-    Sync::CriticalSection m_lock;
-    CCallResult<SteamCall<TSteamResult, TState, TResult, TArgs...>, TSteamResult> m_callResult;
-    TState* m_state;
-    Sync::AutoResetEvent m_completed;
-};
-
-typedef struct {
-    HRESULT hr;
-    SteamLeaderboard_t data;
-} GetLeaderboardState;
-
-typedef struct {
-    HRESULT hr;
-    bool data;
-} SetLeaderboardEntryState;
-
-typedef struct {
-    std::string name;
-    int score;
-} FriendLeaderboardRow;
-
-typedef struct {
-    HRESULT hr;
-    std::vector<FriendLeaderboardRow> data;
-} GetFriendLeaderboardEntriesState;
-
+#include "../native/leaderboardcache.h"
+#include "../native/leaderboarduploadqueue.h"
+#include "../native/steamapi.h"
+#include "../native/steamleaderboards.h"
+#include "../native/steampump.h"
+#include "../native/taskscheduler.h"
+
+// Asynchronous Steam calls: any number of calls (including several of the same type) can be outstanding at once, and
+// each call's completion is run on the callback pump's thread when its result arrives (so completions should be quick).
+//
+// Leaderboards are identified by name. Their handles and friend leaderboard rows are cached (and persisted to a file),
+// and every puzzle's leaderboard handles are looked up on startup, so leaderboards can usually be shown immediately.
+// Scores are uploaded through a persisted queue that drops scores that can't beat the user's best score, coalesces
+// bursts of scores, and retries uploads that failed while offline (including on the next launch).
 class SteamCallManager {
 public:
-    const DWORD pollingPeriodMS = 200;
+    // Receives a call's result, or a failure HRESULT if the call failed
+    template<typename TResult>
+    using Completion = std::function<void(HRESULT hr, TResult result)>;
 
-    SteamCallManager();
+    SteamCallManager(Sic1::SteamApi& api, std::wstring cacheFileName, std::wstring uploadQueueFileName);
+
+    // Note: Saves any scores that haven't been uploaded yet
     ~SteamCallManager();
 
-    // Called by SteamCall<...> helpers
-    unsigned int GetOutstandingCallCount();
-    void IncrementOutstandingCallCount();
-    void DecrementOutstandingCallCount();
+    // Stops uploading, saving, and polling for results (aborting outstanding calls), and saves any scores that haven't
+    // been uploaded yet. Call this before the thread pool is cleaned up (see Promise::Cleanup), since completions and
+    // saves run on it. Safe to call more than once.
+    void Stop();
 
-    // SteamCallManager thread function
-    void RunThread();
+    // True if the score could beat the user's best score (otherwise SetLeaderboardEntry just drops it)
+    bool IsLeaderboardEntryNeeded(const std::string& name, int score) const;
 
-    // Synchronous (serialized) calls
-    SteamLeaderboard_t GetLeaderboard(const char* name);
-    std::vector<FriendLeaderboardRow> GetFriendLeaderboardEntries(SteamLeaderboard_t nativeHandle);
-    bool SetLeaderboardEntry(SteamLeaderboard_t nativeHandle, int score, const int* scoreDetails, int scoreDetailsCount);
+    // Asynchronous calls (completions are run on the calling thread if the result is cached or the call couldn't be
+    // started)
+    void GetLeaderboard(const std::string& name, Completion<SteamLeaderboard_t> completion);
+    void GetFriendLeaderboardEntries(const std::string& name, Completion<std::vector<Sic1::FriendLeaderboardRow>> completion);
+    void SetLeaderboardEntry(const std::string& name, int score, const std::vector<int>& scoreDetails, Completion<bool> completion);
 
     // Achievements
     bool GetAchievement(const char* achievementId);
     bool SetAchievement(const char* achievementId);
     void StoreAchievements();
 
-    STEAM_CALLBACK(SteamCallManager, OnUserStatsReceived, UserStatsReceived_t, m_callbackUserStatsReceived);
-    STEAM_CALLBACK(SteamCallManager, OnUserStatsStored, UserStatsStored_t, m_callbackUserStatsStored);
-    STEAM_CALLBACK(SteamCallManager, OnAchievementStored, UserAchievementStored_t, m_callbackAchievementStored);
+    // Round-trip latency (from starting a call to receiving its result) for each type of call
+    Sic1::LatencyHistogram GetLatencyHistogram(Sic1::SteamCallType type) const;
 
 private:
-    wil::unique_handle m_thread;
-    Sync::AutoResetEvent m_shutdown;
-
-    Sync::ThreadSafeCounter m_outstandingCalls;
-    Sync::AutoResetEvent m_startProcessing;
+    // Writes formatted text to a file (on the I/O workers, coalescing bursts of changes)
+    void Save(std::atomic<bool>& savePending, const std::wstring& fileName, std::function<std::string()> format);
 
+    Sic1::SteamApi& m_api;
     bool m_achievementsInitialized;
 
-    SteamCall<LeaderboardFindResult_t, GetLeaderboardState, SteamLeaderboard_t, const char*> m_getLeaderboard;
-    SteamCall<LeaderboardScoresDownloaded_t, GetFriendLeaderboardEntriesState, std::vector<FriendLeaderboardRow>, SteamLeaderboard_t> m_getFriendLeaderboardEntries;
-    SteamCall<LeaderboardScoreUploaded_t, SetLeaderboardEntryState, bool, SteamLeaderboard_t, int, const int*, int> m_setLeaderboardEntry;
+    // Note: Canceled when stopping, so that queued saves are skipped
+    Sic1::CancellationSource m_saveCancellation;
+    Sync::CriticalSection m_fileLock;
+
+    const std::wstring m_cacheFileName;
+    std::atomic<bool> m_cacheSavePending;
+    Sic1::LeaderboardCache m_cache;
+    Sic1::SteamLeaderboards m_leaderboards;
+
+    const std::wstring m_uploadQueueFileName;
+    std::atomic<bool> m_uploadQueueSavePending;
+    Sic1::LeaderboardUploadQueue m_uploadQueue;
+
+    // Note: This is last so that the pump (and its thread) are stopped before anything else is destroyed
+    Sic1::SteamCallbackPump m_pump;
 };
@@ -0,0 +1,169 @@
+#include "stdafx.h"
+
+#include <wil/result.h>
+#include "steam/isteamfriends.h"
+#include "steamworksapi.h"
+#include "common.h"
+
+using namespace std;
+
+namespace {
+    constexpr Sic1::SteamCallHandle callbackHandleFlag = 0x8000000000000000ull;
+}
+
+SteamworksApi::SteamworksApi()
+    : m_callbackUserStatsReceived(this, &SteamworksApi::OnUserStatsReceived),
+    m_callbackUserStatsStored(this, &SteamworksApi::OnUserStatsStored),
+    m_nextCallbackHandle(callbackHandleFlag | 1) {
+}
+
+void SteamworksApi::SetResultHandler(ResultHandler handler) {
+    auto lock = m_lock.Lock();
+    m_handler = std::move(handler);
+}
+
+void SteamworksApi::RunCallbacks() {
+    vector<pair<Sic1::SteamCallHandle, Sic1::SteamCallResult>> results;
+    ResultHandler handler;
+    {
+        // Note: Calls are started while holding the lock, so their call results are always registered by now
+        auto lock = m_lock.Lock();
+        SteamAPI_RunCallbacks();
+        m_finishedCalls.clear();
+        results.swap(m_completedResults);
+        handler = m_handler;
+    }
+
+    // Note: Results are delivered without holding the lock, so handlers can start more calls
+    if (handler) {
+        for (const auto& [call, result] : results) {
+            handler(call, result);
+        }
+    }
+}
+
+template<typename TSteamResult>
+Sic1::SteamCallHandle SteamworksApi::Start(Sic1::SteamCallType type, SteamAPICall_t call, std::function<void(TSteamResult*, Sic1::SteamCallResult*)> translateResult) {
+    if (call == k_uAPICallInvalid) {
+        return Sic1::steamCallHandleInvalid;
+    }
+
+    auto pendingCall = std::make_unique<PendingCallResult<TSteamResult>>(this, type, translateResult);
+    pendingCall->Set(call);
+    m_pendingCalls[call] = std::move(pendingCall);
+    return call;
+}
+
+Sic1::SteamCallHandle SteamworksApi::FindLeaderboard(const std::string& name) {
+    auto lock = m_lock.Lock();
+    return Start<LeaderboardFindResult_t>(Sic1::SteamCallType::FindLeaderboard,
+        SteamUserStats()->FindLeaderboard(name.c_str()),
+        [](LeaderboardFindResult_t* steamResult, Sic1::SteamCallResult* result) -> void {
+            if (!steamResult->m_bLeaderboardFound) {
+                result->status = Sic1::SteamCallStatus::Failed;
+            }
+            else {
+                result->leaderboard = steamResult->m_hSteamLeaderboard;
+            }
+        });
+}
+
+Sic1::SteamCallHandle SteamworksApi::DownloadFriendLeaderboardEntries(Sic1::SteamLeaderboardHandle leaderboard) {
+    auto lock = m_lock.Lock();
+    return Start<LeaderboardScoresDownloaded_t>(Sic1::SteamCallType::DownloadFriendLeaderboardEntries,
+        SteamUserStats()->DownloadLeaderboardEntries(leaderboard, k_ELeaderboardDataRequestFriends, 0, 0),
+        [](LeaderboardScoresDownloaded_t* steamResult, Sic1::SteamCallResult* result) -> void {
+            auto stats = SteamUserStats();
+            auto friends = SteamFriends();
+            for (int i = 0; i < steamResult->m_cEntryCount; i++) {
+                LeaderboardEntry_t entry;
+                THROW_HR_IF(E_FAIL, !stats->GetDownloadedLeaderboardEntry(steamResult->m_hSteamLeaderboardEntries, i, &entry, nullptr, 0));
+                result->rows.push_back({ friends->GetFriendPersonaName(entry.m_steamIDUser), entry.m_nScore });
+            }
+        });
+}
+
+Sic1::SteamCallHandle SteamworksApi::UploadLeaderboardScore(Sic1::SteamLeaderboardHandle leaderboard, int score, const std::vector<int>& details) {
+    auto lock = m_lock.Lock();
+    return Start<LeaderboardScoreUploaded_t>(Sic1::SteamCallType::UploadLeaderboardScore,
+        SteamUserStats()->UploadLeaderboardScore(leaderboard, k_ELeaderboardUploadScoreMethodKeepBest, score, details.data(), static_cast<int>(details.size())),
+        [](LeaderboardScoreUploaded_t* steamResult, Sic1::SteamCallResult* result) -> void {
+            if (steamResult->m_bSuccess) {
+                result->scoreChanged = steamResult->m_bScoreChanged;
+            }
+            else {
+                result->status = Sic1::SteamCallStatus::Failed;
+            }
+        });
+}
+
+Sic1::SteamCallHandle SteamworksApi::StoreStats() {
+    auto lock = m_lock.Lock();
+    return StartCallback(Sic1::SteamCallType::StoreStats, SteamUserStats()->StoreStats());
+}
+
+Sic1::SteamCallHandle SteamworksApi::RequestCurrentStats() {
+    auto lock = m_lock.Lock();
+    return StartCallback(Sic1::SteamCallType::RequestCurrentStats, SteamUserStats()->RequestCurrentStats());
+}
+
+Sic1::SteamCallHandle SteamworksApi::StartCallback(Sic1::SteamCallType type, bool started) {
+    if (!started) {
+        return Sic1::steamCallHandleInvalid;
+    }
+
+    const Sic1::SteamCallHandle call = m_nextCallbackHandle++;
+    m_pendingCallbacks[type].push_back(call);
+    return call;
+}
+
+bool SteamworksApi::GetAchievement(const std::string& achievementId) {
+    auto userStats = SteamUserStats();
+    bool achieved = false;
+
+    THROW_HR_IF_NULL(E_UNEXPECTED, userStats);
+    THROW_HR_IF(E_FAIL, !userStats->GetAchievement(achievementId.c_str(), &achieved));
+
+    return achieved;
+}
+
+void SteamworksApi::SetAchievement(const std::string& achievementId) {
+    auto userStats = SteamUserStats();
+    THROW_HR_IF_NULL(E_UNEXPECTED, userStats);
+    THROW_HR_IF(E_FAIL, !userStats->SetAchievement(achievementId.c_str()));
+}
+
+void SteamworksApi::Complete(Sic1::SteamCallHandle call, const Sic1::SteamCallResult& result) {
+    auto lock = m_lock.Lock();
+    const auto pendingCall = m_pendingCalls.find(call);
+    if (pendingCall != m_pendingCalls.end()) {
+        m_finishedCalls.push_back(std::move(pendingCall->second));
+        m_pendingCalls.erase(pendingCall);
+    }
+
+    m_completedResults.emplace_back(call, result);
+}
+
+void SteamworksApi::CompleteCallback(Sic1::SteamCallType type, bool succeeded) {
+    auto lock = m_lock.Lock();
+    auto& calls = m_pendingCallbacks[type];
+    for (const auto call : calls) {
+        Sic1::SteamCallResult result = {};
+        result.type = type;
+        result.status = succeeded ? Sic1::SteamCallStatus::Succeeded : Sic1::SteamCallStatus::Failed;
+        m_completedResults.emplace_back(call, result);
+    }
+    calls.clear();
+}
+
+void SteamworksApi::OnUserStatsReceived(UserStatsReceived_t* data) {
+    if (data->m_nGameID == c_steamAppId) {
+        CompleteCallback(Sic1::SteamCallType::RequestCurrentStats, data->m_eResult == k_EResultOK);
+    }
+}
+
+void SteamworksApi::OnUserStatsStored(UserStatsStored_t* data) {
+    if (data->m_nGameID == c_steamAppId) {
+        CompleteCallback(Sic1::SteamCallType::StoreStats, data->m_eResult == k_EResultOK);
+    }
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <steam/steam_api.h>
+#include "steam/isteamuserstats.h"
+#include "utils.h"
+#include "../native/steamapi.h"
+
+// Sic1::SteamApi implemented with Steamworks: call results are tracked with one CCallResult per outstanding call (so
+// any number of calls can be outstanding), and StoreStats/RequestCurrentStats (which complete via callbacks instead of
+// call results) are given synthetic call handles
+class SteamworksApi : public Sic1::SteamApi {
+public:
+    SteamworksApi();
+
+    void SetResultHandler(ResultHandler handler) override;
+    void RunCallbacks() override;
+
+    Sic1::SteamCallHandle FindLeaderboard(const std::string& name) override;
+    Sic1::SteamCallHandle DownloadFriendLeaderboardEntries(Sic1::SteamLeaderboardHandle leaderboard) override;
+    Sic1::SteamCallHandle UploadLeaderboardScore(Sic1::SteamLeaderboardHandle leaderboard, int score, const std::vector<int>& details) override;
+    Sic1::SteamCallHandle StoreStats() override;
+    Sic1::SteamCallHandle RequestCurrentStats() override;
+
+    bool GetAchievement(const std::string& achievementId) override;
+    void SetAchievement(const std::string& achievementId) override;
+
+    STEAM_CALLBACK(SteamworksApi, OnUserStatsReceived, UserStatsReceived_t, m_callbackUserStatsReceived);
+    STEAM_CALLBACK(SteamworksApi, OnUserStatsStored, UserStatsStored_t, m_callbackUserStatsStored);
+
+private:
+    class PendingCall {
+    public:
+        virtual ~PendingCall() {}
+    };
+
+    // Receives a single call's result and translates it
+    template<typename TSteamResult>
+    class PendingCallResult : public PendingCall {
+    public:
+        PendingCallResult(SteamworksApi* parent, Sic1::SteamCallType type, std::function<void(TSteamResult*, Sic1::SteamCallResult*)> translateResult)
+            : m_parent(parent), m_type(type), m_translateResult(translateResult), m_call(k_uAPICallInvalid) {
+        }
+
+        void Set(SteamAPICall_t call) {
+            m_call = call;
+            m_callResult.Set(call, this, &PendingCallResult<TSteamResult>::OnCallback);
+        }
+
+    private:
+        void OnCallback(TSteamResult* steamResult, bool ioFailed) {
+            Sic1::SteamCallResult result = {};
+            result.type = m_type;
+            result.status = ioFailed ? Sic1::SteamCallStatus::IoFailed : Sic1::SteamCallStatus::Succeeded;
+            if (!ioFailed) {
+                try {
+                    m_translateResult(steamResult, &result);
+                }
+                catch (...) {
+                    result.status = Sic1::SteamCallStatus::Failed;
+                }
+            }
+
+            m_parent->Complete(m_call, result);
+        }
+
+        SteamworksApi* m_parent;
+        Sic1::SteamCallType m_type;
+        std::function<void(TSteamResult*, Sic1::SteamCallResult*)> m_translateResult;
+        SteamAPICall_t m_call;
+        CCallResult<PendingCallResult<TSteamResult>, TSteamResult> m_callResult;
+    };
+
+    template<typename TSteamResult>
+    Sic1::SteamCallHandle Start(Sic1::SteamCallType type, SteamAPICall_t call, std::function<void(TSteamResult*, Sic1::SteamCallResult*)> translateResult);
+
+    // Starts a call that completes via a callback (which completes all outstanding calls of that type)
+    Sic1::SteamCallHandle StartCallback(Sic1::SteamCallType type, bool started);
+
+    // Called (from within SteamAPI_RunCallbacks) when a call completes; results are delivered once it returns
+    void Complete(Sic1::SteamCallHandle call, const Sic1::SteamCallResult& result);
+    void CompleteCallback(Sic1::SteamCallType type, bool succeeded);
+
+    Sync::CriticalSection m_lock;
+    ResultHandler m_handler;
+    std::map<SteamAPICall_t, std::unique_ptr<PendingCall>> m_pendingCalls;
+
+    // Calls can't be destroyed from within their own callbacks, so they're destroyed after SteamAPI_RunCallbacks
+    std::vector<std::unique_ptr<PendingCall>> m_finishedCalls;
+    std::vector<std::pair<Sic1::SteamCallHandle, Sic1::SteamCallResult>> m_completedResults;
+
+    // Synthetic handles for StoreStats and RequestCurrentStats (with the top bit set, so they can't collide with
+    // SteamAPICall_t values)
+    Sic1::SteamCallHandle m_nextCallbackHandle;
+    std::map<Sic1::SteamCallType, std::vector<Sic1::SteamCallHandle>> m_pendingCallbacks;
+};
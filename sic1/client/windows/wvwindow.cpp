@@ -151,7 +151,7 @@ STDMETHODIMP WebViewWindow::ResolvePersistLocalStorage(VARIANT resolve, VARIANT
 					m_persistLocalStorage(data.get());
 				}
 			}
-		));
+		), Sic1::TaskPriority::Io);
 	}
 	return S_OK;
 }
@@ -166,7 +166,7 @@ STDMETHODIMP WebViewWindow::ResolvePersistPresentationSettings(VARIANT resolve,
 					m_persistPresentationSettings();
 				}
 			}
-		));
+		), Sic1::TaskPriority::Io);
 	}
 	return S_OK;
 }